@@ -40,6 +40,14 @@ extern "C"
 #define ASD_LOG_LEVEL_DEFAULT ASD_LOG_LEVEL_INFO
 #endif
 
+// Tokenized logging. The format strings of the ASD_LOG_x macros are placed in the
+// asd_log_fmt section, and the log lines only carry the offset of the format string
+// in the section and the varint encoded arguments. scripts/asd_log_decode.py rebuilds
+// the text on host from the section of the ELF.
+#ifndef ASD_LOG_TOKENIZED
+#define ASD_LOG_TOKENIZED 0
+#endif
+
 
 typedef enum {
     ASD_LOG_ID_DSP       = 1,
@@ -65,6 +73,7 @@ typedef enum {
 typedef enum {
     ASD_LOG_DATA_TYPE_LOG_TXT,
     ASD_LOG_DATA_TYPE_BIN,
+    ASD_LOG_DATA_TYPE_LOG_TOKEN,
     ASD_LOG_DATA_TYPE_NUM,
 } asd_log_data_type_t;
 
@@ -114,7 +123,7 @@ typedef struct asd_log_options {
     const char* tag;            ///< tag pointing to the tag name string.
     uint32_t pc;                ///< program pointer value of print line.
     uint32_t more_options;      ///< additional options of the log line.
-    const char* func_name;      ///< Function name. if NULL, no function name and line number;
+    const char* func_name;      ///< Function name. if NULL or empty, no function name and line number;
     int   line_no;              ///< line number;
 } asd_log_options_t;
 
@@ -166,6 +175,7 @@ typedef enum {
 typedef enum {
     LOG_DATA_TYPE_BIT_BIN   = 1,      ///< The log data type is binary data.
     LOG_DATA_TYPE_BIT_TXT   = 2,      ///< The log data type is text.
+    LOG_DATA_TYPE_BIT_TOKEN = 4,      ///< The log data type is raw log lines, tokenized lines are not decoded.
 } log_data_type_bit_t;
 
 /**
@@ -209,6 +219,9 @@ int32_t log_reader_get_remaining_log_length(asd_log_reader_t* reader);
  * @param[in/out] buf: data buffer pointer for output.
  * @param[in] size: buffer size. Read max size. A line is up to 256 bytes, including header. So buffer size should be no less than 256.
  *
+ *        With LOG_DATA_TYPE_BIT_TOKEN, the output is the raw log lines instead, each one as a 16-bit little endian
+ *        length followed by the binary line header and the line body. Decode it with scripts/asd_log_decode.py.
+ *
  * @return  >= 0 for actual read size, or negative for error. If return 0, read position reaches end of the log.
 */
 int32_t log_reader_read(asd_log_reader_t* reader, void* buf, uint32_t size);
@@ -248,4 +248,142 @@ int32_t afw_cir_buf_get_data_size(afw_cir_buf_t* cir_buf);
 */
 int32_t afw_cir_buf_deinit(afw_cir_buf_t** cir_buf);
 
+/*******************************************************************************
+ * AFW multi-producer single-consumer ring
+ *******************************************************************************
+ */
+
+/**
+* Lock-free ring of records for many producers (tasks or ISRs) and one consumer.
+*
+* A producer reserves the space of its record by advancing reserve_idx with a
+* compare and swap, copies its data in, then commits the record by writing its
+* header word. The consumer only returns committed records, in reservation order,
+* and zeroes the space it frees so that a stale header is never seen as committed.
+* Records are 4-byte aligned, headers never wrap.
+*/
+
+// Set in the record header once the data is in place.
+#define AFW_MPSC_RING_COMMITTED     (0x80000000U)
+// Space used by a record of data_len bytes, header included.
+#define AFW_MPSC_RING_RECORD_SIZE(data_len) (((data_len) + sizeof(uint32_t) + 3U) & ~3U)
+// Ring sizes the indexes can be masked with, and that keep the 4-byte records from wrapping a header.
+#define AFW_MPSC_RING_SIZE_VALID(size) \
+    (((size) >= sizeof(uint32_t)) && (((size) & ((size) - 1U)) == 0U) && (((size) % sizeof(uint32_t)) == 0U))
+
+typedef struct {
+    uint8_t * buf_ptr;
+    uint32_t size;                          ///< power of two
+    uint32_t reserve_idx;                   ///< free running, moved by the producers
+    uint32_t read_idx;                      ///< free running, moved by the consumer
+    SemaphoreHandle_t wr_space_avail_sema;
+} afw_mpsc_ring_t;
+
+typedef struct {
+    uint32_t idx;                           ///< ring index of the record header
+    uint32_t len;                           ///< data length
+} afw_mpsc_ring_slot_t;
+
+/**
+* @brief Used to initialize a multi-producer ring
+*
+* @param[in] size size of the ring, must be a power of two and a multiple of 4,
+*                 see AFW_MPSC_RING_SIZE_VALID
+*
+* @return pointer to the newly created ring, NULL on failure
+*/
+afw_mpsc_ring_t* afw_mpsc_ring_init(uint32_t size);
+
+/**
+* @brief Reserve the space of one record. Lock-free, can be called from ISR.
+*        Every successful reserve must be followed by a commit, the consumer
+*        waits on the record until then.
+*
+* @param[in]  ring pointer to the ring
+* @param[in]  data_len length of the record data
+* @param[out] slot reserved record
+*
+* @return 0 on success, -AFW_EIO when the ring is full
+*/
+int32_t afw_mpsc_ring_reserve(afw_mpsc_ring_t* ring, uint32_t data_len, afw_mpsc_ring_slot_t* slot);
+
+/**
+* @brief Copy data into a reserved record, handling the wrap of the ring.
+*
+* @param[in] ring pointer to the ring
+* @param[in] slot reserved record
+* @param[in] offset offset in the record data
+* @param[in] data pointer to the source data
+* @param[in] data_len length of data, offset + data_len must fit in the record
+*/
+void afw_mpsc_ring_slot_copy(afw_mpsc_ring_t* ring, const afw_mpsc_ring_slot_t* slot, uint32_t offset,
+                             const uint8_t* data, uint32_t data_len);
+
+/**
+* @brief Make a reserved record visible to the consumer.
+*
+* @param[in] ring pointer to the ring
+* @param[in] slot reserved record
+*/
+void afw_mpsc_ring_commit(afw_mpsc_ring_t* ring, const afw_mpsc_ring_slot_t* slot);
+
+/**
+* @brief Write one record: reserve, copy and commit. Lock-free, can be called from ISR.
+*
+* @param[in] ring pointer to the ring
+* @param[in] data pointer to the source data
+* @param[in] data_len length of data
+*
+* @return 0 on success, -AFW_EIO when the ring is full
+*
+* Example Usage:
+* @code
+*  int32_t err = afw_mpsc_ring_write(ring, data, 32);
+* @endcode
+*/
+int32_t afw_mpsc_ring_write(afw_mpsc_ring_t* ring, const uint8_t* data, uint32_t data_len);
+
+/**
+* @brief Write one record, waiting for the consumer to free space when the ring is full.
+*        Does not wait when called from ISR.
+*
+* @param[in] ring pointer to the ring
+* @param[in] data pointer to the source data
+* @param[in] data_len length of data
+* @param[in] xTicksToWait ticks to timeout each wait for space.
+*
+* @return 0 on success, negative number on failure
+*/
+int32_t afw_mpsc_ring_write_block(afw_mpsc_ring_t* ring, const uint8_t* data, uint32_t data_len, TickType_t xTicksToWait);
+
+/**
+* @brief Read the oldest committed record. Only be called by the single consumer.
+*
+* @param[in]  ring pointer to the ring
+* @param[out] data pointer to the destination buffer
+* @param[in]  data_len size of the destination buffer
+*
+* @return record length on success, -AFW_EIO when no committed record,
+*         -AFW_ENOMEM when the record was larger than the buffer (the record is dropped)
+*/
+int32_t afw_mpsc_ring_read(afw_mpsc_ring_t* ring, uint8_t* data, uint32_t data_len);
+
+/**
+* @brief Used to get the space held by reserved and committed records.
+*
+* @param[in] ring pointer to the ring
+*
+* @return used space in bytes on success, negative number on failure
+*/
+int32_t afw_mpsc_ring_get_data_size(afw_mpsc_ring_t* ring);
+
+/**
+* @brief Used to deinit a existing ring
+*
+* @param[in] ring reference to the ring pointer
+*
+* @return 0 on success, negative number on failure
+*/
+int32_t afw_mpsc_ring_deinit(afw_mpsc_ring_t** ring);
+
 #endif /* AFW_UTILS_H_ */
@@ -23,6 +23,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <errno.h>
 #include "FreeRTOS.h"
 #include "semphr.h"
@@ -38,13 +39,35 @@
 
 #define DBG_NAME_LEN    16
 
+/* Item stored in the event queues */
+typedef struct {
+    int id;
+    void *pdata;
+    TickType_t tick;    /* post time, for the latency counters */
+    bool ref;           /* pdata is held in an event envelope */
+} afw_event_item_t;
+
+/* Reference counted event envelope, pdata points to data */
+typedef struct {
+    uint32_t refcnt;
+    uint32_t size;
+    uint8_t data[] __attribute__((aligned(8)));
+} afw_event_envelope_t;
+
+#define ENVELOPE_FROM_PDATA(pdata) \
+    ((afw_event_envelope_t *)((uint8_t *)(pdata) - offsetof(afw_event_envelope_t, data)))
+
 /* Array of event queues in the system. The number of event queues is defined
  * by the application. */
 static struct afw_event_queue_t {
     QueueHandle_t q;
     char dbgname[DBG_NAME_LEN];
+    afw_event_queue_stats_t stats;
 } event_queue_list[AFW_NUM_EVENT_QUEUES] = {{0}};
 
+/* Number of event envelopes not released yet */
+static volatile uint32_t envelopes_in_use = 0;
+
 /* Each event has an associated bitmask indicating the event queues that have
  * subscribed to that event. The number of events is defined by the
  * application. */
@@ -54,10 +77,14 @@ static volatile struct afw_event_info_t {
 
 /* Semaphore for controlling modifications to event_queue_list */
 static volatile SemaphoreHandle_t event_queues_mutex = 0;
+/* Serializes the publishing tasks, they post to the subscribers one at a time */
 static volatile SemaphoreHandle_t publish_mutex = 0;
 
 static inline int8_t get_next_idx_clear(uint32_t *word);
 static int init_publish_mutex(void);
+static int publish_event(int event_id, void *pdata, bool ref, portBASE_TYPE *pxHigherPriorityTaskWoken);
+static bool receive_event(int8_t queue_id, afw_event_item_t *item, TickType_t timeout_ticks);
+static void hand_over_event(const afw_event_item_t *item, afw_event_t *event);
 
 
 int8_t afw_event_queue_init(int8_t queue_id, const char *dbgname)
@@ -94,7 +121,8 @@ int8_t afw_event_queue_init(int8_t queue_id, const char *dbgname)
         }
     }
 
-    event_queue_list[queue_id].q = xQueueCreate(AFW_EVENT_QUEUE_LENGTH, sizeof(afw_event_t));
+    event_queue_list[queue_id].q = xQueueCreate(AFW_EVENT_QUEUE_LENGTH, sizeof(afw_event_item_t));
+    memset(&event_queue_list[queue_id].stats, 0, sizeof(afw_event_queue_stats_t));
 
     if (!event_queue_list[queue_id].q) {
         ASD_LOG_E(afw, "ERROR: failed to init event queue\n");
@@ -115,9 +143,10 @@ int afw_post_event(int8_t queue_id, int event_id, void *pdata,
 {
     int status = 0;
 
-    afw_event_t event = {
+    afw_event_item_t event = {
         .id    = event_id,
         .pdata = pdata,
+        .ref   = false,
     };
 
     if (queue_id < 0 || queue_id >= AFW_NUM_EVENT_QUEUES)
@@ -128,10 +157,18 @@ int afw_post_event(int8_t queue_id, int event_id, void *pdata,
         return -1;
     }
 
-    if (pxHigherPriorityTaskWoken)
+    if (pxHigherPriorityTaskWoken) {
+        event.tick = xTaskGetTickCountFromISR();
         status = xQueueSendFromISR(event_queue_list[queue_id].q, &event, pxHigherPriorityTaskWoken);
-    else
+    } else {
+        event.tick = xTaskGetTickCount();
         status = xQueueSend(event_queue_list[queue_id].q, &event, 1);
+    }
+
+    if (status == pdTRUE)
+        __atomic_add_fetch(&event_queue_list[queue_id].stats.posted, 1, __ATOMIC_RELAXED);
+    else
+        __atomic_add_fetch(&event_queue_list[queue_id].stats.dropped, 1, __ATOMIC_RELAXED);
 
     if (status != pdTRUE) {
         ASD_LOG_E(afw, "ERROR: could not post event %d to queue %d [%s]\n", event_id,
@@ -145,55 +182,72 @@ int afw_post_event(int8_t queue_id, int event_id, void *pdata,
 
 int afw_publish_event(int event_id, void *pdata, portBASE_TYPE *pxHigherPriorityTaskWoken)
 {
-    int status = 0;
-
-    if (event_id < 0 || event_id >= AFW_NUM_EVENTS)
-        return -1;
+    return publish_event(event_id, pdata, false, pxHigherPriorityTaskWoken);
+}
 
-    uint32_t subscribers = event_list[event_id].subscribers;
 
-    if (!pxHigherPriorityTaskWoken) {
-        if (!publish_mutex) {
-            if (init_publish_mutex() != 0) {
-                ASD_LOG_E(afw, "ERROR: could not create event publish mutex\n");
-                return -1;
-            }
-        }
+void *afw_event_alloc(size_t size)
+{
+    afw_event_envelope_t *envelope = malloc(sizeof(afw_event_envelope_t) + size);
 
-        xSemaphoreTake(publish_mutex, portMAX_DELAY);
+    if (!envelope) {
+        ASD_LOG_E(afw, "ERROR: could not allocate event of %u bytes\n", (unsigned int)size);
+        return NULL;
     }
 
-    while (subscribers) {
-        int8_t queue_id = get_next_idx_clear(&subscribers);
-        if (afw_post_event(queue_id, event_id, pdata, pxHigherPriorityTaskWoken) != 0)
-            status = -1;
-    }
+    envelope->refcnt = 1;
+    envelope->size   = size;
+    __atomic_add_fetch(&envelopes_in_use, 1, __ATOMIC_RELAXED);
+
+    return envelope->data;
+}
+
 
-    if (!pxHigherPriorityTaskWoken)
-        xSemaphoreGive(publish_mutex);
+int afw_publish_event_ref(int event_id, void *pdata)
+{
+    if (!pdata)
+        return -1;
+
+    int status = publish_event(event_id, pdata, true, NULL);
+
+    // drop the reference of the publisher, the subscribers hold theirs.
+    afw_event_release(pdata);
 
     return status;
 }
 
 
-int afw_get_event(int8_t queue_id, void **pdata, TickType_t timeout_ticks)
+void afw_event_release(void *pdata)
+{
+    if (!pdata)
+        return;
+
+    afw_event_envelope_t *envelope = ENVELOPE_FROM_PDATA(pdata);
+
+    if (__atomic_sub_fetch(&envelope->refcnt, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(envelope);
+        __atomic_sub_fetch(&envelopes_in_use, 1, __ATOMIC_RELAXED);
+    }
+}
+
+
+int afw_get_event(int8_t queue_id, afw_event_t *event, TickType_t timeout_ticks)
 {
     int event_id = AFW_NO_EVENT;
-    afw_event_t event;
+    afw_event_item_t item;
 
     if (queue_id >= AFW_NUM_EVENT_QUEUES || !event_queue_list[queue_id].q)
         return -1;
 
-    if (xQueueReceive(event_queue_list[queue_id].q, (void *)&event, timeout_ticks)) {
-            event_id = event.id;
-            if (pdata)
-                *pdata = event.pdata;
+    if (receive_event(queue_id, &item, timeout_ticks)) {
+        event_id = item.id;
+        hand_over_event(&item, event);
     }
 
     return event_id;
 }
 
-int afw_wait_for_event(int8_t queue_id, int event_id, void **pdata, TickType_t timeout_ticks)
+int afw_wait_for_event(int8_t queue_id, int event_id, afw_event_t *event, TickType_t timeout_ticks)
 {
     if (queue_id >= AFW_NUM_EVENT_QUEUES || !event_queue_list[queue_id].q)
         return -AFW_EINVAL;
@@ -209,8 +263,16 @@ int afw_wait_for_event(int8_t queue_id, int event_id, void **pdata, TickType_t t
     }
 
     while (curr_tick < last_tick) {
-        if (afw_get_event(queue_id, pdata, last_tick - curr_tick) == event_id)
-            return ACE_STATUS_OK;
+        afw_event_item_t item;
+
+        if (receive_event(queue_id, &item, last_tick - curr_tick)) {
+            if (item.id == event_id) {
+                hand_over_event(&item, event);
+                return ACE_STATUS_OK;
+            }
+            // other events are discarded, drop their reference.
+            hand_over_event(&item, NULL);
+        }
 
         if (timeout_ticks == portMAX_DELAY)
             continue;
@@ -277,8 +339,16 @@ bool afw_event_is_subscribed(int8_t queue_id, int event_id)
 
 void afw_flush_event_queue(int8_t queue_id)
 {
-    if (queue_id >= 0 && queue_id < AFW_NUM_EVENT_QUEUES && event_queue_list[queue_id].q)
-        xQueueReset(event_queue_list[queue_id].q);
+    afw_event_item_t event;
+
+    if (queue_id < 0 || queue_id >= AFW_NUM_EVENT_QUEUES || !event_queue_list[queue_id].q)
+        return;
+
+    // release the pending envelopes, no xQueueReset.
+    while (xQueueReceive(event_queue_list[queue_id].q, (void *)&event, 0)) {
+        if (event.ref)
+            afw_event_release(event.pdata);
+    }
 }
 
 
@@ -290,6 +360,7 @@ int afw_event_queue_deinit(int8_t queue_id)
         return -1;
 
     afw_unsubscribe_all_events(queue_id, false);
+    afw_flush_event_queue(queue_id);
     vQueueDelete(event_queue_list[queue_id].q);
     event_queue_list[queue_id].q = 0;
     event_queue_list[queue_id].dbgname[0] = '\0';
@@ -299,6 +370,21 @@ int afw_event_queue_deinit(int8_t queue_id)
     return ACE_STATUS_OK;
 }
 
+
+int afw_event_queue_get_stats(int8_t queue_id, afw_event_queue_stats_t *stats, bool reset)
+{
+    if (queue_id < 0 || queue_id >= AFW_NUM_EVENT_QUEUES || !event_queue_list[queue_id].q || !stats)
+        return -1;
+
+    taskENTER_CRITICAL();
+    *stats = event_queue_list[queue_id].stats;
+    if (reset)
+        memset(&event_queue_list[queue_id].stats, 0, sizeof(afw_event_queue_stats_t));
+    taskEXIT_CRITICAL();
+
+    return ACE_STATUS_OK;
+}
+
 /*******************************************************************************
  * get_next_idx_clear
  *
@@ -315,6 +401,97 @@ static inline int8_t get_next_idx_clear(uint32_t *word)
     return leading_set_bit;
 }
 
+/*******************************************************************************
+ * publish_event
+ *
+ * Post the event to every subscribed queue. Tasks publish under the publish
+ * mutex, so their events are seen in the same order by all subscribers, and
+ * wait up to AFW_EVENT_PUBLISH_TIMEOUT_TICKS for room in each full queue. ISRs
+ * post without waiting inside a critical section. A post that fails is counted
+ * as a drop, logged and fails the publish.
+ *******************************************************************************
+ */
+static int publish_event(int event_id, void *pdata, bool ref, portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+    portBASE_TYPE woken = pdFALSE;
+    UBaseType_t saved_mask = 0;
+    uint32_t dropped = 0;
+
+    if (event_id < 0 || event_id >= AFW_NUM_EVENTS)
+        return -1;
+
+    afw_event_item_t event = {
+        .id    = event_id,
+        .pdata = pdata,
+        .ref   = ref,
+    };
+    afw_event_envelope_t *envelope = ref ? ENVELOPE_FROM_PDATA(pdata) : NULL;
+
+    if (pxHigherPriorityTaskWoken) {
+        saved_mask = taskENTER_CRITICAL_FROM_ISR();
+        event.tick = xTaskGetTickCountFromISR();
+    } else {
+        if (!publish_mutex) {
+            if (init_publish_mutex() != 0) {
+                ASD_LOG_E(afw, "ERROR: could not create event publish mutex\n");
+                return -1;
+            }
+        }
+
+        xSemaphoreTake(publish_mutex, portMAX_DELAY);
+        event.tick = xTaskGetTickCount();
+    }
+
+    uint32_t subscribers = event_list[event_id].subscribers;
+
+    while (subscribers) {
+        int8_t queue_id = get_next_idx_clear(&subscribers);
+        struct afw_event_queue_t *queue = &event_queue_list[queue_id];
+        BaseType_t status;
+
+        if (!queue->q) {
+            dropped |= (1U << queue_id);
+            continue;
+        }
+        // the reference must be taken before the subscriber can see the event.
+        if (envelope)
+            __atomic_add_fetch(&envelope->refcnt, 1, __ATOMIC_RELAXED);
+
+        if (pxHigherPriorityTaskWoken)
+            status = xQueueSendFromISR(queue->q, &event, &woken);
+        else
+            status = xQueueSend(queue->q, &event, AFW_EVENT_PUBLISH_TIMEOUT_TICKS);
+
+        if (status == pdTRUE) {
+            __atomic_add_fetch(&queue->stats.posted, 1, __ATOMIC_RELAXED);
+        } else {
+            if (envelope)
+                __atomic_sub_fetch(&envelope->refcnt, 1, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&queue->stats.dropped, 1, __ATOMIC_RELAXED);
+            dropped |= (1U << queue_id);
+        }
+    }
+
+    if (pxHigherPriorityTaskWoken) {
+        taskEXIT_CRITICAL_FROM_ISR(saved_mask);
+        *pxHigherPriorityTaskWoken |= woken;
+        return dropped ? -1 : 0;
+    }
+
+    xSemaphoreGive(publish_mutex);
+
+    int status = dropped ? -1 : 0;
+
+    // log once the other publishers can go on.
+    while (dropped) {
+        int8_t queue_id = get_next_idx_clear(&dropped);
+        ASD_LOG_E(afw, "ERROR: could not post event %d to queue %d [%s]\n", event_id,
+                queue_id, event_queue_list[queue_id].dbgname);
+    }
+
+    return status;
+}
+
 /*******************************************************************************
  * init_publish_mutex
  *******************************************************************************
@@ -332,6 +509,51 @@ static int init_publish_mutex(void)
     return ACE_STATUS_OK;
 }
 
+/*******************************************************************************
+ * receive_event
+ *
+ * Take the next event out of a queue and update its latency counters.
+ *******************************************************************************
+ */
+static bool receive_event(int8_t queue_id, afw_event_item_t *item, TickType_t timeout_ticks)
+{
+    afw_event_queue_stats_t *stats = &event_queue_list[queue_id].stats;
+
+    if (!xQueueReceive(event_queue_list[queue_id].q, (void *)item, timeout_ticks))
+        return false;
+
+    TickType_t latency = xTaskGetTickCount() - item->tick;
+
+    taskENTER_CRITICAL();
+    stats->received++;
+    stats->total_latency += latency;
+    if (latency > stats->max_latency)
+        stats->max_latency = latency;
+    taskEXIT_CRITICAL();
+
+    return true;
+}
+
+/*******************************************************************************
+ * hand_over_event
+ *
+ * Pass a received event on to the caller, or drop its data if there is nowhere
+ * to pass it to.
+ *******************************************************************************
+ */
+static void hand_over_event(const afw_event_item_t *item, afw_event_t *event)
+{
+    if (!event) {
+        if (item->ref)
+            afw_event_release(item->pdata);
+        return;
+    }
+
+    event->id    = item->id;
+    event->pdata = item->pdata;
+    event->ref   = item->ref;
+}
+
 /*******************************************************************************
  * afw_eventmgr_post_cli
  *
@@ -373,10 +595,11 @@ static ace_status_t afw_eventmgr_post_cli(int32_t len, const char *param[])
  */
 static ace_status_t afw_eventmgr_publish_cli(int32_t len, const char *param[])
 {
-    if (len != 1 || (len == 1 && param[0][0] == '?')) {
-        printf("Usage: eventmgr publish EVENT_ID\n\n");
+    if (len < 1 || len > 2 || param[0][0] == '?') {
+        printf("Usage: eventmgr publish EVENT_ID [DATA]\n\n");
         printf("Arguments:\n");
         printf("\tEVENT_ID\tevent to publish (0 to %d)\n", AFW_NUM_EVENTS - 1);
+        printf("\tDATA\t\tstring attached to the event\n");
         return ACE_STATUS_OK;
     }
 
@@ -388,7 +611,17 @@ static ace_status_t afw_eventmgr_publish_cli(int32_t len, const char *param[])
         return ACE_STATUS_OK;
     }
 
-    int status = afw_publish_event(event_id, NULL, NULL);
+    // the data lives in an envelope, the subscribers release it when done.
+    const char *text = (len == 2) ? param[1] : "";
+    char *pdata = afw_event_alloc(strlen(text) + 1);
+
+    if (!pdata) {
+        printf("Error allocating event %d\n", event_id);
+        return ACE_STATUS_OK;
+    }
+    strcpy(pdata, text);
+
+    int status = afw_publish_event_ref(event_id, pdata);
 
     if (status != 0)
         printf("Error publishing event %d\n", event_id);
@@ -396,6 +629,50 @@ static ace_status_t afw_eventmgr_publish_cli(int32_t len, const char *param[])
     return ACE_STATUS_OK;
 }
 
+/*******************************************************************************
+ * afw_eventmgr_get_cli
+ *
+ * CLI command for taking the next event out of a specific event queue
+ *******************************************************************************
+ */
+static ace_status_t afw_eventmgr_get_cli(int32_t len, const char *param[])
+{
+    if (len < 1 || len > 2 || param[0][0] == '?') {
+        printf("Usage: eventmgr get QUEUE_ID [TIMEOUT_MS]\n\n");
+        printf("Arguments:\n");
+        printf("\tQUEUE_ID\tqueue to read (0 to %d)\n", AFW_NUM_EVENT_QUEUES - 1);
+        printf("\tTIMEOUT_MS\ttime to wait for an event, 0 by default\n");
+        return ACE_STATUS_OK;
+    }
+
+    errno = 0;
+    int8_t queue_id = strtol(param[0], NULL, 0);
+    uint32_t timeout_ms = (len == 2) ? strtoul(param[1], NULL, 0) : 0;
+
+    if (errno) {
+        printf("Error parsing parameters\n");
+        return ACE_STATUS_OK;
+    }
+
+    afw_event_t event;
+    int event_id = afw_get_event(queue_id, &event, pdMS_TO_TICKS(timeout_ms));
+
+    if (event_id < 0) {
+        printf("No event on queue %d\n", queue_id);
+        return ACE_STATUS_OK;
+    }
+
+    if (event.ref)
+        printf("event_id %d, %u bytes of data\n", event_id,
+               (unsigned int)ENVELOPE_FROM_PDATA(event.pdata)->size);
+    else
+        printf("event_id %d, data %p\n", event_id, event.pdata);
+
+    afw_event_done(&event);
+
+    return ACE_STATUS_OK;
+}
+
 /*******************************************************************************
  * afw_eventmgr_show_sub_cli
  *
@@ -460,15 +737,60 @@ static ace_status_t afw_eventmgr_show_queues_cli(int32_t len, const char *param[
     return ACE_STATUS_OK;
 }
 
+/*******************************************************************************
+ * afw_eventmgr_show_stats_cli
+ *
+ * CLI command for showing the counters of all registered event queues
+ *******************************************************************************
+ */
+static ace_status_t afw_eventmgr_show_stats_cli(int32_t len, const char *param[])
+{
+    bool reset = false;
+
+    if (len == 1 && !strcmp(param[0], "reset")) {
+        reset = true;
+    } else if (len != 0) {
+        printf("Usage: eventmgr show stats [reset]\n");
+        return ACE_STATUS_OK;
+    }
+
+    printf("%8s\t%16s\t%8s\t%8s\t%8s\t%8s\t%8s\n", "queue_id", "dbgname", "posted", "dropped",
+           "received", "avg_lat", "max_lat");
+    printf("------------------------------------------------------------------------------------------\n");
+
+    xSemaphoreTake(event_queues_mutex, portMAX_DELAY);
+
+    for (int i = 0; i < AFW_NUM_EVENT_QUEUES; i++) {
+        afw_event_queue_stats_t stats;
+
+        if (afw_event_queue_get_stats(i, &stats, reset) != 0)
+            continue;
+
+        uint32_t avg_latency = stats.received ? (uint32_t)(stats.total_latency / stats.received) : 0;
+
+        printf("%8d\t%16s\t%8u\t%8u\t%8u\t%8u\t%8u\n", i, event_queue_list[i].dbgname,
+               (unsigned int)stats.posted, (unsigned int)stats.dropped, (unsigned int)stats.received,
+               (unsigned int)avg_latency, (unsigned int)stats.max_latency);
+    }
+
+    xSemaphoreGive(event_queues_mutex);
+
+    printf("latency in ticks, %u event envelopes in use\n", (unsigned int)envelopes_in_use);
+
+    return ACE_STATUS_OK;
+}
+
 static const aceCli_moduleCmd_t eventmgr_show_cli[] = {
      { "subscribers",   "show event subscribers",   ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_show_sub_cli                     },
      { "queues",        "show all event queues",    ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_show_queues_cli                  },
+     { "stats",         "show event queue counters",ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_show_stats_cli                   },
      ACE_CLI_NULL_MODULE
 };
 
 const aceCli_moduleCmd_t eventmgr_cli[] = {
      { "post",          "post event to queue",      ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_post_cli},
      { "publish",       "publish event",            ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_publish_cli},
+     { "get",           "get event from queue",     ACE_CLI_SET_LEAF, .command.func=&afw_eventmgr_get_cli},
      { "show",          "show",                     ACE_CLI_SET_FUNC, .command.subCommands=eventmgr_show_cli  },
      ACE_CLI_NULL_MODULE,
 };
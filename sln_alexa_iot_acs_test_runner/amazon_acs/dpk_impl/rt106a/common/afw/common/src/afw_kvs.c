@@ -128,6 +128,18 @@ Value Blob
 #define MAX_VALUE_LEN (AFW_KVS_MAX_VALUE_LEN)
 #define AES_CTR_BUF_SIZE (256)
 
+// Entry index sizing (slot counts must be powers of two)
+#ifndef AFW_KVS_INDEX_MIN_SLOTS
+#define AFW_KVS_INDEX_MIN_SLOTS (16)
+#endif
+#ifndef AFW_KVS_INDEX_MAX_SLOTS
+#define AFW_KVS_INDEX_MAX_SLOTS (1024)
+#endif
+#define KVS_INDEX_EMPTY (0x00000000)
+#define KVS_INDEX_TOMBSTONE (0xFFFFFFFF)
+#define FNV1A_OFFSET_BASIS (2166136261u)
+#define FNV1A_PRIME (16777619u)
+
 // Structs
 typedef union afw_kvs_nonce_counter_u {
     struct {
@@ -138,10 +150,32 @@ typedef union afw_kvs_nonce_counter_u {
     unsigned char nc_buf[16];
 } afw_kvs_nonce_counter_t;
 
+/*
+ * RAM index of the valid entries in a partition. Each slot maps the hash of
+ * the packed namespace/key header to the flash offset of the entry meta, so
+ * lookups touch a single entry instead of walking the whole partition.
+ * Slots are open-addressed with linear probing.
+ */
+typedef struct afw_kvs_index_slot_s {
+    uint32_t hash;
+    uint32_t entry;     // Flash offset of entry meta, or KVS_INDEX_EMPTY/TOMBSTONE
+} afw_kvs_index_slot_t;
+
+typedef enum afw_kvs_index_state_e {
+    KVS_INDEX_STALE = 0,    // Must be rebuilt from flash before use
+    KVS_INDEX_VALID,
+    KVS_INDEX_UNAVAILABLE,  // Out of memory/slots, fall back to scanning flash
+} afw_kvs_index_state_t;
+
 typedef struct afw_kvs_partition_info_s {
     fm_flash_partition_t *partition;
     unsigned long offset;
     SemaphoreHandle_t write_lock;
+
+    afw_kvs_index_slot_t *index;
+    uint32_t index_slots;
+    uint32_t index_used;    // Live entries plus tombstones
+    afw_kvs_index_state_t index_state;
 } afw_kvs_partition_info_t;
 
 
@@ -187,8 +221,20 @@ static int32_t find_write_address(fm_flash_partition_t *part, unsigned long *wri
 static void update_write_address(fm_flash_partition_t *part, unsigned long new_addr);
 static void reset_write_address(fm_flash_partition_t *part);
 static uint8_t* find_entry(const char * namespace, const char* key);
+static uint8_t* scan_for_entry(fm_flash_partition_t *part, const char *header, uint8_t header_len);
 static bool crc_comp_check(uint16_t comp, void *ptr, uint32_t len);
-static int32_t delete_entry(const uint8_t *pos);
+static int32_t delete_entry(fm_flash_partition_t *part, const uint8_t *pos);
+static afw_kvs_partition_info_t* get_partition_info(fm_flash_partition_t *part);
+static uint32_t index_hash(const void *header, uint8_t header_len);
+static afw_kvs_index_slot_t* index_lookup(afw_kvs_partition_info_t *info,
+                                          const char *header,
+                                          uint8_t header_len);
+static bool index_insert(afw_kvs_partition_info_t *info, uint32_t hash, uint32_t entry);
+static void index_add(fm_flash_partition_t *part, const char *header, uint8_t header_len, uint32_t entry);
+static void index_remove(fm_flash_partition_t *part, const uint8_t *pos);
+static void index_reset(fm_flash_partition_t *part);
+static void index_invalidate(fm_flash_partition_t *part);
+static bool index_rebuild(fm_flash_partition_t *part);
 static bool aes_ctr_in_place(void *data,
                              uint16_t len,
                              fm_flash_partition_t *part,
@@ -276,6 +322,18 @@ int32_t afw_kvs_init(unsigned char *mbedtls_aes_key) {
         find_write_address(kvs_mgr.partition_info[i].partition, &kvs_mgr.partition_info[i].offset);
     }
 
+    // Build entry indexes now so the first get/set does not pay for the scan
+    for (int i = 0; i < kvs_mgr.partition_count; i++) {
+        fm_flash_partition_t *part = kvs_mgr.partition_info[i].partition;
+        if (part == backup_part || afw_kvs_lock(part)) {
+            continue;
+        }
+        if (is_partition_initialized(part) && !index_rebuild(part)) {
+            ASD_LOG_W(afw, "Index unavailable for %s, using flash scan", part->name);
+        }
+        afw_kvs_unlock(part);
+    }
+
     return AFW_OK;
 }
 
@@ -292,6 +350,11 @@ int32_t afw_kvs_deinit(void)
         if (kvs_mgr.partition_info[i].write_lock) {
             vSemaphoreDelete(kvs_mgr.partition_info[i].write_lock);
         }
+        free(kvs_mgr.partition_info[i].index);
+        kvs_mgr.partition_info[i].index = NULL;
+        kvs_mgr.partition_info[i].index_slots = 0;
+        kvs_mgr.partition_info[i].index_used = 0;
+        kvs_mgr.partition_info[i].index_state = KVS_INDEX_STALE;
     }
 
     mbedtls_ctr_drbg_free(&kvs_mgr.kvs_ctr_drbg);
@@ -495,10 +558,11 @@ int32_t afw_kvs_set(const char * namespace,
     uint8_t *old_entry = find_entry(namespace, key);
     while (old_entry &&
            old_entry < (uint8_t *)target->offset + write_offset) {
-        ret = delete_entry(old_entry);
+        ret = delete_entry(target, old_entry);
         if (ret) {UNLOCK_AND_RETURN(target, ret);}
         old_entry = find_entry(namespace, key);
     }
+    index_add(target, header, header_len, target->offset + write_offset);
 
 #ifdef AMAZON_TESTS_ENABLE
     testReboot();
@@ -700,7 +764,7 @@ int32_t afw_kvs_delete(const char * namespace,
         UNLOCK_AND_RETURN(target, -AFW_ENOENT);
     }
 
-    int32_t ret = delete_entry(scan);
+    int32_t ret = delete_entry(target, scan);
 
     UNLOCK_AND_RETURN(target, ret);
 }
@@ -713,6 +777,7 @@ int32_t afw_kvs_delete_namespace(const char *namespace)
     if (!shared) {
         KVS_FLASH_ERASE(target);
         reset_write_address(target);
+        index_reset(target);
         UNLOCK_AND_RETURN(target, AFW_OK);
     }
 
@@ -746,7 +811,7 @@ int32_t afw_kvs_delete_namespace(const char *namespace)
         }
 
         // We have a match!
-        delete_entry(scan);
+        delete_entry(target, scan);
         if (!find_next_entry(&scan, target->offset + target->size)) {
             UNLOCK_AND_RETURN(target, -AFW_EUFAIL);
         }
@@ -783,6 +848,8 @@ static int32_t cleanup_impl(const char * namespace,
     // Macro won't work for this case
     if (afw_kvs_lock(target)) {UNLOCK_AND_RETURN(backup_part, -AFW_EBUSY);}
     reset_write_address(target);
+    // Entries move during compaction; rebuilt on next lookup
+    index_invalidate(target);
 
     if (!is_partition_initialized(target)) {
         ASD_LOG_I(afw, "Nothing to cleanup", target->name);
@@ -1191,6 +1258,7 @@ static int32_t find_write_address(fm_flash_partition_t *part, unsigned long *wri
 {
     if (!is_partition_initialized(part)) {
         KVS_FLASH_ERASE(part);
+        index_reset(part);
         if (!initialize_partition(part)) {
             return -AFW_EUFAIL;
         }
@@ -1250,6 +1318,34 @@ static uint8_t* find_entry(const char * namespace, const char* key)
     char header[header_len];
     populate_entry_header(namespace, key, header, shared);
 
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (info && info->index_state == KVS_INDEX_STALE) {
+        index_rebuild(part);
+    }
+    if (!info || info->index_state != KVS_INDEX_VALID) {
+        return scan_for_entry(part, header, header_len);
+    }
+
+    afw_kvs_index_slot_t *slot = index_lookup(info, header, header_len);
+    if (!slot) {
+        return NULL;
+    }
+
+    // Entries were fully validated when indexed, only re-check the meta
+    afw_kvs_entry_meta_t meta = {{0}};
+    uint8_t *pos = (uint8_t *)slot->entry;
+    if (sizeof(meta) != KVS_FLASH_READ(pos, sizeof(meta), &meta) ||
+        !meta.valid ||
+        !crc_comp_check(meta.meta_crc, &meta, META_CRC_COMP_LEN)) {
+        index_invalidate(part);
+        return scan_for_entry(part, header, header_len);
+    }
+
+    return pos;
+}
+
+static uint8_t* scan_for_entry(fm_flash_partition_t *part, const char *header, uint8_t header_len)
+{
     // scan through partition and attempt to retrieve entry
     afw_kvs_entry_meta_t meta = {{0}};
     for (uint8_t *scan = (uint8_t *)(part->offset + sizeof(afw_kvs_partition_header_t));
@@ -1311,7 +1407,7 @@ static inline bool crc_comp_check(uint16_t comp, void *ptr, uint32_t len)
 }
 
 /* Caller of this function MUST take lock. Function is not implicitly thread-safe */
-static int32_t delete_entry(const uint8_t *pos)
+static int32_t delete_entry(fm_flash_partition_t *part, const uint8_t *pos)
 {
     afw_kvs_entry_meta_t meta = {{0}};
     if (sizeof(meta) !=
@@ -1322,6 +1418,8 @@ static int32_t delete_entry(const uint8_t *pos)
     // Check if it's already deleted
     if (!meta.valid) {return AFW_OK;}
 
+    index_remove(part, pos);
+
     meta.valid = 0;
     int ret = KVS_FLASH_WRITE(pos, sizeof(meta), &meta);
     if (ret != sizeof(meta)) {
@@ -1502,6 +1600,7 @@ static int32_t recover_backup()
     }
 
     ASD_LOG_I(afw, "Restoring data for %s from backup_partition", target->name);
+    index_invalidate(target);
     header.magic = KVS_MAGIC_BYTE;
     header.crc = crc16_update(0, &header, HEADER_LEN_NO_CRC);
 
@@ -1541,6 +1640,235 @@ static int32_t recover_backup()
     UNLOCK_AND_RETURN(target, backup_part, ret);
 }
 
+static afw_kvs_partition_info_t* get_partition_info(fm_flash_partition_t *part)
+{
+    for (int i = 0; i < kvs_mgr.partition_count; i++) {
+        if (part == kvs_mgr.partition_info[i].partition) {
+            return &kvs_mgr.partition_info[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t index_hash(const void *header, uint8_t header_len)
+{
+    const uint8_t *data = header;
+    uint32_t hash = FNV1A_OFFSET_BASIS;
+    for (uint8_t i = 0; i < header_len; i++) {
+        hash ^= data[i];
+        hash *= FNV1A_PRIME;
+    }
+
+    return hash;
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static afw_kvs_index_slot_t* index_lookup(afw_kvs_partition_info_t *info,
+                                          const char *header,
+                                          uint8_t header_len)
+{
+    uint32_t hash = index_hash(header, header_len);
+    uint32_t mask = info->index_slots - 1;
+
+    for (uint32_t i = 0, probe = hash & mask; i < info->index_slots; i++, probe = (probe + 1) & mask) {
+        afw_kvs_index_slot_t *slot = &info->index[probe];
+        if (slot->entry == KVS_INDEX_EMPTY) {
+            return NULL;
+        }
+        if (slot->entry == KVS_INDEX_TOMBSTONE || slot->hash != hash) {
+            continue;
+        }
+
+        // Hash matches, confirm against the header stored in flash
+        afw_kvs_entry_meta_t *meta = (afw_kvs_entry_meta_t *)FLASH_OFFSET(slot->entry);
+        if (meta->namespace_len + meta->key_len == header_len &&
+            !memcmp(header, (uint8_t *)meta + sizeof(*meta), header_len)) {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static bool index_insert(afw_kvs_partition_info_t *info, uint32_t hash, uint32_t entry)
+{
+    // Keep load factor under 3/4, rehashing (and dropping tombstones) when needed
+    if (!info->index || (info->index_used + 1) * 4 > info->index_slots * 3) {
+        uint32_t live = 0;
+        for (uint32_t i = 0; i < info->index_slots; i++) {
+            if (info->index[i].entry != KVS_INDEX_EMPTY &&
+                info->index[i].entry != KVS_INDEX_TOMBSTONE) {
+                live++;
+            }
+        }
+
+        uint32_t slots = info->index_slots ? info->index_slots : AFW_KVS_INDEX_MIN_SLOTS;
+        while ((live + 1) * 2 > slots) {
+            slots *= 2;
+        }
+        if (slots > AFW_KVS_INDEX_MAX_SLOTS) {
+            return false;
+        }
+
+        afw_kvs_index_slot_t *index = calloc(slots, sizeof(afw_kvs_index_slot_t));
+        if (!index) {
+            return false;
+        }
+
+        afw_kvs_index_slot_t *old_index = info->index;
+        uint32_t old_slots = info->index_slots;
+        info->index = index;
+        info->index_slots = slots;
+        info->index_used = 0;
+        for (uint32_t i = 0; i < old_slots; i++) {
+            if (old_index[i].entry != KVS_INDEX_EMPTY &&
+                old_index[i].entry != KVS_INDEX_TOMBSTONE) {
+                index_insert(info, old_index[i].hash, old_index[i].entry);
+            }
+        }
+        free(old_index);
+    }
+
+    uint32_t mask = info->index_slots - 1;
+    uint32_t probe = hash & mask;
+    while (info->index[probe].entry != KVS_INDEX_EMPTY &&
+           info->index[probe].entry != KVS_INDEX_TOMBSTONE) {
+        probe = (probe + 1) & mask;
+    }
+
+    if (info->index[probe].entry == KVS_INDEX_EMPTY) {
+        info->index_used++;
+    }
+    info->index[probe].hash = hash;
+    info->index[probe].entry = entry;
+
+    return true;
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static void index_add(fm_flash_partition_t *part, const char *header, uint8_t header_len, uint32_t entry)
+{
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (!info || info->index_state != KVS_INDEX_VALID) {
+        return;
+    }
+
+    afw_kvs_index_slot_t *slot = index_lookup(info, header, header_len);
+    if (slot) {
+        slot->entry = entry;
+        return;
+    }
+
+    if (!index_insert(info, index_hash(header, header_len), entry)) {
+        ASD_LOG_W(afw, "Index full for %s, using flash scan", part->name);
+        info->index_state = KVS_INDEX_UNAVAILABLE;
+    }
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static void index_remove(fm_flash_partition_t *part, const uint8_t *pos)
+{
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (!info || info->index_state != KVS_INDEX_VALID) {
+        return;
+    }
+
+    afw_kvs_entry_meta_t *meta = (afw_kvs_entry_meta_t *)FLASH_OFFSET(pos);
+    uint32_t hash = index_hash((uint8_t *)meta + sizeof(*meta), meta->namespace_len + meta->key_len);
+    uint32_t mask = info->index_slots - 1;
+
+    for (uint32_t i = 0, probe = hash & mask; i < info->index_slots; i++, probe = (probe + 1) & mask) {
+        afw_kvs_index_slot_t *slot = &info->index[probe];
+        if (slot->entry == KVS_INDEX_EMPTY) {
+            return;
+        }
+        if (slot->entry == (uint32_t)pos) {
+            slot->entry = KVS_INDEX_TOMBSTONE;
+            return;
+        }
+    }
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static void index_reset(fm_flash_partition_t *part)
+{
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (!info) {
+        return;
+    }
+
+    if (info->index) {
+        memset(info->index, 0, info->index_slots * sizeof(afw_kvs_index_slot_t));
+    }
+    info->index_used = 0;
+    info->index_state = KVS_INDEX_VALID;
+}
+
+/* Caller of this function MUST take lock. Function is not implicitly thread-safe */
+static void index_invalidate(fm_flash_partition_t *part)
+{
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (info) {
+        info->index_state = KVS_INDEX_STALE;
+    }
+}
+
+/**
+ * @brief Rebuild the RAM index of a partition from flash
+ *
+ * Walks the partition once and indexes every valid entry. If a key has more
+ * than one valid entry (power was lost in afw_kvs_set after the new entry was
+ * committed but before the old one was invalidated), the newer entry wins and
+ * the older one is deleted to finish the interrupted set.
+ *
+ * Caller of this function MUST take lock. Function is not implicitly thread-safe
+ *
+ * @param part
+ *
+ * @return bool true if the index is usable
+ */
+static bool index_rebuild(fm_flash_partition_t *part)
+{
+    afw_kvs_partition_info_t *info = get_partition_info(part);
+    if (!info) {
+        return false;
+    }
+
+    index_reset(part);
+
+    afw_kvs_entry_meta_t meta = {{0}};
+    for (uint8_t *scan = (uint8_t *)(part->offset + sizeof(afw_kvs_partition_header_t));
+         scan < (uint8_t *)(part->offset + part->size) && *FLASH_OFFSET(scan) != 0xFF; ) {
+        if (sizeof(meta) != KVS_FLASH_READ(scan, sizeof(meta), &meta)) {
+            break;
+        }
+
+        uint8_t header_len = meta.namespace_len + meta.key_len;
+        if (meta.valid &&
+            crc_comp_check(meta.meta_crc, &meta, META_CRC_COMP_LEN) &&
+            crc_comp_check(meta.value_crc, FLASH_OFFSET(scan + sizeof(meta)), header_len + meta.value_len + 1)) {
+            const char *header = (const char *)FLASH_OFFSET(scan) + sizeof(meta);
+            afw_kvs_index_slot_t *slot = index_lookup(info, header, header_len);
+            if (slot) {
+                uint8_t *older = (uint8_t *)slot->entry;
+                slot->entry = (uint32_t)scan;
+                delete_entry(part, older);
+            } else if (!index_insert(info, index_hash(header, header_len), (uint32_t)scan)) {
+                info->index_state = KVS_INDEX_UNAVAILABLE;
+                return false;
+            }
+        }
+
+        if (!find_next_entry(&scan, part->offset + part->size)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
 static int32_t afw_kvs_lock(fm_flash_partition_t *partition) {
     bool ret = pdFALSE;
     for (unsigned i = 0; i < KVS_MAX_PARTITION_COUNT; i++) {
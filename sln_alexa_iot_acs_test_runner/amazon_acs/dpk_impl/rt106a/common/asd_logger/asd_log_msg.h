@@ -40,6 +40,7 @@ extern "C"
     (_pline_header)->timestamp_ms = _ts;                           \
     (_pline_header)->level = _level;                               \
     (_pline_header)->task_id = _tid;                               \
+    (_pline_header)->tokenized = 0;                                \
     (_pline_header)->pc = _pc
 
 //Get the log line body length, excluding message header.
@@ -66,7 +67,8 @@ COMPILE_TIME_ASSERT(sizeof(asd_log_msg_t) == 4);
 typedef struct {
     uint64_t timestamp_ms           : 42;   ///< Time stamp of the log line. In Milliseconds. 42 bits integer can hold about 139 years in milliseconds from epoch time.
     uint64_t level                  : 3;    ///< Log verbosity level, up to 8 levels.
-    uint64_t reserved               : 11;
+    uint64_t tokenized              : 1;    ///< Log body is a token line, check asd_log_token.h.
+    uint64_t reserved               : 10;
     uint64_t task_id                : 8;    ///< Task ID the log belongs to. Up to 255.
     uint32_t pc;                            ///< Program counter for the print line. This is equivalent to filename + line.
     uint8_t  data[];                        ///< Log_body contains one line of log print, and should not have line ending.
@@ -79,6 +81,8 @@ COMPILE_TIME_ASSERT(sizeof(asd_log_line_header_t) == 12);
 #define ASD_LOG_LINE_HEADER_TXT_SIZE (40)
 // size delta of binary line header and text line header.
 #define ASD_LOG_LINE_HEADER_SIZE_DELTA (ASD_LOG_LINE_HEADER_TXT_SIZE - ASD_LOG_LINE_HEADER_BIN_SIZE)
+// length prefix of a raw log line, read with LOG_DATA_TYPE_BIT_TOKEN.
+#define ASD_LOG_RAW_LINE_LENGTH_SIZE (2)
 
 
 
@@ -80,10 +80,23 @@ typedef struct asd_log_control_block{
 #define asd_log_module_set_stream_bitmap(_module, _filter_stream_bm)        \
         asd_log_control_block_##_module.ostream_bm = _filter_stream_bm
 
+#if ASD_LOG_TOKENIZED
+// Place the format string literal in the asd_log_fmt section. Its offset in the section
+// is the token of the log line.
+#define ASD_LOG_FMT(fmt)                                                    \
+    ({                                                                      \
+        static const char _asd_log_fmt[]                                    \
+        __attribute__((section("asd_log_fmt"), used)) = fmt;               \
+        _asd_log_fmt;                                                       \
+    })
+#else
+#define ASD_LOG_FMT(fmt) fmt
+#endif
+
 //Declare for platform specific logger; This API doesn't have filter option.
 void asd_log_base_logger(asd_log_control_block_t* module, uint8_t logid, uint8_t level, uint32_t pc, uint32_t more_options, const char* fmt, ...);
 #define ASD_LOG_PLATFORM_BASE(module, logid, level,  pc, more_options, fmt, ...) \
-        asd_log_base_logger(&module, logid, level,  pc, more_options, fmt, ##__VA_ARGS__)
+        asd_log_base_logger(&module, logid, level,  pc, more_options, ASD_LOG_FMT(fmt), ##__VA_ARGS__)
 
 
 // LOG macro for platform usage.
@@ -0,0 +1,464 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All rights reserved.
+ *
+ * AMAZON PROPRIETARY/CONFIDENTIAL
+ *
+ * You may not use this file except in compliance with the terms and
+ * conditions set forth in the accompanying LICENSE.TXT file. This file is a
+ * Modifiable File, as defined in the accompanying LICENSE.TXT file.
+ *
+ * THESE MATERIALS ARE PROVIDED ON AN "AS IS" BASIS. AMAZON SPECIFICALLY
+ * DISCLAIMS, WITH RESPECT TO THESE MATERIALS, ALL WARRANTIES, EXPRESS,
+ * IMPLIED, OR STATUTORY, INCLUDING THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT.
+ */
+/*******************************************************************************
+* Encode and decode tokenized log lines.
+*@File: asd_log_token.c
+********************************************************************************
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include "asd_log_token.h"
+#include "asd_logger_internal_config.h"
+#include "common_macros.h"
+
+#if ASD_LOG_TOKENIZED
+
+// Format strings placed by ASD_LOG_FMT(). GNU ld defines the bounds of the section.
+extern const char __start_asd_log_fmt[];
+extern const char __stop_asd_log_fmt[];
+
+#define TOKEN_NONE          (-1)    // width or precision omitted.
+#define TOKEN_STAR          (-2)    // width or precision passed in arguments.
+#define TOKEN_CONV_MAXSIZE  (16)
+
+typedef enum {
+    TOKEN_LEN_NONE,
+    TOKEN_LEN_HH,
+    TOKEN_LEN_H,
+    TOKEN_LEN_L,
+    TOKEN_LEN_LL,
+    TOKEN_LEN_J,
+    TOKEN_LEN_Z,
+    TOKEN_LEN_T,
+} token_length_t;
+
+// One conversion of the format string.
+typedef struct {
+    char flags[6];
+    int32_t width;
+    int32_t precision;
+    token_length_t length;
+    char conv;
+} token_spec_t;
+
+typedef struct {
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t len;
+    int32_t rc;
+} token_writer_t;
+
+typedef struct {
+    const uint8_t* buf;
+    uint32_t size;
+    uint32_t pos;
+    int32_t rc;
+} token_reader_t;
+
+typedef struct {
+    char* txt;
+    uint32_t size;
+    uint32_t len;
+} token_text_t;
+
+static inline uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+bool asd_log_token_is_fmt(const char* fmt)
+{
+    return fmt >= __start_asd_log_fmt && fmt < __stop_asd_log_fmt;
+}
+
+// Parse the conversion following '%'. Return the position after it, or NULL if it
+// is not supported.
+static const char* token_parse_spec(const char* fmt, token_spec_t* spec)
+{
+    uint32_t nflags = 0;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->width = TOKEN_NONE;
+    spec->precision = TOKEN_NONE;
+
+    while (*fmt && strchr("-+ #0", *fmt)) {
+        if (nflags < sizeof(spec->flags) - 1) {
+            spec->flags[nflags++] = *fmt;
+        }
+        fmt++;
+    }
+
+    if (*fmt == '*') {
+        spec->width = TOKEN_STAR;
+        fmt++;
+    } else if (*fmt >= '0' && *fmt <= '9') {
+        spec->width = 0;
+        while (*fmt >= '0' && *fmt <= '9') {
+            spec->width = spec->width * 10 + (*fmt++ - '0');
+        }
+    }
+
+    if (*fmt == '.') {
+        fmt++;
+        spec->precision = 0;
+        if (*fmt == '*') {
+            spec->precision = TOKEN_STAR;
+            fmt++;
+        }
+        while (*fmt >= '0' && *fmt <= '9') {
+            spec->precision = spec->precision * 10 + (*fmt++ - '0');
+        }
+    }
+
+    switch (*fmt) {
+    case 'h':
+        fmt++;
+        spec->length = TOKEN_LEN_H;
+        if (*fmt == 'h') {
+            fmt++;
+            spec->length = TOKEN_LEN_HH;
+        }
+        break;
+    case 'l':
+        fmt++;
+        spec->length = TOKEN_LEN_L;
+        if (*fmt == 'l') {
+            fmt++;
+            spec->length = TOKEN_LEN_LL;
+        }
+        break;
+    case 'j':
+        fmt++;
+        spec->length = TOKEN_LEN_J;
+        break;
+    case 'z':
+        fmt++;
+        spec->length = TOKEN_LEN_Z;
+        break;
+    case 't':
+        fmt++;
+        spec->length = TOKEN_LEN_T;
+        break;
+    default:
+        break;
+    }
+
+    // no %n, and no long double (L).
+    if (!*fmt || !strchr("diucoxXpsfFeEgGaA%", *fmt)) return NULL;
+    spec->conv = *fmt;
+    return fmt + 1;
+}
+
+static void token_put_varint(token_writer_t* w, uint64_t value)
+{
+    do {
+        if (w->len >= w->size) {
+            w->rc = ASD_LOGGER_ERROR_LINE_LENGTH_LIMIT;
+            return;
+        }
+        w->buf[w->len++] = (value & 0x7F) | ((value > 0x7F) ? 0x80 : 0);
+        value >>= 7;
+    } while (value);
+}
+
+// Return the length of the string put.
+static uint32_t token_put_string(token_writer_t* w, const char* str, uint32_t maxlen)
+{
+    uint32_t len = str ? strnlen(str, MIN(maxlen, w->size)) : 0;
+
+    token_put_varint(w, len);
+    if (w->rc < 0) return 0;
+    if (len > w->size - w->len) {
+        w->rc = ASD_LOGGER_ERROR_LINE_LENGTH_LIMIT;
+        return 0;
+    }
+    if (len) {
+        memcpy(w->buf + w->len, str, len);
+        w->len += len;
+    }
+    return len;
+}
+
+static void token_put_double(token_writer_t* w, double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if (w->size - w->len < sizeof(bits)) {
+        w->rc = ASD_LOGGER_ERROR_LINE_LENGTH_LIMIT;
+        return;
+    }
+    for (uint32_t i = 0; i < sizeof(bits); i++) {
+        w->buf[w->len++] = (uint8_t) (bits >> (8 * i));
+    }
+}
+
+static uint64_t token_get_varint(token_reader_t* r)
+{
+    uint64_t value = 0;
+    uint32_t shift = 0;
+    uint8_t byte;
+
+    do {
+        if (r->pos >= r->size || shift >= 64) {
+            r->rc = ASD_LOGGER_ERROR;
+            return 0;
+        }
+        byte = r->buf[r->pos++];
+        value |= (uint64_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+static const char* token_get_string(token_reader_t* r, uint32_t* len)
+{
+    uint64_t value = token_get_varint(r);
+
+    *len = 0;
+    if (r->rc < 0) return "";
+    if (value > r->size - r->pos) {
+        r->rc = ASD_LOGGER_ERROR;
+        return "";
+    }
+    *len = (uint32_t) value;
+    r->pos += *len;
+    return (const char*) r->buf + r->pos - *len;
+}
+
+static double token_get_double(token_reader_t* r)
+{
+    uint64_t bits = 0;
+    double value;
+
+    if (r->size - r->pos < sizeof(bits)) {
+        r->rc = ASD_LOGGER_ERROR;
+        return 0;
+    }
+    for (uint32_t i = 0; i < sizeof(bits); i++) {
+        bits |= (uint64_t) r->buf[r->pos++] << (8 * i);
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void token_print(token_text_t* t, const char* fmt, ...)
+{
+    va_list ap;
+
+    if (t->len + 1 >= t->size) return;
+    va_start(ap, fmt);
+    int rc = vsnprintf(t->txt + t->len, t->size - t->len, fmt, ap);
+    va_end(ap);
+    if (rc > 0) {
+        t->len = MIN(t->len + rc, t->size - 1);
+    }
+}
+
+int32_t asd_log_token_encode(uint8_t* buf, uint32_t size, const asd_log_options_t* options,
+                             const char* fmt, va_list vargs)
+{
+    if (!buf || !options || !asd_log_token_is_fmt(fmt))
+        return ASD_LOGGER_ERROR_INVALID_PARAMETERS;
+
+    token_writer_t w = {buf, size, 0, ASD_LOGGER_OK};
+    token_spec_t spec;
+
+    token_put_varint(&w, fmt - __start_asd_log_fmt);
+    token_put_string(&w, options->tag, ASD_LOG_LINE_MAXSIZE);
+    // the decoder reads the line number only after a name that is not empty.
+    if (token_put_string(&w, options->func_name, ASD_LOGGER_FUNC_NAME_LENGTH_MAX)) {
+        token_put_varint(&w, (uint32_t) options->line_no);
+    }
+
+    while (*fmt && w.rc == ASD_LOGGER_OK) {
+        if (*fmt++ != '%') continue;
+        fmt = token_parse_spec(fmt, &spec);
+        if (!fmt) return ASD_LOGGER_ERROR_INVALID_PARAMETERS;
+
+        if (spec.width == TOKEN_STAR) {
+            token_put_varint(&w, zigzag_encode(va_arg(vargs, int)));
+        }
+        if (spec.precision == TOKEN_STAR) {
+            spec.precision = va_arg(vargs, int);
+            token_put_varint(&w, zigzag_encode(spec.precision));
+        }
+
+        switch (spec.conv) {
+        case 'd':
+        case 'i': {
+            int64_t value;
+            switch (spec.length) {
+            case TOKEN_LEN_HH:  value = (signed char) va_arg(vargs, int);   break;
+            case TOKEN_LEN_H:   value = (short) va_arg(vargs, int);         break;
+            case TOKEN_LEN_L:   value = va_arg(vargs, long);                break;
+            case TOKEN_LEN_LL:  value = va_arg(vargs, long long);           break;
+            case TOKEN_LEN_J:   value = va_arg(vargs, intmax_t);            break;
+            case TOKEN_LEN_Z:   value = (ptrdiff_t) va_arg(vargs, size_t);  break;
+            case TOKEN_LEN_T:   value = va_arg(vargs, ptrdiff_t);           break;
+            default:            value = va_arg(vargs, int);                 break;
+            }
+            token_put_varint(&w, zigzag_encode(value));
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t value;
+            switch (spec.length) {
+            case TOKEN_LEN_HH:  value = (unsigned char) va_arg(vargs, unsigned int);    break;
+            case TOKEN_LEN_H:   value = (unsigned short) va_arg(vargs, unsigned int);   break;
+            case TOKEN_LEN_L:   value = va_arg(vargs, unsigned long);                   break;
+            case TOKEN_LEN_LL:  value = va_arg(vargs, unsigned long long);              break;
+            case TOKEN_LEN_J:   value = va_arg(vargs, uintmax_t);                       break;
+            case TOKEN_LEN_Z:   value = va_arg(vargs, size_t);                          break;
+            case TOKEN_LEN_T:   value = (size_t) va_arg(vargs, ptrdiff_t);              break;
+            default:            value = va_arg(vargs, unsigned int);                    break;
+            }
+            token_put_varint(&w, value);
+            break;
+        }
+        case 'c':
+            token_put_varint(&w, zigzag_encode(va_arg(vargs, int)));
+            break;
+        case 'p':
+            token_put_varint(&w, (uintptr_t) va_arg(vargs, void*));
+            break;
+        case 's': {
+            const char* str = va_arg(vargs, const char*);
+            token_put_string(&w, str ? str : "(null)",
+                             (spec.precision >= 0) ? (uint32_t) spec.precision : size);
+            break;
+        }
+        case '%':
+            break;
+        default:
+            // floating point conversions.
+            token_put_double(&w, va_arg(vargs, double));
+            break;
+        }
+    }
+
+    return (w.rc < 0) ? w.rc : (int32_t) w.len;
+}
+
+int32_t asd_log_token_decode(const uint8_t* body, uint32_t length, char* txt, uint32_t size)
+{
+    if (!body || !txt || !size) return ASD_LOGGER_ERROR_INVALID_PARAMETERS;
+
+    token_reader_t r = {body, length, 0, ASD_LOGGER_OK};
+    token_text_t t = {txt, size, 0};
+    token_spec_t spec;
+    char conv[TOKEN_CONV_MAXSIZE];
+    const char* str;
+    uint32_t len;
+
+    txt[0] = '\0';
+    uint64_t token = token_get_varint(&r);
+    if (r.rc < 0 || token >= (uint64_t) (__stop_asd_log_fmt - __start_asd_log_fmt))
+        return ASD_LOGGER_ERROR;
+    const char* fmt = __start_asd_log_fmt + token;
+
+    str = token_get_string(&r, &len);
+    if (len) {
+        token_print(&t, "%.*s:", (int) len, str);
+    }
+    str = token_get_string(&r, &len);
+    if (len) {
+        int line_no = (int) token_get_varint(&r);
+        token_print(&t, "%.*s:%d:", (int) len, str, line_no);
+    }
+
+    while (*fmt && r.rc == ASD_LOGGER_OK) {
+        const char* literal = fmt;
+        while (*fmt && *fmt != '%') fmt++;
+        if (fmt > literal) {
+            token_print(&t, "%.*s", (int) (fmt - literal), literal);
+        }
+        if (!*fmt) break;
+
+        fmt = token_parse_spec(fmt + 1, &spec);
+        if (!fmt) return ASD_LOGGER_ERROR;
+        if (spec.conv == '%') {
+            token_print(&t, "%%");
+            continue;
+        }
+
+        // Width and precision are always passed with '*', a negative precision is omitted.
+        int width = (spec.width == TOKEN_NONE) ? 0 : spec.width;
+        int precision = spec.precision;
+        if (spec.width == TOKEN_STAR) {
+            width = (int) zigzag_decode(token_get_varint(&r));
+        }
+        if (spec.precision == TOKEN_STAR) {
+            precision = (int) zigzag_decode(token_get_varint(&r));
+        }
+        snprintf(conv, sizeof(conv), "%%%s*%s%s%c", spec.flags,
+                 strchr("cp", spec.conv) ? "" : ".*",
+                 strchr("diouxX", spec.conv) ? "ll" : "",
+                 spec.conv);
+
+        switch (spec.conv) {
+        case 'd':
+        case 'i': {
+            long long value = zigzag_decode(token_get_varint(&r));
+            token_print(&t, conv, width, precision, value);
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            unsigned long long value = token_get_varint(&r);
+            token_print(&t, conv, width, precision, value);
+            break;
+        }
+        case 'c': {
+            int value = (int) zigzag_decode(token_get_varint(&r));
+            token_print(&t, conv, width, value);
+            break;
+        }
+        case 'p': {
+            void* value = (void*) (uintptr_t) token_get_varint(&r);
+            token_print(&t, conv, width, value);
+            break;
+        }
+        case 's':
+            str = token_get_string(&r, &len);
+            if (precision < 0 || (uint32_t) precision > len) {
+                precision = len;
+            }
+            token_print(&t, conv, width, precision, str);
+            break;
+        default: {
+            double value = token_get_double(&r);
+            token_print(&t, conv, width, precision, value);
+            break;
+        }
+        }
+    }
+
+    return (r.rc < 0) ? r.rc : (int32_t) t.len;
+}
+
+#endif
@@ -63,7 +63,7 @@ static ace_status_t cli_log_upload(int32_t len, const char *param[])
     return ACE_STATUS_OK;
 }
 
-static ace_status_t cli_log_dump(int32_t len, const char *param[])
+static ace_status_t log_dump(int32_t len, const char *param[], bool raw)
 {
     #define LOG_BUF_SIZE    1024
     log_reader_origin_t origin = LOG_POSITION_START;
@@ -82,7 +82,7 @@ static ace_status_t cli_log_dump(int32_t len, const char *param[])
         }
     }
 
-    asd_log_reader_t* reader = log_reader_create(id, LOG_DATA_TYPE_BIT_TXT);
+    asd_log_reader_t* reader = log_reader_create(id, raw ? LOG_DATA_TYPE_BIT_TOKEN : LOG_DATA_TYPE_BIT_TXT);
     if (!reader) {
         printf("error to create a log reader\r\n");
         return ACE_STATUS_OK;
@@ -110,7 +110,14 @@ static ace_status_t cli_log_dump(int32_t len, const char *param[])
     while(1) {
         rc = log_reader_read(reader, buf, LOG_BUF_SIZE);
         if (rc <=0) break;
-        printf("%.*s", (int)rc, buf);
+        if (raw) {
+            //hex, 32 bytes per line. Decode it with scripts/asd_log_decode.py.
+            for (int32_t i = 0; i < rc; i++) {
+                printf("%02X%s", buf[i], ((i + 1) % 32 == 0 || i + 1 == rc) ? "\r\n" : "");
+            }
+        } else {
+            printf("%.*s", (int)rc, buf);
+        }
         log_size += rc;
     }
 
@@ -121,6 +128,16 @@ static ace_status_t cli_log_dump(int32_t len, const char *param[])
     return ACE_STATUS_OK;
 }
 
+static ace_status_t cli_log_dump(int32_t len, const char *param[])
+{
+    return log_dump(len, param, false);
+}
+
+static ace_status_t cli_log_dump_raw(int32_t len, const char *param[])
+{
+    return log_dump(len, param, true);
+}
+
 static int convert_char_to_level(char level_ch)
 {
     for (int level = 0; level < (int)sizeof(level_char); level++) {
@@ -462,6 +479,9 @@ const aceCli_moduleCmd_t log_cli[] = {
     { "dump",   " Dumps logs,\n\t dump [log_id] [0/1]\n\t "
                 LOGID_HELP
                 "\n\t 1: dump unread log only, 0(default): regardless of read/unread",  ACE_CLI_SET_LEAF, .command.func=&cli_log_dump},
+    { "dumpraw", " Dumps raw log lines in hex, tokenized lines are not decoded,\n\t dumpraw [log_id] [0/1]\n\t "
+                LOGID_HELP
+                "\n\t 1: dump unread log only, 0(default): regardless of read/unread",  ACE_CLI_SET_LEAF, .command.func=&cli_log_dump_raw},
     { "wipe",   " Wipes all log for log_id.\n\t wipe [log_id]\n\t " LOGID_HELP,  ACE_CLI_SET_LEAF, .command.func=&cli_log_wipe},
     { "wipe_expired",   " Wipes main logs older than x seconds from current time_stamp.\n\t wipe_expired [seconds before now]\n\t ",
                 ACE_CLI_SET_LEAF, .command.func=&cli_log_wipe_expired},
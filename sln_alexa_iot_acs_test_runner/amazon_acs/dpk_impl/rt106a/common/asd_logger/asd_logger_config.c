@@ -20,6 +20,10 @@
 #include "asd_logger_config.h"
 #include "asd_logger_internal_config.h"
 #include "asd_log_platform_api.h"
+#include "afw_cir_buf.h"
+
+// the main input buffer is a multi-producer ring.
+_Static_assert(AFW_MPSC_RING_SIZE_VALID(ASD_LOG_MAIN_BUFFER_SIZE), "ASD_LOG_MAIN_BUFFER_SIZE must be a power of two");
 
 // default asd_logger configuration. Application can define its own configuration for asd logger.
 const asd_logger_config_t g_logger_default_config = {
@@ -32,6 +32,25 @@
  * @remark This implementation assumes contiguous 0xFF bytes no more than
  * 4096 bytes. This allows the library to recover safely after device reboots.
  *
+ * The writes are combined in RAM: the data of an entry is programmed in page
+ * aligned chunks when it is completed. With AFW_CIR_FLASH_DEFER_WRITE, the data
+ * and the table entries of up to AFW_CIR_FLASH_WRITE_BATCH completed entries
+ * are programmed together instead. The batch is then programmed when it is
+ * full, when the data is read, on afw_cir_flash_flush() and, with
+ * AFW_CIR_FLASH_ERASE_TASK, at the latest AFW_CIR_FLASH_FLUSH_DELAY_MS after an
+ * entry is completed. A power cut, a reset or a crash loses the entries that
+ * are still in RAM. The entries are programmed write started before the data
+ * and completed after it, entries left write started are abandoned on init.
+ *
+ * With AFW_CIR_FLASH_ERASE_TASK, the blocks that are read are erased by a low
+ * priority task, ahead of the writer, so it never waits for an erase. The same
+ * task programs the write batch when it is left in RAM too long.
+ *
+ * Wear is not levelled beyond the circular use of the blocks: the table and
+ * the data blocks are each erased in turn. The erase counts of
+ * afw_cir_flash_get_info() are kept in RAM and start from 0 at every init,
+ * they measure the wear of a run and are not used to pick a block.
+ *
  * -------- 0 -------------
  * FLASH TABLE
  * -------- 8K ------------
@@ -45,10 +64,12 @@
 #define AFW_CIR_FLASH_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include <FreeRTOS.h>
 #include <event_groups.h>
 #include <semphr.h>
+#include <task.h>
 
 #include <afw_error.h>
 
@@ -64,6 +85,65 @@
 #define AFW_CIR_FLASH_TABLE_SIZE            8192
 #endif
 
+/**
+ * @brief Size of the RAM buffer combining the data writes
+ *
+ * It should be a multiple of the 256 bytes flash page.
+ */
+#ifndef AFW_CIR_FLASH_WRITE_BUF_SIZE
+#define AFW_CIR_FLASH_WRITE_BUF_SIZE        1024
+#endif
+
+/**
+ * @brief Keep the completed entries in RAM to combine them in a batch
+ *
+ * When 0, 'afw_cir_flash_write_complete()' programs the entry before it
+ * returns. When 1, the completed entries stay in RAM until the batch is
+ * programmed. Nothing flushes the batch on a reset or a crash, so only enable
+ * it for data whose last entries may be lost, or call 'afw_cir_flash_flush()'
+ * before rebooting.
+ */
+#ifndef AFW_CIR_FLASH_DEFER_WRITE
+#define AFW_CIR_FLASH_DEFER_WRITE           0
+#endif
+
+/**
+ * @brief Maximum number of entries combined in a flash program, with
+ * AFW_CIR_FLASH_DEFER_WRITE
+ */
+#ifndef AFW_CIR_FLASH_WRITE_BATCH
+#define AFW_CIR_FLASH_WRITE_BATCH           16
+#endif
+
+/**
+ * @brief Erase the read blocks in a background task
+ *
+ * When 0, the application calls 'afw_cir_flash_erase()' and
+ * 'afw_cir_flash_flush()' periodically.
+ */
+#ifndef AFW_CIR_FLASH_ERASE_TASK
+#define AFW_CIR_FLASH_ERASE_TASK            1
+#endif
+
+#ifndef AFW_CIR_FLASH_ERASE_TASK_PRIORITY
+#define AFW_CIR_FLASH_ERASE_TASK_PRIORITY   (tskIDLE_PRIORITY + 1)
+#endif
+
+#ifndef AFW_CIR_FLASH_ERASE_TASK_STACK_SIZE
+#define AFW_CIR_FLASH_ERASE_TASK_STACK_SIZE 1024
+#endif
+
+/**
+ * @brief Longest time a completed entry stays in RAM, with AFW_CIR_FLASH_ERASE_TASK
+ * and AFW_CIR_FLASH_DEFER_WRITE
+ *
+ * The erase task programs the write batch this long after the first entry of
+ * the batch is completed, if it is not programmed before.
+ */
+#ifndef AFW_CIR_FLASH_FLUSH_DELAY_MS
+#define AFW_CIR_FLASH_FLUSH_DELAY_MS        1000
+#endif
+
 /**
  * @brief Metrics Error codes
  * @{
@@ -145,6 +225,16 @@ typedef struct afw_cir_flash_s {
     uint32_t next_data_erase_offset;
     SemaphoreHandle_t mutex;
     EventGroupHandle_t erase_async_event;
+    TaskHandle_t erase_task;
+    bool erase_busy;                     /* A data block is erased out of the mutex */
+    uint8_t *write_buf;                  /* Entries, then data of the write batch */
+    uint32_t write_buf_length;           /* Bytes of data in the write batch */
+    uint32_t batch_entries;              /* Entries in the write batch, the last may be open */
+    bool batch_open_written;             /* The first entry is already write started in flash */
+    uint32_t batch_entry_offset;         /* Table offset of the first entry of the batch */
+    uint32_t batch_data_offset;          /* Data offset of the first byte of the batch */
+    uint16_t *erase_count;               /* Erases of each 4K block since init */
+    uint32_t programs;                   /* Flash programs since init */
 } afw_cir_flash_t;
 
 /**
@@ -159,6 +249,10 @@ typedef struct afw_cir_flash_info_s {
     uint32_t avail_erase_entries;        /* Available entries to erase */
     uint32_t avail_unread_size;
     uint32_t avail_unread_entries;       /* Available entries to read */
+    uint32_t programs;                   /* Flash programs since init */
+    uint16_t table_erase_count;          /* Most erased flash table block, since init */
+    uint16_t data_erase_count_min;       /* Least erased data block, since init */
+    uint16_t data_erase_count_max;       /* Most erased data block, since init */
 } afw_cir_flash_info_t;
 
 /**
@@ -204,11 +298,33 @@ int32_t afw_cir_flash_write(afw_cir_flash_t *flash, uint32_t length,
  * to update the flash entry data structure which maintains meta data for
  * data integrity.
  *
+ * The entry and its data are in flash when this returns. With
+ * AFW_CIR_FLASH_DEFER_WRITE, the entry is completed in the RAM write batch, it
+ * is in flash once the batch is programmed: when AFW_CIR_FLASH_WRITE_BATCH
+ * entries are combined, on a read, on 'afw_cir_flash_flush()', or
+ * AFW_CIR_FLASH_FLUSH_DELAY_MS later by the erase task. Without
+ * AFW_CIR_FLASH_ERASE_TASK, call 'afw_cir_flash_flush()' to bound the entries
+ * lost on a power cut.
+ *
  * @param[in]  flash  Pointer to a circular flash object
  * @return AFW_OK on success, an error on failure
  */
 int32_t afw_cir_flash_write_complete(afw_cir_flash_t *flash);
 
+/**
+ * @brief Program the writes combined in RAM
+ *
+ * With AFW_CIR_FLASH_DEFER_WRITE, the completed entries are readable after
+ * the batch is programmed. It is programmed when full, before a read and by
+ * the erase task AFW_CIR_FLASH_FLUSH_DELAY_MS after an entry is completed;
+ * call this to program it now, before a reboot for instance. Without it, there
+ * is no completed entry to program.
+ *
+ * @param[in]  flash  Pointer to a circular flash object
+ * @return AFW_OK on success, an error on failure
+ */
+int32_t afw_cir_flash_flush(afw_cir_flash_t *flash);
+
 /**
  * @brief Read the requested bytes of data from circular flash
  *
@@ -240,7 +356,8 @@ int32_t afw_cir_flash_read_complete(afw_cir_flash_t *flash);
  *
  * Erases 4K blocks of read/abandoned circular flash. This should be
  * called periodically preferrably from a low priority task that erases
- * and frees memory for write operations.
+ * and frees memory for write operations. With AFW_CIR_FLASH_ERASE_TASK, the
+ * blocks are erased in the background and calling this is optional.
  *
  * @param[in]  flash  Pointer to a circular flash object
  * @return AFW_OK on success, an error from afw_error.h
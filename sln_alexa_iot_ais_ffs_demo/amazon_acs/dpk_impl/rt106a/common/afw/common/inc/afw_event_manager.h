@@ -28,6 +28,13 @@
  * on the queue.
  *
  * The event handler should regularly
+ *
+ * Events published with afw_publish_event() carry a borrowed pdata, which has to be NULL or static
+ * data since the publisher cannot tell when every subscriber is done with it. Events with any other
+ * data are published with afw_publish_event_ref() and carry an envelope allocated with
+ * afw_event_alloc(): each subscriber queue holds one reference to it. The received afw_event_t
+ * says whether pdata is such a reference, the subscriber hands it back with afw_event_done(). The
+ * envelope is freed with the last reference, no copy of the data is made for the fan-out.
  */
 
 #ifndef AFW_EVENT_MANAGER_H
@@ -51,6 +58,9 @@ typedef enum {
 #define AFW_NUM_EVENT_QUEUES 20
 
 #define AFW_EVENT_QUEUE_LENGTH 6
+
+// Time a publishing task waits for room in each full subscriber queue.
+#define AFW_EVENT_PUBLISH_TIMEOUT_TICKS 1
 #endif
 
 typedef struct {
@@ -59,12 +69,24 @@ typedef struct {
 
     /** @brief The data attached to the event */
     void *pdata;
+
+    /** @brief pdata is a reference from afw_event_alloc(), hand it back with afw_event_done() */
+    bool ref;
 } afw_event_t;
 
 #define EVENT_QUEUE_AUTO        (-1)
 #define AFW_MAX_EVENT_QUEUES    32
 #define AFW_NO_EVENT            (-1)
 
+/** @brief Per event queue counters, since init or the last reset */
+typedef struct {
+    uint32_t posted;        ///< events queued
+    uint32_t dropped;       ///< events not queued, the queue was full
+    uint32_t received;      ///< events taken out of the queue
+    uint32_t max_latency;   ///< longest time in the queue, in ticks
+    uint64_t total_latency; ///< sum of the time in the queue, in ticks
+} afw_event_queue_stats_t;
+
 #if AFW_NUM_EVENT_QUEUES > AFW_MAX_EVENT_QUEUES
 #error Too many event queues
 #endif
@@ -105,8 +127,11 @@ int afw_post_event(int8_t queue_id, int event_id, void *pdata,
 /**
  * @brief Publish event to all event queues that have subscribed to it.
  *
- * Published events
- * appear in the same order to all subscribers.
+ * pdata is lent to every subscriber, so it has to be NULL or static data. Use
+ * afw_publish_event_ref() for anything else. Events published by tasks appear
+ * in the same order to all subscribers. A task waits up to
+ * AFW_EVENT_PUBLISH_TIMEOUT_TICKS for room in each full queue, an ISR does not
+ * wait.
  *
  * @param event_id needs to be in [0, AFW_NUM_EVENTS - 1].
  *
@@ -117,14 +142,49 @@ int afw_post_event(int8_t queue_id, int event_id, void *pdata,
  */
 int afw_publish_event(int event_id, void *pdata, portBASE_TYPE *pxHigherPriorityTaskWoken);
 
+/**
+ * @brief Allocate a reference counted event envelope of 'size' bytes for afw_publish_event_ref().
+ *
+ * Do not call from an ISR.
+ *
+ * @return pointer to the event data, NULL on failure.
+ */
+void *afw_event_alloc(size_t size);
+
+/**
+ * @brief Publish an event with data from afw_event_alloc() to all event queues that have
+ * subscribed to it, without copying the data.
+ *
+ * The reference of the caller is handed over: each queue the event is posted to gets its own
+ * reference and the envelope is freed right away if there is no subscriber. Subscribers call
+ * afw_event_release() on the received pdata. Published events appear in the same order to all
+ * subscribers, the posts wait as in afw_publish_event().
+ *
+ * Do not call from an ISR.
+ *
+ * @param event_id needs to be in [0, AFW_NUM_EVENTS - 1].
+ *
+ * @return 0 on success, -1 if the event could not be posted to at least one subscriber.
+ */
+int afw_publish_event_ref(int event_id, void *pdata);
+
+/**
+ * @brief Release a reference to event data from afw_event_alloc(), the envelope is freed with
+ * the last reference. Do not call from an ISR.
+ */
+void afw_event_release(void *pdata);
+
 /**
  * @brief Get an event from an event queue, blocking for at most timeout_ticks.
  *
  * Do not call from an ISR.
  *
+ * @param event receives the event, the caller calls afw_event_done() on it once it is
+ * done with the data. If NULL, the data of the event is dropped.
+ *
  * @return the event id
  */
-int afw_get_event(int8_t queue_id, void **pdata, TickType_t timeout_ticks);
+int afw_get_event(int8_t queue_id, afw_event_t *event, TickType_t timeout_ticks);
 
 /**
  * @brief Wait for specified event from event queue, blocking for at most timeout_ticks
@@ -136,9 +196,25 @@ int afw_get_event(int8_t queue_id, void **pdata, TickType_t timeout_ticks);
  *
  * @param event_id should be in [0, AFW_NUM_EVENTS - 1]
  *
+ * @param event receives the event as with afw_get_event(), may be NULL. Other events
+ * taken out of the queue meanwhile are dropped.
+ *
  * @return 0 on success, an afw_error value on failure
  */
-int afw_wait_for_event(int8_t queue_id, int event_id, void **pdata, TickType_t timeout_ticks);
+int afw_wait_for_event(int8_t queue_id, int event_id, afw_event_t *event, TickType_t timeout_ticks);
+
+/**
+ * @brief Hand back the data of a received event, releases its reference if it holds one.
+ *
+ * Do not call from an ISR.
+ */
+static inline void afw_event_done(afw_event_t *event)
+{
+    if (event->ref)
+        afw_event_release(event->pdata);
+    event->pdata = NULL;
+    event->ref   = false;
+}
 
 /**
  * @brief Subscribe the specified queue to the events in 'events'.
@@ -178,6 +254,15 @@ void afw_flush_event_queue(int8_t queue_id);
  */
 int afw_event_queue_deinit(int8_t queue_id);
 
+/**
+ * @brief Get the counters of an event queue.
+ *
+ * @param reset clear the counters after reading them.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int afw_event_queue_get_stats(int8_t queue_id, afw_event_queue_stats_t *stats, bool reset);
+
 /**
  * @brief Subscribe the specified queue to the event.
  *
@@ -325,3 +325,191 @@ int32_t afw_cir_buf_deinit(afw_cir_buf_t** cir_buf)
 
     return 0;
 }
+
+/*******************************************************************************
+ * AFW multi-producer single-consumer ring
+ *******************************************************************************
+ */
+
+afw_mpsc_ring_t* afw_mpsc_ring_init(uint32_t size)
+{
+    if (!AFW_MPSC_RING_SIZE_VALID(size))
+        return NULL;
+
+    afw_mpsc_ring_t *ring = (afw_mpsc_ring_t*)calloc(1, sizeof(afw_mpsc_ring_t));
+    if (!ring)
+        return NULL;
+
+    // zeroed, no header is committed.
+    ring->buf_ptr = (uint8_t*)calloc(1, size);
+    if (!ring->buf_ptr) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->wr_space_avail_sema = xSemaphoreCreateBinary();
+    if (!ring->wr_space_avail_sema) {
+        afw_mpsc_ring_deinit(&ring);
+        return NULL;
+    }
+
+    ring->size = size;
+
+    return ring;
+}
+
+int32_t afw_mpsc_ring_reserve(afw_mpsc_ring_t* ring, uint32_t data_len, afw_mpsc_ring_slot_t* slot)
+{
+    if (!(ring) || !(data_len) || !(slot) || (data_len >= AFW_MPSC_RING_COMMITTED))
+        return -AFW_EINVAL;
+
+    uint32_t record_len = AFW_MPSC_RING_RECORD_SIZE(data_len);
+    uint32_t idx = __atomic_load_n(&ring->reserve_idx, __ATOMIC_RELAXED);
+
+    do {
+        uint32_t ridx = __atomic_load_n(&ring->read_idx, __ATOMIC_ACQUIRE);
+        if (record_len > (ring->size - (idx - ridx))) {
+            // no space for the whole record.
+            return -AFW_EIO;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->reserve_idx, &idx, idx + record_len, true,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    slot->idx = idx;
+    slot->len = data_len;
+
+    return 0;
+}
+
+void afw_mpsc_ring_slot_copy(afw_mpsc_ring_t* ring, const afw_mpsc_ring_slot_t* slot, uint32_t offset,
+                             const uint8_t* data, uint32_t data_len)
+{
+    uint32_t widx = (slot->idx + sizeof(uint32_t) + offset) & (ring->size - 1);
+    uint32_t copy_len = MIN(data_len, ring->size - widx);
+
+    memcpy(&ring->buf_ptr[widx], data, copy_len);
+    if (copy_len < data_len) {
+        memcpy(ring->buf_ptr, data + copy_len, data_len - copy_len);
+    }
+}
+
+void afw_mpsc_ring_commit(afw_mpsc_ring_t* ring, const afw_mpsc_ring_slot_t* slot)
+{
+    uint32_t *header = (uint32_t*)&ring->buf_ptr[slot->idx & (ring->size - 1)];
+
+    // the data must be visible before the header.
+    __atomic_store_n(header, slot->len | AFW_MPSC_RING_COMMITTED, __ATOMIC_RELEASE);
+}
+
+int32_t afw_mpsc_ring_write(afw_mpsc_ring_t* ring, const uint8_t* data, uint32_t data_len)
+{
+    afw_mpsc_ring_slot_t slot;
+
+    if (!(data))
+        return -AFW_EINVAL;
+
+    int32_t rc = afw_mpsc_ring_reserve(ring, data_len, &slot);
+    if (rc < 0)
+        return rc;
+
+    afw_mpsc_ring_slot_copy(ring, &slot, 0, data, data_len);
+    afw_mpsc_ring_commit(ring, &slot);
+
+    return 0;
+}
+
+int32_t afw_mpsc_ring_write_block(afw_mpsc_ring_t* ring, const uint8_t* data, uint32_t data_len, TickType_t xTicksToWait)
+{
+    bool waited = false;
+
+    if (!(ring) || !(data) || !(data_len))
+        return -AFW_EINVAL;
+
+    if (AFW_MPSC_RING_RECORD_SIZE(data_len) > ring->size)
+        return -AFW_EIO;
+
+    int32_t rc = afw_mpsc_ring_write(ring, data, data_len);
+
+    while ((rc == -AFW_EIO) && !xPortIsInsideInterrupt()) {
+        /* Wait on free space to write */
+        if (xSemaphoreTake(ring->wr_space_avail_sema, xTicksToWait) != pdTRUE) {
+            return -AFW_ETIMEOUT;
+        }
+        waited = true;
+        rc = afw_mpsc_ring_write(ring, data, data_len);
+    }
+
+    // only one waiter gets each signal, pass it on to the next one.
+    if (waited && (rc == 0) && (afw_mpsc_ring_get_data_size(ring) < (int32_t)ring->size)) {
+        xSemaphoreGive(ring->wr_space_avail_sema);
+    }
+
+    return rc;
+}
+
+int32_t afw_mpsc_ring_read(afw_mpsc_ring_t* ring, uint8_t* data, uint32_t data_len)
+{
+    if (!(ring) || !(data) || !(data_len))
+        return -AFW_EINVAL;
+
+    uint32_t mask = ring->size - 1;
+    uint32_t ridx = ring->read_idx;
+    uint32_t *header = (uint32_t*)&ring->buf_ptr[ridx & mask];
+    uint32_t record_hdr = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+
+    if (!(record_hdr & AFW_MPSC_RING_COMMITTED)) {
+        // empty, or the oldest record is not committed yet.
+        return -AFW_EIO;
+    }
+
+    uint32_t record_data_len = record_hdr & ~AFW_MPSC_RING_COMMITTED;
+    uint32_t record_len = AFW_MPSC_RING_RECORD_SIZE(record_data_len);
+    uint32_t didx = (ridx + sizeof(uint32_t)) & mask;
+    uint32_t copy_len = MIN(record_data_len, ring->size - didx);
+
+    if (record_data_len <= data_len) {
+        memcpy(data, &ring->buf_ptr[didx], copy_len);
+        if (copy_len < record_data_len) {
+            memcpy(data + copy_len, ring->buf_ptr, record_data_len - copy_len);
+        }
+    }
+
+    // free the record, zeroed so that the next producers start from uncommitted headers.
+    copy_len = MIN(record_len, ring->size - (ridx & mask));
+    memset(&ring->buf_ptr[ridx & mask], 0, copy_len);
+    if (copy_len < record_len) {
+        memset(ring->buf_ptr, 0, record_len - copy_len);
+    }
+    __atomic_store_n(&ring->read_idx, ridx + record_len, __ATOMIC_RELEASE);
+
+    SEMA_GIVE(ring->wr_space_avail_sema);
+
+    return (record_data_len <= data_len) ? (int32_t)record_data_len : -AFW_ENOMEM;
+}
+
+int32_t afw_mpsc_ring_get_data_size(afw_mpsc_ring_t* ring)
+{
+    if (!ring)
+        return -AFW_EINVAL;
+
+    uint32_t ridx = __atomic_load_n(&ring->read_idx, __ATOMIC_ACQUIRE);
+    uint32_t widx = __atomic_load_n(&ring->reserve_idx, __ATOMIC_ACQUIRE);
+
+    return (int32_t)(widx - ridx);
+}
+
+int32_t afw_mpsc_ring_deinit(afw_mpsc_ring_t** ring)
+{
+    if (!*(ring))
+        return -AFW_EINVAL;
+
+    if ((*ring)->wr_space_avail_sema) {
+        vSemaphoreDelete((*ring)->wr_space_avail_sema);
+    }
+    free((*ring)->buf_ptr);
+    free(*ring);
+
+    *ring = NULL;
+
+    return 0;
+}
@@ -31,6 +31,7 @@
 
 #define DEFAULT_TABLE_SIZE     (8192)
 #define FLASH_BLOCK_SIZE       (4096)
+#define FLASH_PAGE_SIZE        (256)
 #define BITS32_DEFAULT_VALUE   (0xFFFFFFFF)
 #define BITS16_DEFAULT_VALUE   (0xFFFF)
 
@@ -49,6 +50,16 @@
 
 #define SEMAPHORE_TIMEOUT      (5000 / portTICK_PERIOD_MS)
 
+/* erase_async_event bits */
+#define EVENT_ERASE            (1 << 0)
+#define EVENT_STOP             (1 << 1)
+#define EVENT_STOPPED          (1 << 2)
+#define EVENT_FLUSH            (1 << 3)
+
+#if (AFW_CIR_FLASH_WRITE_BUF_SIZE % FLASH_PAGE_SIZE) != 0
+#error "AFW_CIR_FLASH_WRITE_BUF_SIZE should be a multiple of the flash page size"
+#endif
+
 typedef struct flash_table_entry_s {
     uint32_t offset;
     uint32_t length;
@@ -132,14 +143,32 @@ static uint32_t get_block_aligned_offset(uint32_t offset)
     return aligned_offset;
 }
 
+static uint32_t get_data_distance(afw_cir_flash_t *flash, uint32_t from,
+                                  uint32_t to)
+{
+    if (to >= from) {
+        return to - from;
+    }
+
+    return (flash->size - from) + (to - AFW_CIR_FLASH_TABLE_SIZE);
+}
+
+static int32_t flash_program(afw_cir_flash_t *flash, uint32_t offset,
+                             uint32_t length, const uint8_t *buf)
+{
+    (flash->programs)++;
+
+    return fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, offset, length, buf);
+}
+
 static int32_t update_entry_status(afw_cir_flash_t *flash, uint32_t offset,
                                    uint16_t status, flash_table_entry_t *entry)
 {
     int32_t ret;
 
     entry->status &= ~status;
-    ret = fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, offset, sizeof(flash_table_entry_t),
-                          (const uint8_t *)entry);
+    ret = flash_program(flash, offset, sizeof(flash_table_entry_t),
+                        (const uint8_t *)entry);
     if (ret < 0) {
         return -AFW_CIR_FLASH_EWRITE_FAIL;
     }
@@ -150,7 +179,7 @@ static int32_t update_entry_status(afw_cir_flash_t *flash, uint32_t offset,
 static int32_t erase_block(afw_cir_flash_t *flash, uint32_t offset,
                            uint32_t length)
 {
-    EventBits_t eraseEventsBits;
+    uint32_t block;
     int32_t ret;
 
     if (!is_block_aligned(offset)) {
@@ -158,7 +187,18 @@ static int32_t erase_block(afw_cir_flash_t *flash, uint32_t offset,
     }
 
     ret = fm_flash_erase_sectors(flash->part, FM_BYPASS_CLIENT_ID, offset, length);
-    return ret;
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (block = offset / FLASH_BLOCK_SIZE;
+         block < (offset + length) / FLASH_BLOCK_SIZE; block++) {
+        if (flash->erase_count[block] != BITS16_DEFAULT_VALUE) {
+            (flash->erase_count[block])++;
+        }
+    }
+
+    return AFW_OK;
 }
 
 static int32_t is_entry_erase_complete(afw_cir_flash_t *flash, uint32_t offset,
@@ -206,7 +246,7 @@ static int32_t erase_flash_table(afw_cir_flash_t *flash)
                                   STATUS_ERASE_START | STATUS_ERASE_COMPLETE,
                                   &entry);
         if (ret != AFW_OK) {
-            return return_unblock(flash, ret);
+            return ret;
         }
 
         flash->next_entry_erase_offset =
@@ -301,59 +341,156 @@ static int32_t find_incomplete_data_length(afw_cir_flash_t *flash,
 {
     uint8_t buf[LOCAL_BUF_SIZE];
     uint32_t buf_len;
+    uint32_t end_offset;
+    uint32_t wrap;
+    uint32_t read_offset;
     int32_t i;
     int32_t ret;
-    int32_t end_offset;
 
-    /* Atleast 4K bytes are available */
-    *length = 0;
+    /* Atleast 4K bytes are available, the data ends before the next block */
     end_offset = get_block_aligned_offset(offset);
     if (offset - end_offset) {
         end_offset = get_next_data_block_offset(flash, end_offset);
-        *length  += end_offset - offset;
     }
     end_offset = get_next_data_block_offset(flash, end_offset);
-    *length  += FLASH_BLOCK_SIZE;
 
-    end_offset -= LOCAL_BUF_SIZE;
-    *length  -= LOCAL_BUF_SIZE;
-    buf_len = LOCAL_BUF_SIZE;
-    do {
-        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, end_offset, buf_len, buf);
+    /* Search the last programmed byte backwards, in data length from offset */
+    *length = get_data_distance(flash, offset, end_offset);
+    wrap = flash->size - offset;
+    while (*length) {
+        buf_len = (*length > LOCAL_BUF_SIZE) ? LOCAL_BUF_SIZE : *length;
+        /* Don't read across the end of the flash */
+        if ((*length > wrap) && (*length - buf_len < wrap)) {
+            buf_len = *length - wrap;
+        }
+        *length -= buf_len;
+
+        read_offset = offset + *length;
+        if (read_offset >= flash->size) {
+            read_offset -= flash->size - AFW_CIR_FLASH_TABLE_SIZE;
+        }
+
+        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, read_offset, buf_len, buf);
         if (ret < 0) {
             return -AFW_CIR_FLASH_EREAD_FAIL;
         }
 
         for (i = buf_len - 1; i >= 0; i--) {
             if (buf[i] != 0xFF) {
-                *length += i;
+                *length += i + 1;
                 return AFW_OK;
             }
         }
+    }
+
+    /* No data was programmed */
+    return AFW_OK;
+}
+
+/*
+ * A cut while the batch was completed can leave some bits of the length
+ * programmed, 'cut_length'. Programming can't set them back: return the
+ * smallest length from 'length' on that keeps them, so the length in flash is
+ * the one the writer continues from. The gap up to it is not programmed.
+ */
+static uint32_t get_programmable_length(uint32_t length, uint32_t cut_length)
+{
+    uint32_t bits;
+    uint32_t high;
+
+    while ((bits = length & ~cut_length) != 0) {
+        /* Clear from the highest bit that can't be kept, carry above it */
+        high = bits;
+        while (high & (high - 1)) {
+            high &= high - 1;
+        }
+        length = (length | (high - 1)) + 1;
+        if (length == 0) {
+            return cut_length;
+        }
+    }
+
+    return length;
+}
 
-        if (*length == 0) {
+/*
+ * A power cut while a write batch is programmed can leave several entries
+ * write started, before the one at 'offset'. Abandon them, their data ends
+ * where the next entry starts.
+ */
+static int32_t abandon_write_batch(afw_cir_flash_t *flash, uint32_t offset,
+                                   uint32_t next_data_offset)
+{
+    flash_table_entry_t entry;
+    uint16_t status;
+    uint32_t i;
+    int32_t ret;
+
+    for (i = 1; i < AFW_CIR_FLASH_WRITE_BATCH; i++) {
+        offset = get_previous_entry_offset(offset);
+
+        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, offset, sizeof(flash_table_entry_t),
+                             (uint8_t *)&entry);
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EREAD_FAIL;
+        }
+
+        status = ~(entry.status);
+        if ((entry.status == BITS16_DEFAULT_VALUE)
+            || ((status & STATUS_ABANDONED) == STATUS_ABANDONED)
+            || ((status & STATUS_WRITE_COMPLETE) == STATUS_WRITE_COMPLETE)) {
             break;
         }
 
-        if (*length >= LOCAL_BUF_SIZE) {
-            end_offset -= LOCAL_BUF_SIZE;
-            if (end_offset < AFW_CIR_FLASH_TABLE_SIZE) {
-                end_offset = flash->size - LOCAL_BUF_SIZE;
-            }
-            *length  -= LOCAL_BUF_SIZE;
-            buf_len = LOCAL_BUF_SIZE;
-        } else {
-            end_offset -= *length;
-            if (end_offset < AFW_CIR_FLASH_TABLE_SIZE) {
-                end_offset = flash->size - *length;
-            }
-            buf_len = *length;
-            *length = 0;
+        entry.length = get_data_distance(flash, entry.offset, next_data_offset);
+        entry.status &= ~STATUS_ABANDONED;
+        ret = flash_program(flash, offset, sizeof(flash_table_entry_t),
+                            (const uint8_t *)&entry);
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EWRITE_FAIL;
         }
 
-    } while (1);
+        next_data_offset = entry.offset;
+    }
+
+    return AFW_OK;
+}
+
+/*
+ * The free entries are the rest of the write block and the erased blocks
+ * after it. The next blocks may still hold the oldest entries.
+ */
+static int32_t count_free_entries(afw_cir_flash_t *flash)
+{
+    flash_table_entry_t entry;
+    uint32_t write_block;
+    uint32_t offset;
+    int32_t ret;
+
+    write_block = get_block_aligned_offset(flash->next_entry_write_offset);
+    flash->num_free_entries = (write_block + FLASH_BLOCK_SIZE
+                               - flash->next_entry_write_offset)
+                              / sizeof(flash_table_entry_t);
+
+    for (offset = get_next_flash_table_block_offset(write_block);
+         offset != write_block;
+         offset = get_next_flash_table_block_offset(offset)) {
+
+        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, offset, sizeof(flash_table_entry_t),
+                             (uint8_t *)&entry);
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EREAD_FAIL;
+        }
 
-    return -AFW_EBUSY;
+        if (entry.status != BITS16_DEFAULT_VALUE) {
+            break;
+        }
+
+        flash->num_free_entries +=
+            (FLASH_BLOCK_SIZE / sizeof(flash_table_entry_t));
+    }
+
+    return AFW_OK;
 }
 
 static int32_t get_write_offset(afw_cir_flash_t *flash)
@@ -366,9 +503,6 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
     uint32_t end;
     uint32_t mid;
 
-    flash->num_free_entries =
-        (AFW_CIR_FLASH_TABLE_SIZE / sizeof(flash_table_entry_t));
-
     flash->next_data_write_offset = BITS32_DEFAULT_VALUE;
     flash->next_entry_write_offset = BITS32_DEFAULT_VALUE;
 
@@ -412,10 +546,7 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
         }
 
         /* If block full skip */
-        if (entry.status != BITS16_DEFAULT_VALUE) {
-            flash->num_free_entries -=
-                (FLASH_BLOCK_SIZE / sizeof(flash_table_entry_t));
-        } else {
+        if (entry.status == BITS16_DEFAULT_VALUE) {
             /* The newest write entry offset should be in this block */
 
             while (start <= end) {
@@ -445,16 +576,21 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
                 return -AFW_CIR_FLASH_ECORRUPT;
             }
 
-            flash->num_free_entries -=
-                ((flash->next_entry_write_offset - offset)
-                 / sizeof(flash_table_entry_t));
-
             break;
         }
 
         offset = get_next_flash_table_block_offset(offset);
     } while (offset != write_block);
 
+    if (flash->next_entry_write_offset == BITS32_DEFAULT_VALUE) {
+        return -AFW_CIR_FLASH_ECORRUPT;
+    }
+
+    ret = count_free_entries(flash);
+    if (ret != AFW_OK) {
+        return ret;
+    }
+
     /* Read previous offset to find data size */
     offset = get_previous_entry_offset(flash->next_entry_write_offset);
 
@@ -470,6 +606,8 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
     /* Mark entry as abandoned if it is in incomplete state */
     if (((status & STATUS_ABANDONED) != STATUS_ABANDONED)
         && ((status & STATUS_WRITE_COMPLETE) != STATUS_WRITE_COMPLETE)) {
+        uint32_t cut_length = entry.length;
+
         ret = find_incomplete_data_length(flash, entry.offset, &(entry.length));
         if (ret != AFW_OK) {
             if (ret == -AFW_CIR_FLASH_EREAD_FAIL) {
@@ -478,10 +616,11 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
                 return -AFW_CIR_FLASH_ECORRUPT;
             }
         }
+        entry.length = get_programmable_length(entry.length, cut_length);
 
         /* Write length */
-        ret = fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, offset, sizeof(flash_table_entry_t),
-                              (const uint8_t *)&entry);
+        ret = flash_program(flash, offset, sizeof(flash_table_entry_t),
+                            (const uint8_t *)&entry);
         if (ret < 0) {
             return -AFW_CIR_FLASH_EWRITE_FAIL;
         }
@@ -490,6 +629,11 @@ static int32_t get_write_offset(afw_cir_flash_t *flash)
         if (ret != AFW_OK) {
             return ret;
         }
+
+        ret = abandon_write_batch(flash, offset, entry.offset);
+        if (ret != AFW_OK) {
+            return ret;
+        }
     }
 
     flash->next_data_write_offset = entry.offset + entry.length;
@@ -591,9 +735,11 @@ static int32_t get_read_offset(afw_cir_flash_t *flash)
     } while (offset != read_block);
 
     // If we didn't find a READ_COMPLETE entry in any block and we didn't find an
-    // uninitialized block, then we're corrupt.
+    // uninitialized block, the table is full of unread entries and the oldest
+    // is at the start of the block after the write block.
     if (flash->next_entry_read_offset == BITS32_DEFAULT_VALUE) {
-        return -AFW_CIR_FLASH_ECORRUPT;
+        flash->next_entry_read_offset =
+            get_next_flash_table_block_offset(read_block);
     }
 
     ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_read_offset,
@@ -683,7 +829,7 @@ static int32_t get_erase_offset(afw_cir_flash_t *flash)
             status = ~(entry.status);
 
             if ((status & STATUS_ERASE_COMPLETE) == STATUS_ERASE_COMPLETE) {
-                flash->next_entry_erase_offset = mid + sizeof(flash_table_entry_t);
+                flash->next_entry_erase_offset = get_next_entry_offset(mid);
                 start = mid + sizeof(flash_table_entry_t);
             } else {
                 if (end == 0) {
@@ -702,6 +848,12 @@ static int32_t get_erase_offset(afw_cir_flash_t *flash)
         offset = get_previous_flash_table_block_offset(offset);
     } while (offset != erase_block);
 
+    /* No entry is erased, the oldest is at the start of the block after the write block */
+    if (flash->next_entry_erase_offset == BITS32_DEFAULT_VALUE) {
+        flash->next_entry_erase_offset =
+            get_next_flash_table_block_offset(erase_block);
+    }
+
     ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_erase_offset,
                          sizeof(flash_table_entry_t), (uint8_t *)&entry);
     if (ret < 0) {
@@ -750,6 +902,15 @@ int32_t get_next_read_entry(afw_cir_flash_t *flash, flash_table_entry_t *entry)
             flash->next_entry_read_offset =
                 get_next_entry_offset(flash->next_entry_read_offset);
 
+            /* Skip the abandoned data too */
+            flash->next_data_read_offset = entry->offset + entry->length;
+            if (flash->next_data_read_offset >= flash->size) {
+                flash->next_data_read_offset -= flash->size - AFW_CIR_FLASH_TABLE_SIZE;
+            }
+
+        } else if ((status & STATUS_READ_COMPLETE) == STATUS_READ_COMPLETE) {
+            /* Old entry of a table block not erased yet */
+            return -AFW_CIR_FLASH_ENO_BYTES;
         } else if (((status & STATUS_READ_START) == STATUS_READ_START)
                    || ((status & STATUS_WRITE_COMPLETE)
                        == STATUS_WRITE_COMPLETE)) {
@@ -824,6 +985,169 @@ int32_t cir_flash_read(afw_cir_flash_t *flash, uint32_t length,
     return AFW_OK;
 }
 
+static uint32_t get_avail_erase_size(afw_cir_flash_t *flash);
+
+static flash_table_entry_t *get_batch_entries(afw_cir_flash_t *flash)
+{
+    return (flash_table_entry_t *)flash->write_buf;
+}
+
+static uint8_t *get_batch_data(afw_cir_flash_t *flash)
+{
+    return flash->write_buf
+           + AFW_CIR_FLASH_WRITE_BATCH * sizeof(flash_table_entry_t);
+}
+
+static bool is_batch_open(afw_cir_flash_t *flash)
+{
+    uint16_t status;
+
+    if (flash->batch_entries == 0) {
+        return false;
+    }
+
+    status = ~(get_batch_entries(flash)[flash->batch_entries - 1].status);
+    return ((status & STATUS_WRITE_COMPLETE) != STATUS_WRITE_COMPLETE);
+}
+
+static bool is_batch_complete_pending(afw_cir_flash_t *flash)
+{
+    return (flash->batch_entries > (is_batch_open(flash) ? 1 : 0));
+}
+
+/*
+ * Bytes of data the batch can still take. The batch ends on a page boundary
+ * and before the data wraps, so it is programmed in one page aligned chunk.
+ */
+static uint32_t get_batch_data_space(afw_cir_flash_t *flash)
+{
+    uint32_t limit;
+
+    limit = AFW_CIR_FLASH_WRITE_BUF_SIZE
+            - (flash->batch_data_offset % FLASH_PAGE_SIZE);
+    if (limit > flash->size - flash->batch_data_offset) {
+        limit = flash->size - flash->batch_data_offset;
+    }
+
+    return limit - flash->write_buf_length;
+}
+
+/*
+ * Program the write batch: the entries write started, the data, then the
+ * entries with their length and status. An open entry stays in the batch.
+ */
+static int32_t flush_write_batch(afw_cir_flash_t *flash)
+{
+    flash_table_entry_t started[AFW_CIR_FLASH_WRITE_BATCH];
+    flash_table_entry_t *entries = get_batch_entries(flash);
+    uint32_t first = flash->batch_open_written ? 1 : 0;
+    uint32_t i;
+    int32_t ret;
+
+    if (flash->batch_entries == 0) {
+        return AFW_OK;
+    }
+
+    for (i = first; i < flash->batch_entries; i++) {
+        started[i] = entries[i];
+        started[i].length = BITS32_DEFAULT_VALUE;
+        started[i].status = (uint16_t)~STATUS_WRITE_START;
+    }
+
+    if (first < flash->batch_entries) {
+        ret = flash_program(flash, flash->batch_entry_offset
+                            + first * sizeof(flash_table_entry_t),
+                            (flash->batch_entries - first) * sizeof(flash_table_entry_t),
+                            (const uint8_t *)&started[first]);
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EWRITE_FAIL;
+        }
+    }
+
+    if (flash->write_buf_length) {
+        ret = flash_program(flash, flash->batch_data_offset,
+                            flash->write_buf_length, get_batch_data(flash));
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EWRITE_FAIL;
+        }
+    }
+
+    if (is_batch_complete_pending(flash)) {
+        ret = flash_program(flash, flash->batch_entry_offset,
+                            flash->batch_entries * sizeof(flash_table_entry_t),
+                            (const uint8_t *)entries);
+        if (ret < 0) {
+            return -AFW_CIR_FLASH_EWRITE_FAIL;
+        }
+    }
+
+    if (is_batch_open(flash)) {
+        entries[0] = entries[flash->batch_entries - 1];
+        flash->batch_entry_offset = flash->next_entry_write_offset;
+        flash->batch_entries = 1;
+        flash->batch_open_written = true;
+    } else {
+        flash->batch_entries = 0;
+        flash->batch_open_written = false;
+    }
+
+    flash->write_buf_length = 0;
+    flash->batch_data_offset = flash->next_data_write_offset;
+
+    return AFW_OK;
+}
+
+/* Start a new entry in the write batch */
+static int32_t open_batch_entry(afw_cir_flash_t *flash)
+{
+    flash_table_entry_t *entry;
+    int32_t ret;
+
+    /* The entries of a batch are contiguous in the flash table */
+    if ((flash->batch_entries == AFW_CIR_FLASH_WRITE_BATCH)
+        || (flash->batch_entries && flash->next_entry_write_offset == 0)) {
+        ret = flush_write_batch(flash);
+        if (ret != AFW_OK) {
+            return ret;
+        }
+    }
+
+    if (flash->batch_entries == 0) {
+        flash->batch_entry_offset = flash->next_entry_write_offset;
+        flash->batch_data_offset = flash->next_data_write_offset;
+    }
+
+    entry = &get_batch_entries(flash)[flash->batch_entries];
+
+    /* The table entry should be unused */
+    ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_write_offset,
+                         sizeof(flash_table_entry_t), (uint8_t *)entry);
+    if (ret < 0) {
+        return -AFW_CIR_FLASH_EREAD_FAIL;
+    }
+
+    if (entry->status != BITS16_DEFAULT_VALUE) {
+        return -AFW_CIR_FLASH_ENO_FREE_SPACE;
+    }
+
+    entry->id = flash->next_entry_id;
+    entry->offset = flash->next_data_write_offset;
+    entry->length = BITS32_DEFAULT_VALUE;
+    entry->status = (uint16_t)~STATUS_WRITE_START;
+    entry->reserved = 0;
+
+    (flash->batch_entries)++;
+    (flash->next_entry_id)++;
+    (flash->num_free_entries)--;
+    flash->data_write_length = 0;
+
+    return AFW_OK;
+}
+
+#if AFW_CIR_FLASH_ERASE_TASK
+static void erase_task(void *arg);
+#endif
+
 int32_t afw_cir_flash_init(char *name, afw_cir_flash_t *flash)
 {
     int32_t ret;
@@ -877,39 +1201,94 @@ int32_t afw_cir_flash_init(char *name, afw_cir_flash_t *flash)
         }
     }
 
+    flash->write_buf = malloc(AFW_CIR_FLASH_WRITE_BATCH * sizeof(flash_table_entry_t)
+                              + AFW_CIR_FLASH_WRITE_BUF_SIZE);
+    if (flash->write_buf == NULL) {
+        return -AFW_ENOMEM;
+    }
+
+    flash->erase_count = calloc(flash->size / FLASH_BLOCK_SIZE, sizeof(uint16_t));
+    if (flash->erase_count == NULL) {
+        ret = -AFW_ENOMEM;
+        goto free_write_buf;
+    }
+
     flash->mutex = xSemaphoreCreateMutex();
     if (flash->mutex == NULL) {
-        return -AFW_ENOMEM;
+        ret = -AFW_ENOMEM;
+        goto free_erase_count;
     }
 
     flash->erase_async_event = xEventGroupCreate();
     if (flash->erase_async_event == NULL) {
-        vSemaphoreDelete(flash->mutex);
-        return -AFW_ENOMEM;
+        ret = -AFW_ENOMEM;
+        goto delete_mutex;
+    }
+
+#if AFW_CIR_FLASH_ERASE_TASK
+    if (pdPASS != xTaskCreate(erase_task, "cir_erase",
+                              AFW_CIR_FLASH_ERASE_TASK_STACK_SIZE / sizeof(portSTACK_TYPE),
+                              (void *)flash,
+                              AFW_CIR_FLASH_ERASE_TASK_PRIORITY | portPRIVILEGE_BIT,
+                              &(flash->erase_task))) {
+        ret = -AFW_ENOMEM;
+        goto delete_event;
     }
 
+    /* Blocks may have been read before the reboot */
+    xEventGroupSetBits(flash->erase_async_event, EVENT_ERASE);
+#endif
+
     return AFW_OK;
+
+#if AFW_CIR_FLASH_ERASE_TASK
+delete_event:
+    vEventGroupDelete(flash->erase_async_event);
+#endif
+delete_mutex:
+    vSemaphoreDelete(flash->mutex);
+free_erase_count:
+    free(flash->erase_count);
+free_write_buf:
+    free(flash->write_buf);
+
+    return ret;
 }
 
 int32_t afw_cir_flash_deinit(afw_cir_flash_t *flash)
 {
+    int32_t ret = AFW_OK;
+
     if (NULL == flash) {
         return -AFW_EINVAL;
     }
 
+#if AFW_CIR_FLASH_ERASE_TASK
+    xEventGroupSetBits(flash->erase_async_event, EVENT_STOP);
+    xEventGroupWaitBits(flash->erase_async_event, EVENT_STOPPED, pdTRUE, pdTRUE,
+                        portMAX_DELAY);
+#endif
+
+    if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
+        ret = flush_write_batch(flash);
+        xSemaphoreGive(flash->mutex);
+    } else {
+        ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
+    }
+
     vSemaphoreDelete(flash->mutex);
     vEventGroupDelete(flash->erase_async_event);
+    free(flash->erase_count);
+    free(flash->write_buf);
     memset(flash, 0, sizeof(afw_cir_flash_t));
 
-    return AFW_OK;
+    return ret;
 }
 
 int32_t afw_cir_flash_write(afw_cir_flash_t *flash, uint32_t length,
                             const uint8_t *buf)
 {
     int32_t ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
-    flash_table_entry_t entry;
-    uint16_t status;
 
     if (NULL == flash || NULL == buf || 0 == length) {
         return -AFW_EINVAL;
@@ -926,63 +1305,37 @@ int32_t afw_cir_flash_write(afw_cir_flash_t *flash, uint32_t length,
             return return_unblock(flash, -AFW_CIR_FLASH_ENO_FREE_SPACE);
         }
 
-        /* Get the next entry from table */
-        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_write_offset,
-                             sizeof(flash_table_entry_t), (uint8_t *)&entry);
-        if (ret < 0) {
-            return return_unblock(flash, -AFW_CIR_FLASH_EREAD_FAIL);
-        }
-
-        /* Flipping the bits to check the set bits */
-        status = ~(entry.status);
-
-        /* Is it unused? */
-        if (entry.status == BITS16_DEFAULT_VALUE) {
-            /* Create an entry in the table */
-            entry.id = flash->next_entry_id;
-            entry.offset = flash->next_data_write_offset;
-            entry.length = BITS32_DEFAULT_VALUE;
-            entry.status = BITS16_DEFAULT_VALUE;
-            entry.reserved = 0;
-
-            ret = fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_write_offset,
-                                  sizeof(flash_table_entry_t),
-                                  (const uint8_t *)&entry);
-            if (ret < 0) {
-                return return_unblock(flash, -AFW_CIR_FLASH_EWRITE_FAIL);
-            }
-
-            ret = update_entry_status(flash, flash->next_entry_write_offset,
-                                      STATUS_WRITE_START, &entry);
+        /* Create an entry in the write batch */
+        if (!is_batch_open(flash)) {
+            ret = open_batch_entry(flash);
             if (ret != AFW_OK) {
                 return return_unblock(flash, ret);
             }
-
-            (flash->next_entry_id)++;
-            (flash->num_free_entries)--;
-            flash->data_write_length = 0;
-        } else if ((status & STATUS_WRITE_COMPLETE) == STATUS_WRITE_COMPLETE) {
-            return return_unblock(flash, -AFW_CIR_FLASH_ENO_FREE_SPACE);
         }
 
         uint32_t rem;
         uint32_t offset = 0;
         do {
-            rem = length;
-            /* Split data write if the flash address space needs wrapping */
-            if (rem > (flash->size - flash->next_data_write_offset)) {
-                rem = flash->size - flash->next_data_write_offset;
+            rem = get_batch_data_space(flash);
+            if (rem == 0) {
+                ret = flush_write_batch(flash);
+                if (ret != AFW_OK) {
+                    return return_unblock(flash, ret);
+                }
+                continue;
             }
-            length -= rem;
 
-            /* write data to flash */
-            ret = fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, flash->next_data_write_offset,
-                                  rem, buf + offset);
-            if (ret < 0) {
-                return return_unblock(flash, -AFW_CIR_FLASH_EWRITE_FAIL);
+            /* Split data write at the end of the batch */
+            if (rem > length) {
+                rem = length;
             }
+            length -= rem;
+
+            memcpy(get_batch_data(flash) + flash->write_buf_length,
+                   buf + offset, rem);
 
             offset += rem;
+            flash->write_buf_length += rem;
             flash->next_data_write_offset += rem;
             flash->data_write_length += rem;
 
@@ -1001,7 +1354,7 @@ int32_t afw_cir_flash_write(afw_cir_flash_t *flash, uint32_t length,
 
 int32_t afw_cir_flash_write_complete(afw_cir_flash_t *flash)
 {
-    flash_table_entry_t entry;
+    flash_table_entry_t *entry;
     int32_t ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
 
     if (NULL == flash) {
@@ -1009,37 +1362,34 @@ int32_t afw_cir_flash_write_complete(afw_cir_flash_t *flash)
     }
 
     if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
-        ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_write_offset,
-                             sizeof(flash_table_entry_t), (uint8_t *)&entry);
-        if (ret < 0) {
-            return return_unblock(flash, -AFW_CIR_FLASH_EREAD_FAIL);
-        }
-
-        uint16_t status = ~(entry.status);
-        if (status != STATUS_WRITE_START) {
+        if (!is_batch_open(flash)) {
             return return_unblock(flash, -AFW_CIR_FLASH_EWRONG_STATE);
         }
 
-        /* Update status to complete and length of the data */
-        entry.length = flash->data_write_length;
-
-        ret = fm_flash_write(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_write_offset,
-                              sizeof(flash_table_entry_t),
-                              (const uint8_t *)&entry);
-        if (ret < 0) {
-            return return_unblock(flash, -AFW_CIR_FLASH_EWRITE_FAIL);
+#if AFW_CIR_FLASH_DEFER_WRITE && AFW_CIR_FLASH_ERASE_TASK
+        /* Bound the time the first completed entry of the batch stays in RAM */
+        if (!is_batch_complete_pending(flash)) {
+            xEventGroupSetBits(flash->erase_async_event, EVENT_FLUSH);
         }
+#endif
 
-        ret = update_entry_status(flash, flash->next_entry_write_offset,
-                                  STATUS_WRITE_COMPLETE, &entry);
-        if (ret != AFW_OK) {
-            return return_unblock(flash, ret);
-        }
+        /* Update status to complete and length of the data, programmed with the batch */
+        entry = &get_batch_entries(flash)[flash->batch_entries - 1];
+        entry->length = flash->data_write_length;
+        entry->status &= ~STATUS_WRITE_COMPLETE;
 
         flash->data_write_length = 0;
         flash->next_entry_write_offset =
             get_next_entry_offset(flash->next_entry_write_offset);
 
+#if !AFW_CIR_FLASH_DEFER_WRITE
+        /* Nothing flushes the RAM on a reset or a crash, the entry is in flash on return */
+        ret = flush_write_batch(flash);
+        if (ret != AFW_OK) {
+            return return_unblock(flash, ret);
+        }
+#endif
+
         ret = 0;
         xSemaphoreGive(flash->mutex);
     }
@@ -1057,7 +1407,13 @@ int32_t afw_cir_flash_read(afw_cir_flash_t *flash, uint32_t length,
     }
 
     if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
-        ret = cir_flash_read(flash, length, buf, false);
+        ret = AFW_OK;
+        if (is_batch_complete_pending(flash)) {
+            ret = flush_write_batch(flash);
+        }
+        if (ret == AFW_OK) {
+            ret = cir_flash_read(flash, length, buf, false);
+        }
         xSemaphoreGive(flash->mutex);
     }
 
@@ -1074,7 +1430,13 @@ int32_t afw_cir_flash_peek(afw_cir_flash_t *flash, uint32_t length,
     }
 
     if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
-        ret = cir_flash_read(flash, length, buf, true);
+        ret = AFW_OK;
+        if (is_batch_complete_pending(flash)) {
+            ret = flush_write_batch(flash);
+        }
+        if (ret == AFW_OK) {
+            ret = cir_flash_read(flash, length, buf, true);
+        }
         xSemaphoreGive(flash->mutex);
     }
 
@@ -1112,6 +1474,12 @@ int32_t afw_cir_flash_read_complete(afw_cir_flash_t *flash)
         flash->next_entry_read_offset =
             get_next_entry_offset(flash->next_entry_read_offset);
 
+#if AFW_CIR_FLASH_ERASE_TASK
+        if (get_avail_erase_size(flash) >= FLASH_BLOCK_SIZE) {
+            xEventGroupSetBits(flash->erase_async_event, EVENT_ERASE);
+        }
+#endif
+
         ret = 0;
         xSemaphoreGive(flash->mutex);
     }
@@ -1119,51 +1487,143 @@ int32_t afw_cir_flash_read_complete(afw_cir_flash_t *flash)
     return ret;
 }
 
-int32_t afw_cir_flash_erase(afw_cir_flash_t *flash)
+/*
+ * Erase the next read block. Called with the mutex, which is given during
+ * the block erase so the writer and the reader are not stalled by it.
+ */
+static int32_t erase_next_block(afw_cir_flash_t *flash, bool *erased)
 {
-    int32_t ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
-    int32_t size;
+    int32_t ret;
+    uint32_t offset;
     flash_table_entry_t entry;
 
-    if (NULL == flash) {
-        return -AFW_EINVAL;
+    *erased = false;
+
+    if (flash->erase_busy
+        || get_avail_erase_size(flash) < FLASH_BLOCK_SIZE) {
+        return AFW_OK;
     }
 
-    if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
-        if (flash->next_data_read_offset >= flash->next_data_erase_offset) {
-            size = flash->next_data_read_offset - flash->next_data_erase_offset;
-        } else {
-            size = flash->size - flash->next_data_erase_offset;
-            size += flash->next_data_read_offset - AFW_CIR_FLASH_TABLE_SIZE;
+    ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_erase_offset,
+                         sizeof(flash_table_entry_t),
+                         (uint8_t *)&entry);
+    if (ret < 0) {
+        return -AFW_CIR_FLASH_EREAD_FAIL;
+    }
+
+    ret = update_entry_status(flash, flash->next_entry_erase_offset,
+                              STATUS_ERASE_START, &entry);
+    if (ret != AFW_OK) {
+        return ret;
+    }
+
+    /* The block is out of the free space until the erase pointer moves */
+    offset = flash->next_data_erase_offset;
+    flash->erase_busy = true;
+    xSemaphoreGive(flash->mutex);
+
+    ret = erase_block(flash, offset, FM_FLASH_ERASE_SIZE_4K);
+
+    xSemaphoreTake(flash->mutex, portMAX_DELAY);
+    flash->erase_busy = false;
+    if (ret < 0) {
+        return ret;
+    }
+
+    flash->next_data_erase_offset =
+        get_next_data_block_offset(flash, flash->next_data_erase_offset);
+    *erased = true;
+
+    return erase_flash_table(flash);
+}
+
+#if AFW_CIR_FLASH_ERASE_TASK
+static void erase_task(void *arg)
+{
+    afw_cir_flash_t *flash = (afw_cir_flash_t *)arg;
+    const TickType_t flush_delay = AFW_CIR_FLASH_FLUSH_DELAY_MS / portTICK_PERIOD_MS;
+    TickType_t flush_start = 0;
+    TickType_t wait;
+    bool flush_pending = false;
+    EventBits_t events;
+    bool erased;
+    int32_t ret;
+
+    do {
+        wait = portMAX_DELAY;
+        if (flush_pending) {
+            wait = xTaskGetTickCount() - flush_start;
+            wait = (wait < flush_delay) ? (flush_delay - wait) : 0;
         }
 
-        if (size >= FLASH_BLOCK_SIZE) {
-            ret = fm_flash_read(flash->part, FM_BYPASS_CLIENT_ID, flash->next_entry_erase_offset,
-                                 sizeof(flash_table_entry_t),
-                                 (uint8_t *)&entry);
-            if (ret < 0) {
-                return return_unblock(flash, -AFW_CIR_FLASH_EREAD_FAIL);
-            }
+        events = xEventGroupWaitBits(flash->erase_async_event,
+                                     EVENT_ERASE | EVENT_STOP | EVENT_FLUSH,
+                                     pdTRUE, pdFALSE, wait);
+        if (events & EVENT_STOP) {
+            break;
+        }
 
-            ret = update_entry_status(flash, flash->next_entry_erase_offset,
-                                      STATUS_ERASE_START, &entry);
-            if (ret != AFW_OK) {
-                return return_unblock(flash, ret);
+        /* Program the write batch flush_delay after its first entry is completed */
+        if ((events & EVENT_FLUSH) && !flush_pending) {
+            flush_pending = true;
+            flush_start = xTaskGetTickCount();
+        }
+        if (flush_pending && (xTaskGetTickCount() - flush_start >= flush_delay)) {
+            if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
+                flush_write_batch(flash);
+                xSemaphoreGive(flash->mutex);
             }
+            flush_pending = false;
+        }
 
-            ret = erase_block(flash, flash->next_data_erase_offset,
-                              FM_FLASH_ERASE_SIZE_4K);
-            if (ret < 0) {
-                return return_unblock(flash, ret);
+        if (!(events & EVENT_ERASE)) {
+            continue;
+        }
+
+        /* Erase all the read blocks, ahead of the writer */
+        do {
+            if (pdTRUE != xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
+                break;
             }
+            ret = erase_next_block(flash, &erased);
+            xSemaphoreGive(flash->mutex);
+        } while ((ret == AFW_OK) && erased
+                 && !(xEventGroupGetBits(flash->erase_async_event) & EVENT_STOP));
 
-            flash->next_data_erase_offset =
-                get_next_data_block_offset(flash,
-                                           flash->next_data_erase_offset);
-            ret = erase_flash_table(flash);
-        }
+    } while (1);
 
-        ret = AFW_OK;
+    xEventGroupSetBits(flash->erase_async_event, EVENT_STOPPED);
+    vTaskDelete(NULL);
+}
+#endif
+
+int32_t afw_cir_flash_erase(afw_cir_flash_t *flash)
+{
+    int32_t ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
+    bool erased;
+
+    if (NULL == flash) {
+        return -AFW_EINVAL;
+    }
+
+    if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
+        ret = erase_next_block(flash, &erased);
+        xSemaphoreGive(flash->mutex);
+    }
+
+    return ret;
+}
+
+int32_t afw_cir_flash_flush(afw_cir_flash_t *flash)
+{
+    int32_t ret = -AFW_CIR_FLASH_EACCESS_TIMEOUT;
+
+    if (NULL == flash) {
+        return -AFW_EINVAL;
+    }
+
+    if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
+        ret = flush_write_batch(flash);
         xSemaphoreGive(flash->mutex);
     }
 
@@ -1208,6 +1668,11 @@ int32_t afw_cir_flash_erase_partition(afw_cir_flash_t *flash)
 
         } while (size);
 
+        /* The write batch is lost with the data */
+        flash->batch_entries = 0;
+        flash->batch_open_written = false;
+        flash->write_buf_length = 0;
+
         ret = 0;
         xSemaphoreGive(flash->mutex);
     }
@@ -1226,7 +1691,13 @@ int32_t afw_cir_flash_get_read_data_length(afw_cir_flash_t *flash,
     }
 
     if (pdTRUE == xSemaphoreTake(flash->mutex, SEMAPHORE_TIMEOUT)) {
-        ret = get_next_read_entry(flash, &entry);
+        ret = AFW_OK;
+        if (is_batch_complete_pending(flash)) {
+            ret = flush_write_batch(flash);
+        }
+        if (ret == AFW_OK) {
+            ret = get_next_read_entry(flash, &entry);
+        }
         if (ret == AFW_OK) {
             *length = entry.length;
         }
@@ -1293,6 +1764,34 @@ static uint32_t get_avail_unread_entries(afw_cir_flash_t *flash)
     return num;
 }
 
+static void get_erase_counts(afw_cir_flash_t *flash,
+                             afw_cir_flash_info_t *info)
+{
+    uint32_t block;
+    uint16_t count;
+
+    info->table_erase_count = 0;
+    info->data_erase_count_min = BITS16_DEFAULT_VALUE;
+    info->data_erase_count_max = 0;
+
+    for (block = 0; block < flash->size / FLASH_BLOCK_SIZE; block++) {
+        count = flash->erase_count[block];
+        if (block < AFW_CIR_FLASH_TABLE_SIZE / FLASH_BLOCK_SIZE) {
+            if (count > info->table_erase_count) {
+                info->table_erase_count = count;
+            }
+            continue;
+        }
+
+        if (count < info->data_erase_count_min) {
+            info->data_erase_count_min = count;
+        }
+        if (count > info->data_erase_count_max) {
+            info->data_erase_count_max = count;
+        }
+    }
+}
+
 int32_t afw_cir_flash_get_info(afw_cir_flash_t *flash,
                                afw_cir_flash_info_t *info)
 {
@@ -1316,6 +1815,9 @@ int32_t afw_cir_flash_get_info(afw_cir_flash_t *flash,
         info->avail_unread_size = get_avail_unread_size(flash);
         info->avail_unread_entries = get_avail_unread_entries(flash);
 
+        info->programs = flash->programs;
+        get_erase_counts(flash, info);
+
         ret = 0;
         xSemaphoreGive(flash->mutex);
     }
@@ -29,6 +29,7 @@
 #include "asd_logger_internal_config.h"
 #include "asd_log_reader.h"
 #include "asd_log_msg.h"
+#include "asd_log_token.h"
 #include "asd_crashdump.h"
 #include "asd_log_platform_api.h"
 #include "log_request_queue.h"
@@ -49,8 +50,12 @@ asd_log_reader_t* log_reader_create(uint8_t log_id, uint32_t options)
     if (!reader) return NULL;
     memset(reader, 0, sizeof(asd_log_reader_t));
     reader->log_id = log_id;
-    reader->data_type = (options & LOG_DATA_TYPE_BIT_TXT)?
-                       ASD_LOG_DATA_TYPE_LOG_TXT : ASD_LOG_DATA_TYPE_BIN;
+    if (options & LOG_DATA_TYPE_BIT_TOKEN) {
+        reader->data_type = ASD_LOG_DATA_TYPE_LOG_TOKEN;
+    } else {
+        reader->data_type = (options & LOG_DATA_TYPE_BIT_TXT)?
+                           ASD_LOG_DATA_TYPE_LOG_TXT : ASD_LOG_DATA_TYPE_BIN;
+    }
     return reader;
 }
 
@@ -236,6 +241,22 @@ static int32_t log_reader_backend_read_crash_log(asd_log_reader_t* reader)
 
 }
 
+// report a log position resync in read log. Some log are missed, due to position resync.
+// The raw log has an empty line instead of the text.
+static uint32_t log_reader_put_resync(const asd_log_reader_t* reader, char* buf, uint32_t bufsize)
+{
+    uint32_t aLen;
+
+    if (ASD_LOG_DATA_TYPE_LOG_TOKEN == reader->data_type) {
+        aLen = MIN(bufsize, (uint32_t) ASD_LOG_RAW_LINE_LENGTH_SIZE);
+        memset(buf, 0, aLen);
+        return aLen;
+    }
+    strncpy(buf,  RESYNC_LOG_POS_MSG, bufsize);
+    aLen = strlen(RESYNC_LOG_POS_MSG);
+    return MIN(bufsize, aLen);
+}
+
 static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_t* flashmgr, asd_log_reader_t* reader)
 {
     int32_t rc = 0;
@@ -244,9 +265,10 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
 
     bool txt_log = (ASD_LOG_DATA_TYPE_LOG_TXT == asd_flash_mgr_get_buffer_data_type(
                          flashmgr, reader->log_id));
+    bool raw = (ASD_LOG_DATA_TYPE_LOG_TOKEN == reader->data_type);
     if (!reader->buf
         || !txt_log
-        || ASD_LOG_DATA_TYPE_LOG_TXT != reader->data_type
+        || (ASD_LOG_DATA_TYPE_LOG_TXT != reader->data_type && !raw)
         || !reader->frame_info.length
         || !flashbuf) {
         return ASD_LOGGER_ERROR_INVALID_PARAMETERS;
@@ -275,10 +297,7 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
                     break;
                 }
                 offset_in_frame = 0;
-                //report a log position resync in read log. Some log are missed, due to position resync.
-                strncpy(buf,  RESYNC_LOG_POS_MSG, bufsize);
-                uint32_t aLen = strlen(RESYNC_LOG_POS_MSG);
-                aLen = MIN(bufsize, aLen);
+                uint32_t aLen = log_reader_put_resync(reader, buf, bufsize);
                 //update output buffer:
                 log_len += aLen;
                 buf += aLen;
@@ -299,7 +318,9 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
             offset_in_frame = 0;
             assert(next_frame_info.length);
         }
-        if (bufsize < frame_info.length + ASD_LOG_LINE_HEADER_SIZE_DELTA + 2) {
+        // the raw line is prefixed with its length instead of the text line header.
+        uint32_t line_offset = raw ? ASD_LOG_RAW_LINE_LENGTH_SIZE : ASD_LOG_LINE_HEADER_SIZE_DELTA;
+        if (bufsize < frame_info.length + line_offset + 2) {
             //the rest buffer can not accomdate the whole log line. skip.
             if (log_len == 0) {
                 //the buffer is too small
@@ -314,8 +335,8 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
                   flashbuf,
                   &frame_info,
                   0,
-                  (uint8_t*) buf + ASD_LOG_LINE_HEADER_SIZE_DELTA,
-                  bufsize - ASD_LOG_LINE_HEADER_SIZE_DELTA);
+                  (uint8_t*) buf + line_offset,
+                  bufsize - line_offset);
         if (ASD_FLASH_BUFFER_EBAD_POSITION == rc) {
             //the frame start_pos is out of range. update it to the latest first frame in log buffer.
             rc = asd_flash_buffer_get_first_frame_info(flashbuf, &frame_info);
@@ -324,10 +345,7 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
                 break;
             }
             offset_in_frame = 0;
-            //report a log position resync in read log. Some log are missed, due to position resync.
-            strncpy(buf,  RESYNC_LOG_POS_MSG, bufsize);
-            uint32_t aLen = strlen(RESYNC_LOG_POS_MSG);
-            aLen = MIN(bufsize, aLen);
+            uint32_t aLen = log_reader_put_resync(reader, buf, bufsize);
             //update output buffer:
             log_len += aLen;
             buf += aLen;
@@ -344,7 +362,42 @@ static int32_t log_reader_backend_read_log_lines_from_flash(const asd_flash_mgr_
         //only support one full line per read. The frame length must be the read length.
         assert(rc == frame_info.length);
 
-        uint32_t length = rc + ASD_LOG_LINE_HEADER_SIZE_DELTA;
+        uint32_t length = rc + line_offset;
+
+        if (raw) {
+            buf[0] = (uint8_t) rc;
+            buf[1] = (uint8_t) (rc >> 8);
+            //update output buffer:
+            log_len += length;
+            buf += length;
+            bufsize -= length;
+            //update offset for frame.
+            offset_in_frame = frame_info.length;
+            continue;
+        }
+
+#if ASD_LOG_TOKENIZED
+        const asd_log_line_header_t* line = (const asd_log_line_header_t*) (buf + ASD_LOG_LINE_HEADER_SIZE_DELTA);
+        if (line->tokenized) {
+            // decode the body to text, after the line header.
+            char txt[ASD_LOG_LINE_MAXSIZE];
+            rc = asd_log_token_decode(line->data, rc - ASD_LOG_LINE_HEADER_BIN_SIZE, txt, sizeof(txt));
+            if (rc < 0) {
+                //corrupted line, keep the header only.
+                rc = 0;
+            }
+            if (ASD_LOG_LINE_HEADER_TXT_SIZE + rc + 2 > bufsize) {
+                if (log_len) {
+                    //read the line again in the next buffer.
+                    rc = 0;
+                    break;
+                }
+                rc = bufsize - ASD_LOG_LINE_HEADER_TXT_SIZE - 2;
+            }
+            memcpy(buf + ASD_LOG_LINE_HEADER_TXT_SIZE, txt, rc);
+            length = ASD_LOG_LINE_HEADER_TXT_SIZE + rc;
+        }
+#endif
 
         //Add "\r\n" for line ending.
         if (bufsize > length) {
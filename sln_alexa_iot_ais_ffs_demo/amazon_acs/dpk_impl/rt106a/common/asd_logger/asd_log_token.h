@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 Amazon.com, Inc. or its affiliates. All rights reserved.
+ *
+ * AMAZON PROPRIETARY/CONFIDENTIAL
+ *
+ * You may not use this file except in compliance with the terms and
+ * conditions set forth in the accompanying LICENSE.TXT file. This file is a
+ * Modifiable File, as defined in the accompanying LICENSE.TXT file.
+ *
+ * THESE MATERIALS ARE PROVIDED ON AN "AS IS" BASIS. AMAZON SPECIFICALLY
+ * DISCLAIMS, WITH RESPECT TO THESE MATERIALS, ALL WARRANTIES, EXPRESS,
+ * IMPLIED, OR STATUTORY, INCLUDING THE IMPLIED WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, AND NON-INFRINGEMENT.
+ */
+/*******************************************************************************
+* The header for tokenized log lines. Enabled by ASD_LOG_TOKENIZED.
+*
+* The body of a tokenized line (asd_log_line_header_t.tokenized set) is:
+*   varint   token, offset of the format string in the asd_log_fmt section.
+*   string   tag, empty if none.
+*   string   function name, empty if none. Followed by varint line number if not empty.
+*   args     one per conversion of the format string, in order:
+*            - '*' width or precision, d, i, c: zigzag varint.
+*            - u, o, x, X, p: varint.
+*            - f, e, g, a: 8 bytes little endian double.
+*            - s: string.
+* A varint is 7 bits per byte, least significant group first, bit 7 set when more
+* bytes follow. A string is a varint length followed by the characters, no NUL.
+*
+*@File: asd_log_token.h
+********************************************************************************
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "asd_log_api.h"
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if ASD_LOG_TOKENIZED
+
+/**
+ * @brief check if the format string is in the asd_log_fmt section, and can be tokenized.
+ * @param [in] fmt: format string.
+ *
+ * @return true if the format string has a token.
+ */
+bool asd_log_token_is_fmt(const char* fmt);
+
+/**
+ * @brief encode a tokenized log line body.
+ * @param [out] buf: output buffer of the line body.
+ * @param [in] size: buffer size.
+ * @param [in] options: options of the log line, for the tag and function name.
+ * @param [in] fmt: format string, must be in the asd_log_fmt section.
+ * @param [in] vargs: format arguments. They are consumed even on error, pass a copy
+ *                    if the line is printed in text on failure.
+ *
+ * @return length of the line body, or negative for error:
+ *         ASD_LOGGER_ERROR_INVALID_PARAMETERS: the format string has no token, or a
+ *         conversion that can not be encoded (%n, %Lf).
+ *         ASD_LOGGER_ERROR_LINE_LENGTH_LIMIT: the line doesn't fit in the buffer.
+ */
+int32_t asd_log_token_encode(uint8_t* buf, uint32_t size, const asd_log_options_t* options,
+                             const char* fmt, va_list vargs);
+
+/**
+ * @brief decode a tokenized log line body to text, as printed by the text logger.
+ *        The text is truncated and NUL terminated if it doesn't fit in the buffer.
+ * @param [in] body: line body.
+ * @param [in] length: line body length.
+ * @param [out] txt: output text buffer.
+ * @param [in] size: text buffer size.
+ *
+ * @return length of the text, or negative for error.
+ */
+int32_t asd_log_token_decode(const uint8_t* body, uint32_t length, char* txt, uint32_t size);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -34,6 +34,7 @@
 #include "asd_logger_impl.h"
 #include "log_buffer.h"
 #include "asd_log_msg.h"
+#include "asd_log_token.h"
 #include "asd_log_reader.h"
 #include "asd_log_eraser.h"
 #include "asd_crashdump.h"
@@ -91,6 +92,7 @@ static void asd_logger_cleanup(asd_logger_if_t* handle);
 static int32_t log_request_handler(asd_logger_t* logger, asd_log_request_t* req);
 static void asd_logger_construct_log_line_header(
                 asd_log_msg_t* logmsg, const asd_log_options_t* options );
+static asd_logger_rc_t asd_logger_frontend_push_line(asd_logger_t* logger, const asd_log_msg_t* logmsg);
 
 
 
@@ -331,7 +333,7 @@ asd_logger_rc_t asd_logger_vprint_console(const asd_log_options_t* opts,
         uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle()),
         opts->pc,
         opts->tag);
-    if (opts->func_name) {
+    if (opts->func_name && opts->func_name[0]) {
         //print the function name and line number, if available.
         printf("%.*s:%d:", ASD_LOGGER_FUNC_NAME_LENGTH_MAX,
                                     opts->func_name, opts->line_no);
@@ -674,6 +676,22 @@ static asd_logger_rc_t asd_logger_frontend_vprint(
     asd_log_line_header_t *line = (asd_log_line_header_t *) logmsg->data;
     asd_logger_construct_log_line_header(logmsg, options);
 
+#if ASD_LOG_TOKENIZED
+    if (asd_log_token_is_fmt(fmt)) {
+        //encode a copy of the args, the line is printed in text if the encoding fails.
+        va_list args;
+        va_copy(args, vargs);
+        int32_t body_length = asd_log_token_encode(line->data, ASD_LOG_LINE_MAXSIZE, options, fmt, args);
+        va_end(args);
+        if (body_length >= 0) {
+            logmsg->type = ASD_LOG_DATA_TYPE_LOG_TOKEN;
+            line->tokenized = 1;
+            logmsg->length = sizeof(asd_log_msg_t) + sizeof(asd_log_line_header_t) + body_length;
+            return asd_logger_frontend_push_line(logger, logmsg);
+        }
+    }
+#endif
+
     //sprintf line:
     int bytes_per_print = 0;
     int size = ASD_LOG_LINE_MAXSIZE;
@@ -688,7 +706,7 @@ static asd_logger_rc_t asd_logger_frontend_vprint(
     size -= bytes_per_print;
     pline += bytes_per_print;
 
-    if (options->func_name) {
+    if (options->func_name && options->func_name[0]) {
         //print the function name and line number, if available.
         bytes_per_print = snprintf(pline, size,
                                                 "%.*s:%d:", ASD_LOGGER_FUNC_NAME_LENGTH_MAX,
@@ -710,9 +728,14 @@ static asd_logger_rc_t asd_logger_frontend_vprint(
     pline += bytes_per_print;
     logmsg->length = sizeof(data) - size;
 
-    //Push log msg to main stream/log buffer.
+    return asd_logger_frontend_push_line(logger, logmsg);
+}
+
+//Push log msg to main stream/log buffer.
+static asd_logger_rc_t asd_logger_frontend_push_line(asd_logger_t* logger, const asd_log_msg_t* logmsg)
+{
     if (afw_stream_write(logger->istream[ASD_LOG_INPUT_STREAM_MAIN],
-                         data, logmsg->length) < 0) {
+                         (const uint8_t*) logmsg, logmsg->length) < 0) {
         //error to push in buffer. count the dropped lines.
         __atomic_add_fetch(&logger->log_drops, 1, __ATOMIC_SEQ_CST);
         __atomic_add_fetch(&logger->total_log_drops, 1, __ATOMIC_SEQ_CST);
@@ -893,11 +916,25 @@ static asd_logger_rc_t asd_logger_init_interface(asd_logger_if_t* handle)
 static asd_logger_rc_t asd_logger_backend_console_print_oneline(const asd_log_msg_t *log_msg)
 {
     if(!log_msg) return ASD_LOGGER_ERROR_INVALID_PARAMETERS;
-    assert(log_msg->type == ASD_LOG_DATA_TYPE_LOG_TXT);
+    assert(log_msg->type == ASD_LOG_DATA_TYPE_LOG_TXT || log_msg->type == ASD_LOG_DATA_TYPE_LOG_TOKEN);
     char header[ASD_LOG_LINE_HEADER_TXT_SIZE+1]={0};
     const asd_log_line_header_t* line = (const asd_log_line_header_t*) log_msg->data;
     asd_logger_decode_line_header(line, header, ASD_LOG_LINE_HEADER_TXT_SIZE + 1);
 
+#if ASD_LOG_TOKENIZED
+    if (line->tokenized) {
+        char txt[ASD_LOG_LINE_MAXSIZE];
+        int32_t len = asd_log_token_decode(line->data, GET_LOG_LINE_BODY_LENGTH(log_msg), txt, sizeof(txt));
+        if (len < 0) return len;
+        printf("%.*s%.*s"ASD_LINE_ENDING,
+            ASD_LOG_LINE_HEADER_TXT_SIZE,
+            header,
+            (int)len,
+            txt);
+        return ASD_LOGGER_OK;
+    }
+#endif
+
     printf("%.*s%.*s"ASD_LINE_ENDING,
         ASD_LOG_LINE_HEADER_TXT_SIZE,
         header,
@@ -921,6 +958,42 @@ static uint32_t count_decoded_text_length(uint32_t bin_length, uint32_t line_num
     return bin_length + line_num*(ASD_LOG_LINE_HEADER_SIZE_DELTA + sizeof(ASD_LINE_ENDING)-1);
 }
 
+#if ASD_LOG_TOKENIZED
+// Text length of the lines from frame_info on, as the reader prints them. The text of
+// a tokenized line doesn't follow from its body length, so each line is read and
+// tokenized ones are decoded.
+static int32_t count_text_log_length(asd_logger_t* logger, asd_flash_buffer_t* flashbuf,
+                                     asd_frame_info_t frame_info, bool skip_first)
+{
+    const asd_log_line_header_t* line = (const asd_log_line_header_t*) logger->scratch_pad;
+    asd_frame_info_t next_frame_info;
+    char txt[ASD_LOG_LINE_MAXSIZE];
+    int32_t length = 0;
+    int32_t rc = 0;
+
+    if (skip_first) {
+        rc = asd_flash_buffer_get_next_frame_info(flashbuf, &frame_info, &next_frame_info);
+        frame_info = next_frame_info;
+    }
+    while (rc == 0) {
+        rc = asd_flash_buffer_read_payload(flashbuf, &frame_info, 0,
+                                           logger->scratch_pad, sizeof(logger->scratch_pad));
+        if (rc < 0) return rc;
+        if ((uint32_t) rc >= ASD_LOG_LINE_HEADER_BIN_SIZE && line->tokenized) {
+            int32_t len = asd_log_token_decode(line->data, rc - ASD_LOG_LINE_HEADER_BIN_SIZE,
+                                               txt, sizeof(txt));
+            //a corrupted line is read as its header only.
+            length += ASD_LOG_LINE_HEADER_TXT_SIZE + MAX(len, 0) + sizeof(ASD_LINE_ENDING) - 1;
+        } else {
+            length += count_decoded_text_length(rc, 1);
+        }
+        rc = asd_flash_buffer_get_next_frame_info(flashbuf, &frame_info, &next_frame_info);
+        frame_info = next_frame_info;
+    }
+    return (ASD_FLASH_BUFFER_ENO_BYTES == rc) ? length : rc;
+}
+#endif
+
 static int32_t compute_remaining_log_length(asd_logger_t* logger, asd_log_reader_t* reader)
 {
     int32_t rc = 0;
@@ -948,7 +1021,17 @@ static int32_t compute_remaining_log_length(asd_logger_t* logger, asd_log_reader
                 //the current frame header is not included.
                 frame_num--;
             }
-            rc = count_decoded_text_length(data_length, frame_num);
+            if (ASD_LOG_DATA_TYPE_LOG_TOKEN == reader->data_type) {
+                rc = data_length + frame_num * ASD_LOG_RAW_LINE_LENGTH_SIZE;
+            } else {
+#if ASD_LOG_TOKENIZED
+                rc = frame_num ? count_text_log_length(logger,
+                                     asd_logger_get_flash_buffer(logger, reader->log_id),
+                                     reader->frame_info, reader->offset_in_frame != 0) : 0;
+#else
+                rc = count_decoded_text_length(data_length, frame_num);
+#endif
+            }
             break;
         }
     }
@@ -1102,7 +1185,7 @@ static int32_t log_request_handler(asd_logger_t* logger, asd_log_request_t* req)
 
     case LOG_REQUEST_MARK_READ_FLAG:
         if (req->log_id == ASD_LOG_ID_CRASH_LOG) {
-            rc = asd_crashdump_erase();
+            rc = asd_crashdump_mark_read();
         } else {
             if (LOG_REQUEST_STATUS_CANCELING == asd_log_request_hold_resource(req)) {
                 //skip process and free the request. no response back.
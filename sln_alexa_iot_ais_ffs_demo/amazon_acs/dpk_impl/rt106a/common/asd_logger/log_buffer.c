@@ -31,16 +31,21 @@
 // Support single consumer + single producer
 // Or  single consumer + multiple producers.
 // Support ISR.
+// Multiple producers reserve and commit records in a lock-free ring, one record per message.
 typedef struct {
     afw_stream_t stream;
     afw_cir_buf_t *cir_buf;
+    afw_mpsc_ring_t *ring;
 }asd_log_buffer_t;
 
 static int32_t single_producer_write(afw_stream_t *logbuf_stream, const uint8_t * data, uint32_t data_len);
 static int32_t multi_producers_write(afw_stream_t *logbuf_stream, const uint8_t * data, uint32_t data_len);
 static int32_t single_consumer_read_one_message(afw_stream_t *logbuf_stream, uint8_t * buf, uint32_t buf_len);
+static int32_t single_consumer_read_ring(afw_stream_t *logbuf_stream, uint8_t * buf, uint32_t buf_len);
 static int32_t get_bytes_available(afw_stream_t *logbuf_stream);
+static int32_t get_bytes_available_ring(afw_stream_t *logbuf_stream);
 static int32_t deinit(afw_stream_t *logbuf_stream);
+static int32_t deinit_ring(afw_stream_t *logbuf_stream);
 
 
 static afw_stream_table_t log_buffer_stream_table_single_producer = {
@@ -53,10 +58,10 @@ static afw_stream_table_t log_buffer_stream_table_single_producer = {
 
 static afw_stream_table_t log_buffer_stream_table_multi_producers = {
     &multi_producers_write,
-    &single_consumer_read_one_message,
-    &get_bytes_available,
+    &single_consumer_read_ring,
+    &get_bytes_available_ring,
     NULL,
-    &deinit
+    &deinit_ring
 };
 
 // ============================ static functions ===============================
@@ -83,8 +88,9 @@ static int32_t single_producer_write(afw_stream_t *logbuf_stream, const uint8_t
 }
 
 /**
- * @brief stream write for multiple producers, use critical section to support calling
- *        from ISR. It writes the whole data or nothing.
+ * @brief stream write for multiple producers, lock-free reserve and commit in the ring
+ *        so that it can be called from ISR. It writes the whole data or nothing, a task
+ *        waits for free space up to ASD_LOGGER_ENQUEUE_TIMEOUT_MS, an ISR never waits.
  * @param [in] logbuf_stream: stream pointer, e.g. log buffer pointer
  * @param [in] data: data pointer for write.
  * @param [in] data_len: data length
@@ -94,12 +100,14 @@ static int32_t single_producer_write(afw_stream_t *logbuf_stream, const uint8_t
 static int32_t multi_producers_write(afw_stream_t *logbuf_stream, const uint8_t * data, uint32_t data_len)
 {
     asd_log_buffer_t *logbuf = (asd_log_buffer_t*) logbuf_stream;
-    if (!logbuf || !logbuf->cir_buf) return -AFW_EINVAL;
-
-    int32_t ret = afw_cir_buf_write_block(logbuf->cir_buf, data, data_len, pdMS_TO_TICKS(ASD_LOGGER_ENQUEUE_TIMEOUT_MS));
+    if (!logbuf || !logbuf->ring) return -AFW_EINVAL;
 
-
-    return ret;
+    int32_t rc = afw_mpsc_ring_write_block(logbuf->ring, data, data_len, pdMS_TO_TICKS(ASD_LOGGER_ENQUEUE_TIMEOUT_MS));
+    if (rc < 0) {
+        return rc;
+    } else {
+        return data_len;
+    }
 }
 
 /**
@@ -136,6 +144,23 @@ static int32_t single_consumer_read_one_message(afw_stream_t *logbuf_stream, uin
     return msg_header.length;
 }
 
+/**
+ * @brief stream read for single consumer of the multi producers ring. Each committed
+ *        record holds one whole message.
+ * @param [in] logbuf_stream: stream pointer, e.g. log buffer pointer
+ * @param [out] buf: data pointer for read.
+ * @param [in] buf_len: data length
+ *
+ * @return data length read, or negative for failure(afw_error).
+ */
+static int32_t single_consumer_read_ring(afw_stream_t *logbuf_stream, uint8_t * buf, uint32_t buf_len)
+{
+    asd_log_buffer_t *logbuf = (asd_log_buffer_t*) logbuf_stream;
+    if (!logbuf || !logbuf->ring) return -AFW_EINVAL;
+    // -AFW_EIO while the oldest message is not committed yet.
+    return afw_mpsc_ring_read(logbuf->ring, buf, buf_len);
+}
+
 static int32_t get_bytes_available(afw_stream_t *logbuf_stream)
 {
     asd_log_buffer_t *logbuf = (asd_log_buffer_t*) logbuf_stream;
@@ -153,25 +178,51 @@ static int32_t deinit(afw_stream_t *logbuf_stream)
     return 0;
 }
 
+static int32_t get_bytes_available_ring(afw_stream_t *logbuf_stream)
+{
+    asd_log_buffer_t *logbuf = (asd_log_buffer_t*) logbuf_stream;
+    if (!logbuf || !logbuf->ring) return -AFW_EINVAL;
+    return afw_mpsc_ring_get_data_size(logbuf->ring);
+}
+
+static int32_t deinit_ring(afw_stream_t *logbuf_stream)
+{
+    asd_log_buffer_t *logbuf = (asd_log_buffer_t*) logbuf_stream;
+    if (!logbuf || !logbuf->ring) return -AFW_EINVAL;
+    afw_mpsc_ring_deinit(&logbuf->ring);
+    free(logbuf);
+    return 0;
+}
+
 
 // ======================= API functions ================================
 
 log_buffer_handle_t log_buffer_create(int buffer_size, uint32_t option)
 {
     if (!buffer_size) return NULL;
-    asd_log_buffer_t *logbuf = malloc(sizeof(asd_log_buffer_t));
+    asd_log_buffer_t *logbuf = calloc(1, sizeof(asd_log_buffer_t));
     if (!logbuf) {
         LOGGER_DPRINTF("logbuf malloc failure.");
         return NULL;
     }
 
-    logbuf->stream.table = (option & MULTI_PRODUCERS_BIT)?
-        &log_buffer_stream_table_multi_producers : &log_buffer_stream_table_single_producer;
-    logbuf->cir_buf = afw_cir_buf_init(buffer_size);
-    if (!logbuf->cir_buf) {
-        free(logbuf);
-        LOGGER_DPRINTF("cir_buf malloc failure.");
-        return NULL;
+    if (option & MULTI_PRODUCERS_BIT) {
+        logbuf->stream.table = &log_buffer_stream_table_multi_producers;
+        // buffer_size must pass AFW_MPSC_RING_SIZE_VALID.
+        logbuf->ring = afw_mpsc_ring_init(buffer_size);
+        if (!logbuf->ring) {
+            free(logbuf);
+            LOGGER_DPRINTF("ring malloc failure.");
+            return NULL;
+        }
+    } else {
+        logbuf->stream.table = &log_buffer_stream_table_single_producer;
+        logbuf->cir_buf = afw_cir_buf_init(buffer_size);
+        if (!logbuf->cir_buf) {
+            free(logbuf);
+            LOGGER_DPRINTF("cir_buf malloc failure.");
+            return NULL;
+        }
     }
     return (log_buffer_handle_t) logbuf;
 }
@@ -181,7 +232,7 @@ int32_t log_buffer_read(log_buffer_handle_t logbuf,
                      size_t buffer_len)
 {
     asd_log_buffer_t *log_buf = (asd_log_buffer_t*) logbuf;
-    if (!log_buf || !log_buf->cir_buf) return -AFW_EINVAL;
+    if (!log_buf) return -AFW_EINVAL;
     return afw_stream_read(&log_buf->stream, buffer, buffer_len);
 }
 
@@ -190,14 +241,14 @@ int32_t log_buffer_write(log_buffer_handle_t logbuf,
                      size_t data_len)
 {
     asd_log_buffer_t *log_buf = (asd_log_buffer_t*) logbuf;
-    if (!log_buf || !log_buf->cir_buf) return -AFW_EINVAL;
+    if (!log_buf) return -AFW_EINVAL;
     return afw_stream_write(&log_buf->stream, data, data_len);
 }
 
 int32_t log_buffer_get_free_size(log_buffer_handle_t logbuf)
 {
     asd_log_buffer_t *log_buf = (asd_log_buffer_t*) logbuf;
-    if (!log_buf || !log_buf->cir_buf) return -AFW_EINVAL;
+    if (!log_buf) return -AFW_EINVAL;
     return afw_stream_get_bytes_available(&log_buf->stream);
 }
 
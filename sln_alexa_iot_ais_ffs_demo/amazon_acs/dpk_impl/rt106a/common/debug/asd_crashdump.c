@@ -45,6 +45,20 @@
                                                 (idx == n -1))
 #define NOT_IN_EXCLUSIVE_RANGE(x, lower, upper)  ((x) <= (lower) || (x) >= (upper))
 
+#define CD_SLOT_BASE(slot)                   ((uint32_t)(slot) * ASD_CD_SLOT_SIZE)
+#define CD_DATA_ROUND_UP(len)                (((len) + 3U) & ~3U)
+#define CD_HEX_BYTES_PER_LINE                (32)
+
+// LZ4 block format: a match starts 12 bytes or more before the end of input
+// and is followed by 5 literals or more.
+#define CD_LZ_HASH_BITS                      (9)
+#define CD_LZ_MIN_MATCH                      (4)
+#define CD_LZ_MF_LIMIT                       (12)
+#define CD_LZ_LAST_LITERALS                  (5)
+#define CD_LZ_MAX_OFFSET                     (0xFFFF)
+// input that can't overflow 'space' bytes of output, even if not compressible.
+#define CD_LZ_INPUT_MAX(space)               ((space) > 16 ? (((space) - 16) / 256) * 255 : 0)
+
 #define CD_SCRATCH_PAD_LENGTH (256)
 #define VALIDATE_PRINT_IN_SCRATCH_PAD(print_bytes)                       \
     if (NOT_IN_EXCLUSIVE_RANGE(print_bytes, 0, CD_SCRATCH_PAD_LENGTH)) { \
@@ -79,11 +93,28 @@ enum {
 typedef struct {
     struct fm_flash_partition* partition; ///< log partition.
     uint8_t status;                       ///< status bits
+    int8_t read_slot;                     ///< slot of the oldest record, -1 for none.
+    int8_t write_slot;                    ///< erased slot for the next record, -1 if not prepared.
+    uint32_t sequence;                    ///< sequence of the next record.
     uint32_t total_frame_length;              ///< cached length of all frames in text format.
     asd_crashdump_mini_t mini_dump;       ///< cached mini_dump in binary.
+    asd_crashdump_context_t context;      ///< cached context, with mini_dump.
+    uint32_t log_slot_base;               ///< slot the crash log is written to.
+    uint32_t log_offset;                  ///< offset of the crash log in the slot.
     uint32_t log_len;                     ///< crash log length; log is not crc protected.
+    const uint8_t* ram_addr;              ///< RAM window captured with the stack.
+    uint32_t ram_len;
 } asd_crashdump_config_t;
 
+// Packed output, staged in the scratch pad and written to flash as it fills.
+typedef struct {
+    uint32_t offset;                      ///< flash offset of the next write.
+    uint32_t length;                      ///< bytes written to flash.
+    uint32_t fill;                        ///< bytes staged.
+    uint16_t crc;                         ///< crc16 of the bytes written.
+    int32_t rc;                           ///< first write error.
+} cd_lz_out_t;
+
 const char* asd_crash_dump_reason_txt_list[] = {
     #define TABLE_ENTRY(a, b, c)  c
     ASD_CRASH_DUMP_TABLE
@@ -126,8 +157,13 @@ const char* cpu_regs_name[] = {
 
 asd_log_create_module(crashdump, ASD_LOG_LEVEL_DEFAULT, ASD_LOG_PLATFORM_STREAM_BM_DEFAULT);
 
-static asd_crashdump_config_t cd_config = {0};
+static asd_crashdump_config_t cd_config = {
+    .read_slot = -1,
+    .write_slot = -1,
+};
 char g_scratchpad[CD_SCRATCH_PAD_LENGTH];
+// positions + 1 of the last 4 byte sequences seen by the compressor.
+static uint16_t cd_lz_hash[1 << CD_LZ_HASH_BITS];
 static app_version_info_callback* g_version_info_cb = NULL;
 
 static int32_t cd_flash_read(asd_crashdump_config_t* cd, uint32_t offset, uint32_t size, void* buf)
@@ -199,27 +235,238 @@ static const char *crash_report_marketplace_id(void)
 
 static bool flash_data_is_all_FF(asd_crashdump_config_t *cd, uint32_t offset, uint32_t size)
 {
-    uint32_t dw = 0xFFFFFFFF;
+    uint32_t dw[8];
     for(uint32_t i = 0; i < size; i += sizeof(dw)) {
         int32_t len;
         len = (size-i > sizeof(dw))? sizeof(dw) : (size-i);
-        if (cd_flash_read(cd, offset + i, len, &dw) != len
-            || dw != 0xFFFFFFFF) {
+        if (cd_flash_read(cd, offset + i, len, dw) != len) {
             return false;
         }
+        for (int j = 0; j < (len + 3) / 4; j++) {
+            if (dw[j] != 0xFFFFFFFF) return false;
+        }
     }
     return true;
 }
 
-static int32_t asd_crashdump_check_and_erase(void)
+/**
+ * @brief check the header and crc of a slot.
+ *
+ * @param [out] context: context of the record, if valid.
+ * @return true if the slot holds a complete record.
+ */
+static bool cd_slot_is_valid(asd_crashdump_config_t *cd, int slot, asd_crashdump_context_t *context)
+{
+    asd_crashdump_header_t header;
+    uint32_t base = CD_SLOT_BASE(slot);
+    uint16_t checksum = 0;
+    uint8_t tmp[32];
+
+    if (cd_flash_read(cd, base + offsetof(asd_crashdump_map_t, header),
+                      sizeof(header), &header) != sizeof(header)) {
+        return false;
+    }
+    if (!asd_crashdump_header_is_valid(&header)) return false;
+
+    // the mini dump and the context follow each other.
+    for (uint32_t i = 0; i < header.length; i += sizeof(tmp)) {
+        int32_t len = MIN(header.length - i, (uint32_t)sizeof(tmp));
+        if (cd_flash_read(cd, base + offsetof(asd_crashdump_map_t, mini_dump) + i,
+                          len, tmp) != len) {
+            return false;
+        }
+        checksum = crc16_update(checksum, tmp, len);
+    }
+    if (checksum != header.crc) return false;
+
+    return (cd_flash_read(cd, base + offsetof(asd_crashdump_map_t, context),
+                          sizeof(*context), context) == sizeof(*context));
+}
+
+/**
+ * @brief find the oldest record to read and the sequence of the next one.
+ *
+ * @return slot following the newest record, where the next record goes.
+ */
+static int cd_scan_slots(asd_crashdump_config_t *cd)
+{
+    asd_crashdump_context_t context;
+    int newest = -1;
+    uint32_t oldest_seq = 0;
+    uint32_t newest_seq = 0;
+
+    cd->read_slot = -1;
+    for (int slot = 0; slot < ASD_CD_SLOT_NUM; slot++) {
+        if (!cd_slot_is_valid(cd, slot, &context)) continue;
+
+        if (cd->read_slot < 0 || (int32_t)(context.sequence - oldest_seq) < 0) {
+            cd->read_slot = slot;
+            oldest_seq = context.sequence;
+        }
+        if (newest < 0 || (int32_t)(context.sequence - newest_seq) > 0) {
+            newest = slot;
+            newest_seq = context.sequence;
+        }
+    }
+
+    cd->status &= ~(CD_FLASH_EXIST | CD_FLASH_CACHED);
+    cd->status |= (cd->read_slot >= 0)? CD_FLASH_EXIST : 0;
+    cd->total_frame_length = 0;
+    cd->sequence = (newest < 0)? 0 : newest_seq + 1;
+
+    return (newest < 0)? 0 : (newest + 1) % ASD_CD_SLOT_NUM;
+}
+
+/**
+ * @brief erase the slot of the next record ahead of time, so that saving a crash
+ *        never waits on an erase. When all slots are in use, the oldest record
+ *        is dropped.
+ *
+ * @return 0 for success, negative for error. (-afw_error)
+ */
+static int32_t cd_prepare_write_slot(asd_crashdump_config_t *cd)
+{
+    int slot = cd_scan_slots(cd);
+
+    if (!flash_data_is_all_FF(cd, CD_SLOT_BASE(slot), ASD_CD_SLOT_SIZE)) {
+        int32_t rc = cd_flash_erase(cd, CD_SLOT_BASE(slot), ASD_CD_SLOT_SIZE);
+        if (rc != 0) {
+            cd->write_slot = -1;
+            return rc;
+        }
+        if (slot == cd->read_slot) {
+            // the ring was full, the next oldest record is read from now on.
+            cd_scan_slots(cd);
+        }
+    }
+    cd->write_slot = slot;
+    return 0;
+}
+
+/**
+ * @brief length of the RAM readable from addr, up to len, within one RAM bank.
+ */
+static uint32_t cd_ram_readable_len(uintptr_t addr, uint32_t len)
 {
-    if(!flash_data_is_all_FF(&cd_config, 0, CRASHDUMP_MINI_TOTAL_SIZE)) {
-        //erase the crash dump region.
-        return asd_crashdump_erase();
+    extern void __base_SRAM_DTC(void);
+    extern void __top_SRAM_DTC(void);
+    extern void __base_SRAM_OC_NON_CACHEABLE(void);
+    extern void __top_SRAM_OC_CACHEABLE(void);
+    // OCRAM non cacheable and cacheable regions are contiguous.
+    const uintptr_t banks[][2] = {
+        {(uintptr_t)__base_SRAM_DTC, (uintptr_t)__top_SRAM_DTC},
+        {(uintptr_t)__base_SRAM_OC_NON_CACHEABLE, (uintptr_t)__top_SRAM_OC_CACHEABLE},
+    };
+
+    for (int i = 0; i < (int)(sizeof(banks)/sizeof(banks[0])); i++) {
+        if (addr >= banks[i][0] && addr < banks[i][1]) {
+            return MIN(len, (uint32_t)(banks[i][1] - addr));
+        }
     }
     return 0;
 }
 
+static void cd_lz_flush(cd_lz_out_t *out)
+{
+    if (!out->fill) return;
+
+    if (out->rc == 0 &&
+        cd_flash_write(&cd_config, out->offset, out->fill, g_scratchpad) != (int32_t)out->fill) {
+        out->rc = -AFW_EIO;
+    }
+    out->crc = crc16_update(out->crc, g_scratchpad, out->fill);
+    out->offset += out->fill;
+    out->length += out->fill;
+    out->fill = 0;
+}
+
+static inline void cd_lz_put(cd_lz_out_t *out, uint8_t byte)
+{
+    g_scratchpad[out->fill++] = byte;
+    if (out->fill == CD_SCRATCH_PAD_LENGTH) {
+        cd_lz_flush(out);
+    }
+}
+
+static void cd_lz_put_len(cd_lz_out_t *out, uint32_t len)
+{
+    for (; len >= 255; len -= 255) {
+        cd_lz_put(out, 255);
+    }
+    cd_lz_put(out, len);
+}
+
+static void cd_lz_sequence(cd_lz_out_t *out, const uint8_t *literals, uint32_t literal_len,
+                           uint32_t match_offset, uint32_t match_len)
+{
+    uint32_t match_code = match_len ? match_len - CD_LZ_MIN_MATCH : 0;
+
+    cd_lz_put(out, (MIN(literal_len, 15U) << 4) | MIN(match_code, 15U));
+    if (literal_len >= 15) {
+        cd_lz_put_len(out, literal_len - 15);
+    }
+    for (uint32_t i = 0; i < literal_len; i++) {
+        cd_lz_put(out, literals[i]);
+    }
+    if (!match_len) return;
+
+    cd_lz_put(out, match_offset & 0xFF);
+    cd_lz_put(out, match_offset >> 8);
+    if (match_code >= 15) {
+        cd_lz_put_len(out, match_code - 15);
+    }
+}
+
+/**
+ * @brief pack memory in LZ4 block format, greedy matching on a small hash table.
+ *        No allocation, the output goes to flash through the scratch pad.
+ *
+ * @return packed length.
+ */
+static uint32_t cd_lz_compress(cd_lz_out_t *out, const uint8_t *src, uint32_t len)
+{
+    uint32_t start = out->length + out->fill;
+    uint32_t anchor = 0;
+    uint32_t ip = 0;
+
+    memset(cd_lz_hash, 0, sizeof(cd_lz_hash));
+
+    if (len > CD_LZ_MF_LIMIT) {
+        while (ip < len - CD_LZ_MF_LIMIT) {
+            uint32_t seq, ref_seq;
+            memcpy(&seq, src + ip, sizeof(seq));
+
+            uint32_t h = (seq * 2654435761U) >> (32 - CD_LZ_HASH_BITS);
+            uint32_t ref = cd_lz_hash[h];
+            cd_lz_hash[h] = ip + 1;
+
+            if (!ref || (ip - (ref - 1)) > CD_LZ_MAX_OFFSET) {
+                ip++;
+                continue;
+            }
+            ref -= 1;
+            memcpy(&ref_seq, src + ref, sizeof(ref_seq));
+            if (ref_seq != seq) {
+                ip++;
+                continue;
+            }
+
+            uint32_t match_len = CD_LZ_MIN_MATCH;
+            while (ip + match_len < len - CD_LZ_LAST_LITERALS
+                   && src[ref + match_len] == src[ip + match_len]) {
+                match_len++;
+            }
+            cd_lz_sequence(out, src + anchor, ip - anchor, ip - ref, match_len);
+            ip += match_len;
+            anchor = ip;
+        }
+    }
+    // last literals.
+    cd_lz_sequence(out, src + anchor, len - anchor, 0, 0);
+
+    return out->length + out->fill - start;
+}
+
 static int32_t asd_crashdump_get_frame_length(asd_frame_info_t* frame_info)
 {
     return asd_crashdump_read_frame(frame_info, 0, NULL, 0);
@@ -496,15 +743,70 @@ static int32_t asd_crashdump_mini_decode(
         break;
     }
 
+    case ASD_CD_FRAME_PACKED_CONTEXT:
+    {
+        // packed bytes in hex, for crashdump_decode.py. Read from flash, line by line.
+        const asd_crashdump_context_t* ctx = &cd_config.context;
+        uint32_t data_base = CD_SLOT_BASE(cd_config.read_slot) + offsetof(asd_crashdump_map_t, data);
+
+        for (int region = 0; region < 2; region++) {
+            uint32_t packed = region ? ctx->ram_packed_len : ctx->stack_packed_len;
+            uint32_t packed_base = data_base + (region ? ctx->stack_packed_len : 0);
+            int32_t lines = (packed + CD_HEX_BYTES_PER_LINE - 1) / CD_HEX_BYTES_PER_LINE;
+
+            if (!packed) continue;
+
+            for (int32_t line = -1; line < lines; line++) {
+                if (line < 0) {
+                    bytes_per_print = snprintf(scratchpad, CD_SCRATCH_PAD_LENGTH,
+                        "\nPacked %s: addr=0x%08x len=%u packed=%u\n",
+                        region ? "ram" : "stack",
+                        (unsigned int)(region ? ctx->ram_addr : ctx->stack_addr),
+                        (unsigned int)(region ? ctx->ram_len : ctx->stack_len),
+                        (unsigned int)packed);
+                } else {
+                    uint32_t n = MIN((uint32_t)CD_HEX_BYTES_PER_LINE, packed - line * CD_HEX_BYTES_PER_LINE);
+                    bytes_per_print = n * 2 + 1;
+                    // only read the flash for lines that are output.
+                    if (buf && (decoded_len + bytes_per_print > (int)offset + output_len)) {
+                        uint8_t raw[CD_HEX_BYTES_PER_LINE];
+                        if (cd_flash_read(&cd_config, packed_base + line * CD_HEX_BYTES_PER_LINE,
+                                          n, raw) != (int32_t)n) {
+                            return -AFW_EIO;
+                        }
+                        for (uint32_t j = 0; j < n; j++) {
+                            scratchpad[j * 2] = TO_BASE16(raw[j] >> 4);
+                            scratchpad[j * 2 + 1] = TO_BASE16(raw[j] & 0xF);
+                        }
+                        scratchpad[n * 2] = '\n';
+                    }
+                }
+                VALIDATE_PRINT_IN_SCRATCH_PAD(bytes_per_print);
+                // append output data, if applicable.
+                output_len += append_data(buf + output_len, size - output_len,
+                                           scratchpad, bytes_per_print,
+                                           (int)offset + output_len - decoded_len);
+                // count decoded text length.
+                decoded_len += bytes_per_print;
+                // check if buffer is full.
+                if (buf && (output_len == (int) size)) break;
+            }
+            if (buf && (output_len == (int) size)) break;
+        }
+        break;
+    }
+
     case ASD_CD_FRAME_LOG:
     {
         // log is not cache in RAM, and always read from flash.
         // read the log section header first.
 
         asd_crashdump_header_t logheader;
+        const asd_crashdump_context_t* ctx = &cd_config.context;
+        uint32_t slot_base = CD_SLOT_BASE(cd_config.read_slot);
 
         if(sizeof(logheader) != cd_flash_read(&cd_config,
-                              offsetof(asd_crashdump_map_t, log_header),
+                              slot_base + offsetof(asd_crashdump_map_t, log_header),
                               sizeof(logheader),
                               &logheader)) {
             return 0;
@@ -520,8 +822,10 @@ static int32_t asd_crashdump_mini_decode(
         }
         if (offset >= logheader.length) return 0;
         output_len = MIN(logheader.length - offset, (uint32_t) size);
+        // the log follows the packed context.
         if (output_len != cd_flash_read(&cd_config,
-                              offsetof(asd_crashdump_map_t, log) + offset,
+                              slot_base + offsetof(asd_crashdump_map_t, data)
+                              + CD_DATA_ROUND_UP(ctx->stack_packed_len + ctx->ram_packed_len) + offset,
                               output_len, buf)){
             return -AFW_EIO;
         }
@@ -548,7 +852,7 @@ static void asd_crashdump_flash_print_finalize(void)
 
     CRASHLOG_HEADER_INIT(&header, cd_config.log_len);
     //write the header back to flash.
-    if (cd_flash_write(&cd_config, offsetof(asd_crashdump_map_t, log_header),
+    if (cd_flash_write(&cd_config, cd_config.log_slot_base + offsetof(asd_crashdump_map_t, log_header),
         sizeof(header), &header) != sizeof(header)) {
         printf("Failed to write crash log header in flash.\n");
     }
@@ -571,13 +875,13 @@ static int asd_crashdump_flash_print(const char* fmt, ...)
     int32_t rc = vsnprintf(g_scratchpad, CD_SCRATCH_PAD_LENGTH, fmt, ap);
     va_end(ap);
     VALIDATE_PRINT_IN_SCRATCH_PAD(rc);
-    int32_t offset = offsetof(asd_crashdump_map_t, log) + cd_config.log_len;
+    int32_t offset = cd_config.log_offset + cd_config.log_len;
 
-    // check available length in flash for crash log.
-    if (rc + offset > LOG_CRASH_LOG_SIZE) {
+    // check available length in the slot for crash log.
+    if (rc + offset > ASD_CD_SLOT_SIZE) {
         return -AFW_ENOSPC;
     }
-    if (cd_flash_write(&cd_config, offset, rc, g_scratchpad) != rc) {
+    if (cd_flash_write(&cd_config, cd_config.log_slot_base + offset, rc, g_scratchpad) != rc) {
         printf("crash log write error.");
         return -AFW_EIO;
     }
@@ -611,10 +915,14 @@ static void asd_crashdump_post_save(uint32_t reason)
 
 int32_t asd_crashdump_init(void)
 {
-    if (cd_config.status != CD_FLASH_UNINITIALIZED) return 0;
+    if (cd_config.status & CD_FLASH_INITIALIZED) return 0;
     cd_config.partition = fm_flash_get_partition(FLASH_PARTITION_LOG_CRASH);
     if (!cd_config.partition) return -AFW_ENODEV;
-    cd_config.status |= (asd_crashdump_is_available())? CD_FLASH_EXIST : 0;
+    // erase the slot of the next crash now, not in the crash path.
+    int32_t rc = cd_prepare_write_slot(&cd_config);
+    if (rc != 0) {
+        ASD_LOG_E(crashdump, "failed to erase the next crash slot. rc =%ld\n", rc);
+    }
     cd_config.status |= CD_FLASH_INITIALIZED;
     return 0;
 }
@@ -642,7 +950,7 @@ bool asd_crashdump_header_is_valid(const asd_crashdump_header_t* header)
     //Currently, support mini dump and log
     switch (header->type) {
         case ASD_CD_TYPE_MINIDUMP:
-            return (header->length == sizeof(asd_crashdump_mini_t));
+            return (header->length == sizeof(asd_crashdump_mini_t) + sizeof(asd_crashdump_context_t));
         case ASD_CD_TYPE_LOG:
             return (header->length > 0) &&
                    (header->length <= CRASHDUMP_LOG_SIZE_MAX);
@@ -653,39 +961,14 @@ bool asd_crashdump_header_is_valid(const asd_crashdump_header_t* header)
 
 bool asd_crashdump_is_available(void)
 {
-    uint32_t tmp;
-    uint16_t checksum = 0;
-    asd_crashdump_header_t cheader;
-
     if (cd_config.status & CD_FLASH_INITIALIZED) {
         //if already initialized, return the cached value.
         return !!(cd_config.status & CD_FLASH_EXIST);
     }
 
-    if(sizeof(cheader) != asd_crashdump_read_raw(ASD_CD_RAW_HEADER,
-                          sizeof(cheader),
-                          &cheader)) {
-        return false;
-    }
-
-    if (!asd_crashdump_header_is_valid(&cheader)) return false;
+    cd_scan_slots(&cd_config);
 
-    for(int i = 0; i < (int)cheader.length; i += sizeof(tmp)) {
-        int32_t len = MIN((int)cheader.length-i, (int)sizeof(tmp));
-
-        if (cd_flash_read(&cd_config, offsetof(asd_crashdump_map_t, mini_dump) + i,
-                          len, &tmp) != len) {
-            return false;
-        }
-        checksum = crc16_update(checksum, &tmp, sizeof(tmp));
-    }
-
-    if (cheader.crc == checksum) {
-        cd_config.status |= CD_FLASH_EXIST;
-    }
-
-
-    return (cheader.crc == checksum);
+    return (cd_config.read_slot >= 0);
 }
 
 
@@ -697,7 +980,39 @@ int32_t asd_crashdump_erase(void)
     cd_config.status &= ~(CD_FLASH_EXIST | CD_FLASH_CACHED);
     cd_config.total_frame_length = 0;
     cd_config.log_len = 0;
-    return cd_flash_erase(&cd_config, 0, LOG_CRASH_LOG_SIZE);
+    cd_config.read_slot = -1;
+    int32_t rc = cd_flash_erase(&cd_config, 0, LOG_CRASH_LOG_SIZE);
+    cd_config.write_slot = (rc == 0)? 0 : -1;
+    return rc;
+}
+
+//There is no protection against read or write operations
+int32_t asd_crashdump_mark_read(void)
+{
+    int8_t slot = cd_config.read_slot;
+
+    if (!asd_crashdump_is_available() || slot < 0) return 0;
+
+    int32_t rc = cd_flash_erase(&cd_config, CD_SLOT_BASE(slot), ASD_CD_SLOT_SIZE);
+    if (rc != 0) return rc;
+
+    // the next oldest record becomes readable.
+    if (cd_config.write_slot < 0) {
+        return cd_prepare_write_slot(&cd_config);
+    }
+    cd_scan_slots(&cd_config);
+    return 0;
+}
+
+int32_t asd_crashdump_set_ram_window(const void* addr, uint32_t len)
+{
+    if (addr && (len > ASD_CD_RAM_WINDOW_MAX
+                 || cd_ram_readable_len((uintptr_t)addr, len) != len)) {
+        return -AFW_EINVAL;
+    }
+    cd_config.ram_addr = addr;
+    cd_config.ram_len = addr ? len : 0;
+    return 0;
 }
 
 //There is no protection between reading and writing to flash the sd_info
@@ -705,34 +1020,89 @@ int32_t asd_crashdump_erase(void)
 //accepted. The checksum provides an ability to recognize corruption to an extent
 void asd_crashdump_save(const asd_crashdump_mini_t *sd_info)
 {
+    asd_crashdump_context_t context = {0};
+    cd_lz_out_t out = {0};
+
     if (!sd_info) return;
-    if (asd_crashdump_check_and_erase() != 0) {
-        printf("failed to erase crash log.\n");
+    if (cd_config.write_slot < 0) {
+        // not prepared by asd_crashdump_init, erase now.
+        if (cd_prepare_write_slot(&cd_config) != 0) {
+            printf("failed to erase crash log.\n");
+            return;
+        }
     }
-    printf("Writing to crash log sector\n");
+    uint32_t slot_base = CD_SLOT_BASE(cd_config.write_slot);
+
+    printf("Writing to crash log slot %d\n", cd_config.write_slot);
     if( sizeof(*sd_info) != cd_flash_write(&cd_config,
-        offsetof(asd_crashdump_map_t, mini_dump),
+        slot_base + offsetof(asd_crashdump_map_t, mini_dump),
         sizeof(*sd_info), sd_info)) {
         printf("Failed to write mini dump in crash log sector.\n");
         return;
     }
+
+    // pack the stack of the faulting context, then the RAM window.
+    context.sequence = cd_config.sequence;
+    out.offset = slot_base + offsetof(asd_crashdump_map_t, data);
+
+    context.stack_addr = sd_info->cpu.sp;
+    context.stack_len = MIN(cd_ram_readable_len(context.stack_addr, ASD_CD_STACK_CAPTURE_SIZE),
+                            (uint32_t)CD_LZ_INPUT_MAX(CRASHDUMP_DATA_SIZE_MAX));
+    if (context.stack_len) {
+        context.stack_packed_len = cd_lz_compress(&out, (const uint8_t*)context.stack_addr,
+                                                  context.stack_len);
+    }
+
+    context.ram_addr = (uintptr_t)cd_config.ram_addr;
+    context.ram_len = MIN(cd_config.ram_len,
+                          (uint32_t)CD_LZ_INPUT_MAX(CRASHDUMP_DATA_SIZE_MAX - context.stack_packed_len));
+    if (context.ram_len) {
+        context.ram_packed_len = cd_lz_compress(&out, cd_config.ram_addr, context.ram_len);
+    }
+
+    cd_lz_flush(&out);
+    if (out.rc != 0) {
+        printf("Failed to write crash context.\n");
+        return;
+    }
+    context.packed_crc = out.crc;
+    if (sizeof(context) != cd_flash_write(&cd_config,
+        slot_base + offsetof(asd_crashdump_map_t, context),
+        sizeof(context), &context)) {
+        printf("Failed to write crash context.\n");
+        return;
+    }
+
+    // the header commits the record.
     asd_crashdump_header_t header;
-    CRASHDUMP_HEADER_INIT(&header, 0, sizeof(asd_crashdump_mini_t));
+    CRASHDUMP_HEADER_INIT(&header, 0, sizeof(asd_crashdump_mini_t) + sizeof(asd_crashdump_context_t));
     header.crc = crc16_update(0, sd_info, sizeof(*sd_info));
+    header.crc = crc16_update(header.crc, &context, sizeof(context));
     if(sizeof(asd_crashdump_header_t)
-       != cd_flash_write(&cd_config, offsetof(asd_crashdump_map_t, header),
+       != cd_flash_write(&cd_config, slot_base + offsetof(asd_crashdump_map_t, header),
                          sizeof(asd_crashdump_header_t), &header)){
         printf("Failed to write crash dump header\n");
         return;
     }
 
-    //save additional log:
+    //save additional log after the packed context:
+    cd_config.log_slot_base = slot_base;
+    cd_config.log_offset = offsetof(asd_crashdump_map_t, data)
+                           + CD_DATA_ROUND_UP(context.stack_packed_len + context.ram_packed_len);
+    cd_config.log_len = 0;
     asd_crashdump_post_save(sd_info->reason);
 
-    //set flash exist bit.
+    //set flash exist bit, the slot is used until the next prepare.
+    if (cd_config.read_slot < 0) {
+        cd_config.read_slot = cd_config.write_slot;
+    }
+    cd_config.write_slot = -1;
+    cd_config.sequence++;
+    cd_config.total_frame_length = 0;
     cd_config.status |= CD_FLASH_EXIST;
-    printf("Succeeds to write crash mini dump. %u bytes = %u + %u\n", CRASHDUMP_MINI_TOTAL_SIZE,
-        sizeof(asd_crashdump_header_t), sizeof(asd_crashdump_mini_t));
+    printf("Succeeds to write crash mini dump. %u bytes = %u + %u + %u packed\n",
+        (unsigned int)(CRASHDUMP_MINI_TOTAL_SIZE + out.length), (unsigned int)CRASHDUMP_MINI_TOTAL_SIZE,
+        (unsigned int)context.stack_packed_len, (unsigned int)context.ram_packed_len);
 }
 
 //There is no protection between reading and writing to flash the sd_info
@@ -741,6 +1111,9 @@ void asd_crashdump_save(const asd_crashdump_mini_t *sd_info)
 int32_t asd_crashdump_read_raw(asd_crashdump_section_t section, uint32_t size, void* buf)
 {
     uint32_t offset, readsize;
+
+    if (cd_config.read_slot < 0) return -AFW_ENOENT;
+
     switch (section) {
     case ASD_CD_RAW_HEADER:
         offset = offsetof(asd_crashdump_map_t, header);
@@ -750,13 +1123,17 @@ int32_t asd_crashdump_read_raw(asd_crashdump_section_t section, uint32_t size, v
         offset = offsetof(asd_crashdump_map_t, mini_dump);
         readsize = sizeof(asd_crashdump_mini_t);
         break;
+    case ASD_CD_RAW_CONTEXT:
+        offset = offsetof(asd_crashdump_map_t, context);
+        readsize = sizeof(asd_crashdump_context_t);
+        break;
     default:
         return -AFW_EINVAL;
     }
 
     if (size < readsize) return -AFW_EINTRL;
 
-    if (cd_flash_read(&cd_config, offset,
+    if (cd_flash_read(&cd_config, CD_SLOT_BASE(cd_config.read_slot) + offset,
                            readsize, buf) != (int) readsize) {
         return -AFW_EIO;
     }
@@ -845,6 +1222,12 @@ int32_t asd_crashdump_read_frame(
             ASD_LOG_E(crashdump, "asd_crashdump_read_raw failed. rc =%ld\n", rc);
             return -AFW_ENOENT;
         }
+        rc = asd_crashdump_read_raw(ASD_CD_RAW_CONTEXT, sizeof(cd_config.context),
+                                    &cd_config.context);
+        if (sizeof(cd_config.context) != rc) {
+            ASD_LOG_E(crashdump, "asd_crashdump_read_raw failed. rc =%ld\n", rc);
+            return -AFW_ENOENT;
+        }
         cd_config.status |= CD_FLASH_CACHED;
     }
     // Now use the cached mini dump raw data to decode.
@@ -861,6 +1244,7 @@ void asd_clear_cached_minidump(void)
 {
     cd_config.status &= ~CD_FLASH_CACHED;
     memset(&cd_config.mini_dump, 0, sizeof(cd_config.mini_dump));
+    memset(&cd_config.context, 0, sizeof(cd_config.context));
 }
 
 void crashdump_register_version_info_callback(app_version_info_callback *cb)
@@ -34,7 +34,24 @@ extern "C" {
 #endif
 
 
-#define ASD_CD_VERSION        1
+#define ASD_CD_VERSION        2
+
+// The crash partition is a ring of slots, one crash record per slot.
+// A slot must be a multiple of the flash sector size.
+#ifndef ASD_CD_SLOT_SIZE
+#define ASD_CD_SLOT_SIZE           (0x1000)
+#endif
+#define ASD_CD_SLOT_NUM            (LOG_CRASH_LOG_SIZE / ASD_CD_SLOT_SIZE)
+
+// Bytes of the faulting task stack captured from sp upwards.
+#ifndef ASD_CD_STACK_CAPTURE_SIZE
+#define ASD_CD_STACK_CAPTURE_SIZE  (1024)
+#endif
+
+// Largest RAM window accepted by asd_crashdump_set_ram_window().
+#ifndef ASD_CD_RAM_WINDOW_MAX
+#define ASD_CD_RAM_WINDOW_MAX      (2048)
+#endif
 
 typedef enum {
     ASD_CD_TYPE_MINIDUMP,
@@ -46,6 +63,7 @@ typedef enum {
     ASD_CD_FRAME_CALL_STACK,
     ASD_CD_FRAME_CPU_REG_DUMP,
     ASD_CD_FRAME_STACK_DUMP,
+    ASD_CD_FRAME_PACKED_CONTEXT,
     ASD_CD_FRAME_LOG,
     ASD_CD_FRAME_NUM,
 } asd_crashdump_frame_index_t;
@@ -53,6 +71,7 @@ typedef enum {
 typedef enum {
     ASD_CD_RAW_HEADER,
     ASD_CD_RAW_MINI,
+    ASD_CD_RAW_CONTEXT,
 } asd_crashdump_section_t;
 
 
@@ -66,20 +85,39 @@ typedef struct {
 
 _Static_assert(sizeof(asd_crashdump_header_t)%4 == 0, "asd_crashdump_header_t must be dword aligned!!!");
 
+// Memory captured with the mini dump, packed in LZ4 block format.
+typedef struct {
+    uint32_t sequence;           ///< crash counter, orders the slots.
+    uint32_t stack_addr;         ///< sp of the faulting context.
+    uint32_t stack_len;          ///< bytes captured from stack_addr.
+    uint32_t stack_packed_len;   ///< bytes of packed stack at the start of data.
+    uint32_t ram_addr;           ///< RAM window set by asd_crashdump_set_ram_window().
+    uint32_t ram_len;
+    uint32_t ram_packed_len;     ///< bytes of packed RAM window following the packed stack.
+    uint16_t packed_crc;         ///< crc16 of all packed bytes.
+    uint16_t reserved;
+} __attribute__((packed)) asd_crashdump_context_t;
+
+// Layout of one slot. The header is written last, a slot without a valid header
+// is either blank or holds an interrupted record.
 typedef struct {
-    asd_crashdump_header_t header;    ///< header for mini dump.
+    asd_crashdump_header_t header;    ///< header for mini dump and context.
     asd_crashdump_mini_t mini_dump;   ///< minidump in binary.
+    asd_crashdump_context_t context;  ///< captured memory description.
     asd_crashdump_header_t log_header;    ///< header for additional crash log.
-    char log[];        ///< log is variable size, that can fill between offset
-                       ///< CRASHDUMP_MINI_TOTAL_SIZE and LOG_CRASH_LOG_SIZE.
+    uint8_t data[];    ///< packed stack, packed RAM window, then the crash log,
+                       ///< up to the end of the slot.
 } __attribute__((packed)) asd_crashdump_map_t;
 
-#define CRASHDUMP_MINI_TOTAL_SIZE (sizeof(asd_crashdump_header_t) + sizeof(asd_crashdump_mini_t))
+#define CRASHDUMP_MINI_TOTAL_SIZE (sizeof(asd_crashdump_header_t) + sizeof(asd_crashdump_mini_t) \
+                                   + sizeof(asd_crashdump_context_t))
+#define CRASHDUMP_DATA_SIZE_MAX   (ASD_CD_SLOT_SIZE - offsetof(asd_crashdump_map_t, data))
 #ifdef LOG_CRASH_LOG_SIZE
-_Static_assert(CRASHDUMP_MINI_TOTAL_SIZE <= LOG_CRASH_LOG_SIZE, "mini crashdump too large");
+_Static_assert(CRASHDUMP_MINI_TOTAL_SIZE <= ASD_CD_SLOT_SIZE, "mini crashdump too large");
+_Static_assert(ASD_CD_SLOT_NUM >= 2, "crash partition needs two slots to keep one erased");
 #endif
 
-#define CRASHDUMP_LOG_SIZE_MAX (LOG_CRASH_LOG_SIZE - offsetof(asd_crashdump_map_t, log))
+#define CRASHDUMP_LOG_SIZE_MAX    CRASHDUMP_DATA_SIZE_MAX
 
 /**
  * @brief initialize crashdump manager.
@@ -101,12 +139,31 @@ int32_t asd_crashdump_read_raw(asd_crashdump_section_t section, uint32_t size, v
 
 
 /**
- * @brief erase crash dump region in flash.
+ * @brief erase crash dump region in flash, all slots.
  *
  * @return 0 for success, negative for error. (-afw_error)
  */
 int32_t asd_crashdump_erase(void);
 
+/**
+ * @brief drop the oldest crash record, the one the frames are read from. Its slot
+ *        is erased and the next record, if any, becomes readable.
+ *
+ * @return 0 for success, negative for error. (-afw_error)
+ */
+int32_t asd_crashdump_mark_read(void);
+
+/**
+ * @brief set a RAM window captured with the next crash records, in addition to the
+ *        stack of the faulting task. The window must stay readable.
+ *
+ * @param [in] addr: start of the window, NULL to disable.
+ * @param [in] len: length of the window, at most ASD_CD_RAM_WINDOW_MAX.
+ *
+ * @return 0 for success, negative for error. (-afw_error)
+ */
+int32_t asd_crashdump_set_ram_window(const void* addr, uint32_t len);
+
 /**
  * @brief check if crash dump is available in flash. It will read the dumped raw data and
  *        check CRC.
@@ -156,7 +213,9 @@ int32_t asd_crashdump_get_first_frame(asd_frame_info_t* first);
 int32_t asd_crashdump_get_next_frame(const asd_frame_info_t* cur, asd_frame_info_t* next);
 
 /**
- * @brief Save the minidump in flash.
+ * @brief Save the minidump in flash, with the stack from minidump->cpu.sp and the
+ *        RAM window, in the slot erased ahead by asd_crashdump_init(). The oldest
+ *        record is overwritten when all slots are in use.
  * @param [in] minidump: pointer of minidump in RAM.
  *
  * @return none.
@@ -161,14 +161,30 @@ extern uintptr_t _g_global_flash_offset;
 #define LOG_META_VERSION        1
 #define LOG_META_SIZE          0x1000
 #define LOG_DSP_SIZE           0x0000
-#define LOG_MAIN_SIZE          0x1E000
+#define LOG_MAIN_SIZE          0x1B000
 #define LOG_VITAL_SIZE         0x0000
-#define LOG_CRASH_LOG_SIZE     0x1000
+#define LOG_CRASH_LOG_SIZE     0x4000  /* 4 crash slots */
 
 #ifdef AMAZON_FLASH_MAP_EXT_ENABLE
 #include "flash_map_ext.h"
 #endif
 
+/* The log region (FLASH_PARTITION_LOG at LOG_BASE, from flash_map_ext.h) holds
+ * the meta, main log and crash partitions back to back */
+#if defined(LOG_BASE) && !defined(LOG_META_ADDR)
+#define LOG_META_ADDR          (LOG_BASE)
+#define LOG_MAIN_ADDR          (LOG_META_ADDR                       + LOG_META_SIZE)
+#define LOG_CRASH_LOG_ADDR     (LOG_MAIN_ADDR                       + LOG_MAIN_SIZE)
+#endif
+
+#if (LOG_META_SIZE + LOG_MAIN_SIZE) % 0x1000 != 0
+#error "CRASH LOG SLOTS ARE NOT 4 KB ALIGNED"
+#endif
+
+#if defined(LOG_LENGTH) && (LOG_META_SIZE + LOG_MAIN_SIZE + LOG_CRASH_LOG_SIZE > LOG_LENGTH)
+#error "LOG PARTITIONS OVERFLOW THE LOG REGION"
+#endif
+
 #ifndef FACTORY_RESET_EXT_PARTITIONS_TO_ERASE
 #define FACTORY_RESET_EXT_PARTITIONS_TO_ERASE
 #endif
@@ -19,6 +19,7 @@
 #include "pdm_to_pcm_task.h"
 #include "pdm_pcm_definitions.h"
 #include "sln_pdm_mic.h"
+#include "sln_tickless.h"
 
 #if USE_MQS
 #include "semphr.h"
@@ -44,6 +45,9 @@
 
 #define PDM_PCM_EVENT_TIMEOUT_MS 1000
 
+/* One DMA completion per ping or pong block */
+#define PDM_PCM_BLOCK_PERIOD_US ((PCM_SINGLE_CH_SMPL_COUNT * 1000000U) / PCM_SAMPLE_RATE_HZ)
+
 #define EVT_PING_MASK (MIC1_PING_EVENT | MIC2_PING_EVENT | MIC3_PING_EVENT)
 #define EVT_PONG_MASK (MIC1_PONG_EVENT | MIC2_PONG_EVENT | MIC3_PONG_EVENT)
 
@@ -127,6 +131,7 @@ static void pdm_to_pcm_update_timestamp(void);
 void DMA0_DMA16_IRQHandler(void)
 {
     PDM_MIC_DmaCallback(&g_pdmMicSai2Handle);
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Microphones, PDM_PCM_BLOCK_PERIOD_US);
 }
 #endif
 
@@ -134,6 +139,7 @@ void DMA0_DMA16_IRQHandler(void)
 void DMA1_DMA17_IRQHandler(void)
 {
     PDM_MIC_DmaCallback(&g_pdmMicSai1Handle);
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Microphones, PDM_PCM_BLOCK_PERIOD_US);
 }
 #endif
 
@@ -11,6 +11,7 @@
 #include "queue.h"
 #include "task.h"
 #include "timers.h"
+#include "semphr.h"
 
 #include "board.h"
 #include "fsl_dmamux.h"
@@ -21,10 +22,10 @@
 #include "fsl_codec_common.h"
 #include "pdm_pcm_definitions.h"
 #include "sln_amplifier.h"
+#include "sln_tickless.h"
 
 #if USE_MQS
 #include "fsl_gpt.h"
-#include "semphr.h"
 #include "ringbuffer.h"
 #endif /* USE_MQS */
 
@@ -37,10 +38,24 @@
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
-/*! @brief AMPLIFIER SEND Task settings */
-#define AMPLIFIER_SEND_TASK_NAME       "amplifier_send_task"
-#define AMPLIFIER_SEND_TASK_STACK_SIZE 1024
-#define AMPLIFIER_SEND_TASK_PRIORITY   configMAX_PRIORITIES - 1
+/*! @brief AMPLIFIER Task settings */
+#define AMPLIFIER_TASK_NAME       "amplifier_task"
+#define AMPLIFIER_TASK_STACK_SIZE 1024
+#define AMPLIFIER_TASK_PRIORITY   configMAX_PRIORITIES - 1
+
+/* Buffers that can wait in the write ring for the amplifier task */
+#ifndef AMP_WRITE_RING_SIZE
+#define AMP_WRITE_RING_SIZE 8
+#endif
+
+/* Chunks kept in the SAI eDMA queue, so the next one starts as soon as the current one ends */
+#define AMP_DMA_INFLIGHT_MAX SAI_XFER_QUEUE_SIZE
+#define AMP_INFLIGHT_SIZE    (2 * SAI_XFER_QUEUE_SIZE)
+#define AMP_INFLIGHT_SILENCE 0xFF
+
+/* Silence played when the write ring runs empty in the middle of a playback, 2ms chunks up to 20ms */
+#define AMP_SILENCE_CHUNK_SIZE (2 * PCM_AMP_DATA_SIZE_1_MS)
+#define AMP_SILENCE_MAX_CHUNKS 10
 
 #if USE_MQS
 #define PCM_AMP_DMA_CHUNK_SIZE 2 * PCM_AMP_SAMPLE_COUNT *PCM_SAMPLE_SIZE_BYTES
@@ -73,6 +88,38 @@ typedef enum _loopback_state
 
 #define PCM_AMP_DMA_TX_COMPLETE_EVT_BIT 1
 #define PCM_AMP_AUDIO_ABORT_EVT_BIT     2
+#define PCM_AMP_WRITE_EVT_BIT           4
+#define PCM_AMP_ABORT_DONE_EVT_BIT      8
+
+typedef enum _amp_write_flags
+{
+    kAmpWriteLoop      = (1U << 0U), /* Played until SLN_AMP_AbortWrite */
+    kAmpWriteCountPool = (1U << 1U), /* Completion frees a slot of pu8BufferPool */
+    kAmpWriteStarted   = (1U << 2U), /* First chunk was handed to the SAI */
+    kAmpWriteExclusive = (1U << 3U), /* SLN_AMP_Write or SLN_AMP_WriteLoop, one at a time */
+} amp_write_flags_t;
+
+/*! @brief Buffer waiting in the write ring */
+typedef struct _amp_write_desc
+{
+    uint8_t *data;
+    uint32_t length;
+    uint32_t offset; /* Bytes already handed to the SAI */
+    uint32_t flags;
+    TickType_t enqueueTick;
+    amp_write_callback_t callback;
+    void *arg;
+} amp_write_desc_t;
+
+/*! @brief Chunk handed to the SAI eDMA queue */
+typedef struct _amp_inflight
+{
+    uint8_t desc;    /* Write ring index or AMP_INFLIGHT_SILENCE */
+    bool first;      /* First chunk of the buffer */
+    bool last;       /* Last chunk of the buffer */
+    bool pool;       /* Buffer is counted in pu8BufferPool */
+    uint32_t playUs; /* Play time of the chunk */
+} amp_inflight_t;
 
 #define WAIT_SAI_RX_FEF_FLAG_CLEAR  3
 #define WAIT_SAI_TX_FEF_FLAG_CLEAR  3
@@ -84,8 +131,10 @@ typedef enum _loopback_state
 /*******************************************************************************
  * Variables
  ******************************************************************************/
-static TaskHandle_t s_AmplifierSendTaskHandle;
+static TaskHandle_t s_AmpTaskHandle = NULL;
 static EventGroupHandle_t s_DmaTxComplete;
+static SemaphoreHandle_t s_AmpBlockingMutex = NULL;
+static SemaphoreHandle_t s_AmpBlockingDone  = NULL;
 static codec_handle_t codecHandle;
 
 #if USE_TFA
@@ -113,11 +162,28 @@ edma_handle_t s_AmpDmaRxHandle   = {0};
 sai_edma_handle_t s_AmpRxHandler = {0};
 #endif /* USE_TFA */
 
-static volatile uint32_t u32AudioLength = 0;
-static uint8_t *pu8AudioPlay            = NULL;
-static uint32_t startAudioLength        = 0;
-static uint8_t *startAudioPlay          = NULL;
-static volatile uint8_t loop            = 0;
+/* Write ring, filled by the callers and drained by the amplifier task.
+ * tail: oldest buffer not yet played, cursor: next buffer to hand to the SAI, head: next free slot */
+static amp_write_desc_t s_AmpRing[AMP_WRITE_RING_SIZE];
+static uint32_t s_AmpRingHead    = 0;
+static uint32_t s_AmpRingTail    = 0;
+static uint32_t s_AmpRingCursor  = 0;
+static uint32_t s_AmpRingCount   = 0;
+static uint32_t s_AmpRingPending = 0;
+/* SLN_AMP_Write and SLN_AMP_WriteLoop buffers in the ring, these calls return busy while one is queued */
+static uint32_t s_AmpRingExclusive = 0;
+
+/* Chunks in the SAI eDMA queue; submitted by the amplifier task, completed by the TX callback,
+ * then processed by the amplifier task */
+static amp_inflight_t s_AmpInflight[AMP_INFLIGHT_SIZE];
+static volatile uint32_t s_AmpInflightSubmit = 0;
+static volatile uint32_t s_AmpInflightDone   = 0;
+static uint32_t s_AmpInflightProcessed       = 0;
+
+__attribute__((aligned(4))) static uint8_t s_AmpSilence[AMP_SILENCE_CHUNK_SIZE];
+static uint32_t s_AmpSilenceChunks = 0;
+static bool s_AmpPlaying           = false;
+static amp_stats_t s_AmpStats      = {0};
 
 #if USE_AUDIO_SPEAKER
 extern usb_device_composite_struct_t g_composite;
@@ -128,6 +194,7 @@ static uint8_t audioPlayDMATempBuff[FS_ISO_OUT_ENDP_PACKET_SIZE];
 #endif
 
 static volatile uint8_t *pu8BufferPool   = NULL;
+static SemaphoreHandle_t s_AmpPoolSemaphore = NULL;
 static uint8_t *pDefaultAudioData        = NULL;
 static uint32_t s_DefaultAudioDataLength = 0;
 
@@ -352,14 +419,34 @@ static void SLN_AMP_RxCallback(I2S_Type *base, sai_edma_handle_t *handle, status
 static void SLN_AMP_TxCallback(I2S_Type *base, sai_edma_handle_t *handle, status_t status, void *userData)
 {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    amp_inflight_t *entry               = NULL;
 
-    xEventGroupSetBitsFromISR(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, &xHigherPriorityTaskWoken);
-
-    if (pu8BufferPool != NULL)
+    if (s_AmpInflightDone != s_AmpInflightSubmit)
     {
-        (*pu8BufferPool)++;
+        entry = &s_AmpInflight[s_AmpInflightDone % AMP_INFLIGHT_SIZE];
+
+        /* Free the slot here rather than in the amplifier task, the loopback sync waits on it */
+        if (entry->pool && entry->last && (pu8BufferPool != NULL))
+        {
+            (*pu8BufferPool)++;
+
+            if (NULL != s_AmpPoolSemaphore)
+            {
+                xSemaphoreGiveFromISR(s_AmpPoolSemaphore, &xHigherPriorityTaskWoken);
+            }
+        }
+
+        s_AmpInflightDone++;
     }
 
+    /* The next TX interrupt comes at the end of the chunk now playing, if any */
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Amplifier,
+                                 (s_AmpInflightDone != s_AmpInflightSubmit) ?
+                                     s_AmpInflight[s_AmpInflightDone % AMP_INFLIGHT_SIZE].playUs :
+                                     0U);
+
+    xEventGroupSetBitsFromISR(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, &xHigherPriorityTaskWoken);
+
 #if USE_AUDIO_SPEAKER
     sai_transfer_t xfer = {0};
     if ((g_composite.audioUnified.audioSendTimes >= g_composite.audioUnified.usbRecvTimes) &&
@@ -389,6 +476,8 @@ static void SLN_AMP_TxCallback(I2S_Type *base, sai_edma_handle_t *handle, status
 
     SAI_TransferSendEDMA(base, handle, &xfer);
 #endif
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 #if USE_MQS
@@ -417,323 +506,422 @@ void SLN_AMP_SetDefaultAudioData(uint8_t *data, uint32_t len)
     }
 }
 
+static void SLN_AMP_UpdateLatency(TickType_t enqueueTick)
+{
+    uint32_t latencyMs = (xTaskGetTickCount() - enqueueTick) * portTICK_PERIOD_MS;
+
+    s_AmpStats.lastLatencyMs = latencyMs;
+    if (latencyMs > s_AmpStats.maxLatencyMs)
+    {
+        s_AmpStats.maxLatencyMs = latencyMs;
+    }
+}
+
 amplifier_status_t SLN_AMP_WriteDefault(void)
 {
+    amplifier_status_t ret = 0;
+
 #if USE_SIGNAL_TEST_SIGNAL
     PlaybackSine();
 #else
-    sai_transfer_t xfer_codec = {0};
-
-    // Take advantage of 32 being power of 2 to replace % to reduce # of instructions
-    size_t overFlow = s_DefaultAudioDataLength & 31U;
-    if (overFlow)
-    {
-        xfer_codec.dataSize = s_DefaultAudioDataLength - (overFlow);
-    }
-    xfer_codec.data = pDefaultAudioData;
-    SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &xfer_codec);
+    ret = SLN_AMP_WriteAsync(pDefaultAudioData, s_DefaultAudioDataLength, NULL, NULL);
 #endif
-    return 0;
+    return ret;
 }
 
-void audio_send_task(void *pvParameters)
+/*!
+ * @brief Hands a chunk to the SAI eDMA queue
+ */
+static status_t SLN_AMP_SendChunk(uint8_t *data, uint32_t length)
 {
+    status_t status           = kStatus_Fail;
     sai_transfer_t write_xfer = {0};
-    EventBits_t events;
-
-    /* Chop into PCM_AMP_DMA_CHUNK_SIZE chunks so the DMA can handle it. */
-    while (1)
-    {
-        events = xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_AUDIO_ABORT_EVT_BIT | PCM_AMP_DMA_TX_COMPLETE_EVT_BIT,
-                                     pdTRUE, pdFALSE, portMAX_DELAY);
 
-        /* We are assured that we waited for all the SAI_TransferSendEDMA to finish and we can stop safely. */
-        if (u32AudioLength == 0)
-        {
-            break;
-        }
-
-        // Abort
-        if (events & 2)
-        {
-            SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
-            u32AudioLength = 0;
-            pu8AudioPlay   = NULL;
-            loop           = 0;
-            break;
-        }
-        else
-        {
-            if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
-            {
-                write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-                write_xfer.data     = pu8AudioPlay;
+    write_xfer.dataSize = length;
+    write_xfer.data     = data;
 
 #if USE_TFA
-                SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    status = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
 
 #elif USE_MQS
-                SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-                SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
+    SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
+    status = SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
 #endif /* USE_TFA */
 
-                pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-                u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
-            }
-            else
-            {
-                write_xfer.dataSize = u32AudioLength;
-                write_xfer.data     = pu8AudioPlay;
+    return status;
+}
 
-#if USE_TFA
-                SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+/*!
+ * @brief Queues a chunk behind the ones already in the SAI eDMA queue
+ *
+ * The in flight entry is registered first, the TX callback may complete the chunk right away.
+ */
+static status_t SLN_AMP_SubmitChunk(uint8_t desc, uint8_t *data, uint32_t length, bool first, bool last, bool pool)
+{
+    status_t status        = kStatus_Fail;
+    amp_inflight_t *entry  = &s_AmpInflight[s_AmpInflightSubmit % AMP_INFLIGHT_SIZE];
+    bool idle              = false;
+    amp_write_desc_t *item = NULL;
+
+    entry->desc   = desc;
+    entry->first  = first;
+    entry->last   = last;
+    entry->pool   = pool;
+    entry->playUs = (length * 1000U) / PCM_AMP_DATA_SIZE_1_MS;
+
+    taskENTER_CRITICAL();
+    idle = (s_AmpInflightDone == s_AmpInflightSubmit);
+    s_AmpInflightSubmit++;
+    if (idle)
+    {
+        /* The TX interrupts start again with this chunk */
+        SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Amplifier, entry->playUs);
+    }
+    taskEXIT_CRITICAL();
 
-#elif USE_MQS
-                SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-                SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+    status = SLN_AMP_SendChunk(data, length);
 
-                if (loop)
-                {
-                    u32AudioLength = startAudioLength;
-                    pu8AudioPlay   = startAudioPlay;
-                }
-                else
-                {
-                    u32AudioLength = 0;
-                    pu8AudioPlay   = NULL;
-                }
-            }
-        }
+    if (kStatus_Success != status)
+    {
+        /* Never reached the SAI, so the TX callback can not have consumed it */
+        taskENTER_CRITICAL();
+        s_AmpInflightSubmit--;
+        taskEXIT_CRITICAL();
+    }
+    else if (idle && first)
+    {
+        /* Nothing was playing, so the chunk starts right away */
+        item = &s_AmpRing[desc];
+        SLN_AMP_UpdateLatency(item->enqueueTick);
     }
 
-    vTaskDelete(NULL);
+    return status;
 }
 
-amplifier_status_t SLN_AMP_Write(uint8_t *data, uint32_t length)
+/*!
+ * @brief Completes the oldest buffer of the ring and frees its slot
+ */
+static void SLN_AMP_ReleaseWrite(amplifier_status_t status)
 {
-    sai_transfer_t write_xfer     = {0};
-    amplifier_status_t eAmpStatus = 1;
+    amp_write_desc_t item = s_AmpRing[s_AmpRingTail];
 
-    if (0 == u32AudioLength)
+    taskENTER_CRITICAL();
+    s_AmpRingTail = (s_AmpRingTail + 1) % AMP_WRITE_RING_SIZE;
+    s_AmpRingCount--;
+    if (item.flags & kAmpWriteExclusive)
     {
-        pu8AudioPlay = data;
-        if (length)
-        {
-            u32AudioLength = length - (length % 32);
-        }
-        else
-        {
-            u32AudioLength = length;
-        }
+        s_AmpRingExclusive--;
+    }
+    taskEXIT_CRITICAL();
 
-        /* Chop into 512KB chunks so the DMA can handle it. */
-        if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
-        {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = pu8AudioPlay;
+    if (kStatus_Success == status)
+    {
+        s_AmpStats.writes++;
+    }
 
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    if (NULL != item.callback)
+    {
+        item.callback(item.data, item.length, status, item.arg);
+    }
+}
 
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+/*!
+ * @brief Handles the chunks completed by the TX callback
+ */
+static void SLN_AMP_ProcessCompleted(void)
+{
+    amp_inflight_t *entry = NULL;
+    amp_inflight_t *next  = NULL;
 
-            pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-            u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
+    while (s_AmpInflightProcessed != s_AmpInflightDone)
+    {
+        entry = &s_AmpInflight[s_AmpInflightProcessed % AMP_INFLIGHT_SIZE];
+        s_AmpInflightProcessed++;
 
-            if (xTaskCreate(audio_send_task, AMPLIFIER_SEND_TASK_NAME, AMPLIFIER_SEND_TASK_STACK_SIZE, NULL,
-                            AMPLIFIER_SEND_TASK_PRIORITY, &s_AmplifierSendTaskHandle) == pdPASS)
-            {
-                eAmpStatus = 0;
-            }
-            else
+        /* The following chunk, if any, started playing when this one ended */
+        if (s_AmpInflightProcessed != s_AmpInflightSubmit)
+        {
+            next = &s_AmpInflight[s_AmpInflightProcessed % AMP_INFLIGHT_SIZE];
+            if (next->first)
             {
-                configPRINTF(("Failed to create amplifier_send_task for SLN_AMP_Write!\r\n"));
+                SLN_AMP_UpdateLatency(s_AmpRing[next->desc].enqueueTick);
             }
         }
-        else
-        {
-            write_xfer.dataSize = u32AudioLength;
-            write_xfer.data     = pu8AudioPlay;
 
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            u32AudioLength = 0;
-            pu8AudioPlay   = NULL;
-
-            eAmpStatus = 0;
+        if ((AMP_INFLIGHT_SILENCE != entry->desc) && entry->last)
+        {
+            SLN_AMP_ReleaseWrite(kStatus_Success);
         }
     }
-    return eAmpStatus;
 }
 
-amplifier_status_t SLN_AMP_WriteLoop(uint8_t *data, uint32_t length)
+/*!
+ * @brief Keeps the SAI eDMA queue filled from the write ring
+ *
+ * When the ring runs empty in the middle of a playback, short silence chunks are played so the
+ * SAI keeps running until either new data comes in or AMP_SILENCE_MAX_CHUNKS were played.
+ */
+static void SLN_AMP_Refill(void)
 {
-    sai_transfer_t write_xfer     = {0};
-    amplifier_status_t eAmpStatus = 1;
+    amp_write_desc_t *item = NULL;
+    uint32_t pending       = 0;
+    uint32_t inflight      = 0;
+    uint32_t chunk         = 0;
+    bool first             = false;
+    bool last              = false;
 
-    if (0 == u32AudioLength)
+    while (1)
     {
-        pu8AudioPlay = data;
-        if (length)
-        {
-            u32AudioLength = length - (length % 32);
-        }
-        else
+        taskENTER_CRITICAL();
+        pending  = s_AmpRingPending;
+        inflight = s_AmpInflightSubmit - s_AmpInflightDone;
+        taskEXIT_CRITICAL();
+
+        if ((inflight >= AMP_DMA_INFLIGHT_MAX) || ((s_AmpInflightSubmit - s_AmpInflightProcessed) >= AMP_INFLIGHT_SIZE))
         {
-            u32AudioLength = length;
+            break;
         }
 
-        startAudioLength = u32AudioLength;
-        startAudioPlay   = data;
-        loop             = 1;
-
-        /* Chop into 512KB chunks so the DMA can handle it. */
-        if (u32AudioLength > PCM_AMP_DMA_CHUNK_SIZE)
+        if (pending)
         {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = pu8AudioPlay;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+            item  = &s_AmpRing[s_AmpRingCursor];
+            chunk = item->length - item->offset;
+            chunk = (chunk > PCM_AMP_DMA_CHUNK_SIZE) ? PCM_AMP_DMA_CHUNK_SIZE : chunk;
+            first = (0 == item->offset) && !(item->flags & kAmpWriteStarted);
+            last  = ((item->offset + chunk) == item->length) && !(item->flags & kAmpWriteLoop);
+
+            if (kStatus_Success != SLN_AMP_SubmitChunk(s_AmpRingCursor, item->data + item->offset, chunk, first, last,
+                                                       (item->flags & kAmpWriteCountPool)))
+            {
+                configPRINTF(("Failed to send amplifier data!\r\n"));
+                break;
+            }
 
-            pu8AudioPlay += PCM_AMP_DMA_CHUNK_SIZE;
-            u32AudioLength -= PCM_AMP_DMA_CHUNK_SIZE;
+            /* Data came back before the silence ran out, the producer was late */
+            if (s_AmpSilenceChunks)
+            {
+                s_AmpStats.gaps++;
+                s_AmpSilenceChunks = 0;
+            }
+            s_AmpPlaying = true;
 
-            /* Clear all the bits before creating the task */
-            xEventGroupClearBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT | PCM_AMP_AUDIO_ABORT_EVT_BIT);
+            item->flags |= kAmpWriteStarted;
+            item->offset += chunk;
 
-            if (xTaskCreate(audio_send_task, AMPLIFIER_SEND_TASK_NAME, AMPLIFIER_SEND_TASK_STACK_SIZE, NULL,
-                            AMPLIFIER_SEND_TASK_PRIORITY, &s_AmplifierSendTaskHandle) == pdPASS)
+            if (item->offset == item->length)
             {
-                eAmpStatus = 0;
+                if (item->flags & kAmpWriteLoop)
+                {
+                    item->offset = 0;
+                }
+                else
+                {
+                    taskENTER_CRITICAL();
+                    s_AmpRingCursor = (s_AmpRingCursor + 1) % AMP_WRITE_RING_SIZE;
+                    s_AmpRingPending--;
+                    taskEXIT_CRITICAL();
+                }
             }
-            else
+        }
+        else if (s_AmpPlaying && (inflight <= 1) && (s_AmpSilenceChunks < AMP_SILENCE_MAX_CHUNKS))
+        {
+            /* Queue silence just in time, so new data never waits behind more than one silence chunk */
+            if (kStatus_Success != SLN_AMP_SubmitChunk(AMP_INFLIGHT_SILENCE, s_AmpSilence, sizeof(s_AmpSilence), false,
+                                                       false, false))
             {
-                configPRINTF(("Failed to create amplifier_send_task for SLN_AMP_WriteLoop!\r\n"));
+                break;
             }
+
+            s_AmpSilenceChunks++;
+            s_AmpStats.silenceChunks++;
         }
         else
         {
-            write_xfer.dataSize = u32AudioLength;
-            write_xfer.data     = pu8AudioPlay;
+            if ((0 == inflight) && (s_AmpSilenceChunks >= AMP_SILENCE_MAX_CHUNKS))
+            {
+                /* Playback is over */
+                s_AmpPlaying       = false;
+                s_AmpSilenceChunks = 0;
+            }
+            break;
+        }
+    }
+}
 
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+/*!
+ * @brief Stops the SAI and drops every buffer in the ring
+ */
+static void SLN_AMP_FlushWrites(void)
+{
+    uint32_t count = 0;
 
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+    SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Amplifier, 0U);
 
-            u32AudioLength = 0;
-            pu8AudioPlay   = NULL;
+    /* Buffers that finished playing already gave their pool slot back in the TX callback */
+    SLN_AMP_ProcessCompleted();
 
-            eAmpStatus = 0;
+    taskENTER_CRITICAL();
+    s_AmpInflightSubmit    = 0;
+    s_AmpInflightDone      = 0;
+    s_AmpInflightProcessed = 0;
+    count                  = s_AmpRingCount;
+    taskEXIT_CRITICAL();
+
+    while (count--)
+    {
+        /* The TX callback will never complete these, give their pool slot back here */
+        if ((s_AmpRing[s_AmpRingTail].flags & kAmpWriteCountPool) && (pu8BufferPool != NULL))
+        {
+            taskENTER_CRITICAL();
+            (*pu8BufferPool)++;
+            taskEXIT_CRITICAL();
+
+            if (NULL != s_AmpPoolSemaphore)
+            {
+                xSemaphoreGive(s_AmpPoolSemaphore);
+            }
         }
+
+        SLN_AMP_ReleaseWrite(kStatus_Fail);
     }
-    return eAmpStatus;
+
+    /* Buffers queued while flushing are played */
+    taskENTER_CRITICAL();
+    s_AmpRingCursor  = s_AmpRingTail;
+    s_AmpRingPending = s_AmpRingCount;
+    taskEXIT_CRITICAL();
+
+    s_AmpPlaying       = false;
+    s_AmpSilenceChunks = 0;
 }
 
-amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length)
+static void SLN_AMP_Task(void *pvParameters)
 {
-    uint32_t total_len;
-    uint8_t *ptr              = data;
-    sai_transfer_t write_xfer = {0};
-    status_t ret              = 0;
+    EventBits_t events;
 
-    if (length)
-    {
-        total_len = length - (length % 32);
-    }
-    else
+    while (1)
     {
-        total_len = length;
-    }
-
-    /* Chop into 512KB chunks so the DMA can handle it. */
-    write_xfer.dataSize = total_len;
-    write_xfer.data     = ptr;
-
-#if USE_TFA
-    ret = SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+        events = xEventGroupWaitBits(s_DmaTxComplete,
+                                     PCM_AMP_DMA_TX_COMPLETE_EVT_BIT | PCM_AMP_AUDIO_ABORT_EVT_BIT | PCM_AMP_WRITE_EVT_BIT,
+                                     pdTRUE, pdFALSE, portMAX_DELAY);
 
-#elif USE_MQS
-    SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-    ret = SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+        if (events & PCM_AMP_AUDIO_ABORT_EVT_BIT)
+        {
+            SLN_AMP_FlushWrites();
+            xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_ABORT_DONE_EVT_BIT);
+        }
 
-    return ret;
+        SLN_AMP_ProcessCompleted();
+        SLN_AMP_Refill();
+    }
 }
 
-amplifier_status_t SLN_AMP_WriteBlocking(uint8_t *data, uint32_t length)
+static amplifier_status_t SLN_AMP_Enqueue(
+    uint8_t *data, uint32_t length, uint32_t flags, amp_write_callback_t callback, void *arg)
 {
-    uint32_t total_len;
-    uint8_t *ptr              = data;
-    sai_transfer_t write_xfer = {0};
+    amplifier_status_t ret = kStatus_Success;
+    amp_write_desc_t *item = NULL;
 
+    /* Ensure write size is a multiple of 32, otherwise EDMA will assert failure */
     if (length)
     {
-        total_len = length - (length % 32);
+        length = length - (length % 32);
     }
-    else
+
+    if ((NULL == data) || (0 == length) || (NULL == s_AmpTaskHandle))
     {
-        total_len = length;
+        ret = kStatus_InvalidArgument;
     }
 
-    /* Chop into 512KB chunks so the DMA can handle it. */
-    while (total_len)
+    if (kStatus_Success == ret)
     {
-        if (total_len > PCM_AMP_DMA_CHUNK_SIZE)
+        taskENTER_CRITICAL();
+        if ((flags & kAmpWriteExclusive) && s_AmpRingExclusive)
         {
-            write_xfer.dataSize = PCM_AMP_DMA_CHUNK_SIZE;
-            write_xfer.data     = ptr;
-
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
-
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
-
-            ptr += PCM_AMP_DMA_CHUNK_SIZE;
-            total_len -= PCM_AMP_DMA_CHUNK_SIZE;
+            /* The previous SLN_AMP_Write or SLN_AMP_WriteLoop is still playing */
+            ret = kStatus_Fail;
+        }
+        else if (s_AmpRingCount < AMP_WRITE_RING_SIZE)
+        {
+            item              = &s_AmpRing[s_AmpRingHead];
+            item->data        = data;
+            item->length      = length;
+            item->offset      = 0;
+            item->flags       = flags;
+            item->enqueueTick = xTaskGetTickCount();
+            item->callback    = callback;
+            item->arg         = arg;
+
+            s_AmpRingHead = (s_AmpRingHead + 1) % AMP_WRITE_RING_SIZE;
+            s_AmpRingCount++;
+            s_AmpRingPending++;
+            if (flags & kAmpWriteExclusive)
+            {
+                s_AmpRingExclusive++;
+            }
         }
         else
         {
-            write_xfer.dataSize = total_len;
-            write_xfer.data     = ptr;
+            ret = kStatus_SAI_QueueFull;
+        }
+        taskEXIT_CRITICAL();
+    }
 
-#if USE_TFA
-            SAI_TransferSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler, &write_xfer);
+    if (kStatus_Success == ret)
+    {
+        xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_WRITE_EVT_BIT);
+    }
 
-#elif USE_MQS
-            SLN_AMP_VolAndDiffInputControl(write_xfer.data, write_xfer.dataSize);
-            SLN_AMP_RxCallback(write_xfer.data, write_xfer.dataSize, &write_xfer);
-#endif /* USE_TFA */
+    return ret;
+}
+
+amplifier_status_t SLN_AMP_WriteAsync(uint8_t *data, uint32_t length, amp_write_callback_t callback, void *arg)
+{
+    return SLN_AMP_Enqueue(data, length, 0, callback, arg);
+}
+
+amplifier_status_t SLN_AMP_Write(uint8_t *data, uint32_t length)
+{
+    return SLN_AMP_Enqueue(data, length, kAmpWriteExclusive, NULL, NULL);
+}
+
+amplifier_status_t SLN_AMP_WriteLoop(uint8_t *data, uint32_t length)
+{
+    return SLN_AMP_Enqueue(data, length, kAmpWriteLoop | kAmpWriteExclusive, NULL, NULL);
+}
+
+amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length)
+{
+    return SLN_AMP_Enqueue(data, length, kAmpWriteCountPool, NULL, NULL);
+}
 
-            total_len = 0;
+static void SLN_AMP_WriteBlockingDone(uint8_t *data, uint32_t length, amplifier_status_t status, void *arg)
+{
+    *(amplifier_status_t *)arg = status;
+    xSemaphoreGive(s_AmpBlockingDone);
+}
+
+amplifier_status_t SLN_AMP_WriteBlocking(uint8_t *data, uint32_t length)
+{
+    amplifier_status_t ret    = kStatus_Success;
+    amplifier_status_t played = kStatus_Success;
+
+    if (length >= 32)
+    {
+        xSemaphoreTake(s_AmpBlockingMutex, portMAX_DELAY);
+
+        ret = SLN_AMP_Enqueue(data, length, 0, SLN_AMP_WriteBlockingDone, &played);
+        if (kStatus_Success == ret)
+        {
+            xSemaphoreTake(s_AmpBlockingDone, portMAX_DELAY);
+            ret = played;
         }
 
-        xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, pdTRUE, pdTRUE, portMAX_DELAY);
+        xSemaphoreGive(s_AmpBlockingMutex);
     }
 
-    return 0;
+    return ret;
 }
 
 amplifier_status_t SLN_AMP_AbortWrite(void)
@@ -742,6 +930,16 @@ amplifier_status_t SLN_AMP_AbortWrite(void)
     return 0;
 }
 
+void SLN_AMP_GetStats(amp_stats_t *stats)
+{
+    if (NULL != stats)
+    {
+        taskENTER_CRITICAL();
+        *stats = s_AmpStats;
+        taskEXIT_CRITICAL();
+    }
+}
+
 amplifier_status_t SLN_AMP_Read(void)
 {
 #if USE_TFA
@@ -804,6 +1002,20 @@ amplifier_status_t SLN_AMP_Init(volatile uint8_t *pu8BuffNum)
 
     xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_DMA_TX_COMPLETE_EVT_BIT, pdTRUE, pdTRUE, portMAX_DELAY);
 
+    s_AmpBlockingMutex = xSemaphoreCreateMutex();
+    s_AmpBlockingDone  = xSemaphoreCreateBinary();
+    if ((s_AmpBlockingMutex == NULL) || (s_AmpBlockingDone == NULL))
+    {
+        configPRINTF(("Failed to create amplifier write semaphores\r\n"));
+    }
+
+    if (xTaskCreate(SLN_AMP_Task, AMPLIFIER_TASK_NAME, AMPLIFIER_TASK_STACK_SIZE, NULL, AMPLIFIER_TASK_PRIORITY,
+                    &s_AmpTaskHandle) != pdPASS)
+    {
+        configPRINTF(("Failed to create amplifier_task!\r\n"));
+        s_AmpTaskHandle = NULL;
+    }
+
     ret = CODEC_Init(&codecHandle, (codec_config_t *)BOARD_GetBoardCodecConfig());
 
 #if USE_MQS
@@ -880,6 +1092,11 @@ void SLN_AMP_SetVolume(uint8_t volume)
     CODEC_SetVolume(&codecHandle, kCODEC_PlayChannelLeft0 | kCODEC_PlayChannelRight0, (uint32_t)volume);
 }
 
+void SLN_AMP_SetBufferPoolSemaphore(SemaphoreHandle_t semaphore)
+{
+    s_AmpPoolSemaphore = semaphore;
+}
+
 void *SLN_AMP_GetAmpTxHandler()
 {
     return &s_AmpTxHandler;
@@ -887,8 +1104,17 @@ void *SLN_AMP_GetAmpTxHandler()
 
 void SLN_AMP_Abort(void)
 {
-    /* Stop playback. This will flush the SAI transmit buffers. */
-    SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, &s_AmpTxHandler);
+    /* Stop playback. This will flush the SAI transmit buffers and the write ring. */
+    if ((NULL == s_AmpTaskHandle) || (xTaskGetCurrentTaskHandle() == s_AmpTaskHandle))
+    {
+        SLN_AMP_FlushWrites();
+    }
+    else
+    {
+        xEventGroupClearBits(s_DmaTxComplete, PCM_AMP_ABORT_DONE_EVT_BIT);
+        xEventGroupSetBits(s_DmaTxComplete, PCM_AMP_AUDIO_ABORT_EVT_BIT);
+        xEventGroupWaitBits(s_DmaTxComplete, PCM_AMP_ABORT_DONE_EVT_BIT, pdTRUE, pdTRUE, portMAX_DELAY);
+    }
 }
 
 void SLN_AMP_LoopbackEnable(void)
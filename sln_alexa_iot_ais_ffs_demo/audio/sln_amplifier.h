@@ -13,9 +13,9 @@
 #include "event_groups.h"
 #include "fsl_common.h"
 #include "fsl_edma.h"
+#include "semphr.h"
 
 #if USE_MQS
-#include "semphr.h"
 #include "ringbuffer.h"
 #endif
 
@@ -30,6 +30,20 @@ typedef int32_t amplifier_status_t;
 typedef void (*amp_get_cal_callback_t)(uint8_t *state);
 typedef void (*amp_set_cal_callback_t)(uint8_t state);
 
+/*! @brief Called from the amplifier task once a buffer was played (kStatus_Success)
+ *         or dropped by an abort (kStatus_Fail). Keep it short, the amplifier task feeds the SAI */
+typedef void (*amp_write_callback_t)(uint8_t *data, uint32_t length, amplifier_status_t status, void *arg);
+
+/*! @brief Amplifier playback statistics */
+typedef struct _amp_stats
+{
+    uint32_t writes;        /*!< Buffers played */
+    uint32_t gaps;          /*!< Times the write ring ran empty in the middle of a playback */
+    uint32_t silenceChunks; /*!< Silence chunks played while the write ring was empty */
+    uint32_t lastLatencyMs; /*!< Enqueue to play start latency of the last buffer */
+    uint32_t maxLatencyMs;  /*!< Highest enqueue to play start latency */
+} amp_stats_t;
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -55,31 +69,47 @@ amplifier_status_t SLN_AMP_Init(volatile uint8_t *pu8BuffNum);
  */
 amplifier_status_t SLN_AMP_Read(void);
 
+/**
+ * @brief Queues data for the amplifier task
+ * The amplifier task sends the queued buffers in order and keeps the SAI eDMA queue filled,
+ * playing silence when the queue runs empty in the middle of a playback.
+ * The buffer must stay valid until the callback was called.
+ *
+ * @param data                  Pointer to the data that will be sent over the DMA
+ * @param length                The length of the data, rounded down to a multiple of 32
+ * @param callback              Called once the buffer was played or aborted, can be NULL
+ * @param arg                   Argument passed to the callback
+ * @return amplifier_status_t   0 if success, kStatus_SAI_QueueFull if the write queue is full
+ */
+amplifier_status_t SLN_AMP_WriteAsync(uint8_t *data, uint32_t length, amp_write_callback_t callback, void *arg);
+
 /**
  * @brief Writes the data to the amplifier
- * The data is chop into 512KB chunks and sent to the SAI interface
+ * The data is queued for the amplifier task, which sends it to the SAI interface in chunks.
+ * Only one SLN_AMP_Write or SLN_AMP_WriteLoop buffer is queued at a time, use SLN_AMP_WriteAsync
+ * to queue buffers back to back.
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
- * @return amplifier_status_t   0 if success
+ * @return amplifier_status_t   0 if success, 1 if the previous SLN_AMP_Write or SLN_AMP_WriteLoop is still playing
  */
 amplifier_status_t SLN_AMP_Write(uint8_t *data, uint32_t length);
 
 /**
  * @brief Writes the data to the amplifier in a loop
- * The data will be written by the function and then by the audio_send_task in a loop
+ * The data will be written by the amplifier task in a loop
  * until we call SLN_AMP_AbortWrite
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
- * @return amplifier_status_t   0 if success
+ * @return amplifier_status_t   0 if success, 1 if the previous SLN_AMP_Write or SLN_AMP_WriteLoop is still playing
  */
 amplifier_status_t SLN_AMP_WriteLoop(uint8_t *data, uint32_t length);
 
 /**
  * @brief Writes data to the amplifier
- * This functions sends the data in one chunk to the SAI interfce without waiting
- * for the amplifier TX callback
+ * This functions queues the data without waiting for it to be played.
+ * The buffer pool passed to SLN_AMP_Init is incremented once the data was played
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
@@ -89,9 +119,8 @@ amplifier_status_t SLN_AMP_WriteNoWait(uint8_t *data, uint32_t length);
 
 /**
  * @brief Writes data to the amplifier
- * This function is blocking meaning it waits, after each SAI send, for the
- * g_dmaTxComplete to be cleared by the amplifier TX callback. The data is sent
- * in 512KB chunks
+ * This function is blocking meaning it waits until the amplifier task played
+ * all the data
  *
  * @param data                  Pointer to the data that will be sent over the DMA
  * @param length                The length of the data
@@ -180,6 +209,14 @@ void SLN_AMP_UpdateTimestamp(uint32_t timestamp);
  */
 void SLN_AMP_SetVolume(uint8_t volume);
 
+/**
+ * @brief Sets a semaphore given from the TX interrupt each time a SLN_AMP_WriteNoWait buffer
+ * was played, along with the increment of the buffer pool passed to SLN_AMP_Init
+ *
+ * @param semaphore     Counting semaphore, NULL to stop giving it
+ */
+void SLN_AMP_SetBufferPoolSemaphore(SemaphoreHandle_t semaphore);
+
 /**
  * @brief Gets the amplifier TX handler
  *
@@ -189,11 +226,19 @@ void *SLN_AMP_GetAmpTxHandler();
 
 /**
  * @brief Abort the amplifier
+ * Stops the SAI transfer and drops all the queued data, returns once this is done
  *
  * @return void
  */
 void SLN_AMP_Abort(void);
 
+/**
+ * @brief Gets the amplifier playback statistics
+ *
+ * @param stats         Filled with the statistics gathered since boot
+ */
+void SLN_AMP_GetStats(amp_stats_t *stats);
+
 /**
  * @brief Enables the AMP loopback mechanism
  *
@@ -154,6 +154,14 @@
 #define AIA_SMART_HOME_UNCERTAINTY_IN_MS (1)
 #define AIA_SMART_HOME_TIME_BUFFER_SIZE (21)
 
+/*! @brief Brightness is a percentage, a directive out of range is refused */
+#define AIA_SMART_HOME_BRIGHTNESS_MAX (100)
+
+/*! @brief Shortest interval between two ChangeReports of an endpoint, the changes in between are merged */
+#ifndef AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS
+#define AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS (1000U)
+#endif
+
 typedef enum
 {
     AIS_CRYPT_ENCRYPT,
@@ -464,6 +472,9 @@ typedef struct
     ais_avs_range_controller_t *rangeController;
     ais_avs_toggle_controller_t *toggleController;
     ais_avs_mode_controller_t *modeController;
+    uint32_t changedMask;  /* Capabilities to report, one bit per ais_smart_home_controller_type_t */
+    TickType_t lastReport; /* Tick of the last ChangeReport */
+    bool reported;         /* lastReport is valid */
 } ais_avs_smart_home_endpoint_t;
 
 typedef struct {
@@ -551,10 +562,21 @@ typedef struct
 {
     ais_smart_home_controller_type_t controller_type; /* Type as defined in ais_smart_home_controller_type */
     uint32_t controller_directive_type; /* Controller type for example ais_smart_home_power_controller_type */
-    aia_smart_home_response_payload_t *response; /* Parameters for the response that needs to be sent back */
     ais_avs_smart_home_endpoint_t *endpoint; /* Pointer to the endpoint the message is associated with */
 } aia_smart_home_queue_payload_t;
 
+/*! @brief Smart Home directive, parsed once before the dispatch. The strings point in the received JSON. */
+typedef struct _aia_smart_home_directive
+{
+    const char *name_space;
+    const char *name;
+    const char *messageId;
+    const char *correlationToken;            /* NULL if the directive has none */
+    const char *endpointId;                  /* NULL if the directive has no endpoint */
+    cJSON *payload;                          /* directive.payload object, NULL if absent */
+    ais_avs_smart_home_endpoint_t *endpoint; /* Endpoint matching endpointId, NULL if unknown */
+} aia_smart_home_directive_t;
+
 
 /*! @brief AIS interface structure */
 typedef struct _ais_handle_t
@@ -621,6 +643,12 @@ typedef struct _ais_handle_t
 
 typedef bool (*ais_process_func_t)(ais_handle_t *handle, const char *data, uint32_t length);
 
+/*! @brief Handler of one (namespace, name) Smart Home directive.
+ *  Fills response->context.json when the directive is answered with a Response event. */
+typedef status_t (*aia_smart_home_directive_handler_t)(ais_handle_t *handle,
+                                                       const aia_smart_home_directive_t *directive,
+                                                       aia_smart_home_response_payload_t *response);
+
 /*******************************************************************************
  * API
  ******************************************************************************/
@@ -1582,64 +1610,178 @@ bool AIS_TimeoutCheck(TickType_t savedTick, uint32_t timeout);
 status_t AIA_AlexaSmartHomeInit(ais_handle_t *handle);
 
 /*!
- * @brief Sends the JSON payload to the Handler to process
+ * @brief Parses the header of an EndpointForwarding directive and calls the handler
+ *        registered for its (namespace, name)
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param payload Incoming message from the service to process
+ * @param message Incoming message from the service to process
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomeHandler(ais_handle_t *handle, cJSON *payload);
+status_t AIA_AlexaSmartHomeDispatch(ais_handle_t *handle, cJSON *message);
 
 /*!
- * @brief Sends the JSON payload to the Power Controller Handler to process
+ * @brief Queues a Smart Home directive to the application callbacks
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param message Incoming message from the service to process
+ * @param controller_type Controller the directive belongs to
+ * @param directive_type Directive type of the controller, for example ais_smart_home_power_controller_type_t
+ * @param endpoint Pointer to the endpoint the directive is associated with
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomePowerControllerHandler(ais_handle_t *handle, cJSON *message);
+status_t AIA_SmartHomeQueueDirective(ais_handle_t *handle,
+                                     ais_smart_home_controller_type_t controller_type,
+                                     uint32_t directive_type,
+                                     ais_avs_smart_home_endpoint_t *endpoint);
 
 /*!
- * @brief Sends the JSON payload to the Mode Controller Handler to process
+ * @brief Notes a change of the endpoint state that was not requested by a directive, for example
+ *        from a button. The ChangeReport is sent from the smart home task with the state copied under
+ *        the smart home lock when the window ends, at most once per AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS
+ *        per endpoint, and holds every capability changed in the window. Directive Responses are
+ *        never delayed or merged, they keep their correlationToken. The controller SetState functions
+ *        call it, use them to change the state of an endpoint.
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param message Incoming message from the service to process
+ * @param endpoint Pointer to the endpoint whose state changed
+ * @param controller_type Capability that changed
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomeModeControllerHandler(ais_handle_t *handle, cJSON *message);
+status_t AIA_AlexaSmartHomeReportChange(ais_handle_t *handle,
+                                        ais_avs_smart_home_endpoint_t *endpoint,
+                                        ais_smart_home_controller_type_t controller_type);
 
 /*!
- * @brief Sends the JSON payload to the Range Controller Handler to process
+ * @brief Handles the Alexa.PowerController TurnOn directive
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param message Incoming message from the service to process
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomeRangeControllerHandler(ais_handle_t *handle, cJSON *message);
+status_t AIA_AlexaSmartHomePowerControllerTurnOn(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response);
 
 /*!
- * @brief Sends the JSON payload to the Toggle Controller Handler to process
+ * @brief Handles the Alexa.PowerController TurnOff directive
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param message Incoming message from the service to process
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomePowerControllerTurnOff(ais_handle_t *handle,
+                                                  const aia_smart_home_directive_t *directive,
+                                                  aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.ToggleController TurnOn directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeToggleControllerTurnOn(ais_handle_t *handle,
+                                                  const aia_smart_home_directive_t *directive,
+                                                  aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.ToggleController TurnOff directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomeToggleControllerHandler(ais_handle_t *handle, cJSON *message);
+status_t AIA_AlexaSmartHomeToggleControllerTurnOff(ais_handle_t *handle,
+                                                   const aia_smart_home_directive_t *directive,
+                                                   aia_smart_home_response_payload_t *response);
 
 /*!
- * @brief Sends the JSON payload to the Brightness Controller Handler to process
+ * @brief Handles the Alexa.RangeController SetRangeValue directive
  *
  * @param handle Pointer to AIS interface handle that will be initialized
- * @param json Incoming message from the service to process
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
  *
  * @return Success or failure
  */
-status_t AIA_AlexaSmartHomeBrightnessControllerHandler(ais_handle_t *handle, cJSON *json);
+status_t AIA_AlexaSmartHomeRangeControllerSetRangeValue(ais_handle_t *handle,
+                                                        const aia_smart_home_directive_t *directive,
+                                                        aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.RangeController AdjustRangeValue directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeRangeControllerAdjustRangeValue(ais_handle_t *handle,
+                                                           const aia_smart_home_directive_t *directive,
+                                                           aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.ModeController SetMode directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeModeControllerSetMode(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.ModeController AdjustMode directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeModeControllerAdjustMode(ais_handle_t *handle,
+                                                    const aia_smart_home_directive_t *directive,
+                                                    aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.BrightnessController SetBrightness directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeBrightnessControllerSetBrightness(ais_handle_t *handle,
+                                                             const aia_smart_home_directive_t *directive,
+                                                             aia_smart_home_response_payload_t *response);
+
+/*!
+ * @brief Handles the Alexa.BrightnessController AdjustBrightness directive
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param directive Parsed directive
+ * @param response Response to fill with the context
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness(ais_handle_t *handle,
+                                                                const aia_smart_home_directive_t *directive,
+                                                                aia_smart_home_response_payload_t *response);
 
 /*!
  * @brief Creates the context entry for Brightness Controller
@@ -1696,6 +1838,71 @@ cJSON *AIA_AlexaSmartHomeRangeControllerCreateResponseContext(ais_handle_t *hand
 cJSON *AIA_AlexaSmartHomeToggleControllerCreateResponseContext(ais_handle_t *handle,
                                                                ais_avs_smart_home_endpoint_t *endpoint);
 
+/*!
+ * @brief Sets the brightness of the Brightness Controller outside of a directive and reports the change
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param endpoint Pointer to the endpoint for the controller to reference
+ * @param brightness New brightness as a percentage
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeBrightnessControllerSetState(ais_handle_t *handle,
+                                                        ais_avs_smart_home_endpoint_t *endpoint,
+                                                        uint32_t brightness);
+
+/*!
+ * @brief Sets the mode of the Mode Controller outside of a directive and reports the change
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param endpoint Pointer to the endpoint for the controller to reference
+ * @param mode New mode
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeModeControllerSetState(ais_handle_t *handle,
+                                                  ais_avs_smart_home_endpoint_t *endpoint,
+                                                  uint32_t mode);
+
+/*!
+ * @brief Sets the power state of the Power Controller outside of a directive and reports the change
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param endpoint Pointer to the endpoint for the controller to reference
+ * @param on true to turn the power on
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomePowerControllerSetState(ais_handle_t *handle,
+                                                   ais_avs_smart_home_endpoint_t *endpoint,
+                                                   bool on);
+
+/*!
+ * @brief Sets the range value of the Range Controller outside of a directive and reports the change
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param endpoint Pointer to the endpoint for the controller to reference
+ * @param range New range value
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeRangeControllerSetState(ais_handle_t *handle,
+                                                   ais_avs_smart_home_endpoint_t *endpoint,
+                                                   uint32_t range);
+
+/*!
+ * @brief Sets the toggle state of the Toggle Controller outside of a directive and reports the change
+ *
+ * @param handle Pointer to AIS interface handle that will be initialized
+ * @param endpoint Pointer to the endpoint for the controller to reference
+ * @param on true to turn the toggle on
+ *
+ * @return Success or failure
+ */
+status_t AIA_AlexaSmartHomeToggleControllerSetState(ais_handle_t *handle,
+                                                    ais_avs_smart_home_endpoint_t *endpoint,
+                                                    bool on);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -17,79 +17,6 @@
 
 #include "mbedtls/base64.h"
 
-/*******************************************************************************
- * Prototypes
- ******************************************************************************/
-static cJSON *AIA_AlexaSmartHomeBrightnessControllerSetBrightness(ais_handle_t *handle,
-                                                                  cJSON *payload,
-                                                                  aia_smart_home_response_payload_t *response,
-                                                                  ais_avs_smart_home_endpoint_t *endpoint);
-static cJSON *AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness(ais_handle_t *handle,
-                                                                     cJSON *payload,
-                                                                     aia_smart_home_response_payload_t *response,
-                                                                     ais_avs_smart_home_endpoint_t *endpoint);
-
-/*******************************************************************************
- * Definitions
- ******************************************************************************/
-
-/*******************************************************************************
- * Variables
- ******************************************************************************/
-
-status_t AIA_AlexaSmartHomeBrightnessControllerHandler(ais_handle_t *handle, cJSON *json)
-{
-    cJSON *directive, *name_space, *name, *correlationToken, *endpointId, *endpoint, *payload, *header;
-    aia_smart_home_response_payload_t *response;
-    ais_avs_smart_home_endpoint_t *sh_endpoint;
-    status_t status = kStatus_Fail;
-
-    response = (aia_smart_home_response_payload_t *)pvPortMalloc(sizeof(aia_smart_home_response_payload_t));
-
-    if (response != NULL)
-    {
-        /* Brightness Controller Endpoint Handler */
-        directive        = cJSON_GetObjectItemCaseSensitive(json, "directive");
-        header           = cJSON_GetObjectItemCaseSensitive(directive, "header");
-        name_space       = cJSON_GetObjectItemCaseSensitive(header, "namespace");
-        name             = cJSON_GetObjectItemCaseSensitive(header, "name");
-        correlationToken = cJSON_GetObjectItemCaseSensitive(header, "correlationToken");
-        endpoint         = cJSON_GetObjectItemCaseSensitive(directive, "endpoint");
-        endpointId       = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
-        payload          = cJSON_GetObjectItemCaseSensitive(directive, "payload");
-
-        sh_endpoint = AIA_SmartHomeGetEndpoint(handle, endpointId->valuestring);
-
-        if (sh_endpoint != NULL)
-        {
-            response->correlationToken = correlationToken->valuestring;
-            response->endpointId       = endpointId->valuestring;
-
-            if (strcmp(name->valuestring, "SetBrightness") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeBrightnessControllerSetBrightness(handle, payload, response, sh_endpoint);
-            }
-
-            if (strcmp(name->valuestring, "AdjustBrightness") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness(handle, payload, response, sh_endpoint);
-            }
-
-            status = AIA_AlexaSmartHomeResponse(handle, response);
-        }
-        else
-        {
-            configPRINTF(("[SmartHome] Failed to find matching endpoint %s", endpointId->valuestring));
-        }
-
-        vPortFree(response);
-    }
-
-    return status;
-}
-
 cJSON *AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(ais_handle_t *handle,
                                                                    ais_avs_smart_home_endpoint_t *endpoint)
 {
@@ -120,88 +47,99 @@ cJSON *AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(ais_handle_t
     return response;
 }
 
-static cJSON *AIA_AlexaSmartHomeBrightnessControllerSetBrightness(ais_handle_t *handle,
-                                                                  cJSON *payload,
-                                                                  aia_smart_home_response_payload_t *response,
-                                                                  ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeBrightnessControllerSetBrightness(ais_handle_t *handle,
+                                                             const aia_smart_home_directive_t *directive,
+                                                             aia_smart_home_response_payload_t *response)
 {
-    cJSON *context, *brightnessValue;
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *brightnessValue;
+    status_t status = kStatus_Fail;
 
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    /* Please note, this is still in MQTT Callback context. */
 
-    context = cJSON_CreateArray();
+    brightnessValue = cJSON_GetObjectItemCaseSensitive(directive->payload, "brightness");
 
-    if (payload != NULL)
+    if ((endpoint->brightnessController == NULL) || !cJSON_IsNumber(brightnessValue) ||
+        (brightnessValue->valueint < 0) || (brightnessValue->valueint > AIA_SMART_HOME_BRIGHTNESS_MAX))
+    {
+        configPRINTF(("[SmartHome] Invalid SetBrightness for endpoint %s\r\n", directive->endpointId));
+    }
+    else
     {
-        brightnessValue = cJSON_GetObjectItemCaseSensitive(payload, "brightness");
-
         xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
         endpoint->brightnessController->brightness = brightnessValue->valueint;
         xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_BRIGHTNESS_CONTROLLER,
+                                    AIS_SMART_HOME_BRIGHTNESS_CONTROLLER_SET, endpoint);
+
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, endpoint));
+
+        status = kStatus_Success;
     }
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    return status;
+}
+
+status_t AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness(ais_handle_t *handle,
+                                                                const aia_smart_home_directive_t *directive,
+                                                                aia_smart_home_response_payload_t *response)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *brightnessValueDelta;
+    status_t status = kStatus_Fail;
+
+    /* Please note, this is still in MQTT Callback context. */
+
+    brightnessValueDelta = cJSON_GetObjectItemCaseSensitive(directive->payload, "brightnessDelta");
+
+    if ((endpoint->brightnessController == NULL) || !cJSON_IsNumber(brightnessValueDelta) ||
+        (brightnessValueDelta->valueint < -AIA_SMART_HOME_BRIGHTNESS_MAX) ||
+        (brightnessValueDelta->valueint > AIA_SMART_HOME_BRIGHTNESS_MAX))
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_BRIGHTNESS_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_BRIGHTNESS_CONTROLLER_SET;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        configPRINTF(("[SmartHome] Invalid AdjustBrightness for endpoint %s\r\n", directive->endpointId));
     }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->brightnessController->brightnessDelta = brightnessValueDelta->valueint;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_BRIGHTNESS_CONTROLLER,
+                                    AIS_SMART_HOME_BRIGHTNESS_CONTROLLER_ADJUST, endpoint);
+
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, endpoint));
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, endpoint));
+        status = kStatus_Success;
+    }
 
-    return context;
+    return status;
 }
 
-static cJSON *AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness(ais_handle_t *handle,
-                                                                     cJSON *payload,
-                                                                     aia_smart_home_response_payload_t *response,
-                                                                     ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeBrightnessControllerSetState(ais_handle_t *handle,
+                                                        ais_avs_smart_home_endpoint_t *endpoint,
+                                                        uint32_t brightness)
 {
-    cJSON *context, *brightnessValueDelta;
-
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    bool changed;
 
-    context = cJSON_CreateArray();
+    if ((endpoint == NULL) || (endpoint->brightnessController == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
 
-    brightnessValueDelta = cJSON_GetObjectItemCaseSensitive(payload, "brightnessDelta");
     xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->brightnessController->brightnessDelta = brightnessValueDelta->valueint;
+    changed = (endpoint->brightnessController->brightness != brightness);
+    endpoint->brightnessController->brightness = brightness;
     xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if (!changed)
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_BRIGHTNESS_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_BRIGHTNESS_CONTROLLER_ADJUST;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        return kStatus_Success;
     }
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, endpoint));
-
-    return context;
+    return AIA_AlexaSmartHomeReportChange(handle, endpoint, AIS_SMART_HOME_BRIGHTNESS_CONTROLLER);
 }
@@ -26,6 +26,47 @@
 #define AIA_SMARTHOME_TASK_STACK    1024U
 #define AIA_SMARTHOME_TASK_PRIORITY (configTIMER_TASK_PRIORITY - 3)
 
+/* Slots of the directive hash table, power of two larger than the number of routes */
+#define AIA_SMART_HOME_ROUTE_SLOTS      32U
+#define AIA_SMART_HOME_ROUTE_EMPTY      0xFFU
+#define AIA_SMART_HOME_ROUTE_SEED_MAX   256U
+#define AIA_SMART_HOME_FNV_OFFSET_BASIS 2166136261U
+#define AIA_SMART_HOME_FNV_PRIME        16777619U
+
+/* Directives are handled one at a time from the MQTT callback, one spare for a nested report */
+#define AIA_SMART_HOME_RESPONSE_POOL_SIZE 2U
+
+/* State of an endpoint copied under the smart home lock, the controllers point in the copy */
+typedef struct _aia_smart_home_snapshot
+{
+    ais_avs_smart_home_endpoint_t endpoint;
+    ais_avs_brightness_controller_t brightnessController;
+    ais_avs_power_controller_t powerController;
+    ais_avs_range_controller_t rangeController;
+    ais_avs_toggle_controller_t toggleController;
+    ais_avs_mode_controller_t modeController;
+} aia_smart_home_snapshot_t;
+
+typedef struct _aia_smart_home_route
+{
+    const char *name_space;
+    const char *name;
+    aia_smart_home_directive_handler_t handler;
+    bool sendResponse; /* Send a Response event with the context filled by the handler */
+} aia_smart_home_route_t;
+
+/*******************************************************************************
+ * Prototypes
+ ******************************************************************************/
+static void AIA_SmartHomeTask(void *arg);
+static status_t AIA_AlexaSmartHomeReportState(ais_handle_t *handle,
+                                              const aia_smart_home_directive_t *directive,
+                                              aia_smart_home_response_payload_t *response);
+static status_t AIA_AlexaSmartHomeEventProcessed(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response);
+static status_t AIA_AlexaSmartHomeChangeReport(ais_handle_t *handle, aia_smart_home_response_payload_t *change_report);
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
@@ -34,18 +75,204 @@ __attribute__((section(".ocram_non_cacheable_bss")))
 StackType_t aia_smarthome_task_stack_buffer[AIA_SMARTHOME_TASK_STACK];
 __attribute__((section(".ocram_non_cacheable_bss"))) StaticTask_t aia_smarthome_task_buffer;
 
-/*******************************************************************************
- * Prototypes
- ******************************************************************************/
-static void AIA_SmartHomeTask(void *arg);
-status_t _AIA_SmartHomeHandleReportState(ais_handle_t *handle,
-                                         aia_smart_home_response_payload_t *stateResponse,
-                                         cJSON *payload);
+/* Every directive the device handles, the namespace and name must be unique */
+static const aia_smart_home_route_t s_smartHomeRoutes[] = {
+    {AIA_SMART_HOME_NAMESPACE_ALEXA, "ReportState", AIA_AlexaSmartHomeReportState, false},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA, "EventProcessed", AIA_AlexaSmartHomeEventProcessed, false},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_POWER_CONTROLLER, "TurnOn", AIA_AlexaSmartHomePowerControllerTurnOn, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_POWER_CONTROLLER, "TurnOff", AIA_AlexaSmartHomePowerControllerTurnOff, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_TOGGLE_CONTROLLER, "TurnOn", AIA_AlexaSmartHomeToggleControllerTurnOn, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_TOGGLE_CONTROLLER, "TurnOff", AIA_AlexaSmartHomeToggleControllerTurnOff, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_RANGE_CONTROLLER, "SetRangeValue", AIA_AlexaSmartHomeRangeControllerSetRangeValue,
+     true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_RANGE_CONTROLLER, "AdjustRangeValue",
+     AIA_AlexaSmartHomeRangeControllerAdjustRangeValue, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_MODE_CONTROLLER, "SetMode", AIA_AlexaSmartHomeModeControllerSetMode, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_MODE_CONTROLLER, "AdjustMode", AIA_AlexaSmartHomeModeControllerAdjustMode, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_BRIGHTNESS_CONTROLLER, "SetBrightness",
+     AIA_AlexaSmartHomeBrightnessControllerSetBrightness, true},
+    {AIA_SMART_HOME_NAMESPACE_ALEXA_BRIGHTNESS_CONTROLLER, "AdjustBrightness",
+     AIA_AlexaSmartHomeBrightnessControllerAdjustBrightness, true},
+};
+
+#define AIA_SMART_HOME_ROUTE_NUM (sizeof(s_smartHomeRoutes) / sizeof(s_smartHomeRoutes[0]))
+
+/* Index in s_smartHomeRoutes of every hash slot, filled once by AIA_SmartHomeBuildRoutes */
+static uint8_t s_routeSlots[AIA_SMART_HOME_ROUTE_SLOTS];
+static uint32_t s_routeSeed;
+static bool s_routesPerfect = false;
+
+static aia_smart_home_response_payload_t s_responsePool[AIA_SMART_HOME_RESPONSE_POOL_SIZE];
+static bool s_responseInUse[AIA_SMART_HOME_RESPONSE_POOL_SIZE];
+
+/* Queued to wake the smart home task when a ChangeReport becomes pending, never freed */
+static aia_smart_home_queue_payload_t s_changeReportWakeup;
 
 /*******************************************************************************
  * Code
  *******************************************************************************/
 
+static uint32_t AIA_SmartHomeRouteHash(uint32_t seed, const char *name_space, const char *name)
+{
+    uint32_t hash = AIA_SMART_HOME_FNV_OFFSET_BASIS ^ seed;
+
+    while (*name_space != '\0')
+    {
+        hash = (hash ^ (uint8_t)*name_space++) * AIA_SMART_HOME_FNV_PRIME;
+    }
+
+    /* Separator, so that the split between namespace and name is part of the key */
+    hash = (hash ^ (uint8_t)'.') * AIA_SMART_HOME_FNV_PRIME;
+
+    while (*name != '\0')
+    {
+        hash = (hash ^ (uint8_t)*name++) * AIA_SMART_HOME_FNV_PRIME;
+    }
+
+    return (hash ^ (hash >> 16)) & (AIA_SMART_HOME_ROUTE_SLOTS - 1U);
+}
+
+/* Look for the first seed that puts every route in its own slot, the lookup is then one hash and one compare */
+static void AIA_SmartHomeBuildRoutes(void)
+{
+    uint32_t seed;
+    uint32_t route;
+    uint32_t slot;
+
+    for (seed = 0; (seed < AIA_SMART_HOME_ROUTE_SEED_MAX) && !s_routesPerfect; seed++)
+    {
+        memset(s_routeSlots, AIA_SMART_HOME_ROUTE_EMPTY, sizeof(s_routeSlots));
+
+        for (route = 0; route < AIA_SMART_HOME_ROUTE_NUM; route++)
+        {
+            slot = AIA_SmartHomeRouteHash(seed, s_smartHomeRoutes[route].name_space, s_smartHomeRoutes[route].name);
+            if (s_routeSlots[slot] != AIA_SMART_HOME_ROUTE_EMPTY)
+            {
+                break;
+            }
+            s_routeSlots[slot] = (uint8_t)route;
+        }
+
+        if (route == AIA_SMART_HOME_ROUTE_NUM)
+        {
+            s_routeSeed     = seed;
+            s_routesPerfect = true;
+        }
+    }
+
+    if (!s_routesPerfect)
+    {
+        configPRINTF(("[SmartHome] No perfect hash for the directive table, using a linear search\r\n"));
+    }
+}
+
+static const aia_smart_home_route_t *AIA_SmartHomeFindRoute(const char *name_space, const char *name)
+{
+    const aia_smart_home_route_t *route = NULL;
+    uint32_t idx;
+
+    if (s_routesPerfect)
+    {
+        idx = s_routeSlots[AIA_SmartHomeRouteHash(s_routeSeed, name_space, name)];
+        if ((idx != AIA_SMART_HOME_ROUTE_EMPTY) && (0 == strcmp(s_smartHomeRoutes[idx].name, name)) &&
+            (0 == strcmp(s_smartHomeRoutes[idx].name_space, name_space)))
+        {
+            route = &s_smartHomeRoutes[idx];
+        }
+    }
+    else
+    {
+        for (idx = 0; idx < AIA_SMART_HOME_ROUTE_NUM; idx++)
+        {
+            if ((0 == strcmp(s_smartHomeRoutes[idx].name, name)) &&
+                (0 == strcmp(s_smartHomeRoutes[idx].name_space, name_space)))
+            {
+                route = &s_smartHomeRoutes[idx];
+                break;
+            }
+        }
+    }
+
+    return route;
+}
+
+static aia_smart_home_response_payload_t *AIA_SmartHomeResponseAlloc(void)
+{
+    aia_smart_home_response_payload_t *response = NULL;
+    uint32_t idx;
+
+    taskENTER_CRITICAL();
+    for (idx = 0; idx < AIA_SMART_HOME_RESPONSE_POOL_SIZE; idx++)
+    {
+        if (!s_responseInUse[idx])
+        {
+            s_responseInUse[idx] = true;
+            response             = &s_responsePool[idx];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (response != NULL)
+    {
+        memset(response, 0, sizeof(aia_smart_home_response_payload_t));
+    }
+
+    return response;
+}
+
+static void AIA_SmartHomeResponseFree(aia_smart_home_response_payload_t *response)
+{
+    taskENTER_CRITICAL();
+    s_responseInUse[response - s_responsePool] = false;
+    taskEXIT_CRITICAL();
+}
+
+static const char *AIA_SmartHomeGetString(cJSON *object, const char *key)
+{
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(object, key);
+
+    return (cJSON_IsString(item) && (item->valuestring != NULL)) ? item->valuestring : NULL;
+}
+
+/* Fill the directive from the EndpointForwarding payload, the optional fields are left NULL */
+static status_t AIA_SmartHomeParseDirective(ais_handle_t *handle, cJSON *message, aia_smart_home_directive_t *directive)
+{
+    cJSON *directiveJson, *header, *endpoint, *payload;
+    status_t status = kStatus_InvalidArgument;
+
+    memset(directive, 0, sizeof(aia_smart_home_directive_t));
+
+    directiveJson = cJSON_GetObjectItemCaseSensitive(message, "directive");
+    header        = cJSON_GetObjectItemCaseSensitive(directiveJson, "header");
+
+    if (cJSON_IsObject(header))
+    {
+        directive->name_space       = AIA_SmartHomeGetString(header, "namespace");
+        directive->name             = AIA_SmartHomeGetString(header, "name");
+        directive->messageId        = AIA_SmartHomeGetString(header, "messageId");
+        directive->correlationToken = AIA_SmartHomeGetString(header, "correlationToken");
+
+        endpoint              = cJSON_GetObjectItemCaseSensitive(directiveJson, "endpoint");
+        directive->endpointId = AIA_SmartHomeGetString(endpoint, "endpointId");
+
+        payload            = cJSON_GetObjectItemCaseSensitive(directiveJson, "payload");
+        directive->payload = cJSON_IsObject(payload) ? payload : NULL;
+
+        if (directive->endpointId != NULL)
+        {
+            directive->endpoint = AIA_SmartHomeGetEndpoint(handle, (char *)directive->endpointId);
+        }
+
+        if ((directive->name_space != NULL) && (directive->name != NULL))
+        {
+            status = kStatus_Success;
+        }
+    }
+
+    return status;
+}
+
 status_t AIA_AlexaSmartHomeInit(ais_handle_t *handle)
 {
     cJSON *discoveryJson, *event, *payload, *endpoint_array, *endpoint, *interface, *header, *capabilities_array,
@@ -167,6 +394,11 @@ status_t AIA_AlexaSmartHomeInit(ais_handle_t *handle)
         endpoint_count++;
     }
 
+    if (!s_routesPerfect)
+    {
+        AIA_SmartHomeBuildRoutes();
+    }
+
     if (smartHomeTaskHandle == NULL)
     {
         smartHomeTaskHandle =
@@ -180,44 +412,294 @@ status_t AIA_AlexaSmartHomeInit(ais_handle_t *handle)
     return status;
 }
 
-status_t AIA_AlexaSmartHomeHandler(ais_handle_t *handle, cJSON *payload)
+status_t AIA_AlexaSmartHomeDispatch(ais_handle_t *handle, cJSON *message)
 {
-    cJSON *header, *name, *directive, *messageId, *correlationToken, *endpoint, *endpointId;
+    aia_smart_home_directive_t directive;
+    const aia_smart_home_route_t *route;
     aia_smart_home_response_payload_t *response;
+    status_t status;
+
+    status = AIA_SmartHomeParseDirective(handle, message, &directive);
+
+    if (status != kStatus_Success)
+    {
+        configPRINTF(("[SmartHome] Malformed directive\r\n"));
+        return status;
+    }
+
+    route = AIA_SmartHomeFindRoute(directive.name_space, directive.name);
+
+    if (route == NULL)
+    {
+        configPRINTF(("[SmartHome] Unsupported directive %s %s\r\n", directive.name_space, directive.name));
+        return kStatus_Fail;
+    }
+
+    if (route->sendResponse && ((directive.endpoint == NULL) || (directive.correlationToken == NULL)))
+    {
+        configPRINTF(("[SmartHome] Failed to find matching endpoint %s\r\n",
+                      (directive.endpointId != NULL) ? directive.endpointId : "(none)"));
+        return kStatus_Fail;
+    }
+
+    response = AIA_SmartHomeResponseAlloc();
+
+    if (response == NULL)
+    {
+        configPRINTF(("[SmartHome] No free response for %s %s\r\n", directive.name_space, directive.name));
+        return kStatus_Fail;
+    }
+
+    response->correlationToken = (char *)directive.correlationToken;
+    response->endpointId       = (char *)directive.endpointId;
+
+    status = route->handler(handle, &directive, response);
+
+    if ((status == kStatus_Success) && route->sendResponse)
+    {
+        status = AIA_AlexaSmartHomeResponse(handle, response);
+    }
+
+    AIA_SmartHomeResponseFree(response);
+
+    return status;
+}
+
+status_t AIA_SmartHomeQueueDirective(ais_handle_t *handle,
+                                     ais_smart_home_controller_type_t controller_type,
+                                     uint32_t directive_type,
+                                     ais_avs_smart_home_endpoint_t *endpoint)
+{
+    aia_smart_home_queue_payload_t *smartHomePayload;
     status_t status = kStatus_Fail;
 
-    directive        = cJSON_GetObjectItemCaseSensitive(payload, "directive");
-    header           = cJSON_GetObjectItemCaseSensitive(directive, "header");
-    name             = cJSON_GetObjectItemCaseSensitive(header, "name");
-    messageId        = cJSON_GetObjectItemCaseSensitive(header, "messageId");
-    correlationToken = cJSON_GetObjectItemCaseSensitive(header, "correlationToken");
-    endpoint         = cJSON_GetObjectItemCaseSensitive(payload, "endpoint");
-    endpointId       = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
+    /* The Response of the directive carries the new state, no ChangeReport for it */
+    xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+    endpoint->changedMask &= ~(1U << controller_type);
+    xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    /* Possibly add additional JSON attributes for AIA specific requirements */
+    if (handle->smart_home.p_smartHomeQueue != NULL)
+    {
+        smartHomePayload = (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
+
+        if (smartHomePayload != NULL)
+        {
+            smartHomePayload->controller_type           = controller_type;
+            smartHomePayload->controller_directive_type = directive_type;
+            smartHomePayload->endpoint                  = endpoint;
+
+            /* Sending the address of the pointer to reduce memory on the queue */
+            if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
+            {
+                vPortFree(smartHomePayload);
+            }
+            else
+            {
+                status = kStatus_Success;
+            }
+        }
+    }
 
-    if (strcmp(name->valuestring, "EventProcessed") == 0)
+    return status;
+}
+
+static status_t AIA_AlexaSmartHomeEventProcessed(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response)
+{
+    /* AddOrUpdate/Delete report has been processed, nothing to answer */
+    return kStatus_Success;
+}
+
+status_t AIA_AlexaSmartHomeReportChange(ais_handle_t *handle,
+                                        ais_avs_smart_home_endpoint_t *endpoint,
+                                        ais_smart_home_controller_type_t controller_type)
+{
+    aia_smart_home_queue_payload_t *wakeup = &s_changeReportWakeup;
+    bool firstChange;
+
+    if ((endpoint == NULL) || (handle->smart_home.s_smartHomeLock == NULL))
     {
-        /* Set EventProcess Group Bit to notify AddOrUpdate/Delete report has been processed */
-        status = kStatus_Success;
+        return kStatus_InvalidArgument;
+    }
+
+    xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+    firstChange = (endpoint->changedMask == 0);
+    endpoint->changedMask |= (1U << controller_type);
+    xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+    /* Later changes of the window only update the mask, the task already waits for its end. The task
+     * flushes after every message it takes, so no wakeup is needed from its own callbacks. */
+    if (firstChange && (handle->smart_home.p_smartHomeQueue != NULL) &&
+        (xTaskGetCurrentTaskHandle() != smartHomeTaskHandle))
+    {
+        /* A full queue drains within a window, wait for room rather than losing the wakeup */
+        if (pdTRUE != xQueueSend(handle->smart_home.p_smartHomeQueue, &wakeup,
+                                 pdMS_TO_TICKS(AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS)))
+        {
+            configPRINTF(("[SmartHome] ChangeReport wakeup not queued, sent with the next directive\r\n"));
+        }
+    }
+
+    return kStatus_Success;
+}
+
+static cJSON *AIA_SmartHomeCreateProperty(ais_handle_t *handle,
+                                          ais_avs_smart_home_endpoint_t *endpoint,
+                                          ais_smart_home_controller_type_t controller_type)
+{
+    cJSON *property = NULL;
+
+    switch (controller_type)
+    {
+        case AIS_SMART_HOME_POWER_CONTROLLER:
+            if (endpoint->powerController != NULL)
+            {
+                property = AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, endpoint);
+            }
+            break;
+        case AIS_SMART_HOME_TOGGLE_CONTROLLER:
+            if (endpoint->toggleController != NULL)
+            {
+                property = AIA_AlexaSmartHomeToggleControllerCreateResponseContext(handle, endpoint);
+            }
+            break;
+        case AIS_SMART_HOME_RANGE_CONTROLLER:
+            if (endpoint->rangeController != NULL)
+            {
+                property = AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, endpoint);
+            }
+            break;
+        case AIS_SMART_HOME_MODE_CONTROLLER:
+            if (endpoint->modeController != NULL)
+            {
+                property = AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, endpoint);
+            }
+            break;
+        case AIS_SMART_HOME_BRIGHTNESS_CONTROLLER:
+            if (endpoint->brightnessController != NULL)
+            {
+                property = AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, endpoint);
+            }
+            break;
+        default:
+            break;
+    }
+
+    return property;
+}
+
+/* Called with the smart home lock held */
+static void AIA_SmartHomeSnapshot(const ais_avs_smart_home_endpoint_t *endpoint, aia_smart_home_snapshot_t *snapshot)
+{
+    snapshot->endpoint = *endpoint;
+
+    if (endpoint->brightnessController != NULL)
+    {
+        snapshot->brightnessController          = *endpoint->brightnessController;
+        snapshot->endpoint.brightnessController = &snapshot->brightnessController;
+    }
+    if (endpoint->powerController != NULL)
+    {
+        snapshot->powerController          = *endpoint->powerController;
+        snapshot->endpoint.powerController = &snapshot->powerController;
+    }
+    if (endpoint->rangeController != NULL)
+    {
+        snapshot->rangeController          = *endpoint->rangeController;
+        snapshot->endpoint.rangeController = &snapshot->rangeController;
     }
+    if (endpoint->toggleController != NULL)
+    {
+        snapshot->toggleController          = *endpoint->toggleController;
+        snapshot->endpoint.toggleController = &snapshot->toggleController;
+    }
+    if (endpoint->modeController != NULL)
+    {
+        snapshot->modeController          = *endpoint->modeController;
+        snapshot->endpoint.modeController = &snapshot->modeController;
+    }
+}
+
+/* One ChangeReport with the changed capabilities in the payload and the others in the context */
+static void AIA_SmartHomeSendChangeReport(ais_handle_t *handle, ais_avs_smart_home_endpoint_t *endpoint, uint32_t mask)
+{
+    aia_smart_home_response_payload_t changeReport = {0};
+    cJSON *change, *cause, *changed, *property;
+    uint32_t controller_type;
+
+    changed                   = cJSON_CreateArray();
+    changeReport.context.json = cJSON_CreateArray();
+    changeReport.payload.json = cJSON_CreateObject();
+    changeReport.endpointId   = endpoint->endpointId;
 
-    if (strcmp(name->valuestring, "ReportState") == 0)
+    for (controller_type = AIS_SMART_HOME_POWER_CONTROLLER; controller_type <= AIS_SMART_HOME_BRIGHTNESS_CONTROLLER;
+         controller_type++)
     {
-        response = (aia_smart_home_response_payload_t *)pvPortMalloc(sizeof(aia_smart_home_response_payload_t));
+        property = AIA_SmartHomeCreateProperty(handle, endpoint, (ais_smart_home_controller_type_t)controller_type);
+        if (property != NULL)
+        {
+            cJSON_AddItemToArray((mask & (1U << controller_type)) ? changed : changeReport.context.json, property);
+        }
+    }
+
+    change = cJSON_CreateObject();
+    cause  = cJSON_CreateObject();
+    cJSON_AddItemToObject(cause, "type", cJSON_CreateString("PHYSICAL_INTERACTION"));
+    cJSON_AddItemToObject(change, "cause", cause);
+    cJSON_AddItemToObject(change, "properties", changed);
+    cJSON_AddItemToObject(changeReport.payload.json, "change", change);
+
+    AIA_AlexaSmartHomeChangeReport(handle, &changeReport);
+}
+
+/* Send the ChangeReports whose window has elapsed, returns the ticks until the next one is due */
+static TickType_t AIA_SmartHomeFlushChangeReports(ais_handle_t *handle)
+{
+    const TickType_t window = pdMS_TO_TICKS(AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS);
+    TickType_t wait         = portMAX_DELAY;
+    TickType_t now, elapsed;
+    ais_avs_smart_home_endpoint_t *endpoint;
+    aia_smart_home_snapshot_t snapshot;
+    uint32_t endpoint_count;
+    uint32_t mask;
 
-        if (response != NULL)
+    for (endpoint_count = 0; endpoint_count < handle->smart_home.number_of_endpoints; endpoint_count++)
+    {
+        endpoint = &handle->smart_home.smart_home_endpoint[endpoint_count];
+        mask     = 0;
+
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        if (endpoint->changedMask != 0)
         {
-            response->correlationToken = correlationToken->valuestring;
-            response->endpointId       = endpointId->valuestring;
+            now     = xTaskGetTickCount();
+            elapsed = now - endpoint->lastReport;
 
-            status = _AIA_SmartHomeHandleReportState(handle, response, payload);
+            if (!endpoint->reported || (elapsed >= window))
+            {
+                mask                  = endpoint->changedMask;
+                endpoint->changedMask = 0;
+                endpoint->lastReport  = now;
+                endpoint->reported    = true;
 
-            vPortFree(response);
+                /* Taken with the mask, so the properties of the report are one state of the endpoint */
+                AIA_SmartHomeSnapshot(endpoint, &snapshot);
+            }
+            else if ((window - elapsed) < wait)
+            {
+                wait = window - elapsed;
+            }
+        }
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        if (mask != 0)
+        {
+            /* The controllers take the lock to read their state, the report is built from the copy */
+            AIA_SmartHomeSendChangeReport(handle, &snapshot.endpoint, mask);
         }
     }
 
-    return status;
+    return wait;
 }
 
 cJSON *AIA_DiscoveryEndpointGetAddOrUpdateReportJson(ais_handle_t *handle)
@@ -420,7 +902,8 @@ status_t AIA_AlexaSmartHomeResponse(ais_handle_t *handle, aia_smart_home_respons
     return status;
 }
 
-status_t AIA_AlexaSmartHomeChangeReport(ais_handle_t *handle, aia_smart_home_response_payload_t *change_report)
+/* Sends a ChangeReport, AIA_AlexaSmartHomeReportChange merges the changes of a window into one */
+static status_t AIA_AlexaSmartHomeChangeReport(ais_handle_t *handle, aia_smart_home_response_payload_t *change_report)
 {
     status_t status = kStatus_Fail;
     cJSON *event, *header;
@@ -437,6 +920,11 @@ status_t AIA_AlexaSmartHomeChangeReport(ais_handle_t *handle, aia_smart_home_res
 
     cJSON_AddItemToObject(header, "name", cJSON_CreateString((char *)"ChangeReport"));
 
+    if (change_report->payload.json != NULL)
+    {
+        cJSON_ReplaceItemInObjectCaseSensitive(event, "payload", change_report->payload.json);
+    }
+
     AIS_EventSmartHomeEndpointForwarding(handle, &smart_home_change_report);
 
     return status;
@@ -508,65 +996,56 @@ ais_avs_smart_home_endpoint_t *AIA_SmartHomeGetEndpoint(ais_handle_t *handle, ch
     return endpoint;
 }
 
-status_t _AIA_SmartHomeHandleReportState(ais_handle_t *handle,
-                                         aia_smart_home_response_payload_t *stateResponse,
-                                         cJSON *payload)
+static status_t AIA_AlexaSmartHomeReportState(ais_handle_t *handle,
+                                              const aia_smart_home_directive_t *directive,
+                                              aia_smart_home_response_payload_t *response)
 {
-    cJSON *directive, *endpoint, *endpointId, *properties, *event, *header;
-    status_t status                    = kStatus_Fail;
-    uint32_t endpoint_count            = 0;
-    ais_json_t smart_home_report_state = {0};
-    ais_avs_smart_home_endpoint_t *sh_endpoint;
+    cJSON *properties, *event, *header;
+    status_t status                            = kStatus_Fail;
+    ais_json_t smart_home_report_state         = {0};
+    ais_avs_smart_home_endpoint_t *sh_endpoint = directive->endpoint;
 
-    properties = cJSON_CreateArray();
-
-    smart_home_report_state.json = cJSON_CreateObject();
-
-    directive  = cJSON_GetObjectItemCaseSensitive(payload, "directive");
-    endpoint   = cJSON_GetObjectItemCaseSensitive(directive, "endpoint");
-    endpointId = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
-
-    stateResponse->endpointId = endpointId->valuestring;
+    if ((sh_endpoint == NULL) || (response->correlationToken == NULL))
+    {
+        configPRINTF(("[SmartHome] - Unable to find associated endpoint %s\r\n",
+                      (directive->endpointId != NULL) ? directive->endpointId : "(none)"));
+        return status;
+    }
 
-    sh_endpoint = AIA_SmartHomeGetEndpoint(handle, stateResponse->endpointId);
+    properties = cJSON_CreateArray();
 
-    if (sh_endpoint != NULL)
+    if (sh_endpoint->brightnessController != NULL)
     {
-        if (handle->smart_home.smart_home_endpoint[endpoint_count].brightnessController != NULL)
-        {
-            cJSON_AddItemToArray(properties,
-                                 AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, sh_endpoint));
-        }
-        if (handle->smart_home.smart_home_endpoint[endpoint_count].powerController != NULL)
-        {
-            cJSON_AddItemToArray(properties,
-                                 AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, sh_endpoint));
-        }
-        if (handle->smart_home.smart_home_endpoint[endpoint_count].modeController != NULL)
-        {
-            cJSON_AddItemToArray(properties,
-                                 AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, sh_endpoint));
-        }
-        if (handle->smart_home.smart_home_endpoint[endpoint_count].rangeController != NULL)
-        {
-            cJSON_AddItemToArray(properties,
-                                 AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, sh_endpoint));
-        }
-        if (handle->smart_home.smart_home_endpoint[endpoint_count].toggleController != NULL)
-        {
-            cJSON_AddItemToArray(properties,
-                                 AIA_AlexaSmartHomeToggleControllerCreateResponseContext(handle, sh_endpoint));
-        }
+        cJSON_AddItemToArray(properties,
+                             AIA_AlexaSmartHomeBrightnessControllerCreateResponseContext(handle, sh_endpoint));
     }
-    else
+    if (sh_endpoint->powerController != NULL)
+    {
+        cJSON_AddItemToArray(properties,
+                             AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, sh_endpoint));
+    }
+    if (sh_endpoint->modeController != NULL)
+    {
+        cJSON_AddItemToArray(properties,
+                             AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, sh_endpoint));
+    }
+    if (sh_endpoint->rangeController != NULL)
     {
-        configPRINTF(("[SmartHome] - Unable to find associated endpoint %s\t\n", endpointId->valuestring));
+        cJSON_AddItemToArray(properties,
+                             AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, sh_endpoint));
     }
+    if (sh_endpoint->toggleController != NULL)
+    {
+        cJSON_AddItemToArray(properties,
+                             AIA_AlexaSmartHomeToggleControllerCreateResponseContext(handle, sh_endpoint));
+    }
+
+    response->context.json = properties;
 
-    stateResponse->context.json = properties;
+    smart_home_report_state.json = cJSON_CreateObject();
 
     /* Create template JSON message */
-    status = AIA_AlexaSmartHomeBuildTemplate(handle, smart_home_report_state.json, stateResponse);
+    status = AIA_AlexaSmartHomeBuildTemplate(handle, smart_home_report_state.json, response);
 
     event  = cJSON_GetObjectItemCaseSensitive(smart_home_report_state.json, "event");
     header = cJSON_GetObjectItemCaseSensitive(event, "header");
@@ -574,7 +1053,7 @@ status_t _AIA_SmartHomeHandleReportState(ais_handle_t *handle,
     cJSON_AddItemToObject(header, "name", cJSON_CreateString((char *)"StateReport"));
 
     /* correlationToken is not always used when sending events */
-    cJSON_AddItemToObject(header, "correlationToken", cJSON_CreateString((char *)stateResponse->correlationToken));
+    cJSON_AddItemToObject(header, "correlationToken", cJSON_CreateString((char *)response->correlationToken));
 
     AIS_EventSmartHomeEndpointForwarding(handle, &smart_home_report_state);
 
@@ -594,14 +1073,20 @@ static void AIA_SmartHomeTask(void *arg)
 {
     aia_smart_home_queue_payload_t *smart_home_msg = NULL;
     ais_handle_t *handle                           = (ais_handle_t *)arg;
+    TickType_t wait                                = portMAX_DELAY;
 
     while (1)
     {
         /* Passing the address of the pointer so the memory address will be copied into the address of the stack pointer
          * to save memory */
-        if (xQueueReceive(handle->smart_home.p_smartHomeQueue, &smart_home_msg, portMAX_DELAY))
+        if (xQueueReceive(handle->smart_home.p_smartHomeQueue, &smart_home_msg, wait))
         {
-            if (smart_home_msg != NULL)
+            /* The ChangeReport wakeup only shortens the wait, the reports are flushed below */
+            if (smart_home_msg == &s_changeReportWakeup)
+            {
+                wait = 0;
+            }
+            else if (smart_home_msg != NULL)
             {
                 switch (smart_home_msg->controller_type)
                 {
@@ -631,5 +1116,7 @@ static void AIA_SmartHomeTask(void *arg)
                 configPRINTF(("[Smart Home Task] NULL pointer received\r\n"));
             }
         }
+
+        wait = AIA_SmartHomeFlushChangeReports(handle);
     }
 }
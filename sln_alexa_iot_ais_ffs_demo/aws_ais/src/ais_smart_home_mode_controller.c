@@ -17,79 +17,6 @@
 
 #include "mbedtls/base64.h"
 
-/*******************************************************************************
- * Prototypes
- ******************************************************************************/
-static cJSON *AIA_AlexaSmartHomeModeControllerSetMode(ais_handle_t *handle,
-                                                      cJSON *payload,
-                                                      aia_smart_home_response_payload_t *response,
-                                                      ais_avs_smart_home_endpoint_t *endpoint);
-static cJSON *AIA_AlexaSmartHomeModeControllerAdjustMode(ais_handle_t *handle,
-                                                         cJSON *payload,
-                                                         aia_smart_home_response_payload_t *response,
-                                                         ais_avs_smart_home_endpoint_t *endpoint);
-
-/*******************************************************************************
- * Variables
- ******************************************************************************/
-
-/*******************************************************************************
- * Definitions
- ******************************************************************************/
-
-status_t AIA_AlexaSmartHomeModeControllerHandler(ais_handle_t *handle, cJSON *message)
-{
-    cJSON *header, *name, *payload, *directive, *name_space, *correlationToken, *endpointId, *endpoint;
-    aia_smart_home_response_payload_t *response;
-    ais_avs_smart_home_endpoint_t *sh_endpoint;
-    status_t status = kStatus_Fail;
-
-    response = (aia_smart_home_response_payload_t *)pvPortMalloc(sizeof(aia_smart_home_response_payload_t));
-
-    if (response != NULL)
-    {
-        /* Power Controller Endpoint Handler */
-        directive        = cJSON_GetObjectItemCaseSensitive(message, "directive");
-        header           = cJSON_GetObjectItemCaseSensitive(directive, "header");
-        name_space       = cJSON_GetObjectItemCaseSensitive(header, "namespace");
-        name             = cJSON_GetObjectItemCaseSensitive(header, "name");
-        correlationToken = cJSON_GetObjectItemCaseSensitive(header, "correlationToken");
-        endpoint         = cJSON_GetObjectItemCaseSensitive(directive, "endpoint");
-        endpointId       = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
-        payload          = cJSON_GetObjectItemCaseSensitive(message, "payload");
-
-        sh_endpoint = AIA_SmartHomeGetEndpoint(handle, endpointId->valuestring);
-
-        if (sh_endpoint != NULL)
-        {
-            response->correlationToken = correlationToken->valuestring;
-            response->endpointId       = endpointId->valuestring;
-
-            if (strcmp(name->valuestring, "SetMode") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeModeControllerSetMode(handle, payload, response, sh_endpoint);
-            }
-
-            if (strcmp(name->valuestring, "AdjustMode") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeModeControllerAdjustMode(handle, payload, response, sh_endpoint);
-            }
-
-            status = AIA_AlexaSmartHomeResponse(handle, response);
-        }
-        else
-        {
-            configPRINTF(("[SmartHome] Failed to find matching endpoint %s", endpointId->valuestring));
-        }
-
-        vPortFree(response);
-    }
-
-    return status;
-}
-
 cJSON *AIA_AlexaSmartHomeModeControllerCreateResponseContext(ais_handle_t *handle,
                                                              ais_avs_smart_home_endpoint_t *endpoint)
 {
@@ -120,85 +47,96 @@ cJSON *AIA_AlexaSmartHomeModeControllerCreateResponseContext(ais_handle_t *handl
     return response;
 }
 
-static cJSON *AIA_AlexaSmartHomeModeControllerSetMode(ais_handle_t *handle,
-                                                      cJSON *payload,
-                                                      aia_smart_home_response_payload_t *response,
-                                                      ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeModeControllerSetMode(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response)
 {
-    cJSON *mode, *context;
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *mode;
+    status_t status = kStatus_Fail;
 
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    /* Please note, this is still in MQTT Callback context. */
 
-    context = cJSON_CreateArray();
+    mode = cJSON_GetObjectItemCaseSensitive(directive->payload, "mode");
 
-    mode = cJSON_GetObjectItemCaseSensitive(payload, "mode");
+    if ((endpoint->modeController == NULL) || !cJSON_IsNumber(mode))
+    {
+        configPRINTF(("[SmartHome] Invalid SetMode for endpoint %s\r\n", directive->endpointId));
+    }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->modeController->mode = mode->valueint;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->modeController->mode = mode->valueint;
-    xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_MODE_CONTROLLER,
+                                    AIS_SMART_HOME_MODE_CONTROLLER_SET, endpoint);
+
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, endpoint));
+
+        status = kStatus_Success;
+    }
+
+    return status;
+}
+
+status_t AIA_AlexaSmartHomeModeControllerAdjustMode(ais_handle_t *handle,
+                                                    const aia_smart_home_directive_t *directive,
+                                                    aia_smart_home_response_payload_t *response)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *modeDelta;
+    status_t status = kStatus_Fail;
+
+    /* Please note, this is still in MQTT Callback context. */
+
+    modeDelta = cJSON_GetObjectItemCaseSensitive(directive->payload, "modeDelta");
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if ((endpoint->modeController == NULL) || !cJSON_IsNumber(modeDelta))
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_MODE_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_MODE_CONTROLLER_SET;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        configPRINTF(("[SmartHome] Invalid AdjustMode for endpoint %s\r\n", directive->endpointId));
     }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->modeController->modeDelta = modeDelta->valueint;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_MODE_CONTROLLER,
+                                    AIS_SMART_HOME_MODE_CONTROLLER_ADJUST, endpoint);
+
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, endpoint));
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, endpoint));
+        status = kStatus_Success;
+    }
 
-    return context;
+    return status;
 }
 
-static cJSON *AIA_AlexaSmartHomeModeControllerAdjustMode(ais_handle_t *handle,
-                                                         cJSON *payload,
-                                                         aia_smart_home_response_payload_t *response,
-                                                         ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeModeControllerSetState(ais_handle_t *handle,
+                                                  ais_avs_smart_home_endpoint_t *endpoint,
+                                                  uint32_t mode)
 {
-    cJSON *modeDelta, *context;
-
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    bool changed;
 
-    context = cJSON_CreateArray();
+    if ((endpoint == NULL) || (endpoint->modeController == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
 
-    modeDelta = cJSON_GetObjectItemCaseSensitive(payload, "modeDelta");
     xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->modeController->modeDelta = modeDelta->valueint;
+    changed = (endpoint->modeController->mode != mode);
+    endpoint->modeController->mode = mode;
     xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if (!changed)
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_MODE_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_MODE_CONTROLLER_ADJUST;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        return kStatus_Success;
     }
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeModeControllerCreateResponseContext(handle, endpoint));
-
-    return context;
+    return AIA_AlexaSmartHomeReportChange(handle, endpoint, AIS_SMART_HOME_MODE_CONTROLLER);
 }
@@ -17,75 +17,6 @@
 
 #include "mbedtls/base64.h"
 
-/*******************************************************************************
- * Prototypes
- ******************************************************************************/
-static cJSON *AIA_AlexaSmartHomePowerControllerTurnOn(ais_handle_t *handle,
-                                                      aia_smart_home_response_payload_t *response,
-                                                      ais_avs_smart_home_endpoint_t *endpoint);
-static cJSON *AIA_AlexaSmartHomePowerControllerTurnOff(ais_handle_t *handle,
-                                                       aia_smart_home_response_payload_t *response,
-                                                       ais_avs_smart_home_endpoint_t *endpoint);
-
-/*******************************************************************************
- * Definitions
- ******************************************************************************/
-
-/*******************************************************************************
- * Variables
- ******************************************************************************/
-
-status_t AIA_AlexaSmartHomePowerControllerHandler(ais_handle_t *handle, cJSON *message)
-{
-    cJSON *header, *directive, *name_space, *name, *correlationToken, *endpointId, *endpoint;
-    aia_smart_home_response_payload_t *response;
-    ais_avs_smart_home_endpoint_t *sh_endpoint;
-    status_t status = kStatus_Fail;
-
-    response = (aia_smart_home_response_payload_t *)pvPortMalloc(sizeof(aia_smart_home_response_payload_t));
-
-    if (response != NULL)
-    {
-        /* Power Controller Endpoint Handler */
-
-        directive        = cJSON_GetObjectItemCaseSensitive(message, "directive");
-        header           = cJSON_GetObjectItemCaseSensitive(directive, "header");
-        name_space       = cJSON_GetObjectItemCaseSensitive(header, "namespace");
-        name             = cJSON_GetObjectItemCaseSensitive(header, "name");
-        correlationToken = cJSON_GetObjectItemCaseSensitive(header, "correlationToken");
-        endpoint         = cJSON_GetObjectItemCaseSensitive(directive, "endpoint");
-        endpointId       = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
-
-        sh_endpoint = AIA_SmartHomeGetEndpoint(handle, endpointId->valuestring);
-
-        if (sh_endpoint != NULL)
-        {
-            response->correlationToken = correlationToken->valuestring;
-            response->endpointId       = endpointId->valuestring;
-
-            if (strcmp(name->valuestring, "TurnOn") == 0)
-            {
-                response->context.json = AIA_AlexaSmartHomePowerControllerTurnOn(handle, response, sh_endpoint);
-            }
-
-            if (strcmp(name->valuestring, "TurnOff") == 0)
-            {
-                response->context.json = AIA_AlexaSmartHomePowerControllerTurnOff(handle, response, sh_endpoint);
-            }
-
-            status = AIA_AlexaSmartHomeResponse(handle, response);
-        }
-        else
-        {
-            configPRINTF(("[SmartHome] Failed to find matching endpoint %s", endpointId->valuestring));
-        }
-
-        vPortFree(response);
-    }
-
-    return status;
-}
-
 cJSON *AIA_AlexaSmartHomePowerControllerCreateResponseContext(ais_handle_t *handle,
                                                               ais_avs_smart_home_endpoint_t *endpoint)
 {
@@ -116,80 +47,90 @@ cJSON *AIA_AlexaSmartHomePowerControllerCreateResponseContext(ais_handle_t *hand
     return response;
 }
 
-static cJSON *AIA_AlexaSmartHomePowerControllerTurnOn(ais_handle_t *handle,
-                                                      aia_smart_home_response_payload_t *response,
-                                                      ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomePowerControllerTurnOn(ais_handle_t *handle,
+                                                 const aia_smart_home_directive_t *directive,
+                                                 aia_smart_home_response_payload_t *response)
 {
-    cJSON *context;
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    status_t status = kStatus_Fail;
 
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    /* Please note, this is still in MQTT Callback context. */
+
+    if (endpoint->powerController == NULL)
+    {
+        configPRINTF(("[SmartHome] Invalid TurnOn for endpoint %s\r\n", directive->endpointId));
+    }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->powerController->on = true;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    context = cJSON_CreateArray();
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_POWER_CONTROLLER,
+                                    AIS_SMART_HOME_POWER_CONTROLLER_TURN_ON, endpoint);
 
-    xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->powerController->on = true;
-    xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, endpoint));
+
+        status = kStatus_Success;
+    }
+
+    return status;
+}
+
+status_t AIA_AlexaSmartHomePowerControllerTurnOff(ais_handle_t *handle,
+                                                  const aia_smart_home_directive_t *directive,
+                                                  aia_smart_home_response_payload_t *response)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    status_t status = kStatus_Fail;
+
+    /* Please note, this is still in MQTT Callback context. */
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if (endpoint->powerController == NULL)
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_POWER_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_POWER_CONTROLLER_TURN_ON;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        configPRINTF(("[SmartHome] Invalid TurnOff for endpoint %s\r\n", directive->endpointId));
     }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->powerController->on = false;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_POWER_CONTROLLER,
+                                    AIS_SMART_HOME_POWER_CONTROLLER_TURN_OFF, endpoint);
+
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, endpoint));
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, endpoint));
+        status = kStatus_Success;
+    }
 
-    return context;
+    return status;
 }
 
-static cJSON *AIA_AlexaSmartHomePowerControllerTurnOff(ais_handle_t *handle,
-                                                       aia_smart_home_response_payload_t *response,
-                                                       ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomePowerControllerSetState(ais_handle_t *handle,
+                                                   ais_avs_smart_home_endpoint_t *endpoint,
+                                                   bool on)
 {
-    cJSON *context;
-
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    bool changed;
 
-    context = cJSON_CreateArray();
+    if ((endpoint == NULL) || (endpoint->powerController == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
 
     xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->powerController->on = false;
+    changed = (endpoint->powerController->on != on);
+    endpoint->powerController->on = on;
     xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if (!changed)
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_POWER_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_POWER_CONTROLLER_TURN_OFF;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        return kStatus_Success;
     }
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomePowerControllerCreateResponseContext(handle, endpoint));
-
-    return context;
+    return AIA_AlexaSmartHomeReportChange(handle, endpoint, AIS_SMART_HOME_POWER_CONTROLLER);
 }
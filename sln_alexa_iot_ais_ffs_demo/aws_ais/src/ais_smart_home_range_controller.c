@@ -17,80 +17,6 @@
 
 #include "mbedtls/base64.h"
 
-/*******************************************************************************
- * Prototypes
- ******************************************************************************/
-static cJSON *AIA_AlexaSmartHomeRangeControllerSetRangeValue(ais_handle_t *handle,
-                                                             cJSON *payload,
-                                                             aia_smart_home_response_payload_t *response,
-                                                             ais_avs_smart_home_endpoint_t *endpoint);
-static cJSON *AIA_AlexaSmartHomeRangeControllerAdjustRangeValue(ais_handle_t *handle,
-                                                                cJSON *payload,
-                                                                aia_smart_home_response_payload_t *response,
-                                                                ais_avs_smart_home_endpoint_t *endpoint);
-/*******************************************************************************
- * Definitions
- ******************************************************************************/
-
-/*******************************************************************************
- * Variables
- ******************************************************************************/
-
-aia_smart_home_queue_payload_t *smartHomeRangePayload;
-
-status_t AIA_AlexaSmartHomeRangeControllerHandler(ais_handle_t *handle, cJSON *message)
-{
-    cJSON *header, *name, *payload, *directive, *name_space, *correlationToken, *endpointId, *endpoint;
-    aia_smart_home_response_payload_t *response;
-    ais_avs_smart_home_endpoint_t *sh_endpoint;
-    status_t status = kStatus_Fail;
-
-    response = (aia_smart_home_response_payload_t *)pvPortMalloc(sizeof(aia_smart_home_response_payload_t));
-
-    if (response != NULL)
-    {
-        /* Power Controller Endpoint Handler */
-        directive        = cJSON_GetObjectItemCaseSensitive(message, "directive");
-        header           = cJSON_GetObjectItemCaseSensitive(directive, "header");
-        name_space       = cJSON_GetObjectItemCaseSensitive(header, "namespace");
-        name             = cJSON_GetObjectItemCaseSensitive(header, "name");
-        correlationToken = cJSON_GetObjectItemCaseSensitive(header, "correlationToken");
-        endpoint         = cJSON_GetObjectItemCaseSensitive(directive, "endpoint");
-        endpointId       = cJSON_GetObjectItemCaseSensitive(endpoint, "endpointId");
-        payload          = cJSON_GetObjectItemCaseSensitive(message, "payload");
-
-        sh_endpoint = AIA_SmartHomeGetEndpoint(handle, endpointId->valuestring);
-
-        if (sh_endpoint != NULL)
-        {
-            response->correlationToken = correlationToken->valuestring;
-            response->endpointId       = endpointId->valuestring;
-
-            if (strcmp(name->valuestring, "SetRangeValue") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeRangeControllerSetRangeValue(handle, payload, response, sh_endpoint);
-            }
-
-            if (strcmp(name->valuestring, "AdjustRangeValue") == 0)
-            {
-                response->context.json =
-                    AIA_AlexaSmartHomeRangeControllerAdjustRangeValue(handle, payload, response, sh_endpoint);
-            }
-
-            status = AIA_AlexaSmartHomeResponse(handle, response);
-        }
-        else
-        {
-            configPRINTF(("[SmartHome] Failed to find matching endpoint %s", endpointId->valuestring));
-        }
-
-        vPortFree(response);
-    }
-
-    return status;
-}
-
 cJSON *AIA_AlexaSmartHomeRangeControllerCreateResponseContext(ais_handle_t *handle,
                                                               ais_avs_smart_home_endpoint_t *endpoint)
 {
@@ -121,88 +47,98 @@ cJSON *AIA_AlexaSmartHomeRangeControllerCreateResponseContext(ais_handle_t *hand
     return response;
 }
 
-static cJSON *AIA_AlexaSmartHomeRangeControllerSetRangeValue(ais_handle_t *handle,
-                                                             cJSON *payload,
-                                                             aia_smart_home_response_payload_t *response,
-                                                             ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeRangeControllerSetRangeValue(ais_handle_t *handle,
+                                                        const aia_smart_home_directive_t *directive,
+                                                        aia_smart_home_response_payload_t *response)
 {
-    cJSON *rangeValue, *context;
-
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
-
-    context = cJSON_CreateArray();
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *rangeValue;
+    status_t status = kStatus_Fail;
 
-    rangeValue = cJSON_GetObjectItemCaseSensitive(payload, "rangeValue");
+    /* Please note, this is still in MQTT Callback context. */
 
-    xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->rangeController->range = rangeValue->valueint;
-    xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+    rangeValue = cJSON_GetObjectItemCaseSensitive(directive->payload, "rangeValue");
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if ((endpoint->rangeController == NULL) || !cJSON_IsNumber(rangeValue))
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_RANGE_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_RANGE_CONTROLLER_SET_RANGE;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        configPRINTF(("[SmartHome] Invalid SetRangeValue for endpoint %s\r\n", directive->endpointId));
     }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->rangeController->range = rangeValue->valueint;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, endpoint));
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_RANGE_CONTROLLER,
+                                    AIS_SMART_HOME_RANGE_CONTROLLER_SET_RANGE, endpoint);
 
-    return context;
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, endpoint));
+
+        status = kStatus_Success;
+    }
+
+    return status;
 }
 
-static cJSON *AIA_AlexaSmartHomeRangeControllerAdjustRangeValue(ais_handle_t *handle,
-                                                                cJSON *payload,
-                                                                aia_smart_home_response_payload_t *response,
-                                                                ais_avs_smart_home_endpoint_t *endpoint)
+status_t AIA_AlexaSmartHomeRangeControllerAdjustRangeValue(ais_handle_t *handle,
+                                                           const aia_smart_home_directive_t *directive,
+                                                           aia_smart_home_response_payload_t *response)
 {
-    cJSON *rangeValueDelta, *rangeValueDeltaDefault, *context;
+    ais_avs_smart_home_endpoint_t *endpoint = directive->endpoint;
+    cJSON *rangeValueDelta, *rangeValueDeltaDefault;
+    status_t status = kStatus_Fail;
 
-    /* This function is responsible for performing the turn on function.
-    ** Please note, this is still in MQTT Callback context.
-    */
+    /* Please note, this is still in MQTT Callback context. */
+
+    rangeValueDelta        = cJSON_GetObjectItemCaseSensitive(directive->payload, "rangeValueDelta");
+    rangeValueDeltaDefault = cJSON_GetObjectItemCaseSensitive(directive->payload, "rangeValueDeltaDefault");
+
+    if ((endpoint->rangeController == NULL) || !cJSON_IsNumber(rangeValueDelta))
+    {
+        configPRINTF(("[SmartHome] Invalid AdjustRangeValue for endpoint %s\r\n", directive->endpointId));
+    }
+    else
+    {
+        xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
+        endpoint->rangeController->rangeDelta        = rangeValueDelta->valueint;
+        endpoint->rangeController->rangeDeltaDefault = cJSON_IsTrue(rangeValueDeltaDefault) ? 1U : 0U;
+        xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    context = cJSON_CreateArray();
+        AIA_SmartHomeQueueDirective(handle, AIS_SMART_HOME_RANGE_CONTROLLER,
+                                    AIS_SMART_HOME_RANGE_CONTROLLER_ADJUST_RANGE, endpoint);
 
-    rangeValueDelta        = cJSON_GetObjectItemCaseSensitive(payload, "rangeValueDelta");
-    rangeValueDeltaDefault = cJSON_GetObjectItemCaseSensitive(payload, "rangeValueDeltaDefault");
+        response->context.json = cJSON_CreateArray();
+        cJSON_AddItemToArray(response->context.json,
+                             AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, endpoint));
+
+        status = kStatus_Success;
+    }
+
+    return status;
+}
+
+status_t AIA_AlexaSmartHomeRangeControllerSetState(ais_handle_t *handle,
+                                                   ais_avs_smart_home_endpoint_t *endpoint,
+                                                   uint32_t range)
+{
+    bool changed;
+
+    if ((endpoint == NULL) || (endpoint->rangeController == NULL))
+    {
+        return kStatus_InvalidArgument;
+    }
 
     xSemaphoreTake(handle->smart_home.s_smartHomeLock, portMAX_DELAY);
-    endpoint->rangeController->rangeDelta        = rangeValueDelta->valueint;
-    endpoint->rangeController->rangeDeltaDefault = rangeValueDeltaDefault->valueint;
+    changed = (endpoint->rangeController->range != range);
+    endpoint->rangeController->range = range;
     xSemaphoreGive(handle->smart_home.s_smartHomeLock);
 
-    if (handle->smart_home.p_smartHomeQueue != NULL)
+    if (!changed)
     {
-        aia_smart_home_queue_payload_t *smartHomePayload =
-            (aia_smart_home_queue_payload_t *)pvPortMalloc(sizeof(aia_smart_home_queue_payload_t));
-
-        smartHomePayload->response                  = response;
-        smartHomePayload->controller_type           = AIS_SMART_HOME_RANGE_CONTROLLER;
-        smartHomePayload->controller_directive_type = AIS_SMART_HOME_RANGE_CONTROLLER_ADJUST_RANGE;
-        smartHomePayload->endpoint                  = endpoint;
-
-        /* Sending the address of the pointer to reduce memory on the queue */
-        if (errQUEUE_FULL == xQueueSend(handle->smart_home.p_smartHomeQueue, &smartHomePayload, (TickType_t)0))
-        {
-            vPortFree(smartHomePayload);
-            /* Send error response */
-        }
+        return kStatus_Success;
     }
 
-    cJSON_AddItemToArray(context, AIA_AlexaSmartHomeRangeControllerCreateResponseContext(handle, endpoint));
-
-    return context;
+    return AIA_AlexaSmartHomeReportChange(handle, endpoint, AIS_SMART_HOME_RANGE_CONTROLLER);
 }
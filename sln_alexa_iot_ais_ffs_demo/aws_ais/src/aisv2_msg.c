@@ -45,8 +45,6 @@ static status_t AIS_ValidateMessage(ais_handle_t *handle,
                                     char **dataOut,
                                     commonHeader_t **header);
 
-static status_t AIS_ProcessEndpointControl(ais_handle_t *handle, cJSON *payload);
-
 /* Node of linked lists used for queuing json publishing events */
 typedef struct
 {
@@ -754,48 +752,6 @@ MQTTBool_t AIS_CallbackSpeaker(void *pvUserData, const MQTTPublishData_t *const
     return eMQTTFalse;
 }
 
-static status_t AIS_ProcessEndpointControl(ais_handle_t *handle, cJSON *payload)
-{
-    cJSON *header, *directive, *name_space;
-    status_t status = kStatus_Fail;
-
-    directive  = cJSON_GetObjectItemCaseSensitive(payload, "directive");
-    header     = cJSON_GetObjectItemCaseSensitive(directive, "header");
-    name_space = cJSON_GetObjectItemCaseSensitive(header, "namespace");
-
-    if (strcmp(name_space->valuestring, "Alexa") == 0)
-    {
-        status = AIA_AlexaSmartHomeHandler(handle, payload);
-    }
-
-    if (strcmp(name_space->valuestring, "Alexa.PowerController") == 0)
-    {
-        status = AIA_AlexaSmartHomePowerControllerHandler(handle, payload);
-    }
-
-    if (strcmp(name_space->valuestring, "Alexa.ModeController") == 0)
-    {
-        status = AIA_AlexaSmartHomeModeControllerHandler(handle, payload);
-    }
-
-    if (strcmp(name_space->valuestring, "Alexa.RangeController") == 0)
-    {
-        status = AIA_AlexaSmartHomeRangeControllerHandler(handle, payload);
-    }
-
-    if (strcmp(name_space->valuestring, "Alexa.ToggleController") == 0)
-    {
-        status = AIA_AlexaSmartHomeToggleControllerHandler(handle, payload);
-    }
-
-    if (strcmp(name_space->valuestring, "Alexa.BrightnessController") == 0)
-    {
-        status = AIA_AlexaSmartHomeBrightnessControllerHandler(handle, payload);
-    }
-
-    return status;
-}
-
 static void AIS_ProcessDirectiveJSON(ais_handle_t *handle, cJSON *directive)
 {
     cJSON *header, *name, *payload, *value;
@@ -827,7 +783,7 @@ static void AIS_ProcessDirectiveJSON(ais_handle_t *handle, cJSON *directive)
 
         payload = cJSON_GetObjectItemCaseSensitive(directive, "payload");
 
-        AIS_ProcessEndpointControl(handle, payload);
+        AIA_AlexaSmartHomeDispatch(handle, payload);
         /* Send message to the AddUpdateReport Group to indicate complete */
     }
 
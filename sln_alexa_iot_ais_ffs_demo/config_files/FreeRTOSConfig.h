@@ -53,9 +53,13 @@
 
 extern void sln_shell_trace_malloc(void *ptr, size_t size);
 extern void sln_shell_trace_free(void *ptr, size_t size);
+extern void vHeapTrackerMalloc(void *pv, size_t xSize, void *pvCaller);
+extern void vHeapTrackerFree(void *pv);
 
 #define configUSE_PREEMPTION                    1
-#define configUSE_TICKLESS_IDLE                 0
+/* Tick from GPT1 and stop it in the idle task, see sln_tickless.h */
+#define configUSE_TICKLESS_IDLE                 1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
 #define configCPU_CLOCK_HZ                      (SystemCoreClock)
 #define configTICK_RATE_HZ                      ((TickType_t)1000)
 
@@ -87,6 +91,17 @@ extern void sln_shell_trace_free(void *ptr, size_t size);
 #define configTOTAL_HEAP_SIZE                   ((size_t) (295 * 1024))
 #define configAPPLICATION_ALLOCATED_HEAP        0
 
+/* Serve small allocations from size class pools in front of heap_4, see heap_slab.h.
+ * The pools (26 KB with the classes below) are taken from configTOTAL_HEAP_SIZE. */
+#define configUSE_HEAP_SLAB                     0
+#define configHEAP_SLAB_CLASSES                 {{32, 64}, {64, 64}, {128, 32}, {256, 32}, {512, 16}}
+
+/* Record every live block with its call site for the heap_profile shell command, see heap_4_wrap.h.
+ * Costs about 10 KB of RAM with the table sizes below, debug builds only. */
+#define configUSE_HEAP_TRACKER                  0
+#define configHEAP_TRACKER_BLOCKS               512
+#define configHEAP_TRACKER_SITES                64
+
 #define configCHECK_FOR_STACK_OVERFLOW          2
 #define configRECORD_STACK_HIGH_ADDRESS         1
 
@@ -221,7 +236,23 @@ standard names. */
 
 #define portYIELD_FROM_ISR_WRAP portYIELD_FROM_ISR // TO_CHECK commented in Alexa
 
+#if (configUSE_HEAP_TRACKER == 1)
+/* Expanded inside pvPortMalloc, so the return address is the allocating call site */
+#define traceMALLOC(pv, size)                                                 \
+    do                                                                        \
+    {                                                                         \
+        vHeapTrackerMalloc((pv), (size), __builtin_return_address(0));        \
+        sln_shell_trace_malloc((pv), (size));                                 \
+    } while (0)
+#define traceFREE(pv, size)                                                   \
+    do                                                                        \
+    {                                                                         \
+        vHeapTrackerFree(pv);                                                 \
+        sln_shell_trace_free((pv), (size));                                   \
+    } while (0)
+#else
 #define traceMALLOC sln_shell_trace_malloc
 #define traceFREE   sln_shell_trace_free
+#endif
 
 #endif /* FREERTOS_CONFIG_H */
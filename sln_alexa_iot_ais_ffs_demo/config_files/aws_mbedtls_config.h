@@ -110,6 +110,7 @@
 #include "fsl_dcp.h"
 
 #define MBEDTLS_FREESCALE_DCP_AES    /* Enable use of DCP AES.*/
+#define MBEDTLS_FREESCALE_DCP_AES_GCM /* Enable use of DCP AES-CTR for GCM.*/
 #define MBEDTLS_FREESCALE_DCP_SHA1   /* Enable use of DCP SHA1.*/
 #define MBEDTLS_FREESCALE_DCP_SHA256 /* Enable use of DCP SHA256.*/
 
@@ -211,6 +212,9 @@
 #endif
 #if defined(MBEDTLS_FREESCALE_DCP_AES)
 #define MBEDTLS_AES_CRYPT_CBC_ALT
+/* The DCP has no 192/256-bit AES, ksdk_mbedtls.c runs such keys in the software rounds of aes_alt.c.
+ * NO_192 / NO_256 then only skip the CMAC and GCM self test vectors of those sizes: CTR_DRBG is kept
+ * on AES-128 by MBEDTLS_CTR_DRBG_USE_128_BIT_KEY, TLS by the MBEDTLS_SSL_CIPHERSUITES list below. */
 #define MBEDTLS_AES_ALT_NO_256
 #endif
 #if defined(MBEDTLS_FREESCALE_LTC_AES) || defined(MBEDTLS_FREESCALE_MMCAU_AES) || \
@@ -235,6 +239,9 @@
     defined(MBEDTLS_FREESCALE_CAAM_AES_GCM)
 #define MBEDTLS_GCM_CRYPT_ALT
 #endif
+#if defined(MBEDTLS_FREESCALE_DCP_AES_GCM)
+#define MBEDTLS_GCM_ALT
+#endif
 #if defined(MBEDTLS_FREESCALE_LTC_PKHA) || defined(MBEDTLS_FREESCALE_CAU3_PKHA) || defined(MBEDTLS_FREESCALE_CAAM_PKHA)
 #define MBEDTLS_MPI_ADD_ABS_ALT
 #define MBEDTLS_MPI_SUB_ABS_ALT
@@ -1608,7 +1615,7 @@ void *pvPortCalloc(size_t num, size_t size); /*Calloc for HEAP3.*/
  *
  * Comment this macro to disable support for SSL session tickets
  */
-//#define MBEDTLS_SSL_SESSION_TICKETS
+#define MBEDTLS_SSL_SESSION_TICKETS
 
 /**
  * \def MBEDTLS_SSL_EXPORT_KEYS
@@ -2968,8 +2975,9 @@ void *pvPortCalloc(size_t num, size_t size); /*Calloc for HEAP3.*/
  */
 //#define MBEDTLS_SSL_CIPHERSUITES MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
 
+/* AES-128 only, the suites with 256-bit keys would run in software */
 #if defined(MBEDTLS_FREESCALE_DCP_AES) && defined(MBEDTLS_AES_ALT_NO_256)
-#define MBEDTLS_SSL_CIPHERSUITES MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA,MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA
+#define MBEDTLS_SSL_CIPHERSUITES MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_CBC_SHA,MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256
 #endif
 
 /* X509 options */
@@ -65,6 +65,20 @@
  */
 #define pkcs11configPAL_DESTROY_SUPPORTED 0
 
+/**
+ * @brief Set to 1 to keep the objects read from flash in RAM.
+ *
+ * The certificate and keys are then read from flash once instead of on every
+ * TLS connection. Private key material is kept in a dedicated static area of
+ * pkcs11configPAL_PRIVATE_CACHE_SIZE bytes, wiped when the cache is invalidated.
+ */
+#define pkcs11configPAL_OBJECT_CACHE 1
+
+/**
+ * @brief Largest private key file kept in the object cache, bigger ones are read on every use.
+ */
+#define pkcs11configPAL_PRIVATE_CACHE_SIZE 2048
+
 /**
  * @brief Set to 1 if OTA image verification via PKCS #11 module is supported.
  *
@@ -67,6 +67,12 @@
  */
 #define LWIP_NETIF_LINK_CALLBACK 1
 
+/**
+ * LWIP_NETIF_STATUS_CALLBACK==1: Support a callback function whenever an interface
+ * changes its up/down status or its address.
+ */
+#define LWIP_NETIF_STATUS_CALLBACK 1
+
 /**
  * LWIP_NETIF_LOOPBACK==1: Support sending packets with a destination IP
  * address equal to the netif IP address, looping them back up the stack.
@@ -45,6 +45,14 @@ task.h is included from an application file. */
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+#if( configUSE_HEAP_SLAB == 1 )
+	/* heap_slab.c provides pvPortMalloc() and vPortFree() and falls through to
+	the allocator below for sizes its classes can't serve. */
+	#include "heap_slab.h"
+	#define pvPortMalloc	pvHeap4Malloc
+	#define vPortFree		vHeap4Free
+#endif
+
 #if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
 	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
 #endif
@@ -22,6 +22,7 @@
 #include "task.h"
 
 #include "heap_4_wrap.h"
+#include "heap_slab.h"
 #include <string.h>
 
 
@@ -61,6 +62,20 @@ void *pvPortRealloc( void *pv, size_t size )
     }
 
     //if( (pv != NULL) && (pvReturn != NULL) )
+#if( configUSE_HEAP_SLAB == 1 )
+    // Blocks served by a slab class have no xBlockLink_t, copy up to the class size
+    if((pv != NULL) && (xSlabGetBlockSize(pv) != 0)) {
+        xBlockSize = xSlabGetBlockSize(pv);
+
+        if(xBlockSize < size) {
+            memcpy(pvReturn, pv, xBlockSize);
+        } else {
+            memcpy(pvReturn, pv, size);
+        }
+
+        vPortFree(pv);
+    } else
+#endif
     if(pv != NULL) {
         // The memory being freed will have an xBlockLink_t structure immediately before it.
         puc -= getHeapStructSize();
@@ -23,6 +23,8 @@
 #include "heap_4.c"
 
 #include <assert.h>
+#include <stdbool.h>
+#include <string.h>
 
 // make sure our xBlockLink_t is the same as the one from heap_4.c (BlockLink_t)
 _Static_assert( sizeof(BlockLink_t) == sizeof(xBlockLink_t), "xBlockLink_t must match BlockLink_t from heap_4.c");
@@ -45,8 +47,6 @@ size_t getBlockAllocatedBit( void )
     return xBlockAllocatedBit;
 }
 
-/* NXP: we don't need this function and it triggers a compilation error, commenting it */
-#if 0
 /*
  * Walk through heap chunks and print out usage info on each chunk
  */
@@ -106,18 +106,432 @@ bool xUsed;
                 }
             }
         #endif
+        ( void ) pcTaskName;
 
         if( xUsed ) {
             // if allocated, print task id.
-            print_func("%d\t%ld\n", blockSize, uxTaskNumber);
+            print_func("%u\t%lu\n", (unsigned int)blockSize, (unsigned long)uxTaskNumber);
         }
         else
         {
             // if not allocated, no task id.
-            print_func("%d\n", blockSize);
+            print_func("%u\n", (unsigned int)blockSize);
+        }
+
+        if (blockSize == 0) {
+            print_func("Heap block corruption. End walking.\n");
+            return;
         }
 
         ptr += blockSize;
     }
 }
-#endif
+
+/*
+ * Free blocks histogram, walks the free list only
+ */
+size_t xHeapGetFreeHistogram( size_t *pxBins, size_t xBinCount )
+{
+BlockLink_t *pxBlock;
+size_t xLargest = 0;
+size_t xBin;
+size_t xSize;
+
+    if( ( pxBins != NULL ) && ( xBinCount > 0 ) )
+    {
+        memset( pxBins, 0, xBinCount * sizeof( size_t ) );
+    }
+
+    vTaskSuspendAll();
+    {
+        pxBlock = xStart.pxNextFreeBlock;
+
+        // NULL until the first allocation initialises the heap
+        while( ( pxBlock != NULL ) && ( pxBlock != pxEnd ) )
+        {
+            if( pxBlock->xBlockSize > xLargest )
+            {
+                xLargest = pxBlock->xBlockSize;
+            }
+
+            if( ( pxBins != NULL ) && ( xBinCount > 0 ) )
+            {
+                // Bin 0 holds blocks below 2^(heapHISTOGRAM_FIRST_SHIFT + 1) bytes, then one bin per power of two
+                xSize = pxBlock->xBlockSize >> heapHISTOGRAM_FIRST_SHIFT;
+                for( xBin = 0; ( xSize > 1 ) && ( xBin < xBinCount - 1 ); xBin++ )
+                {
+                    xSize >>= 1;
+                }
+                pxBins[ xBin ]++;
+            }
+
+            pxBlock = pxBlock->pxNextFreeBlock;
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return xLargest;
+}
+
+#if( configUSE_HEAP_TRACKER == 1 )
+
+#define heapTRACKER_EMPTY       ( ( uint16_t ) 0xFFFF )
+#define heapTRACKER_OTHER_SITE  ( configHEAP_TRACKER_SITES - 1 )
+
+_Static_assert( ( configHEAP_TRACKER_BLOCKS & ( configHEAP_TRACKER_BLOCKS - 1 ) ) == 0, "configHEAP_TRACKER_BLOCKS must be a power of two" );
+_Static_assert( configHEAP_TRACKER_SITES >= 2, "configHEAP_TRACKER_SITES needs room for the catch-all site" );
+
+// Side table entry of a live block; the heap_4 header is left untouched as vPortFree and pvPortRealloc check it
+typedef struct HEAP_TRACKED_BLOCK
+{
+    void *pv;
+    uint32_t ulSize;
+    TickType_t xTick;
+    uint16_t usSite;
+} HeapTrackedBlock_t;
+
+static HeapTrackedBlock_t xTrackedBlocks[ configHEAP_TRACKER_BLOCKS ];
+// Last entry collects the call sites that don't fit
+static HeapSiteStats_t xTrackedSites[ configHEAP_TRACKER_SITES ];
+static HeapTrendSample_t xTrend[ configHEAP_TRACKER_TREND_SAMPLES ];
+static size_t xTrendNext = 0;
+static size_t xTrendCount = 0;
+static size_t xUntrackedAllocations = 0;
+static BaseType_t xTrackerInitDone = pdFALSE;
+
+static size_t prvTrackerHash( const void *pv )
+{
+    // Blocks are 8 byte aligned, Fibonacci hashing spreads the remaining bits
+    return ( size_t ) ( ( ( ( uint32_t ) ( size_t ) pv >> 3 ) * 2654435761UL ) >> 8 );
+}
+
+static void prvTrackerInit( void )
+{
+size_t x;
+
+    for( x = 0; x < configHEAP_TRACKER_BLOCKS; x++ )
+    {
+        xTrackedBlocks[ x ].pv = NULL;
+        xTrackedBlocks[ x ].usSite = heapTRACKER_EMPTY;
+    }
+
+    memset( xTrackedSites, 0, sizeof( xTrackedSites ) );
+    xTrackerInitDone = pdTRUE;
+}
+
+static uint16_t prvTrackerSite( void *pvCaller )
+{
+size_t xIndex = prvTrackerHash( pvCaller ) % heapTRACKER_OTHER_SITE;
+size_t xProbe;
+
+    // Open addressing on the caller PC, sites are never removed
+    for( xProbe = 0; xProbe < heapTRACKER_OTHER_SITE; xProbe++ )
+    {
+        if( xTrackedSites[ xIndex ].pvCaller == pvCaller )
+        {
+            return ( uint16_t ) xIndex;
+        }
+
+        if( xTrackedSites[ xIndex ].pvCaller == NULL )
+        {
+            xTrackedSites[ xIndex ].pvCaller = pvCaller;
+            return ( uint16_t ) xIndex;
+        }
+
+        xIndex = ( xIndex + 1 ) % heapTRACKER_OTHER_SITE;
+    }
+
+    return heapTRACKER_OTHER_SITE;
+}
+
+static void prvTrackerSampleTrend( TickType_t xNow )
+{
+    if( ( xTrendCount == 0 ) ||
+        ( ( xNow - xTrend[ ( xTrendNext + configHEAP_TRACKER_TREND_SAMPLES - 1 ) % configHEAP_TRACKER_TREND_SAMPLES ].xTick ) >= pdMS_TO_TICKS( configHEAP_TRACKER_TREND_PERIOD_MS ) ) )
+    {
+        xTrend[ xTrendNext ].xTick = xNow;
+        xTrend[ xTrendNext ].xLargestFreeBlock = xHeapGetFreeHistogram( NULL, 0 );
+        xTrend[ xTrendNext ].xFreeBytes = xFreeBytesRemaining;
+
+        xTrendNext = ( xTrendNext + 1 ) % configHEAP_TRACKER_TREND_SAMPLES;
+        if( xTrendCount < configHEAP_TRACKER_TREND_SAMPLES )
+        {
+            xTrendCount++;
+        }
+    }
+}
+
+void vHeapTrackerMalloc( void *pv, size_t xSize, void *pvCaller )
+{
+size_t xIndex;
+size_t xProbe;
+uint16_t usSite;
+
+    if( pv == NULL )
+    {
+        return;
+    }
+
+    // heap_4 calls this with the scheduler suspended already, the lock-free slab classes do not
+    vTaskSuspendAll();
+    {
+        if( xTrackerInitDone == pdFALSE )
+        {
+            prvTrackerInit();
+        }
+
+        usSite = prvTrackerSite( pvCaller );
+        xTrackedSites[ usSite ].xAllocations++;
+        xTrackedSites[ usSite ].xAllocatedBytes += xSize;
+
+        xIndex = ( prvTrackerHash( pv ) & ( configHEAP_TRACKER_BLOCKS - 1 ) );
+        for( xProbe = 0; xProbe < configHEAP_TRACKER_BLOCKS; xProbe++ )
+        {
+            if( xTrackedBlocks[ xIndex ].usSite == heapTRACKER_EMPTY )
+            {
+                xTrackedBlocks[ xIndex ].pv = pv;
+                xTrackedBlocks[ xIndex ].ulSize = ( uint32_t ) xSize;
+                xTrackedBlocks[ xIndex ].xTick = xTaskGetTickCount();
+                xTrackedBlocks[ xIndex ].usSite = usSite;
+
+                xTrackedSites[ usSite ].xLiveBytes += xSize;
+                xTrackedSites[ usSite ].xLiveBlocks++;
+                break;
+            }
+
+            xIndex = ( xIndex + 1 ) & ( configHEAP_TRACKER_BLOCKS - 1 );
+        }
+
+        if( xProbe == configHEAP_TRACKER_BLOCKS )
+        {
+            xUntrackedAllocations++;
+        }
+
+        prvTrackerSampleTrend( xTaskGetTickCount() );
+    }
+    ( void ) xTaskResumeAll();
+}
+
+void vHeapTrackerFree( void *pv )
+{
+size_t xIndex;
+size_t xNext;
+size_t xHome;
+size_t xProbe;
+HeapSiteStats_t *pxSite;
+
+    if( ( pv == NULL ) || ( xTrackerInitDone == pdFALSE ) )
+    {
+        return;
+    }
+
+    vTaskSuspendAll();
+    {
+        xIndex = ( prvTrackerHash( pv ) & ( configHEAP_TRACKER_BLOCKS - 1 ) );
+        for( xProbe = 0; xProbe < configHEAP_TRACKER_BLOCKS; xProbe++ )
+        {
+            if( xTrackedBlocks[ xIndex ].usSite == heapTRACKER_EMPTY )
+            {
+                // Untracked block
+                break;
+            }
+
+            if( xTrackedBlocks[ xIndex ].pv == pv )
+            {
+                pxSite = &xTrackedSites[ xTrackedBlocks[ xIndex ].usSite ];
+                pxSite->xLiveBytes -= xTrackedBlocks[ xIndex ].ulSize;
+                pxSite->xLiveBlocks--;
+
+                // Backward shift deletion keeps every probe chain unbroken without tombstones. The hole is
+                // emptied first so the scan stops on it even when the table was full
+                xTrackedBlocks[ xIndex ].pv = NULL;
+                xTrackedBlocks[ xIndex ].usSite = heapTRACKER_EMPTY;
+
+                xNext = ( xIndex + 1 ) & ( configHEAP_TRACKER_BLOCKS - 1 );
+                while( xTrackedBlocks[ xNext ].usSite != heapTRACKER_EMPTY )
+                {
+                    xHome = ( prvTrackerHash( xTrackedBlocks[ xNext ].pv ) & ( configHEAP_TRACKER_BLOCKS - 1 ) );
+
+                    if( ( ( xNext - xHome ) & ( configHEAP_TRACKER_BLOCKS - 1 ) ) >= ( ( xNext - xIndex ) & ( configHEAP_TRACKER_BLOCKS - 1 ) ) )
+                    {
+                        xTrackedBlocks[ xIndex ] = xTrackedBlocks[ xNext ];
+                        xTrackedBlocks[ xNext ].pv = NULL;
+                        xTrackedBlocks[ xNext ].usSite = heapTRACKER_EMPTY;
+                        xIndex = xNext;
+                    }
+
+                    xNext = ( xNext + 1 ) & ( configHEAP_TRACKER_BLOCKS - 1 );
+                }
+                break;
+            }
+
+            xIndex = ( xIndex + 1 ) & ( configHEAP_TRACKER_BLOCKS - 1 );
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+
+size_t xHeapTrackerGetTopSites( HeapSiteStats_t *pxSites, size_t xMaxSites, BaseType_t xByChurn )
+{
+size_t xCount = 0;
+size_t xSite;
+size_t xPos;
+size_t xKey;
+
+    if( pxSites == NULL )
+    {
+        return 0;
+    }
+
+    vTaskSuspendAll();
+    {
+        // Insertion into a sorted array of xMaxSites entries, biggest first
+        for( xSite = 0; xSite < configHEAP_TRACKER_SITES; xSite++ )
+        {
+            if( xTrackedSites[ xSite ].xAllocations == 0 )
+            {
+                continue;
+            }
+
+            xKey = ( xByChurn != pdFALSE ) ? xTrackedSites[ xSite ].xAllocations : xTrackedSites[ xSite ].xLiveBytes;
+
+            for( xPos = xCount; xPos > 0; xPos-- )
+            {
+                if( ( ( xByChurn != pdFALSE ) ? pxSites[ xPos - 1 ].xAllocations : pxSites[ xPos - 1 ].xLiveBytes ) >= xKey )
+                {
+                    break;
+                }
+
+                if( xPos < xMaxSites )
+                {
+                    pxSites[ xPos ] = pxSites[ xPos - 1 ];
+                }
+            }
+
+            if( xPos < xMaxSites )
+            {
+                pxSites[ xPos ] = xTrackedSites[ xSite ];
+
+                if( xCount < xMaxSites )
+                {
+                    xCount++;
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return xCount;
+}
+
+size_t xHeapTrackerGetTrend( HeapTrendSample_t *pxSamples, size_t xMaxSamples )
+{
+size_t xCount = 0;
+size_t xFirst;
+
+    if( pxSamples == NULL )
+    {
+        return 0;
+    }
+
+    vTaskSuspendAll();
+    {
+        // Oldest first
+        xFirst = ( xTrendNext + configHEAP_TRACKER_TREND_SAMPLES - xTrendCount ) % configHEAP_TRACKER_TREND_SAMPLES;
+        for( xCount = 0; ( xCount < xTrendCount ) && ( xCount < xMaxSamples ); xCount++ )
+        {
+            pxSamples[ xCount ] = xTrend[ ( xFirst + xCount ) % configHEAP_TRACKER_TREND_SAMPLES ];
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return xCount;
+}
+
+size_t xHeapTrackerGetUntracked( void )
+{
+    return xUntrackedAllocations;
+}
+
+static uint8_t *prvExportPut( uint8_t *pucOut, uint32_t ulValue, size_t xBytes )
+{
+size_t x;
+
+    for( x = 0; x < xBytes; x++ )
+    {
+        *pucOut++ = ( uint8_t ) ( ulValue >> ( 8 * x ) );
+    }
+
+    return pucOut;
+}
+
+size_t xHeapTrackerExport( uint8_t *pucBuffer, size_t xLength )
+{
+uint8_t *pucOut = pucBuffer;
+size_t xSites = 0;
+size_t xSite;
+size_t xBin;
+size_t xSample;
+size_t xBins[ heapHISTOGRAM_BINS ];
+size_t xLargest;
+
+    if( ( pucBuffer == NULL ) || ( xLength < heapEXPORT_MAX_SIZE ) )
+    {
+        return 0;
+    }
+
+    xLargest = xHeapGetFreeHistogram( xBins, heapHISTOGRAM_BINS );
+
+    vTaskSuspendAll();
+    {
+        for( xSite = 0; xSite < configHEAP_TRACKER_SITES; xSite++ )
+        {
+            if( xTrackedSites[ xSite ].xAllocations != 0 )
+            {
+                xSites++;
+            }
+        }
+
+        pucOut = prvExportPut( pucOut, heapEXPORT_MAGIC, 4 );
+        pucOut = prvExportPut( pucOut, heapEXPORT_VERSION, 2 );
+        pucOut = prvExportPut( pucOut, xSites, 2 );
+        pucOut = prvExportPut( pucOut, heapHISTOGRAM_BINS, 2 );
+        pucOut = prvExportPut( pucOut, xTrendCount, 2 );
+        pucOut = prvExportPut( pucOut, xTaskGetTickCount(), 4 );
+        pucOut = prvExportPut( pucOut, xFreeBytesRemaining, 4 );
+        pucOut = prvExportPut( pucOut, xMinimumEverFreeBytesRemaining, 4 );
+        pucOut = prvExportPut( pucOut, xLargest, 4 );
+        pucOut = prvExportPut( pucOut, xUntrackedAllocations, 4 );
+
+        for( xSite = 0; xSite < configHEAP_TRACKER_SITES; xSite++ )
+        {
+            if( xTrackedSites[ xSite ].xAllocations != 0 )
+            {
+                pucOut = prvExportPut( pucOut, ( uint32_t ) ( size_t ) xTrackedSites[ xSite ].pvCaller, 4 );
+                pucOut = prvExportPut( pucOut, xTrackedSites[ xSite ].xLiveBytes, 4 );
+                pucOut = prvExportPut( pucOut, xTrackedSites[ xSite ].xLiveBlocks, 4 );
+                pucOut = prvExportPut( pucOut, xTrackedSites[ xSite ].xAllocations, 4 );
+                pucOut = prvExportPut( pucOut, xTrackedSites[ xSite ].xAllocatedBytes, 4 );
+            }
+        }
+
+        for( xBin = 0; xBin < heapHISTOGRAM_BINS; xBin++ )
+        {
+            pucOut = prvExportPut( pucOut, xBins[ xBin ], 4 );
+        }
+
+        xSample = ( xTrendNext + configHEAP_TRACKER_TREND_SAMPLES - xTrendCount ) % configHEAP_TRACKER_TREND_SAMPLES;
+        for( xBin = 0; xBin < xTrendCount; xBin++ )
+        {
+            pucOut = prvExportPut( pucOut, xTrend[ xSample ].xTick, 4 );
+            pucOut = prvExportPut( pucOut, xTrend[ xSample ].xLargestFreeBlock, 4 );
+            pucOut = prvExportPut( pucOut, xTrend[ xSample ].xFreeBytes, 4 );
+            xSample = ( xSample + 1 ) % configHEAP_TRACKER_TREND_SAMPLES;
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    return ( size_t ) ( pucOut - pucBuffer );
+}
+
+#endif /* configUSE_HEAP_TRACKER == 1 */
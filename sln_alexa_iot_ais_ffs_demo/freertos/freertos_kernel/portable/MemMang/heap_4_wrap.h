@@ -51,3 +51,111 @@ size_t getBlockAllocatedBit( void );
  *              error.
  */
 void walkHeap( int (*print_func)(const char*, ...) );
+
+/* Free block histogram: bin 0 counts blocks below 128 bytes, each next bin doubles, the last one is open ended */
+#define heapHISTOGRAM_FIRST_SHIFT  6
+#define heapHISTOGRAM_BINS         12
+
+/**
+ * @brief Count the free blocks of the heap per power of two size
+ *
+ * @param [out] pxBins: array receiving the count of each bin, can be NULL
+ * @param [in] xBinCount: number of entries in pxBins
+ *
+ * @return size of the largest free block
+ */
+size_t xHeapGetFreeHistogram( size_t *pxBins, size_t xBinCount );
+
+#ifndef configUSE_HEAP_TRACKER
+#define configUSE_HEAP_TRACKER 0
+#endif
+
+#if( configUSE_HEAP_TRACKER == 1 )
+
+/* Live blocks followed at once, power of two; allocations beyond it are only counted */
+#ifndef configHEAP_TRACKER_BLOCKS
+#define configHEAP_TRACKER_BLOCKS 512
+#endif
+
+/* Distinct call sites; the last one collects the sites that don't fit */
+#ifndef configHEAP_TRACKER_SITES
+#define configHEAP_TRACKER_SITES 64
+#endif
+
+#ifndef configHEAP_TRACKER_TREND_SAMPLES
+#define configHEAP_TRACKER_TREND_SAMPLES 60
+#endif
+
+#ifndef configHEAP_TRACKER_TREND_PERIOD_MS
+#define configHEAP_TRACKER_TREND_PERIOD_MS 1000
+#endif
+
+/*
+ * Export layout (little endian, decoded by scripts/heap_profile_report.py):
+ * |--magic(4)--|--version(2)--|--sites(2)--|--bins(2)--|--samples(2)--|--tick(4)--|
+ * |--free(4)--|--min free(4)--|--largest free(4)--|--untracked(4)--|
+ * sites   x |--pc(4)--|--live bytes(4)--|--live blocks(4)--|--allocations(4)--|--allocated bytes(4)--|
+ * bins    x |--free blocks(4)--|
+ * samples x |--tick(4)--|--largest free(4)--|--free(4)--|
+ */
+#define heapEXPORT_MAGIC    0x4B525448UL /* "HTRK" */
+#define heapEXPORT_VERSION  1
+#define heapEXPORT_MAX_SIZE ( 32 + ( configHEAP_TRACKER_SITES * 20 ) + ( heapHISTOGRAM_BINS * 4 ) + ( configHEAP_TRACKER_TREND_SAMPLES * 12 ) )
+
+typedef struct HEAP_SITE_STATS
+{
+    void *pvCaller;          /*<< Return address of the pvPortMalloc() call, NULL for the catch-all site. */
+    size_t xLiveBytes;       /*<< Bytes requested by this site and not freed yet. */
+    size_t xLiveBlocks;      /*<< Blocks allocated by this site and not freed yet. */
+    size_t xAllocations;     /*<< Allocations made by this site since boot. */
+    size_t xAllocatedBytes;  /*<< Bytes requested by this site since boot. */
+} HeapSiteStats_t;
+
+typedef struct HEAP_TREND_SAMPLE
+{
+    TickType_t xTick;          /*<< When the sample was taken. */
+    size_t xLargestFreeBlock;  /*<< Largest free block at that time. */
+    size_t xFreeBytes;         /*<< Total free bytes at that time. */
+} HeapTrendSample_t;
+
+/* traceMALLOC / traceFREE hooks, see FreeRTOSConfig.h */
+void vHeapTrackerMalloc( void *pv, size_t xSize, void *pvCaller );
+void vHeapTrackerFree( void *pv );
+
+/**
+ * @brief Get the call sites holding the most heap, or allocating the most often
+ *
+ * @param [out] pxSites: array receiving the sites, biggest first
+ * @param [in] xMaxSites: number of entries in pxSites
+ * @param [in] xByChurn: pdFALSE to sort by live bytes, pdTRUE by number of allocations
+ *
+ * @return number of sites written
+ */
+size_t xHeapTrackerGetTopSites( HeapSiteStats_t *pxSites, size_t xMaxSites, BaseType_t xByChurn );
+
+/**
+ * @brief Get the largest free block trend, sampled at most every configHEAP_TRACKER_TREND_PERIOD_MS
+ *
+ * @param [out] pxSamples: array receiving the samples, oldest first
+ * @param [in] xMaxSamples: number of entries in pxSamples
+ *
+ * @return number of samples written
+ */
+size_t xHeapTrackerGetTrend( HeapTrendSample_t *pxSamples, size_t xMaxSamples );
+
+/**
+ * @brief Number of allocations not followed because the block table was full
+ */
+size_t xHeapTrackerGetUntracked( void );
+
+/**
+ * @brief Serialize sites, free block histogram and trend for the host side report
+ *
+ * @param [out] pucBuffer: buffer receiving the export
+ * @param [in] xLength: size of pucBuffer, at least heapEXPORT_MAX_SIZE
+ *
+ * @return bytes written, 0 if the buffer is too small
+ */
+size_t xHeapTrackerExport( uint8_t *pucBuffer, size_t xLength );
+
+#endif /* configUSE_HEAP_TRACKER == 1 */
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+/*******************************************************************************
+ * @file heap_slab.c
+ *
+ * @brief size class pools served in front of heap_4
+ *******************************************************************************
+ */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "heap_slab.h"
+
+#if( configUSE_HEAP_SLAB == 1 )
+
+// Free list head: index + 1 of the first free block in the low half (0 when empty),
+// a tag bumped on every change in the high half so a stale compare-and-swap fails.
+#define slabHEAD_INDEX_MASK  0x0000FFFFUL
+#define slabHEAD_TAG_MASK    0xFFFF0000UL
+#define slabHEAD_TAG_ONE     0x00010000UL
+#define slabMAX_BLOCK_COUNT  0xFFFEUL
+
+typedef struct SLAB_CONFIG
+{
+    uint16_t usBlockSize;
+    uint16_t usBlockCount;
+} SlabConfig_t;
+
+typedef struct SLAB_CLASS
+{
+    size_t xBlockSize;
+    size_t xBlockCount;
+    uint8_t *pucStart;
+    uint8_t *pucEnd;
+    uint32_t ulFreeHead;
+    uint32_t ulInUse;
+    uint32_t ulHighWater;
+    uint32_t ulAllocations;
+    uint32_t ulFallThroughs;
+} SlabClass_t;
+
+static const SlabConfig_t xSlabConfig[] = configHEAP_SLAB_CLASSES;
+
+#define slabCLASS_COUNT ( sizeof( xSlabConfig ) / sizeof( xSlabConfig[ 0 ] ) )
+
+static SlabClass_t xSlabClasses[ slabCLASS_COUNT ];
+
+// All classes live in one heap_4 block, pointers in this range belong to a class.
+static uint8_t *pucSlabStart = NULL;
+static uint8_t *pucSlabEnd = NULL;
+static volatile BaseType_t xSlabInitDone = pdFALSE;
+
+/*-----------------------------------------------------------*/
+
+static void prvSlabInit( void )
+{
+size_t xTotalSize = 0;
+size_t xClass;
+size_t xBlock;
+uint8_t *pucBlock;
+
+    vTaskSuspendAll();
+    {
+        if( xSlabInitDone == pdFALSE )
+        {
+            for( xClass = 0; xClass < slabCLASS_COUNT; xClass++ )
+            {
+                configASSERT( ( xSlabConfig[ xClass ].usBlockSize & portBYTE_ALIGNMENT_MASK ) == 0 );
+                configASSERT( xSlabConfig[ xClass ].usBlockSize >= sizeof( uint16_t ) );
+                configASSERT( xSlabConfig[ xClass ].usBlockCount <= slabMAX_BLOCK_COUNT );
+                configASSERT( ( xClass == 0 ) || ( xSlabConfig[ xClass ].usBlockSize > xSlabConfig[ xClass - 1 ].usBlockSize ) );
+
+                xTotalSize += ( size_t ) xSlabConfig[ xClass ].usBlockSize * xSlabConfig[ xClass ].usBlockCount;
+            }
+
+            // Taken first, the pools sit at the bottom of heap_4 for good
+            pucSlabStart = ( uint8_t * ) pvHeap4Malloc( xTotalSize );
+
+            if( pucSlabStart != NULL )
+            {
+                pucBlock = pucSlabStart;
+
+                for( xClass = 0; xClass < slabCLASS_COUNT; xClass++ )
+                {
+                    SlabClass_t *pxClass = &xSlabClasses[ xClass ];
+
+                    pxClass->xBlockSize = xSlabConfig[ xClass ].usBlockSize;
+                    pxClass->xBlockCount = xSlabConfig[ xClass ].usBlockCount;
+                    pxClass->pucStart = pucBlock;
+                    pxClass->pucEnd = pucBlock + ( pxClass->xBlockSize * pxClass->xBlockCount );
+
+                    // Chain every block to the next one, the last one ends the list
+                    for( xBlock = 0; xBlock < pxClass->xBlockCount; xBlock++ )
+                    {
+                        *( uint16_t * ) pucBlock = ( xBlock + 1 < pxClass->xBlockCount ) ? ( uint16_t ) ( xBlock + 2 ) : 0;
+                        pucBlock += pxClass->xBlockSize;
+                    }
+
+                    pxClass->ulFreeHead = ( pxClass->xBlockCount > 0 ) ? 1 : 0;
+                }
+
+                pucSlabEnd = pucBlock;
+            }
+
+            // Not retried if heap_4 couldn't give the pools, everything falls through
+            xSlabInitDone = pdTRUE;
+        }
+    }
+    ( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+static void *prvSlabPop( SlabClass_t *pxClass )
+{
+uint32_t ulOldHead;
+uint32_t ulNewHead;
+uint32_t ulIndex;
+uint8_t *pucBlock;
+
+    ulOldHead = __atomic_load_n( &pxClass->ulFreeHead, __ATOMIC_ACQUIRE );
+
+    do
+    {
+        ulIndex = ulOldHead & slabHEAD_INDEX_MASK;
+
+        if( ulIndex == 0 )
+        {
+            return NULL;
+        }
+
+        // The link may be stale if another task wins the race, the tag then fails the swap
+        pucBlock = pxClass->pucStart + ( ( ulIndex - 1 ) * pxClass->xBlockSize );
+        ulNewHead = ( ( ulOldHead + slabHEAD_TAG_ONE ) & slabHEAD_TAG_MASK ) | *( volatile uint16_t * ) pucBlock;
+    } while( __atomic_compare_exchange_n( &pxClass->ulFreeHead, &ulOldHead, ulNewHead, pdFALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) == 0 );
+
+    return pucBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSlabPush( SlabClass_t *pxClass, uint8_t *pucBlock )
+{
+uint32_t ulOldHead;
+uint32_t ulNewHead;
+uint32_t ulIndex = ( ( size_t ) ( pucBlock - pxClass->pucStart ) / pxClass->xBlockSize ) + 1;
+
+    ulOldHead = __atomic_load_n( &pxClass->ulFreeHead, __ATOMIC_ACQUIRE );
+
+    do
+    {
+        *( volatile uint16_t * ) pucBlock = ( uint16_t ) ( ulOldHead & slabHEAD_INDEX_MASK );
+        ulNewHead = ( ( ulOldHead + slabHEAD_TAG_ONE ) & slabHEAD_TAG_MASK ) | ulIndex;
+    } while( __atomic_compare_exchange_n( &pxClass->ulFreeHead, &ulOldHead, ulNewHead, pdFALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static SlabClass_t *prvSlabFindClass( void *pv )
+{
+SlabClass_t *pxClass = NULL;
+size_t xClass;
+
+    if( ( ( uint8_t * ) pv >= pucSlabStart ) && ( ( uint8_t * ) pv < pucSlabEnd ) )
+    {
+        for( xClass = 0; xClass < slabCLASS_COUNT; xClass++ )
+        {
+            if( ( uint8_t * ) pv < xSlabClasses[ xClass ].pucEnd )
+            {
+                pxClass = &xSlabClasses[ xClass ];
+                break;
+            }
+        }
+    }
+
+    return pxClass;
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+void *pvReturn = NULL;
+size_t xClass;
+uint32_t ulInUse;
+uint32_t ulHighWater;
+
+    if( xSlabInitDone == pdFALSE )
+    {
+        prvSlabInit();
+    }
+
+    if( ( xWantedSize > 0 ) && ( pucSlabStart != NULL ) )
+    {
+        for( xClass = 0; xClass < slabCLASS_COUNT; xClass++ )
+        {
+            SlabClass_t *pxClass = &xSlabClasses[ xClass ];
+
+            if( xWantedSize <= pxClass->xBlockSize )
+            {
+                pvReturn = prvSlabPop( pxClass );
+
+                if( pvReturn != NULL )
+                {
+                    ulInUse = __atomic_add_fetch( &pxClass->ulInUse, 1, __ATOMIC_RELAXED );
+                    __atomic_add_fetch( &pxClass->ulAllocations, 1, __ATOMIC_RELAXED );
+
+                    ulHighWater = __atomic_load_n( &pxClass->ulHighWater, __ATOMIC_RELAXED );
+                    while( ( ulInUse > ulHighWater ) &&
+                           ( __atomic_compare_exchange_n( &pxClass->ulHighWater, &ulHighWater, ulInUse, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) == 0 ) )
+                    {
+                    }
+
+                    traceMALLOC( pvReturn, pxClass->xBlockSize );
+                }
+                else
+                {
+                    __atomic_add_fetch( &pxClass->ulFallThroughs, 1, __ATOMIC_RELAXED );
+                }
+
+                // A bigger class is not tried, it would only move the pressure
+                break;
+            }
+        }
+    }
+
+    if( pvReturn == NULL )
+    {
+        pvReturn = pvHeap4Malloc( xWantedSize );
+    }
+
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+SlabClass_t *pxClass = prvSlabFindClass( pv );
+
+    if( pxClass != NULL )
+    {
+        // Must be the start of a block
+        configASSERT( ( ( size_t ) ( ( uint8_t * ) pv - pxClass->pucStart ) % pxClass->xBlockSize ) == 0 );
+
+        traceFREE( pv, pxClass->xBlockSize );
+
+        prvSlabPush( pxClass, ( uint8_t * ) pv );
+        __atomic_sub_fetch( &pxClass->ulInUse, 1, __ATOMIC_RELAXED );
+    }
+    else
+    {
+        vHeap4Free( pv );
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xSlabGetBlockSize( void *pv )
+{
+SlabClass_t *pxClass = prvSlabFindClass( pv );
+
+    return ( pxClass != NULL ) ? pxClass->xBlockSize : 0;
+}
+/*-----------------------------------------------------------*/
+
+size_t xSlabGetStats( SlabStats_t *pxStats, size_t xMaxClasses )
+{
+size_t xClass;
+
+    if( ( pxStats == NULL ) || ( pucSlabStart == NULL ) )
+    {
+        return 0;
+    }
+
+    for( xClass = 0; ( xClass < slabCLASS_COUNT ) && ( xClass < xMaxClasses ); xClass++ )
+    {
+        pxStats[ xClass ].xBlockSize = xSlabClasses[ xClass ].xBlockSize;
+        pxStats[ xClass ].xBlockCount = xSlabClasses[ xClass ].xBlockCount;
+        pxStats[ xClass ].xInUse = __atomic_load_n( &xSlabClasses[ xClass ].ulInUse, __ATOMIC_RELAXED );
+        pxStats[ xClass ].xHighWater = __atomic_load_n( &xSlabClasses[ xClass ].ulHighWater, __ATOMIC_RELAXED );
+        pxStats[ xClass ].xAllocations = __atomic_load_n( &xSlabClasses[ xClass ].ulAllocations, __ATOMIC_RELAXED );
+        pxStats[ xClass ].xFallThroughs = __atomic_load_n( &xSlabClasses[ xClass ].ulFallThroughs, __ATOMIC_RELAXED );
+    }
+
+    return xClass;
+}
+
+#endif /* configUSE_HEAP_SLAB == 1 */
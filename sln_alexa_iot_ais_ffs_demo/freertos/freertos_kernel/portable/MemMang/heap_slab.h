@@ -0,0 +1,71 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+/*******************************************************************************
+ * @file heap_slab.h
+ *
+ * @brief size class pools served in front of heap_4
+ *
+ * With configUSE_HEAP_SLAB set to 1, pvPortMalloc() first tries the smallest
+ * class of configHEAP_SLAB_CLASSES that fits the request. Each class is a
+ * lock-free free list of fixed size blocks carved from heap_4 on the first
+ * allocation, so short lived small buffers no longer split the heap_4 free
+ * list. Requests bigger than the largest class, or hitting an empty class,
+ * fall through to heap_4.
+ *******************************************************************************
+ */
+
+#pragma once
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+
+#ifndef configUSE_HEAP_SLAB
+#define configUSE_HEAP_SLAB 0
+#endif
+
+/* { block size, block count } per class, sizes ascending and multiple of portBYTE_ALIGNMENT */
+#ifndef configHEAP_SLAB_CLASSES
+#define configHEAP_SLAB_CLASSES \
+    {                           \
+        {32, 64}, {64, 64}, {128, 32}, {256, 32}, {512, 16}, \
+    }
+#endif
+
+typedef struct SLAB_STATS
+{
+    size_t xBlockSize;     /*<< Size of the blocks of the class. */
+    size_t xBlockCount;    /*<< Number of blocks of the class. */
+    size_t xInUse;         /*<< Blocks currently allocated. */
+    size_t xHighWater;     /*<< Most blocks ever allocated at once. */
+    size_t xAllocations;   /*<< Successful allocations from the class. */
+    size_t xFallThroughs;  /*<< Requests sent to heap_4 because the class was empty. */
+} SlabStats_t;
+
+/* heap_4 allocator, renamed when configUSE_HEAP_SLAB is 1 */
+void *pvHeap4Malloc( size_t xWantedSize );
+void vHeap4Free( void *pv );
+
+/**
+ * @brief Get the usable size of a block served by a slab class
+ *
+ * @param [in] pv: block returned by pvPortMalloc()
+ *
+ * @return size of the class, 0 if pv was not served by a class
+ */
+size_t xSlabGetBlockSize( void *pv );
+
+/**
+ * @brief Get the statistics of each slab class
+ *
+ * @param [out] pxStats: array receiving one entry per class
+ * @param [in] xMaxClasses: number of entries in pxStats
+ *
+ * @return number of classes written, 0 if the classes are not set up yet
+ */
+size_t xSlabGetStats( SlabStats_t *pxStats, size_t xMaxClasses );
@@ -43,9 +43,21 @@
 #define TLS_ERROR_SIGN                ( -2003 ) /*!< Error in sign operation. */
 #define TLS_ERROR_NO_PRIVATE_KEY      ( -2004 ) /*!< Private key was not provisioned. */
 #define TLS_ERROR_NO_CERTIFICATE      ( -2005 ) /*!< Client certificate not provisioned. */
+#define TLS_ERROR_NO_SESSION          ( -2006 ) /*!< No cached session to export. */
+#define TLS_ERROR_SESSION_FORMAT      ( -2007 ) /*!< Session blob is malformed or does not fit. */
 
 /**@} */
 
+/**
+ * @brief Largest blob produced by TLS_SessionExport.
+ */
+#define TLS_SESSION_BLOB_MAX_LENGTH    ( 768 )
+
+/**
+ * @brief Longest session ID reported by TLS_SessionGetInfo.
+ */
+#define TLS_SESSION_ID_MAX_LENGTH      ( 32 )
+
 /**
  * @brief Defines callback type for receiving bytes from the network.
  *
@@ -153,4 +165,60 @@ BaseType_t TLS_Send( void * pvContext,
  */
 void TLS_Cleanup( void * pvContext );
 
+/**
+ * @brief Serializes the cached client session so it can be kept across reboots.
+ *
+ * The last session negotiated by TLS_Connect (session ticket or session ID)
+ * is cached in RAM and offered on the next TLS_Connect to the same destination.
+ * The blob holds the session master secret and must only be stored encrypted.
+ * The peer certificate is not part of it, resumed sessions do not need it.
+ *
+ * @param[out] pucBuffer Buffer receiving the blob, NULL to query the length.
+ * @param[in] xBufferLength Length of pucBuffer in bytes.
+ * @param[out] pxOutLength Length of the blob.
+ *
+ * @return 0 on success, TLS_ERROR_NO_SESSION or TLS_ERROR_SESSION_FORMAT otherwise.
+ */
+BaseType_t TLS_SessionExport( uint8_t * pucBuffer,
+                              size_t xBufferLength,
+                              size_t * pxOutLength );
+
+/**
+ * @brief Describes the cached client session.
+ *
+ * A resumed session keeps its master secret, but the server may have renewed
+ * its ticket, so its blob can still differ from the one exported before.
+ * A session without a ticket keeps its ID when resumed. With a ticket, the
+ * client draws a new random ID for every handshake.
+ *
+ * @param[out] pucSessionId Buffer of TLS_SESSION_ID_MAX_LENGTH bytes receiving
+ * the session ID, can be NULL.
+ * @param[out] pxSessionIdLength Length of the session ID, can be NULL.
+ * @param[out] pxResumed pdTRUE if the last TLS_Connect resumed the cached session.
+ * @param[out] pulTicketLifetime Ticket lifetime hint in seconds, 0 if the session
+ * has no ticket or the server gave no hint.
+ *
+ * @return 0 on success, TLS_ERROR_NO_SESSION otherwise.
+ */
+BaseType_t TLS_SessionGetInfo( uint8_t * pucSessionId,
+                               size_t * pxSessionIdLength,
+                               BaseType_t * pxResumed,
+                               uint32_t * pulTicketLifetime );
+
+/**
+ * @brief Restores a session cache previously saved with TLS_SessionExport.
+ *
+ * @param[in] pucBuffer Blob from TLS_SessionExport.
+ * @param[in] xBufferLength Length of pucBuffer in bytes.
+ *
+ * @return 0 on success, TLS_ERROR_SESSION_FORMAT otherwise.
+ */
+BaseType_t TLS_SessionImport( const uint8_t * pucBuffer,
+                              size_t xBufferLength );
+
+/**
+ * @brief Drops the cached session, the next TLS_Connect does a full handshake.
+ */
+void TLS_SessionInvalidate( void );
+
 #endif /* ifndef __AWS__TLS__H__ */
@@ -35,6 +35,7 @@
 #include "iot_pkcs11_config.h"
 #include "iot_pkcs11.h"
 #include "task.h"
+#include "semphr.h"
 
 #if SSS_HAVE_ALT_A71CH
 #  include "ax_mbedtls.h"
@@ -123,6 +124,36 @@ typedef struct TLSContext
 
 #define TLS_PRINT( X )    vLoggingPrintf X
 
+/**
+ * @brief Client side session cache.
+ *
+ * The session of the last successful handshake is kept in RAM and offered on
+ * the next connection to the same destination, so a reconnect can skip the
+ * key exchange and the certificate chain verification. mbedTLS falls back to
+ * a full handshake by itself when the server does not resume the session.
+ */
+#ifndef tlsSESSION_CACHE_ENABLED
+    #define tlsSESSION_CACHE_ENABLED    1
+#endif
+
+#if ( tlsSESSION_CACHE_ENABLED == 1 )
+    #define tlsSESSION_DESTINATION_MAX_LENGTH    ( 128 )
+    #define tlsSESSION_TICKET_MAX_LENGTH         ( 512 )
+    #define tlsSESSION_BLOB_VERSION              ( 1 )
+
+    typedef struct TLSSessionCache
+    {
+        BaseType_t xValid;
+        BaseType_t xResumed; /* The last handshake resumed the session cached before it. */
+        char cDestination[ tlsSESSION_DESTINATION_MAX_LENGTH ];
+        mbedtls_ssl_session xSession;
+    } TLSSessionCache_t;
+
+    static TLSSessionCache_t xSessionCache;
+    static SemaphoreHandle_t xSessionCacheMutex = NULL;
+    static StaticSemaphore_t xSessionCacheMutexBuffer;
+#endif /* tlsSESSION_CACHE_ENABLED */
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -686,6 +717,133 @@ static int prvInitializeClientCredential( TLSContext_t * pxCtx )
 
 /*-----------------------------------------------------------*/
 
+#if ( tlsSESSION_CACHE_ENABLED == 1 )
+
+/**
+ * @brief Lazily creates the session cache mutex and takes it.
+ */
+    static void prvSessionCacheLock( void )
+    {
+        if( NULL == xSessionCacheMutex )
+        {
+            taskENTER_CRITICAL();
+
+            if( NULL == xSessionCacheMutex )
+            {
+                xSessionCacheMutex = xSemaphoreCreateMutexStatic( &xSessionCacheMutexBuffer );
+            }
+
+            taskEXIT_CRITICAL();
+        }
+
+        ( void ) xSemaphoreTake( xSessionCacheMutex, portMAX_DELAY );
+    }
+
+    static void prvSessionCacheUnlock( void )
+    {
+        ( void ) xSemaphoreGive( xSessionCacheMutex );
+    }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Drops the cached session. Must be called with the cache locked.
+ */
+    static void prvSessionCacheClear( void )
+    {
+        mbedtls_ssl_session_free( &xSessionCache.xSession );
+        memset( &xSessionCache, 0, sizeof( xSessionCache ) );
+    }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Offers the cached session for this connection, if it was made to the same destination.
+ *
+ * @return pdTRUE if a session was offered to the server.
+ */
+    static BaseType_t prvSessionCacheApply( TLSContext_t * pxCtx )
+    {
+        BaseType_t xOffered = pdFALSE;
+
+        prvSessionCacheLock();
+
+        if( ( pdTRUE == xSessionCache.xValid ) &&
+            ( NULL != pxCtx->pcDestination ) &&
+            ( 0 == strncmp( xSessionCache.cDestination, pxCtx->pcDestination, tlsSESSION_DESTINATION_MAX_LENGTH ) ) )
+        {
+            if( 0 == mbedtls_ssl_set_session( &pxCtx->xMbedSslCtx, &xSessionCache.xSession ) )
+            {
+                xOffered = pdTRUE;
+            }
+        }
+
+        prvSessionCacheUnlock();
+
+        return xOffered;
+    }
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Caches the session negotiated by a successful handshake.
+ *
+ * @param[in] xOffered Whether a cached session was offered for this handshake.
+ */
+    static void prvSessionCacheStore( TLSContext_t * pxCtx,
+                                      BaseType_t xOffered )
+    {
+        mbedtls_ssl_session xSession;
+        BaseType_t xResumed = pdFALSE;
+
+        if( ( NULL == pxCtx->pcDestination ) ||
+            ( strlen( pxCtx->pcDestination ) >= tlsSESSION_DESTINATION_MAX_LENGTH ) )
+        {
+            return;
+        }
+
+        mbedtls_ssl_session_init( &xSession );
+
+        if( 0 == mbedtls_ssl_get_session( &pxCtx->xMbedSslCtx, &xSession ) )
+        {
+            #if defined( MBEDTLS_X509_CRT_PARSE_C )
+                /* A resumed handshake does not look at the peer certificate,
+                 * do not keep a copy of the chain around. */
+                if( NULL != xSession.peer_cert )
+                {
+                    mbedtls_x509_crt_free( xSession.peer_cert );
+                    mbedtls_free( xSession.peer_cert );
+                    xSession.peer_cert = NULL;
+                }
+            #endif
+
+            prvSessionCacheLock();
+
+            /* The master secret only survives a handshake that resumed the session. */
+            xResumed = ( ( pdTRUE == xOffered ) &&
+                         ( pdTRUE == xSessionCache.xValid ) &&
+                         ( 0 == memcmp( xSession.master, xSessionCache.xSession.master, sizeof( xSession.master ) ) ) );
+
+            prvSessionCacheClear();
+            xSessionCache.xSession = xSession;
+            strncpy( xSessionCache.cDestination, pxCtx->pcDestination, tlsSESSION_DESTINATION_MAX_LENGTH - 1 );
+            xSessionCache.xValid = pdTRUE;
+            xSessionCache.xResumed = xResumed;
+
+            prvSessionCacheUnlock();
+
+            TLS_PRINT( ( "TLS session %s\r\n", ( pdTRUE == xResumed ) ? "resumed" : "established" ) );
+        }
+        else
+        {
+            mbedtls_ssl_session_free( &xSession );
+        }
+    }
+
+#endif /* tlsSESSION_CACHE_ENABLED */
+
+/*-----------------------------------------------------------*/
+
 /*
  * Interface routines.
  */
@@ -764,6 +922,7 @@ BaseType_t TLS_Connect( void * pvContext )
 {
     BaseType_t xResult = 0;
     TLSContext_t * pxCtx = ( TLSContext_t * ) pvContext; /*lint !e9087 !e9079 Allow casting void* to other types. */
+    BaseType_t xSessionOffered = pdFALSE;
 
     /* Ensure that the FreeRTOS heap is used. */
     CRYPTO_ConfigureHeap();
@@ -902,6 +1061,14 @@ BaseType_t TLS_Connect( void * pvContext )
         xResult = mbedtls_ssl_set_hostname( &pxCtx->xMbedSslCtx, pxCtx->pcDestination );
     }
 
+    #if ( tlsSESSION_CACHE_ENABLED == 1 )
+        /* Try to resume the previous session first. */
+        if( 0 == xResult )
+        {
+            xSessionOffered = prvSessionCacheApply( pxCtx );
+        }
+    #endif
+
     /* Set the socket callbacks. */
     if( 0 == xResult )
     {
@@ -922,6 +1089,15 @@ BaseType_t TLS_Connect( void * pvContext )
                  * a context that failed the handshake. */
                 prvFreeContext( pxCtx );
                 TLS_PRINT( ( "ERROR: Handshake failed with error code %d \r\n", xResult ) );
+
+                #if ( tlsSESSION_CACHE_ENABLED == 1 )
+                    /* Do not offer the same session again, the caller's
+                     * retry then falls back to a full handshake. */
+                    if( pdTRUE == xSessionOffered )
+                    {
+                        TLS_SessionInvalidate();
+                    }
+                #endif
                 break;
             }
         }
@@ -931,6 +1107,10 @@ BaseType_t TLS_Connect( void * pvContext )
     if( 0 == xResult )
     {
         pxCtx->xTLSHandshakeSuccessful = pdTRUE;
+
+        #if ( tlsSESSION_CACHE_ENABLED == 1 )
+            prvSessionCacheStore( pxCtx, xSessionOffered );
+        #endif
     }
     else if( xResult > 0 )
     {
@@ -1064,3 +1244,335 @@ void TLS_Cleanup( void * pvContext )
         vPortFree( pxCtx );
     }
 }
+
+/*-----------------------------------------------------------*/
+
+#if ( tlsSESSION_CACHE_ENABLED == 1 )
+
+/* Session blob layout, little endian:
+ * version(1) | destination length(1) | destination | ciphersuite(4) | compression(4) |
+ * id length(1) | id(32) | master(48) | verify result(4) |
+ * [ticket length(4) | ticket lifetime(4) | ticket] | [mfl code(1)] | [encrypt then mac(1)] */
+
+    static void prvBlobPut( uint8_t * pucBlob,
+                            size_t * pxPos,
+                            const void * pvData,
+                            size_t xLength )
+    {
+        if( NULL != pucBlob )
+        {
+            memcpy( pucBlob + *pxPos, pvData, xLength );
+        }
+
+        *pxPos += xLength;
+    }
+
+    static void prvBlobPutU32( uint8_t * pucBlob,
+                               size_t * pxPos,
+                               uint32_t ulValue )
+    {
+        uint8_t ucBytes[ 4 ] = { ( uint8_t ) ulValue, ( uint8_t ) ( ulValue >> 8 ),
+                                 ( uint8_t ) ( ulValue >> 16 ), ( uint8_t ) ( ulValue >> 24 ) };
+
+        prvBlobPut( pucBlob, pxPos, ucBytes, sizeof( ucBytes ) );
+    }
+
+    static BaseType_t prvBlobGet( const uint8_t * pucBlob,
+                                  size_t xBlobLength,
+                                  size_t * pxPos,
+                                  void * pvData,
+                                  size_t xLength )
+    {
+        BaseType_t xResult = pdFALSE;
+
+        if( ( xLength <= xBlobLength ) && ( *pxPos <= xBlobLength - xLength ) )
+        {
+            memcpy( pvData, pucBlob + *pxPos, xLength );
+            *pxPos += xLength;
+            xResult = pdTRUE;
+        }
+
+        return xResult;
+    }
+
+    static BaseType_t prvBlobGetU32( const uint8_t * pucBlob,
+                                     size_t xBlobLength,
+                                     size_t * pxPos,
+                                     uint32_t * pulValue )
+    {
+        uint8_t ucBytes[ 4 ] = { 0 };
+        BaseType_t xResult = prvBlobGet( pucBlob, xBlobLength, pxPos, ucBytes, sizeof( ucBytes ) );
+
+        *pulValue = ( ( uint32_t ) ucBytes[ 0 ] ) | ( ( uint32_t ) ucBytes[ 1 ] << 8 ) |
+                    ( ( uint32_t ) ucBytes[ 2 ] << 16 ) | ( ( uint32_t ) ucBytes[ 3 ] << 24 );
+
+        return xResult;
+    }
+
+    static size_t prvSessionSerialize( uint8_t * pucBlob )
+    {
+        const mbedtls_ssl_session * pxSession = &xSessionCache.xSession;
+        size_t xPos = 0;
+        uint8_t ucByte = 0;
+
+        ucByte = tlsSESSION_BLOB_VERSION;
+        prvBlobPut( pucBlob, &xPos, &ucByte, 1 );
+        ucByte = ( uint8_t ) strlen( xSessionCache.cDestination );
+        prvBlobPut( pucBlob, &xPos, &ucByte, 1 );
+        prvBlobPut( pucBlob, &xPos, xSessionCache.cDestination, ucByte );
+        prvBlobPutU32( pucBlob, &xPos, ( uint32_t ) pxSession->ciphersuite );
+        prvBlobPutU32( pucBlob, &xPos, ( uint32_t ) pxSession->compression );
+        ucByte = ( uint8_t ) pxSession->id_len;
+        prvBlobPut( pucBlob, &xPos, &ucByte, 1 );
+        prvBlobPut( pucBlob, &xPos, pxSession->id, sizeof( pxSession->id ) );
+        prvBlobPut( pucBlob, &xPos, pxSession->master, sizeof( pxSession->master ) );
+        prvBlobPutU32( pucBlob, &xPos, pxSession->verify_result );
+
+        #if defined( MBEDTLS_SSL_SESSION_TICKETS ) && defined( MBEDTLS_SSL_CLI_C )
+            prvBlobPutU32( pucBlob, &xPos, ( uint32_t ) pxSession->ticket_len );
+            prvBlobPutU32( pucBlob, &xPos, pxSession->ticket_lifetime );
+            prvBlobPut( pucBlob, &xPos, pxSession->ticket, pxSession->ticket_len );
+        #endif
+
+        #if defined( MBEDTLS_SSL_MAX_FRAGMENT_LENGTH )
+            prvBlobPut( pucBlob, &xPos, &pxSession->mfl_code, 1 );
+        #endif
+
+        #if defined( MBEDTLS_SSL_TRUNCATED_HMAC )
+            ucByte = ( uint8_t ) pxSession->trunc_hmac;
+            prvBlobPut( pucBlob, &xPos, &ucByte, 1 );
+        #endif
+
+        #if defined( MBEDTLS_SSL_ENCRYPT_THEN_MAC )
+            ucByte = ( uint8_t ) pxSession->encrypt_then_mac;
+            prvBlobPut( pucBlob, &xPos, &ucByte, 1 );
+        #endif
+
+        return xPos;
+    }
+
+#endif /* tlsSESSION_CACHE_ENABLED */
+
+/*-----------------------------------------------------------*/
+
+BaseType_t TLS_SessionExport( uint8_t * pucBuffer,
+                              size_t xBufferLength,
+                              size_t * pxOutLength )
+{
+    BaseType_t xResult = TLS_ERROR_NO_SESSION;
+
+    #if ( tlsSESSION_CACHE_ENABLED == 1 )
+        size_t xLength = 0;
+
+        prvSessionCacheLock();
+
+        if( pdTRUE == xSessionCache.xValid )
+        {
+            xLength = prvSessionSerialize( NULL );
+
+            if( ( xLength > TLS_SESSION_BLOB_MAX_LENGTH ) ||
+                ( ( NULL != pucBuffer ) && ( xLength > xBufferLength ) ) )
+            {
+                xResult = TLS_ERROR_SESSION_FORMAT;
+            }
+            else
+            {
+                if( NULL != pucBuffer )
+                {
+                    ( void ) prvSessionSerialize( pucBuffer );
+                }
+
+                if( NULL != pxOutLength )
+                {
+                    *pxOutLength = xLength;
+                }
+
+                xResult = 0;
+            }
+        }
+
+        prvSessionCacheUnlock();
+    #else
+        ( void ) pucBuffer;
+        ( void ) xBufferLength;
+        ( void ) pxOutLength;
+    #endif /* tlsSESSION_CACHE_ENABLED */
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t TLS_SessionGetInfo( uint8_t * pucSessionId,
+                               size_t * pxSessionIdLength,
+                               BaseType_t * pxResumed,
+                               uint32_t * pulTicketLifetime )
+{
+    BaseType_t xResult = TLS_ERROR_NO_SESSION;
+
+    #if ( tlsSESSION_CACHE_ENABLED == 1 )
+        prvSessionCacheLock();
+
+        if( pdTRUE == xSessionCache.xValid )
+        {
+            if( NULL != pucSessionId )
+            {
+                memcpy( pucSessionId, xSessionCache.xSession.id, xSessionCache.xSession.id_len );
+            }
+
+            if( NULL != pxSessionIdLength )
+            {
+                *pxSessionIdLength = xSessionCache.xSession.id_len;
+            }
+
+            if( NULL != pxResumed )
+            {
+                *pxResumed = xSessionCache.xResumed;
+            }
+
+            if( NULL != pulTicketLifetime )
+            {
+                #if defined( MBEDTLS_SSL_SESSION_TICKETS )
+                    *pulTicketLifetime = ( NULL != xSessionCache.xSession.ticket ) ?
+                                         xSessionCache.xSession.ticket_lifetime : 0;
+                #else
+                    *pulTicketLifetime = 0;
+                #endif
+            }
+
+            xResult = 0;
+        }
+
+        prvSessionCacheUnlock();
+    #else
+        ( void ) pucSessionId;
+        ( void ) pxSessionIdLength;
+        ( void ) pxResumed;
+        ( void ) pulTicketLifetime;
+    #endif /* tlsSESSION_CACHE_ENABLED */
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+BaseType_t TLS_SessionImport( const uint8_t * pucBuffer,
+                              size_t xBufferLength )
+{
+    BaseType_t xResult = TLS_ERROR_SESSION_FORMAT;
+
+    #if ( tlsSESSION_CACHE_ENABLED == 1 )
+        mbedtls_ssl_session xSession;
+        char cDestination[ tlsSESSION_DESTINATION_MAX_LENGTH ] = { 0 };
+        size_t xPos = 0;
+        uint8_t ucVersion = 0;
+        uint8_t ucLength = 0;
+        uint8_t ucByte = 0;
+        uint32_t ulValue = 0;
+        BaseType_t xOk = pdFALSE;
+
+        /* Ticket buffer is allocated through the mbedTLS platform calloc. */
+        CRYPTO_ConfigureHeap();
+
+        mbedtls_ssl_session_init( &xSession );
+
+        xOk = ( NULL != pucBuffer ) &&
+              prvBlobGet( pucBuffer, xBufferLength, &xPos, &ucVersion, 1 ) &&
+              ( tlsSESSION_BLOB_VERSION == ucVersion ) &&
+              prvBlobGet( pucBuffer, xBufferLength, &xPos, &ucLength, 1 ) &&
+              ( ucLength < tlsSESSION_DESTINATION_MAX_LENGTH ) &&
+              prvBlobGet( pucBuffer, xBufferLength, &xPos, cDestination, ucLength ) &&
+              prvBlobGetU32( pucBuffer, xBufferLength, &xPos, &ulValue );
+
+        if( xOk )
+        {
+            xSession.ciphersuite = ( int ) ulValue;
+            xOk = prvBlobGetU32( pucBuffer, xBufferLength, &xPos, &ulValue );
+        }
+
+        if( xOk )
+        {
+            xSession.compression = ( int ) ulValue;
+            xOk = prvBlobGet( pucBuffer, xBufferLength, &xPos, &ucByte, 1 ) &&
+                  ( ucByte <= sizeof( xSession.id ) ) &&
+                  prvBlobGet( pucBuffer, xBufferLength, &xPos, xSession.id, sizeof( xSession.id ) ) &&
+                  prvBlobGet( pucBuffer, xBufferLength, &xPos, xSession.master, sizeof( xSession.master ) ) &&
+                  prvBlobGetU32( pucBuffer, xBufferLength, &xPos, &xSession.verify_result );
+            xSession.id_len = ucByte;
+        }
+
+        #if defined( MBEDTLS_SSL_SESSION_TICKETS ) && defined( MBEDTLS_SSL_CLI_C )
+            if( xOk )
+            {
+                xOk = prvBlobGetU32( pucBuffer, xBufferLength, &xPos, &ulValue ) &&
+                      ( ulValue <= tlsSESSION_TICKET_MAX_LENGTH ) &&
+                      prvBlobGetU32( pucBuffer, xBufferLength, &xPos, &xSession.ticket_lifetime );
+            }
+
+            if( xOk && ( ulValue > 0 ) )
+            {
+                xSession.ticket = mbedtls_calloc( 1, ulValue );
+                xSession.ticket_len = ulValue;
+                xOk = ( NULL != xSession.ticket ) &&
+                      prvBlobGet( pucBuffer, xBufferLength, &xPos, xSession.ticket, ulValue );
+            }
+        #endif
+
+        #if defined( MBEDTLS_SSL_MAX_FRAGMENT_LENGTH )
+            if( xOk )
+            {
+                xOk = prvBlobGet( pucBuffer, xBufferLength, &xPos, &xSession.mfl_code, 1 );
+            }
+        #endif
+
+        #if defined( MBEDTLS_SSL_TRUNCATED_HMAC )
+            if( xOk )
+            {
+                xOk = prvBlobGet( pucBuffer, xBufferLength, &xPos, &ucByte, 1 );
+                xSession.trunc_hmac = ucByte;
+            }
+        #endif
+
+        #if defined( MBEDTLS_SSL_ENCRYPT_THEN_MAC )
+            if( xOk )
+            {
+                xOk = prvBlobGet( pucBuffer, xBufferLength, &xPos, &ucByte, 1 );
+                xSession.encrypt_then_mac = ucByte;
+            }
+        #endif
+
+        if( xOk && ( xPos == xBufferLength ) )
+        {
+            prvSessionCacheLock();
+
+            prvSessionCacheClear();
+            xSessionCache.xSession = xSession;
+            memcpy( xSessionCache.cDestination, cDestination, sizeof( cDestination ) );
+            xSessionCache.xValid = pdTRUE;
+
+            prvSessionCacheUnlock();
+
+            xResult = 0;
+        }
+        else
+        {
+            mbedtls_ssl_session_free( &xSession );
+        }
+    #else
+        ( void ) pucBuffer;
+        ( void ) xBufferLength;
+    #endif /* tlsSESSION_CACHE_ENABLED */
+
+    return xResult;
+}
+
+/*-----------------------------------------------------------*/
+
+void TLS_SessionInvalidate( void )
+{
+    #if ( tlsSESSION_CACHE_ENABLED == 1 )
+        prvSessionCacheLock();
+        prvSessionCacheClear();
+        prvSessionCacheUnlock();
+    #endif
+}
@@ -55,7 +55,7 @@ static int aes_padlock_ace = -1;
 #endif
 
 #if defined(MBEDTLS_AES_ROM_TABLES)
-#if !defined(MBEDTLS_AES_SETKEY_ENC_ALT)
+#if !defined(MBEDTLS_AES_SETKEY_ENC_ALT) || defined(MBEDTLS_FREESCALE_DCP_AES)
 /*
  * Forward S-box
  */
@@ -331,7 +331,7 @@ static const uint32_t RCON[10] =
 #endif /* MBEDTLS_AES_SETKEY_ENC_ALT */
 #else /* MBEDTLS_AES_ROM_TABLES */
 
-#if !defined(MBEDTLS_AES_SETKEY_ENC_ALT)
+#if !defined(MBEDTLS_AES_SETKEY_ENC_ALT) || defined(MBEDTLS_FREESCALE_DCP_AES)
 
 /*
  * Forward S-box & tables
@@ -1363,6 +1363,233 @@ int mbedtls_aes_crypt_ctr( mbedtls_aes_context *ctx,
 #endif /* MBEDTLS_CIPHER_MODE_CTR */
 /* clang-format on */
 
+/*          DCP AES software fallback          */
+#if defined(MBEDTLS_FREESCALE_DCP_AES)
+
+/*
+ * The DCP only takes 128-bit keys. ksdk_mbedtls.c hands the 192 and 256-bit
+ * keys to the table driven rounds below, ctx->nr then holds the number of
+ * rounds (12 or 14) instead of the DCP key size in bytes (16).
+ */
+
+/*
+ * AES key schedule (encryption), software rounds
+ */
+int mbedtls_aes_sw_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    unsigned int i;
+    uint32_t *RK;
+
+#if !defined(MBEDTLS_AES_ROM_TABLES)
+    if (aes_init_done == 0)
+    {
+        aes_gen_tables();
+        aes_init_done = 1;
+    }
+#endif
+
+    switch (keybits)
+    {
+        case 192:
+            ctx->nr = 12;
+            break;
+        case 256:
+            ctx->nr = 14;
+            break;
+        default:
+            return (MBEDTLS_ERR_AES_INVALID_KEY_LENGTH);
+    }
+
+    ctx->rk = RK = ctx->buf;
+
+    for (i = 0; i < (keybits >> 5); i++)
+    {
+        GET_UINT32_LE(RK[i], key, i << 2);
+    }
+
+    if (ctx->nr == 12)
+    {
+        for (i = 0; i < 8; i++, RK += 6)
+        {
+            RK[6] = RK[0] ^ RCON[i] ^ ((uint32_t)FSb[(RK[5] >> 8) & 0xFF]) ^
+                    ((uint32_t)FSb[(RK[5] >> 16) & 0xFF] << 8) ^ ((uint32_t)FSb[(RK[5] >> 24) & 0xFF] << 16) ^
+                    ((uint32_t)FSb[(RK[5]) & 0xFF] << 24);
+
+            RK[7]  = RK[1] ^ RK[6];
+            RK[8]  = RK[2] ^ RK[7];
+            RK[9]  = RK[3] ^ RK[8];
+            RK[10] = RK[4] ^ RK[9];
+            RK[11] = RK[5] ^ RK[10];
+        }
+    }
+    else
+    {
+        for (i = 0; i < 7; i++, RK += 8)
+        {
+            RK[8] = RK[0] ^ RCON[i] ^ ((uint32_t)FSb[(RK[7] >> 8) & 0xFF]) ^
+                    ((uint32_t)FSb[(RK[7] >> 16) & 0xFF] << 8) ^ ((uint32_t)FSb[(RK[7] >> 24) & 0xFF] << 16) ^
+                    ((uint32_t)FSb[(RK[7]) & 0xFF] << 24);
+
+            RK[9]  = RK[1] ^ RK[8];
+            RK[10] = RK[2] ^ RK[9];
+            RK[11] = RK[3] ^ RK[10];
+
+            RK[12] = RK[4] ^ ((uint32_t)FSb[(RK[11]) & 0xFF]) ^ ((uint32_t)FSb[(RK[11] >> 8) & 0xFF] << 8) ^
+                     ((uint32_t)FSb[(RK[11] >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(RK[11] >> 24) & 0xFF] << 24);
+
+            RK[13] = RK[5] ^ RK[12];
+            RK[14] = RK[6] ^ RK[13];
+            RK[15] = RK[7] ^ RK[14];
+        }
+    }
+
+    return (0);
+}
+
+/*
+ * AES key schedule (decryption), software rounds
+ */
+int mbedtls_aes_sw_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
+{
+    int i, j, ret;
+    mbedtls_aes_context cty;
+    uint32_t *RK;
+    uint32_t *SK;
+
+    mbedtls_aes_init(&cty);
+
+    ctx->rk = RK = ctx->buf;
+
+    /* Also checks keybits */
+    if ((ret = mbedtls_aes_sw_setkey_enc(&cty, key, keybits)) != 0)
+    {
+        goto exit;
+    }
+
+    ctx->nr = cty.nr;
+
+    SK = cty.rk + cty.nr * 4;
+
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+
+    for (i = ctx->nr - 1, SK -= 8; i > 0; i--, SK -= 8)
+    {
+        for (j = 0; j < 4; j++, SK++)
+        {
+            *RK++ = AES_RT0(FSb[(*SK) & 0xFF]) ^ AES_RT1(FSb[(*SK >> 8) & 0xFF]) ^
+                    AES_RT2(FSb[(*SK >> 16) & 0xFF]) ^ AES_RT3(FSb[(*SK >> 24) & 0xFF]);
+        }
+    }
+
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+    *RK++ = *SK++;
+
+exit:
+    mbedtls_aes_free(&cty);
+
+    return (ret);
+}
+
+/*
+ * AES-ECB block encryption, software rounds
+ */
+int mbedtls_aes_sw_encrypt(mbedtls_aes_context *ctx, const unsigned char input[16], unsigned char output[16])
+{
+    int i;
+    uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+
+    RK = ctx->rk;
+
+    GET_UINT32_LE(X0, input, 0);
+    X0 ^= *RK++;
+    GET_UINT32_LE(X1, input, 4);
+    X1 ^= *RK++;
+    GET_UINT32_LE(X2, input, 8);
+    X2 ^= *RK++;
+    GET_UINT32_LE(X3, input, 12);
+    X3 ^= *RK++;
+
+    for (i = (ctx->nr >> 1) - 1; i > 0; i--)
+    {
+        AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+        AES_FROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+    }
+
+    AES_FROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+
+    X0 = *RK++ ^ ((uint32_t)FSb[(Y0) & 0xFF]) ^ ((uint32_t)FSb[(Y1 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y2 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y3 >> 24) & 0xFF] << 24);
+
+    X1 = *RK++ ^ ((uint32_t)FSb[(Y1) & 0xFF]) ^ ((uint32_t)FSb[(Y2 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y3 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y0 >> 24) & 0xFF] << 24);
+
+    X2 = *RK++ ^ ((uint32_t)FSb[(Y2) & 0xFF]) ^ ((uint32_t)FSb[(Y3 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y0 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y1 >> 24) & 0xFF] << 24);
+
+    X3 = *RK++ ^ ((uint32_t)FSb[(Y3) & 0xFF]) ^ ((uint32_t)FSb[(Y0 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)FSb[(Y1 >> 16) & 0xFF] << 16) ^ ((uint32_t)FSb[(Y2 >> 24) & 0xFF] << 24);
+
+    PUT_UINT32_LE(X0, output, 0);
+    PUT_UINT32_LE(X1, output, 4);
+    PUT_UINT32_LE(X2, output, 8);
+    PUT_UINT32_LE(X3, output, 12);
+
+    return (0);
+}
+
+/*
+ * AES-ECB block decryption, software rounds
+ */
+int mbedtls_aes_sw_decrypt(mbedtls_aes_context *ctx, const unsigned char input[16], unsigned char output[16])
+{
+    int i;
+    uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
+
+    RK = ctx->rk;
+
+    GET_UINT32_LE(X0, input, 0);
+    X0 ^= *RK++;
+    GET_UINT32_LE(X1, input, 4);
+    X1 ^= *RK++;
+    GET_UINT32_LE(X2, input, 8);
+    X2 ^= *RK++;
+    GET_UINT32_LE(X3, input, 12);
+    X3 ^= *RK++;
+
+    for (i = (ctx->nr >> 1) - 1; i > 0; i--)
+    {
+        AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+        AES_RROUND(X0, X1, X2, X3, Y0, Y1, Y2, Y3);
+    }
+
+    AES_RROUND(Y0, Y1, Y2, Y3, X0, X1, X2, X3);
+
+    X0 = *RK++ ^ ((uint32_t)RSb[(Y0) & 0xFF]) ^ ((uint32_t)RSb[(Y3 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y2 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y1 >> 24) & 0xFF] << 24);
+
+    X1 = *RK++ ^ ((uint32_t)RSb[(Y1) & 0xFF]) ^ ((uint32_t)RSb[(Y0 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y3 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y2 >> 24) & 0xFF] << 24);
+
+    X2 = *RK++ ^ ((uint32_t)RSb[(Y2) & 0xFF]) ^ ((uint32_t)RSb[(Y1 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y0 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y3 >> 24) & 0xFF] << 24);
+
+    X3 = *RK++ ^ ((uint32_t)RSb[(Y3) & 0xFF]) ^ ((uint32_t)RSb[(Y2 >> 8) & 0xFF] << 8) ^
+         ((uint32_t)RSb[(Y1 >> 16) & 0xFF] << 16) ^ ((uint32_t)RSb[(Y0 >> 24) & 0xFF] << 24);
+
+    PUT_UINT32_LE(X0, output, 0);
+    PUT_UINT32_LE(X1, output, 4);
+    PUT_UINT32_LE(X2, output, 8);
+    PUT_UINT32_LE(X3, output, 12);
+
+    return (0);
+}
+#endif /* MBEDTLS_FREESCALE_DCP_AES */
+
 /*          HASHCRYPT AES          */
 #if defined(MBEDTLS_FREESCALE_HASHCRYPT_AES)
 
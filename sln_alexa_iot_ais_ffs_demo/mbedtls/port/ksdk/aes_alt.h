@@ -77,6 +77,17 @@ typedef struct
 mbedtls_aes_context;
 #endif /* MBEDTLS_FREESCALE_HASHCRYPT_AES */
 
+#if defined(MBEDTLS_FREESCALE_DCP_AES)
+/**
+ * \brief          Software key schedules and block functions, used for the
+ *                 192 and 256-bit keys the DCP can't take.
+ */
+int mbedtls_aes_sw_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits);
+int mbedtls_aes_sw_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits);
+int mbedtls_aes_sw_encrypt(mbedtls_aes_context *ctx, const unsigned char input[16], unsigned char output[16]);
+int mbedtls_aes_sw_decrypt(mbedtls_aes_context *ctx, const unsigned char input[16], unsigned char output[16]);
+#endif /* MBEDTLS_FREESCALE_DCP_AES */
+
 #endif /* MBEDTLS_AES_ALT */
 
 #ifdef __cplusplus
@@ -0,0 +1,66 @@
+/**
+ * \file gcm_alt.h
+ *
+ * \brief   This file contains alternate GCM definitions.
+ *
+ *          With MBEDTLS_FREESCALE_DCP_AES_GCM, AES-128 keys get their
+ *          counter blocks encrypted by the DCP in batches, while the CPU
+ *          runs the 4-bit table GHASH over the previous batch. Other ciphers
+ *          and key sizes go block by block through the cipher layer.
+ */
+
+/*  Copyright (C) 2006-2018, Arm Limited (or its affiliates), All Rights Reserved.
+ *  SPDX-License-Identifier: Apache-2.0
+ *  Copyright 2021 NXP. Not a Contribution
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *  not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *  WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *  This file is part of Mbed TLS (https://tls.mbed.org)
+ */
+#ifndef MBEDTLS_GCM_ALT_H
+#define MBEDTLS_GCM_ALT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(MBEDTLS_GCM_ALT)
+
+/**
+ * \brief          The GCM context structure.
+ */
+typedef struct mbedtls_gcm_context
+{
+    mbedtls_cipher_context_t cipher_ctx; /*!< The cipher context used. */
+    uint64_t HL[16];                     /*!< Precalculated HTable low. */
+    uint64_t HH[16];                     /*!< Precalculated HTable high. */
+    uint64_t len;                        /*!< The total length of the encrypted data. */
+    uint64_t add_len;                    /*!< The total length of the additional data. */
+    unsigned char base_ectr[16];         /*!< The first ECTR for tag. */
+    unsigned char y[16];                 /*!< The Y working value. */
+    unsigned char buf[16];               /*!< The buf working value. */
+    int mode;                            /*!< The operation to perform:
+                                              #MBEDTLS_GCM_ENCRYPT or
+                                              #MBEDTLS_GCM_DECRYPT. */
+    int hw;                              /*!< Non-zero when the counter blocks
+                                              are encrypted by the hardware. */
+}
+mbedtls_gcm_context;
+
+#endif /* MBEDTLS_GCM_ALT */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* gcm_alt.h */
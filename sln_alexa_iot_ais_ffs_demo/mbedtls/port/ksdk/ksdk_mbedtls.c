@@ -63,6 +63,9 @@ static cau3_handle_t s_cau3Handle = {.taskDone = MBEDTLS_CAU3_COMPLETION_SIGNAL,
 /******************************************************************************/
 #if defined(FSL_FEATURE_SOC_DCP_COUNT) && (FSL_FEATURE_SOC_DCP_COUNT > 0)
 static dcp_handle_t s_dcpHandle = {.channel = kDCP_Channel0, .keySlot = kDCP_KeySlot0, .swapConfig = kDCP_NoSwap};
+
+/* The DCP only takes 128-bit AES keys (nr = 16 bytes), longer ones run the software rounds of aes_alt.c */
+#define DCP_AES_KEY_IN_SW(ctx) ((ctx)->nr != 16)
 #endif
 
 /******************************************************************************/
@@ -590,7 +593,15 @@ int mbedtls_des3_crypt_cbc(mbedtls_des3_context *ctx,
 int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
 {
     uint32_t *RK;
-    
+
+#if defined(MBEDTLS_FREESCALE_DCP_AES)
+    if ((keybits == 192u) || (keybits == 256u))
+    {
+        crypto_detach_ctx_from_key_slot(ctx);
+        return (mbedtls_aes_sw_setkey_enc(ctx, key, keybits));
+    }
+#endif
+
 #ifdef MBEDTLS_AES_ALT_NO_192
     if (keybits == 192u)
     {
@@ -659,7 +670,15 @@ int mbedtls_aes_setkey_enc(mbedtls_aes_context *ctx, const unsigned char *key, u
 int mbedtls_aes_setkey_dec(mbedtls_aes_context *ctx, const unsigned char *key, unsigned int keybits)
 {
     uint32_t *RK;
-    
+
+#if defined(MBEDTLS_FREESCALE_DCP_AES)
+    if ((keybits == 192u) || (keybits == 256u))
+    {
+        crypto_detach_ctx_from_key_slot(ctx);
+        return (mbedtls_aes_sw_setkey_dec(ctx, key, keybits));
+    }
+#endif
+
 #ifdef MBEDTLS_AES_ALT_NO_192
     if (keybits == 192u)
     {
@@ -748,6 +767,10 @@ int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx, const unsigned char i
 #elif defined(MBEDTLS_FREESCALE_CAAM_AES)
     CAAM_AES_EncryptEcb(CAAM_INSTANCE, &s_caamHandle, input, output, 16, key, ctx->nr);
 #elif defined(MBEDTLS_FREESCALE_DCP_AES)
+    if (DCP_AES_KEY_IN_SW(ctx))
+    {
+        return (mbedtls_aes_sw_encrypt(ctx, input, output));
+    }
     if (!crypto_key_is_loaded(ctx))
     {
         DCP_AES_SetKey(DCP, &s_dcpHandle, key, ctx->nr);
@@ -784,6 +807,10 @@ int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx, const unsigned char i
 #elif defined(MBEDTLS_FREESCALE_CAAM_AES)
     CAAM_AES_DecryptEcb(CAAM_INSTANCE, &s_caamHandle, input, output, 16, key, ctx->nr);
 #elif defined(MBEDTLS_FREESCALE_DCP_AES)
+    if (DCP_AES_KEY_IN_SW(ctx))
+    {
+        return (mbedtls_aes_sw_decrypt(ctx, input, output));
+    }
     if (!crypto_key_is_loaded(ctx))
     {
         DCP_AES_SetKey(DCP, &s_dcpHandle, key, ctx->nr);
@@ -891,6 +918,46 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
     return (0);
 }
 #elif defined(MBEDTLS_FREESCALE_DCP_AES)
+static int dcp_aes_sw_crypt_cbc(mbedtls_aes_context *ctx,
+                                int mode,
+                                size_t length,
+                                unsigned char iv[16],
+                                const unsigned char *input,
+                                unsigned char *output)
+{
+    unsigned char temp[16];
+    int i;
+
+    while (length > 0)
+    {
+        if (mode == MBEDTLS_AES_DECRYPT)
+        {
+            memcpy(temp, input, 16);
+            mbedtls_aes_sw_decrypt(ctx, input, output);
+            for (i = 0; i < 16; i++)
+            {
+                output[i] = (unsigned char)(output[i] ^ iv[i]);
+            }
+            memcpy(iv, temp, 16);
+        }
+        else
+        {
+            for (i = 0; i < 16; i++)
+            {
+                output[i] = (unsigned char)(input[i] ^ iv[i]);
+            }
+            mbedtls_aes_sw_encrypt(ctx, output, output);
+            memcpy(iv, output, 16);
+        }
+
+        input += 16;
+        output += 16;
+        length -= 16;
+    }
+
+    return (0);
+}
+
 int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
                           int mode,
                           size_t length,
@@ -903,6 +970,11 @@ int mbedtls_aes_crypt_cbc(mbedtls_aes_context *ctx,
     if (length % 16)
         return (MBEDTLS_ERR_AES_INVALID_INPUT_LENGTH);
 
+    if (DCP_AES_KEY_IN_SW(ctx))
+    {
+        return (dcp_aes_sw_crypt_cbc(ctx, mode, length, iv, input, output));
+    }
+
     key = (uint8_t *)ctx->rk;
     if (!crypto_key_is_loaded(ctx))
     {
@@ -1504,6 +1576,571 @@ int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context *ctx,
     return (mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_DECRYPT, length, iv, iv_len, add, add_len, input, output,
                                       tag_len, actTag));
 }
+
+#elif defined(MBEDTLS_FREESCALE_DCP_AES_GCM)
+
+#include "mbedtls/gcm.h"
+#include "mbedtls/platform_util.h"
+
+/* Counter blocks per DCP job. Two jobs alternate: the DCP encrypts the next
+ * batch while the CPU XORs and hashes the current one. */
+#define GCM_DCP_BATCH_BLOCKS 8u
+
+#ifndef GET_UINT32_BE
+#define GET_UINT32_BE(n, b, i)                                                                                 \
+    {                                                                                                          \
+        (n) = ((uint32_t)(b)[(i)] << 24) | ((uint32_t)(b)[(i) + 1] << 16) | ((uint32_t)(b)[(i) + 2] << 8) | \
+              ((uint32_t)(b)[(i) + 3]);                                                                        \
+    }
+#endif
+
+#ifndef PUT_UINT32_BE
+#define PUT_UINT32_BE(n, b, i)                    \
+    {                                             \
+        (b)[(i)]     = (unsigned char)((n) >> 24); \
+        (b)[(i) + 1] = (unsigned char)((n) >> 16); \
+        (b)[(i) + 2] = (unsigned char)((n) >> 8);  \
+        (b)[(i) + 3] = (unsigned char)((n));       \
+    }
+#endif
+
+void mbedtls_gcm_init(mbedtls_gcm_context *ctx)
+{
+    memset(ctx, 0, sizeof(mbedtls_gcm_context));
+}
+
+/*
+ * Precompute small multiples of H, that is set
+ *      HH[i] || HL[i] = H times i,
+ * where i is seen as a field element with the high-order bits for the low
+ * powers of P, as in the reference gcm.c.
+ */
+static int gcm_gen_table(mbedtls_gcm_context *ctx)
+{
+    int ret, i, j;
+    uint64_t hi, lo;
+    uint64_t vl, vh;
+    unsigned char h[16];
+    size_t olen = 0;
+
+    memset(h, 0, 16);
+    if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, h, 16, h, &olen)) != 0)
+    {
+        return (ret);
+    }
+
+    /* pack h as two 64-bits ints, big-endian */
+    GET_UINT32_BE(hi, h, 0);
+    GET_UINT32_BE(lo, h, 4);
+    vh = (uint64_t)hi << 32 | lo;
+
+    GET_UINT32_BE(hi, h, 8);
+    GET_UINT32_BE(lo, h, 12);
+    vl = (uint64_t)hi << 32 | lo;
+
+    /* 8 = 1000 corresponds to 1 in GF(2^128) */
+    ctx->HL[8] = vl;
+    ctx->HH[8] = vh;
+
+    /* 0 corresponds to 0 in GF(2^128) */
+    ctx->HH[0] = 0;
+    ctx->HL[0] = 0;
+
+    for (i = 4; i > 0; i >>= 1)
+    {
+        uint32_t T = (vl & 1) * 0xe1000000U;
+        vl         = (vh << 63) | (vl >> 1);
+        vh         = (vh >> 1) ^ ((uint64_t)T << 32);
+
+        ctx->HL[i] = vl;
+        ctx->HH[i] = vh;
+    }
+
+    for (i = 2; i <= 8; i *= 2)
+    {
+        uint64_t *HiL = ctx->HL + i, *HiH = ctx->HH + i;
+        vh            = *HiH;
+        vl            = *HiL;
+        for (j = 1; j < i; j++)
+        {
+            HiH[j] = vh ^ ctx->HH[j];
+            HiL[j] = vl ^ ctx->HL[j];
+        }
+    }
+
+    mbedtls_platform_zeroize(h, sizeof(h));
+
+    return (0);
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context *ctx,
+                       mbedtls_cipher_id_t cipher,
+                       const unsigned char *key,
+                       unsigned int keybits)
+{
+    int ret;
+    const mbedtls_cipher_info_t *cipher_info;
+
+    cipher_info = mbedtls_cipher_info_from_values(cipher, keybits, MBEDTLS_MODE_ECB);
+    if (cipher_info == NULL)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    if (cipher_info->block_size != 16)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+
+    if ((ret = mbedtls_cipher_setup(&ctx->cipher_ctx, cipher_info)) != 0)
+    {
+        return (ret);
+    }
+
+    if ((ret = mbedtls_cipher_setkey(&ctx->cipher_ctx, key, keybits, MBEDTLS_ENCRYPT)) != 0)
+    {
+        return (ret);
+    }
+
+    /* The cipher layer keeps an mbedtls_aes_context, the DCP takes it directly */
+    ctx->hw = (cipher == MBEDTLS_CIPHER_ID_AES) && (keybits == 128u);
+
+    return (gcm_gen_table(ctx));
+}
+
+/*
+ * Shoup's method for multiplication use this table with
+ *      last4[x] = x times P^128
+ */
+static const uint64_t last4[16] = {0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+                                   0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+/*
+ * Sets output to x times H using the precomputed tables.
+ */
+static void gcm_mult(mbedtls_gcm_context *ctx, const unsigned char x[16], unsigned char output[16])
+{
+    int i = 0;
+    unsigned char lo, hi, rem;
+    uint64_t zh, zl;
+
+    lo = x[15] & 0xf;
+
+    zh = ctx->HH[lo];
+    zl = ctx->HL[lo];
+
+    for (i = 15; i >= 0; i--)
+    {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+
+        if (i != 15)
+        {
+            rem = (unsigned char)zl & 0xf;
+            zl  = (zh << 60) | (zl >> 4);
+            zh  = (zh >> 4);
+            zh ^= (uint64_t)last4[rem] << 48;
+            zh ^= ctx->HH[lo];
+            zl ^= ctx->HL[lo];
+        }
+
+        rem = (unsigned char)zl & 0xf;
+        zl  = (zh << 60) | (zl >> 4);
+        zh  = (zh >> 4);
+        zh ^= (uint64_t)last4[rem] << 48;
+        zh ^= ctx->HH[hi];
+        zl ^= ctx->HL[hi];
+    }
+
+    PUT_UINT32_BE(zh >> 32, output, 0);
+    PUT_UINT32_BE(zh, output, 4);
+    PUT_UINT32_BE(zl >> 32, output, 8);
+    PUT_UINT32_BE(zl, output, 12);
+}
+
+int mbedtls_gcm_starts(
+    mbedtls_gcm_context *ctx, int mode, const unsigned char *iv, size_t iv_len, const unsigned char *add, size_t add_len)
+{
+    int ret;
+    unsigned char work_buf[16];
+    size_t i;
+    const unsigned char *p;
+    size_t use_len, olen = 0;
+
+    /* IV and AD are limited to 2^64 bits, so 2^61 bytes */
+    /* IV is not allowed to be zero length */
+    if (iv_len == 0 || ((uint64_t)iv_len) >> 61 != 0 || ((uint64_t)add_len) >> 61 != 0)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    memset(ctx->y, 0x00, sizeof(ctx->y));
+    memset(ctx->buf, 0x00, sizeof(ctx->buf));
+
+    ctx->mode    = mode;
+    ctx->len     = 0;
+    ctx->add_len = 0;
+
+    if (iv_len == 12)
+    {
+        memcpy(ctx->y, iv, iv_len);
+        ctx->y[15] = 1;
+    }
+    else
+    {
+        memset(work_buf, 0x00, 16);
+        PUT_UINT32_BE(iv_len * 8, work_buf, 12);
+
+        p = iv;
+        while (iv_len > 0)
+        {
+            use_len = (iv_len < 16) ? iv_len : 16;
+
+            for (i = 0; i < use_len; i++)
+            {
+                ctx->y[i] ^= p[i];
+            }
+
+            gcm_mult(ctx, ctx->y, ctx->y);
+
+            iv_len -= use_len;
+            p += use_len;
+        }
+
+        for (i = 0; i < 16; i++)
+        {
+            ctx->y[i] ^= work_buf[i];
+        }
+
+        gcm_mult(ctx, ctx->y, ctx->y);
+    }
+
+    if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, ctx->y, 16, ctx->base_ectr, &olen)) != 0)
+    {
+        return (ret);
+    }
+
+    ctx->add_len = add_len;
+    p            = add;
+    while (add_len > 0)
+    {
+        use_len = (add_len < 16) ? add_len : 16;
+
+        for (i = 0; i < use_len; i++)
+        {
+            ctx->buf[i] ^= p[i];
+        }
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        add_len -= use_len;
+        p += use_len;
+    }
+
+    return (0);
+}
+
+/*
+ * XOR the key stream in and fold the ciphertext into the GHASH, 16 bytes at a time
+ */
+static void gcm_xor_ghash(mbedtls_gcm_context *ctx,
+                          const unsigned char *ectr,
+                          size_t length,
+                          const unsigned char *input,
+                          unsigned char *output)
+{
+    size_t use_len;
+    size_t i;
+
+    while (length > 0)
+    {
+        use_len = (length < 16) ? length : 16;
+
+        for (i = 0; i < use_len; i++)
+        {
+            if (ctx->mode == MBEDTLS_GCM_DECRYPT)
+            {
+                ctx->buf[i] ^= input[i];
+            }
+            output[i] = ectr[i] ^ input[i];
+            if (ctx->mode == MBEDTLS_GCM_ENCRYPT)
+            {
+                ctx->buf[i] ^= output[i];
+            }
+        }
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        length -= use_len;
+        ectr += use_len;
+        input += use_len;
+        output += use_len;
+    }
+}
+
+/*
+ * Write up to GCM_DCP_BATCH_BLOCKS successive counter blocks, returns how many
+ */
+static size_t gcm_dcp_counters(mbedtls_gcm_context *ctx, unsigned char *ctr, size_t blocks)
+{
+    size_t n;
+    int i;
+
+    if (blocks > GCM_DCP_BATCH_BLOCKS)
+    {
+        blocks = GCM_DCP_BATCH_BLOCKS;
+    }
+
+    for (n = 0; n < blocks; n++)
+    {
+        for (i = 16; i > 12; i--)
+        {
+            if (++ctx->y[i - 1] != 0)
+            {
+                break;
+            }
+        }
+        memcpy(ctr + (n * 16u), ctx->y, 16);
+    }
+
+    return blocks;
+}
+
+static int gcm_dcp_crypt(mbedtls_gcm_context *ctx, size_t length, const unsigned char *input, unsigned char *output)
+{
+    unsigned char ctr[2][GCM_DCP_BATCH_BLOCKS * 16u];
+    unsigned char ectr[2][GCM_DCP_BATCH_BLOCKS * 16u];
+    dcp_work_packet_t dcpWork    = {0};
+    mbedtls_aes_context *aes_ctx = (mbedtls_aes_context *)ctx->cipher_ctx.cipher_ctx;
+    size_t blocks                = (length + 15u) / 16u;
+    size_t batch;
+    size_t next;
+    size_t use_len;
+    status_t status;
+    int cur = 0;
+    int ret = 0;
+
+    if (!crypto_key_is_loaded(aes_ctx))
+    {
+        DCP_AES_SetKey(DCP, &s_dcpHandle, (uint8_t *)aes_ctx->rk, aes_ctx->nr);
+        crypto_attach_ctx_to_key_slot(aes_ctx, s_dcpHandle.keySlot);
+    }
+
+    batch = gcm_dcp_counters(ctx, ctr[0], blocks);
+    blocks -= batch;
+    if (DCP_AES_EncryptEcb(DCP, &s_dcpHandle, ctr[0], ectr[0], batch * 16u) != kStatus_Success)
+    {
+        return (MBEDTLS_ERR_GCM_HW_ACCEL_FAILED);
+    }
+
+    while (batch > 0)
+    {
+        next = 0;
+        if (blocks > 0)
+        {
+            next = gcm_dcp_counters(ctx, ctr[cur ^ 1], blocks);
+            blocks -= next;
+
+            do
+            {
+                status = DCP_AES_EncryptEcbNonBlocking(DCP, &s_dcpHandle, &dcpWork, ctr[cur ^ 1], ectr[cur ^ 1],
+                                                       next * 16u);
+            } while (status == (status_t)kStatus_DCP_Again);
+
+            if (status != kStatus_Success)
+            {
+                ret = MBEDTLS_ERR_GCM_HW_ACCEL_FAILED;
+                break;
+            }
+        }
+
+        /* The last batch may end on a partial block */
+        use_len = (length < (batch * 16u)) ? length : (batch * 16u);
+        gcm_xor_ghash(ctx, ectr[cur], use_len, input, output);
+        input += use_len;
+        output += use_len;
+        length -= use_len;
+
+        if ((next > 0) && (DCP_WaitForChannelComplete(DCP, &s_dcpHandle) != kStatus_Success))
+        {
+            ret = MBEDTLS_ERR_GCM_HW_ACCEL_FAILED;
+            break;
+        }
+
+        cur ^= 1;
+        batch = next;
+    }
+
+    mbedtls_platform_zeroize(ectr, sizeof(ectr));
+
+    return (ret);
+}
+
+int mbedtls_gcm_update(mbedtls_gcm_context *ctx, size_t length, const unsigned char *input, unsigned char *output)
+{
+    int ret;
+    unsigned char ectr[16];
+    size_t use_len, olen = 0;
+
+    if (output > input && (size_t)(output - input) < length)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    /* Total length is restricted to 2^39 - 256 bits, ie 2^36 - 2^5 bytes
+     * Also check for possible overflow */
+    if (ctx->len + length < ctx->len || (uint64_t)ctx->len + length > 0xFFFFFFFE0ull)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    ctx->len += length;
+
+    if (length == 0)
+    {
+        return (0);
+    }
+
+    if (ctx->hw)
+    {
+        return (gcm_dcp_crypt(ctx, length, input, output));
+    }
+
+    /* Other ciphers and key sizes, one block at a time through the cipher layer */
+    while (length > 0)
+    {
+        use_len = (length < 16) ? length : 16;
+
+        (void)gcm_dcp_counters(ctx, ectr, 1);
+        if ((ret = mbedtls_cipher_update(&ctx->cipher_ctx, ectr, 16, ectr, &olen)) != 0)
+        {
+            return (ret);
+        }
+
+        gcm_xor_ghash(ctx, ectr, use_len, input, output);
+
+        length -= use_len;
+        input += use_len;
+        output += use_len;
+    }
+
+    return (0);
+}
+
+int mbedtls_gcm_finish(mbedtls_gcm_context *ctx, unsigned char *tag, size_t tag_len)
+{
+    unsigned char work_buf[16];
+    size_t i;
+    uint64_t orig_len     = ctx->len * 8;
+    uint64_t orig_add_len = ctx->add_len * 8;
+
+    if (tag_len > 16 || tag_len < 4)
+    {
+        return (MBEDTLS_ERR_GCM_BAD_INPUT);
+    }
+
+    memcpy(tag, ctx->base_ectr, tag_len);
+
+    if (orig_len || orig_add_len)
+    {
+        memset(work_buf, 0x00, 16);
+
+        PUT_UINT32_BE((orig_add_len >> 32), work_buf, 0);
+        PUT_UINT32_BE((orig_add_len), work_buf, 4);
+        PUT_UINT32_BE((orig_len >> 32), work_buf, 8);
+        PUT_UINT32_BE((orig_len), work_buf, 12);
+
+        for (i = 0; i < 16; i++)
+        {
+            ctx->buf[i] ^= work_buf[i];
+        }
+
+        gcm_mult(ctx, ctx->buf, ctx->buf);
+
+        for (i = 0; i < tag_len; i++)
+        {
+            tag[i] ^= ctx->buf[i];
+        }
+    }
+
+    return (0);
+}
+
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context *ctx,
+                              int mode,
+                              size_t length,
+                              const unsigned char *iv,
+                              size_t iv_len,
+                              const unsigned char *add,
+                              size_t add_len,
+                              const unsigned char *input,
+                              unsigned char *output,
+                              size_t tag_len,
+                              unsigned char *tag)
+{
+    int ret;
+
+    if ((ret = mbedtls_gcm_starts(ctx, mode, iv, iv_len, add, add_len)) != 0)
+    {
+        return (ret);
+    }
+
+    if ((ret = mbedtls_gcm_update(ctx, length, input, output)) != 0)
+    {
+        return (ret);
+    }
+
+    return (mbedtls_gcm_finish(ctx, tag, tag_len));
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context *ctx,
+                             size_t length,
+                             const unsigned char *iv,
+                             size_t iv_len,
+                             const unsigned char *add,
+                             size_t add_len,
+                             const unsigned char *tag,
+                             size_t tag_len,
+                             const unsigned char *input,
+                             unsigned char *output)
+{
+    int ret;
+    unsigned char check_tag[16];
+    size_t i;
+    int diff;
+
+    if ((ret = mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_DECRYPT, length, iv, iv_len, add, add_len, input, output,
+                                         tag_len, check_tag)) != 0)
+    {
+        return (ret);
+    }
+
+    /* Check tag in "constant-time" */
+    for (diff = 0, i = 0; i < tag_len; i++)
+    {
+        diff |= tag[i] ^ check_tag[i];
+    }
+
+    if (diff != 0)
+    {
+        mbedtls_platform_zeroize(output, length);
+        return (MBEDTLS_ERR_GCM_AUTH_FAILED);
+    }
+
+    return (0);
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context *ctx)
+{
+    if (ctx == NULL)
+    {
+        return;
+    }
+    mbedtls_cipher_free(&ctx->cipher_ctx);
+    mbedtls_platform_zeroize(ctx, sizeof(mbedtls_gcm_context));
+}
 #endif
 #endif /* MBEDTLS_GCM_C */
 
@@ -0,0 +1,331 @@
+#!/usr/bin/env python3
+
+"""
+
+Copyright 2021 NXP.
+
+This software is owned or controlled by NXP and may only be used
+strictly in accordance with the license terms that accompany it. By
+expressly accepting such terms or by downloading, installing,
+activating and/or otherwise using the software, you are agreeing that
+you have read, and that you agree to comply with and are bound by,
+such license terms. If you do not agree to be bound by the applicable
+license terms, then you may not retain, install, activate or otherwise
+use the software.
+
+File
+++++
+/scripts/asd_log_decode.py
+
+Brief
++++++
+** Decodes the raw asd_logger log lines, tokenized or not **
+
+.. versionadded:: 0.0
+
+
+With ASD_LOG_TOKENIZED set to 1, the format strings of the ASD_LOG_x macros
+are placed in the asd_log_fmt section of the ELF and the log lines in flash
+only hold the offset of the format string and the encoded arguments. The
+layout of a line is described in
+amazon_acs/dpk_impl/rt106a/common/asd_logger/asd_log_token.h.
+
+The raw lines are read with log_reader_create(log_id, LOG_DATA_TYPE_BIT_TOKEN),
+for instance by the "log dumpraw" shell command of the test runner which
+prints them in hex; save the console output to a file and pass it to this
+script, or pass a binary file with -b.
+
+The script prints the log lines in the same text format as "log dump". With
+-s, it also prints the number of bytes per line in flash and in text.
+
+The asd_log_fmt section is extracted from the ELF given with -e with
+arm-none-eabi-objcopy (must be in PATH), or the objcopy given with -o.
+
+##########
+NOTA BENE:
+  1. The ELF must be the one of the firmware that wrote the log: the tokens
+     are offsets in its asd_log_fmt section
+
+  2. The timestamps are printed in UTC, as the device does
+##########
+
+
+execute "asd_log_decode.py --help" for usage information.
+
+"""
+
+import os
+import re
+import sys
+import time
+import struct
+import argparse
+import tempfile
+import subprocess
+
+
+HEX_LINE = re.compile(r'^(?:[0-9A-F]{2})+$')
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|j|z|t)?([diucoxXpsfFeEgGaA%])')
+
+LINE_HEADER_SIZE = 12
+LEVEL_CHAR = 'DIWEF'
+
+
+def read_raw(path, binary):
+    """
+    Read the raw log lines
+
+    :param path: "log dumpraw" console output, or binary file
+    :param binary: path is a binary file
+    :returns: (bytes) raw log lines
+    """
+
+    if binary:
+        with open(path, 'rb') as fp:
+            return fp.read()
+
+    raw = bytearray()
+    with open(path, 'r', errors='replace') as fp:
+        for line in fp:
+            line = line.strip()
+            if line and HEX_LINE.match(line):
+                raw += bytes.fromhex(line)
+
+    return bytes(raw)
+
+
+def load_formats(elf, objcopy='arm-none-eabi-objcopy'):
+    """
+    Extract the asd_log_fmt section of the ELF
+
+    :returns: (bytes) format strings, NUL separated
+    """
+
+    if elf is None:
+        return None
+
+    fd, path = tempfile.mkstemp(suffix='.bin')
+    os.close(fd)
+    try:
+        cmd = [objcopy, '-O', 'binary', '--only-section=asd_log_fmt', elf, path]
+        subprocess.run(cmd, check=True)
+        with open(path, 'rb') as fp:
+            formats = fp.read()
+    finally:
+        os.remove(path)
+
+    if not formats:
+        raise ValueError("no asd_log_fmt section in %s, built without ASD_LOG_TOKENIZED?" % elf)
+
+    return formats
+
+
+class Body:
+    """ Reader of a tokenized line body """
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            if self.pos >= len(self.data) or shift >= 64:
+                raise ValueError("truncated varint")
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def signed(self):
+        value = self.varint()
+        return (value >> 1) ^ -(value & 1)
+
+    def string(self):
+        length = self.varint()
+        if self.pos + length > len(self.data):
+            raise ValueError("truncated string")
+        self.pos += length
+        return self.data[self.pos - length:self.pos].decode('utf-8', errors='replace')
+
+    def double(self):
+        if self.pos + 8 > len(self.data):
+            raise ValueError("truncated double")
+        self.pos += 8
+        return struct.unpack_from('<d', self.data, self.pos - 8)[0]
+
+
+def format_conversion(flags, width, precision, conv, value):
+    """
+    printf() one conversion, the C way
+    """
+
+    if conv == 'p':
+        conv, flags = 'x', flags + '#'
+    if conv == 'a' or conv == 'A':
+        # float.hex() doesn't drop the trailing zeros of the mantissa as C does
+        text = re.sub(r'\.?0+p', 'p', float.hex(value))
+        text = text.upper() if conv == 'A' else text
+        spec = '%' + flags.replace('0', '') + ('%d' % width if width else '') + 's'
+        return spec % text
+    if conv == 'u':
+        conv = 'd'
+
+    spec = '%' + flags
+    if width:
+        spec += '%d' % width
+    if precision is not None and precision >= 0:
+        spec += '.%d' % precision
+    text = (spec + conv) % value
+
+    # python prefixes the alternate octal form with 0o
+    if conv == 'o' and '#' in flags:
+        text = text.replace('0o', '0', 1)
+
+    return text
+
+
+def decode_token(body, formats):
+    """
+    Rebuild the text of a tokenized line body
+
+    :returns: (str) "tag:function:line:message", as the text logger prints it
+    """
+
+    if formats is None:
+        raise ValueError("tokenized line, the ELF is needed (-e)")
+
+    reader = Body(body)
+    token = reader.varint()
+    if token >= len(formats):
+        raise ValueError("token 0x%x out of the asd_log_fmt section" % token)
+    fmt = formats[token:formats.index(b'\0', token)].decode('utf-8', errors='replace')
+
+    text = ''
+    tag = reader.string()
+    if tag:
+        text += tag + ':'
+    func = reader.string()
+    if func:
+        text += '%s:%d:' % (func, reader.varint())
+
+    pos = 0
+    for match in CONVERSION.finditer(fmt):
+        text += fmt[pos:match.start()]
+        pos = match.end()
+        flags, width, precision, _, conv = match.groups()
+
+        if conv == '%':
+            text += '%'
+            continue
+
+        width = reader.signed() if width == '*' else int(width or 0)
+        if precision == '*':
+            precision = reader.signed()
+        elif precision is not None:
+            precision = int(precision or 0)
+        if width < 0:
+            flags, width = flags + '-', -width
+
+        if conv in 'di':
+            value = reader.signed()
+        elif conv in 'uoxXp':
+            value = reader.varint()
+        elif conv == 'c':
+            value = chr(reader.signed() & 0xFF)
+            conv = 's'
+        elif conv == 's':
+            value = reader.string()
+        else:
+            value = reader.double()
+
+        text += format_conversion(flags, width, precision, conv, value)
+
+    return text + fmt[pos:]
+
+
+def decode(raw, formats):
+    """
+    Decode the raw log lines
+
+    :returns: (list) (text, stored bytes, tokenized) per line
+    """
+
+    lines = []
+    pos = 0
+
+    while pos + 2 <= len(raw):
+        length = struct.unpack_from('<H', raw, pos)[0]
+        pos += 2
+
+        if length == 0:
+            lines.append(("###Resync pos", 2, False))
+            continue
+        if length < LINE_HEADER_SIZE or pos + length > len(raw):
+            raise ValueError("bad line length %d at offset %d" % (length, pos - 2))
+
+        bits, pc = struct.unpack_from('<QI', raw, pos)
+        body = raw[pos + LINE_HEADER_SIZE:pos + length]
+        pos += length
+
+        timestamp_ms = bits & ((1 << 42) - 1)
+        level = (bits >> 42) & 0x7
+        tokenized = (bits >> 45) & 0x1
+        task_id = (bits >> 56) & 0xFF
+
+        header = "[%s.%03d %c %3u %08x]" % (
+            time.strftime("%Y-%m-%d %H:%M:%S", time.gmtime(timestamp_ms // 1000)),
+            timestamp_ms % 1000,
+            LEVEL_CHAR[level] if level < len(LEVEL_CHAR) else 'U',
+            task_id, pc)
+
+        if tokenized:
+            try:
+                text = decode_token(body, formats)
+            except (ValueError, TypeError) as e:
+                text = "<undecoded: %s> %s" % (e, body.hex())
+        else:
+            text = body.decode('utf-8', errors='replace')
+
+        lines.append((header + text, length + 2, bool(tokenized)))
+
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the raw asd_logger log lines")
+    parser.add_argument('log', help="\"log dumpraw\" console output, or binary file with -b")
+    parser.add_argument('-b', '--binary', action='store_true', help="the log is a binary file")
+    parser.add_argument('-e', '--elf', help="application .axf built with ASD_LOG_TOKENIZED")
+    parser.add_argument('-o', '--objcopy', default='arm-none-eabi-objcopy', help="objcopy for the ELF")
+    parser.add_argument('-s', '--stats', action='store_true', help="print the bytes per line")
+    args = parser.parse_args()
+
+    try:
+        raw = read_raw(args.log, args.binary)
+        formats = load_formats(args.elf, args.objcopy)
+        lines = decode(raw, formats)
+
+        for text, _, _ in lines:
+            print(text)
+
+        if args.stats and lines:
+            stored = sum(length for _, length, _ in lines)
+            printed = sum(len(text) + 2 for text, _, _ in lines)
+            tokenized = sum(1 for _, _, token in lines if token)
+            print("\n%d lines, %d tokenized" % (len(lines), tokenized))
+            print("flash: %d bytes, %.1f per line" % (stored, stored / len(lines)))
+            print("text:  %d bytes, %.1f per line" % (printed, printed / len(lines)))
+
+    except (OSError, ValueError, subprocess.CalledProcessError) as e:
+        print("\nERROR: %s" % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
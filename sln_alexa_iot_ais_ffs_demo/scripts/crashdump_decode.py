@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+
+"""
+
+Copyright 2021 NXP.
+
+This software is owned or controlled by NXP and may only be used
+strictly in accordance with the license terms that accompany it. By
+expressly accepting such terms or by downloading, installing,
+activating and/or otherwise using the software, you are agreeing that
+you have read, and that you agree to comply with and are bound by,
+such license terms. If you do not agree to be bound by the applicable
+license terms, then you may not retain, install, activate or otherwise
+use the software.
+
+File
+++++
+/scripts/crashdump_decode.py
+
+Brief
++++++
+** Rebuilds the backtrace of a crash record read from the crash log **
+
+.. versionadded:: 0.0
+
+
+Each crash record of amazon_acs/dpk_impl/rt106a/common/debug/asd_crashdump.c
+holds the CPU registers, the stack of the faulting context from sp and an
+optional RAM window (asd_crashdump_set_ram_window). The memory is packed in
+LZ4 block format and printed in hex in the "Packed stack:" and "Packed ram:"
+sections of the crash report; save the report to a file and pass it to this
+script.
+
+The script prints:
+    - the registers of the crash
+    - the backtrace: pc, lr, then every word of the unpacked stack that is
+      a Thumb return address inside a function of the ELF
+
+With -e, the addresses are checked against the functions of the ELF and
+resolved to function and line with arm-none-eabi-nm and
+arm-none-eabi-addr2line (must be in PATH). With -o, the unpacked memory is
+written to <prefix>_stack.bin and <prefix>_ram.bin.
+
+##########
+NOTA BENE:
+  1. The backtrace is a stack scan, not an unwind: stale return addresses
+     left in the stack by earlier calls are listed too
+
+  2. Without -e, every odd word of the stack is listed as a candidate
+##########
+
+
+execute "crashdump_decode.py --help" for usage information.
+
+"""
+
+import re
+import sys
+import struct
+import argparse
+import subprocess
+
+
+REG_LINE = re.compile(r'^(\w+)\s*= 0x([0-9a-fA-F]{8})$')
+PACKED_LINE = re.compile(r'^Packed (stack|ram): addr=0x([0-9a-fA-F]+) len=(\d+) packed=(\d+)$')
+HEX_LINE = re.compile(r'^[0-9A-F]+$')
+
+
+def read_report(path):
+    """
+    Extract the registers and the packed memory of a crash report
+
+    :param path: crash report
+    :type  path: str
+
+    :returns: (dict) 'regs' name -> value, 'stack' and 'ram' dict with addr, len and packed bytes
+    """
+
+    report = {'regs': {}}
+    current = None
+
+    with open(path, 'r', errors='replace') as fp:
+        for line in fp:
+            line = line.strip()
+
+            match = PACKED_LINE.match(line)
+            if match:
+                current = {'addr': int(match.group(2), 16), 'len': int(match.group(3)),
+                           'packed_len': int(match.group(4)), 'packed': bytearray()}
+                report[match.group(1)] = current
+                continue
+
+            if current is not None and line and HEX_LINE.match(line) and \
+                    len(current['packed']) < current['packed_len']:
+                current['packed'] += bytes.fromhex(line)
+                continue
+            current = None
+
+            match = REG_LINE.match(line)
+            if match:
+                report['regs'][match.group(1)] = int(match.group(2), 16)
+
+    for name in ('stack', 'ram'):
+        if name in report and len(report[name]['packed']) != report[name]['packed_len']:
+            raise ValueError("packed %s is %d bytes, expected %d" %
+                             (name, len(report[name]['packed']), report[name]['packed_len']))
+
+    return report
+
+
+def lz4_unpack(src, size):
+    """
+    Decode an LZ4 block
+
+    :param src: packed bytes
+    :param size: unpacked length
+    :returns: (bytes) unpacked data
+    """
+
+    dst = bytearray()
+    pos = 0
+
+    while pos < len(src):
+        token = src[pos]
+        pos += 1
+
+        literals = token >> 4
+        if literals == 15:
+            while True:
+                literals += src[pos]
+                pos += 1
+                if src[pos - 1] != 255:
+                    break
+        dst += src[pos:pos + literals]
+        pos += literals
+
+        if pos >= len(src):
+            break
+
+        offset = src[pos] | (src[pos + 1] << 8)
+        pos += 2
+        if offset == 0 or offset > len(dst):
+            raise ValueError("bad match offset %d at %d" % (offset, pos))
+
+        length = token & 0xF
+        if length == 15:
+            while True:
+                length += src[pos]
+                pos += 1
+                if src[pos - 1] != 255:
+                    break
+        length += 4
+
+        # matches may overlap their own output
+        for _ in range(length):
+            dst.append(dst[-offset])
+
+    if len(dst) != size:
+        raise ValueError("unpacked %d bytes, expected %d" % (len(dst), size))
+
+    return bytes(dst)
+
+
+def load_functions(elf):
+    """
+    List the functions of the ELF
+
+    :returns: (list) sorted (start, end, name)
+    """
+
+    cmd = ['arm-none-eabi-nm', '-S', '-n', '-C', '--defined-only', elf]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, check=True, universal_newlines=True).stdout
+
+    functions = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in ('t', 'T', 'W'):
+            start = int(fields[0], 16) & ~1
+            functions.append((start, start + int(fields[1], 16), fields[3]))
+
+    return functions
+
+
+def in_function(functions, addr):
+    for start, end, _ in functions:
+        if start < addr < end:
+            return True
+        if start > addr:
+            break
+    return False
+
+
+def backtrace(report, stack, functions):
+    """
+    Scan the stack for return addresses
+
+    :returns: (list) (where, address) frames, address without the Thumb bit
+    """
+
+    frames = []
+    regs = report['regs']
+
+    if 'pc' in regs:
+        frames.append(('pc', regs['pc'] & ~1))
+    if 'lr' in regs and regs['lr'] & 1:
+        frames.append(('lr', (regs['lr'] & ~1) - 2))
+
+    for idx in range(len(stack) // 4):
+        word = struct.unpack_from('<I', stack, idx * 4)[0]
+        if not word & 1:
+            continue
+        # point to the call instruction, not after it
+        addr = (word & ~1) - 2
+        if functions is None or in_function(functions, addr):
+            frames.append(('sp+0x%03x' % (idx * 4), addr))
+
+    return frames
+
+
+def resolve(frames, elf):
+    """
+    Name every frame with addr2line
+
+    :returns: (dict) address -> "function file:line"
+    """
+
+    addrs = sorted(set(addr for _, addr in frames))
+    names = {}
+
+    if elf is None or not addrs:
+        return names
+
+    cmd = ['arm-none-eabi-addr2line', '-f', '-C', '-s', '-e', elf] + ['0x%x' % addr for addr in addrs]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, check=True, universal_newlines=True).stdout.splitlines()
+
+    for idx, addr in enumerate(addrs):
+        func = out[2 * idx] if 2 * idx < len(out) else '??'
+        where = out[2 * idx + 1] if 2 * idx + 1 < len(out) else '??'
+        names[addr] = '%s %s' % (func, where)
+
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Rebuild the backtrace of a crash report")
+    parser.add_argument('report', help="crash report with the Packed stack section")
+    parser.add_argument('-e', '--elf', help="application .axf to check and resolve the return addresses")
+    parser.add_argument('-o', '--output', help="prefix of the files the unpacked memory is written to")
+    args = parser.parse_args()
+
+    try:
+        report = read_report(args.report)
+        if 'stack' not in report:
+            raise ValueError("no packed stack in %s" % args.report)
+
+        memory = {}
+        for name in ('stack', 'ram'):
+            if name in report:
+                memory[name] = lz4_unpack(report[name]['packed'], report[name]['len'])
+                if args.output:
+                    with open('%s_%s.bin' % (args.output, name), 'wb') as fp:
+                        fp.write(memory[name])
+
+        for name in ('pc', 'lr', 'sp', 'psr', 'cfsr', 'hfsr', 'mmfar', 'bfar'):
+            if name in report['regs']:
+                print("%-6s 0x%08x" % (name, report['regs'][name]))
+
+        print("\nstack 0x%08x, %d bytes" % (report['stack']['addr'], report['stack']['len']))
+        if 'ram' in report:
+            print("ram   0x%08x, %d bytes" % (report['ram']['addr'], report['ram']['len']))
+
+        functions = load_functions(args.elf) if args.elf else None
+        frames = backtrace(report, memory['stack'], functions)
+        names = resolve(frames, args.elf)
+
+        print("\nbacktrace:")
+        for idx, (where, addr) in enumerate(frames):
+            print("#%-3d %-9s 0x%08x %s" % (idx, where, addr, names.get(addr, '')))
+
+    except (OSError, ValueError, IndexError, subprocess.CalledProcessError) as e:
+        print("\nERROR: %s" % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
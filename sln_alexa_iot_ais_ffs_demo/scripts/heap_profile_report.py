@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+
+"""
+
+Copyright 2021 NXP.
+
+This software is owned or controlled by NXP and may only be used
+strictly in accordance with the license terms that accompany it. By
+expressly accepting such terms or by downloading, installing,
+activating and/or otherwise using the software, you are agreeing that
+you have read, and that you agree to comply with and are bound by,
+such license terms. If you do not agree to be bound by the applicable
+license terms, then you may not retain, install, activate or otherwise
+use the software.
+
+File
+++++
+/scripts/heap_profile_report.py
+
+Brief
++++++
+** Decodes the heap profile exported by the "heap_profile export" shell command **
+
+.. versionadded:: 0.0
+
+
+The firmware must be built with configUSE_HEAP_TRACKER set to 1 in
+FreeRTOSConfig.h. "heap_profile export" prints the profile as
+"HEAPTRK <hex>" lines ended by "HEAPTRK END"; save the console output to a
+file and pass it to this script. The layout of the profile is described in
+freertos/freertos_kernel/portable/MemMang/heap_4_wrap.h.
+
+The script prints:
+    - heap totals and the free block histogram
+    - the call sites sorted by live bytes and by number of allocations
+    - the largest free block trend
+
+With -e, the call site addresses are resolved to function and line with
+arm-none-eabi-addr2line (must be in PATH). With -f, a folded stack file
+"caller live_bytes" is written, ready for flamegraph.pl:
+
+    flamegraph.pl --countname bytes heap.folded > heap.svg
+
+##########
+NOTA BENE:
+  1. The call site is the return address of pvPortMalloc(): allocations
+     made through calloc / pvPortRealloc are reported at those wrappers,
+     and with configUSE_HEAP_SLAB the heap_4 fall-throughs at heap_slab.c
+
+  2. "untracked" counts the allocations made while the block table was
+     full (configHEAP_TRACKER_BLOCKS); their sites miss those bytes
+##########
+
+
+execute "heap_profile_report.py --help" for usage information.
+
+"""
+
+import sys
+import struct
+import argparse
+import subprocess
+
+
+EXPORT_MAGIC = 0x4B525448
+EXPORT_VERSION = 1
+EXPORT_HEADER = struct.Struct('<IHHHHIIIII')
+EXPORT_SITE = struct.Struct('<IIIII')
+EXPORT_BIN = struct.Struct('<I')
+EXPORT_SAMPLE = struct.Struct('<III')
+
+# Must match heapHISTOGRAM_FIRST_SHIFT
+HISTOGRAM_FIRST_SHIFT = 6
+
+LINE_TAG = 'HEAPTRK'
+
+
+def read_blob(path):
+    """
+    Extract the last complete export from a console log
+
+    :param path: console log
+    :type  path: str
+
+    :returns: (bytes) raw profile
+    """
+
+    blob = None
+    current = None
+
+    with open(path, 'r', errors='replace') as fp:
+        for line in fp:
+            pos = line.find(LINE_TAG)
+            if pos < 0:
+                continue
+            data = line[pos + len(LINE_TAG):].strip()
+            if data == 'END':
+                if current is not None:
+                    blob = bytes(current)
+                current = None
+            else:
+                if current is None:
+                    current = bytearray()
+                current += bytes.fromhex(data)
+
+    if blob is None:
+        raise ValueError("no complete %s export found in %s" % (LINE_TAG, path))
+
+    return blob
+
+
+def decode(blob):
+    """
+    Decode a raw profile
+
+    :returns: (dict) header fields, 'sites', 'bins' and 'trend' lists
+    """
+
+    if len(blob) < EXPORT_HEADER.size:
+        raise ValueError("export too short")
+
+    magic, version, n_sites, n_bins, n_samples, tick, free, min_free, largest, untracked = \
+        EXPORT_HEADER.unpack_from(blob, 0)
+    if magic != EXPORT_MAGIC or version != EXPORT_VERSION:
+        raise ValueError("bad export header")
+
+    expected = EXPORT_HEADER.size + n_sites * EXPORT_SITE.size + n_bins * EXPORT_BIN.size + \
+        n_samples * EXPORT_SAMPLE.size
+    if len(blob) != expected:
+        raise ValueError("export is %d bytes, expected %d" % (len(blob), expected))
+
+    pos = EXPORT_HEADER.size
+    sites = []
+    for _ in range(n_sites):
+        pc, live, blocks, allocs, alloc_bytes = EXPORT_SITE.unpack_from(blob, pos)
+        sites.append({'pc': pc, 'live': live, 'blocks': blocks, 'allocs': allocs, 'bytes': alloc_bytes})
+        pos += EXPORT_SITE.size
+
+    bins = []
+    for _ in range(n_bins):
+        bins.append(EXPORT_BIN.unpack_from(blob, pos)[0])
+        pos += EXPORT_BIN.size
+
+    trend = []
+    for _ in range(n_samples):
+        trend.append(EXPORT_SAMPLE.unpack_from(blob, pos))
+        pos += EXPORT_SAMPLE.size
+
+    return {'tick': tick, 'free': free, 'min_free': min_free, 'largest': largest, 'untracked': untracked,
+            'sites': sites, 'bins': bins, 'trend': trend}
+
+
+def resolve(sites, elf):
+    """
+    Name every call site with addr2line
+
+    :returns: (dict) pc -> "function file:line"
+    """
+
+    names = {0: '[other sites]'}
+    pcs = [s['pc'] for s in sites if s['pc'] != 0]
+
+    if elf is None or not pcs:
+        for pc in pcs:
+            names[pc] = '0x%08x' % pc
+        return names
+
+    # Thumb return addresses have bit 0 set and point after the call
+    cmd = ['arm-none-eabi-addr2line', '-f', '-C', '-s', '-e', elf] + ['0x%x' % ((pc & ~1) - 2) for pc in pcs]
+    out = subprocess.run(cmd, stdout=subprocess.PIPE, check=True, universal_newlines=True).stdout.splitlines()
+
+    for idx, pc in enumerate(pcs):
+        func = out[2 * idx] if 2 * idx < len(out) else '??'
+        where = out[2 * idx + 1] if 2 * idx + 1 < len(out) else '??'
+        names[pc] = '%s %s' % (func, where)
+
+    return names
+
+
+def bin_label(idx, count):
+    if idx == count - 1:
+        return '>= %d' % (1 << (HISTOGRAM_FIRST_SHIFT + idx))
+    return '< %d' % (1 << (HISTOGRAM_FIRST_SHIFT + 1 + idx))
+
+
+def print_report(prof, names, top):
+    print("Tick %d: free %d, min free %d, largest free block %d, untracked allocations %d" %
+          (prof['tick'], prof['free'], prof['min_free'], prof['largest'], prof['untracked']))
+    if prof['free']:
+        print("Fragmentation: %.1f%% (1 - largest / free)" % (100.0 * (1 - float(prof['largest']) / prof['free'])))
+
+    print("\nFree blocks")
+    for idx, count in enumerate(prof['bins']):
+        if count:
+            print("  %-10s %d" % (bin_label(idx, len(prof['bins'])), count))
+
+    for title, key in (("live bytes", 'live'), ("allocations", 'allocs')):
+        print("\nTop sites by %s" % title)
+        print("  %8s %7s %9s %10s  %s" % ("Live", "Blocks", "Allocs", "Bytes", "Caller"))
+        for site in sorted(prof['sites'], key=lambda s: s[key], reverse=True)[:top]:
+            print("  %8d %7d %9d %10d  %s" % (site['live'], site['blocks'], site['allocs'], site['bytes'],
+                                             names[site['pc']]))
+
+    if prof['trend']:
+        print("\nLargest free block trend")
+        for tick, largest, free in prof['trend']:
+            print("  %10d %8d %8d" % (tick, largest, free))
+
+
+def write_folded(path, prof, names):
+    with open(path, 'w') as fp:
+        for site in prof['sites']:
+            if site['live']:
+                fp.write("heap;%s %d\n" % (names[site['pc']].replace(' ', '_').replace(';', ':'), site['live']))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the heap_profile export of the device console")
+    parser.add_argument('log', help="console log containing the HEAPTRK lines")
+    parser.add_argument('-e', '--elf', help="application .axf to resolve the call sites")
+    parser.add_argument('-f', '--folded', help="write live bytes per site in folded stack format")
+    parser.add_argument('-t', '--top', type=int, default=10, help="number of sites listed")
+    args = parser.parse_args()
+
+    try:
+        prof = decode(read_blob(args.log))
+        names = resolve(prof['sites'], args.elf)
+        print_report(prof, names, args.top)
+        if args.folded:
+            write_folded(args.folded, prof, names)
+
+    except (OSError, ValueError, subprocess.CalledProcessError) as e:
+        print("\nERROR: %s" % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
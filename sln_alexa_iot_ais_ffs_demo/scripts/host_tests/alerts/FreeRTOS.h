@@ -0,0 +1,40 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build ais_alerts.c. Nothing is
+ * scheduled: the test calls the work of the alert task itself.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef uint32_t EventBits_t;
+
+typedef struct
+{
+    int dummy;
+} StaticTask_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+#define pdPASS  ( pdTRUE )
+
+#define portMAX_DELAY ( ( TickType_t ) 0xffffffffUL )
+
+#define configTIMER_TASK_PRIORITY 5
+
+/* The alerts log a line per alert found in flash */
+#define configPRINTF( x )
+
+#define pvPortMalloc malloc
+#define vPortFree    free
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for aisv2.h, the alert types and the FreeRTOS types used by
+ * ais_alerts.h.
+ */
+
+#ifndef _AISV2_H_
+#define _AISV2_H_
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+typedef void *EventGroupHandle_t;
+
+typedef enum _ais_alert_type
+{
+    AIS_ALERT_TYPE_TIMER,
+    AIS_ALERT_TYPE_ALARM,
+    AIS_ALERT_TYPE_REMINDER,
+    AIS_ALERT_TYPE_INVALID
+} ais_alert_type_t;
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits);
+
+#endif /* _AISV2_H_ */
@@ -0,0 +1,447 @@
+/*
+ * Host check of ais_alerts.c on a simulated clock, with reboots.
+ *
+ * Builds the real ais_alerts.c against the stub headers in this directory. The
+ * alert task is never run: the workload calls its work, storing the new alerts
+ * and removing the deleted ones, itself. The alerts file is kept in RAM and is
+ * programmed like NOR flash: a program of bytes that are not erased fails the
+ * test, so the journal can only grow into its erased tail.
+ *
+ * The clock moves a few seconds per step while alerts are set, deleted online,
+ * triggered offline when due and stopped by the user, thousands of them over
+ * the run. A model of the alerts checks that:
+ *  - the due alerts trigger one at a time, earliest first, and never before
+ *    their time;
+ *  - every alert is found by its token, an alert token being a prefix of
+ *    another one included, and no longer found once it is removed;
+ *  - after each reboot the stored alerts come back with their time and state;
+ *  - the flash programs only cover the records of each change, and the file is
+ *    copied again only when the journal is full.
+ *
+ * Build and run with "make -C scripts/host_tests alerts".
+ */
+
+#include <stdio.h>
+
+#include "ais_alerts.h"
+#include "sln_flash_mgmt.h"
+#include "ux_attention_system.h"
+
+#define TEST_ALERTS       6000
+#define TEST_STEPS        40000
+#define TEST_REBOOT_EVERY 2000
+#define TEST_CHECK_EVERY  50
+#define TEST_FILE_MAX     (256 * 1024)
+#define TEST_PAGE_SIZE    512
+#define TEST_FILE_HDR     8 /* sln_file_header_t in front of the data */
+
+typedef enum
+{
+    MODEL_UNSET,
+    MODEL_IDLE,
+    MODEL_TRIGGERED,
+    MODEL_DELETED,
+    MODEL_REMOVED,
+} model_state_t;
+
+typedef struct
+{
+    char token[AIS_MAX_ALERT_TOKEN_LEN_BYTES];
+    uint64_t time;
+    model_state_t state;
+} model_alert_t;
+
+EventGroupHandle_t s_offlineAudioEventGroup = NULL;
+
+int32_t ais_alert_store_alerts_to_nvm(void);
+int32_t ais_alert_delete(void);
+
+static model_alert_t s_model[TEST_ALERTS];
+static alertTokenList_t s_list;
+static uint32_t s_next_alert;
+static uint64_t s_now = AIS_ALERT_EPOCH_DAY_ZERO + 1000;
+static uint64_t s_last_trigger;
+
+static uint8_t s_file[TEST_FILE_MAX];
+static uint32_t s_file_size;
+static bool s_file_saved;
+
+static long s_saves;
+static long s_programs;
+static long s_program_bytes;
+static long s_pages;
+static long s_changes;
+static long s_triggers;
+static long s_full;
+static long s_reboots;
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("alerts: ");                         \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+size_t safe_strlen(const char *ptr, size_t max)
+{
+    size_t len = 0;
+
+    while (len < max && ptr[len]) {
+        len++;
+    }
+    return len;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    return bits;
+}
+
+int32_t ux_attention_set_state(ux_attention_states_t uxState)
+{
+    return 0;
+}
+
+static long pages_of(uint32_t offset, uint32_t len)
+{
+    uint32_t first = (TEST_FILE_HDR + offset) / TEST_PAGE_SIZE;
+    uint32_t last = (TEST_FILE_HDR + offset + len - 1) / TEST_PAGE_SIZE;
+
+    return last - first + 1;
+}
+
+int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len)
+{
+    if (len > TEST_FILE_MAX) {
+        return SLN_FLASH_MGMT_EOVERFLOW2;
+    }
+    memcpy(s_file, data, len);
+    s_file_size = len;
+    s_file_saved = true;
+    s_saves++;
+    s_pages += pages_of(0, len);
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_MGMT_Program(const char *name, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    if (!s_file_saved) {
+        return SLN_FLASH_MGMT_ENOENTRY2;
+    }
+    if (len == 0 || offset > s_file_size || len > s_file_size - offset) {
+        return SLN_FLASH_MGMT_EINVAL3;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (s_file[offset + i] != 0xFF) {
+            FAIL("program of byte %u of the alerts file, already programmed", offset + i);
+        }
+        s_file[offset + i] = data[i];
+    }
+    s_programs++;
+    s_program_bytes += len;
+    s_pages += pages_of(offset, len);
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
+{
+    if (!s_file_saved) {
+        return SLN_FLASH_MGMT_ENOENTRY2;
+    }
+    if (data == NULL || *len > s_file_size) {
+        *len = s_file_size;
+    }
+    if (data != NULL) {
+        memcpy(data, s_file, *len);
+    }
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_MGMT_Erase(const char *name)
+{
+    s_file_saved = false;
+    return SLN_FLASH_MGMT_OK;
+}
+
+static int32_t slot_of(const model_alert_t *alert)
+{
+    return AIS_Alerts_GetDuplicate(alert->token, strlen(alert->token));
+}
+
+/* Short tokens are prefixes of each other, "...alert.1" of "...alert.12" */
+static void make_token(char *token, uint32_t id)
+{
+    if (id % 7 == 3) {
+        snprintf(token, AIS_MAX_ALERT_TOKEN_LEN_BYTES, "%0*u", (int)AIS_MAX_ALERT_TOKEN_LEN_BYTES - 1, id);
+    } else {
+        snprintf(token, AIS_MAX_ALERT_TOKEN_LEN_BYTES, "amzn1.alert.%u", id);
+    }
+}
+
+static void set_alert(void)
+{
+    model_alert_t *alert = &s_model[s_next_alert];
+    ais_alert_t set = {0};
+    uint32_t live = 0;
+    int32_t ret;
+
+    make_token(alert->token, s_next_alert);
+    alert->time = s_now + 1 + ((rand() % 3 == 0) ? rand() % (10 * 86400) : rand() % 3600);
+
+    memcpy(set.token, alert->token, strlen(alert->token));
+    set.scheduledTime = alert->time;
+    set.durationMs = 1000;
+    set.type = (ais_alert_type_t)(rand() % AIS_ALERT_TYPE_INVALID);
+    set.valid = true;
+    set.idle = true;
+
+    ret = AIS_Alerts_SaveAlert(&set);
+    if (ret == -3) {
+        for (uint32_t i = 0; i < s_next_alert; i++) {
+            live += (s_model[i].state != MODEL_UNSET && s_model[i].state != MODEL_REMOVED);
+        }
+        if (live != AIS_APP_MAX_ALERT_COUNT) {
+            FAIL("alert %u refused with %u alerts stored", s_next_alert, live);
+        }
+        s_full++;
+        return;
+    }
+    if (ret != 0) {
+        FAIL("save of alert %u failed, %d", s_next_alert, ret);
+    }
+    alert->state = MODEL_IDLE;
+    s_next_alert++;
+    s_changes++;
+}
+
+/* The service sends an alert again, it must not take another slot */
+static void set_again(model_alert_t *alert)
+{
+    ais_alert_t set = {0};
+    uint32_t before = 0;
+    uint32_t after = 0;
+
+    AIS_Alerts_GetAlertsList(&s_list, &before);
+    memcpy(set.token, alert->token, strlen(alert->token));
+    set.scheduledTime = alert->time;
+    set.durationMs = 1000;
+    set.valid = true;
+    set.idle = true;
+    if (AIS_Alerts_SaveAlert(&set) != 0) {
+        FAIL("alert %s set again failed", alert->token);
+    }
+    AIS_Alerts_GetAlertsList(&s_list, &after);
+    if (after != before) {
+        FAIL("alert %s set again stored %u alerts instead of %u", alert->token, after, before);
+    }
+}
+
+static void trigger_due(void)
+{
+    int32_t slot;
+
+    while ((slot = AIS_Alerts_GetNextDue(s_now)) >= 0) {
+        uint64_t time = AIS_Alerts_GetScheduledTime(slot);
+        model_alert_t *found = NULL;
+
+        if (time >= s_now || time < s_last_trigger) {
+            FAIL("alert at %llu due at %llu, after one at %llu", (unsigned long long)time,
+                 (unsigned long long)s_now, (unsigned long long)s_last_trigger);
+        }
+        for (uint32_t i = 0; i < s_next_alert; i++) {
+            if (s_model[i].state != MODEL_IDLE || s_model[i].time > time) {
+                continue;
+            }
+            if (s_model[i].time < time) {
+                FAIL("alert at %llu due before the one at %llu", (unsigned long long)s_model[i].time,
+                     (unsigned long long)time);
+            }
+            if (slot_of(&s_model[i]) == slot) {
+                found = &s_model[i];
+            }
+        }
+        if (found == NULL) {
+            FAIL("slot %d due at %llu holds no idle alert", slot, (unsigned long long)time);
+        }
+
+        AIS_Alerts_Trigger(slot, true);
+        if (AIS_Alerts_MarkAsTriggeredOffline(slot) != 0) {
+            FAIL("trigger of %s failed", found->token);
+        }
+        found->state = MODEL_TRIGGERED;
+        s_last_trigger = time;
+        s_triggers++;
+        s_changes++;
+    }
+
+    for (uint32_t i = 0; i < s_next_alert; i++) {
+        if (s_model[i].state == MODEL_IDLE && s_model[i].time < s_now) {
+            FAIL("alert %s at %llu not triggered at %llu", s_model[i].token,
+                 (unsigned long long)s_model[i].time, (unsigned long long)s_now);
+        }
+    }
+}
+
+static model_alert_t *pick(model_state_t state)
+{
+    uint32_t start;
+
+    if (s_next_alert == 0) {
+        return NULL;
+    }
+    start = rand() % s_next_alert;
+    for (uint32_t i = 0; i < s_next_alert; i++) {
+        model_alert_t *alert = &s_model[(start + i) % s_next_alert];
+
+        if (alert->state == state) {
+            return alert;
+        }
+    }
+    return NULL;
+}
+
+static void remove_deleted(void)
+{
+    if (ais_alert_delete() != 0) {
+        FAIL("remove of the deleted alerts failed");
+    }
+    for (uint32_t i = 0; i < s_next_alert; i++) {
+        if (s_model[i].state == MODEL_DELETED) {
+            s_model[i].state = MODEL_REMOVED;
+            s_changes++;
+        }
+    }
+}
+
+static void check_alerts(const char *when)
+{
+    uint32_t stored = 0;
+    uint32_t deleted = 0;
+    uint32_t count;
+
+    for (uint32_t i = 0; i < s_next_alert; i++) {
+        model_alert_t *alert = &s_model[i];
+        int32_t slot = slot_of(alert);
+        bool idle;
+
+        if (alert->state == MODEL_REMOVED) {
+            if (slot >= 0) {
+                FAIL("%s: removed alert %s found in slot %d", when, alert->token, slot);
+            }
+            continue;
+        }
+        if (slot < 0) {
+            FAIL("%s: alert %s lost", when, alert->token);
+        }
+        if (AIS_Alerts_GetScheduledTime(slot) != alert->time) {
+            FAIL("%s: alert %s at %llu instead of %llu", when, alert->token,
+                 (unsigned long long)AIS_Alerts_GetScheduledTime(slot), (unsigned long long)alert->time);
+        }
+        idle = AIS_Alerts_GetIdleState(slot);
+        if (idle != (alert->state == MODEL_IDLE)) {
+            FAIL("%s: alert %s %s", when, alert->token, idle ? "idle again" : "no longer idle");
+        }
+        stored += (alert->state != MODEL_DELETED);
+        deleted += (alert->state == MODEL_DELETED);
+    }
+
+    AIS_Alerts_GetDeletedList(NULL, &count);
+    if (count != deleted) {
+        FAIL("%s: %u alerts to delete instead of %u", when, count, deleted);
+    }
+    AIS_Alerts_GetAlertsList(&s_list, &count);
+    if (count != stored) {
+        FAIL("%s: %u alerts stored instead of %u", when, count, stored);
+    }
+}
+
+static void reboot(void)
+{
+    // The alert task had the time to store the new alerts
+    if (ais_alert_store_alerts_to_nvm() != 0) {
+        FAIL("store before reboot %ld failed", s_reboots);
+    }
+    if (AIS_Alerts_Init() != 0) {
+        FAIL("init at reboot %ld failed", s_reboots);
+    }
+    s_reboots++;
+    check_alerts("after reboot");
+}
+
+int main(void)
+{
+    ais_alert_stats_t stats;
+    long rewrite_pages;
+
+    srand(31);
+    if (AIS_Alerts_Init() != 0) {
+        FAIL("init without an alerts file failed");
+    }
+
+    for (long step = 0; step < TEST_STEPS && s_next_alert < TEST_ALERTS; step++) {
+        model_alert_t *alert;
+
+        s_now += 1 + rand() % 20;
+
+        if (rand() % 3 == 0) {
+            set_alert();
+        }
+        if (rand() % 40 == 0 && (alert = pick(MODEL_IDLE)) != NULL) {
+            set_again(alert);
+        }
+        if (rand() % 2 == 0 && ais_alert_store_alerts_to_nvm() != 0) {
+            FAIL("store of the new alerts failed");
+        }
+        if (rand() % 10 == 0 && (alert = pick(MODEL_IDLE)) != NULL) {
+            // Deleted online
+            if (AIS_Alerts_MarkForDelete(alert->token, strlen(alert->token)) != 0) {
+                FAIL("delete of %s failed", alert->token);
+            }
+            alert->state = MODEL_DELETED;
+            s_changes++;
+        }
+
+        trigger_due();
+
+        if (rand() % 3 == 0 && (alert = pick(MODEL_TRIGGERED)) != NULL) {
+            // Stopped by the user
+            if (AIS_Alerts_MarkForDeleteOffline(slot_of(alert)) != 0) {
+                FAIL("offline delete of %s failed", alert->token);
+            }
+            alert->state = MODEL_DELETED;
+            s_changes++;
+        }
+        if (rand() % 8 == 0) {
+            remove_deleted();
+        }
+
+        if (step % TEST_REBOOT_EVERY == TEST_REBOOT_EVERY - 1) {
+            reboot();
+        } else if (step % TEST_CHECK_EVERY == 0) {
+            check_alerts("running");
+        }
+    }
+    reboot();
+
+    AIS_Alerts_GetStats(&stats);
+    if (stats.journalWrites != s_programs + s_saves || stats.compactions != s_saves) {
+        FAIL("%u journal writes and %u compactions counted, %ld and %ld done", stats.journalWrites,
+             stats.compactions, s_programs + s_saves, s_saves);
+    }
+
+    // What rewriting the whole file for each change would have cost
+    rewrite_pages = s_changes * pages_of(0, s_file_size);
+    if (s_pages * 10 > rewrite_pages) {
+        FAIL("%ld pages programmed for %ld changes, a whole file is %ld pages", s_pages, s_changes,
+             pages_of(0, s_file_size));
+    }
+
+    printf("alerts: %u alerts set, %ld refused when full, %ld triggered in order, %ld reboots\n",
+           s_next_alert, s_full, s_triggers, s_reboots);
+    printf("alerts: %ld changes: %ld programs of %.1f bytes each, %ld copies of the %u byte file, "
+           "%ld pages programmed (%ld to rewrite the file each time)\n",
+           s_changes, s_programs, (double)s_program_bytes / s_programs, s_saves, s_file_size, s_pages,
+           rewrite_pages);
+    return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for app_events.h.
+ */
+
+#ifndef _APP_EVENTS_H_
+#define _APP_EVENTS_H_
+
+typedef enum _app_events_category_alert
+{
+    kNewAlertSet = 0,
+    kAlertDelete,
+} app_events_category_alert_t;
+
+#endif /* _APP_EVENTS_H_ */
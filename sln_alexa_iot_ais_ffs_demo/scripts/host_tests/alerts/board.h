@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for board.h, nothing of it is used.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#endif /* _BOARD_H_ */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for sln_amplifier.h, nothing of it is used.
+ */
+
+#ifndef _SLN_AMPLIFIER_H_
+#define _SLN_AMPLIFIER_H_
+
+#endif /* _SLN_AMPLIFIER_H_ */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for sln_flash.h.
+ */
+
+#ifndef _SLN_FLASH_H_
+#define _SLN_FLASH_H_
+
+#include <stddef.h>
+
+size_t safe_strlen(const char *ptr, size_t max);
+
+#endif /* _SLN_FLASH_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for sln_flash_mgmt.h. The test keeps the alerts file in RAM
+ * and programs it like NOR flash.
+ */
+
+#ifndef _SLN_FLASH_MGMT_
+#define _SLN_FLASH_MGMT_
+
+#include <stdint.h>
+
+typedef enum _sln_flash_mgmt_status
+{
+    SLN_FLASH_MGMT_OK         = 0x00,
+    SLN_FLASH_MGMT_EINVAL3    = -0x42,
+    SLN_FLASH_MGMT_ENOENTRY2  = -0x51,
+    SLN_FLASH_MGMT_EOVERFLOW  = -0x60,
+    SLN_FLASH_MGMT_EOVERFLOW2 = -0x61,
+    SLN_FLASH_MGMT_EENCRYPT2  = -0x71,
+} sln_flash_mgmt_status_t;
+
+int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len);
+int32_t SLN_FLASH_MGMT_Program(const char *name, uint32_t offset, const uint8_t *data, uint32_t len);
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len);
+int32_t SLN_FLASH_MGMT_Erase(const char *name);
+
+#endif /* _SLN_FLASH_MGMT_ */
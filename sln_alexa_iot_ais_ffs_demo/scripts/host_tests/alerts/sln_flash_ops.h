@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for sln_flash_ops.h, nothing of it is used.
+ */
+
+#ifndef _SLN_FLASH_OPS_H_
+#define _SLN_FLASH_OPS_H_
+
+#endif /* _SLN_FLASH_OPS_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for task.h. The alert task is created but never run.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+static inline TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stackDepth,
+                                             void *params, UBaseType_t priority, StackType_t *stack,
+                                             StaticTask_t *task)
+{
+    return task;
+}
+
+static inline BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value,
+                                         TickType_t wait)
+{
+    abort();
+}
+
+#endif /* INC_TASK_H */
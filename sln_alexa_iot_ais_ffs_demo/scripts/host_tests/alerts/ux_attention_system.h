@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for ux_attention_system.h.
+ */
+
+#ifndef _UX_ATTENTION_SYSTEM_H_
+#define _UX_ATTENTION_SYSTEM_H_
+
+#include <stdint.h>
+
+typedef uint32_t ux_attention_states_t;
+
+int32_t ux_attention_set_state(ux_attention_states_t uxState);
+
+#endif /* _UX_ATTENTION_SYSTEM_H_ */
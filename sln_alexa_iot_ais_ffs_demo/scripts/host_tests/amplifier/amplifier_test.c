@@ -0,0 +1,418 @@
+/*
+ * Host check of audio/sln_amplifier.c against the fake SAI of fake_sai/.
+ *
+ * The real amplifier task runs on the simulated scheduler and feeds the fake
+ * SAI, which keeps everything it plays. The buffers hold non-zero samples
+ * numbered in order, so once the silence is taken out the output must be the
+ * buffers back to back, sample for sample.
+ *
+ *  - late producer: each buffer is written some time after the previous one
+ *    ended. Up to 20ms the silence bridges the gap, the SAI never runs dry
+ *    and the amplifier counts one gap per buffer. A buffer waits at most for
+ *    the silence chunk playing and the one queued. Later than that the
+ *    playback ends;
+ *  - back to back: the ring is kept filled, the SAI never runs dry and no
+ *    silence is played before the end of the playback;
+ *  - SLN_AMP_Write and SLN_AMP_WriteLoop return busy while one of them is
+ *    queued, SLN_AMP_WriteAsync still queues, the loop plays until aborted;
+ *  - SLN_AMP_WriteNoWait gives back each pool slot once, played or aborted.
+ *
+ * The latency SLN_AMP_GetStats reports is checked against the one the fake
+ * SAI saw. Each TX interrupt must come when the previous one announced it to
+ * the tickless idle, give or take the rounding of the chunk to 1us, unless
+ * an abort stopped them.
+ *
+ * Build and run with "make -C scripts/host_tests amplifier".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "fake_sai.h"
+#include "pdm_pcm_definitions.h"
+#include "sim_rtos.h"
+#include "sln_amplifier.h"
+#include "sln_tickless.h"
+
+#define TEST_BUFFERS       48
+#define TEST_MAX_BUFFER_MS 40
+#define TEST_STREAM_BYTES  (TEST_BUFFERS * TEST_MAX_BUFFER_MS * PCM_AMP_DATA_SIZE_1_MS)
+#define TEST_SILENCE_MS    20 /* AMP_SILENCE_MAX_CHUNKS of 2ms */
+#define TEST_POOL_SLOTS    AMP_WRITE_SLOTS
+
+static const char *s_scenario = "init";
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("amplifier: %s: ", s_scenario);      \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+static int16_t s_stream[TEST_STREAM_BYTES / 2];
+static uint32_t s_written; /* Bytes of the stream handed to the amplifier */
+
+static uint8_t *s_buf_data[TEST_BUFFERS];
+static uint32_t s_buf_length[TEST_BUFFERS];
+static uint64_t s_buf_enqueue_us[TEST_BUFFERS];
+static uint64_t s_buf_start_us[TEST_BUFFERS];
+static int s_buf_count;
+static int s_done;
+static int s_failed;
+static bool s_refill; /* Write the next buffer as one completes */
+static uint64_t s_max_latency_us;
+static uint64_t s_seen_latency_us; /* Highest of all the scenarios */
+
+static volatile uint8_t s_pool = TEST_POOL_SLOTS;
+
+static uint64_t s_tickless_next_us; /* Next TX interrupt announced, 0 when stopped */
+static uint32_t s_tickless_reports;
+
+void SLN_TICKLESS_PeriodicIrqDone(sln_tickless_periodic_t source, uint32_t periodUs)
+{
+    uint64_t now_us = sim_now_us();
+
+    if (source != kSLN_TICKLESS_Amplifier) {
+        FAIL("periodic interrupt %d reported", (int)source);
+    }
+    /* An abort stops the TX interrupts at any time */
+    if (s_tickless_next_us != 0 && ((periodUs != 0 && now_us + 1 < s_tickless_next_us) ||
+                                    now_us > s_tickless_next_us + 1)) {
+        FAIL("TX interrupt at %llu us, announced for %llu us", (unsigned long long)now_us,
+             (unsigned long long)s_tickless_next_us);
+    }
+    if (periodUs == 0 && fake_sai_running()) {
+        FAIL("TX interrupts stopped at %llu us, the SAI still plays", (unsigned long long)now_us);
+    }
+    s_tickless_next_us = (periodUs != 0) ? now_us + periodUs : 0;
+    s_tickless_reports++;
+}
+
+/* Cut the stream into buffers of 1 to TEST_MAX_BUFFER_MS, in 32 byte steps */
+static void make_buffers(void)
+{
+    uint32_t off = 0;
+
+    s_buf_count = 0;
+    s_done = 0;
+    s_failed = 0;
+    s_written = 0;
+    s_max_latency_us = 0;
+    for (int i = 0; i < TEST_BUFFERS; i++) {
+        uint32_t length = 32 * (1 + rand() % (TEST_MAX_BUFFER_MS * PCM_AMP_DATA_SIZE_1_MS / 32));
+
+        s_buf_data[i] = (uint8_t *)s_stream + off;
+        s_buf_length[i] = length;
+        s_buf_start_us[i] = 0;
+        off += length;
+    }
+}
+
+static void start_hook(const uint8_t *data, size_t size, uint64_t now_us)
+{
+    for (int i = 0; i < s_buf_count; i++) {
+        if (data == s_buf_data[i] && s_buf_start_us[i] == 0) {
+            uint64_t latency_us = now_us - s_buf_enqueue_us[i];
+
+            s_buf_start_us[i] = now_us;
+            if (latency_us > s_max_latency_us) {
+                s_max_latency_us = latency_us;
+            }
+        }
+    }
+}
+
+static void write_done(uint8_t *data, uint32_t length, amplifier_status_t status, void *arg);
+
+static amplifier_status_t write_next(void)
+{
+    amplifier_status_t ret;
+    int idx = s_buf_count;
+
+    s_buf_enqueue_us[idx] = sim_now_us();
+    ret = SLN_AMP_WriteAsync(s_buf_data[idx], s_buf_length[idx], write_done, (void *)(intptr_t)idx);
+    if (ret == kStatus_Success) {
+        s_buf_count++;
+        s_written += s_buf_length[idx];
+    }
+    return ret;
+}
+
+static void write_done(uint8_t *data, uint32_t length, amplifier_status_t status, void *arg)
+{
+    int idx = (int)(intptr_t)arg;
+
+    if (idx != s_done + s_failed || data != s_buf_data[idx] || length != s_buf_length[idx]) {
+        FAIL("buffer %d completed out of order, expected %d", idx, s_done + s_failed);
+    }
+    if (status == kStatus_Success) {
+        s_done++;
+    } else {
+        s_failed++;
+    }
+    /* The slot is free again, keep the ring full */
+    if (s_refill && s_buf_count < TEST_BUFFERS && write_next() != kStatus_Success) {
+        FAIL("refill of buffer %d refused", s_buf_count);
+    }
+}
+
+static bool all_done(void *arg)
+{
+    return s_done + s_failed == s_buf_count;
+}
+
+static bool sai_stopped(void *arg)
+{
+    return !fake_sai_running();
+}
+
+/* The non-zero samples played must be the stream, up to what was written */
+static void check_output(void)
+{
+    size_t length;
+    const uint8_t *out = fake_sai_output(&length);
+    uint32_t played = 0;
+
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        int16_t sample;
+
+        memcpy(&sample, out + i, 2);
+        if (sample == 0) {
+            continue;
+        }
+        if (played >= s_written / 2 || sample != s_stream[played]) {
+            FAIL("sample %u played as %d, expected %d", played, sample,
+                 played < s_written / 2 ? s_stream[played] : 0);
+        }
+        played++;
+    }
+    if (played != s_written / 2) {
+        FAIL("%u of %u samples played", played, s_written / 2);
+    }
+}
+
+/* The latency the amplifier reports, in ticks, is the one the SAI saw */
+static void check_latency(const amp_stats_t *stats)
+{
+    if (s_max_latency_us > s_seen_latency_us) {
+        s_seen_latency_us = s_max_latency_us;
+    }
+    if (stats->maxLatencyMs > s_seen_latency_us / 1000 + 1 || stats->maxLatencyMs + 1 < s_seen_latency_us / 1000) {
+        FAIL("the amplifier reports up to %u ms of latency, the SAI saw %llu us", stats->maxLatencyMs,
+             (unsigned long long)s_seen_latency_us);
+    }
+}
+
+static void back_to_back(void)
+{
+    fake_sai_stats_t sai;
+    amp_stats_t before;
+    amp_stats_t after;
+
+    s_scenario = "back to back";
+    make_buffers();
+    fake_sai_reset();
+    SLN_AMP_GetStats(&before);
+
+    s_refill = true;
+    while (write_next() == kStatus_Success) {
+    }
+    sim_run_until(all_done, NULL, 10000);
+    s_refill = false;
+    sim_run_until(sai_stopped, NULL, 1000);
+    fake_sai_get_stats(&sai);
+    SLN_AMP_GetStats(&after);
+
+    check_output();
+    check_latency(&after);
+    if (s_failed) {
+        FAIL("%d buffers not played", s_failed);
+    }
+    /* Only the silence closing the playback */
+    if (sai.underruns || after.gaps != before.gaps
+        || after.silenceChunks - before.silenceChunks != TEST_SILENCE_MS / 2) {
+        FAIL("%u underruns, %u gaps, %u silence chunks", sai.underruns, after.gaps - before.gaps,
+             after.silenceChunks - before.silenceChunks);
+    }
+    printf("amplifier: %d buffers back to back, no gap, enqueue to play latency up to %llu us\n",
+           TEST_BUFFERS, (unsigned long long)s_max_latency_us);
+}
+
+static void late_producer(void)
+{
+    fake_sai_stats_t sai;
+    amp_stats_t before;
+    amp_stats_t after;
+    uint32_t late_writes = 0;
+    uint32_t stops = 0;
+
+    s_scenario = "late producer";
+    make_buffers();
+    fake_sai_reset();
+    SLN_AMP_GetStats(&before);
+
+    while (s_buf_count < TEST_BUFFERS) {
+        /* Clear of the end of the silence, which depends on where the last chunk ended */
+        uint32_t late_ms = (rand() % 4) ? rand() % (TEST_SILENCE_MS - 2) : TEST_SILENCE_MS + 5 + rand() % 10;
+
+        if (write_next() != kStatus_Success) {
+            FAIL("write of buffer %d failed", s_buf_count);
+        }
+        sim_run_until(all_done, NULL, 1000);
+        sim_run(late_ms);
+        if (s_buf_count == TEST_BUFFERS) {
+            break;
+        }
+        /* The last chunk still plays when the buffer completes, silence follows it */
+        if (late_ms < TEST_SILENCE_MS) {
+            late_writes++;
+        } else {
+            stops++;
+        }
+    }
+    sim_run_until(sai_stopped, NULL, 1000);
+    fake_sai_get_stats(&sai);
+    SLN_AMP_GetStats(&after);
+
+    check_output();
+    if (sai.underruns != stops) {
+        FAIL("%u underruns for %u writes after the end of the playback", sai.underruns, stops);
+    }
+    if (after.gaps - before.gaps != late_writes) {
+        FAIL("%u gaps for %u late writes", after.gaps - before.gaps, late_writes);
+    }
+    /* At most the end of the silence chunk playing and the one queued behind it */
+    if (s_max_latency_us > 2 * 2000) {
+        FAIL("enqueue to play latency up to %llu us, more than two silence chunks",
+             (unsigned long long)s_max_latency_us);
+    }
+    check_latency(&after);
+    printf("amplifier: %u late writes bridged with %u silence chunks, %u stops, latency up to %llu us "
+           "(reported %u ms)\n",
+           late_writes, after.silenceChunks - before.silenceChunks, stops,
+           (unsigned long long)s_max_latency_us, after.maxLatencyMs);
+}
+
+static void busy_contract(void)
+{
+    amplifier_status_t ret;
+    size_t length;
+    uint32_t loops;
+
+    s_scenario = "busy";
+    make_buffers();
+    fake_sai_reset();
+
+    if (SLN_AMP_Write(s_buf_data[0], s_buf_length[0]) != kStatus_Success) {
+        FAIL("first write refused");
+    }
+    ret = SLN_AMP_Write(s_buf_data[1], s_buf_length[1]);
+    if (ret != 1) {
+        FAIL("second write returned %d while the first plays", (int)ret);
+    }
+    ret = SLN_AMP_WriteLoop(s_buf_data[1], s_buf_length[1]);
+    if (ret != 1) {
+        FAIL("loop write returned %d while the first plays", (int)ret);
+    }
+    if (write_next() != kStatus_Success) {
+        FAIL("async write refused while a write plays");
+    }
+
+    /* Busy until played, the async buffer behind it does not count */
+    sim_run(s_buf_length[0] / PCM_AMP_DATA_SIZE_1_MS + 2);
+    if (SLN_AMP_Write(s_buf_data[1], s_buf_length[1]) != kStatus_Success) {
+        FAIL("write refused once the previous one played");
+    }
+    sim_run_until(all_done, NULL, 1000);
+    sim_run_until(sai_stopped, NULL, 1000);
+
+    fake_sai_reset();
+    if (SLN_AMP_WriteLoop(s_buf_data[2], s_buf_length[2]) != kStatus_Success) {
+        FAIL("loop write refused");
+    }
+    sim_run(500);
+    if (SLN_AMP_Write(s_buf_data[3], s_buf_length[3]) != 1) {
+        FAIL("write accepted while looping");
+    }
+    SLN_AMP_AbortWrite();
+    sim_run_until(sai_stopped, NULL, 1000);
+    fake_sai_output(&length);
+    loops = length / s_buf_length[2];
+    if (loops < 500 * PCM_AMP_DATA_SIZE_1_MS / s_buf_length[2]) {
+        FAIL("loop played %zu bytes in 500ms", length);
+    }
+    if (SLN_AMP_Write(s_buf_data[3], s_buf_length[3]) != kStatus_Success) {
+        FAIL("write refused after the loop was aborted");
+    }
+    sim_run(TEST_MAX_BUFFER_MS + TEST_SILENCE_MS + 10);
+    printf("amplifier: busy while a write plays, loop played %u times until aborted\n", loops);
+}
+
+static void pool_slots(void)
+{
+    SemaphoreHandle_t sem = xSemaphoreCreateCounting(TEST_POOL_SLOTS, TEST_POOL_SLOTS);
+    uint32_t written = 0;
+
+    s_scenario = "pool";
+    make_buffers();
+    fake_sai_reset();
+    SLN_AMP_SetBufferPoolSemaphore(sem);
+
+    /* Take a slot per write like streamer_pcm, play some and abort the rest */
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 20; i++) {
+            xSemaphoreTake(sem, portMAX_DELAY);
+            if (s_pool == 0) {
+                FAIL("pool semaphore given without a free slot");
+            }
+            s_pool--;
+            if (SLN_AMP_WriteNoWait(s_buf_data[i], s_buf_length[i]) != kStatus_Success) {
+                FAIL("no wait write %d refused", i);
+            }
+            written++;
+        }
+        if (round == 0) {
+            sim_run(TEST_POOL_SLOTS * TEST_MAX_BUFFER_MS + TEST_SILENCE_MS);
+        } else {
+            SLN_AMP_Abort();
+        }
+    }
+    if (s_pool != TEST_POOL_SLOTS || uxSemaphoreGetCount(sem) != TEST_POOL_SLOTS) {
+        FAIL("%u of %u pool slots back, semaphore at %lu", s_pool, TEST_POOL_SLOTS,
+             (unsigned long)uxSemaphoreGetCount(sem));
+    }
+    SLN_AMP_SetBufferPoolSemaphore(NULL);
+    vSemaphoreDelete(sem);
+    printf("amplifier: %u no wait writes gave back their pool slot once, abort included\n", written);
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < TEST_STREAM_BYTES / 2; i++) {
+        s_stream[i] = (int16_t)(1 + i % 30000);
+    }
+    srand(30);
+
+    fake_sai_init();
+    fake_sai_set_start_hook(start_hook);
+    if (SLN_AMP_Init(&s_pool) != kStatus_Success) {
+        FAIL("init failed");
+    }
+
+    late_producer();
+    back_to_back();
+    busy_contract();
+    pool_slots();
+
+    if (s_tickless_next_us != 0) {
+        FAIL("TX interrupt announced after the end of the playback");
+    }
+    printf("amplifier: %u TX interrupts announced to the tickless idle on time\n", s_tickless_reports);
+    return 0;
+}
@@ -0,0 +1,7 @@
+/*
+ * Host stand-in for the application asd_log_config.h, turns the tokenized lines on.
+ */
+
+#pragma once
+
+#define ASD_LOG_TOKENIZED 1
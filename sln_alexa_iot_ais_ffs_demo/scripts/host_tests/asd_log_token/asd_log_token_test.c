@@ -0,0 +1,249 @@
+/*
+ * Host check of the tokenized log lines of asd_log_token.c, and of the decoder in
+ * scripts/asd_log_decode.py.
+ *
+ * Builds the real asd_log_token.c with ASD_LOG_TOKENIZED set; GNU ld places the
+ * format strings in the asd_log_fmt section as on the target. Each line is encoded
+ * and decoded back, and the text is compared with the one the text logger stores
+ * (vsnprintf of the tag, the function name and line number, and the message).
+ * The lines are also written to the directory given on the command line, in the
+ * raw format of "log dumpraw", with the expected text of each;
+ * check_decode.py then decodes them with decode() from the decoder.
+ *
+ * The log lines taken from the tree are also counted as a benchmark: the bytes per
+ * line in flash (line header and body), tokenized and in text, and the CPU time per
+ * call of asd_log_token_encode() and of the vsnprintf() of the text logger, each the
+ * best of a few timed loops over the line. Encoding has to be the cheaper one.
+ *
+ * Build and run with "make -C scripts/host_tests asd_log_token".
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "asd_log_token.h"
+#include "asd_log_msg.h"
+#include "asd_log_platform_api.h"
+#include "asd_logger_internal_config.h"
+
+static FILE *s_raw;
+static FILE *s_expected;
+static int s_failures;
+static int s_cases;
+static uint32_t s_lines;
+static uint32_t s_token_bytes;
+static uint32_t s_text_bytes;
+static uint64_t s_token_ns;
+static uint64_t s_text_ns;
+
+#define BENCH_CALLS  20000
+#define BENCH_ROUNDS 5
+
+static uint64_t now_ns(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((uint64_t)time.tv_sec * 1000000000ULL) + (uint64_t)time.tv_nsec;
+}
+
+// the text body the text logger stores for the line.
+static int text_body(char *txt, uint32_t size, const asd_log_options_t *options,
+                     const char *fmt, va_list args)
+{
+    int len = 0;
+
+    if (options->tag) {
+        len += snprintf(txt + len, size - len, "%s:", options->tag);
+    }
+    if (options->func_name && options->func_name[0]) {
+        len += snprintf(txt + len, size - len, "%.*s:%d:", ASD_LOGGER_FUNC_NAME_LENGTH_MAX,
+                        options->func_name, options->line_no);
+    }
+    len += vsnprintf(txt + len, size - len, fmt, args);
+    return len;
+}
+
+static void write_line(const uint8_t *body, uint32_t length, bool tokenized)
+{
+    uint8_t line[ASD_LOG_LINE_HEADER_BIN_SIZE + ASD_LOG_LINE_MAXSIZE] = {0};
+    asd_log_line_header_t *header = (asd_log_line_header_t *)line;
+    uint16_t raw_length = ASD_LOG_LINE_HEADER_BIN_SIZE + length;
+
+    ASD_LOG_LINE_HEADER_SET(header, 1700000000123ULL + s_cases, ASD_LOG_LEVEL_WARN,
+                            7, 0x60012345);
+    header->tokenized = tokenized;
+    memcpy(header->data, body, length);
+
+    uint8_t prefix[ASD_LOG_RAW_LINE_LENGTH_SIZE] = {raw_length & 0xFF, raw_length >> 8};
+    fwrite(prefix, 1, sizeof(prefix), s_raw);
+    fwrite(line, 1, raw_length, s_raw);
+}
+
+/*
+ * Encode one line, decode it back and compare with the text line. 'bench' counts
+ * the line in the benchmark.
+ */
+static void check_line(bool bench, const char *tag, const char *func_name, int line_no,
+                       const char *fmt, ...)
+{
+    asd_log_options_t options = {
+        .level = ASD_LOG_LEVEL_WARN,
+        .tag = tag,
+        .func_name = func_name,
+        .line_no = line_no,
+    };
+    uint8_t body[ASD_LOG_LINE_MAXSIZE];
+    char ref[ASD_LOG_LINE_MAXSIZE];
+    char txt[ASD_LOG_LINE_MAXSIZE];
+    va_list args;
+
+    s_cases++;
+
+    va_start(args, fmt);
+    int ref_len = text_body(ref, sizeof(ref), &options, fmt, args);
+    va_end(args);
+
+    va_start(args, fmt);
+    int32_t length = asd_log_token_encode(body, sizeof(body), &options, fmt, args);
+    va_end(args);
+    if (length < 0) {
+        fprintf(stderr, "case %d \"%s\": encode failed, rc %ld\n", s_cases, fmt, (long)length);
+        s_failures++;
+        return;
+    }
+
+    int32_t txt_len = asd_log_token_decode(body, length, txt, sizeof(txt));
+    if (txt_len != ref_len || strcmp(txt, ref)) {
+        fprintf(stderr, "case %d: decoded \"%s\" (%ld), expected \"%s\" (%d)\n",
+                s_cases, txt, (long)txt_len, ref, ref_len);
+        s_failures++;
+        return;
+    }
+
+    write_line(body, length, true);
+    fprintf(s_expected, "%s\n", ref);
+
+    if (!bench) {
+        return;
+    }
+    s_lines++;
+    s_token_bytes += ASD_LOG_LINE_HEADER_BIN_SIZE + length;
+    s_text_bytes += ASD_LOG_LINE_HEADER_BIN_SIZE + ref_len;
+
+    // the best round of each, so a preempted round does not count.
+    uint64_t token_ns = UINT64_MAX;
+    uint64_t text_ns = UINT64_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < BENCH_CALLS; i++) {
+            va_start(args, fmt);
+            asd_log_token_encode(body, sizeof(body), &options, fmt, args);
+            va_end(args);
+        }
+        uint64_t ns = now_ns() - start;
+        token_ns = (ns < token_ns) ? ns : token_ns;
+
+        start = now_ns();
+        for (int i = 0; i < BENCH_CALLS; i++) {
+            va_start(args, fmt);
+            text_body(txt, sizeof(txt), &options, fmt, args);
+            va_end(args);
+        }
+        ns = now_ns() - start;
+        text_ns = (ns < text_ns) ? ns : text_ns;
+    }
+    s_token_ns += token_ns;
+    s_text_ns += text_ns;
+}
+
+static FILE *open_file(const char *dir, const char *name)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "cannot write %s\n", path);
+        exit(1);
+    }
+    return f;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s OUTPUT_DIR\n", argv[0]);
+        return 2;
+    }
+    s_raw = open_file(argv[1], "raw.bin");
+    s_expected = open_file(argv[1], "expected.txt");
+
+    // log lines of the tree.
+    check_line(true, "logReader", NULL, 0,
+               ASD_LOG_FMT("crash log section %d length reports %d, but read %d"), 3, 1024, 977);
+    check_line(true, "logReader", NULL, 0, ASD_LOG_FMT("Fail to get frame info rc = %d"), -55);
+    check_line(true, "logReader", NULL, 0,
+               ASD_LOG_FMT("frame info pos: %lu, log_len %lu"), 123456UL, 0UL);
+    check_line(true, "logReader", NULL, 0, ASD_LOG_FMT("too small buffer"));
+    check_line(true, "RebootMgr", NULL, 0,
+               ASD_LOG_FMT("failed to write reboot record: %d"), -5);
+    check_line(true, "RebootMgr", NULL, 0,
+               ASD_LOG_FMT("Reason: %s, uptime: %lu sec, time: %.*s (%lu)"),
+               "WATCHDOG", 86400UL, 19, "2023-11-14 22:13:20 UTC", 1700000000UL);
+    check_line(true, "RebootMgr", NULL, 0, ASD_LOG_FMT("%-2u %-32s %-12lu %-16lu %.*s"),
+               2u, "SOFTWARE", 3600UL, 1700000000UL, 19, "2023-11-14 22:13:20");
+    check_line(true, "ace_hal", NULL, 0,
+               ASD_LOG_FMT("Failed to set %s with error (%d:%s)"), "wifi.ssid", -3, "AFW_EIO");
+    check_line(true, "ace_hal", NULL, 0, ASD_LOG_FMT("The key %s does not exist"), "dha.cert");
+    check_line(true, "crashdump", NULL, 0,
+               ASD_LOG_FMT("asd_crashdump_read_raw failed. rc =%ld"), -22L);
+    check_line(true, "logReader", "log_reader_read", 354,
+               ASD_LOG_FMT("read log line failed. rc = %d"), -7);
+
+    // function name: none, empty, truncated.
+    check_line(false, "afw", "", 12, ASD_LOG_FMT("empty name %d %s"), 5, "x");
+    check_line(false, "afw", NULL, 12, ASD_LOG_FMT("no name %d"), 5);
+    check_line(false, "afw", "a_function_name_longer_than_the_limit", 1234,
+               ASD_LOG_FMT("long name %u"), 7u);
+    check_line(false, NULL, NULL, 0, ASD_LOG_FMT("no tag"));
+
+    // conversions.
+    check_line(false, "afw", NULL, 0,
+               ASD_LOG_FMT("%-8s|%08x|%5.2f|%c|%%|%+d|%.3s|%*d|%.*s|%#o|%X"),
+               "ab", 0xbeefu, 3.14159, 'z', 42, "abcdef", 6, -7, 2, "xyz", 15u, 0xABCu);
+    check_line(false, "afw", NULL, 0, ASD_LOG_FMT("%hhd %hu %lld %llu %zu %p %e %g"),
+               (signed char)-3, (unsigned short)65535, -1234567890123LL,
+               18446744073709551615ULL, (size_t)99, (void *)0x2000, 12345.678, 0.0001);
+    check_line(false, "afw", NULL, 0, ASD_LOG_FMT("%s %-*d| %.*s|"),
+               (char *)NULL, -6, 3, -1, "negative precision");
+
+    // a text line between the tokenized ones.
+    const char *plain = "tag:plain text";
+    write_line((const uint8_t *)plain, strlen(plain), false);
+    fprintf(s_expected, "%s\n", plain);
+
+    fclose(s_raw);
+    fclose(s_expected);
+
+    if (s_failures) {
+        printf("asd log token: %d of %d cases FAILED\n", s_failures, s_cases);
+        return 1;
+    }
+    if (s_token_ns >= s_text_ns) {
+        printf("asd log token: encoding took %llu ns, formatting the text %llu ns\n",
+               (unsigned long long)s_token_ns, (unsigned long long)s_text_ns);
+        return 1;
+    }
+    printf("asd log token: %d cases\n", s_cases);
+    printf("asd log token: %lu log lines, %lu bytes per line in flash tokenized, %lu in text\n",
+           (unsigned long)s_lines, (unsigned long)(s_token_bytes / s_lines),
+           (unsigned long)(s_text_bytes / s_lines));
+    printf("asd log token: %.1f ns per line encoding, %.1f ns formatting the text\n",
+           (double)s_token_ns / ((uint64_t)s_lines * BENCH_CALLS),
+           (double)s_text_ns / ((uint64_t)s_lines * BENCH_CALLS));
+    return 0;
+}
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+"""
+Decode the lines written by asd_log_token_test with decode() from
+scripts/asd_log_decode.py, the formats taken from the test ELF, and compare
+them with the text of the text logger.
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..'))
+
+from asd_log_decode import read_raw, load_formats, decode
+
+
+def main():
+    out_dir, elf = sys.argv[1], sys.argv[2]
+    objcopy = os.environ.get('OBJCOPY', 'objcopy')
+
+    with open(os.path.join(out_dir, 'expected.txt')) as f:
+        expected = f.read().splitlines()
+    lines = decode(read_raw(os.path.join(out_dir, 'raw.bin'), True), load_formats(elf, objcopy))
+    failures = 0
+
+    if len(lines) != len(expected):
+        print("asd log token: decoded %d lines, expected %d" % (len(lines), len(expected)))
+        return 1
+
+    for i, ((text, _, _), ref) in enumerate(zip(lines, expected)):
+        # drop the "[date time level task pc]" header.
+        text = text.split(']', 1)[1]
+        if text != ref:
+            print("line %d: decoded \"%s\", expected \"%s\"" % (i + 1, text, ref))
+            failures += 1
+
+    if failures or not lines:
+        print("asd log token: %d of %d lines FAILED to decode" % (failures, len(lines)))
+        return 1
+    print("asd log token: decoded %d lines" % len(lines))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
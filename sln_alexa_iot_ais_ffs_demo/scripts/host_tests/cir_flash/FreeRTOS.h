@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build afw_cir_flash.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+#define pdPASS  ( pdTRUE )
+
+#define portMAX_DELAY      ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS ( ( TickType_t ) 1 )
+#define portSTACK_TYPE     StackType_t
+#define portPRIVILEGE_BIT  ( ( UBaseType_t ) 0x00 )
+
+#define tskIDLE_PRIORITY   ( ( UBaseType_t ) 0U )
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,368 @@
+/*
+ * Host check of afw_cir_flash.c on a simulated NOR partition, with power cuts.
+ *
+ * Builds the real afw_cir_flash.c against the stub headers in this directory,
+ * without the erase task: the workload calls afw_cir_flash_erase() itself. The
+ * partition is kept in RAM and behaves as NOR: programming only clears bits,
+ * erasing sets 4K blocks back to 0xFF.
+ *
+ * A random workload writes entries in pieces, reads and erases them. Each entry
+ * holds its sequence number, its length and a pattern, so a reader can tell a
+ * lost entry from a corrupt one. The steady run prints the flash programs per
+ * entry and the erase counts.
+ *
+ * Each power cut run then arms a cut after a random number of programs: the
+ * program that is cut stores only a random prefix of its bytes, an erase that
+ * is cut only the first blocks, and nothing reaches the flash afterwards. The
+ * partition is initialized again and read back, twice per run:
+ *  - the entries come back in order, intact, at most the last read one twice;
+ *  - none of the entries completed before the cut and not read yet is
+ *    missing. Built with AFW_CIR_FLASH_DEFER_WRITE, only the entries
+ *    programmed by afw_cir_flash_flush() before the cut have to survive, those
+ *    still in RAM may be lost.
+ *
+ * It is built and run once per AFW_CIR_FLASH_DEFER_WRITE setting.
+ *
+ * The runs that found a bug are run first, then the given number of runs from
+ * the given first one, 2000 from 0 by default.
+ *
+ * Build and run with "make -C scripts/host_tests cir_flash".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <afw_def.h>
+#include <afw_cir_flash.h>
+#include <flash_manager.h>
+
+#define TEST_PART_SIZE      (64 * 1024)
+#define TEST_BLOCK_SIZE     4096
+#define TEST_MAX_ENTRY      1200
+#define TEST_CUTS_PER_RUN   2
+#define TEST_DEFAULT_RUNS   2000
+
+#define NO_SEQ              0xFFFFFFFFU
+
+/* Runs that tore the length of an entry completed in a batch */
+static const int s_regression_runs[] = { 7482, 13568, 19143 };
+
+static uint8_t s_nor[TEST_PART_SIZE];
+static struct fm_flash_partition s_part = { .name = "test", .size = TEST_PART_SIZE };
+
+static long s_programs;
+static long s_erases;
+static long s_cut_after = -1;
+static bool s_dead;
+
+static uint32_t s_next_seq;       /* Sequence number of the next entry written */
+static uint32_t s_last_read_seq;  /* Last entry read, NO_SEQ for none */
+static uint32_t s_durable_seq;    /* Entries before it were in flash before the cut */
+static uint32_t s_expect_seq;     /* Next flushed entry the reader should see */
+static uint32_t s_recovered;
+
+static int s_run;
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("cir flash: run %d: ", s_run);       \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+struct fm_flash_partition *fm_flash_get_partition(const char *name)
+{
+    return &s_part;
+}
+
+int fm_flash_read(struct fm_flash_partition *part, int client_id,
+                  unsigned long from, uint32_t len, uint8_t *buf)
+{
+    if (from + len > TEST_PART_SIZE) {
+        FAIL("read of %u bytes at 0x%lx out of the partition", len, from);
+    }
+    memcpy(buf, s_nor + from, len);
+    return len;
+}
+
+int fm_flash_write(struct fm_flash_partition *part, int client_id,
+                   unsigned long to, uint32_t len, const uint8_t *buf)
+{
+    uint32_t programmed = len;
+
+    if (len == 0 || to + len > TEST_PART_SIZE) {
+        FAIL("write of %u bytes at 0x%lx out of the partition", len, to);
+    }
+    if (s_dead) {
+        return len;
+    }
+
+    s_programs++;
+    if (s_cut_after >= 0 && s_programs > s_cut_after) {
+        programmed = rand() % (len + 1);
+        s_dead = true;
+    }
+    for (uint32_t i = 0; i < programmed; i++) {
+        s_nor[to + i] &= buf[i];
+    }
+    return len;
+}
+
+int fm_flash_erase_sectors(struct fm_flash_partition *part, int client_id,
+                           size_t offset, size_t xBytes)
+{
+    if (offset % TEST_BLOCK_SIZE || xBytes % TEST_BLOCK_SIZE
+        || offset + xBytes > TEST_PART_SIZE) {
+        FAIL("erase of %zu bytes at 0x%zx not on blocks of the partition", xBytes, offset);
+    }
+    if (s_dead) {
+        return 0;
+    }
+
+    s_erases++;
+    if (s_cut_after >= 0 && s_programs >= s_cut_after) {
+        xBytes = TEST_BLOCK_SIZE * (rand() % (xBytes / TEST_BLOCK_SIZE + 1));
+        s_dead = true;
+    }
+    memset(s_nor + offset, 0xFF, xBytes);
+    return 0;
+}
+
+static uint8_t pattern(uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq * 31 + i);
+}
+
+/* Write one entry in random pieces, if there is room for it */
+static void write_one(afw_cir_flash_t *flash)
+{
+    uint8_t buf[TEST_MAX_ENTRY];
+    afw_cir_flash_info_t info;
+    uint32_t len = 8 + rand() % 300;
+    uint32_t off = 0;
+    int32_t ret;
+
+    if (rand() % 20 == 0) {
+        len = 8 + rand() % (TEST_MAX_ENTRY - 100);
+    }
+    memcpy(buf, &s_next_seq, 4);
+    memcpy(buf + 4, &len, 4);
+    for (uint32_t i = 8; i < len; i++) {
+        buf[i] = pattern(s_next_seq, i);
+    }
+
+    afw_cir_flash_get_info(flash, &info);
+    if (info.avail_free_size < len + 1 || info.avail_free_entries < 2) {
+        return;
+    }
+
+    while (off < len) {
+        uint32_t n = 1 + rand() % (len - off);
+
+        ret = afw_cir_flash_write(flash, n, buf + off);
+        if (ret == -AFW_CIR_FLASH_ENO_FREE_SPACE && off == 0) {
+            return;
+        }
+        if (ret != AFW_OK) {
+            if (s_dead) {
+                return;
+            }
+            FAIL("write of entry %u failed, %ld", s_next_seq, (long)ret);
+        }
+        off += n;
+    }
+
+    ret = afw_cir_flash_write_complete(flash);
+    if (ret != AFW_OK) {
+        if (s_dead) {
+            return;
+        }
+        FAIL("write complete of entry %u failed, %ld", s_next_seq, (long)ret);
+    }
+    s_next_seq++;
+
+#if !AFW_CIR_FLASH_DEFER_WRITE
+    /* Completed in flash, unless the cut came during it */
+    if (s_cut_after >= 0 && !s_dead) {
+        s_durable_seq = s_next_seq;
+    }
+#endif
+}
+
+/* Read and check the next entry. Return false when there is none */
+static bool read_one(afw_cir_flash_t *flash)
+{
+    uint8_t buf[TEST_MAX_ENTRY];
+    uint32_t len;
+    uint32_t seq;
+    uint32_t stored_len;
+    int32_t ret;
+
+    ret = afw_cir_flash_get_read_data_length(flash, &len);
+    if (ret == -AFW_CIR_FLASH_ENO_BYTES || s_dead) {
+        return false;
+    }
+    if (ret != AFW_OK) {
+        FAIL("read length failed, %ld", (long)ret);
+    }
+    if (len < 8 || len > sizeof(buf)) {
+        FAIL("bad entry length %u after entry %u", len, s_last_read_seq);
+    }
+
+    ret = afw_cir_flash_read(flash, len, buf);
+    if (ret != AFW_OK) {
+        if (s_dead) {
+            return false;
+        }
+        FAIL("read failed, %ld", (long)ret);
+    }
+
+    memcpy(&seq, buf, 4);
+    memcpy(&stored_len, buf + 4, 4);
+    if (stored_len != len || seq >= s_next_seq
+        || (s_last_read_seq != NO_SEQ && seq < s_last_read_seq)) {
+        FAIL("bad entry after entry %u: seq %u, length %u, stored length %u",
+             s_last_read_seq, seq, len, stored_len);
+    }
+    for (uint32_t i = 8; i < len; i++) {
+        if (buf[i] != pattern(seq, i)) {
+            FAIL("entry %u corrupt at byte %u", seq, i);
+        }
+    }
+
+    /* The flushed entries come back one after the other */
+    if (seq < s_durable_seq && seq + 1 != s_expect_seq) {
+        if (seq != s_expect_seq) {
+            FAIL("durable entry %u lost, read entry %u", s_expect_seq, seq);
+        }
+        s_expect_seq = seq + 1;
+    }
+    s_last_read_seq = seq;
+
+    ret = afw_cir_flash_read_complete(flash);
+    if (ret != AFW_OK) {
+        if (s_dead) {
+            return false;
+        }
+        FAIL("read complete of entry %u failed, %ld", seq, (long)ret);
+    }
+    return true;
+}
+
+static void workload(afw_cir_flash_t *flash, int steps)
+{
+    for (int step = 0; step < steps && !s_dead; step++) {
+        int op = rand() % 10;
+
+        if (op < 6) {
+            write_one(flash);
+        } else if (op < 9) {
+            read_one(flash);
+        } else {
+            afw_cir_flash_erase(flash);
+        }
+    }
+}
+
+/* Drop the RAM state the way a reset does, nothing is flushed */
+static void power_off(afw_cir_flash_t *flash)
+{
+    vSemaphoreDelete(flash->mutex);
+    vEventGroupDelete(flash->erase_async_event);
+    free(flash->erase_count);
+    free(flash->write_buf);
+}
+
+static void power_cut_run(void)
+{
+    afw_cir_flash_t flash;
+    int32_t ret;
+
+    srand(100 + s_run);
+    memset(s_nor, 0xFF, sizeof(s_nor));
+    s_dead = false;
+    s_programs = 0;
+    s_cut_after = -1;
+    s_next_seq = 0;
+    s_last_read_seq = NO_SEQ;
+    s_durable_seq = 0;
+
+    if (afw_cir_flash_init("test", &flash) != AFW_OK) {
+        FAIL("init of the empty partition failed");
+    }
+    workload(&flash, 300 + rand() % 3000);
+
+    for (int cut = 0; cut < TEST_CUTS_PER_RUN; cut++) {
+        ret = afw_cir_flash_flush(&flash);
+        if (ret != AFW_OK) {
+            FAIL("flush failed, %ld", (long)ret);
+        }
+        s_durable_seq = s_next_seq;
+        s_expect_seq = (s_last_read_seq == NO_SEQ) ? 0 : s_last_read_seq + 1;
+
+        s_cut_after = s_programs + rand() % 400;
+        workload(&flash, 100000);
+        if (!s_dead) {
+            break;
+        }
+
+        power_off(&flash);
+        s_cut_after = -1;
+        s_dead = false;
+
+        ret = afw_cir_flash_init("test", &flash);
+        if (ret != AFW_OK) {
+            FAIL("init after cut %d failed, %ld", cut, (long)ret);
+        }
+        while (read_one(&flash)) {
+            s_recovered++;
+        }
+        if (s_expect_seq < s_durable_seq) {
+            FAIL("durable entries %u to %u lost after cut %d", s_expect_seq,
+                 s_durable_seq - 1, cut);
+        }
+        s_durable_seq = 0;
+
+        workload(&flash, 3000);
+    }
+
+    while (read_one(&flash)) {
+    }
+    afw_cir_flash_deinit(&flash);
+}
+
+int main(int argc, char **argv)
+{
+    afw_cir_flash_t flash;
+    afw_cir_flash_info_t info;
+    int runs = (argc > 1) ? atoi(argv[1]) : TEST_DEFAULT_RUNS;
+    int first = (argc > 2) ? atoi(argv[2]) : 0;
+
+    srand(1);
+    memset(s_nor, 0xFF, sizeof(s_nor));
+    s_last_read_seq = NO_SEQ;
+    if (afw_cir_flash_init("test", &flash) != AFW_OK) {
+        FAIL("init of the empty partition failed");
+    }
+    workload(&flash, 20000);
+    afw_cir_flash_get_info(&flash, &info);
+    printf("cir flash: %s, %u entries, %.2f programs per entry, %ld erases, "
+           "table blocks erased %u times, data blocks %u to %u\n",
+           AFW_CIR_FLASH_DEFER_WRITE ? "deferred" : "on complete", s_next_seq, (double)info.programs / s_next_seq, s_erases,
+           info.table_erase_count, info.data_erase_count_min, info.data_erase_count_max);
+    afw_cir_flash_deinit(&flash);
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(s_regression_runs); i++) {
+        s_run = s_regression_runs[i];
+        power_cut_run();
+    }
+    for (s_run = first; s_run < first + runs; s_run++) {
+        power_cut_run();
+    }
+    printf("cir flash: %s, %d power cut runs, %u entries read back after a cut\n",
+           AFW_CIR_FLASH_DEFER_WRITE ? "deferred" : "on complete",
+           (int)ARRAY_SIZE(s_regression_runs) + runs, s_recovered);
+    return 0;
+}
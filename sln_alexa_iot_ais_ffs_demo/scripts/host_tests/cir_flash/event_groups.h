@@ -0,0 +1,31 @@
+/*
+ * Host stand-in for event_groups.h, the bits are only set: nothing waits on
+ * them without the erase task.
+ */
+
+#ifndef EVENT_GROUPS_H
+#define EVENT_GROUPS_H
+
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+
+typedef TickType_t EventBits_t;
+typedef EventBits_t *EventGroupHandle_t;
+
+static inline EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(EventBits_t));
+}
+
+static inline void vEventGroupDelete(EventGroupHandle_t group)
+{
+    free(group);
+}
+
+static inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, const EventBits_t bits)
+{
+    return *group |= bits;
+}
+
+#endif /* EVENT_GROUPS_H */
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for iot_flash.h, just the types flash_manager.h names.
+ */
+
+#ifndef _IOT_FLASH_H_
+#define _IOT_FLASH_H_
+
+typedef struct IotFlashInfo {
+    int unused;
+} IotFlashInfo_t;
+
+typedef int IotFlashIoctlRequest_t;
+
+typedef void (*IotFlashCallback_t)(int xStatus, void *pvUserContext);
+
+#endif /* _IOT_FLASH_H_ */
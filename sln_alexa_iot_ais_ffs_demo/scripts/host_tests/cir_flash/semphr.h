@@ -0,0 +1,41 @@
+/*
+ * Host stand-in for semphr.h. A single thread: the mutex only checks that it
+ * is taken and given in pairs.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+
+typedef int *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(int));
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t mutex)
+{
+    assert(*mutex == 0);
+    free(mutex);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t wait)
+{
+    assert(*mutex == 0);
+    *mutex = 1;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    assert(*mutex == 1);
+    *mutex = 0;
+    return pdTRUE;
+}
+
+#endif /* SEMAPHORE_H */
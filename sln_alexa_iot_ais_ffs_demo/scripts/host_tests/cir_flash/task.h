@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for task.h. The test builds afw_cir_flash.c without the erase
+ * task, nothing is scheduled.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build asd_crashdump.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+
+#define configMAX_TASK_NAME_LEN 12
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for asd_log_platform_api.h, logs go to stderr.
+ */
+
+#ifndef ASD_LOG_PLATFORM_API_H
+#define ASD_LOG_PLATFORM_API_H
+
+#include <stdio.h>
+
+#define asd_log_create_module(module, level, streams) \
+    static const char asd_log_module_##module[] = #module
+#define ASD_LOG_E(module, ...) fprintf(stderr, __VA_ARGS__)
+
+#endif /* ASD_LOG_PLATFORM_API_H */
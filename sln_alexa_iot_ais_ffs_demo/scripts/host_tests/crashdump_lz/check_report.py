@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+Run the fault reports written by crashdump_lz_test through
+scripts/crashdump_decode.py and compare the registers, the unpacked memory
+and the backtrace it prints with the fault the test saved.
+"""
+
+import os
+import subprocess
+import sys
+
+DECODER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'crashdump_decode.py')
+
+
+def read_expect(path):
+    expect = {'regs': [], 'memory': {}, 'frames': []}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if fields[0] == 'reg':
+                expect['regs'].append((fields[1], int(fields[2], 16)))
+            elif fields[0] == 'frame':
+                expect['frames'].append((fields[1], int(fields[2], 16)))
+            else:
+                expect['memory'][fields[0]] = (int(fields[1], 16), int(fields[2]))
+    return expect
+
+
+def check(prefix):
+    expect = read_expect(prefix + '.expect')
+    proc = subprocess.run([sys.executable, DECODER, prefix + '.report', '-o', prefix + '_decoded'],
+                          stdout=subprocess.PIPE, universal_newlines=True)
+    lines = proc.stdout.splitlines()
+    if proc.returncode != 0:
+        raise ValueError("decoder failed: %s" % (lines[-1] if lines else proc.returncode))
+
+    for name, value in expect['regs']:
+        if "%-6s 0x%08x" % (name, value) not in lines:
+            raise ValueError("register %s 0x%08x not decoded" % (name, value))
+
+    for name in ('stack', 'ram'):
+        if name not in expect['memory']:
+            if any(line.startswith(name + ' ') for line in lines):
+                raise ValueError("%s decoded, none saved" % name)
+            continue
+        addr, length = expect['memory'][name]
+        if "%-5s 0x%08x, %d bytes" % (name, addr, length) not in lines:
+            raise ValueError("%s at 0x%08x, %d bytes not decoded" % (name, addr, length))
+        with open(prefix + '.' + name, 'rb') as f:
+            saved = f.read()
+        with open('%s_decoded_%s.bin' % (prefix, name), 'rb') as f:
+            if f.read() != saved:
+                raise ValueError("unpacked %s differs" % name)
+
+    frames = []
+    for line in lines[lines.index('backtrace:') + 1:]:
+        fields = line.split()
+        frames.append((fields[1], int(fields[2], 16)))
+    if frames != expect['frames']:
+        raise ValueError("backtrace of %d frames, %d expected" % (len(frames), len(expect['frames'])))
+
+
+def main():
+    out_dir = sys.argv[1]
+    names = sorted(f[:-7] for f in os.listdir(out_dir) if f.endswith('.report'))
+    failures = 0
+
+    for name in names:
+        try:
+            check(os.path.join(out_dir, name))
+        except (OSError, ValueError) as e:
+            print("%s: %s" % (name, e))
+            failures += 1
+
+    if failures or not names:
+        print("crashdump report: %d of %d reports FAILED to decode" % (failures, len(names)))
+        return 1
+    print("crashdump report: decoded %d reports" % len(names))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
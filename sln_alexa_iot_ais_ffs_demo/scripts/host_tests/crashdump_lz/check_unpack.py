@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+"""
+Unpack the cases written by crashdump_lz_test with lz4_unpack() from
+scripts/crashdump_decode.py and compare them with the packer input.
+"""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..'))
+
+from crashdump_decode import lz4_unpack
+
+
+def main():
+    out_dir = sys.argv[1]
+    names = sorted(f[:-4] for f in os.listdir(out_dir) if f.endswith('.raw'))
+    failures = 0
+
+    for name in names:
+        with open(os.path.join(out_dir, name + '.raw'), 'rb') as f:
+            raw = f.read()
+        with open(os.path.join(out_dir, name + '.lz4'), 'rb') as f:
+            packed = f.read()
+        try:
+            if lz4_unpack(packed, len(raw)) != raw:
+                raise ValueError("unpacked data differs")
+        except (ValueError, IndexError) as e:
+            print("%s: %s" % (name, e))
+            failures += 1
+
+    if failures or not names:
+        print("crashdump lz: %d of %d cases FAILED to unpack" % (failures, len(names)))
+        return 1
+    print("crashdump lz: unpacked %d cases" % len(names))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
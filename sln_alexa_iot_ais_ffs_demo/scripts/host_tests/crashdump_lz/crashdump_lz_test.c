@@ -0,0 +1,525 @@
+/*
+ * Host check of asd_crashdump.c: the LZ4 packer, the ring of crash slots and
+ * the crash report read back by scripts/crashdump_decode.py.
+ *
+ * Builds the real asd_crashdump.c against the stub headers in this directory,
+ * with the crash partition kept in RAM and the RAM banks the captures are
+ * checked against mapped onto two test arrays.
+ *
+ *  - packer: inputs shaped like the captured memory (stacks, zeroed and
+ *    patterned RAM, noise, the edge lengths of the block format) go through
+ *    cd_lz_compress(). The write offsets, the crc and the worst case bound of
+ *    CD_LZ_INPUT_MAX() are checked, each input and its packed form written to
+ *    the output directory for check_unpack.py.
+ *  - slot ring: crashes saved across reboots rotate through the slots, the
+ *    oldest record is dropped when the ring is full and the records read back
+ *    oldest first.
+ *  - interrupted save: the flash stops taking writes after every byte count
+ *    of a save in turn. The header goes last, so after the reboot the torn
+ *    record is never read, the older ones are intact and the slot is reused.
+ *  - fault reports: synthetic fault frames are saved and read back through
+ *    the frame API. Each report and the expected registers, memory and
+ *    return addresses go to the output directory for check_report.py, which
+ *    runs them through crashdump_decode.py.
+ *
+ * Build and run with "make -C scripts/host_tests crashdump_lz".
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// the save path reports to the console, quiet it for the interrupted saves.
+static int crashdump_printf(const char *fmt, ...);
+#define printf crashdump_printf
+#include "asd_crashdump.c"
+#undef printf
+
+#define TEST_MAX_INPUT  4096
+#define TEST_BANK_SIZE  4096
+#define TEST_SAVES      10
+
+static uint8_t s_partition[LOG_CRASH_LOG_SIZE];
+static int s_failures;
+static int s_quiet;
+// bytes the flash programs before it stops, as on a power cut. -1 for no limit.
+static long s_write_budget = -1;
+static uint32_t s_write_bytes;
+static uint32_t s_last_write;
+
+/*
+ * The DTC and OCRAM banks of cd_ram_readable_len(). The linker symbols are
+ * declared as functions there, so they are aliases of the arrays here; built
+ * without PIE for the addresses to fit the 32-bit fields of the records.
+ */
+uint8_t test_sram_dtc[TEST_BANK_SIZE] __attribute__((aligned(8)));
+uint8_t test_sram_oc[TEST_BANK_SIZE] __attribute__((aligned(8)));
+__asm__(".globl __base_SRAM_DTC\n.set __base_SRAM_DTC, test_sram_dtc\n"
+        ".globl __top_SRAM_DTC\n.set __top_SRAM_DTC, test_sram_dtc + 4096\n"
+        ".globl __base_SRAM_OC_NON_CACHEABLE\n.set __base_SRAM_OC_NON_CACHEABLE, test_sram_oc\n"
+        ".globl __top_SRAM_OC_CACHEABLE\n.set __top_SRAM_OC_CACHEABLE, test_sram_oc + 4096\n");
+
+static int crashdump_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int rc = 0;
+
+    if (!s_quiet) {
+        va_start(ap, fmt);
+        rc = vprintf(fmt, ap);
+        va_end(ap);
+    }
+    return rc;
+}
+
+struct fm_flash_partition *fm_flash_get_partition(const char *name)
+{
+    return (struct fm_flash_partition *)s_partition;
+}
+
+int fm_flash_read(struct fm_flash_partition *part, int client_id,
+                  unsigned long from, uint32_t len, uint8_t *buf)
+{
+    if (from + len > sizeof(s_partition)) return -AFW_EINVAL;
+    memcpy(buf, s_partition + from, len);
+    return len;
+}
+
+int fm_flash_write(struct fm_flash_partition *part, int client_id,
+                   unsigned long to, uint32_t len, const uint8_t *buf)
+{
+    if (to + len > sizeof(s_partition)) return -AFW_EINVAL;
+    // NOR: programming only clears bits.
+    for (uint32_t i = 0; i < len; i++) {
+        if (s_write_budget == 0) return -AFW_EIO;
+        if (s_write_budget > 0) s_write_budget--;
+        s_partition[to + i] &= buf[i];
+        s_write_bytes++;
+    }
+    s_last_write = to;
+    return len;
+}
+
+int fm_flash_erase_sectors(struct fm_flash_partition *part, int client_id,
+                           size_t offset, size_t xBytes)
+{
+    if (offset + xBytes > sizeof(s_partition)) return -AFW_EINVAL;
+    memset(s_partition + offset, 0xFF, xBytes);
+    return 0;
+}
+
+void asd_dump_heap_stats(int (*print)(const char *fmt, ...)) {}
+
+#define CHECK(cond, ...)                               \
+    do {                                               \
+        if (!(cond)) {                                 \
+            fprintf(stderr, "%s: ", name);             \
+            fprintf(stderr, __VA_ARGS__);              \
+            fprintf(stderr, "\n");                     \
+            s_failures++;                              \
+            return;                                    \
+        }                                              \
+    } while (0)
+
+static void write_file(const char *dir, const char *name, const char *ext,
+                       const void *data, uint32_t len)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.%s", dir, name, ext);
+
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(data, 1, len, f) != len) {
+        fprintf(stderr, "cannot write %s\n", path);
+        exit(1);
+    }
+    fclose(f);
+}
+
+/*
+ * Pack 'src' at 'offset' in the partition, the way asd_crashdump_save()
+ * streams a capture after the slot header.
+ */
+static void pack_case(const char *dir, const char *name, const uint8_t *src, uint32_t len,
+                      uint32_t offset)
+{
+    cd_lz_out_t out = { .offset = offset };
+
+    memset(s_partition, 0xFF, sizeof(s_partition));
+
+    uint32_t packed = cd_lz_compress(&out, src, len);
+    cd_lz_flush(&out);
+
+    CHECK(out.rc == 0, "write failed, rc %ld", (long)out.rc);
+    CHECK(packed == out.length, "packed %u, wrote %u", packed, out.length);
+    CHECK(out.offset == offset + packed, "offset %u after %u bytes at %u",
+          out.offset, packed, offset);
+    CHECK(out.crc == crc16_update(0, s_partition + offset, packed), "crc mismatch");
+    CHECK(offset == 0 || s_partition[offset - 1] == 0xFF, "wrote before offset");
+    CHECK(offset + packed == sizeof(s_partition) || s_partition[offset + packed] == 0xFF,
+          "wrote past the packed length");
+    // the least space CD_LZ_INPUT_MAX() takes 'len' bytes of input for.
+    uint32_t space = 16 + 256 * ((len + 254) / 255);
+    CHECK(CD_LZ_INPUT_MAX(space) >= len, "bad bound for %u", len);
+    CHECK(packed <= space, "packed %u exceeds the %u bytes allowed for %u", packed, space, len);
+
+    write_file(dir, name, "raw", src, len);
+    write_file(dir, name, "lz4", s_partition + offset, packed);
+}
+
+/*
+ * A reboot: the module state is lost, asd_crashdump_init() scans the slots
+ * and erases the one the next crash goes to.
+ */
+static void reboot(void)
+{
+    s_write_budget = -1;
+    memset(&cd_config, 0, sizeof(cd_config));
+    cd_config.read_slot = -1;
+    cd_config.write_slot = -1;
+    asd_crashdump_init();
+}
+
+static void make_crash(asd_crashdump_mini_t *mini, uint32_t n)
+{
+    memset(mini, 0, sizeof(*mini));
+    mini->reason = ASD_CD_REASON_EXCEPTION_HARDFAULT;
+    mini->time = 1600000000 + n;
+    mini->uptime_sec = n;
+    mini->call_stack_depth = 4;
+    for (uint32_t i = 0; i < 4; i++) {
+        mini->call_stacks[i] = 0x60002000 + n * 0x100 + i * 0x10 + 1;
+    }
+    mini->cpu.sp = (uintptr_t)test_sram_dtc + 1024;
+    mini->cpu.pc = 0x60004000 + n * 4;
+    snprintf(mini->task_name, sizeof(mini->task_name), "task%u", n);
+}
+
+// sequence of the record in each slot, -1 for none.
+static void slot_sequences(int64_t seqs[ASD_CD_SLOT_NUM])
+{
+    asd_crashdump_context_t context;
+
+    for (int slot = 0; slot < ASD_CD_SLOT_NUM; slot++) {
+        seqs[slot] = cd_slot_is_valid(&cd_config, slot, &context) ? (int64_t)context.sequence : -1;
+    }
+}
+
+// uptime of the record the frames are read from, -1 for none.
+static int64_t read_uptime(void)
+{
+    asd_crashdump_mini_t mini;
+
+    if (!asd_crashdump_is_available() ||
+        asd_crashdump_read_raw(ASD_CD_RAW_MINI, sizeof(mini), &mini) != sizeof(mini)) {
+        return -1;
+    }
+    return mini.uptime_sec;
+}
+
+static void slot_ring_checks(void)
+{
+    const char *name = "slot ring";
+    asd_crashdump_mini_t mini;
+    int64_t seqs[ASD_CD_SLOT_NUM];
+
+    // whatever the partition holds, init has to erase a slot for the first crash.
+    memset(s_partition, 0, sizeof(s_partition));
+    reboot();
+    CHECK(!asd_crashdump_is_available(), "record found in a zeroed partition");
+    CHECK(cd_config.write_slot == 0 && flash_data_is_all_FF(&cd_config, 0, ASD_CD_SLOT_SIZE),
+          "slot 0 not prepared");
+
+    for (uint32_t n = 0; n < TEST_SAVES; n++) {
+        make_crash(&mini, n);
+        asd_crashdump_save(&mini);
+        slot_sequences(seqs);
+        CHECK(seqs[n % ASD_CD_SLOT_NUM] == n, "crash %u not in slot %u", n, n % ASD_CD_SLOT_NUM);
+
+        reboot();
+        // one slot is kept erased for the next crash.
+        uint32_t kept = MIN(n + 1, (uint32_t)ASD_CD_SLOT_NUM - 1);
+        slot_sequences(seqs);
+        for (uint32_t slot = 0; slot < ASD_CD_SLOT_NUM; slot++) {
+            uint32_t age = (n - slot) % ASD_CD_SLOT_NUM;
+            int64_t expected = (age < kept) ? (int64_t)(n - age) : -1;
+            CHECK(seqs[slot] == expected, "after crash %u: slot %u holds %lld, %lld expected",
+                  n, slot, (long long)seqs[slot], (long long)expected);
+        }
+        uint32_t next = (n + 1) % ASD_CD_SLOT_NUM;
+        CHECK(cd_config.write_slot == next &&
+              flash_data_is_all_FF(&cd_config, CD_SLOT_BASE(next), ASD_CD_SLOT_SIZE),
+              "after crash %u: slot %u not prepared", n, next);
+        CHECK(cd_config.sequence == n + 1, "after crash %u: next sequence %u", n, cd_config.sequence);
+        CHECK(read_uptime() == n + 1 - kept, "after crash %u: crash %lld read first",
+              n, (long long)read_uptime());
+    }
+
+    // read and drop the records, oldest first.
+    for (uint32_t n = TEST_SAVES + 1 - ASD_CD_SLOT_NUM; n < TEST_SAVES; n++) {
+        CHECK(read_uptime() == n, "crash %lld read, %u expected", (long long)read_uptime(), n);
+        CHECK(asd_crashdump_mark_read() == 0, "crash %u not dropped", n);
+    }
+    CHECK(!asd_crashdump_is_available(), "record left after reading them all");
+
+    // two crashes without a reboot: the second one erases its slot in the crash path.
+    uint32_t slot = cd_config.write_slot;
+    make_crash(&mini, TEST_SAVES);
+    asd_crashdump_save(&mini);
+    make_crash(&mini, TEST_SAVES + 1);
+    asd_crashdump_save(&mini);
+    slot_sequences(seqs);
+    CHECK(seqs[slot] >= 0 && seqs[(slot + 1) % ASD_CD_SLOT_NUM] == seqs[slot] + 1,
+          "crashes saved without a reboot lost");
+    CHECK(read_uptime() == TEST_SAVES && asd_crashdump_mark_read() == 0 &&
+          read_uptime() == TEST_SAVES + 1, "crashes saved without a reboot read out of order");
+}
+
+static void interrupted_save_checks(void)
+{
+    const char *name = "interrupted save";
+    static uint8_t saved[LOG_CRASH_LOG_SIZE];
+    asd_crashdump_mini_t mini;
+    int64_t seqs[ASD_CD_SLOT_NUM];
+
+    // cut inside the packed stack too, not only in the fixed part of the record.
+    for (uint32_t i = 0; i < TEST_BANK_SIZE; i++) {
+        test_sram_dtc[i] = (i % 64 < 40) ? rand() : 0xA5;
+    }
+    asd_crashdump_erase();
+    reboot();
+    for (uint32_t n = 0; n < 2; n++) {
+        make_crash(&mini, n);
+        asd_crashdump_save(&mini);
+        reboot();
+    }
+    uint32_t slot = cd_config.write_slot;
+    memcpy(saved, s_partition, sizeof(saved));
+
+    // a complete save first, for its length.
+    make_crash(&mini, 2);
+    s_write_bytes = 0;
+    asd_crashdump_save(&mini);
+    uint32_t total = s_write_bytes;
+    CHECK(s_last_write == CD_SLOT_BASE(slot) + offsetof(asd_crashdump_map_t, header),
+          "the header is not written last");
+
+    s_quiet = 1;
+    for (uint32_t budget = 0; budget < total; budget++) {
+        memcpy(s_partition, saved, sizeof(s_partition));
+        reboot();
+        s_write_budget = budget;
+        asd_crashdump_save(&mini);
+
+        reboot();
+        slot_sequences(seqs);
+        CHECK(seqs[0] == 0 && seqs[1] == 1 && seqs[slot] < 0,
+              "cut after %u of %u bytes: slots hold %lld %lld %lld", budget, total,
+              (long long)seqs[0], (long long)seqs[1], (long long)seqs[slot]);
+        CHECK(cd_config.sequence == 2 && cd_config.write_slot == slot &&
+              flash_data_is_all_FF(&cd_config, CD_SLOT_BASE(slot), ASD_CD_SLOT_SIZE),
+              "cut after %u of %u bytes: slot %u not erased for the next crash", budget, total, slot);
+        CHECK(read_uptime() == 0, "cut after %u of %u bytes: crash %lld read first",
+              budget, total, (long long)read_uptime());
+    }
+    s_quiet = 0;
+
+    // the next crash takes the slot.
+    asd_crashdump_save(&mini);
+    reboot();
+    slot_sequences(seqs);
+    CHECK(seqs[slot] == 2, "crash lost after the interrupted saves");
+}
+
+typedef struct {
+    const char *name;
+    uint8_t reason;
+    uint32_t sp_offset;          ///< sp in the DTC bank.
+    uint32_t ram_offset;         ///< RAM window in the OCRAM bank.
+    uint32_t ram_len;            ///< 0 for no window.
+} fault_case_t;
+
+static const fault_case_t s_faults[] = {
+    { "hardfault", ASD_CD_REASON_EXCEPTION_HARDFAULT, 1024, 0, 0 },
+    // sp close to the end of the bank, less than ASD_CD_STACK_CAPTURE_SIZE is captured.
+    { "busfault_top", ASD_CD_REASON_EXCEPTION_BUSFAULT, TEST_BANK_SIZE - 200, 512, 1500 },
+    { "usagefault_ram", ASD_CD_REASON_EXCEPTION_USAGEFAULT, 2048, 0, ASD_CD_RAM_WINDOW_MAX },
+};
+
+/*
+ * Save a fault on a synthetic stack: the exception frame, then locals and
+ * saved registers with return addresses in between. Data words are even, so
+ * the return addresses are the only odd words the decoder lists.
+ */
+static void fault_report_case(const char *dir, const fault_case_t *fault)
+{
+    const char *name = fault->name;
+    static char report[16384];
+    char path[256];
+    asd_crashdump_mini_t mini = { 0 };
+    asd_crashdump_context_t context;
+    asd_frame_info_t frame, next;
+    uint32_t len = 0;
+
+    uint32_t *stack = (uint32_t *)(test_sram_dtc + fault->sp_offset);
+    uint32_t words = MIN(TEST_BANK_SIZE - fault->sp_offset, (uint32_t)ASD_CD_STACK_CAPTURE_SIZE) / 4;
+    for (uint32_t i = 0; i < words; i++) {
+        stack[i] = (i % 7 == 3) ? 0x60010000 + (rand() % 0x4000) * 2 + 1 : (rand() & ~1U);
+    }
+    for (uint32_t i = 0; i < TEST_BANK_SIZE; i++) {
+        test_sram_oc[i] = rand();
+    }
+
+    mini.reason = fault->reason;
+    mini.time = 1600000000;
+    mini.uptime_sec = 42;
+    snprintf(mini.task_name, sizeof(mini.task_name), "%.*s", (int)sizeof(mini.task_name) - 1, name);
+    unsigned int *reg = &mini.cpu.r0;
+    for (uint32_t i = 0; i <= 12; i++) {
+        reg[i] = 0x10000000 * (i % 8) + i;
+    }
+    mini.cpu.sp = (uintptr_t)stack;
+    mini.cpu.lr = 0x60012345;
+    mini.cpu.pc = 0x60023456;
+    mini.cpu.psr = 0x61000000;
+    mini.cpu.exc_return = 0xFFFFFFFD;
+    mini.cpu.cfsr = 0x00008200 | fault->reason;
+    mini.cpu.hfsr = 0x40000000;
+    mini.cpu.bfar = 0x2020DEAC;
+
+    asd_crashdump_erase();
+    reboot();
+    CHECK(asd_crashdump_set_ram_window(test_sram_oc + TEST_BANK_SIZE - 16, 32) == -AFW_EINVAL,
+          "RAM window past the end of the bank accepted");
+    CHECK(asd_crashdump_set_ram_window(fault->ram_len ? test_sram_oc + fault->ram_offset : NULL,
+                                       fault->ram_len) == 0, "RAM window refused");
+    asd_crashdump_save(&mini);
+
+    CHECK(asd_crashdump_read_raw(ASD_CD_RAW_CONTEXT, sizeof(context), &context) == sizeof(context),
+          "no record");
+    CHECK(context.stack_addr == mini.cpu.sp && context.stack_len == words * 4,
+          "stack at 0x%x, %u bytes captured", context.stack_addr, context.stack_len);
+    CHECK(context.ram_len == fault->ram_len, "%u bytes of RAM captured", context.ram_len);
+
+    // the report as the crash uploader reads it, in uneven pieces.
+    int32_t rc = asd_crashdump_get_first_frame(&frame);
+    while (rc == 0) {
+        for (uint32_t offset = 0; offset < frame.length;) {
+            int32_t n = asd_crashdump_read_frame(&frame, offset, report + len,
+                                                 MIN(97U, (uint32_t)sizeof(report) - len));
+            CHECK(n > 0, "frame %u: read at %u returned %d", frame.index, offset, n);
+            offset += n;
+            len += n;
+        }
+        rc = asd_crashdump_get_next_frame(&frame, &next);
+        frame = next;
+    }
+    CHECK(rc == -AFW_ENOSPC, "frames end with %d", rc);
+    CHECK(len == (uint32_t)asd_crashdump_get_total_frame_length(), "read %u of %d bytes",
+          len, asd_crashdump_get_total_frame_length());
+
+    write_file(dir, name, "report", report, len);
+    write_file(dir, name, "stack", stack, words * 4);
+    if (fault->ram_len) {
+        write_file(dir, name, "ram", test_sram_oc + fault->ram_offset, fault->ram_len);
+    }
+
+    // what the decoder has to find in the report.
+    snprintf(path, sizeof(path), "%s/%s.expect", dir, name);
+    FILE *f = fopen(path, "w");
+    CHECK(f, "cannot write %s", path);
+    fprintf(f, "reg pc 0x%08x\nreg lr 0x%08x\nreg sp 0x%08x\nreg psr 0x%08x\n",
+            mini.cpu.pc, mini.cpu.lr, mini.cpu.sp, mini.cpu.psr);
+    fprintf(f, "reg cfsr 0x%08x\nreg hfsr 0x%08x\nreg bfar 0x%08x\n",
+            mini.cpu.cfsr, mini.cpu.hfsr, mini.cpu.bfar);
+    fprintf(f, "stack 0x%08x %u\n", mini.cpu.sp, words * 4);
+    if (fault->ram_len) {
+        fprintf(f, "ram 0x%08x %u\n", (unsigned int)(uintptr_t)(test_sram_oc + fault->ram_offset),
+                fault->ram_len);
+    }
+    // frames point to the call, the instruction before the return address.
+    fprintf(f, "frame pc 0x%08x\nframe lr 0x%08x\n", mini.cpu.pc, mini.cpu.lr - 1 - 2);
+    for (uint32_t i = 0; i < words; i++) {
+        if (stack[i] & 1) {
+            fprintf(f, "frame sp+0x%03x 0x%08x\n", i * 4, stack[i] - 1 - 2);
+        }
+    }
+    fclose(f);
+    asd_crashdump_set_ram_window(NULL, 0);
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t buf[TEST_MAX_INPUT];
+    char name[64];
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s OUTPUT_DIR\n", argv[0]);
+        return 2;
+    }
+    const char *dir = argv[1];
+    int cases = 0;
+
+    srand(43);
+
+    // every length around the block format limits, on a short period.
+    for (uint32_t len = 0; len <= 40; len++) {
+        for (uint32_t i = 0; i < len; i++) {
+            buf[i] = "abcab"[i % 5];
+        }
+        snprintf(name, sizeof(name), "period_%u", len);
+        pack_case(dir, name, buf, len, 0);
+        cases++;
+    }
+
+    // zeroed RAM, long match and literal length extensions.
+    memset(buf, 0, sizeof(buf));
+    pack_case(dir, "zeros", buf, sizeof(buf), 64);
+    cases++;
+
+    for (uint32_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = rand();
+    }
+    pack_case(dir, "noise", buf, sizeof(buf), 0);
+    pack_case(dir, "noise_270", buf, 270, 3);
+    pack_case(dir, "noise_15", buf, 15, 0);
+    cases += 3;
+
+    // a stack: a few return addresses and saved registers, repeated frames,
+    // unused words filled with the FreeRTOS stack fill byte.
+    uint32_t *words = (uint32_t *)buf;
+    for (uint32_t i = 0; i < sizeof(buf) / 4; i++) {
+        if (i < 256) {
+            words[i] = 0xA5A5A5A5;
+        } else if (i % 8 == 7) {
+            words[i] = 0x60010000 + (rand() % 16) * 0x40 + 1;
+        } else if (i % 8 < 3) {
+            words[i] = 0x20200000 + (rand() % 64) * 4;
+        } else {
+            words[i] = rand() % 4 ? (uint32_t)rand() : 0;
+        }
+    }
+    pack_case(dir, "stack", buf, sizeof(buf), 100);
+    cases++;
+
+    // matches reaching back across the scratch pad flushes.
+    for (uint32_t i = 0; i < sizeof(buf); i++) {
+        buf[i] = (i % 1000 < 500) ? rand() : buf[i - 500];
+    }
+    pack_case(dir, "far_matches", buf, sizeof(buf), 0);
+    cases++;
+
+    slot_ring_checks();
+    interrupted_save_checks();
+    for (uint32_t i = 0; i < sizeof(s_faults) / sizeof(s_faults[0]); i++) {
+        fault_report_case(dir, &s_faults[i]);
+    }
+
+    if (s_failures) {
+        printf("crashdump: %d checks FAILED\n", s_failures);
+        return 1;
+    }
+    printf("crashdump: packed %d cases, %d crashes through %d slots, %d fault reports\n",
+           cases, TEST_SAVES + 2, ASD_CD_SLOT_NUM, (int)(sizeof(s_faults) / sizeof(s_faults[0])));
+    return 0;
+}
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for flash_map.h, only the crash log partition.
+ */
+
+#ifndef FLASH_MAP_H
+#define FLASH_MAP_H
+
+#define FLASH_PARTITION_LOG_CRASH "flashlogcrash"
+#define LOG_CRASH_LOG_SIZE        0x4000
+
+#endif /* FLASH_MAP_H */
@@ -0,0 +1,3 @@
+/*
+ * Host stand-in for task.h, asd_crashdump.c needs nothing from it on the host.
+ */
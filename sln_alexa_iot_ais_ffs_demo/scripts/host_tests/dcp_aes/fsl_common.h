@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for fsl_common.h, only what the ksdk mbedTLS port needs with
+ * the DCP enabled.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+
+enum
+{
+    kStatus_Success         = 0,
+    kStatus_Fail            = 1,
+    kStatus_InvalidArgument = 4,
+};
+
+#define FSL_FEATURE_SOC_DCP_COUNT 1
+
+#endif /* _FSL_COMMON_H_ */
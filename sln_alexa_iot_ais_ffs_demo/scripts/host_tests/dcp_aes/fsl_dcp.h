@@ -0,0 +1,98 @@
+/*
+ * Host stand-in for the DCP driver: same API as drivers/fsl_dcp.h for the AES
+ * calls the mbedTLS port makes, backed by a software AES-128 in
+ * dcp_aes_test.c. Hashing is not modelled, keep the DCP SHA options off.
+ */
+
+#ifndef _FSL_DCP_H_
+#define _FSL_DCP_H_
+
+#include "fsl_common.h"
+
+enum
+{
+    kStatus_DCP_Again = MAKE_STATUS(67, 0),
+};
+
+typedef struct
+{
+    int unused;
+} DCP_Type;
+
+extern DCP_Type g_hostDcp;
+#define DCP (&g_hostDcp)
+
+typedef enum _dcp_channel
+{
+    kDCP_Channel0 = 1u << 16,
+} dcp_channel_t;
+
+typedef enum _dcp_key_slot
+{
+    kDCP_KeySlot0 = 0u,
+    kDCP_OtpKey   = 4u,
+} dcp_key_slot_t;
+
+typedef enum _dcp_swap
+{
+    kDCP_NoSwap = 0x0u,
+} dcp_swap_t;
+
+typedef struct _dcp_handle
+{
+    dcp_channel_t channel;
+    dcp_key_slot_t keySlot;
+    uint32_t swapConfig;
+    uint32_t keyWord[4];
+    uint32_t iv[4];
+} dcp_handle_t;
+
+typedef struct _dcp_work_packet
+{
+    uint32_t nextCmdAddress;
+    uint32_t control0;
+    uint32_t control1;
+    uint32_t sourceBufferAddress;
+    uint32_t destinationBufferAddress;
+    uint32_t bufferSize;
+    uint32_t payloadPointer;
+    uint32_t status;
+} dcp_work_packet_t;
+
+typedef struct _dcp_config
+{
+    bool gatherResidualWrites;
+    bool enableContextCaching;
+    bool enableContextSwitching;
+    uint8_t enableChannel;
+    uint8_t enableChannelInterrupt;
+} dcp_config_t;
+
+void DCP_Init(DCP_Type *base, const dcp_config_t *config);
+void DCP_GetDefaultConfig(dcp_config_t *config);
+status_t DCP_WaitForChannelComplete(DCP_Type *base, dcp_handle_t *handle);
+status_t DCP_AES_SetKey(DCP_Type *base, dcp_handle_t *handle, const uint8_t *key, size_t keySize);
+status_t DCP_AES_EncryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *plaintext, uint8_t *ciphertext, size_t size);
+status_t DCP_AES_DecryptEcb(
+    DCP_Type *base, dcp_handle_t *handle, const uint8_t *ciphertext, uint8_t *plaintext, size_t size);
+status_t DCP_AES_EncryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *plaintext,
+                            uint8_t *ciphertext,
+                            size_t size,
+                            const uint8_t iv[16]);
+status_t DCP_AES_DecryptCbc(DCP_Type *base,
+                            dcp_handle_t *handle,
+                            const uint8_t *ciphertext,
+                            uint8_t *plaintext,
+                            size_t size,
+                            const uint8_t iv[16]);
+status_t DCP_AES_EncryptEcbNonBlocking(DCP_Type *base,
+                                       dcp_handle_t *handle,
+                                       dcp_work_packet_t *dcpPacket,
+                                       const uint8_t *plaintext,
+                                       uint8_t *ciphertext,
+                                       size_t size);
+
+#endif /* _FSL_DCP_H_ */
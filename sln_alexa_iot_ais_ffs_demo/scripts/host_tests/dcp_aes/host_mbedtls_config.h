@@ -0,0 +1,37 @@
+/*
+ * mbedTLS configuration of the DCP AES host check: the AES / GCM part of
+ * config_files/aws_mbedtls_config.h, DCP hashing left out.
+ */
+
+#ifndef HOST_MBEDTLS_CONFIG_H
+#define HOST_MBEDTLS_CONFIG_H
+
+#include "fsl_common.h"
+
+#define MBEDTLS_FREESCALE_DCP_AES
+#define MBEDTLS_FREESCALE_DCP_AES_GCM
+
+/* Same as the target configuration, but for MBEDTLS_AES_ALT_NO_192 / NO_256:
+ * with the DCP they only skip the self test vectors of those key sizes, which
+ * run in the software rounds of aes_alt.c. */
+#define MBEDTLS_AES_ALT
+#define MBEDTLS_AES_SETKEY_ENC_ALT
+#define MBEDTLS_AES_SETKEY_DEC_ALT
+#define MBEDTLS_AES_ENCRYPT_ALT
+#define MBEDTLS_AES_DECRYPT_ALT
+#define MBEDTLS_AES_CRYPT_CBC_ALT
+#define MBEDTLS_GCM_ALT
+
+#define MBEDTLS_AES_ROM_TABLES
+#define MBEDTLS_CIPHER_MODE_CBC
+#define MBEDTLS_CIPHER_MODE_CFB
+#define MBEDTLS_CIPHER_MODE_CTR
+
+#define MBEDTLS_AES_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_GCM_C
+#define MBEDTLS_SELF_TEST
+
+#include "mbedtls/check_config.h"
+
+#endif /* HOST_MBEDTLS_CONFIG_H */
@@ -0,0 +1,522 @@
+/*
+ * Host check of the lease table of dhcp_server.c.
+ *
+ * lwIP runs on the simulated scheduler of fake_sai/, the AP interface is the
+ * fake one of fake_net/, set up as TCPIP_MANAGER_start_ap_interface() does.
+ * The test plays the clients: it passes their broadcasts to the interface and
+ * reads back the replies the server sends, then checks the lease table. The
+ * check goes through:
+ *  - DISCOVER, REQUEST: the first pool address is offered, then bound;
+ *  - a REQUEST for the address of another client: NAK;
+ *  - a REQUEST for the offer of another server: the offer is dropped;
+ *  - RELEASE: the address is free, and given back to the same client;
+ *  - options overloaded in the 'file' and 'sname' fields, and not announced
+ *    by option 52;
+ *  - the pool exhausted: no OFFER, until an address is released or an offer
+ *    runs out;
+ *  - DECLINE: the address is kept out of the pool for a while;
+ *  - truncated and malformed messages: no reply, the server keeps going;
+ *  - the server stopped and started again: the leases are kept.
+ *
+ * Build and run with "make -C scripts/host_tests dhcp_server".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/def.h"
+#include "lwip/etharp.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/netif.h"
+#include "lwip/prot/dhcp.h"
+#include "lwip/prot/iana.h"
+#include "lwip/tcpip.h"
+
+#include "dhcp_server.h"
+#include "fake_net.h"
+#include "sim_rtos.h"
+#include "wwd_network.h"
+
+/* The AP network of tcpip_manager.c */
+#define TEST_SERVER_IP PP_HTONL(LWIP_MAKEU32(192, 168, 1, 1))
+#define TEST_OTHER_IP  PP_HTONL(LWIP_MAKEU32(192, 168, 1, 2))
+#define TEST_NETMASK   PP_HTONL(LWIP_MAKEU32(255, 255, 0, 0))
+#define TEST_POOL_IP(n) PP_HTONL(LWIP_MAKEU32(192, 168, 1, 100 + (n)))
+
+/* WWD_AP_INTERFACE, the fake interface takes the MAC address 02:00:00:00:00:02 */
+#define TEST_AP_INTERFACE 1
+
+/* Fields of the BOOTP header lwIP has no offset for */
+#define TEST_CIADDR_OFS 12
+#define TEST_YIADDR_OFS 16
+#define TEST_CHADDR_OFS 28
+
+/* Time given to the server to answer, it waits at most 500 ms on its socket */
+#define TEST_ANSWER_MS 20
+#define TEST_QUIT_MS   1000
+
+#define TEST_OFFER_HOLD_MS   (30 * 1000)
+#define TEST_DECLINE_HOLD_MS (600 * 1000)
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("dhcp server: ");        \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+/* Where a client puts its options */
+typedef enum
+{
+    kTestOptionsArea, /* All in the options area */
+    kTestOverload,    /* Type and server identifier in 'file', requested address in 'sname' */
+    kTestNoOverload,  /* As kTestOverload, without option 52 */
+} test_layout_t;
+
+/* Last reply of the server */
+typedef struct
+{
+    uint32_t count;
+    uint8_t type;
+    uint32_t yiaddr;
+    uint8_t client;
+} test_reply_t;
+
+static struct netif s_ap;
+static test_reply_t s_reply;
+static uint32_t s_exchanges;
+
+static const uint8_t s_broadcast[ETH_HWADDR_LEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+static void client_mac(uint8_t client, uint8_t *mac)
+{
+    static const uint8_t base[ETH_HWADDR_LEN] = {0x02, 0xc0, 0, 0, 0, 0};
+
+    memcpy(mac, base, ETH_HWADDR_LEN);
+    mac[5] = client;
+}
+
+/* Returns the data of a DHCP option of the options area, NULL when the message has none */
+static const uint8_t *dhcp_option(const uint8_t *msg, uint16_t len, uint8_t code)
+{
+    uint16_t ofs = DHCP_OPTIONS_OFS;
+
+    while ((ofs + 1 < len) && (msg[ofs] != DHCP_OPTION_END))
+    {
+        if (msg[ofs] == DHCP_OPTION_PAD)
+        {
+            ofs++;
+            continue;
+        }
+        if (ofs + 2 + msg[ofs + 1] > len)
+        {
+            FAIL("option %u past the end of the reply", msg[ofs]);
+        }
+        if (msg[ofs] == code)
+        {
+            return &msg[ofs + 2];
+        }
+        ofs += 2 + msg[ofs + 1];
+    }
+
+    return NULL;
+}
+
+static uint32_t dhcp_option_ip(const uint8_t *option)
+{
+    uint32_t ip;
+
+    memcpy(&ip, option, sizeof(ip));
+    return ip;
+}
+
+/* Replies are broadcast to the client port */
+static void clients_tx_hook(struct netif *netif, const uint8_t *frame, uint16_t len)
+{
+    const uint8_t *msg;
+    const uint8_t *type;
+    const uint8_t *serverId;
+    uint16_t msgLen;
+    uint8_t mac[ETH_HWADDR_LEN];
+
+    msg = fake_net_udp_payload(frame, len, LWIP_IANA_PORT_DHCP_CLIENT, &msgLen);
+    if (msg == NULL)
+    {
+        return;
+    }
+    if (0 != memcmp(frame, s_broadcast, ETH_HWADDR_LEN))
+    {
+        FAIL("reply not broadcast");
+    }
+    if ((msgLen <= DHCP_OPTIONS_OFS) || (msg[0] != DHCP_BOOTREPLY))
+    {
+        FAIL("reply of %u bytes, op %u", msgLen, msg[0]);
+    }
+
+    type     = dhcp_option(msg, msgLen, DHCP_OPTION_MESSAGE_TYPE);
+    serverId = dhcp_option(msg, msgLen, DHCP_OPTION_SERVER_ID);
+    if ((type == NULL) || (serverId == NULL) || (dhcp_option_ip(serverId) != TEST_SERVER_IP))
+    {
+        FAIL("reply without a type or server identifier");
+    }
+    if ((*type != DHCP_NAK) && ((dhcp_option(msg, msgLen, DHCP_OPTION_LEASE_TIME) == NULL) ||
+                                (dhcp_option(msg, msgLen, DHCP_OPTION_SUBNET_MASK) == NULL) ||
+                                (dhcp_option(msg, msgLen, DHCP_OPTION_ROUTER) == NULL)))
+    {
+        FAIL("reply %u without a lease time, netmask or router", *type);
+    }
+
+    client_mac(0, mac);
+    if (0 != memcmp(&msg[TEST_CHADDR_OFS], mac, ETH_HWADDR_LEN - 1))
+    {
+        FAIL("reply to an unknown client");
+    }
+
+    s_reply.count++;
+    s_reply.type   = *type;
+    s_reply.client = msg[TEST_CHADDR_OFS + ETH_HWADDR_LEN - 1];
+    memcpy(&s_reply.yiaddr, &msg[TEST_YIADDR_OFS], 4);
+}
+
+static uint8_t *put_option(uint8_t *opt, uint8_t code, const void *data, uint8_t len)
+{
+    *opt++ = code;
+    *opt++ = len;
+    memcpy(opt, data, len);
+
+    return opt + len;
+}
+
+/* Passes the message of client to the server, returns true when it answered */
+static bool client_send(uint8_t client, const uint8_t *msg, uint16_t len)
+{
+    uint8_t frame[SIZEOF_ETH_HDR + 28 + sizeof(struct dhcp_msg)];
+    uint8_t mac[ETH_HWADDR_LEN];
+    uint32_t before = s_reply.count;
+
+    client_mac(client, mac);
+    len = fake_net_udp_frame(frame, s_broadcast, mac, IPADDR_ANY, IPADDR_BROADCAST, LWIP_IANA_PORT_DHCP_CLIENT,
+                             LWIP_IANA_PORT_DHCP_SERVER, msg, len);
+    if (!fake_net_input(&s_ap, frame, len))
+    {
+        FAIL("client %u: message dropped", client);
+    }
+    sim_run(TEST_ANSWER_MS);
+    s_exchanges++;
+
+    if (s_reply.count > before + 1)
+    {
+        FAIL("client %u: %u replies", client, s_reply.count - before);
+    }
+    if ((s_reply.count != before) && (s_reply.client != client))
+    {
+        FAIL("client %u: reply to client %u", client, s_reply.client);
+    }
+
+    return s_reply.count != before;
+}
+
+/* Sends a DHCP message, requested and serverId are left out when 0 */
+static bool client_dhcp(uint8_t client, uint8_t type, uint32_t ciaddr, uint32_t requested, uint32_t serverId,
+                        test_layout_t layout)
+{
+    uint8_t msg[sizeof(struct dhcp_msg)] = {0};
+    uint8_t *opt                         = &msg[DHCP_OPTIONS_OFS];
+    uint8_t *typeArea                    = opt;
+    uint8_t *requestedArea               = opt;
+    const uint8_t cookie[]               = {0x63, 0x82, 0x53, 0x63};
+    uint8_t overload                     = 3; /* 'file' and 'sname' */
+
+    msg[0] = DHCP_BOOTREQUEST;
+    msg[1] = LWIP_IANA_HWTYPE_ETHERNET;
+    msg[2] = ETH_HWADDR_LEN;
+    msg[4] = client;
+    memcpy(&msg[TEST_CIADDR_OFS], &ciaddr, 4);
+    client_mac(client, &msg[TEST_CHADDR_OFS]);
+    memcpy(&msg[DHCP_MSG_LEN], cookie, sizeof(cookie));
+
+    if (layout != kTestOptionsArea)
+    {
+        if (layout == kTestOverload)
+        {
+            opt = put_option(opt, DHCP_OPTION_OVERLOAD, &overload, 1);
+        }
+        *opt++        = DHCP_OPTION_END;
+        typeArea      = &msg[DHCP_FILE_OFS];
+        requestedArea = &msg[DHCP_SNAME_OFS];
+    }
+
+    typeArea = put_option(typeArea, DHCP_OPTION_MESSAGE_TYPE, &type, 1);
+    if (serverId != 0)
+    {
+        typeArea = put_option(typeArea, DHCP_OPTION_SERVER_ID, &serverId, 4);
+    }
+    if (layout == kTestOptionsArea)
+    {
+        requestedArea = typeArea;
+    }
+    if (requested != 0)
+    {
+        requestedArea = put_option(requestedArea, DHCP_OPTION_REQUESTED_IP, &requested, 4);
+    }
+
+    if (layout == kTestOptionsArea)
+    {
+        *requestedArea++ = DHCP_OPTION_END;
+        opt              = requestedArea;
+    }
+    else
+    {
+        *typeArea      = DHCP_OPTION_END;
+        *requestedArea = DHCP_OPTION_END;
+    }
+
+    return client_send(client, msg, (uint16_t)(opt - msg));
+}
+
+/* DISCOVER, expects an OFFER of ip, or no answer when ip is 0 */
+static void discover(uint8_t client, uint32_t requested, uint32_t ip, const char *what)
+{
+    bool answered = client_dhcp(client, DHCP_DISCOVER, 0, requested, 0, kTestOptionsArea);
+
+    if ((ip == 0) && answered)
+    {
+        FAIL("%s: client %u offered %s", what, client, ip4addr_ntoa((const ip4_addr_t *)&s_reply.yiaddr));
+    }
+    if ((ip != 0) && (!answered || (s_reply.type != DHCP_OFFER) || (s_reply.yiaddr != ip)))
+    {
+        FAIL("%s: client %u got %s %s", what, client, answered ? "a reply" : "no reply",
+             answered ? ip4addr_ntoa((const ip4_addr_t *)&s_reply.yiaddr) : "");
+    }
+}
+
+/* REQUEST of ip, expects type back */
+static void request(uint8_t client, uint32_t ip, uint32_t serverId, uint8_t type, const char *what)
+{
+    if (!client_dhcp(client, DHCP_REQUEST, 0, ip, serverId, kTestOptionsArea) || (s_reply.type != type))
+    {
+        FAIL("%s: client %u REQUEST answered with %u, %u expected", what, client, s_reply.type, type);
+    }
+    if ((type == DHCP_ACK) && (s_reply.yiaddr != ip))
+    {
+        FAIL("%s: client %u ACKed with %s", what, client, ip4addr_ntoa((const ip4_addr_t *)&s_reply.yiaddr));
+    }
+}
+
+static void release(uint8_t client, uint32_t ip)
+{
+    if (client_dhcp(client, DHCP_RELEASE, ip, 0, TEST_SERVER_IP, kTestOptionsArea))
+    {
+        FAIL("client %u: RELEASE answered", client);
+    }
+}
+
+/* Checks the lease of pool address n */
+static void expect_lease(uint32_t n, uint8_t state, uint8_t client, const char *what)
+{
+    dhcp_server_lease_t leases[DHCP_SERVER_MAX_LEASES];
+    uint8_t mac[ETH_HWADDR_LEN];
+    uint32_t ip = TEST_POOL_IP(n);
+
+    if (dhcp_server_get_leases(leases, DHCP_SERVER_MAX_LEASES) != DHCP_SERVER_MAX_LEASES)
+    {
+        FAIL("%s: lease table not read", what);
+    }
+    client_mac(client, mac);
+    if ((0 != memcmp(leases[n].ip_addr, &ip, 4)) || (leases[n].state != state) ||
+        ((client != 0) && (0 != memcmp(leases[n].mac, mac, ETH_HWADDR_LEN))))
+    {
+        FAIL("%s: lease %u in state %u for client %u, state %u for client %u expected", what, n, leases[n].state,
+             leases[n].mac[ETH_HWADDR_LEN - 1], state, client);
+    }
+}
+
+static void malformed(void)
+{
+    uint8_t msg[sizeof(struct dhcp_msg)] = {0};
+    const uint8_t cookie[]               = {0x63, 0x82, 0x53, 0x63};
+    uint8_t *opt                         = &msg[DHCP_OPTIONS_OFS];
+    uint8_t type                         = DHCP_DISCOVER;
+
+    msg[0] = DHCP_BOOTREQUEST;
+    msg[1] = LWIP_IANA_HWTYPE_ETHERNET;
+    msg[2] = ETH_HWADDR_LEN;
+    client_mac(20, &msg[TEST_CHADDR_OFS]);
+    memcpy(&msg[DHCP_MSG_LEN], cookie, sizeof(cookie));
+    put_option(opt, DHCP_OPTION_MESSAGE_TYPE, &type, 1);
+
+    /* Cut before the options, then in the middle of the type option */
+    if (client_send(20, msg, DHCP_OPTIONS_OFS) || client_send(20, msg, DHCP_OPTIONS_OFS + 2) ||
+        client_send(20, msg, 100))
+    {
+        FAIL("truncated DISCOVER answered");
+    }
+
+    /* Option length past the end of the message */
+    opt[1] = 200;
+    if (client_send(20, msg, DHCP_OPTIONS_OFS + 3))
+    {
+        FAIL("DISCOVER with an option past the end answered");
+    }
+    opt[1] = 1;
+
+    /* Overloaded 'file' field without an end, its last option running into the cookie */
+    opt[0] = DHCP_OPTION_OVERLOAD;
+    opt[1] = 1;
+    opt[2] = 1;
+    opt[3] = DHCP_OPTION_END;
+    msg[DHCP_FILE_OFS + DHCP_FILE_LEN - 2] = DHCP_OPTION_MESSAGE_TYPE;
+    msg[DHCP_FILE_OFS + DHCP_FILE_LEN - 1] = 1;
+    if (client_send(20, msg, sizeof(msg)))
+    {
+        FAIL("DISCOVER with the type past the 'file' field answered");
+    }
+    memset(&msg[DHCP_FILE_OFS], 0, DHCP_FILE_LEN);
+    put_option(opt, DHCP_OPTION_MESSAGE_TYPE, &type, 1);
+
+    /* Not a request, not Ethernet, no cookie */
+    msg[0] = DHCP_BOOTREPLY;
+    if (client_send(20, msg, sizeof(msg)))
+    {
+        FAIL("BOOTREPLY answered");
+    }
+    msg[0] = DHCP_BOOTREQUEST;
+    msg[2] = 16;
+    if (client_send(20, msg, sizeof(msg)))
+    {
+        FAIL("DISCOVER with a 16 byte hardware address answered");
+    }
+    msg[2] = ETH_HWADDR_LEN;
+    msg[DHCP_MSG_LEN] = 0;
+    if (client_send(20, msg, sizeof(msg)))
+    {
+        FAIL("DISCOVER without the magic cookie answered");
+    }
+}
+
+int main(void)
+{
+    ip4_addr_t ipaddr  = {TEST_SERVER_IP};
+    ip4_addr_t netmask = {TEST_NETMASK};
+    uint32_t served    = 0;
+    const uint8_t fillOrder[DHCP_SERVER_MAX_LEASES - 2] = {2, 3, 4, 6, 7, 1};
+
+    fake_net_set_tx_hook(clients_tx_hook);
+
+    tcpip_init(NULL, NULL);
+    sim_run(TEST_ANSWER_MS);
+    if (NULL == netif_add(&s_ap, &ipaddr, &netmask, &ipaddr, (void *)TEST_AP_INTERFACE, wlanif_init, tcpip_input))
+    {
+        FAIL("netif_add");
+    }
+    netif_set_default(&s_ap);
+    netif_set_up(&s_ap);
+    start_dhcp_server(ipaddr.addr);
+    sim_run(TEST_ANSWER_MS);
+
+    /* First client */
+    discover(1, 0, TEST_POOL_IP(0), "first DISCOVER");
+    expect_lease(0, DHCP_LEASE_OFFERED, 1, "first OFFER");
+    request(1, TEST_POOL_IP(0), TEST_SERVER_IP, DHCP_ACK, "first REQUEST");
+    expect_lease(0, DHCP_LEASE_BOUND, 1, "first ACK");
+
+    /* The address of another client, asked back after a reboot */
+    request(2, TEST_POOL_IP(0), 0, DHCP_NAK, "address of another client");
+    expect_lease(0, DHCP_LEASE_BOUND, 1, "address of another client");
+
+    /* The client takes the offer of another server */
+    discover(2, 0, TEST_POOL_IP(1), "second client");
+    if (client_dhcp(2, DHCP_REQUEST, 0, TEST_POOL_IP(1), TEST_OTHER_IP, kTestOptionsArea))
+    {
+        FAIL("REQUEST to another server answered");
+    }
+    expect_lease(1, DHCP_LEASE_FREE, 0, "offer of another server taken");
+
+    /* RELEASE, the same address is given back */
+    release(2, TEST_POOL_IP(0));
+    expect_lease(0, DHCP_LEASE_BOUND, 1, "RELEASE of another client");
+    release(1, TEST_POOL_IP(0));
+    expect_lease(0, DHCP_LEASE_FREE, 1, "RELEASE");
+    discover(1, 0, TEST_POOL_IP(0), "DISCOVER after RELEASE");
+    request(1, TEST_POOL_IP(0), TEST_SERVER_IP, DHCP_ACK, "REQUEST after RELEASE");
+
+    /* With addresses left in the pool, so an answer would be an OFFER */
+    malformed();
+    discover(1, 0, TEST_POOL_IP(0), "after the malformed messages");
+
+    /* Options in 'file' and 'sname' */
+    if (client_dhcp(3, DHCP_DISCOVER, 0, TEST_POOL_IP(5), 0, kTestNoOverload))
+    {
+        FAIL("options in 'file' read without option 52");
+    }
+    if (!client_dhcp(3, DHCP_DISCOVER, 0, TEST_POOL_IP(5), 0, kTestOverload) || (s_reply.type != DHCP_OFFER) ||
+        (s_reply.yiaddr != TEST_POOL_IP(5)))
+    {
+        FAIL("overloaded DISCOVER: requested address not offered");
+    }
+    if (!client_dhcp(3, DHCP_REQUEST, 0, TEST_POOL_IP(5), TEST_SERVER_IP, kTestOverload) ||
+        (s_reply.type != DHCP_ACK) || (s_reply.yiaddr != TEST_POOL_IP(5)))
+    {
+        FAIL("overloaded REQUEST not ACKed");
+    }
+    expect_lease(5, DHCP_LEASE_BOUND, 3, "overloaded REQUEST");
+
+    /* The rest of the pool, the addresses never used first, then the one freed the longest ago */
+    for (uint8_t client = 4; client < 4 + sizeof(fillOrder); client++)
+    {
+        uint32_t n = fillOrder[client - 4];
+
+        discover(client, 0, TEST_POOL_IP(n), "filling the pool");
+        request(client, TEST_POOL_IP(n), TEST_SERVER_IP, DHCP_ACK, "filling the pool");
+        expect_lease(n, DHCP_LEASE_BOUND, client, "filling the pool");
+    }
+
+    /* Exhausted */
+    discover(10, 0, 0, "pool exhausted");
+    discover(10, TEST_POOL_IP(0), 0, "pool exhausted, leased address asked for");
+    request(10, TEST_POOL_IP(2), 0, DHCP_NAK, "pool exhausted, leased address asked back");
+
+    /* An address released goes to the next client, and is held for its offer */
+    release(1, TEST_POOL_IP(0));
+    discover(10, 0, TEST_POOL_IP(0), "address released");
+    discover(11, 0, 0, "address offered to another client");
+    sim_run(TEST_OFFER_HOLD_MS);
+    discover(11, 0, TEST_POOL_IP(0), "offer ran out");
+    request(10, TEST_POOL_IP(0), TEST_SERVER_IP, DHCP_NAK, "REQUEST after the offer ran out");
+    request(11, TEST_POOL_IP(0), TEST_SERVER_IP, DHCP_ACK, "offer taken");
+
+    /* The address is in use on the network */
+    if (client_dhcp(11, DHCP_DECLINE, 0, TEST_POOL_IP(0), TEST_SERVER_IP, kTestOptionsArea))
+    {
+        FAIL("DECLINE answered");
+    }
+    expect_lease(0, DHCP_LEASE_DECLINED, 0, "DECLINE");
+    discover(11, 0, 0, "declined address");
+    sim_run(TEST_DECLINE_HOLD_MS);
+    discover(12, 0, TEST_POOL_IP(0), "decline ran out");
+
+    /* Stopped and started again with the AP */
+    quit_dhcp_server();
+    sim_run(TEST_QUIT_MS);
+    discover(4, 0, 0, "server stopped");
+    start_dhcp_server(ipaddr.addr);
+    sim_run(TEST_ANSWER_MS);
+    discover(4, 0, TEST_POOL_IP(2), "server started again");
+    expect_lease(2, DHCP_LEASE_BOUND, 4, "server started again");
+
+    for (uint32_t n = 0; n < DHCP_SERVER_MAX_LEASES; n++)
+    {
+        dhcp_server_lease_t leases[DHCP_SERVER_MAX_LEASES];
+
+        dhcp_server_get_leases(leases, DHCP_SERVER_MAX_LEASES);
+        served += (leases[n].state != DHCP_LEASE_FREE);
+    }
+
+    printf("dhcp server: %u messages, %u replies, %u of %u addresses in use at the end\n", s_exchanges,
+           s_reply.count, served, DHCP_SERVER_MAX_LEASES);
+
+    return 0;
+}
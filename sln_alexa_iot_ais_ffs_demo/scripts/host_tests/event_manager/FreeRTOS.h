@@ -0,0 +1,30 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build afw_event_manager.c on
+ * the POSIX threads of pthread_rtos.c. A tick is a millisecond.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portBASE_TYPE      long
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+#define pdPASS  ( pdTRUE )
+#define pdFAIL  ( pdFALSE )
+
+#define portMAX_DELAY      ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS ( ( TickType_t ) 1 )
+#define pdMS_TO_TICKS(ms)  ( ( TickType_t ) ( ms ) )
+
+#define __CLZ(x)           ( ( x ) ? __builtin_clz( x ) : 32 )
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for ace/aceCli.h, the CLI tables of afw_event_manager.c are
+ * built but never run.
+ */
+
+#ifndef ACE_CLI_H
+#define ACE_CLI_H
+
+#include <stdint.h>
+
+typedef int32_t ace_status_t;
+
+#define ACE_STATUS_OK 0
+
+typedef struct aceCli_moduleCmd {
+    const char *commandMsg;
+    const char *help;
+    uint8_t flags;
+    union {
+        ace_status_t (*func)(int32_t len, const char *param[]);
+        const struct aceCli_moduleCmd *subCommands;
+    } command;
+} aceCli_moduleCmd_t;
+
+#define ACE_CLI_SET_LEAF    1
+#define ACE_CLI_SET_FUNC    0
+#define ACE_CLI_NULL_MODULE { 0 }
+
+#endif /* ACE_CLI_H */
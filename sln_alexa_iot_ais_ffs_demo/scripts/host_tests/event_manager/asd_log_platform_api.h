@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for asd_log_platform_api.h. The errors are counted, the test
+ * checks that every drop was logged.
+ */
+
+#ifndef ASD_LOG_PLATFORM_API_H
+#define ASD_LOG_PLATFORM_API_H
+
+void event_manager_log_error(const char *fmt, ...);
+
+#define ASD_LOG_E(module, ...) event_manager_log_error(__VA_ARGS__)
+
+#endif /* ASD_LOG_PLATFORM_API_H */
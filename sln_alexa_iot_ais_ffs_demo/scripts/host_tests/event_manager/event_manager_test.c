@@ -0,0 +1,329 @@
+/*
+ * Host check of the publish and subscribe paths of afw_event_manager.c, with
+ * many publishers and subscribers on POSIX threads.
+ *
+ * afw_event_manager.c is included, built against the stub headers in this
+ * directory: queues, mutexes and critical sections are the pthread ones of
+ * pthread_rtos.c, a tick is a millisecond.
+ *
+ * Task publishers publish data events in envelopes, with their number and a
+ * sequence number, and now and then a static event. An ISR publisher publishes
+ * to a queue of its own without waiting. Three subscribers read the data: one
+ * as fast as it can, one slowly, one waiting with afw_wait_for_event() for the
+ * end event and dropping the rest. Then a queue nobody reads is deinitialized
+ * with envelopes in it.
+ *
+ *  - each subscriber sees the events of each publisher in order and intact,
+ *    and the events of the task publishers in the same order as the others;
+ *  - a slow subscriber makes the publishers wait rather than drop events;
+ *  - every event is received or counted as a drop, every drop of a task
+ *    publisher is logged and fails its publish;
+ *  - no envelope is left once all the events are handed back.
+ *
+ * Build and run with "make -C scripts/host_tests event_manager".
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "afw_event_manager.c"
+
+#define TEST_PUBLISHERS     4
+#define TEST_EVENTS         5000
+#define TEST_STATIC_EVERY   10
+#define TEST_ISR_EVENTS     3000
+#define TEST_SUBSCRIBERS    3
+#define TEST_TIMEOUT_S      120
+
+#define EV_DATA             AFW_EVENT_TEST
+#define EV_STATIC           AFW_EVENT_LED_OFF
+#define EV_ISR              AFW_EVENT_BUTTON_0_DOWN
+#define EV_END              AFW_EVENT_LED_BLINK
+
+#define TOKEN(pub, seq)     ((uint32_t)(pub) * TEST_EVENTS + (seq))
+#define TOKENS              (TEST_PUBLISHERS * TEST_EVENTS)
+
+typedef struct {
+    uint32_t publisher;
+    uint32_t seq;
+    uint8_t pattern[40];
+} test_data_t;
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("event manager: ");                  \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+static int s_errors;
+
+static const int s_static_data = 42;
+
+static int8_t s_queues[TEST_SUBSCRIBERS];
+static int8_t s_isr_queue;
+
+static uint32_t s_published_failed;
+static uint32_t s_isr_published;
+static uint32_t s_isr_failed;
+
+/* What each subscriber received */
+static struct {
+    uint32_t tokens[TOKENS];
+    uint32_t data;
+    uint32_t statics;
+    int32_t next_seq[TEST_PUBLISHERS];
+    uint8_t seen[TOKENS];
+} s_received[TEST_SUBSCRIBERS];
+
+void event_manager_log_error(const char *fmt, ...)
+{
+    __atomic_add_fetch(&s_errors, 1, __ATOMIC_RELAXED);
+}
+
+static void timed_out(int sig)
+{
+    static const char msg[] = "event manager: timed out\n";
+
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+static void *publisher(void *arg)
+{
+    uint32_t pub = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t seq = 0; seq < TEST_EVENTS; seq++) {
+        test_data_t *data = afw_event_alloc(sizeof(*data));
+
+        if (!data) {
+            FAIL("publisher %u: no envelope for event %u", pub, seq);
+        }
+        data->publisher = pub;
+        data->seq = seq;
+        for (uint32_t i = 0; i < sizeof(data->pattern); i++) {
+            data->pattern[i] = (uint8_t)(pub * 31 + seq + i);
+        }
+        if (afw_publish_event_ref(EV_DATA, data) != 0) {
+            __atomic_add_fetch(&s_published_failed, 1, __ATOMIC_RELAXED);
+        }
+        if (seq % TEST_STATIC_EVERY == 0 && afw_publish_event(EV_STATIC, (void *)&s_static_data, NULL) != 0) {
+            __atomic_add_fetch(&s_published_failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static void *isr_publisher(void *arg)
+{
+    for (uint32_t n = 0; n < TEST_ISR_EVENTS; n++) {
+        portBASE_TYPE woken = pdFALSE;
+
+        if (afw_publish_event(EV_ISR, (void *)(uintptr_t)n, &woken) != 0) {
+            s_isr_failed++;
+        } else {
+            s_isr_published++;
+        }
+        if (n % 4 == 0) {
+            usleep(200);
+        }
+    }
+    return NULL;
+}
+
+static void check_data(int sub, const afw_event_t *event)
+{
+    const test_data_t *data = event->pdata;
+
+    if (!event->ref || data->publisher >= TEST_PUBLISHERS || data->seq >= TEST_EVENTS) {
+        FAIL("subscriber %d: bad data event", sub);
+    }
+    if ((int32_t)data->seq < s_received[sub].next_seq[data->publisher]) {
+        FAIL("subscriber %d: event %u of publisher %u after event %d", sub, data->seq, data->publisher,
+             s_received[sub].next_seq[data->publisher] - 1);
+    }
+    for (uint32_t i = 0; i < sizeof(data->pattern); i++) {
+        if (data->pattern[i] != (uint8_t)(data->publisher * 31 + data->seq + i)) {
+            FAIL("subscriber %d: event %u of publisher %u corrupt", sub, data->seq, data->publisher);
+        }
+    }
+    s_received[sub].next_seq[data->publisher] = data->seq + 1;
+    s_received[sub].seen[TOKEN(data->publisher, data->seq)] = 1;
+    s_received[sub].tokens[s_received[sub].data++] = TOKEN(data->publisher, data->seq);
+}
+
+static void *subscriber(void *arg)
+{
+    int sub = (int)(uintptr_t)arg;
+    int8_t queue = s_queues[sub];
+    afw_event_t event;
+    uint32_t n = 0;
+
+    while (1) {
+        int event_id = afw_get_event(queue, &event, portMAX_DELAY);
+
+        if (event_id == EV_END) {
+            break;
+        } else if (event_id == EV_DATA) {
+            check_data(sub, &event);
+        } else if (event_id == EV_STATIC && event.pdata == &s_static_data && !event.ref) {
+            s_received[sub].statics++;
+        } else {
+            FAIL("subscriber %d: event %d received", sub, event_id);
+        }
+        afw_event_done(&event);
+
+        // the slow one sleeps after every 4 events
+        if (sub == 1 && ++n % 4 == 0) {
+            usleep(200);
+        }
+    }
+    return NULL;
+}
+
+/* Drops everything up to the end event */
+static void *end_waiter(void *arg)
+{
+    int sub = (int)(uintptr_t)arg;
+    afw_event_t event;
+
+    if (afw_wait_for_event(s_queues[sub], EV_END, &event, portMAX_DELAY) != 0) {
+        FAIL("subscriber %d: end event not received", sub);
+    }
+    afw_event_done(&event);
+    return NULL;
+}
+
+static void *isr_subscriber(void *arg)
+{
+    afw_event_t event;
+    uintptr_t next = 0;
+
+    while (afw_get_event(s_isr_queue, &event, portMAX_DELAY) == EV_ISR) {
+        if ((uintptr_t)event.pdata < next || event.ref) {
+            FAIL("ISR event %lu after %lu", (unsigned long)(uintptr_t)event.pdata, (unsigned long)next - 1);
+        }
+        next = (uintptr_t)event.pdata + 1;
+        afw_event_done(&event);
+        usleep(20);
+    }
+    return NULL;
+}
+
+/* The events of the task publishers both received are in the same order */
+static void check_same_order(int a, int b)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    while (1) {
+        while (i < s_received[a].data && !s_received[b].seen[s_received[a].tokens[i]]) {
+            i++;
+        }
+        while (j < s_received[b].data && !s_received[a].seen[s_received[b].tokens[j]]) {
+            j++;
+        }
+        if (i == s_received[a].data || j == s_received[b].data) {
+            break;
+        }
+        if (s_received[a].tokens[i] != s_received[b].tokens[j]) {
+            FAIL("subscribers %d and %d received the events in a different order", a, b);
+        }
+        i++;
+        j++;
+    }
+}
+
+int main(void)
+{
+    static const int data_events[] = { EV_DATA, EV_STATIC, EV_END };
+    static const int isr_events[] = { EV_ISR, EV_END };
+    pthread_t publishers[TEST_PUBLISHERS];
+    pthread_t subscribers[TEST_SUBSCRIBERS];
+    pthread_t isr_threads[2];
+    afw_event_queue_stats_t stats;
+    uint32_t dropped = 0;
+    uint32_t received = TEST_PUBLISHERS * (TEST_EVENTS + TEST_EVENTS / TEST_STATIC_EVERY);
+
+    signal(SIGALRM, timed_out);
+    alarm(TEST_TIMEOUT_S);
+
+    for (int i = 0; i < TEST_SUBSCRIBERS; i++) {
+        s_queues[i] = afw_event_queue_init(EVENT_QUEUE_AUTO, "subscriber");
+        afw_subscribe_events(s_queues[i], data_events, 3, false);
+        pthread_create(&subscribers[i], NULL, (i == 2) ? end_waiter : subscriber, (void *)(uintptr_t)i);
+    }
+    s_isr_queue = afw_event_queue_init(EVENT_QUEUE_AUTO, "isr");
+    afw_subscribe_events(s_isr_queue, isr_events, 2, false);
+    pthread_create(&isr_threads[0], NULL, isr_subscriber, NULL);
+    pthread_create(&isr_threads[1], NULL, isr_publisher, NULL);
+
+    for (uintptr_t i = 0; i < TEST_PUBLISHERS; i++) {
+        pthread_create(&publishers[i], NULL, publisher, (void *)i);
+    }
+    for (int i = 0; i < TEST_PUBLISHERS; i++) {
+        pthread_join(publishers[i], NULL);
+    }
+    pthread_join(isr_threads[1], NULL);
+
+    if (afw_publish_event(EV_END, NULL, NULL) != 0) {
+        FAIL("end event not published");
+    }
+    for (int i = 0; i < TEST_SUBSCRIBERS; i++) {
+        pthread_join(subscribers[i], NULL);
+    }
+    pthread_join(isr_threads[0], NULL);
+
+    for (int i = 0; i < TEST_SUBSCRIBERS; i++) {
+        afw_event_queue_get_stats(s_queues[i], &stats, false);
+        if (stats.posted != stats.received || stats.posted + stats.dropped != received + 1) {
+            FAIL("subscriber %d: %u events posted, %u dropped and %u received of %u published", i,
+                 stats.posted, stats.dropped, stats.received, received + 1);
+        }
+        if (i < 2 && s_received[i].data + s_received[i].statics + 1 != stats.received) {
+            FAIL("subscriber %d: %u events handed over, %u received", i,
+                 s_received[i].data + s_received[i].statics + 1, stats.received);
+        }
+        dropped += stats.dropped;
+    }
+    if (dropped > received / 100) {
+        FAIL("%u of %u events dropped, the publishers did not wait for the slow subscriber", dropped,
+             received * TEST_SUBSCRIBERS);
+    }
+    if ((dropped != 0) != (s_published_failed != 0) || (uint32_t)s_errors != dropped) {
+        FAIL("%u events dropped, %u publishes failed, %d errors logged", dropped, s_published_failed,
+             s_errors);
+    }
+    check_same_order(0, 1);
+
+    afw_event_queue_get_stats(s_isr_queue, &stats, false);
+    if (stats.posted != s_isr_published + 1 || stats.dropped != s_isr_failed || stats.received != stats.posted) {
+        FAIL("ISR queue: %u posted, %u dropped, %u received, %u published and %u failed", stats.posted,
+             stats.dropped, stats.received, s_isr_published, s_isr_failed);
+    }
+
+    for (int i = 0; i < TEST_SUBSCRIBERS; i++) {
+        afw_event_queue_deinit(s_queues[i]);
+    }
+    afw_event_queue_deinit(s_isr_queue);
+
+    // a queue deinitialized with envelopes in it releases them.
+    int8_t unread = afw_event_queue_init(EVENT_QUEUE_AUTO, "unread");
+    afw_subscribe_events(unread, data_events, 1, false);
+    for (int i = 0; i < 3; i++) {
+        afw_publish_event_ref(EV_DATA, afw_event_alloc(16));
+    }
+    afw_event_queue_deinit(unread);
+
+    if (envelopes_in_use != 0) {
+        FAIL("%u envelopes not released", envelopes_in_use);
+    }
+
+    printf("event manager: %u events from %d publishers to %d subscribers, %u dropped, "
+           "%u ISR events published and %u dropped without waiting\n",
+           received, TEST_PUBLISHERS, TEST_SUBSCRIBERS, dropped, s_isr_published, s_isr_failed);
+    return 0;
+}
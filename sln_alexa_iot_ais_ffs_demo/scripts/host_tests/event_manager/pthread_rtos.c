@@ -0,0 +1,147 @@
+/*
+ * The FreeRTOS calls of afw_event_manager.c on POSIX threads. A queue is a
+ * ring of items under one mutex, with a condition variable for each
+ * direction, the waits time out on the millisecond ticks.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+struct pthread_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static pthread_mutex_t s_critical = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+void pthread_rtos_enter_critical(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void pthread_rtos_exit_critical(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+/* false once the ticks are over, the waits use the realtime clock */
+static bool wait_on(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t wait, const struct timespec *deadline)
+{
+    if (wait == 0) {
+        return false;
+    }
+    if (wait == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static void deadline_in(TickType_t wait, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_sec += wait / 1000;
+    deadline->tv_nsec += (long)(wait % 1000) * 1000000;
+    if (deadline->tv_nsec >= 1000000000) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    queue->items = calloc(length, itemSize ? itemSize : 1);
+    queue->length = length;
+    queue->item_size = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    struct timespec deadline;
+
+    deadline_in(wait, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (!wait_on(&queue->not_full, &queue->lock, wait, &deadline) && queue->count == queue->length) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size != 0) {
+        memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], item,
+               queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    struct timespec deadline;
+
+    deadline_in(wait, &deadline);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!wait_on(&queue->not_empty, &queue->lock, wait, &deadline) && queue->count == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size != 0) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+
+    xSemaphoreGive(mutex);
+    return mutex;
+}
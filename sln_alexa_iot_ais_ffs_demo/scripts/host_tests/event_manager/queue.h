@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for queue.h, a queue is a ring of items under a mutex. The
+ * ISR calls never wait.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct pthread_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+void vQueueDelete(QueueHandle_t queue);
+
+#define xQueueSendFromISR( q, item, woken ) xQueueSend( ( q ), ( item ), 0 )
+
+#endif /* QUEUE_H */
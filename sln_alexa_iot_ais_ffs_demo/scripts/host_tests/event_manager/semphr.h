@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for semphr.h, a mutex is a queue of one empty item, full
+ * while the mutex is free.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreTake( s, wait ) xQueueReceive( ( s ), NULL, ( wait ) )
+#define xSemaphoreGive( s )       xQueueSend( ( s ), NULL, 0 )
+#define vSemaphoreDelete( s )     vQueueDelete( s )
+
+#endif /* SEMAPHORE_H */
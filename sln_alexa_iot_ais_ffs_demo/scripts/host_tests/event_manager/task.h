@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for task.h. The critical sections, from tasks and from ISRs,
+ * are one recursive mutex every thread of the test shares.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include <sched.h>
+
+#include "FreeRTOS.h"
+
+TickType_t xTaskGetTickCount(void);
+void pthread_rtos_enter_critical(void);
+void pthread_rtos_exit_critical(void);
+
+#define xTaskGetTickCountFromISR()          xTaskGetTickCount()
+#define taskENTER_CRITICAL()                pthread_rtos_enter_critical()
+#define taskEXIT_CRITICAL()                 pthread_rtos_exit_critical()
+#define taskENTER_CRITICAL_FROM_ISR()       ( pthread_rtos_enter_critical(), 0 )
+#define taskEXIT_CRITICAL_FROM_ISR( mask )  ( ( void ) ( mask ), pthread_rtos_exit_critical() )
+#define taskYIELD()                         sched_yield()
+
+#endif /* INC_TASK_H */
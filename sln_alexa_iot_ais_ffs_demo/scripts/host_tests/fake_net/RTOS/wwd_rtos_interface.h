@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for RTOS/wwd_rtos_interface.h, nothing of it is used.
+ */
+
+#ifndef INCLUDED_WWD_RTOS_INTERFACE_H_
+#define INCLUDED_WWD_RTOS_INTERFACE_H_
+
+#endif /* INCLUDED_WWD_RTOS_INTERFACE_H_ */
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the lwIP arch/cc.h of lwip/port.
+ */
+
+#ifndef FAKE_NET_CC_H
+#define FAKE_NET_CC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LWIP_PLATFORM_DIAG(x) \
+    do {                      \
+        printf x;             \
+        printf("\n");         \
+    } while (0)
+
+#define LWIP_PLATFORM_ASSERT(x)                                    \
+    do {                                                           \
+        printf("lwip assert: %s at %s:%d\n", x, __FILE__, __LINE__); \
+        abort();                                                   \
+    } while (0)
+
+#endif /* FAKE_NET_CC_H */
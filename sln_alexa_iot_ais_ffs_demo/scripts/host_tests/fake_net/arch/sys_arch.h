@@ -0,0 +1,29 @@
+/*
+ * Host stand-in for the lwIP arch/sys_arch.h of lwip/port, lwIP runs on the
+ * simulated scheduler of fake_sai/sim_rtos.c, see sys_arch.c.
+ */
+
+#ifndef FAKE_NET_SYS_ARCH_H
+#define FAKE_NET_SYS_ARCH_H
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+struct sys_mbox;
+
+typedef SemaphoreHandle_t sys_sem_t;
+typedef SemaphoreHandle_t sys_mutex_t;
+typedef struct sys_mbox *sys_mbox_t;
+typedef TaskHandle_t sys_thread_t;
+typedef unsigned long sys_prot_t;
+
+#define SYS_MBOX_NULL NULL
+#define SYS_SEM_NULL  NULL
+
+#define sys_mbox_valid(x)       (*(x) != NULL)
+#define sys_mbox_set_invalid(x) (*(x) = NULL)
+#define sys_sem_valid(x)        (*(x) != NULL)
+#define sys_sem_set_invalid(x)  (*(x) = NULL)
+
+#endif /* FAKE_NET_SYS_ARCH_H */
@@ -0,0 +1,169 @@
+/*
+ * Fake WiFi interfaces for the host checks, see fake_net.h.
+ */
+
+#include <string.h>
+
+#include "lwip/etharp.h"
+#include "lwip/ip.h"
+#include "lwip/pbuf.h"
+#include "lwip/prot/udp.h"
+#include "netif/ethernet.h"
+
+#include "fake_net.h"
+#include "network/wwd_network_constants.h"
+#include "wwd_network.h"
+
+#define FAKE_NET_MAX_NETIFS 4
+
+static fake_net_tx_hook_t s_tx_hook;
+
+static struct {
+    struct netif *netif;
+    uint32_t tx;
+} s_netifs[FAKE_NET_MAX_NETIFS];
+
+void fake_net_set_tx_hook(fake_net_tx_hook_t hook)
+{
+    s_tx_hook = hook;
+}
+
+static uint32_t *fake_net_counter(struct netif *netif)
+{
+    for (int i = 0; i < FAKE_NET_MAX_NETIFS; i++) {
+        if (s_netifs[i].netif == netif) {
+            return &s_netifs[i].tx;
+        }
+    }
+    for (int i = 0; i < FAKE_NET_MAX_NETIFS; i++) {
+        if (s_netifs[i].netif == NULL) {
+            s_netifs[i].netif = netif;
+            return &s_netifs[i].tx;
+        }
+    }
+    printf("fake net: too many interfaces\n");
+    exit(1);
+}
+
+uint32_t fake_net_tx_count(struct netif *netif)
+{
+    return *fake_net_counter(netif);
+}
+
+static err_t fake_net_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    uint8_t frame[WICED_PAYLOAD_MTU + SIZEOF_ETH_HDR];
+    uint16_t len;
+
+    if (p->tot_len > sizeof(frame)) {
+        printf("fake net: %u byte frame sent\n", p->tot_len);
+        exit(1);
+    }
+    len = pbuf_copy_partial(p, frame, sizeof(frame), 0);
+
+    (*fake_net_counter(netif))++;
+    if (s_tx_hook != NULL) {
+        s_tx_hook(netif, frame, len);
+    }
+    return ERR_OK;
+}
+
+bool fake_net_input(struct netif *netif, const uint8_t *frame, uint16_t len)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+
+    if (p == NULL) {
+        return false;
+    }
+    pbuf_take(p, frame, len);
+    if (netif->input(p, netif) != ERR_OK) {
+        pbuf_free(p);
+        return false;
+    }
+    return true;
+}
+
+static uint16_t fake_net_ip_checksum(const uint8_t *hdr)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < IP_HLEN; i += 2) {
+        sum += (uint32_t)(hdr[i] << 8) | hdr[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+static void fake_net_put16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+/* The UDP checksum is left out, 0 tells the receiver so */
+uint16_t fake_net_udp_frame(uint8_t *frame, const uint8_t *dst_mac, const uint8_t *src_mac, uint32_t src_ip,
+                            uint32_t dst_ip, uint16_t src_port, uint16_t dst_port, const uint8_t *payload,
+                            uint16_t len)
+{
+    uint8_t *ip = frame + SIZEOF_ETH_HDR;
+    uint8_t *udp = ip + IP_HLEN;
+
+    memcpy(frame, dst_mac, ETH_HWADDR_LEN);
+    memcpy(frame + ETH_HWADDR_LEN, src_mac, ETH_HWADDR_LEN);
+    fake_net_put16(frame + 2 * ETH_HWADDR_LEN, ETHTYPE_IP);
+
+    memset(ip, 0, IP_HLEN);
+    ip[0] = 0x45;
+    fake_net_put16(ip + 2, (uint16_t)(IP_HLEN + UDP_HLEN + len));
+    ip[8] = 64;
+    ip[9] = IP_PROTO_UDP;
+    memcpy(ip + 12, &src_ip, 4);
+    memcpy(ip + 16, &dst_ip, 4);
+    fake_net_put16(ip + 10, fake_net_ip_checksum(ip));
+
+    fake_net_put16(udp, src_port);
+    fake_net_put16(udp + 2, dst_port);
+    fake_net_put16(udp + 4, (uint16_t)(UDP_HLEN + len));
+    fake_net_put16(udp + 6, 0);
+    memcpy(udp + UDP_HLEN, payload, len);
+
+    return (uint16_t)(SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + len);
+}
+
+const uint8_t *fake_net_udp_payload(const uint8_t *frame, uint16_t len, uint16_t dst_port, uint16_t *payload_len)
+{
+    const uint8_t *ip = frame + SIZEOF_ETH_HDR;
+    const uint8_t *udp;
+    uint16_t udp_len;
+
+    if ((len < SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN) || (((frame[12] << 8) | frame[13]) != ETHTYPE_IP) ||
+        (ip[9] != IP_PROTO_UDP)) {
+        return NULL;
+    }
+    udp = ip + (ip[0] & 0x0f) * 4;
+    udp_len = (uint16_t)((udp[4] << 8) | udp[5]);
+    if ((((udp[2] << 8) | udp[3]) != dst_port) || (udp + udp_len > frame + len) || (udp_len < UDP_HLEN)) {
+        return NULL;
+    }
+    *payload_len = udp_len - UDP_HLEN;
+    return udp + UDP_HLEN;
+}
+
+err_t wlanif_init(struct netif *netif)
+{
+    netif->name[0] = 'w';
+    netif->name[1] = 'l';
+    netif->hwaddr_len = ETHARP_HWADDR_LEN;
+    memset(netif->hwaddr, 0, ETHARP_HWADDR_LEN);
+    netif->hwaddr[0] = 0x02;
+    netif->hwaddr[5] = (uint8_t)((uintptr_t)netif->state + 1);
+    netif->mtu = WICED_PAYLOAD_MTU;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+    netif->output = etharp_output;
+    netif->linkoutput = fake_net_linkoutput;
+
+    *fake_net_counter(netif) = 0;
+    return ERR_OK;
+}
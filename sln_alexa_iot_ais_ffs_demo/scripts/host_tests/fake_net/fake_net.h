@@ -0,0 +1,37 @@
+/*
+ * Fake WiFi interfaces for the host checks, in place of the wlanif_init() of
+ * the WICED network driver. A netif added with it hands each frame it sends to
+ * the hook of the check, which plays the rest of the network: it can answer by
+ * passing frames back with fake_net_input(). The interfaces take the MAC
+ * address 02:00:00:00:00:0N, N being the WWD interface in the netif state plus
+ * one.
+ */
+
+#ifndef FAKE_NET_H
+#define FAKE_NET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lwip/netif.h"
+
+/* Called, on the tcpip thread, with each Ethernet frame netif sends */
+typedef void (*fake_net_tx_hook_t)(struct netif *netif, const uint8_t *frame, uint16_t len);
+
+void fake_net_set_tx_hook(fake_net_tx_hook_t hook);
+
+/* Passes an Ethernet frame to netif as received, returns false when lwIP is out of pbufs */
+bool fake_net_input(struct netif *netif, const uint8_t *frame, uint16_t len);
+
+/* Frames sent by netif since it was added */
+uint32_t fake_net_tx_count(struct netif *netif);
+
+/* Builds an Ethernet/IPv4/UDP frame around payload, addresses in network order. Returns its length */
+uint16_t fake_net_udp_frame(uint8_t *frame, const uint8_t *dst_mac, const uint8_t *src_mac, uint32_t src_ip,
+                            uint32_t dst_ip, uint16_t src_port, uint16_t dst_port, const uint8_t *payload,
+                            uint16_t len);
+
+/* Payload of frame when it is an IPv4/UDP datagram to dst_port, NULL otherwise */
+const uint8_t *fake_net_udp_payload(const uint8_t *frame, uint16_t len, uint16_t dst_port, uint16_t *payload_len);
+
+#endif /* FAKE_NET_H */
@@ -0,0 +1,33 @@
+/*
+ * Host lwIP options: the ones of the target in config_files/lwipopts.h, with
+ * what a 64-bit host and the build of the host checks need on top.
+ */
+
+#ifndef FAKE_NET_LWIPOPTS_H
+#define FAKE_NET_LWIPOPTS_H
+
+/* Pointers are 8 bytes here */
+#define MEM_ALIGNMENT 8
+
+/* The target sets the printf formats again after lwip/arch.h */
+#undef X8_F
+#undef U16_F
+#undef S16_F
+#undef X16_F
+#undef U32_F
+#undef S32_F
+#undef X32_F
+#undef SZT_F
+
+#include_next "lwipopts.h"
+
+/* Only the netconn API is built, errno comes from the C library */
+#undef LWIP_SOCKET
+#define LWIP_SOCKET 0
+#undef LWIP_PROVIDE_ERRNO
+#define LWIP_ERRNO_STDINCLUDE 1
+
+#undef SZT_F
+#define SZT_F "zu"
+
+#endif /* FAKE_NET_LWIPOPTS_H */
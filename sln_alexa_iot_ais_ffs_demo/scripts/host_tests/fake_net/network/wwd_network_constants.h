@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for network/wwd_network_constants.h.
+ */
+
+#ifndef INCLUDED_WWD_NETWORK_CONSTANTS_H_
+#define INCLUDED_WWD_NETWORK_CONSTANTS_H_
+
+#define WICED_PAYLOAD_MTU 1500
+
+#endif /* INCLUDED_WWD_NETWORK_CONSTANTS_H_ */
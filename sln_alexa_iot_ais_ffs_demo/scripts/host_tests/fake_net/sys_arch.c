@@ -0,0 +1,184 @@
+/*
+ * lwIP system layer of the host checks, on the simulated scheduler of
+ * fake_sai/sim_rtos.c: the threads are its tasks, semaphores and mutexes its
+ * counting semaphores. A mailbox is a ring with a semaphore counting the
+ * messages and one counting the free slots. The tasks never run at the same
+ * time, so the protection has nothing to do.
+ */
+
+#include <stdlib.h>
+
+#include "lwip/sys.h"
+#include "sim_rtos.h"
+
+struct sys_mbox
+{
+    void **msgs;
+    int size;
+    int head;
+    int tail;
+    SemaphoreHandle_t used;
+    SemaphoreHandle_t free;
+};
+
+void sys_init(void)
+{
+}
+
+u32_t sys_now(void)
+{
+    return xTaskGetTickCount();
+}
+
+sys_prot_t sys_arch_protect(void)
+{
+    return 0;
+}
+
+void sys_arch_unprotect(sys_prot_t pval)
+{
+}
+
+err_t sys_sem_new(sys_sem_t *sem, u8_t count)
+{
+    *sem = xSemaphoreCreateCounting(0xffff, count);
+    return ERR_OK;
+}
+
+void sys_sem_signal(sys_sem_t *sem)
+{
+    xSemaphoreGive(*sem);
+}
+
+/* Waits forever for a timeout of 0, returns the time waited */
+u32_t sys_arch_sem_wait(sys_sem_t *sem, u32_t timeout)
+{
+    u32_t start = sys_now();
+
+    if (xSemaphoreTake(*sem, (timeout == 0) ? portMAX_DELAY : timeout) != pdTRUE) {
+        return SYS_ARCH_TIMEOUT;
+    }
+    return sys_now() - start;
+}
+
+void sys_sem_free(sys_sem_t *sem)
+{
+    vSemaphoreDelete(*sem);
+}
+
+err_t sys_mutex_new(sys_mutex_t *mutex)
+{
+    *mutex = xSemaphoreCreateMutex();
+    return ERR_OK;
+}
+
+void sys_mutex_lock(sys_mutex_t *mutex)
+{
+    xSemaphoreTake(*mutex, portMAX_DELAY);
+}
+
+void sys_mutex_unlock(sys_mutex_t *mutex)
+{
+    xSemaphoreGive(*mutex);
+}
+
+void sys_mutex_free(sys_mutex_t *mutex)
+{
+    vSemaphoreDelete(*mutex);
+}
+
+err_t sys_mbox_new(sys_mbox_t *mbox, int size)
+{
+    struct sys_mbox *box = calloc(1, sizeof(*box));
+
+    box->size = size;
+    box->msgs = calloc(size, sizeof(void *));
+    box->used = xSemaphoreCreateCounting(size, 0);
+    box->free = xSemaphoreCreateCounting(size, size);
+    *mbox = box;
+    return ERR_OK;
+}
+
+void sys_mbox_free(sys_mbox_t *mbox)
+{
+    struct sys_mbox *box = *mbox;
+
+    if (uxSemaphoreGetCount(box->used) != 0) {
+        printf("sys arch: mailbox freed with %lu messages in it\n", uxSemaphoreGetCount(box->used));
+        exit(1);
+    }
+    vSemaphoreDelete(box->used);
+    vSemaphoreDelete(box->free);
+    free(box->msgs);
+    free(box);
+}
+
+static void sys_mbox_put(struct sys_mbox *box, void *msg)
+{
+    box->msgs[box->head] = msg;
+    box->head = (box->head + 1) % box->size;
+    xSemaphoreGive(box->used);
+}
+
+void sys_mbox_post(sys_mbox_t *mbox, void *msg)
+{
+    xSemaphoreTake((*mbox)->free, portMAX_DELAY);
+    sys_mbox_put(*mbox, msg);
+}
+
+err_t sys_mbox_trypost(sys_mbox_t *mbox, void *msg)
+{
+    if (xSemaphoreTake((*mbox)->free, 0) != pdTRUE) {
+        return ERR_MEM;
+    }
+    sys_mbox_put(*mbox, msg);
+    return ERR_OK;
+}
+
+err_t sys_mbox_trypost_fromisr(sys_mbox_t *mbox, void *msg)
+{
+    return sys_mbox_trypost(mbox, msg);
+}
+
+static void sys_mbox_get(struct sys_mbox *box, void **msg)
+{
+    void *got = box->msgs[box->tail];
+
+    box->tail = (box->tail + 1) % box->size;
+    xSemaphoreGive(box->free);
+    if (msg != NULL) {
+        *msg = got;
+    }
+}
+
+/* Waits forever for a timeout of 0, returns the time waited */
+u32_t sys_arch_mbox_fetch(sys_mbox_t *mbox, void **msg, u32_t timeout)
+{
+    u32_t start = sys_now();
+
+    if (xSemaphoreTake((*mbox)->used, (timeout == 0) ? portMAX_DELAY : timeout) != pdTRUE) {
+        return SYS_ARCH_TIMEOUT;
+    }
+    sys_mbox_get(*mbox, msg);
+    return sys_now() - start;
+}
+
+u32_t sys_arch_mbox_tryfetch(sys_mbox_t *mbox, void **msg)
+{
+    if (xSemaphoreTake((*mbox)->used, 0) != pdTRUE) {
+        return SYS_MBOX_EMPTY;
+    }
+    sys_mbox_get(*mbox, msg);
+    return 0;
+}
+
+sys_thread_t sys_thread_new(const char *name, lwip_thread_fn thread, void *arg, int stacksize, int prio)
+{
+    TaskHandle_t task = NULL;
+
+    if (xTaskCreate(thread, name, stacksize, arg, prio, &task) != pdPASS) {
+        printf("sys arch: no task left for %s\n", name);
+        exit(1);
+    }
+    return task;
+}
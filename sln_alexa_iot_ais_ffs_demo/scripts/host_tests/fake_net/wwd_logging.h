@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for wwd_logging.h, the logs are dropped.
+ */
+
+#ifndef INCLUDED_WWD_LOGGING_H_
+#define INCLUDED_WWD_LOGGING_H_
+
+#define WWD_LOG(x)
+
+#endif /* INCLUDED_WWD_LOGGING_H_ */
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for wwd_network.h, wlanif_init() is the fake one of fake_net.c.
+ */
+
+#ifndef INCLUDED_WWD_NETWORK_H_
+#define INCLUDED_WWD_NETWORK_H_
+
+#include "lwip/err.h"
+
+struct netif;
+
+err_t wlanif_init(struct netif *netif);
+
+#endif /* INCLUDED_WWD_NETWORK_H_ */
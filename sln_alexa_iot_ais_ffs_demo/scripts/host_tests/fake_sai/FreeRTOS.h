@@ -0,0 +1,44 @@
+/*
+ * Host stand-in for FreeRTOS.h, for the modules run on the simulated scheduler
+ * of sim_rtos.c. The tasks are run one at a time and only switch when they
+ * block, so the critical sections have nothing to mask.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define portSTACK_TYPE StackType_t
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+#define pdPASS  ( pdTRUE )
+#define pdFAIL  ( pdFALSE )
+
+#define portMAX_DELAY      ( ( TickType_t ) 0xffffffffUL )
+#define portTICK_PERIOD_MS ( ( TickType_t ) 1 )
+#define pdMS_TO_TICKS( ms ) ( ( TickType_t ) ( ms ) )
+
+#define configMAX_PRIORITIES 15
+#define configTIMER_TASK_PRIORITY ( configMAX_PRIORITIES - 1 )
+#ifndef configPRINTF
+#define configPRINTF( x )    printf x
+#endif
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define portYIELD_FROM_ISR( woken ) ( void ) ( woken )
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *ptr);
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,50 @@
+/*
+ * Host stand-in for board.h: the amplifier SAI is the fake one of fake_sai.c,
+ * the interrupts and the codec do nothing.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include "fsl_codec_common.h"
+#include "fsl_sai_edma.h"
+
+extern I2S_Type g_fake_sai;
+
+#define BOARD_AMP_SAI (&g_fake_sai)
+
+#define SAI3_RX_IRQn 0
+
+typedef struct
+{
+    edma_handle_t *amp_dma_tx_handle;
+    edma_handle_t *amp_dma_rx_handle;
+    sai_edma_handle_t *amp_sai_tx_handle;
+    sai_edma_handle_t *amp_sai_rx_handle;
+    sai_edma_callback_t sai_tx_callback;
+    sai_edma_callback_t sai_rx_callback;
+} sai_init_handle_t;
+
+/* Hooks the callbacks to the fake SAI and sends the 32 dummy bytes, like the board does */
+void BOARD_SAI_Init(sai_init_handle_t saiInitHandle);
+
+static inline void BOARD_Codec_I2C_Init(void)
+{
+}
+
+static inline codec_config_t *BOARD_GetBoardCodecConfig(void)
+{
+    static codec_config_t config;
+
+    return &config;
+}
+
+static inline void NVIC_EnableIRQ(int irq)
+{
+}
+
+static inline void NVIC_DisableIRQ(int irq)
+{
+}
+
+#endif /* _BOARD_H_ */
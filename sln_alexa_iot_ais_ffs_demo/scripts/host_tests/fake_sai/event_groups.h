@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for event_groups.h, a wait blocks the calling task of the
+ * simulated scheduler in sim_rtos.c.
+ */
+
+#ifndef EVENT_GROUPS_H
+#define EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+
+typedef TickType_t EventBits_t;
+typedef struct sim_event_group *EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all,
+                                TickType_t ticks);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+
+static inline BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits, BaseType_t *woken)
+{
+    xEventGroupSetBits(group, bits);
+    return pdPASS;
+}
+
+#endif /* EVENT_GROUPS_H */
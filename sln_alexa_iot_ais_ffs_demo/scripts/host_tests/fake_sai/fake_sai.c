@@ -0,0 +1,178 @@
+/*
+ * Fake amplifier SAI, see fake_sai.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+#include "pdm_pcm_definitions.h"
+
+#include "fake_sai.h"
+#include "sim_rtos.h"
+
+#define FAKE_SAI_BYTES_PER_MS PCM_AMP_DATA_SIZE_1_MS
+
+I2S_Type g_fake_sai;
+
+static sai_edma_handle_t *s_tx_handle;
+static sai_transfer_t s_queue[SAI_XFER_QUEUE_SIZE];
+static uint32_t s_queue_head;
+static uint32_t s_queue_count;
+
+static bool s_running;
+static bool s_dry;
+static uint64_t s_dry_us; /* Ran dry at */
+static uint64_t s_end_us; /* The playing transfer ends at */
+static uint64_t s_carry;  /* Rounding of the transfer lengths, carried to the next one */
+
+static uint8_t *s_out;
+static size_t s_out_length;
+static size_t s_out_size;
+
+static fake_sai_stats_t s_stats;
+static fake_sai_start_hook_t s_start_hook;
+
+static void fake_sai_start(void)
+{
+    sai_transfer_t *xfer = &s_queue[s_queue_head];
+    uint64_t bytes_us = (uint64_t)xfer->dataSize * 1000 + s_carry;
+
+    if (s_out_length + xfer->dataSize > s_out_size) {
+        s_out_size = 2 * (s_out_length + xfer->dataSize);
+        s_out = realloc(s_out, s_out_size);
+    }
+    memcpy(s_out + s_out_length, xfer->data, xfer->dataSize);
+    s_out_length += xfer->dataSize;
+
+    s_running = true;
+    s_end_us = sim_now_us() + bytes_us / FAKE_SAI_BYTES_PER_MS;
+    s_carry = bytes_us % FAKE_SAI_BYTES_PER_MS;
+    s_stats.transfers++;
+
+    if (s_start_hook != NULL) {
+        s_start_hook(xfer->data, xfer->dataSize, sim_now_us());
+    }
+}
+
+static uint64_t fake_sai_next_us(void)
+{
+    return s_running ? s_end_us : UINT64_MAX;
+}
+
+/* A transfer ended: the next one was linked and starts right away, then the callback runs */
+static void fake_sai_fire(void)
+{
+    s_queue_head = (s_queue_head + 1) % SAI_XFER_QUEUE_SIZE;
+    s_queue_count--;
+
+    if (s_queue_count) {
+        fake_sai_start();
+    } else {
+        s_running = false;
+        s_dry = true;
+        s_dry_us = sim_now_us();
+        s_carry = 0;
+    }
+
+    s_stats.callbacks++;
+    if (s_tx_handle->callback != NULL) {
+        s_tx_handle->callback(BOARD_AMP_SAI, s_tx_handle, kStatus_SAI_TxIdle, s_tx_handle->userData);
+    }
+}
+
+static const sim_irq_t s_irq = { fake_sai_next_us, fake_sai_fire };
+
+void fake_sai_init(void)
+{
+    sim_add_irq(&s_irq);
+}
+
+void fake_sai_reset(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_out_length = 0;
+    s_dry = false;
+}
+
+void fake_sai_get_stats(fake_sai_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+const uint8_t *fake_sai_output(size_t *length)
+{
+    *length = s_out_length;
+    return s_out;
+}
+
+void fake_sai_set_start_hook(fake_sai_start_hook_t hook)
+{
+    s_start_hook = hook;
+}
+
+bool fake_sai_running(void)
+{
+    return s_running;
+}
+
+void BOARD_SAI_Init(sai_init_handle_t saiInitHandle)
+{
+    static uint8_t dummy[32];
+    sai_transfer_t xfer = { dummy, sizeof(dummy) };
+
+    s_tx_handle = saiInitHandle.amp_sai_tx_handle;
+    s_tx_handle->callback = saiInitHandle.sai_tx_callback;
+    s_tx_handle->userData = NULL;
+    if (saiInitHandle.amp_sai_rx_handle != NULL) {
+        saiInitHandle.amp_sai_rx_handle->callback = saiInitHandle.sai_rx_callback;
+    }
+
+    SAI_TransferSendEDMA(BOARD_AMP_SAI, s_tx_handle, &xfer);
+    s_dry = false;
+}
+
+status_t SAI_TransferSendEDMA(I2S_Type *base, sai_edma_handle_t *handle, sai_transfer_t *xfer)
+{
+    if (handle != s_tx_handle || xfer->data == NULL || xfer->dataSize == 0 || xfer->dataSize % 32) {
+        printf("fake sai: bad transfer of %zu bytes\n", xfer->dataSize);
+        exit(1);
+    }
+    if (s_queue_count == SAI_XFER_QUEUE_SIZE) {
+        s_stats.queue_full++;
+        return kStatus_SAI_QueueFull;
+    }
+
+    s_queue[(s_queue_head + s_queue_count) % SAI_XFER_QUEUE_SIZE] = *xfer;
+    s_queue_count++;
+
+    if (!s_running) {
+        if (s_dry) {
+            s_stats.underruns++;
+            s_stats.dry_us += sim_now_us() - s_dry_us;
+            s_dry = false;
+        }
+        fake_sai_start();
+    }
+    return kStatus_Success;
+}
+
+void SAI_TransferTerminateSendEDMA(I2S_Type *base, sai_edma_handle_t *handle)
+{
+    s_queue_head = 0;
+    s_queue_count = 0;
+    s_running = false;
+    s_dry = false;
+    s_carry = 0;
+    s_stats.terminates++;
+}
+
+status_t SAI_TransferReceiveEDMA(I2S_Type *base, sai_edma_handle_t *handle, sai_transfer_t *xfer)
+{
+    return kStatus_Success;
+}
+
+void SAI_TransferTerminateReceiveEDMA(I2S_Type *base, sai_edma_handle_t *handle)
+{
+}
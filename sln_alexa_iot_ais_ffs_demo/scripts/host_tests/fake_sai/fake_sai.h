@@ -0,0 +1,48 @@
+/*
+ * Fake amplifier SAI for the host checks. It plays the queued transfers one
+ * after the other on the virtual clock of sim_rtos.c, at the PCM_AMP rate, and
+ * calls the TX callback as each one ends. Everything played is kept, silence
+ * included, so a check can compare it sample by sample.
+ *
+ * The SAI runs dry when its queue is empty as a transfer ends. A transfer
+ * queued after that restarts it, and counts as an underrun: on the board this
+ * is an audible gap. A terminate stops it without running dry.
+ */
+
+#ifndef FAKE_SAI_H
+#define FAKE_SAI_H
+
+#include <stdint.h>
+
+#include "fsl_sai_edma.h"
+
+typedef struct fake_sai_stats
+{
+    uint32_t transfers;   /* Transfers played */
+    uint32_t underruns;   /* Restarts after running dry */
+    uint64_t dry_us;       /* Time spent dry before the restarts */
+    uint32_t terminates;  /* SAI_TransferTerminateSendEDMA calls */
+    uint32_t queue_full;   /* Transfers refused, the queue was full */
+    uint32_t callbacks;   /* TX callbacks called */
+} fake_sai_stats_t;
+
+/* Called as a transfer starts playing */
+typedef void (*fake_sai_start_hook_t)(const uint8_t *data, size_t size, uint64_t now_us);
+
+/* Registers the SAI with the simulated scheduler */
+void fake_sai_init(void);
+
+/* Clears the statistics and the output */
+void fake_sai_reset(void);
+
+void fake_sai_get_stats(fake_sai_stats_t *stats);
+
+/* Everything played since the last reset */
+const uint8_t *fake_sai_output(size_t *length);
+
+void fake_sai_set_start_hook(fake_sai_start_hook_t hook);
+
+/* True while a transfer is playing */
+bool fake_sai_running(void);
+
+#endif /* FAKE_SAI_H */
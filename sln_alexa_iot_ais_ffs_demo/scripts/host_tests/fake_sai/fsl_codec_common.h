@@ -0,0 +1,37 @@
+/*
+ * Host stand-in for fsl_codec_common.h, the codec does nothing.
+ */
+
+#ifndef _FSL_CODEC_COMMON_H_
+#define _FSL_CODEC_COMMON_H_
+
+#include "fsl_common.h"
+
+enum
+{
+    kCODEC_PlayChannelLeft0  = (1U << 0U),
+    kCODEC_PlayChannelRight0 = (1U << 1U),
+};
+
+typedef struct _codec_config
+{
+    void *codecDevConfig;
+} codec_config_t;
+
+typedef struct _codec_handle
+{
+    codec_config_t *codecConfig;
+} codec_handle_t;
+
+static inline status_t CODEC_Init(codec_handle_t *handle, codec_config_t *config)
+{
+    handle->codecConfig = config;
+    return kStatus_Success;
+}
+
+static inline status_t CODEC_SetVolume(codec_handle_t *handle, uint32_t channel, uint32_t volume)
+{
+    return kStatus_Success;
+}
+
+#endif /* _FSL_CODEC_COMMON_H_ */
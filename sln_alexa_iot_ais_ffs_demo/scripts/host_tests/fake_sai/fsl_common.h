@@ -0,0 +1,36 @@
+/*
+ * Host stand-in for fsl_common.h, the status codes and helpers the audio
+ * modules use.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+#define MAKE_STATUS(group, code) ((((group)*100) + (code)))
+
+enum
+{
+    kStatusGroup_Generic = 0,
+    kStatusGroup_SAI     = 19,
+};
+
+enum
+{
+    kStatus_Success         = MAKE_STATUS(kStatusGroup_Generic, 0),
+    kStatus_Fail            = MAKE_STATUS(kStatusGroup_Generic, 1),
+    kStatus_InvalidArgument = MAKE_STATUS(kStatusGroup_Generic, 4),
+    kStatus_Timeout         = MAKE_STATUS(kStatusGroup_Generic, 5),
+};
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#endif /* _FSL_COMMON_H_ */
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for fsl_dmamux.h, the channels are not modelled.
+ */
+
+#ifndef _FSL_DMAMUX_H_
+#define _FSL_DMAMUX_H_
+
+#include "fsl_common.h"
+
+#define DMAMUX NULL
+
+static inline void DMAMUX_EnableChannel(void *base, uint32_t channel)
+{
+}
+
+static inline void DMAMUX_DisableChannel(void *base, uint32_t channel)
+{
+}
+
+#endif /* _FSL_DMAMUX_H_ */
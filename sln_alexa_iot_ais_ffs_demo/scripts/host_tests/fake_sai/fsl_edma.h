@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for fsl_edma.h, the handles are never looked into.
+ */
+
+#ifndef _FSL_EDMA_H_
+#define _FSL_EDMA_H_
+
+#include "fsl_common.h"
+
+typedef struct _edma_handle
+{
+    uint32_t channel;
+} edma_handle_t;
+
+#endif /* _FSL_EDMA_H_ */
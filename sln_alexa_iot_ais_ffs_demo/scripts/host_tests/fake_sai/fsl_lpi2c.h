@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for fsl_lpi2c.h, nothing of it is used.
+ */
+
+#ifndef _FSL_LPI2C_H_
+#define _FSL_LPI2C_H_
+
+#include "fsl_common.h"
+
+#endif /* _FSL_LPI2C_H_ */
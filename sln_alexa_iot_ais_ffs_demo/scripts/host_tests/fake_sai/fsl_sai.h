@@ -0,0 +1,80 @@
+/*
+ * Host stand-in for fsl_sai.h. The SAI is the fake one of fake_sai.c, only the
+ * FIFO error flags of its registers and the format enums are there.
+ */
+
+#ifndef _FSL_SAI_H_
+#define _FSL_SAI_H_
+
+#include "fsl_common.h"
+
+#define SAI_XFER_QUEUE_SIZE (4U)
+
+enum
+{
+    kStatus_SAI_TxBusy    = MAKE_STATUS(kStatusGroup_SAI, 0),
+    kStatus_SAI_RxBusy    = MAKE_STATUS(kStatusGroup_SAI, 1),
+    kStatus_SAI_TxError   = MAKE_STATUS(kStatusGroup_SAI, 2),
+    kStatus_SAI_RxError   = MAKE_STATUS(kStatusGroup_SAI, 3),
+    kStatus_SAI_QueueFull = MAKE_STATUS(kStatusGroup_SAI, 4),
+    kStatus_SAI_TxIdle    = MAKE_STATUS(kStatusGroup_SAI, 5),
+    kStatus_SAI_RxIdle    = MAKE_STATUS(kStatusGroup_SAI, 6),
+};
+
+enum
+{
+    kSAI_FIFOErrorFlag = (1U << 18U),
+};
+
+typedef enum _sai_mono_stereo
+{
+    kSAI_Stereo = 0x0U,
+    kSAI_MonoRight,
+    kSAI_MonoLeft,
+} sai_mono_stereo_t;
+
+typedef enum _sai_sample_rate
+{
+    kSAI_SampleRate8KHz    = 8000U,
+    kSAI_SampleRate11025Hz = 11025U,
+    kSAI_SampleRate12KHz   = 12000U,
+    kSAI_SampleRate16KHz   = 16000U,
+    kSAI_SampleRate22050Hz = 22050U,
+    kSAI_SampleRate24KHz   = 24000U,
+    kSAI_SampleRate32KHz   = 32000U,
+    kSAI_SampleRate44100Hz = 44100U,
+    kSAI_SampleRate48KHz   = 48000U,
+    kSAI_SampleRate96KHz   = 96000U,
+} sai_sample_rate_t;
+
+typedef enum _sai_word_width
+{
+    kSAI_WordWidth8bits  = 8U,
+    kSAI_WordWidth16bits = 16U,
+    kSAI_WordWidth24bits = 24U,
+    kSAI_WordWidth32bits = 32U,
+} sai_word_width_t;
+
+typedef struct
+{
+    volatile uint32_t TCSR;
+    volatile uint32_t RCSR;
+} I2S_Type;
+
+typedef struct _sai_transfer
+{
+    uint8_t *data;
+    size_t dataSize;
+} sai_transfer_t;
+
+static inline void SAI_TxClearStatusFlags(I2S_Type *base, uint32_t mask)
+{
+    base->TCSR &= ~mask;
+}
+
+static inline void SAI_RxClearStatusFlags(I2S_Type *base, uint32_t mask)
+{
+    base->RCSR &= ~mask;
+}
+
+#endif /* _FSL_SAI_H_ */
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for fsl_sai_edma.h, the transfers go to the fake SAI of
+ * fake_sai.c.
+ */
+
+#ifndef _FSL_SAI_EDMA_H_
+#define _FSL_SAI_EDMA_H_
+
+#include "fsl_edma.h"
+#include "fsl_sai.h"
+
+typedef struct sai_edma_handle sai_edma_handle_t;
+
+typedef void (*sai_edma_callback_t)(I2S_Type *base, sai_edma_handle_t *handle, status_t status, void *userData);
+
+struct sai_edma_handle
+{
+    sai_edma_callback_t callback;
+    void *userData;
+};
+
+status_t SAI_TransferSendEDMA(I2S_Type *base, sai_edma_handle_t *handle, sai_transfer_t *xfer);
+void SAI_TransferTerminateSendEDMA(I2S_Type *base, sai_edma_handle_t *handle);
+status_t SAI_TransferReceiveEDMA(I2S_Type *base, sai_edma_handle_t *handle, sai_transfer_t *xfer);
+void SAI_TransferTerminateReceiveEDMA(I2S_Type *base, sai_edma_handle_t *handle);
+
+#endif /* _FSL_SAI_EDMA_H_ */
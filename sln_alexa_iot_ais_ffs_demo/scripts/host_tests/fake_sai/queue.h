@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for queue.h, a send or receive blocks the calling task of the
+ * simulated scheduler in sim_rtos.c.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct sim_queue *QueueHandle_t;
+
+#define errQUEUE_FULL ( ( BaseType_t ) 0 )
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+
+#define xQueueSendFromISR( q, item, woken ) xQueueSend( ( q ), ( item ), 0 )
+
+#endif /* QUEUE_H */
@@ -0,0 +1,25 @@
+/*
+ * Host stand-in for semphr.h, a take blocks the calling task of the simulated
+ * scheduler in sim_rtos.c. Mutexes are binary semaphores given once.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+typedef struct sim_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateBinary()        xSemaphoreCreateCounting(1, 0)
+#define xSemaphoreCreateMutex()         xSemaphoreCreateCounting(1, 1)
+#define xSemaphoreGiveFromISR( s, w )   xSemaphoreGive( s )
+#define xSemaphoreTakeFromISR( s, w )   xSemaphoreTake( s, 0 )
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,472 @@
+/*
+ * Simulated scheduler for the host checks, see sim_rtos.h.
+ *
+ * Each blocking call loops on a try function: when it fails, the task goes back
+ * to the scheduler and tries again once some other task ran or an interrupt
+ * fired. Called outside of the tasks, the blocking calls run the scheduler
+ * themselves.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "sim_rtos.h"
+
+#define SIM_MAX_TASKS  8
+#define SIM_MAX_IRQS   4
+#define SIM_STACK_SIZE (256 * 1024)
+
+struct sim_task
+{
+    ucontext_t ctx;
+    TaskFunction_t code;
+    void *params;
+    const char *name;
+    UBaseType_t priority;
+    uint64_t timeout_us; /* Deadline of the wait the task is blocked in */
+    bool started;
+};
+
+struct sim_event_group
+{
+    EventBits_t bits;
+};
+
+struct sim_semaphore
+{
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+struct sim_queue
+{
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct sim_queue_op
+{
+    QueueHandle_t queue;
+    void *item;
+};
+
+typedef bool (*sim_try_t)(void *arg);
+
+static struct sim_task *s_tasks[SIM_MAX_TASKS];
+static int s_task_count;
+static struct sim_task *s_current;
+static ucontext_t s_sched_ctx;
+
+static const sim_irq_t *s_irqs[SIM_MAX_IRQS];
+static int s_irq_count;
+
+static uint64_t s_now_us;
+static uint64_t s_progress; /* Bumped each time a task may have unblocked another one */
+static uint64_t s_wakeups;
+
+#define SIM_FAIL(...)                               \
+    do {                                            \
+        printf("sim rtos: ");                       \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+void *pvPortMalloc(size_t size)
+{
+    return malloc(size);
+}
+
+void vPortFree(void *ptr)
+{
+    free(ptr);
+}
+
+uint64_t sim_now_us(void)
+{
+    return s_now_us;
+}
+
+uint64_t sim_wakeups(void)
+{
+    return s_wakeups;
+}
+
+void sim_add_irq(const sim_irq_t *irq)
+{
+    if (s_irq_count == SIM_MAX_IRQS) {
+        SIM_FAIL("too many interrupt sources");
+    }
+    s_irqs[s_irq_count++] = irq;
+}
+
+static void sim_task_entry(void)
+{
+    s_current->code(s_current->params);
+    SIM_FAIL("task %s returned", s_current->name);
+}
+
+/* Runs the tasks until they are all blocked. Returns true when any of them ran */
+static bool sim_run_tasks(void)
+{
+    uint64_t start = s_progress;
+    uint64_t before;
+    bool again = true;
+
+    while (again) {
+        again = false;
+        for (UBaseType_t prio = configMAX_PRIORITIES; prio-- > 0 && !again;) {
+            for (int i = 0; i < s_task_count && !again; i++) {
+                struct sim_task *task = s_tasks[i];
+
+                if (task->priority != prio) {
+                    continue;
+                }
+                before = s_progress;
+                s_current = task;
+                swapcontext(&s_sched_ctx, &task->ctx);
+                s_current = NULL;
+                /* Something may have been unblocked: start over from the highest priority */
+                again = (s_progress != before) || !task->started;
+                task->started = true;
+            }
+        }
+    }
+    return s_progress != start;
+}
+
+/* Runs the tasks. When they were all blocked already, fires the next interrupts
+ * or timeouts up to the limit and runs the tasks again: the caller outside of
+ * the tasks has the lowest priority. Returns false when nothing is left to
+ * happen before the limit */
+static bool sim_step(uint64_t limit_us)
+{
+    uint64_t next_us = UINT64_MAX;
+
+    if (sim_run_tasks()) {
+        return true;
+    }
+
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i]->timeout_us < next_us) {
+            next_us = s_tasks[i]->timeout_us;
+        }
+    }
+    for (int i = 0; i < s_irq_count; i++) {
+        uint64_t irq_us = s_irqs[i]->next_us();
+
+        if (irq_us < next_us) {
+            next_us = irq_us;
+        }
+    }
+    if (next_us < s_now_us) {
+        next_us = s_now_us;
+    }
+    if (next_us == UINT64_MAX || next_us > limit_us) {
+        if (limit_us == UINT64_MAX) {
+            return false;
+        }
+        s_now_us = limit_us;
+        return true;
+    }
+
+    s_now_us = next_us;
+    for (int i = 0; i < s_irq_count; i++) {
+        if (s_irqs[i]->next_us() <= s_now_us) {
+            s_irqs[i]->fire();
+        }
+    }
+    sim_run_tasks();
+    return true;
+}
+
+/* Blocks until try() succeeds or the ticks ran out */
+static bool sim_block(sim_try_t try, void *arg, TickType_t ticks)
+{
+    uint64_t timeout_us = (ticks == portMAX_DELAY) ? UINT64_MAX : s_now_us + (uint64_t)ticks * 1000;
+    bool blocked = false;
+
+    while (!try(arg)) {
+        if (s_now_us >= timeout_us) {
+            s_progress++;
+            s_wakeups += blocked;
+            return false;
+        }
+        blocked = true;
+        if (s_current != NULL) {
+            struct sim_task *task = s_current;
+
+            task->timeout_us = timeout_us;
+            swapcontext(&task->ctx, &s_sched_ctx);
+            task->timeout_us = UINT64_MAX;
+        } else if (!sim_step(timeout_us)) {
+            SIM_FAIL("deadlock at %llu us, every task waits forever", (unsigned long long)s_now_us);
+        }
+    }
+    s_progress++;
+    s_wakeups += blocked;
+    return true;
+}
+
+static bool sim_try_never(void *arg)
+{
+    return false;
+}
+
+void sim_run(uint32_t ms)
+{
+    uint64_t until_us = s_now_us + (uint64_t)ms * 1000;
+
+    while (s_now_us < until_us) {
+        if (!sim_step(until_us)) {
+            break;
+        }
+    }
+}
+
+void sim_run_until(bool (*ready)(void *arg), void *arg, uint32_t ms)
+{
+    if (!sim_block(ready, arg, ms)) {
+        SIM_FAIL("condition not met within %u ms", ms);
+    }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    struct sim_task *task;
+
+    if (s_task_count == SIM_MAX_TASKS) {
+        return pdFAIL;
+    }
+    task = calloc(1, sizeof(*task));
+    task->code = code;
+    task->params = params;
+    task->name = name;
+    task->priority = priority;
+    task->timeout_us = UINT64_MAX;
+    getcontext(&task->ctx);
+    task->ctx.uc_stack.ss_sp = malloc(SIM_STACK_SIZE);
+    task->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+    task->ctx.uc_link = NULL;
+    makecontext(&task->ctx, sim_task_entry, 0);
+
+    s_tasks[s_task_count++] = task;
+    if (created != NULL) {
+        *created = task;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / 1000);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sim_block(sim_try_never, NULL, ticks);
+}
+
+/* The task is dropped from the scheduler, its stack is kept: it may be the one
+ * running this */
+void vTaskDelete(TaskHandle_t task)
+{
+    int i;
+
+    if (task == NULL) {
+        task = s_current;
+    }
+    for (i = 0; i < s_task_count && s_tasks[i] != task; i++) {
+    }
+    if (i == s_task_count) {
+        SIM_FAIL("deleted task not found");
+    }
+    memmove(&s_tasks[i], &s_tasks[i + 1], (size_t)(s_task_count - i - 1) * sizeof(s_tasks[0]));
+    s_task_count--;
+    s_progress++;
+
+    if (task == s_current) {
+        setcontext(&s_sched_ctx);
+    }
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+struct sim_event_wait
+{
+    EventGroupHandle_t group;
+    EventBits_t bits;
+    BaseType_t clear;
+    BaseType_t all;
+    EventBits_t seen;
+};
+
+static bool sim_try_event(void *arg)
+{
+    struct sim_event_wait *wait = arg;
+    EventBits_t set = wait->group->bits & wait->bits;
+
+    wait->seen = wait->group->bits;
+    if (wait->all ? (set != wait->bits) : (set == 0)) {
+        return false;
+    }
+    if (wait->clear) {
+        wait->group->bits &= ~wait->bits;
+    }
+    return true;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear, BaseType_t all,
+                                TickType_t ticks)
+{
+    struct sim_event_wait wait = { group, bits, clear, all, 0 };
+
+    sim_block(sim_try_event, &wait, ticks);
+    return wait.seen;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    s_progress++;
+    return group->bits |= bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t before = group->bits;
+
+    group->bits &= ~bits;
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+
+    sem->max = max;
+    sem->count = initial;
+    return sem;
+}
+
+static bool sim_try_take(void *arg)
+{
+    SemaphoreHandle_t sem = arg;
+
+    if (sem->count == 0) {
+        return false;
+    }
+    sem->count--;
+    return true;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    return sim_block(sim_try_take, sem, ticks) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count == sem->max) {
+        return pdFALSE;
+    }
+    sem->count++;
+    s_progress++;
+    return pdTRUE;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem)
+{
+    return sem->count;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+
+    queue->items = calloc(length, itemSize ? itemSize : 1);
+    queue->length = length;
+    queue->item_size = itemSize;
+    return queue;
+}
+
+static bool sim_try_send(void *arg)
+{
+    struct sim_queue_op *op = arg;
+    QueueHandle_t queue = op->queue;
+
+    if (queue->count == queue->length) {
+        return false;
+    }
+    memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], op->item,
+           queue->item_size);
+    queue->count++;
+    return true;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct sim_queue_op op = { queue, (void *)item };
+
+    return sim_block(sim_try_send, &op, ticks) ? pdTRUE : errQUEUE_FULL;
+}
+
+static bool sim_try_receive(void *arg)
+{
+    struct sim_queue_op *op = arg;
+    QueueHandle_t queue = op->queue;
+
+    if (queue->count == 0) {
+        return false;
+    }
+    memcpy(op->item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    return true;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct sim_queue_op op = { queue, item };
+
+    return sim_block(sim_try_receive, &op, ticks) ? pdTRUE : pdFALSE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    free(queue->items);
+    free(queue);
+}
@@ -0,0 +1,40 @@
+/*
+ * Simulated scheduler for the host checks: FreeRTOS tasks run as coroutines
+ * on a virtual clock, one at a time, the highest priority ready one first.
+ * A task only gives the CPU back when it blocks. When every task is blocked the
+ * clock jumps to the next interrupt or timeout, so a run is the same on every
+ * host and takes no real time.
+ *
+ * The check itself runs outside the tasks. When it blocks, or calls
+ * sim_run(), the tasks run in the meantime.
+ */
+
+#ifndef SIM_RTOS_H
+#define SIM_RTOS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*! @brief Interrupt source: when it fires next, UINT64_MAX for never, and its handler */
+typedef struct sim_irq
+{
+    uint64_t (*next_us)(void);
+    void (*fire)(void);
+} sim_irq_t;
+
+/* Current virtual time */
+uint64_t sim_now_us(void);
+
+/* Registers an interrupt source, handlers are run outside of the tasks */
+void sim_add_irq(const sim_irq_t *irq);
+
+/* Runs the tasks and interrupts for the given time */
+void sim_run(uint32_t ms);
+
+/* Runs the tasks and interrupts until ready() returns true, fails after the given time */
+void sim_run_until(bool (*ready)(void *arg), void *arg, uint32_t ms);
+
+/* Number of times a blocked task was woken up, by its wait being satisfied or timing out */
+uint64_t sim_wakeups(void);
+
+#endif /* SIM_RTOS_H */
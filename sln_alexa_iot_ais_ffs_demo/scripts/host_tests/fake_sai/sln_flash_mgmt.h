@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for sln_flash_mgmt.h, nothing of it is used.
+ */
+
+#ifndef _SLN_FLASH_MGMT_H_
+#define _SLN_FLASH_MGMT_H_
+
+#include "fsl_common.h"
+
+#endif /* _SLN_FLASH_MGMT_H_ */
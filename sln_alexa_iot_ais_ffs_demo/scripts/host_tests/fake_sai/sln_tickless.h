@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for sln_tickless.h, the check linking the module implements
+ * SLN_TICKLESS_PeriodicIrqDone().
+ */
+
+#ifndef SLN_TICKLESS_H_
+#define SLN_TICKLESS_H_
+
+#include <stdint.h>
+
+typedef enum _sln_tickless_periodic
+{
+    kSLN_TICKLESS_Microphones,
+    kSLN_TICKLESS_Amplifier,
+    kSLN_TICKLESS_PeriodicCount,
+} sln_tickless_periodic_t;
+
+void SLN_TICKLESS_PeriodicIrqDone(sln_tickless_periodic_t source, uint32_t periodUs);
+
+#endif /* SLN_TICKLESS_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Host stand-in for task.h, the tasks run on the simulated scheduler of
+ * sim_rtos.c.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct
+{
+    uint8_t unused;
+} StaticTask_t;
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task);
+
+/* The stack and task buffers are not used, the simulated task has its own */
+static inline TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stackDepth, void *params,
+                                             UBaseType_t priority, StackType_t *stack, StaticTask_t *buffer)
+{
+    TaskHandle_t created = NULL;
+
+    xTaskCreate(code, name, stackDepth, params, priority, &created);
+    return created;
+}
+
+#endif /* INC_TASK_H */
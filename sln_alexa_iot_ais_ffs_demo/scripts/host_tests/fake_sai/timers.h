@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for timers.h, nothing of it is used.
+ */
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+
+#endif /* TIMERS_H */
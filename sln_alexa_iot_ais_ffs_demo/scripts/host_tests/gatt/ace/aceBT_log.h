@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for ace/aceBT_log.h, the logs are dropped.
+ */
+
+#ifndef ACE_BT_LOG_H
+#define ACE_BT_LOG_H
+
+#define BT_LOGI(...)
+#define BT_LOGE(...)
+
+#endif /* ACE_BT_LOG_H */
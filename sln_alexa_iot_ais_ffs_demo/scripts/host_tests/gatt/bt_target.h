@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for bt_target.h, nothing of it is used by bt_hal_gatt.c.
+ */
+
+#ifndef BT_TARGET_H
+#define BT_TARGET_H
+
+#endif /* BT_TARGET_H */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for fsl_debug_console.h, nothing of it is used by bt_hal_gatt.c.
+ */
+
+#ifndef FSL_DEBUG_CONSOLE_H
+#define FSL_DEBUG_CONSOLE_H
+
+#endif /* FSL_DEBUG_CONSOLE_H */
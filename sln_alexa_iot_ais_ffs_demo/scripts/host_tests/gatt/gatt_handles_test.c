@@ -0,0 +1,220 @@
+/*
+ * Host benchmark of the GATT handle translations of bt_hall_gatt_helpers.c.
+ *
+ * Builds the real helpers with a database large enough for all the generated
+ * handles: services, then characteristics with zero to two descriptors, until
+ * the 256 generated handles are used. The value handles the characteristics
+ * got are kept in a list, the way the helpers kept them before the bitmap.
+ *  - every handle, static or generated, translates as the list says;
+ *  - a stream of requests is dispatched the way bt_hal_gatt.c does it: the
+ *    value handle of a read or write is turned into the characteristic
+ *    handle for ACS, the characteristic handle of a response or notification
+ *    into the value handle. Timed through the bitmap and through a scan of
+ *    the list, the bitmap has to be the faster one.
+ *
+ * Build and run with "make -C scripts/host_tests gatt_handles".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "wiced_bt_gatt.h"
+#include "bt_hall_gatt_helpers.h"
+
+#define TEST_REQUESTS 2000000
+#define TEST_ROUNDS   5
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("gatt handles: ");       \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+/* Value handles in the order they were generated, as in the list the bitmap replaced */
+static uint16_t s_valueHandles[GENERATED_HANDLE_NUM];
+static uint32_t s_valueHandleNum;
+
+/* Characteristic handles, what the requests are about */
+static uint16_t s_charHandles[GENERATED_HANDLE_NUM];
+static uint32_t s_charNum;
+
+static volatile uint32_t s_sink;
+
+extern handle_value_database_t handle_values;
+
+static uint64_t now_ns(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((uint64_t)time.tv_sec * 1000000000ULL) + (uint64_t)time.tv_nsec;
+}
+
+static uint16_t scan_characteristic_handle(uint16_t handle)
+{
+    for (uint32_t i = 0; i < s_valueHandleNum; i++)
+    {
+        if (s_valueHandles[i] == handle)
+        {
+            return handle - 1;
+        }
+    }
+    return handle;
+}
+
+static uint16_t scan_value_handle(uint16_t handle)
+{
+    for (uint32_t i = 0; i < s_valueHandleNum; i++)
+    {
+        if (s_valueHandles[i] == (uint16_t)(handle + 1))
+        {
+            return handle + 1;
+        }
+    }
+    return handle;
+}
+
+static void add_characteristic(uint32_t n)
+{
+    uint16_t handle = 0;
+    uint8_t uuid128[UUID128SIZE];
+    uint8_t status;
+
+    memset(uuid128, (int)n, sizeof(uuid128));
+    if (n % 3 == 0)
+    {
+        status = add_characteristic128(&handle, uuid128, 0x1A, LEGATTDB_PERM_READABLE);
+    }
+    else
+    {
+        status = add_characteristic16_writable(&handle, 0x2A00 + n, 0x0A,
+                                               LEGATTDB_PERM_READABLE | LEGATTDB_PERM_WRITE_REQ);
+    }
+    if (status != WICED_BT_GATT_SUCCESS)
+    {
+        FAIL("characteristic %u not added: 0x%x", n, status);
+    }
+    s_charHandles[s_charNum++] = handle;
+    s_valueHandles[s_valueHandleNum++] = handle + 1;
+
+    for (uint32_t i = 0; i < n % 3; i++)
+    {
+        uint16_t descriptor = 0;
+
+        status = (i == 0) ? add_char_descriptor16_writable(&descriptor, 0x2902, LEGATTDB_PERM_READABLE)
+                          : add_char_descriptor128(&descriptor, uuid128, LEGATTDB_PERM_READABLE);
+        if (status != WICED_BT_GATT_SUCCESS)
+        {
+            FAIL("descriptor %u of characteristic %u not added: 0x%x", i, n, status);
+        }
+    }
+}
+
+static void build_database(void)
+{
+    uint8_t service128[UUID128SIZE] = {0};
+    uint16_t handle;
+    uint32_t used = 0;
+
+    init_gatt_database();
+    /* a service, a characteristic and two descriptors at most per step */
+    for (uint32_t n = 0; used + 5 <= GENERATED_HANDLE_NUM; n++)
+    {
+        if (n % 16 == 0)
+        {
+            handle = 0;
+            if (add_service_128(&handle, service128, WICED_TRUE) != WICED_BT_GATT_SUCCESS)
+            {
+                FAIL("service %u not added", n / 16);
+            }
+            used++;
+        }
+        add_characteristic(n);
+        used += 2 + n % 3;
+    }
+}
+
+static void check_translations(void)
+{
+    for (uint32_t handle = 0; handle < 0x300; handle++)
+    {
+        uint16_t characteristic = get_characteristic_handle(handle);
+        uint16_t value = get_value_handle(handle);
+
+        if (characteristic != scan_characteristic_handle(handle))
+        {
+            FAIL("characteristic handle of 0x%x is 0x%x, 0x%x expected", handle, characteristic,
+                 scan_characteristic_handle(handle));
+        }
+        if (value != scan_value_handle(handle))
+        {
+            FAIL("value handle of 0x%x is 0x%x, 0x%x expected", handle, value, scan_value_handle(handle));
+        }
+    }
+}
+
+/* Read and write requests carry value handles, half of the stream, the responses characteristic handles */
+static uint64_t dispatch(const uint16_t *requests, int scan)
+{
+    uint64_t start = now_ns();
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < TEST_REQUESTS; i++)
+    {
+        uint16_t handle = requests[i];
+
+        if (i & 1)
+        {
+            sum += scan ? scan_characteristic_handle(handle + 1) : get_characteristic_handle(handle + 1);
+        }
+        else
+        {
+            sum += scan ? scan_value_handle(handle) : get_value_handle(handle);
+        }
+    }
+    s_sink = sum;
+    return now_ns() - start;
+}
+
+int main(void)
+{
+    static uint16_t requests[TEST_REQUESTS];
+    uint64_t bitmapNs = UINT64_MAX;
+    uint64_t scanNs = UINT64_MAX;
+
+    build_database();
+    if (handle_values.size != s_valueHandleNum)
+    {
+        FAIL("%u value handles counted, %u generated", handle_values.size, s_valueHandleNum);
+    }
+    check_translations();
+
+    srand(44);
+    for (uint32_t i = 0; i < TEST_REQUESTS; i++)
+    {
+        requests[i] = s_charHandles[rand() % s_charNum];
+    }
+    for (int round = 0; round < TEST_ROUNDS; round++)
+    {
+        uint64_t ns = dispatch(requests, 0);
+
+        bitmapNs = (ns < bitmapNs) ? ns : bitmapNs;
+        ns = dispatch(requests, 1);
+        scanNs = (ns < scanNs) ? ns : scanNs;
+    }
+    if (bitmapNs >= scanNs)
+    {
+        FAIL("bitmap %llu ns, scan %llu ns for %u translations", (unsigned long long)bitmapNs,
+             (unsigned long long)scanNs, TEST_REQUESTS);
+    }
+
+    printf("gatt handles: %u characteristics in a %u byte database, %.1f ns per translation "
+           "(%.1f ns scanning the value handles)\n",
+           s_charNum, get_datebase_size(), (double)bitmapNs / TEST_REQUESTS, (double)scanNs / TEST_REQUESTS);
+    return 0;
+}
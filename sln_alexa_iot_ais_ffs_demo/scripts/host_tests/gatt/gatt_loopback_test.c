@@ -0,0 +1,700 @@
+/*
+ * Host loopback check of the GATT server of bt_hal_gatt.c.
+ *
+ * Builds the real bt_hal_gatt.c and bt_hall_gatt_helpers.c on a fake stack:
+ * the wiced_bt_gatt calls of the server are recorded, the test plays the
+ * client by calling the server callback with the events the stack would
+ * send, and the callbacks of the ACS layer record what reaches it. The link
+ * has a few transmit buffers, drained once per connection event, a full link
+ * reports congestion.
+ *  - the MTU is asked for on connection and reported to the ACS layer;
+ *  - read and write requests reach the ACS layer on the characteristic
+ *    handle, responses leave on the value handle;
+ *  - a 512 byte prepared write reaches the ACS layer once, whole;
+ *  - after a rejected chunk, the first one or a later one, no chunk is
+ *    queued and the execute write is rejected without reaching the ACS layer;
+ *  - an indication is reported sent on the confirmation of the client, or as
+ *    failed on disconnection;
+ *  - with the notification path opted into, a stream of indications goes out
+ *    as notifications through the congestion of the link, faster than the
+ *    confirmed stream, and a link congested for good fails the value.
+ *
+ * Build and run with "make -C scripts/host_tests gatt_loopback".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ace/bt_hal_manager.h>
+#include <ace/bt_hal_gatt_server.h>
+#include "wiced_bt_gatt.h"
+#include "wiced_bt_cfg.h"
+#include "wiced_rtos.h"
+#include "bt_hall_gatt_helpers.h"
+
+#define TEST_CONN_ID            5
+#define TEST_MAX_MTU            247
+#define TEST_CLIENT_MTU         185
+#define TEST_CONN_INTERVAL_MS   15
+#define TEST_TX_BUFFERS         4
+#define TEST_LOG_SIZE           256
+#define TEST_MAX_VALUE          512
+#define TEST_STREAM_VALUES      100
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("gatt loopback: ");      \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+typedef enum
+{
+    PACKET_NOTIFICATION,
+    PACKET_INDICATION,
+    PACKET_RESPONSE,
+} packet_type_t;
+
+typedef struct
+{
+    packet_type_t type;
+    uint16_t connId;
+    uint16_t handle;
+    uint16_t len;
+    uint8_t status;
+    uint8_t value[TEST_MAX_VALUE];
+} packet_t;
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t execWrites;
+    uint32_t indicationsSent;
+    uint32_t indicationsFailed;
+    uint32_t connections;
+    uint16_t mtu;
+    uint16_t handle;
+    uint16_t offset;
+    size_t len;
+    bool needRsp;
+    bool execWrite;
+    uint8_t value[TEST_MAX_VALUE];
+} acs_log_t;
+
+wiced_bt_cfg_settings_t wiced_bt_cfg_settings = {.gatt_cfg = {.max_mtu_size = TEST_MAX_MTU}};
+
+const void *prvBTGetGattServerInterface();
+
+/* Fake stack */
+static wiced_bt_gatt_cback_t *s_gattCallback;
+static packet_t s_packets[TEST_LOG_SIZE];
+static uint32_t s_packetNum;
+static uint16_t s_mtuAsked;
+static uint32_t s_nowMs;
+static uint32_t s_events;
+static uint32_t s_txQueued;
+static uint32_t s_congestedReplies;
+static uint32_t s_forceCongested;
+static uint32_t s_delays;
+static wiced_bool_t s_indicationOutstanding;
+
+/* ACS layer */
+static acs_log_t s_acs;
+static const BTGattServerInterface_t *s_server;
+static uint16_t s_charHandle;
+static uint16_t s_serviceHandle;
+
+static void run_link(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        s_nowMs++;
+        if (s_nowMs % TEST_CONN_INTERVAL_MS == 0)
+        {
+            s_txQueued = (s_txQueued > TEST_TX_BUFFERS) ? s_txQueued - TEST_TX_BUFFERS : 0;
+            s_events++;
+        }
+    }
+}
+
+static void wait_events(uint32_t events)
+{
+    uint32_t target = s_events + events;
+
+    while (s_events < target)
+    {
+        run_link(1);
+    }
+}
+
+static packet_t *log_packet(packet_type_t type, uint16_t connId, uint16_t handle, uint16_t len, const uint8_t *value)
+{
+    packet_t *packet;
+
+    if (s_packetNum == TEST_LOG_SIZE)
+    {
+        FAIL("more than %u packets sent", TEST_LOG_SIZE);
+    }
+    if (len > TEST_MAX_VALUE)
+    {
+        FAIL("packet of %u bytes sent", len);
+    }
+    packet = &s_packets[s_packetNum++];
+    packet->type = type;
+    packet->connId = connId;
+    packet->handle = handle;
+    packet->len = len;
+    if (len > 0)
+    {
+        memcpy(packet->value, value, len);
+    }
+    return packet;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_register(wiced_bt_gatt_cback_t *p_gatt_cback)
+{
+    s_gattCallback = p_gatt_cback;
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_db_init(const uint8_t *p_gatt_db, uint16_t gatt_db_size)
+{
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_send_notification(uint16_t conn_id, uint16_t attr_handle, uint16_t val_len,
+                                                       uint8_t *p_val)
+{
+    if ((s_forceCongested > 0) || (s_txQueued == TEST_TX_BUFFERS))
+    {
+        s_forceCongested -= (s_forceCongested > 0) ? 1 : 0;
+        s_congestedReplies++;
+        return WICED_BT_GATT_CONGESTED;
+    }
+    s_txQueued++;
+    log_packet(PACKET_NOTIFICATION, conn_id, attr_handle, val_len, p_val);
+    return WICED_BT_GATT_SUCCESS;
+}
+
+/* The ATT protocol allows a single indication waiting for its confirmation */
+wiced_bt_gatt_status_t wiced_bt_gatt_send_indication(uint16_t conn_id, uint16_t attr_handle, uint16_t val_len,
+                                                     uint8_t *p_val)
+{
+    if (s_indicationOutstanding == WICED_TRUE)
+    {
+        return WICED_BT_GATT_BUSY;
+    }
+    s_indicationOutstanding = WICED_TRUE;
+    s_txQueued++;
+    log_packet(PACKET_INDICATION, conn_id, attr_handle, val_len, p_val);
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_send_response(wiced_bt_gatt_status_t status, uint16_t conn_id,
+                                                   uint16_t attr_handle, uint16_t attr_len, uint16_t offset,
+                                                   uint8_t *p_attr)
+{
+    log_packet(PACKET_RESPONSE, conn_id, attr_handle, attr_len, p_attr)->status = status;
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_configure_mtu(uint16_t conn_id, uint16_t mtu)
+{
+    if (conn_id != TEST_CONN_ID)
+    {
+        FAIL("MTU asked for on connection %u", conn_id);
+    }
+    s_mtuAsked = mtu;
+    return WICED_BT_GATT_SUCCESS;
+}
+
+wiced_bt_gatt_status_t wiced_bt_gatt_send_write(uint16_t conn_id, wiced_bt_gatt_write_type_t type,
+                                                wiced_bt_gatt_value_t *p_write)
+{
+    return WICED_BT_GATT_SUCCESS;
+}
+
+void wiced_rtos_delay_milliseconds(uint32_t milliseconds)
+{
+    s_delays++;
+    run_link(milliseconds);
+}
+
+static void acs_connection(uint16_t usConnId, uint8_t ucServerIf, bool bConnected, BTBdaddr_t *pxBda)
+{
+    s_acs.connections++;
+}
+
+static void acs_characteristic_added(BTStatus_t xStatus, uint8_t ucServerIf, BTUuid_t *pxUuid,
+                                     uint16_t usServiceHandle, uint16_t usHandle)
+{
+    s_charHandle = usHandle;
+}
+
+static void acs_service_added(BTStatus_t xStatus, uint8_t ucServerIf, BTGattSrvcId_t *pxSrvcId,
+                              uint16_t usServiceHandle)
+{
+    s_serviceHandle = usServiceHandle;
+}
+
+static void acs_read(uint16_t usConnId, uint32_t ulTransId, BTBdaddr_t *pxBda, uint16_t usAttrHandle,
+                     uint16_t usOffset)
+{
+    s_acs.reads++;
+    s_acs.handle = usAttrHandle;
+    s_acs.offset = usOffset;
+}
+
+static void acs_write(uint16_t usConnId, uint32_t ulTransId, BTBdaddr_t *pxBda, uint16_t usAttrHandle,
+                      uint16_t usOffset, size_t xLength, bool bNeedRsp, bool bIsPrep, uint8_t *pucValue)
+{
+    if (xLength > TEST_MAX_VALUE)
+    {
+        FAIL("write of %zu bytes reached the ACS layer", xLength);
+    }
+    s_acs.writes++;
+    s_acs.handle = usAttrHandle;
+    s_acs.offset = usOffset;
+    s_acs.len = xLength;
+    s_acs.needRsp = bNeedRsp;
+    memcpy(s_acs.value, pucValue, xLength);
+}
+
+static void acs_exec_write(uint16_t usConnId, uint32_t ulTransId, BTBdaddr_t *pxBda, bool bExecWrite)
+{
+    s_acs.execWrites++;
+    s_acs.execWrite = bExecWrite;
+}
+
+static void acs_indication_sent(uint16_t usConnId, BTStatus_t xStatus)
+{
+    if (xStatus == eBTStatusSuccess)
+    {
+        s_acs.indicationsSent++;
+    }
+    else
+    {
+        s_acs.indicationsFailed++;
+    }
+}
+
+static void acs_mtu_changed(uint16_t usConnId, uint16_t usMtu)
+{
+    s_acs.mtu = usMtu;
+}
+
+static const BTGattServerCallbacks_t s_acsCallbacks = {
+    .pxConnectionCb = acs_connection,
+    .pxServiceAddedCb = acs_service_added,
+    .pxCharacteristicAddedCb = acs_characteristic_added,
+    .pxRequestReadCb = acs_read,
+    .pxRequestWriteCb = acs_write,
+    .pxRequestExecWriteCb = acs_exec_write,
+    .pxIndicationSentCb = acs_indication_sent,
+    .pxMtuChangedCb = acs_mtu_changed,
+};
+
+static wiced_bt_gatt_status_t client_connection(wiced_bool_t connected)
+{
+    static uint8_t address[6] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    wiced_bt_gatt_event_data_t event = {0};
+
+    event.connection_status.bd_addr = address;
+    event.connection_status.conn_id = TEST_CONN_ID;
+    event.connection_status.connected = connected;
+    return s_gattCallback(GATT_CONNECTION_STATUS_EVT, &event);
+}
+
+static wiced_bt_gatt_status_t client_request(wiced_bt_gatt_request_type_t type, wiced_bt_gatt_request_data_t *data)
+{
+    wiced_bt_gatt_event_data_t event = {0};
+
+    event.attribute_request.conn_id = TEST_CONN_ID;
+    event.attribute_request.request_type = type;
+    if (data != NULL)
+    {
+        event.attribute_request.data = *data;
+    }
+    return s_gattCallback(GATT_ATTRIBUTE_REQUEST_EVT, &event);
+}
+
+static wiced_bt_gatt_status_t client_prepare_write(uint16_t handle, uint16_t offset, uint16_t len, uint8_t *value)
+{
+    wiced_bt_gatt_request_data_t data = {0};
+
+    data.write_req.handle = handle;
+    data.write_req.is_prep = WICED_TRUE;
+    data.write_req.offset = offset;
+    data.write_req.val_len = len;
+    data.write_req.p_val = value;
+    return client_request(GATTS_REQ_TYPE_PREP_WRITE, &data);
+}
+
+static wiced_bt_gatt_status_t client_execute_write(wiced_bt_gatt_exec_flag_t flag)
+{
+    wiced_bt_gatt_request_data_t data = {0};
+
+    data.exec_write = flag;
+    return client_request(GATTS_REQ_TYPE_WRITE_EXEC, &data);
+}
+
+static void client_confirm(uint16_t handle)
+{
+    wiced_bt_gatt_request_data_t data = {0};
+
+    data.handle = handle;
+    s_indicationOutstanding = WICED_FALSE;
+    client_request(GATTS_REQ_TYPE_CONF, &data);
+}
+
+static void fill_value(uint8_t *value, uint32_t len, uint32_t seed)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        value[i] = (uint8_t)(seed * 13 + i * 7);
+    }
+}
+
+static void build_server(void)
+{
+    BTUuid_t uuid = {.ucType = eBTuuidType128};
+    BTGattSrvcId_t service = {.xServiceType = eBTServiceTypePrimary};
+
+    s_server = prvBTGetGattServerInterface();
+    if (s_server->pxGattServerInit(&s_acsCallbacks) != eBTStatusSuccess ||
+        s_server->pxRegisterServer(&uuid) != eBTStatusSuccess || s_gattCallback == NULL)
+    {
+        FAIL("server not registered");
+    }
+
+    service.xId.xUuid.ucType = eBTuuidType16;
+    service.xId.xUuid.uu.uu16 = 0xFE03;
+    memset(uuid.uu.uu128, 0x5A, sizeof(uuid.uu.uu128));
+    if (s_server->pxAddService(0, &service, 8) != eBTStatusSuccess ||
+        s_server->pxAddCharacteristic(0, s_serviceHandle, &uuid, eBTPropRead | eBTPropWrite | eBTPropNotify,
+                                      eBTPermRead | eBTPermWrite) != eBTStatusSuccess ||
+        s_server->pxStartService(0, s_serviceHandle, BTTransportLe) != eBTStatusSuccess)
+    {
+        FAIL("service not added");
+    }
+    if (get_value_handle(s_charHandle) != s_charHandle + 1)
+    {
+        FAIL("characteristic 0x%x has no value handle", s_charHandle);
+    }
+}
+
+static void connection_checks(void)
+{
+    wiced_bt_gatt_event_data_t event = {0};
+
+    if (client_connection(WICED_TRUE) != WICED_BT_GATT_SUCCESS || s_acs.connections != 1)
+    {
+        FAIL("connection not reported");
+    }
+    if (s_mtuAsked != TEST_MAX_MTU || get_negotiated_mtu() != GATT_DEF_BLE_MTU_SIZE)
+    {
+        FAIL("MTU %u asked for on connection, %u in use", s_mtuAsked, get_negotiated_mtu());
+    }
+
+    event.operation_complete.conn_id = TEST_CONN_ID;
+    event.operation_complete.op = GATTC_OPTYPE_CONFIG;
+    event.operation_complete.status = WICED_BT_GATT_SUCCESS;
+    event.operation_complete.response_data.mtu = TEST_CLIENT_MTU;
+    s_gattCallback(GATT_OPERATION_CPLT_EVT, &event);
+    if (get_negotiated_mtu() != TEST_CLIENT_MTU || s_acs.mtu != TEST_CLIENT_MTU)
+    {
+        FAIL("MTU %u in use after the exchange, %u reported", get_negotiated_mtu(), s_acs.mtu);
+    }
+}
+
+static void request_checks(void)
+{
+    uint16_t valueHandle = s_charHandle + 1;
+    wiced_bt_gatt_request_data_t data = {0};
+    uint8_t value[20];
+    BTGattResponse_t response = {0};
+
+    data.read_req.handle = valueHandle;
+    data.read_req.offset = 3;
+    if (client_request(GATTS_REQ_TYPE_READ, &data) != WICED_BT_GATT_PENDING || s_acs.reads != 1 ||
+        s_acs.handle != s_charHandle || s_acs.offset != 3)
+    {
+        FAIL("read of 0x%x reached the ACS layer on 0x%x", valueHandle, s_acs.handle);
+    }
+
+    fill_value(value, sizeof(value), 1);
+    response.xAttrValue.usHandle = s_charHandle;
+    response.xAttrValue.pucValue = value;
+    response.xAttrValue.xLen = sizeof(value);
+    s_packetNum = 0;
+    s_server->pxSendResponse(TEST_CONN_ID, 0, eBTStatusSuccess, &response);
+    if (s_packetNum != 1 || s_packets[0].type != PACKET_RESPONSE || s_packets[0].handle != valueHandle ||
+        s_packets[0].len != sizeof(value) || memcmp(s_packets[0].value, value, sizeof(value)) != 0)
+    {
+        FAIL("response to the read not sent on 0x%x", valueHandle);
+    }
+
+    memset(&data, 0, sizeof(data));
+    data.write_req.handle = valueHandle;
+    data.write_req.val_len = sizeof(value);
+    data.write_req.p_val = value;
+    if (client_request(GATTS_REQ_TYPE_WRITE, &data) != WICED_BT_GATT_PENDING || s_acs.writes != 1 ||
+        s_acs.handle != s_charHandle || s_acs.len != sizeof(value) || s_acs.needRsp != true ||
+        memcmp(s_acs.value, value, sizeof(value)) != 0)
+    {
+        FAIL("write of 0x%x reached the ACS layer on 0x%x", valueHandle, s_acs.handle);
+    }
+}
+
+/* Chunks of the MTU less the 5 bytes of the prepare write header */
+static uint32_t prepare_write(uint8_t *value, uint32_t len)
+{
+    uint32_t chunk = get_negotiated_mtu() - 5;
+    uint32_t chunks = 0;
+
+    for (uint32_t offset = 0; offset < len; offset += chunk, chunks++)
+    {
+        uint32_t size = (len - offset < chunk) ? len - offset : chunk;
+
+        if (client_prepare_write(s_charHandle + 1, offset, size, value + offset) != WICED_BT_GATT_SUCCESS)
+        {
+            FAIL("chunk at %u of a %u byte write rejected", offset, len);
+        }
+    }
+    return chunks;
+}
+
+static void prepared_write_checks(void)
+{
+    static uint8_t value[TEST_MAX_VALUE + 100];
+    uint16_t valueHandle = s_charHandle + 1;
+    uint32_t writes = s_acs.writes;
+    uint32_t execWrites = s_acs.execWrites;
+    uint32_t chunks;
+
+    /* a whole value, one write for the ACS layer */
+    fill_value(value, TEST_MAX_VALUE, 2);
+    chunks = prepare_write(value, TEST_MAX_VALUE);
+    if (s_acs.writes != writes)
+    {
+        FAIL("chunk of a prepared write reached the ACS layer");
+    }
+    if (client_execute_write(GATT_PREP_WRITE_EXEC) != WICED_BT_GATT_SUCCESS || s_acs.writes != writes + 1 ||
+        s_acs.handle != s_charHandle || s_acs.offset != 0 || s_acs.len != TEST_MAX_VALUE ||
+        s_acs.needRsp != false || memcmp(s_acs.value, value, TEST_MAX_VALUE) != 0)
+    {
+        FAIL("%u chunks of a prepared write not written whole", chunks);
+    }
+    writes++;
+
+    /* a chunk out of place, the chunks after it and the execute write are rejected */
+    fill_value(value, TEST_MAX_VALUE, 3);
+    if (client_prepare_write(valueHandle, 0, 100, value) != WICED_BT_GATT_SUCCESS ||
+        client_prepare_write(valueHandle, 150, 100, value + 150) != WICED_BT_GATT_INVALID_OFFSET ||
+        client_prepare_write(valueHandle, 100, 100, value + 100) != WICED_BT_GATT_PREPARE_Q_FULL)
+    {
+        FAIL("chunk after a rejected chunk accepted");
+    }
+    if (client_execute_write(GATT_PREP_WRITE_EXEC) != WICED_BT_GATT_PREPARE_Q_FULL || s_acs.writes != writes ||
+        s_acs.execWrites != execWrites)
+    {
+        FAIL("execute write of a rejected value accepted");
+    }
+
+    /* a first chunk too large, the queue stays empty but nothing else is queued */
+    if (client_prepare_write(valueHandle, 0, TEST_MAX_VALUE + 100, value) != WICED_BT_GATT_PREPARE_Q_FULL ||
+        client_prepare_write(valueHandle, 0, 100, value) != WICED_BT_GATT_PREPARE_Q_FULL ||
+        client_prepare_write(valueHandle, 100, 100, value + 100) != WICED_BT_GATT_PREPARE_Q_FULL)
+    {
+        FAIL("chunk after a rejected first chunk accepted");
+    }
+    if (client_execute_write(GATT_PREP_WRITE_EXEC) != WICED_BT_GATT_PREPARE_Q_FULL || s_acs.writes != writes ||
+        s_acs.execWrites != execWrites)
+    {
+        FAIL("execute write after a rejected first chunk reached the ACS layer");
+    }
+
+    /* a chunk of another attribute */
+    if (client_prepare_write(valueHandle, 0, 100, value) != WICED_BT_GATT_SUCCESS ||
+        client_prepare_write(valueHandle + 1, 100, 100, value + 100) != WICED_BT_GATT_PREPARE_Q_FULL ||
+        client_execute_write(GATT_PREP_WRITE_EXEC) != WICED_BT_GATT_PREPARE_Q_FULL || s_acs.writes != writes)
+    {
+        FAIL("chunk of another attribute queued");
+    }
+
+    /* a cancelled write goes to the ACS layer as such, the queue is usable again after it */
+    prepare_write(value, 200);
+    if (client_execute_write(GATT_PREP_WRITE_CANCEL) != WICED_BT_GATT_SUCCESS || s_acs.writes != writes ||
+        s_acs.execWrites != execWrites + 1 || s_acs.execWrite != false)
+    {
+        FAIL("cancelled prepared write not reported");
+    }
+    fill_value(value, 300, 4);
+    prepare_write(value, 300);
+    if (client_execute_write(GATT_PREP_WRITE_EXEC) != WICED_BT_GATT_SUCCESS || s_acs.writes != writes + 1 ||
+        s_acs.len != 300 || memcmp(s_acs.value, value, 300) != 0)
+    {
+        FAIL("prepared write after the rejected ones not written");
+    }
+}
+
+static void check_stream(packet_type_t type, uint32_t len)
+{
+    if (s_packetNum != TEST_STREAM_VALUES)
+    {
+        FAIL("%u of %u values sent", s_packetNum, TEST_STREAM_VALUES);
+    }
+    for (uint32_t i = 0; i < s_packetNum; i++)
+    {
+        uint8_t value[TEST_MAX_VALUE];
+
+        fill_value(value, len, i);
+        if (s_packets[i].type != type || s_packets[i].handle != s_charHandle + 1 || s_packets[i].len != len ||
+            memcmp(s_packets[i].value, value, len) != 0)
+        {
+            FAIL("value %u of the stream sent wrong", i);
+        }
+    }
+}
+
+/* Returns the time the stream took on the link */
+static uint32_t indication_stream(uint32_t len)
+{
+    uint32_t start = s_nowMs;
+    uint8_t value[TEST_MAX_VALUE];
+
+    s_packetNum = 0;
+    s_acs.indicationsSent = 0;
+    for (uint32_t i = 0; i < TEST_STREAM_VALUES; i++)
+    {
+        fill_value(value, len, i);
+        if (s_server->pxSendIndication(0, s_charHandle, TEST_CONN_ID, len, value, true) != eBTStatusSuccess)
+        {
+            FAIL("indication %u not sent", i);
+        }
+        if (s_acs.indicationsSent != i)
+        {
+            FAIL("indication %u reported sent before its confirmation", i);
+        }
+        /* the value goes out in the next connection event, the confirmation comes back in the one after */
+        wait_events(2);
+        client_confirm(s_charHandle + 1);
+        if (s_acs.indicationsSent != i + 1)
+        {
+            FAIL("indication %u not reported sent on its confirmation", i);
+        }
+    }
+    return s_nowMs - start;
+}
+
+static uint32_t notification_stream(uint32_t len)
+{
+    uint32_t start = s_nowMs;
+    uint8_t value[TEST_MAX_VALUE];
+
+    s_packetNum = 0;
+    s_acs.indicationsSent = 0;
+    for (uint32_t i = 0; i < TEST_STREAM_VALUES; i++)
+    {
+        fill_value(value, len, i);
+        if (s_server->pxSendIndication(0, s_charHandle, TEST_CONN_ID, len, value, true) != eBTStatusSuccess ||
+            s_acs.indicationsSent != i + 1)
+        {
+            FAIL("value %u of the notification stream not reported sent", i);
+        }
+    }
+    while (s_txQueued > 0)
+    {
+        run_link(1);
+    }
+    return s_nowMs - start;
+}
+
+static void indication_checks(void)
+{
+    uint32_t len = TEST_CLIENT_MTU - 3;
+    uint8_t value[TEST_MAX_VALUE] = {0};
+    uint32_t indicationMs;
+    uint32_t notificationMs;
+    uint32_t delays;
+
+    /* a value over the MTU fails at once, nothing is sent */
+    s_packetNum = 0;
+    if (s_server->pxSendIndication(0, s_charHandle, TEST_CONN_ID, len + 1, value, true) != eBTStatusFail ||
+        s_acs.indicationsFailed != 1 || s_packetNum != 0)
+    {
+        FAIL("indication over the MTU sent");
+    }
+
+    indicationMs = indication_stream(len);
+    check_stream(PACKET_INDICATION, len);
+
+    set_indications_as_notifications(WICED_TRUE);
+    delays = s_delays;
+    notificationMs = notification_stream(len);
+    check_stream(PACKET_NOTIFICATION, len);
+    if (s_delays == delays || s_acs.indicationsFailed != 1)
+    {
+        FAIL("notification stream never waited for the link, %u values failed", s_acs.indicationsFailed - 1);
+    }
+    if (notificationMs >= indicationMs)
+    {
+        FAIL("%u values in %u ms as notifications, %u ms as indications", TEST_STREAM_VALUES, notificationMs,
+             indicationMs);
+    }
+
+    /* a link congested for good fails the value after the retries */
+    s_packetNum = 0;
+    s_forceCongested = 1000;
+    s_congestedReplies = 0;
+    if (s_server->pxSendIndication(0, s_charHandle, TEST_CONN_ID, len, value, true) != eBTStatusFail ||
+        s_acs.indicationsFailed != 2 || s_packetNum != 0 || s_congestedReplies != 21)
+    {
+        FAIL("value sent %u times on a congested link", s_congestedReplies);
+    }
+    s_forceCongested = 0;
+    set_indications_as_notifications(WICED_FALSE);
+
+    printf("gatt loopback: %u values of %u bytes in %u ms as notifications, %u ms as indications\n",
+           TEST_STREAM_VALUES, len, notificationMs, indicationMs);
+}
+
+static void disconnection_checks(void)
+{
+    uint8_t value[8] = {0};
+    uint32_t sent = s_acs.indicationsSent;
+
+    if (s_server->pxSendIndication(0, s_charHandle, TEST_CONN_ID, sizeof(value), value, true) != eBTStatusSuccess)
+    {
+        FAIL("indication not sent");
+    }
+    client_connection(WICED_FALSE);
+    if (s_acs.indicationsFailed != 3 || s_acs.indicationsSent != sent)
+    {
+        FAIL("indication pending on disconnection not reported failed");
+    }
+    client_confirm(s_charHandle + 1);
+    if (s_acs.indicationsFailed != 3 || s_acs.indicationsSent != sent)
+    {
+        FAIL("indication reported twice");
+    }
+    if (get_connection_state() != WICED_FALSE || get_negotiated_mtu() != GATT_DEF_BLE_MTU_SIZE)
+    {
+        FAIL("connection state kept after disconnection");
+    }
+}
+
+int main(void)
+{
+    build_server();
+    connection_checks();
+    request_checks();
+    prepared_write_checks();
+    indication_checks();
+    disconnection_checks();
+    return 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for wiced_bt_cfg.h, the GATT settings of the real header.
+ */
+
+#ifndef WICED_BT_CFG_H
+#define WICED_BT_CFG_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint16_t max_mtu_size;
+} wiced_bt_cfg_gatt_settings_t;
+
+typedef struct
+{
+    wiced_bt_cfg_gatt_settings_t gatt_cfg;
+} wiced_bt_cfg_settings_t;
+
+#endif /* WICED_BT_CFG_H */
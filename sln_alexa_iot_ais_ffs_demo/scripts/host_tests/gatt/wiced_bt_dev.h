@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for wiced_bt_dev.h, nothing of it is used by bt_hal_gatt.c.
+ */
+
+#ifndef WICED_BT_DEV_H
+#define WICED_BT_DEV_H
+
+#endif /* WICED_BT_DEV_H */
@@ -0,0 +1,183 @@
+/*
+ * Host stand-in for wiced_bt_gatt.h, the status codes, database definitions,
+ * server events and server calls of the real header.
+ */
+
+#ifndef WICED_BT_GATT_H
+#define WICED_BT_GATT_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "gattdefs.h"
+
+typedef enum
+{
+    WICED_FALSE = 0,
+    WICED_TRUE = 1
+} wiced_bool_t;
+
+enum wiced_bt_gatt_status_e
+{
+    WICED_BT_GATT_SUCCESS           = 0x00,
+    WICED_BT_GATT_INVALID_PDU       = 0x04,
+    WICED_BT_GATT_INVALID_OFFSET    = 0x07,
+    WICED_BT_GATT_PREPARE_Q_FULL    = 0x09,
+    WICED_BT_GATT_INVALID_ATTR_LEN  = 0x0d,
+    WICED_BT_GATT_DB_FULL           = 0x83,
+    WICED_BT_GATT_BUSY              = 0x84,
+    WICED_BT_GATT_ILLEGAL_PARAMETER = 0x87,
+    WICED_BT_GATT_PENDING           = 0x88,
+    WICED_BT_GATT_CONGESTED         = 0x8f,
+};
+typedef uint8_t wiced_bt_gatt_status_t;
+
+#define LEGATTDB_PERM_READABLE          (0x1 << 1)
+#define LEGATTDB_PERM_WRITE_CMD         (0x1 << 2)
+#define LEGATTDB_PERM_WRITE_REQ         (0x1 << 3)
+#define LEGATTDB_PERM_AUTH_READABLE     (0x1 << 4)
+#define LEGATTDB_PERM_RELIABLE_WRITE    (0x1 << 5)
+#define LEGATTDB_PERM_AUTH_WRITABLE     (0x1 << 6)
+#define LEGATTDB_PERM_WRITABLE          (LEGATTDB_PERM_WRITE_CMD | LEGATTDB_PERM_WRITE_REQ | LEGATTDB_PERM_AUTH_WRITABLE)
+#define LEGATTDB_PERM_SERVICE_UUID_128  (0x1 << 7)
+
+#define LEGATTDB_UUID16_SIZE    2
+#define LEGATTDB_UUID128_SIZE   16
+
+#define GATT_DEF_BLE_MTU_SIZE   23
+
+enum wiced_bt_gatt_auth_req_e
+{
+    GATT_AUTH_REQ_NONE = 0,
+};
+typedef uint8_t wiced_bt_gatt_auth_req_t;
+
+typedef struct
+{
+    uint16_t handle;
+    uint16_t offset;
+    uint16_t len;
+    wiced_bt_gatt_auth_req_t auth_req;
+    uint8_t value[1];
+} wiced_bt_gatt_value_t;
+
+enum wiced_bt_gatt_exec_flag_e
+{
+    GATT_PREP_WRITE_CANCEL = 0x00,
+    GATT_PREP_WRITE_EXEC   = 0x01
+};
+typedef uint8_t wiced_bt_gatt_exec_flag_t;
+
+typedef struct
+{
+    uint16_t handle;
+    uint16_t offset;
+    wiced_bool_t is_long;
+    uint16_t *p_val_len;
+    uint8_t *p_val;
+} wiced_bt_gatt_read_t;
+
+typedef struct
+{
+    uint16_t handle;
+    wiced_bool_t is_prep;
+    uint16_t offset;
+    uint16_t val_len;
+    uint8_t *p_val;
+} wiced_bt_gatt_write_t;
+
+typedef union
+{
+    wiced_bt_gatt_read_t read_req;
+    wiced_bt_gatt_write_t write_req;
+    uint16_t handle;
+    uint16_t mtu;
+    wiced_bt_gatt_exec_flag_t exec_write;
+} wiced_bt_gatt_request_data_t;
+
+enum wiced_bt_gatt_request_type_e
+{
+    GATTS_REQ_TYPE_READ = 1,
+    GATTS_REQ_TYPE_WRITE,
+    GATTS_REQ_TYPE_PREP_WRITE,
+    GATTS_REQ_TYPE_WRITE_EXEC,
+    GATTS_REQ_TYPE_MTU,
+    GATTS_REQ_TYPE_CONF,
+};
+typedef uint8_t wiced_bt_gatt_request_type_t;
+
+enum wiced_bt_gatt_write_type_e
+{
+    GATT_WRITE_NO_RSP = 1,
+    GATT_WRITE,
+    GATT_WRITE_PREPARE
+};
+typedef uint8_t wiced_bt_gatt_write_type_t;
+
+enum wiced_bt_gatt_optype_e
+{
+    GATTC_OPTYPE_NONE   = 0,
+    GATTC_OPTYPE_CONFIG = 5,
+};
+typedef uint8_t wiced_bt_gatt_optype_t;
+
+typedef union
+{
+    uint16_t mtu;
+    uint16_t handle;
+} wiced_bt_gatt_operation_complete_rsp_t;
+
+typedef enum
+{
+    GATT_CONNECTION_STATUS_EVT,
+    GATT_OPERATION_CPLT_EVT,
+    GATT_DISCOVERY_RESULT_EVT,
+    GATT_DISCOVERY_CPLT_EVT,
+    GATT_ATTRIBUTE_REQUEST_EVT
+} wiced_bt_gatt_evt_t;
+
+typedef struct
+{
+    uint16_t conn_id;
+    wiced_bt_gatt_optype_t op;
+    wiced_bt_gatt_status_t status;
+    wiced_bt_gatt_operation_complete_rsp_t response_data;
+} wiced_bt_gatt_operation_complete_t;
+
+typedef struct
+{
+    uint8_t *bd_addr;
+    uint8_t addr_type;
+    uint16_t conn_id;
+    wiced_bool_t connected;
+    uint8_t reason;
+    uint8_t transport;
+    uint8_t link_role;
+} wiced_bt_gatt_connection_status_t;
+
+typedef struct
+{
+    uint16_t conn_id;
+    wiced_bt_gatt_request_type_t request_type;
+    wiced_bt_gatt_request_data_t data;
+} wiced_bt_gatt_attribute_request_t;
+
+typedef union
+{
+    wiced_bt_gatt_operation_complete_t operation_complete;
+    wiced_bt_gatt_connection_status_t connection_status;
+    wiced_bt_gatt_attribute_request_t attribute_request;
+} wiced_bt_gatt_event_data_t;
+
+typedef wiced_bt_gatt_status_t wiced_bt_gatt_cback_t(wiced_bt_gatt_evt_t event, wiced_bt_gatt_event_data_t *p_event_data);
+
+wiced_bt_gatt_status_t wiced_bt_gatt_register(wiced_bt_gatt_cback_t *p_gatt_cback);
+wiced_bt_gatt_status_t wiced_bt_gatt_db_init(const uint8_t *p_gatt_db, uint16_t gatt_db_size);
+wiced_bt_gatt_status_t wiced_bt_gatt_send_indication(uint16_t conn_id, uint16_t attr_handle, uint16_t val_len, uint8_t *p_val);
+wiced_bt_gatt_status_t wiced_bt_gatt_send_notification(uint16_t conn_id, uint16_t attr_handle, uint16_t val_len, uint8_t *p_val);
+wiced_bt_gatt_status_t wiced_bt_gatt_send_response(wiced_bt_gatt_status_t status, uint16_t conn_id, uint16_t attr_handle,
+                                                   uint16_t attr_len, uint16_t offset, uint8_t *p_attr);
+wiced_bt_gatt_status_t wiced_bt_gatt_configure_mtu(uint16_t conn_id, uint16_t mtu);
+wiced_bt_gatt_status_t wiced_bt_gatt_send_write(uint16_t conn_id, wiced_bt_gatt_write_type_t type, wiced_bt_gatt_value_t *p_write);
+
+#endif /* WICED_BT_GATT_H */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for wiced_bt_stack.h, nothing of it is used by bt_hal_gatt.c.
+ */
+
+#ifndef WICED_BT_STACK_H
+#define WICED_BT_STACK_H
+
+#endif /* WICED_BT_STACK_H */
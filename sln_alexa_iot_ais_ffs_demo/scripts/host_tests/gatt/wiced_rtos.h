@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for wiced_rtos.h and the FreeRTOS heap calls, the delays are
+ * counted by the test instead of slept.
+ */
+
+#ifndef WICED_RTOS_H
+#define WICED_RTOS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define pvPortMalloc malloc
+#define vPortFree    free
+
+void wiced_rtos_delay_milliseconds(uint32_t milliseconds);
+
+#endif /* WICED_RTOS_H */
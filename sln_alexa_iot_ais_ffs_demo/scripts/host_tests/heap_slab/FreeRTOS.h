@@ -0,0 +1,60 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build heap_4_wrap.c and
+ * heap_slab.c with the heap and slab classes of config_files/FreeRTOSConfig.h.
+ * The test builds it once with configUSE_HEAP_SLAB 0 and once with 1.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+
+#define portMAX_DELAY           ( ( TickType_t ) 0xffffffffUL )
+#define portBYTE_ALIGNMENT      8
+#define portBYTE_ALIGNMENT_MASK ( 0x0007 )
+
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+#define configTOTAL_HEAP_SIZE            ( ( size_t ) ( 295 * 1024 ) )
+#define configHEAP_SLAB_CLASSES          {{32, 64}, {64, 64}, {128, 32}, {256, 32}, {512, 16}}
+#define configHEAP_TASK_ACCOUNTING       0
+#define configUSE_HEAP_TRACKER           0
+#define configUSE_MALLOC_FAILED_HOOK     0
+
+#ifndef configUSE_HEAP_SLAB
+#define configUSE_HEAP_SLAB 1
+#endif
+
+#define configASSERT( x ) assert( x )
+#define mtCOVERAGE_TEST_MARKER()
+
+#define traceMALLOC( pv, size )
+#define traceFREE( pv, size )
+
+/* As in portable.h */
+typedef struct xHeapStats
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+void *pvPortMalloc( size_t xWantedSize );
+void vPortFree( void *pv );
+size_t xPortGetFreeHeapSize( void );
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+#endif /* INC_FREERTOS_H */
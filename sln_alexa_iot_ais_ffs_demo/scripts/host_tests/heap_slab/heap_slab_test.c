@@ -0,0 +1,449 @@
+/*
+ * Host trace replay of heap_slab.c against plain heap_4.
+ *
+ * Built twice against the stub FreeRTOS.h / task.h in this directory, with the
+ * 295 KB heap and the slab classes of config_files/FreeRTOSConfig.h: once with
+ * configUSE_HEAP_SLAB 0, plain heap_4, and once with 1, the slab classes in
+ * front of heap_4.
+ *
+ * The trace is made up of the hot path allocations of a long session: MQTT
+ * receive buffers, publish nodes, logging buffers, flash scratch buffers, cJSON
+ * nodes freed together, and connection objects that live long between them.
+ * Every few hundred operations a 16 KB buffer, the size of a TLS record, is
+ * allocated and freed at once.
+ *
+ * The replay times every pvPortMalloc() / vPortFree() and follows the heap_4
+ * free list: its largest block, the number of blocks, and the 16 KB buffers
+ * that could not be allocated. Each block is filled with its id and checked
+ * when freed, and with the slab classes on, the class counters are checked
+ * against the trace.
+ *
+ * The plain heap_4 run writes its figures to the given file, the slab run reads
+ * them back and prints both side by side.
+ *
+ * Build and run with "make -C scripts/host_tests heap_slab".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_4_wrap.h"
+#include "heap_slab.h"
+
+#define TEST_STEPS      200000
+#define TEST_MAX_OPS    ( TEST_STEPS * 8 )
+#define TEST_MAX_IDS    ( TEST_STEPS * 4 )
+#define TEST_BIG_SIZE   ( 16 * 1024 )
+#define TEST_BIG_EVERY  300
+#define TEST_WALK_EVERY 1000
+
+typedef struct
+{
+    uint32_t ulId;
+    uint32_t ulSize; /* 0 for a free */
+} TraceOp_t;
+
+typedef struct
+{
+    double dMallocMean;
+    double dMallocP99;
+    double dFreeMean;
+    double dFreeP99;
+    size_t xLargestMin;
+    size_t xLargestEnd;
+    size_t xBlocksMax;
+    size_t xBigFailures;
+    size_t xMinEverFree;
+} ReplayResult_t;
+
+static TraceOp_t xTrace[ TEST_MAX_OPS ];
+static size_t xTraceLen;
+
+/* Step at which each id is freed, the trace is built in step order */
+typedef struct
+{
+    uint32_t ulStep;
+    uint32_t ulId;
+} PendingFree_t;
+
+static PendingFree_t xPending[ TEST_MAX_IDS ];
+static size_t xPendingCount;
+static uint32_t ulNextId;
+
+static void *pvBlocks[ TEST_MAX_IDS ];
+static uint32_t ulSizes[ TEST_MAX_IDS ];
+static uint32_t ulMallocNs[ TEST_MAX_OPS ];
+static uint32_t ulFreeNs[ TEST_MAX_OPS ];
+
+static UBaseType_t uxSuspendNesting;
+
+#define FAIL( ... )                                 \
+    do {                                            \
+        printf( "heap slab: " );                    \
+        printf( __VA_ARGS__ );                      \
+        printf( "\n" );                             \
+        exit( 1 );                                  \
+    } while( 0 )
+
+void vTaskSuspendAll( void )
+{
+    uxSuspendNesting++;
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    assert( uxSuspendNesting > 0 );
+    uxSuspendNesting--;
+    return pdFALSE;
+}
+
+static uint32_t prvRange( uint32_t ulMin, uint32_t ulMax )
+{
+    return ulMin + ( uint32_t ) rand() % ( ulMax - ulMin + 1 );
+}
+
+/* Min-heap of the pending frees by step */
+static void prvPendingPush( uint32_t ulStep, uint32_t ulId )
+{
+    size_t xPos = xPendingCount++;
+
+    while( ( xPos > 0 ) && ( xPending[ ( xPos - 1 ) / 2 ].ulStep > ulStep ) )
+    {
+        xPending[ xPos ] = xPending[ ( xPos - 1 ) / 2 ];
+        xPos = ( xPos - 1 ) / 2;
+    }
+    xPending[ xPos ].ulStep = ulStep;
+    xPending[ xPos ].ulId = ulId;
+}
+
+static PendingFree_t prvPendingPop( void )
+{
+    PendingFree_t xTop = xPending[ 0 ];
+    PendingFree_t xLast = xPending[ --xPendingCount ];
+    size_t xPos = 0;
+    size_t xChild;
+
+    while( ( xChild = ( 2 * xPos ) + 1 ) < xPendingCount )
+    {
+        if( ( xChild + 1 < xPendingCount ) && ( xPending[ xChild + 1 ].ulStep < xPending[ xChild ].ulStep ) )
+        {
+            xChild++;
+        }
+        if( xPending[ xChild ].ulStep >= xLast.ulStep )
+        {
+            break;
+        }
+        xPending[ xPos ] = xPending[ xChild ];
+        xPos = xChild;
+    }
+    xPending[ xPos ] = xLast;
+    return xTop;
+}
+
+static void prvTraceAlloc( uint32_t ulStep, uint32_t ulSize, uint32_t ulLife )
+{
+    if( ( xTraceLen >= TEST_MAX_OPS - 1 ) || ( ulNextId >= TEST_MAX_IDS ) )
+    {
+        FAIL( "trace too long at step %u", ulStep );
+    }
+    xTrace[ xTraceLen ].ulId = ulNextId;
+    xTrace[ xTraceLen ].ulSize = ulSize;
+    xTraceLen++;
+    prvPendingPush( ulStep + ulLife, ulNextId++ );
+}
+
+static void prvBuildTrace( void )
+{
+    srand( 32 );
+
+    for( uint32_t ulStep = 0; ulStep < TEST_STEPS; ulStep++ )
+    {
+        uint32_t ulKind = rand() % 100;
+
+        while( ( xPendingCount > 0 ) && ( xPending[ 0 ].ulStep <= ulStep ) )
+        {
+            xTrace[ xTraceLen ].ulId = prvPendingPop().ulId;
+            xTrace[ xTraceLen ].ulSize = 0;
+            xTraceLen++;
+        }
+
+        if( ulKind < 25 )
+        {
+            /* Publish node */
+            prvTraceAlloc( ulStep, prvRange( 40, 160 ), prvRange( 2, 20 ) );
+        }
+        else if( ulKind < 45 )
+        {
+            /* Logging buffer */
+            prvTraceAlloc( ulStep, prvRange( 100, 256 ), prvRange( 1, 5 ) );
+        }
+        else if( ulKind < 60 )
+        {
+            /* cJSON nodes of a parsed message, freed together */
+            uint32_t ulLife = prvRange( 3, 30 );
+            uint32_t ulNodes = prvRange( 4, 24 );
+
+            for( uint32_t i = 0; i < ulNodes; i++ )
+            {
+                prvTraceAlloc( ulStep, prvRange( 16, 64 ), ulLife );
+            }
+        }
+        else if( ulKind < 70 )
+        {
+            /* MQTT receive buffer */
+            prvTraceAlloc( ulStep, prvRange( 512, 2048 ), prvRange( 1, 3 ) );
+        }
+        else if( ulKind < 76 )
+        {
+            /* Flash scratch */
+            prvTraceAlloc( ulStep, prvRange( 256, 4096 ), 1 );
+        }
+
+        if( rand() % 500 == 0 )
+        {
+            /* Connection or session object, lives long */
+            prvTraceAlloc( ulStep, prvRange( 200, 6000 ), prvRange( 500, 20000 ) );
+        }
+
+        if( ulStep % TEST_BIG_EVERY == 0 )
+        {
+            /* Taken and released at once by the replay */
+            xTrace[ xTraceLen ].ulId = UINT32_MAX;
+            xTrace[ xTraceLen ].ulSize = TEST_BIG_SIZE;
+            xTraceLen++;
+        }
+    }
+
+    while( xPendingCount > 0 )
+    {
+        xTrace[ xTraceLen ].ulId = prvPendingPop().ulId;
+        xTrace[ xTraceLen ].ulSize = 0;
+        xTraceLen++;
+    }
+}
+
+static uint64_t prvNowNs( void )
+{
+    struct timespec xTime;
+
+    clock_gettime( CLOCK_MONOTONIC, &xTime );
+    return ( ( uint64_t ) xTime.tv_sec * 1000000000ULL ) + ( uint64_t ) xTime.tv_nsec;
+}
+
+static int prvCompare( const void *pvA, const void *pvB )
+{
+    uint32_t ulA = *( const uint32_t * ) pvA;
+    uint32_t ulB = *( const uint32_t * ) pvB;
+
+    return ( ulA > ulB ) - ( ulA < ulB );
+}
+
+static void prvSummary( uint32_t *pulNs, size_t xCount, double *pdMean, double *pdP99 )
+{
+    uint64_t ullSum = 0;
+
+    for( size_t i = 0; i < xCount; i++ )
+    {
+        ullSum += pulNs[ i ];
+    }
+    qsort( pulNs, xCount, sizeof( uint32_t ), prvCompare );
+    *pdMean = ( double ) ullSum / xCount;
+    *pdP99 = pulNs[ ( xCount * 99 ) / 100 ];
+}
+
+static void prvWalk( ReplayResult_t *pxResult )
+{
+    size_t xBins[ 16 ];
+    size_t xBlocks = 0;
+    size_t xLargest = xHeapGetFreeHistogram( xBins, 16 );
+
+    for( size_t i = 0; i < 16; i++ )
+    {
+        xBlocks += xBins[ i ];
+    }
+    if( xLargest < pxResult->xLargestMin )
+    {
+        pxResult->xLargestMin = xLargest;
+    }
+    if( xBlocks > pxResult->xBlocksMax )
+    {
+        pxResult->xBlocksMax = xBlocks;
+    }
+    pxResult->xLargestEnd = xLargest;
+}
+
+static void prvReplay( ReplayResult_t *pxResult )
+{
+    size_t xMallocs = 0;
+    size_t xFrees = 0;
+
+    memset( pxResult, 0, sizeof( *pxResult ) );
+    pxResult->xLargestMin = SIZE_MAX;
+
+    for( size_t xOp = 0; xOp < xTraceLen; xOp++ )
+    {
+        TraceOp_t *pxOp = &xTrace[ xOp ];
+        uint64_t ullStart;
+
+        if( pxOp->ulId == UINT32_MAX )
+        {
+            void *pvBig = pvPortMalloc( pxOp->ulSize );
+
+            if( pvBig == NULL )
+            {
+                pxResult->xBigFailures++;
+            }
+            vPortFree( pvBig );
+        }
+        else if( pxOp->ulSize != 0 )
+        {
+            uint8_t *pucBlock;
+
+            ullStart = prvNowNs();
+            pucBlock = pvPortMalloc( pxOp->ulSize );
+            ulMallocNs[ xMallocs++ ] = ( uint32_t ) ( prvNowNs() - ullStart );
+
+            if( pucBlock == NULL )
+            {
+                FAIL( "allocation %u of %u bytes failed", pxOp->ulId, pxOp->ulSize );
+            }
+            if( ( ( uintptr_t ) pucBlock & portBYTE_ALIGNMENT_MASK ) != 0 )
+            {
+                FAIL( "allocation %u at %p not aligned", pxOp->ulId, ( void * ) pucBlock );
+            }
+            memset( pucBlock, ( uint8_t ) pxOp->ulId, pxOp->ulSize );
+            pvBlocks[ pxOp->ulId ] = pucBlock;
+            ulSizes[ pxOp->ulId ] = pxOp->ulSize;
+        }
+        else
+        {
+            uint8_t *pucBlock = pvBlocks[ pxOp->ulId ];
+
+            for( uint32_t i = 0; i < ulSizes[ pxOp->ulId ]; i++ )
+            {
+                if( pucBlock[ i ] != ( uint8_t ) pxOp->ulId )
+                {
+                    FAIL( "block %u overwritten at byte %u", pxOp->ulId, i );
+                }
+            }
+
+            ullStart = prvNowNs();
+            vPortFree( pucBlock );
+            ulFreeNs[ xFrees++ ] = ( uint32_t ) ( prvNowNs() - ullStart );
+        }
+
+        if( xOp % TEST_WALK_EVERY == 0 )
+        {
+            prvWalk( pxResult );
+        }
+    }
+    prvWalk( pxResult );
+
+    prvSummary( ulMallocNs, xMallocs, &pxResult->dMallocMean, &pxResult->dMallocP99 );
+    prvSummary( ulFreeNs, xFrees, &pxResult->dFreeMean, &pxResult->dFreeP99 );
+    pxResult->xMinEverFree = xPortGetMinimumEverFreeHeapSize();
+}
+
+#if( configUSE_HEAP_SLAB == 1 )
+
+static void prvPrint( const char *pcName, const ReplayResult_t *pxResult )
+{
+    printf( "heap slab: %-7s malloc %5.1f ns (p99 %4.0f), free %5.1f ns (p99 %4.0f), largest free block "
+            "%6zu at worst %6zu at the end, %3zu free blocks at most, %zu 16 KB buffers refused\n",
+            pcName, pxResult->dMallocMean, pxResult->dMallocP99, pxResult->dFreeMean, pxResult->dFreeP99,
+            pxResult->xLargestMin, pxResult->xLargestEnd, pxResult->xBlocksMax, pxResult->xBigFailures );
+}
+
+static void prvCheckClasses( void )
+{
+    static const struct
+    {
+        uint16_t usBlockSize;
+        uint16_t usBlockCount;
+    } xConfig[] = configHEAP_SLAB_CLASSES;
+    SlabStats_t xStats[ 8 ];
+    size_t xRequests[ 8 ] = { 0 };
+    size_t xClasses = xSlabGetStats( xStats, 8 );
+
+    if( xClasses != sizeof( xConfig ) / sizeof( xConfig[ 0 ] ) )
+    {
+        FAIL( "%zu classes set up", xClasses );
+    }
+
+    for( size_t xOp = 0; xOp < xTraceLen; xOp++ )
+    {
+        for( size_t xClass = 0; ( xTrace[ xOp ].ulSize != 0 ) && ( xClass < xClasses ); xClass++ )
+        {
+            if( xTrace[ xOp ].ulSize <= xConfig[ xClass ].usBlockSize )
+            {
+                xRequests[ xClass ]++;
+                break;
+            }
+        }
+    }
+
+    for( size_t xClass = 0; xClass < xClasses; xClass++ )
+    {
+        SlabStats_t *pxStats = &xStats[ xClass ];
+
+        printf( "heap slab: class %3zu x %2zu: %7zu allocations, %6zu sent to heap_4, %2zu at most\n",
+                pxStats->xBlockSize, pxStats->xBlockCount, pxStats->xAllocations, pxStats->xFallThroughs,
+                pxStats->xHighWater );
+
+        if( ( pxStats->xInUse != 0 ) || ( pxStats->xHighWater > pxStats->xBlockCount ) ||
+            ( pxStats->xAllocations + pxStats->xFallThroughs != xRequests[ xClass ] ) )
+        {
+            FAIL( "class of %zu: %zu in use, %zu at most, %zu + %zu of %zu requests", pxStats->xBlockSize,
+                  pxStats->xInUse, pxStats->xHighWater, pxStats->xAllocations, pxStats->xFallThroughs,
+                  xRequests[ xClass ] );
+        }
+    }
+}
+
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+int main( int argc, char **argv )
+{
+    ReplayResult_t xResult;
+    FILE *pxFile;
+
+    if( argc < 2 )
+    {
+        FAIL( "usage: %s <figures file>", argv[ 0 ] );
+    }
+
+    prvBuildTrace();
+    prvReplay( &xResult );
+
+
+#if( configUSE_HEAP_SLAB == 0 )
+    pxFile = fopen( argv[ 1 ], "wb" );
+    if( ( pxFile == NULL ) || ( fwrite( &xResult, sizeof( xResult ), 1, pxFile ) != 1 ) )
+    {
+        FAIL( "can't write %s", argv[ 1 ] );
+    }
+    fclose( pxFile );
+    printf( "heap slab: %zu operations replayed, %zu KB heap\n", xTraceLen, configTOTAL_HEAP_SIZE / 1024 );
+#else
+    {
+        ReplayResult_t xPlain;
+
+        pxFile = fopen( argv[ 1 ], "rb" );
+        if( ( pxFile == NULL ) || ( fread( &xPlain, sizeof( xPlain ), 1, pxFile ) != 1 ) )
+        {
+            FAIL( "can't read the heap_4 figures from %s", argv[ 1 ] );
+        }
+        fclose( pxFile );
+
+        prvCheckClasses();
+        prvPrint( "heap_4", &xPlain );
+        prvPrint( "slab", &xResult );
+    }
+#endif
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for task.h. A single thread: the scheduler lock only nests.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+
+#define taskENTER_CRITICAL() vTaskSuspendAll()
+#define taskEXIT_CRITICAL()  ( void ) xTaskResumeAll()
+
+#endif /* INC_TASK_H */
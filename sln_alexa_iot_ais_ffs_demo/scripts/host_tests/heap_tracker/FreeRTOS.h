@@ -0,0 +1,65 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build heap_4_wrap.c with the
+ * heap tracker enabled.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+#define pdMS_TO_TICKS( xTimeInMs ) ( ( TickType_t ) ( xTimeInMs ) )
+
+#define portMAX_DELAY           ( ( TickType_t ) 0xffffffffUL )
+#define portBYTE_ALIGNMENT      8
+#define portBYTE_ALIGNMENT_MASK ( 0x0007 )
+
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#define configAPPLICATION_ALLOCATED_HEAP 0
+#define configTOTAL_HEAP_SIZE            ( 64 * 1024 )
+#define configUSE_HEAP_SLAB              0
+#define configHEAP_TASK_ACCOUNTING       0
+#define configUSE_MALLOC_FAILED_HOOK     0
+
+#define configUSE_HEAP_TRACKER             1
+#define configHEAP_TRACKER_BLOCKS          64
+#define configHEAP_TRACKER_SITES           8
+#define configHEAP_TRACKER_TREND_SAMPLES   16
+#define configHEAP_TRACKER_TREND_PERIOD_MS 10
+
+#define configASSERT( x ) assert( x )
+#define mtCOVERAGE_TEST_MARKER()
+
+void vHeapTrackerMalloc( void *pv, size_t xSize, void *pvCaller );
+void vHeapTrackerFree( void *pv );
+
+/* Same hooks as config_files/FreeRTOSConfig.h, without the shell tracing */
+#define traceMALLOC( pv, size ) vHeapTrackerMalloc( ( pv ), ( size ), __builtin_return_address( 0 ) )
+#define traceFREE( pv, size )   vHeapTrackerFree( pv )
+
+/* As in portable.h */
+typedef struct xHeapStats
+{
+    size_t xAvailableHeapSpaceInBytes;
+    size_t xSizeOfLargestFreeBlockInBytes;
+    size_t xSizeOfSmallestFreeBlockInBytes;
+    size_t xNumberOfFreeBlocks;
+    size_t xMinimumEverFreeBytesRemaining;
+    size_t xNumberOfSuccessfulAllocations;
+    size_t xNumberOfSuccessfulFrees;
+} HeapStats_t;
+
+void *pvPortMalloc( size_t xWantedSize );
+void vPortFree( void *pv );
+size_t xPortGetFreeHeapSize( void );
+size_t xPortGetMinimumEverFreeHeapSize( void );
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,226 @@
+/*
+ * Host check of the heap tracker in heap_4_wrap.c.
+ *
+ * Builds the real heap_4 + tracker against the stub FreeRTOS.h / task.h in
+ * this directory, runs random pvPortMalloc / vPortFree traffic from a few call
+ * sites and checks the per site counters against a shadow count. Also calls
+ * the tracker hooks with the scheduler running, the way the lock-free slab
+ * classes in heap_slab.c do, and checks the tracker takes the lock itself.
+ *
+ * Build and run with "make -C scripts/host_tests heap_tracker".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "heap_4_wrap.h"
+
+#define TEST_SITES    4
+#define TEST_MAX_LIVE 48
+#define TEST_ROUNDS   200000
+
+static UBaseType_t s_suspendNesting;
+static TickType_t s_tick;
+
+void vTaskSuspendAll( void )
+{
+    s_suspendNesting++;
+}
+
+BaseType_t xTaskResumeAll( void )
+{
+    assert( s_suspendNesting > 0 );
+    s_suspendNesting--;
+    return pdFALSE;
+}
+
+TickType_t xTaskGetTickCount( void )
+{
+    /* Only the tracker asks for the tick, and only under the lock */
+    assert( s_suspendNesting > 0 );
+    return s_tick;
+}
+
+typedef struct
+{
+    void *pv;
+    int site;
+} live_block_t;
+
+static live_block_t s_live[ TEST_MAX_LIVE * 4 ];
+static int s_liveCount;
+
+static __attribute__( ( noinline ) ) void *alloc_site0( size_t size ) { return pvPortMalloc( size ); }
+static __attribute__( ( noinline ) ) void *alloc_site1( size_t size ) { return pvPortMalloc( size ); }
+static __attribute__( ( noinline ) ) void *alloc_site2( size_t size ) { return pvPortMalloc( size ); }
+static __attribute__( ( noinline ) ) void *alloc_site3( size_t size ) { return pvPortMalloc( size ); }
+
+static void *(*const s_sites[ TEST_SITES ])( size_t ) = {alloc_site0, alloc_site1, alloc_site2, alloc_site3};
+
+static int fail( const char *what, int round )
+{
+    printf( "FAIL: %s (round %d)\n", what, round );
+    return 1;
+}
+
+static size_t tracked_live_blocks( void )
+{
+    HeapSiteStats_t sites[ configHEAP_TRACKER_SITES ];
+    size_t count = xHeapTrackerGetTopSites( sites, configHEAP_TRACKER_SITES, pdFALSE );
+    size_t total = 0;
+
+    for( size_t i = 0; i < count; i++ )
+    {
+        total += sites[ i ].xLiveBlocks;
+    }
+
+    return total;
+}
+
+static void free_at( int index )
+{
+    vPortFree( s_live[ index ].pv );
+    s_live[ index ] = s_live[ --s_liveCount ];
+}
+
+static int check_random_traffic( int maxLive )
+{
+    for( int round = 0; round < TEST_ROUNDS; round++ )
+    {
+        s_tick++;
+
+        if( ( s_liveCount == 0 ) || ( ( s_liveCount < maxLive ) && ( rand() & 1 ) ) )
+        {
+            int site = rand() % TEST_SITES;
+            void *pv = s_sites[ site ]( 16 + ( rand() % 512 ) );
+
+            if( pv == NULL )
+            {
+                return fail( "heap exhausted", round );
+            }
+
+            s_live[ s_liveCount ].pv = pv;
+            s_live[ s_liveCount ].site = site;
+            s_liveCount++;
+        }
+        else
+        {
+            free_at( rand() % s_liveCount );
+        }
+
+        if( s_suspendNesting != 0 )
+        {
+            return fail( "scheduler left suspended", round );
+        }
+
+        if( ( maxLive <= configHEAP_TRACKER_BLOCKS ) && ( tracked_live_blocks() != ( size_t ) s_liveCount ) )
+        {
+            return fail( "tracked live blocks differ from the shadow count", round );
+        }
+    }
+
+    return 0;
+}
+
+static int check_slab_path( void )
+{
+    /* heap_slab.c hands out blocks of its own arena and calls the hooks without suspending */
+    static uint64_t slabBlock[ 4 ];
+    size_t before = tracked_live_blocks();
+
+    vHeapTrackerMalloc( slabBlock, sizeof( slabBlock ), ( void * ) check_slab_path );
+    if( tracked_live_blocks() != before + 1 )
+    {
+        return fail( "slab block not tracked", 0 );
+    }
+
+    vHeapTrackerFree( slabBlock );
+    if( ( tracked_live_blocks() != before ) || ( s_suspendNesting != 0 ) )
+    {
+        return fail( "slab block not released", 0 );
+    }
+
+    return 0;
+}
+
+static int check_export( void )
+{
+    uint8_t blob[ heapEXPORT_MAX_SIZE ];
+    size_t length = xHeapTrackerExport( blob, sizeof( blob ) );
+    uint32_t magic = blob[ 0 ] | ( blob[ 1 ] << 8 ) | ( blob[ 2 ] << 16 ) | ( ( uint32_t ) blob[ 3 ] << 24 );
+
+    if( ( length == 0 ) || ( length > sizeof( blob ) ) || ( magic != heapEXPORT_MAGIC ) )
+    {
+        return fail( "bad export blob", 0 );
+    }
+
+    if( xHeapTrackerExport( blob, 8 ) != 0 )
+    {
+        return fail( "export overran a short buffer", 0 );
+    }
+
+    return 0;
+}
+
+int main( void )
+{
+    HeapTrendSample_t trend[ configHEAP_TRACKER_TREND_SAMPLES ];
+    HeapSiteStats_t sites[ configHEAP_TRACKER_SITES ];
+    size_t count;
+    size_t siteCount;
+
+    srand( 1 );
+
+    if( check_random_traffic( TEST_MAX_LIVE ) || check_slab_path() )
+    {
+        return 1;
+    }
+
+    /* Past the side table the extra blocks are only counted */
+    if( check_random_traffic( configHEAP_TRACKER_BLOCKS + 32 ) )
+    {
+        return 1;
+    }
+
+    if( xHeapTrackerGetUntracked() == 0 )
+    {
+        return fail( "overflowing the side table went unnoticed", 0 );
+    }
+
+    while( s_liveCount > 0 )
+    {
+        free_at( s_liveCount - 1 );
+    }
+
+    count = xHeapTrackerGetTopSites( sites, configHEAP_TRACKER_SITES, pdTRUE );
+    for( size_t i = 0; i < count; i++ )
+    {
+        if( ( sites[ i ].xLiveBlocks != 0 ) || ( sites[ i ].xLiveBytes != 0 ) )
+        {
+            return fail( "site still holds live blocks after freeing everything", 0 );
+        }
+    }
+
+    siteCount = count;
+    if( ( siteCount < TEST_SITES ) || ( siteCount >= configHEAP_TRACKER_SITES ) )
+    {
+        return fail( "unexpected number of call sites", 0 );
+    }
+
+    count = xHeapTrackerGetTrend( trend, configHEAP_TRACKER_TREND_SAMPLES );
+    if( ( count != configHEAP_TRACKER_TREND_SAMPLES ) || ( trend[ 0 ].xTick >= trend[ count - 1 ].xTick ) )
+    {
+        return fail( "trend samples missing or out of order", 0 );
+    }
+
+    if( check_export() )
+    {
+        return 1;
+    }
+
+    printf( "heap tracker: OK (%u sites, %u untracked)\n", ( unsigned ) siteCount, ( unsigned ) xHeapTrackerGetUntracked() );
+    return 0;
+}
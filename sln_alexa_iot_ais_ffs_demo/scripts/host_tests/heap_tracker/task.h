@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for task.h, the scheduler lock is a nesting counter the test
+ * can look at.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+void vTaskSuspendAll( void );
+BaseType_t xTaskResumeAll( void );
+TickType_t xTaskGetTickCount( void );
+
+#define taskENTER_CRITICAL() vTaskSuspendAll()
+#define taskEXIT_CRITICAL()  ( void ) xTaskResumeAll()
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build afw_kvs.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+
+#define portMAX_DELAY ( ( TickType_t ) 0xffffffffUL )
+
+#endif /* INC_FREERTOS_H */
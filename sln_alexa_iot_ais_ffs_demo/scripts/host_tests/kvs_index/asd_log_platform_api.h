@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for asd_log_platform_api.h, errors and warnings go to stderr.
+ */
+
+#ifndef ASD_LOG_PLATFORM_API_H
+#define ASD_LOG_PLATFORM_API_H
+
+#include <stdio.h>
+
+#define ASD_LOG_E(module, ...) (fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+#define ASD_LOG_W(module, ...) (fprintf(stderr, __VA_ARGS__), fprintf(stderr, "\n"))
+#define ASD_LOG_I(module, ...) ((void)0)
+
+#endif /* ASD_LOG_PLATFORM_API_H */
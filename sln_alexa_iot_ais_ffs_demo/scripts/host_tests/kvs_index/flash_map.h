@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for flash_map.h: the shared and backup partitions and two
+ * private ones, in a RAM flash defined by the test.
+ */
+
+#ifndef FLASH_MAP_H
+#define FLASH_MAP_H
+
+#include <stdint.h>
+
+extern uint8_t g_kvs_test_flash[];
+
+#define FLASH_BASE                  ((uintptr_t)g_kvs_test_flash)
+
+#define KVS_BASE                    0x10000
+#define KVS_LENGTH                  0x28000
+#define KVS_MAX_PARTITION_COUNT     0x20
+
+#define FLASH_PARTITION_KVS_BACKUP  "kvsBackup"
+#define FLASH_PARTITION_KVS_SHARED  "kvsShared"
+
+#endif /* FLASH_MAP_H */
@@ -0,0 +1,20 @@
+/*
+ * mbedTLS configuration of the host KVS check: AES-CTR for the encrypted
+ * values and CTR_DRBG for the partition nonces, seeded from the host.
+ */
+
+#ifndef HOST_MBEDTLS_CONFIG_H
+#define HOST_MBEDTLS_CONFIG_H
+
+#define MBEDTLS_AES_ROM_TABLES
+#define MBEDTLS_CIPHER_MODE_CTR
+
+#define MBEDTLS_AES_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SHA512_C
+
+#include "mbedtls/check_config.h"
+
+#endif /* HOST_MBEDTLS_CONFIG_H */
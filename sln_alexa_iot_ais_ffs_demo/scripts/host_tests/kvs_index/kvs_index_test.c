@@ -0,0 +1,474 @@
+/*
+ * Host check of the RAM entry index of afw_kvs.c.
+ *
+ * Builds the real afw_kvs.c against the stub headers in this directory, with
+ * the KVS partitions in a RAM flash (programming only clears bits). A random
+ * workload of sets, gets, deletes, cleanups and namespace deletes runs over
+ * the shared partition, with and without a namespace, and two private
+ * partitions, one of them encrypted. Every value is compared with a model, and
+ * every lookup through the index with the flash scan it replaces.
+ *
+ * The test hooks of afw_kvs.c (AMAZON_TESTS_ENABLE) cut the power at a random
+ * step of a set or a cleanup. After the reboot the key being set holds its old
+ * or its new value, no key has two valid entries (the rebuild finishes a set
+ * that was cut after the new entry was committed) and the index is usable.
+ *
+ * The benchmark then times afw_kvs_get() over a full shared partition, with
+ * the index and with the flash scan, and counts the flash reads of each.
+ *
+ * Build and run with "make -C scripts/host_tests kvs_index", the number of
+ * power cut runs can be given on the command line.
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define AMAZON_TESTS_ENABLE
+#include "afw_kvs.c"
+
+#define TEST_FLASH_SIZE         0x40000
+#define TEST_SECTOR_SIZE        0x1000
+#define TEST_NAMESPACES         4
+#define TEST_KEYS               24
+#define TEST_MAX_VALUE          200
+#define TEST_DEFAULT_RUNS       300
+#define TEST_BENCH_KEYS         200
+#define TEST_BENCH_ROUNDS       50
+
+uint8_t g_kvs_test_flash[TEST_FLASH_SIZE];
+
+static fm_flash_partition_t s_parts[] = {
+    { .name = "kvsShared", .size = 0x10000, .offset = 0x10000 },
+    { .name = "kvsBackup", .size = 0x10000, .offset = 0x20000 },
+    { .name = "kvsTest",   .size = 0x4000,  .offset = 0x30000 },
+    { .name = "kvsTest2",  .size = 0x4000,  .offset = 0x34000, .encrypted = 1 },
+};
+
+static fm_flash_info s_flash_info = {
+    .ulFlashSize = TEST_FLASH_SIZE,
+    .ulSectorSize = TEST_SECTOR_SIZE,
+};
+
+static unsigned char s_aes_key[16] = "host kvs key 01";
+
+/* NULL is the shared partition without a namespace */
+static const char *s_namespaces[TEST_NAMESPACES] = { NULL, "ns1", "kvsTest", "kvsTest2" };
+
+typedef struct {
+    bool present;
+    uint16_t len;
+    uint8_t value[TEST_MAX_VALUE];
+} test_value_t;
+
+static test_value_t s_model[TEST_NAMESPACES][TEST_KEYS];
+
+/* The set in flight when the power is cut */
+static struct {
+    bool active;
+    int ns;
+    int key;
+    test_value_t value;
+} s_pending;
+
+static jmp_buf s_cut_env;
+static int s_cut_at;
+static long s_reads;
+static int s_run;
+static int s_cuts;
+static int s_finished_sets;
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("kvs index: run %d: ", s_run);       \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+struct fm_flash_partition *fm_flash_get_partition(const char *name)
+{
+    for (uint32_t i = 0; i < ARRAY_SIZE(s_parts); i++) {
+        if (!strcmp(name, s_parts[i].name)) {
+            return &s_parts[i];
+        }
+    }
+    return NULL;
+}
+
+struct fm_flash_partition *fm_flash_get_partition_from_address(const int64_t addr)
+{
+    for (uint32_t i = 0; i < ARRAY_SIZE(s_parts); i++) {
+        if (addr >= s_parts[i].offset && addr < s_parts[i].offset + s_parts[i].size) {
+            return &s_parts[i];
+        }
+    }
+    return NULL;
+}
+
+struct fm_flash_partition *fm_flash_get_partition_table(int *size)
+{
+    *size = ARRAY_SIZE(s_parts);
+    return s_parts;
+}
+
+int fm_flash_get_unique_client_id(void)
+{
+    return 1;
+}
+
+fm_flash_info *fm_flash_getinfo(void)
+{
+    return &s_flash_info;
+}
+
+int fm_flash_read(struct fm_flash_partition *part, int client_id,
+                  unsigned long from, uint32_t len, uint8_t *buf)
+{
+    unsigned long base = part ? part->offset : 0;
+
+    if (base + from + len > TEST_FLASH_SIZE) {
+        FAIL("read of %u bytes at 0x%lx out of the flash", len, base + from);
+    }
+    s_reads++;
+    memcpy(buf, g_kvs_test_flash + base + from, len);
+    return len;
+}
+
+int fm_flash_write(struct fm_flash_partition *part, int client_id,
+                   unsigned long to, uint32_t len, const uint8_t *buf)
+{
+    unsigned long base = part ? part->offset : 0;
+
+    if (base + to + len > TEST_FLASH_SIZE) {
+        FAIL("write of %u bytes at 0x%lx out of the flash", len, base + to);
+    }
+    // NOR: programming only clears bits.
+    for (uint32_t i = 0; i < len; i++) {
+        g_kvs_test_flash[base + to + i] &= buf[i];
+    }
+    return len;
+}
+
+int fm_flash_erase(struct fm_flash_partition *part, int client_id)
+{
+    if (!part) {
+        return -AFW_EINVAL;
+    }
+    memset(g_kvs_test_flash + part->offset, 0xFF, part->size);
+    return AFW_OK;
+}
+
+int fm_flash_erase_sectors(struct fm_flash_partition *part, int client_id,
+                           size_t offset, size_t xBytes)
+{
+    if (!part || offset % TEST_SECTOR_SIZE || xBytes % TEST_SECTOR_SIZE ||
+        offset + xBytes > part->size) {
+        return -AFW_EINVAL;
+    }
+    memset(g_kvs_test_flash + part->offset + offset, 0xFF, xBytes);
+    return AFW_OK;
+}
+
+/* Called by afw_kvs.c between the flash steps of a set and a cleanup */
+void testReboot(void)
+{
+    if (s_cut_at > 0 && --s_cut_at == 0) {
+        longjmp(s_cut_env, 1);
+    }
+}
+
+static void key_name(char *key, int k)
+{
+    sprintf(key, "key_%02d", k);
+}
+
+static fm_flash_partition_t *entry_header(int ns, const char *key, char *header, uint8_t *header_len)
+{
+    fm_flash_partition_t *part = find_partition(s_namespaces[ns]);
+    bool shared = (part == shared_part);
+
+    *header_len = PACKED_NAMESPACE_KEY_LEN(shared, s_namespaces[ns], key);
+    populate_entry_header(s_namespaces[ns], key, header, shared);
+    return part;
+}
+
+/* Valid entries of a key in flash, the way the scan finds them */
+static int count_entries(int ns, const char *key)
+{
+    char header[MAX_NAMESPACE_LEN + MAX_KEY_LEN];
+    uint8_t header_len;
+    fm_flash_partition_t *part = entry_header(ns, key, header, &header_len);
+    afw_kvs_entry_meta_t meta;
+    int count = 0;
+
+    for (uint8_t *scan = (uint8_t *)(part->offset + sizeof(afw_kvs_partition_header_t));
+         scan < (uint8_t *)(part->offset + part->size) && *FLASH_OFFSET(scan) != 0xFF; ) {
+        memcpy(&meta, FLASH_OFFSET(scan), sizeof(meta));
+        if (meta.valid && meta.namespace_len + meta.key_len == header_len &&
+            !memcmp(header, FLASH_OFFSET(scan) + sizeof(meta), header_len) &&
+            crc_comp_check(meta.meta_crc, &meta, META_CRC_COMP_LEN) &&
+            crc_comp_check(meta.value_crc, FLASH_OFFSET(scan + sizeof(meta)),
+                           header_len + meta.value_len + 1)) {
+            count++;
+        }
+        if (!find_next_entry(&scan, part->offset + part->size)) {
+            break;
+        }
+    }
+    return count;
+}
+
+static void check_key(int ns, int k)
+{
+    char key[16];
+    char header[MAX_NAMESPACE_LEN + MAX_KEY_LEN];
+    uint8_t header_len;
+    uint8_t value[TEST_MAX_VALUE];
+    test_value_t *model = &s_model[ns][k];
+
+    key_name(key, k);
+    afw_kvs_partition_info_t *info = get_partition_info(find_partition(s_namespaces[ns]));
+    bool indexed_before = (info->index_state == KVS_INDEX_VALID);
+    long reads_before = s_reads;
+    int32_t ret = afw_kvs_get(s_namespaces[ns], key, value, sizeof(value));
+    // through the index: the meta when it is looked up, then the meta and the value
+    if (indexed_before && s_reads - reads_before > 3) {
+        FAIL("%s/%s: the get scanned the flash, %ld reads", s_namespaces[ns], key,
+             s_reads - reads_before);
+    }
+    if (!model->present) {
+        if (ret != -AFW_ENOENT) {
+            FAIL("%s/%s: deleted key read back, %ld", s_namespaces[ns], key, (long)ret);
+        }
+    } else if (ret != model->len || memcmp(value, model->value, model->len)) {
+        FAIL("%s/%s: read %ld bytes, %u expected or different", s_namespaces[ns], key,
+             (long)ret, model->len);
+    }
+
+    // the index finds the entry the flash scan finds
+    fm_flash_partition_t *part = entry_header(ns, key, header, &header_len);
+    uint8_t *indexed = find_entry(s_namespaces[ns], key);
+    uint8_t *scanned = scan_for_entry(part, header, header_len);
+    if (indexed != scanned) {
+        FAIL("%s/%s: index found 0x%lx, scan 0x%lx", s_namespaces[ns], key,
+             (unsigned long)indexed, (unsigned long)scanned);
+    }
+}
+
+static void check_all(void)
+{
+    char key[16];
+
+    for (int ns = 0; ns < TEST_NAMESPACES; ns++) {
+        for (int k = 0; k < TEST_KEYS; k++) {
+            check_key(ns, k);
+            key_name(key, k);
+            if (count_entries(ns, key) > 1) {
+                FAIL("%s/%s: several valid entries", s_namespaces[ns], key);
+            }
+        }
+    }
+    for (int i = 0; i < kvs_mgr.partition_count; i++) {
+        afw_kvs_partition_info_t *info = &kvs_mgr.partition_info[i];
+        if (info->partition != backup_part && info->index_state != KVS_INDEX_VALID) {
+            FAIL("%s: index not in use, state %d", info->partition->name, info->index_state);
+        }
+        if (*info->write_lock) {
+            FAIL("%s: lock still taken", info->partition->name);
+        }
+    }
+}
+
+static void set_one(int ns, int k)
+{
+    char key[16];
+
+    s_pending.ns = ns;
+    s_pending.key = k;
+    s_pending.value.present = true;
+    s_pending.value.len = 1 + rand() % TEST_MAX_VALUE;
+    for (int i = 0; i < s_pending.value.len; i++) {
+        s_pending.value.value[i] = rand();
+    }
+    s_pending.active = true;
+
+    key_name(key, k);
+    int32_t ret = afw_kvs_set(s_namespaces[ns], key, s_pending.value.value,
+                              s_pending.value.len, rand() % 4 == 0);
+    if (ret != AFW_OK) {
+        FAIL("%s/%s: set failed, %ld", s_namespaces[ns], key, (long)ret);
+    }
+    s_pending.active = false;
+    s_model[ns][k] = s_pending.value;
+}
+
+static void workload(int steps)
+{
+    char key[16];
+
+    for (int step = 0; step < steps; step++) {
+        int op = rand() % 100;
+        int ns = rand() % TEST_NAMESPACES;
+        int k = rand() % TEST_KEYS;
+
+        key_name(key, k);
+        if (op < 55) {
+            set_one(ns, k);
+        } else if (op < 70) {
+            int32_t ret = afw_kvs_delete(s_namespaces[ns], key);
+            if (ret != (s_model[ns][k].present ? AFW_OK : -AFW_ENOENT)) {
+                FAIL("%s/%s: delete returned %ld", s_namespaces[ns], key, (long)ret);
+            }
+            s_model[ns][k].present = false;
+        } else if (op < 95) {
+            check_key(ns, k);
+        } else if (op < 99) {
+            if (afw_kvs_cleanup(s_namespaces[ns]) != AFW_OK) {
+                FAIL("cleanup of %s failed", s_namespaces[ns]);
+            }
+        } else {
+            if (afw_kvs_delete_namespace(s_namespaces[ns]) != AFW_OK) {
+                FAIL("delete of namespace %s failed", s_namespaces[ns]);
+            }
+            for (k = 0; k < TEST_KEYS; k++) {
+                s_model[ns][k].present = false;
+            }
+        }
+    }
+}
+
+/* Drop the RAM state the way a reset does, then mount again */
+static void reboot(void)
+{
+    for (int i = 0; i < kvs_mgr.partition_count; i++) {
+        *kvs_mgr.partition_info[i].write_lock = 0;
+    }
+    afw_kvs_deinit();
+    if (afw_kvs_init(s_aes_key) != AFW_OK) {
+        FAIL("init failed");
+    }
+}
+
+static void power_cut_run(int steps)
+{
+    srand(1000 + s_run);
+    memset(g_kvs_test_flash, 0xFF, sizeof(g_kvs_test_flash));
+    memset(s_model, 0, sizeof(s_model));
+    s_pending.active = false;
+    s_cut_at = 0;
+    if (afw_kvs_init(s_aes_key) != AFW_OK) {
+        FAIL("init of the empty flash failed");
+    }
+
+    workload(rand() % steps);
+    check_all();
+
+    if (setjmp(s_cut_env) == 0) {
+        s_cut_at = 1 + rand() % 40;
+        workload(steps);
+        s_cut_at = 0;
+    } else {
+        s_cuts++;
+        if (s_pending.active) {
+            char key[16];
+            key_name(key, s_pending.key);
+            if (count_entries(s_pending.ns, key) > 1) {
+                s_finished_sets++;
+            }
+        }
+        reboot();
+
+        // the set that was cut left the old or the new value
+        if (s_pending.active) {
+            uint8_t value[TEST_MAX_VALUE];
+            char key[16];
+            key_name(key, s_pending.key);
+            int32_t ret = afw_kvs_get(s_namespaces[s_pending.ns], key, value, sizeof(value));
+            if (ret == s_pending.value.len && !memcmp(value, s_pending.value.value, ret)) {
+                s_model[s_pending.ns][s_pending.key] = s_pending.value;
+            }
+            s_pending.active = false;
+        }
+    }
+    check_all();
+
+    workload(steps / 4);
+    reboot();
+    check_all();
+    afw_kvs_deinit();
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Time afw_kvs_get() over every key of a full shared partition */
+static void bench_gets(const char *label, double *us, double *reads)
+{
+    char key[16];
+    uint8_t value[64];
+    long reads_before = s_reads;
+    double start = now_us();
+
+    for (int round = 0; round < TEST_BENCH_ROUNDS; round++) {
+        for (int k = 0; k < TEST_BENCH_KEYS; k++) {
+            sprintf(key, "bench_%03d", k);
+            if (afw_kvs_get(NULL, key, value, sizeof(value)) != 32) {
+                FAIL("%s: bench key %s not read", label, key);
+            }
+        }
+    }
+    *us = (now_us() - start) / (TEST_BENCH_ROUNDS * TEST_BENCH_KEYS);
+    *reads = (double)(s_reads - reads_before) / (TEST_BENCH_ROUNDS * TEST_BENCH_KEYS);
+}
+
+static void bench(void)
+{
+    char key[16];
+    uint8_t value[32];
+    double index_us, index_reads, scan_us, scan_reads;
+
+    memset(g_kvs_test_flash, 0xFF, sizeof(g_kvs_test_flash));
+    if (afw_kvs_init(s_aes_key) != AFW_OK) {
+        FAIL("init of the empty flash failed");
+    }
+    for (int k = 0; k < TEST_BENCH_KEYS; k++) {
+        sprintf(key, "bench_%03d", k);
+        memset(value, k, sizeof(value));
+        if (afw_kvs_set(NULL, key, value, sizeof(value), false) != AFW_OK) {
+            FAIL("bench key %s not set", key);
+        }
+    }
+
+    bench_gets("index", &index_us, &index_reads);
+    get_partition_info(shared_part)->index_state = KVS_INDEX_UNAVAILABLE;
+    bench_gets("scan", &scan_us, &scan_reads);
+    afw_kvs_deinit();
+
+    printf("kvs index: get of one of %d keys, %.2f us and %.1f flash reads with the index, "
+           "%.2f us and %.1f reads with the scan\n",
+           TEST_BENCH_KEYS, index_us, index_reads, scan_us, scan_reads);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = (argc > 1) ? atoi(argv[1]) : TEST_DEFAULT_RUNS;
+
+    for (s_run = 0; s_run < runs; s_run++) {
+        power_cut_run(400);
+    }
+    if (!s_finished_sets) {
+        FAIL("no cut left a key with two valid entries, the rebuild is not exercised");
+    }
+    printf("kvs index: %d power cut runs, %d cuts, %d sets finished by the rebuild\n",
+           runs, s_cuts, s_finished_sets);
+
+    bench();
+    return 0;
+}
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for task.h, afw_kvs.c needs nothing from it on the host.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,31 @@
+/*
+ * Host stand-in for afw_utils.h, the helpers afw_cir_buf.c uses. The real
+ * header pulls in the ACE CLI and OSAL.
+ */
+
+#ifndef AFW_UTILS_H_
+#define AFW_UTILS_H_
+
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "portmacro.h"
+#include "semphr.h"
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+#define SEMA_TAKE(sem, timeout, retv)     \
+    if (xPortIsInsideInterrupt()) {         \
+        (retv) = xSemaphoreTakeFromISR(sem, NULL); \
+    } else {  \
+        (retv) = xSemaphoreTake(sem, timeout); \
+    }
+
+#define SEMA_GIVE(sem)     \
+    if (xPortIsInsideInterrupt()) { \
+        xSemaphoreGiveFromISR(sem, NULL); \
+    } else {  \
+        xSemaphoreGive(sem); \
+    }
+
+#endif /* AFW_UTILS_H_ */
@@ -0,0 +1,280 @@
+/*
+ * Host stress check of the multi-producer ring of afw_cir_buf.c.
+ *
+ * Builds the real afw_cir_buf.c against the stub headers in this directory,
+ * its semaphores are POSIX ones. A few checks on one thread come first: the
+ * ring sizes init accepts, records wrapping the end of the ring, a record
+ * read into a buffer too small for it.
+ *
+ * Then task producer threads write records of random lengths into a small
+ * ring, half of them with afw_mpsc_ring_write_block(), half reserving,
+ * copying in two pieces and committing. One more producer thread declares
+ * itself an interrupt: it never waits and its writes fail when the ring is
+ * full. The main thread is the consumer. Each record holds its producer, its
+ * sequence number and a pattern:
+ *  - the records of each producer come out in order and intact;
+ *  - none of the task producers loses a record, the interrupt producer only
+ *    the ones it was told were not written;
+ *  - the ring is empty at the end.
+ *
+ * Build and run with "make -C scripts/host_tests mpsc_ring".
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <afw_cir_buf.h>
+#include <afw_error.h>
+
+#define TEST_RING_SIZE      1024
+#define TEST_TASKS          3
+#define TEST_PRODUCERS      (TEST_TASKS + 1)
+#define TEST_RECORDS        100000
+#define TEST_ISR_RECORDS    20000
+#define TEST_MAX_DATA       300
+#define TEST_WAIT_TICKS     2000
+#define TEST_TIMEOUT_S      120
+
+typedef struct {
+    uint16_t producer;
+    uint16_t len;
+    uint32_t seq;
+} record_head_t;
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("mpsc ring: ");                      \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+__thread BaseType_t mpsc_ring_in_isr;
+
+static afw_mpsc_ring_t *s_ring;
+static volatile int s_producers_done;
+static uint32_t s_isr_written;
+static uint32_t s_isr_rejected;
+static uint32_t s_reserve_retries[TEST_PRODUCERS];
+
+static void timed_out(int sig)
+{
+    static const char msg[] = "mpsc ring: timed out\n";
+
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+static uint8_t pattern(uint32_t producer, uint32_t seq, uint32_t i)
+{
+    return (uint8_t)(seq * 31 + producer * 7 + i);
+}
+
+static uint32_t make_record(uint8_t *record, uint32_t producer, uint32_t seq, unsigned *rand_state)
+{
+    uint32_t len = sizeof(record_head_t) + rand_r(rand_state) % (TEST_MAX_DATA - sizeof(record_head_t) + 1);
+    record_head_t head = { .producer = producer, .len = len, .seq = seq };
+
+    memcpy(record, &head, sizeof(head));
+    for (uint32_t i = sizeof(head); i < len; i++) {
+        record[i] = pattern(producer, seq, i);
+    }
+    return len;
+}
+
+static void *task_producer(void *arg)
+{
+    uint32_t producer = (uint32_t)(uintptr_t)arg;
+    unsigned rand_state = producer + 1;
+    uint8_t record[TEST_MAX_DATA];
+
+    for (uint32_t seq = 0; seq < TEST_RECORDS; seq++) {
+        uint32_t len = make_record(record, producer, seq, &rand_state);
+
+        if (seq & 1) {
+            int32_t rc = afw_mpsc_ring_write_block(s_ring, record, len, TEST_WAIT_TICKS);
+
+            if (rc != 0) {
+                FAIL("producer %u: record %u not written: %d", producer, seq, rc);
+            }
+        } else {
+            afw_mpsc_ring_slot_t slot;
+            uint32_t split = rand_r(&rand_state) % (len + 1);
+
+            while (afw_mpsc_ring_reserve(s_ring, len, &slot) == -AFW_EIO) {
+                s_reserve_retries[producer]++;
+                sched_yield();
+            }
+            afw_mpsc_ring_slot_copy(s_ring, &slot, 0, record, split);
+            sched_yield();
+            afw_mpsc_ring_slot_copy(s_ring, &slot, split, record + split, len - split);
+            afw_mpsc_ring_commit(s_ring, &slot);
+        }
+    }
+    __atomic_add_fetch(&s_producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Never waits: both write calls fail at once when the ring is full */
+static void *isr_producer(void *arg)
+{
+    uint32_t producer = TEST_TASKS;
+    unsigned rand_state = producer + 1;
+    uint8_t record[TEST_MAX_DATA];
+
+    mpsc_ring_in_isr = pdTRUE;
+    for (uint32_t n = 0; n < TEST_ISR_RECORDS; n++) {
+        uint32_t len = make_record(record, producer, s_isr_written, &rand_state);
+        int32_t rc = (n & 1) ? afw_mpsc_ring_write(s_ring, record, len) :
+                               afw_mpsc_ring_write_block(s_ring, record, len, TEST_WAIT_TICKS);
+
+        if (rc == 0) {
+            s_isr_written++;
+        } else if (rc == -AFW_EIO) {
+            s_isr_rejected++;
+        } else {
+            FAIL("interrupt write failed with %d", rc);
+        }
+        if (n % 64 == 0) {
+            usleep(50);
+        }
+    }
+    __atomic_add_fetch(&s_producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void check_record(const uint8_t *record, int32_t len, uint32_t *expected)
+{
+    record_head_t head;
+
+    if (len < (int32_t)sizeof(head)) {
+        FAIL("record of %d bytes read", len);
+    }
+    memcpy(&head, record, sizeof(head));
+    if (head.producer >= TEST_PRODUCERS || head.len != len) {
+        FAIL("record of %d bytes from producer %u, %u bytes long", len, head.producer, head.len);
+    }
+    if (head.seq != expected[head.producer]) {
+        FAIL("producer %u: record %u read, %u expected", head.producer, head.seq, expected[head.producer]);
+    }
+    for (int32_t i = sizeof(head); i < len; i++) {
+        if (record[i] != pattern(head.producer, head.seq, i)) {
+            FAIL("producer %u: record %u corrupt at byte %d", head.producer, head.seq, i);
+        }
+    }
+    expected[head.producer]++;
+}
+
+static void single_thread_checks(void)
+{
+    static const uint32_t bad_sizes[] = { 0, 1, 2, 3, 6, 12, 100, 1000, 1025 };
+    static const uint32_t good_sizes[] = { 4, 8, 64, 1024 };
+    uint8_t data[64];
+    uint8_t out[64];
+    afw_mpsc_ring_t *ring;
+
+    for (uint32_t i = 0; i < sizeof(bad_sizes) / sizeof(bad_sizes[0]); i++) {
+        ring = afw_mpsc_ring_init(bad_sizes[i]);
+        if (ring) {
+            FAIL("ring of %u bytes accepted", bad_sizes[i]);
+        }
+    }
+    for (uint32_t i = 0; i < sizeof(good_sizes) / sizeof(good_sizes[0]); i++) {
+        ring = afw_mpsc_ring_init(good_sizes[i]);
+        if (!ring) {
+            FAIL("ring of %u bytes refused", good_sizes[i]);
+        }
+        afw_mpsc_ring_deinit(&ring);
+    }
+
+    /* records of 4 + 21 -> 28 bytes walk around a 64 byte ring */
+    ring = afw_mpsc_ring_init(64);
+    for (uint32_t n = 0; n < 50; n++) {
+        memset(data, n, sizeof(data));
+        if (afw_mpsc_ring_write(ring, data, 21) != 0 || afw_mpsc_ring_write(ring, data, 21) != 0) {
+            FAIL("write %u into the 64 byte ring failed", n);
+        }
+        if (afw_mpsc_ring_write(ring, data, 21) != -AFW_EIO) {
+            FAIL("third record accepted by the 64 byte ring");
+        }
+        for (int k = 0; k < 2; k++) {
+            if (afw_mpsc_ring_read(ring, out, sizeof(out)) != 21 || memcmp(out, data, 21) != 0) {
+                FAIL("record %u read back wrong after %u bytes", n, n * 56);
+            }
+        }
+    }
+
+    /* a record too large for the buffer is dropped, the next one reads */
+    afw_mpsc_ring_write(ring, data, 30);
+    afw_mpsc_ring_write(ring, data, 10);
+    if (afw_mpsc_ring_read(ring, out, 20) != -AFW_ENOMEM || afw_mpsc_ring_read(ring, out, 20) != 10 ||
+        afw_mpsc_ring_get_data_size(ring) != 0) {
+        FAIL("record larger than the read buffer not dropped");
+    }
+    afw_mpsc_ring_deinit(&ring);
+}
+
+int main(void)
+{
+    pthread_t threads[TEST_PRODUCERS];
+    uint32_t expected[TEST_PRODUCERS] = { 0 };
+    uint8_t record[TEST_MAX_DATA];
+    uint64_t reads = 0;
+    uint64_t empty_reads = 0;
+    uint32_t retries = 0;
+
+    signal(SIGALRM, timed_out);
+    alarm(TEST_TIMEOUT_S);
+
+    single_thread_checks();
+
+    s_ring = afw_mpsc_ring_init(TEST_RING_SIZE);
+    for (uintptr_t i = 0; i < TEST_TASKS; i++) {
+        pthread_create(&threads[i], NULL, task_producer, (void *)i);
+    }
+    pthread_create(&threads[TEST_TASKS], NULL, isr_producer, NULL);
+
+    while (1) {
+        int done = __atomic_load_n(&s_producers_done, __ATOMIC_ACQUIRE);
+        int32_t len = afw_mpsc_ring_read(s_ring, record, sizeof(record));
+
+        if (len == -AFW_EIO) {
+            if (done == TEST_PRODUCERS) {
+                break;
+            }
+            empty_reads++;
+            sched_yield();
+            continue;
+        }
+        check_record(record, len, expected);
+        reads++;
+    }
+
+    for (int i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < TEST_TASKS; i++) {
+        if (expected[i] != TEST_RECORDS) {
+            FAIL("producer %d: %u of %u records read", i, expected[i], TEST_RECORDS);
+        }
+        retries += s_reserve_retries[i];
+    }
+    if (expected[TEST_TASKS] != s_isr_written) {
+        FAIL("interrupt producer: %u of %u records written read", expected[TEST_TASKS], s_isr_written);
+    }
+    if (afw_mpsc_ring_get_data_size(s_ring) != 0) {
+        FAIL("%d bytes left in the ring", afw_mpsc_ring_get_data_size(s_ring));
+    }
+    afw_mpsc_ring_deinit(&s_ring);
+
+    printf("mpsc ring: %llu records through a %u byte ring from %d producers, "
+           "%u interrupt writes refused when full, %u reserve retries, %llu empty reads\n",
+           (unsigned long long)reads, TEST_RING_SIZE, TEST_PRODUCERS, s_isr_rejected, retries,
+           (unsigned long long)empty_reads);
+    return 0;
+}
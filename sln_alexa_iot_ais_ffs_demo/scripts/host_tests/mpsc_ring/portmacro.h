@@ -0,0 +1,20 @@
+/*
+ * Host stand-in for portmacro.h. A producer thread of the test can declare
+ * itself an interrupt, the ring then takes its ISR paths.
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include "FreeRTOS.h"
+
+extern __thread BaseType_t mpsc_ring_in_isr;
+
+static inline BaseType_t xPortIsInsideInterrupt(void)
+{
+    return mpsc_ring_in_isr;
+}
+
+#define portYIELD_FROM_ISR_WRAP(x) ((void)(x))
+
+#endif /* PORTMACRO_H */
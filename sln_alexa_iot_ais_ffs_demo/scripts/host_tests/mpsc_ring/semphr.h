@@ -0,0 +1,89 @@
+/*
+ * Host stand-in for semphr.h on POSIX threads. Binary semaphores and mutexes
+ * are a count of at most one under a mutex, a take waits on a condition
+ * variable for the ticks given, a tick is a millisecond.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+
+struct pthread_semaphore {
+    pthread_mutex_t lock;
+    pthread_cond_t given;
+    int count;
+};
+
+typedef struct pthread_semaphore *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t pthread_semaphore_create(int count)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->given, NULL);
+    sem->count = count;
+    return sem;
+}
+
+#define xSemaphoreCreateBinary() pthread_semaphore_create(0)
+#define xSemaphoreCreateMutex()  pthread_semaphore_create(1)
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->lock);
+    pthread_cond_destroy(&sem->given);
+    free(sem);
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    struct timespec deadline;
+    int rc = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += wait / 1000;
+    deadline.tv_nsec += (long)(wait % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && rc != ETIMEDOUT) {
+        if (wait == portMAX_DELAY) {
+            pthread_cond_wait(&sem->given, &sem->lock);
+        } else if (wait == 0) {
+            rc = ETIMEDOUT;
+        } else {
+            rc = pthread_cond_timedwait(&sem->given, &sem->lock, &deadline);
+        }
+    }
+    if (sem->count == 0) {
+        pthread_mutex_unlock(&sem->lock);
+        return pdFALSE;
+    }
+    sem->count = 0;
+    pthread_mutex_unlock(&sem->lock);
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    sem->count = 1;
+    pthread_cond_signal(&sem->given);
+    pthread_mutex_unlock(&sem->lock);
+    return pdTRUE;
+}
+
+#define xSemaphoreTakeFromISR(s, w) xSemaphoreTake((s), 0)
+#define xSemaphoreGiveFromISR(s, w) xSemaphoreGive(s)
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build sln_iot_pkcs11_pal.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ( ( BaseType_t ) 0 )
+#define pdTRUE  ( ( BaseType_t ) 1 )
+
+#define portMAX_DELAY ( ( TickType_t ) 0xffffffffUL )
+
+#define configPRINTF( x )
+
+/* Counted by the test, the private key must not go to the heap */
+void *pvPortMalloc( size_t xWantedSize );
+void vPortFree( void *pv );
+
+#endif /* INC_FREERTOS_H */
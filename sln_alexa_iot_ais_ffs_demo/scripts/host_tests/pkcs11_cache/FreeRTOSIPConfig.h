@@ -0,0 +1,3 @@
+/*
+ * Host stand-in for FreeRTOSIPConfig.h, nothing of it is used by the PAL.
+ */
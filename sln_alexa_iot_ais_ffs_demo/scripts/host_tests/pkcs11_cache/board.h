@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for board.h: the registers PKCS11_KeyGen() salts the key
+ * phrase with.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t DIGPROG;
+} USB_ANALOG_Type;
+
+typedef struct
+{
+    uint32_t CFG3;
+} OCOTP_Type;
+
+extern USB_ANALOG_Type g_usbAnalog;
+extern OCOTP_Type g_ocotp;
+
+#define USB_ANALOG (&g_usbAnalog)
+#define OCOTP      (&g_ocotp)
+
+#endif /* _BOARD_H_ */
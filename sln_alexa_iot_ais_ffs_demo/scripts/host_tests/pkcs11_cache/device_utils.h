@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for device_utils.h.
+ */
+
+#ifndef DEVICE_UTILS_H_
+#define DEVICE_UTILS_H_
+
+#include <stdbool.h>
+
+void APP_GetUniqueID(char **uniqueID, bool removeSpecialCharacters);
+void APP_GetHexUniqueID(char **uniqueID);
+void PKCS11_KeyGen(char **keyPhrase);
+
+#endif /* DEVICE_UTILS_H_ */
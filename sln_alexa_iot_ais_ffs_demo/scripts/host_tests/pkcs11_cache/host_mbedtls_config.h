@@ -0,0 +1,19 @@
+/*
+ * mbedTLS configuration of the host PKCS#11 cache check: SHA256 for the
+ * digests of the cached objects, and what PKCS11_KeyGen() links against.
+ */
+
+#ifndef HOST_MBEDTLS_CONFIG_H
+#define HOST_MBEDTLS_CONFIG_H
+
+#define MBEDTLS_BASE64_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_PKCS5_C
+#define MBEDTLS_SHA256_C
+
+/* Only for the declarations of x509_crt.h, not linked */
+#define MBEDTLS_BIGNUM_C
+
+#include "mbedtls/check_config.h"
+
+#endif /* HOST_MBEDTLS_CONFIG_H */
@@ -0,0 +1,3 @@
+/*
+ * Host stand-in for iot_crypto.h, nothing of it is used by the PAL.
+ */
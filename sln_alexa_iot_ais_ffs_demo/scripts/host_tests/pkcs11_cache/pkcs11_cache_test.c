@@ -0,0 +1,300 @@
+/*
+ * Host check of the object cache of sln_iot_pkcs11_pal.c, by its flash reads.
+ *
+ * Builds the real PAL against the stub headers in this directory. The files are
+ * kept in RAM by a fake SLN_FLASH_MGMT_Read(), which counts its calls. Writes
+ * and erases go through fake_save() / fake_erase(), which call
+ * PKCS11_PAL_FileChanged() after the write, as the flash management does with
+ * the file_changed_cb set in main.c. The check goes through:
+ *  - objects looked up before they are provisioned: not found, and found as
+ *    soon as they are saved, no cached absence;
+ *  - repeated reads of a cached object: no flash read;
+ *  - a file written again, with and without a copy of it still handed out:
+ *    the next read gets the new data;
+ *  - writes to other files: the cache is kept;
+ *  - an erased file: no longer found;
+ *  - the private key never goes to the heap.
+ *
+ * Build and run with "make -C scripts/host_tests pkcs11_cache".
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "device_utils.h"
+#include "FreeRTOS.h"
+#include "iot_pkcs11.h"
+#include "iot_pkcs11_config.h"
+#include "iot_pkcs11_pal.h"
+#include "sln_flash_mgmt.h"
+
+#define TEST_FILE_MAX 4096
+#define TEST_READS    1000
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("pkcs11 cache: ");       \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+typedef struct
+{
+    const char *name;
+    uint8_t data[TEST_FILE_MAX];
+    uint32_t len;
+    int present;
+} fake_file_t;
+
+static fake_file_t s_files[] = {
+    {.name = "cert.dat"},
+    {.name = "pkey.dat"},
+    {.name = "FreeRTOS_P11_CodeSignKey.dat"},
+    {.name = "alerts.dat"},
+};
+
+USB_ANALOG_Type g_usbAnalog;
+OCOTP_Type g_ocotp;
+
+static uint32_t s_flashReads;
+static uint32_t s_heapAllocs;
+
+void *pvPortMalloc(size_t xWantedSize)
+{
+    s_heapAllocs++;
+    return malloc(xWantedSize);
+}
+
+void vPortFree(void *pv)
+{
+    free(pv);
+}
+
+CK_RV prvMbedTLS_Initialize(void)
+{
+    return CKR_OK;
+}
+
+void APP_GetUniqueID(char **uniqueID, bool removeSpecialCharacters)
+{
+    *uniqueID = strdup("unique");
+}
+
+void APP_GetHexUniqueID(char **uniqueID)
+{
+    *uniqueID = strdup("0011223344556677");
+}
+
+static fake_file_t *fake_find(const char *name)
+{
+    for (uint32_t idx = 0; idx < sizeof(s_files) / sizeof(s_files[0]); idx++)
+    {
+        if (0 == strcmp(s_files[idx].name, name))
+        {
+            return &s_files[idx];
+        }
+    }
+
+    FAIL("read of unknown file %s", name);
+    return NULL;
+}
+
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
+{
+    fake_file_t *file = fake_find(name);
+
+    s_flashReads++;
+
+    if (!file->present)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY2;
+    }
+
+    if (NULL != data)
+    {
+        if (*len < file->len)
+        {
+            FAIL("read of %s in %u bytes, %u needed", name, *len, file->len);
+        }
+        memcpy(data, file->data, file->len);
+    }
+    *len = file->len;
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+static void fake_save(const char *name, uint32_t len, uint8_t seed)
+{
+    fake_file_t *file = fake_find(name);
+
+    for (uint32_t idx = 0; idx < len; idx++)
+    {
+        file->data[idx] = (uint8_t)(seed + idx * 7);
+    }
+    file->len     = len;
+    file->present = 1;
+
+    PKCS11_PAL_FileChanged(name);
+}
+
+static void fake_erase(const char *name)
+{
+    fake_find(name)->present = 0;
+
+    PKCS11_PAL_FileChanged(name);
+}
+
+static CK_OBJECT_HANDLE find(const char *label)
+{
+    return PKCS11_PAL_FindObject((uint8_t *)label, (uint8_t)strlen(label));
+}
+
+/* Reads the object and checks it holds the file, the buffer is handed back unless kept */
+static uint8_t *get(CK_OBJECT_HANDLE handle, const char *name, int keep)
+{
+    fake_file_t *file = fake_find(name);
+    uint8_t *data     = NULL;
+    uint32_t len      = 0;
+    CK_BBOOL isPrivate;
+
+    if (CKR_OK != PKCS11_PAL_GetObjectValue(handle, &data, &len, &isPrivate))
+    {
+        FAIL("%s not read", name);
+    }
+    if ((len != file->len) || (0 != memcmp(data, file->data, len)) || (0 != data[len]))
+    {
+        FAIL("%s read with %u bytes, %u in flash", name, len, file->len);
+    }
+
+    if (!keep)
+    {
+        PKCS11_PAL_GetObjectValueCleanup(data, len);
+        data = NULL;
+    }
+
+    return data;
+}
+
+static void expect_reads(uint32_t before, uint32_t reads, const char *what)
+{
+    if (s_flashReads - before != reads)
+    {
+        FAIL("%s: %u flash reads, %u expected", what, s_flashReads - before, reads);
+    }
+}
+
+int main(void)
+{
+    CK_OBJECT_HANDLE cert;
+    CK_OBJECT_HANDLE key;
+    uint32_t before;
+    uint32_t gets = 0;
+    uint8_t *held;
+
+    if (CKR_OK != C_Initialize(NULL))
+    {
+        FAIL("C_Initialize");
+    }
+
+    /* Not provisioned yet, looked for at every connection attempt */
+    for (uint32_t idx = 0; idx < 3; idx++)
+    {
+        if (0 != find(pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS))
+        {
+            FAIL("certificate found before it is saved");
+        }
+    }
+
+    /* Provisioning, found at once, no reboot */
+    fake_save("cert.dat", 1200, 1);
+    fake_save("pkey.dat", 1700, 2);
+
+    before = s_flashReads;
+    cert   = find(pkcs11configLABEL_DEVICE_CERTIFICATE_FOR_TLS);
+    key    = find(pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS);
+    if ((0 == cert) || (0 == key))
+    {
+        FAIL("objects not found after they are saved");
+    }
+    expect_reads(before, 4, "first lookup");
+
+    /* Every TLS connection reads both, from RAM */
+    before = s_flashReads;
+    for (uint32_t idx = 0; idx < TEST_READS; idx++)
+    {
+        get(cert, "cert.dat", 0);
+        get(key, "pkey.dat", 0);
+        gets += 2;
+    }
+    expect_reads(before, 0, "cached reads");
+
+    /* The private key lives in the private area */
+    fake_save("pkey.dat", 1650, 3);
+    before = s_heapAllocs;
+    get(key, "pkey.dat", 0);
+    get(find(pkcs11configLABEL_DEVICE_PUBLIC_KEY_FOR_TLS), "pkey.dat", 0);
+    gets += 2;
+    if (s_heapAllocs != before)
+    {
+        FAIL("private key copied to the heap");
+    }
+
+    /* Other files written, the alerts journal in particular */
+    before = s_flashReads;
+    for (uint32_t idx = 0; idx < 50; idx++)
+    {
+        fake_save("alerts.dat", 100 + idx, (uint8_t)idx);
+        get(cert, "cert.dat", 0);
+        gets++;
+    }
+    expect_reads(before, 0, "other files written");
+
+    /* Certificate rotated: read again once, then cached */
+    fake_save("cert.dat", 1100, 4);
+    before = s_flashReads;
+    get(cert, "cert.dat", 0);
+    get(cert, "cert.dat", 0);
+    gets += 2;
+    expect_reads(before, 2, "certificate rotated");
+
+    /* Rotated while a connection still holds the old one */
+    held = get(cert, "cert.dat", 1);
+    fake_save("cert.dat", 1300, 5);
+    get(cert, "cert.dat", 0);
+    PKCS11_PAL_GetObjectValueCleanup(held, 1100);
+    before = s_flashReads;
+    get(cert, "cert.dat", 0);
+    get(cert, "cert.dat", 0);
+    gets += 4;
+    expect_reads(before, 2, "rotated while held");
+
+    /* Deprovisioned */
+    fake_erase("pkey.dat");
+    if ((0 != find(pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS)) ||
+        (0 != find(pkcs11configLABEL_DEVICE_PUBLIC_KEY_FOR_TLS)))
+    {
+        FAIL("key found after it is erased");
+    }
+    fake_save("pkey.dat", 1600, 6);
+    if (0 == find(pkcs11configLABEL_DEVICE_PRIVATE_KEY_FOR_TLS))
+    {
+        FAIL("key not found after it is saved again");
+    }
+    get(key, "pkey.dat", 0);
+    gets++;
+
+    /* C_Finalize */
+    PKCS11_PAL_WipeCache();
+    before = s_flashReads;
+    get(cert, "cert.dat", 0);
+    gets++;
+    expect_reads(before, 2, "after the wipe");
+
+    printf("pkcs11 cache: %u object reads, %u flash reads (%u without the cache)\n", gets, s_flashReads,
+           gets * 2);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+/*
+ * Host stand-in for sln_flash_mgmt.h. The test keeps the files in RAM and
+ * counts the reads.
+ */
+
+#ifndef _SLN_FLASH_MGMT_
+#define _SLN_FLASH_MGMT_
+
+#include <stdint.h>
+
+typedef enum _sln_flash_mgmt_status
+{
+    SLN_FLASH_MGMT_OK        = 0x00,
+    SLN_FLASH_MGMT_ENOENTRY2 = -0x51,
+} sln_flash_mgmt_status_t;
+
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len);
+
+#endif /* _SLN_FLASH_MGMT_ */
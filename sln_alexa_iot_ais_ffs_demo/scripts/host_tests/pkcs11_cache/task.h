@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for task.h, nothing of it is used by the PAL.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,843 @@
+/*
+ * Host stand-in for the cJSON of libs/libcjson2.a, which is only built for the
+ * target. The part of the cJSON.h API the smart home modules use, with the
+ * behaviour of cJSON 1.7.7 where a caller can see it:
+ *  - cJSON_Parse() returns NULL on any error, text after the first value is
+ *    ignored, nesting is limited to CJSON_NESTING_LIMIT;
+ *  - the getters take NULL and items of the wrong type and return NULL;
+ *  - valueint is valuedouble saturated to the int range.
+ * The items alive are counted, for the leak checks.
+ */
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "cJSON.h"
+
+typedef struct
+{
+    const char *text;
+    size_t offset;
+    size_t depth;
+} parser_t;
+
+static long s_liveItems;
+
+static cJSON *ParseValue(parser_t *parser);
+
+long cJSON_HostLiveItems(void)
+{
+    return s_liveItems;
+}
+
+void *cJSON_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void cJSON_free(void *object)
+{
+    free(object);
+}
+
+static cJSON *NewItem(int type)
+{
+    cJSON *item = calloc(1, sizeof(cJSON));
+
+    if (item != NULL)
+    {
+        item->type = type;
+        s_liveItems++;
+    }
+    return item;
+}
+
+static char *Duplicate(const char *string)
+{
+    size_t length = strlen(string) + 1;
+    char *copy    = malloc(length);
+
+    if (copy != NULL)
+    {
+        memcpy(copy, string, length);
+    }
+    return copy;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    cJSON *next;
+
+    while (item != NULL)
+    {
+        next = item->next;
+        if (!(item->type & cJSON_IsReference))
+        {
+            cJSON_Delete(item->child);
+            free(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst))
+        {
+            free(item->string);
+        }
+        free(item);
+        s_liveItems--;
+        item = next;
+    }
+}
+
+static void SkipWhitespace(parser_t *parser)
+{
+    while ((parser->text[parser->offset] != '\0') && ((unsigned char)parser->text[parser->offset] <= ' '))
+    {
+        parser->offset++;
+    }
+}
+
+static int ParseHex4(const char *text, unsigned int *value)
+{
+    *value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        char c = text[i];
+
+        *value <<= 4;
+        if ((c >= '0') && (c <= '9'))
+        {
+            *value |= (unsigned int)(c - '0');
+        }
+        else if ((c >= 'a') && (c <= 'f'))
+        {
+            *value |= (unsigned int)(c - 'a' + 10);
+        }
+        else if ((c >= 'A') && (c <= 'F'))
+        {
+            *value |= (unsigned int)(c - 'A' + 10);
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Decodes the \u escape at text, surrogate pairs included, returns the length of the escape or 0 */
+static size_t ParseUtf16(const char *text, char **out)
+{
+    unsigned int first, second, codepoint;
+    size_t length = 6;
+    size_t bytes;
+    unsigned char lead;
+
+    if (!ParseHex4(text + 2, &first) || ((first >= 0xDC00) && (first <= 0xDFFF)))
+    {
+        return 0;
+    }
+    codepoint = first;
+    if ((first >= 0xD800) && (first <= 0xDBFF))
+    {
+        if ((text[6] != '\\') || (text[7] != 'u') || !ParseHex4(text + 8, &second) || (second < 0xDC00) ||
+            (second > 0xDFFF))
+        {
+            return 0;
+        }
+        codepoint = 0x10000 + (((first & 0x3FF) << 10) | (second & 0x3FF));
+        length    = 12;
+    }
+
+    if (codepoint < 0x80)
+    {
+        bytes = 1;
+        lead  = 0x00;
+    }
+    else if (codepoint < 0x800)
+    {
+        bytes = 2;
+        lead  = 0xC0;
+    }
+    else if (codepoint < 0x10000)
+    {
+        bytes = 3;
+        lead  = 0xE0;
+    }
+    else
+    {
+        bytes = 4;
+        lead  = 0xF0;
+    }
+    for (size_t i = bytes - 1; i > 0; i--)
+    {
+        (*out)[i] = (char)((codepoint | 0x80) & 0xBF);
+        codepoint >>= 6;
+    }
+    (*out)[0] = (char)(codepoint | lead);
+    *out += bytes;
+
+    return length;
+}
+
+/* Parses the string at the offset, returns a malloc'ed copy or NULL */
+static char *ParseStringText(parser_t *parser)
+{
+    const char *start = parser->text + parser->offset + 1;
+    const char *end   = start;
+    char *copy, *out;
+
+    if (parser->text[parser->offset] != '"')
+    {
+        return NULL;
+    }
+    while ((*end != '\0') && (*end != '"'))
+    {
+        end += (end[0] == '\\' && end[1] != '\0') ? 2 : 1;
+    }
+    if (*end != '"')
+    {
+        return NULL;
+    }
+
+    /* The decoded string is never longer than the escaped one */
+    copy = malloc((size_t)(end - start) + 1);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    out = copy;
+    for (const char *in = start; in < end;)
+    {
+        size_t length = 2;
+
+        if (*in != '\\')
+        {
+            *out++ = *in++;
+            continue;
+        }
+        switch (in[1])
+        {
+            case 'b':
+                *out++ = '\b';
+                break;
+            case 'f':
+                *out++ = '\f';
+                break;
+            case 'n':
+                *out++ = '\n';
+                break;
+            case 'r':
+                *out++ = '\r';
+                break;
+            case 't':
+                *out++ = '\t';
+                break;
+            case '"':
+            case '\\':
+            case '/':
+                *out++ = in[1];
+                break;
+            case 'u':
+                length = ((end - in) >= 6) ? ParseUtf16(in, &out) : 0;
+                break;
+            default:
+                length = 0;
+                break;
+        }
+        if ((length == 0) || (in + length > end))
+        {
+            free(copy);
+            return NULL;
+        }
+        in += length;
+    }
+    *out = '\0';
+    parser->offset = (size_t)(end - parser->text) + 1;
+
+    return copy;
+}
+
+static cJSON *ParseNumber(parser_t *parser)
+{
+    const char *start = parser->text + parser->offset;
+    char digits[64];
+    size_t length = 0;
+    char *end;
+    double number;
+
+    if ((*start != '-') && !isdigit((unsigned char)*start))
+    {
+        return NULL;
+    }
+    /* Only the characters of a JSON number go to strtod, as in cJSON: no "inf" or hex */
+    while ((length < sizeof(digits) - 1) && (isdigit((unsigned char)start[length]) || (start[length] == '+') ||
+                                             (start[length] == '-') || (start[length] == '.') ||
+                                             (start[length] == 'e') || (start[length] == 'E')))
+    {
+        digits[length] = start[length];
+        length++;
+    }
+    digits[length] = '\0';
+    number         = strtod(digits, &end);
+    if (end == digits)
+    {
+        return NULL;
+    }
+    parser->offset += (size_t)(end - digits);
+
+    return cJSON_CreateNumber(number);
+}
+
+/* Parses the items of an array or object up to the closing character */
+static cJSON *ParseChildren(parser_t *parser, int type, char close)
+{
+    cJSON *container, *child, *last = NULL;
+    char *name = NULL;
+
+    if (++parser->depth > CJSON_NESTING_LIMIT)
+    {
+        return NULL;
+    }
+    container = NewItem(type);
+    parser->offset++;
+    SkipWhitespace(parser);
+    if (parser->text[parser->offset] == close)
+    {
+        parser->offset++;
+        parser->depth--;
+        return container;
+    }
+
+    while (1)
+    {
+        SkipWhitespace(parser);
+        if (type == cJSON_Object)
+        {
+            name = ParseStringText(parser);
+            SkipWhitespace(parser);
+            if ((name == NULL) || (parser->text[parser->offset] != ':'))
+            {
+                break;
+            }
+            parser->offset++;
+            SkipWhitespace(parser);
+        }
+
+        child = ParseValue(parser);
+        if (child == NULL)
+        {
+            break;
+        }
+        child->string = name;
+        name          = NULL;
+        if (last == NULL)
+        {
+            container->child = child;
+        }
+        else
+        {
+            last->next  = child;
+            child->prev = last;
+        }
+        last = child;
+
+        SkipWhitespace(parser);
+        if (parser->text[parser->offset] == close)
+        {
+            parser->offset++;
+            parser->depth--;
+            return container;
+        }
+        if (parser->text[parser->offset] != ',')
+        {
+            break;
+        }
+        parser->offset++;
+    }
+
+    free(name);
+    cJSON_Delete(container);
+    return NULL;
+}
+
+static cJSON *ParseValue(parser_t *parser)
+{
+    const char *text = parser->text + parser->offset;
+    cJSON *item      = NULL;
+    char *string;
+
+    if (strncmp(text, "null", 4) == 0)
+    {
+        item = NewItem(cJSON_NULL);
+        parser->offset += 4;
+    }
+    else if (strncmp(text, "false", 5) == 0)
+    {
+        item = NewItem(cJSON_False);
+        parser->offset += 5;
+    }
+    else if (strncmp(text, "true", 4) == 0)
+    {
+        item           = NewItem(cJSON_True);
+        item->valueint = 1;
+        parser->offset += 4;
+    }
+    else if (*text == '"')
+    {
+        string = ParseStringText(parser);
+        if (string != NULL)
+        {
+            item              = NewItem(cJSON_String);
+            item->valuestring = string;
+        }
+    }
+    else if (*text == '[')
+    {
+        item = ParseChildren(parser, cJSON_Array, ']');
+    }
+    else if (*text == '{')
+    {
+        item = ParseChildren(parser, cJSON_Object, '}');
+    }
+    else
+    {
+        item = ParseNumber(parser);
+    }
+
+    return item;
+}
+
+cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    parser_t parser = {value, 0, 0};
+    cJSON *item;
+
+    if (value == NULL)
+    {
+        return NULL;
+    }
+    SkipWhitespace(&parser);
+    item = ParseValue(&parser);
+    if ((item != NULL) && require_null_terminated)
+    {
+        SkipWhitespace(&parser);
+        if (value[parser.offset] != '\0')
+        {
+            cJSON_Delete(item);
+            item = NULL;
+        }
+    }
+    if ((item != NULL) && (return_parse_end != NULL))
+    {
+        *return_parse_end = value + parser.offset;
+    }
+
+    return item;
+}
+
+cJSON *cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, NULL, 0);
+}
+
+typedef struct
+{
+    char *buffer;
+    size_t length;
+    size_t size;
+} printer_t;
+
+static void Append(printer_t *printer, const char *text, size_t length)
+{
+    if (printer->length + length + 1 > printer->size)
+    {
+        printer->size   = 2 * (printer->length + length + 1);
+        printer->buffer = realloc(printer->buffer, printer->size);
+    }
+    memcpy(printer->buffer + printer->length, text, length);
+    printer->length += length;
+    printer->buffer[printer->length] = '\0';
+}
+
+static void PrintString(printer_t *printer, const char *string)
+{
+    char escape[8];
+
+    Append(printer, "\"", 1);
+    for (const unsigned char *c = (const unsigned char *)((string != NULL) ? string : ""); *c != '\0'; c++)
+    {
+        if ((*c == '"') || (*c == '\\'))
+        {
+            escape[0] = '\\';
+            escape[1] = (char)*c;
+            Append(printer, escape, 2);
+        }
+        else if (*c < ' ')
+        {
+            snprintf(escape, sizeof(escape), "\\u%04x", *c);
+            Append(printer, escape, 6);
+        }
+        else
+        {
+            Append(printer, (const char *)c, 1);
+        }
+    }
+    Append(printer, "\"", 1);
+}
+
+static void PrintValue(printer_t *printer, const cJSON *item)
+{
+    char number[32];
+    const cJSON *child;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_NULL:
+            Append(printer, "null", 4);
+            break;
+        case cJSON_False:
+            Append(printer, "false", 5);
+            break;
+        case cJSON_True:
+            Append(printer, "true", 4);
+            break;
+        case cJSON_Number:
+            if (item->valuedouble == (double)item->valueint)
+            {
+                snprintf(number, sizeof(number), "%d", item->valueint);
+            }
+            else
+            {
+                snprintf(number, sizeof(number), "%1.17g", item->valuedouble);
+            }
+            Append(printer, number, strlen(number));
+            break;
+        case cJSON_String:
+            PrintString(printer, item->valuestring);
+            break;
+        case cJSON_Array:
+        case cJSON_Object:
+            Append(printer, ((item->type & 0xFF) == cJSON_Array) ? "[" : "{", 1);
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if ((item->type & 0xFF) == cJSON_Object)
+                {
+                    PrintString(printer, child->string);
+                    Append(printer, ":", 1);
+                }
+                PrintValue(printer, child);
+                if (child->next != NULL)
+                {
+                    Append(printer, ",", 1);
+                }
+            }
+            Append(printer, ((item->type & 0xFF) == cJSON_Array) ? "]" : "}", 1);
+            break;
+        default:
+            break;
+    }
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    printer_t printer = {NULL, 0, 0};
+
+    if (item == NULL)
+    {
+        return NULL;
+    }
+    Append(&printer, "", 0);
+    PrintValue(&printer, item);
+
+    return printer.buffer;
+}
+
+int cJSON_GetArraySize(const cJSON *array)
+{
+    int size = 0;
+
+    for (const cJSON *child = (array != NULL) ? array->child : NULL; child != NULL; child = child->next)
+    {
+        size++;
+    }
+    return size;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    cJSON *child = (array != NULL) ? array->child : NULL;
+
+    while ((child != NULL) && (index-- > 0))
+    {
+        child = child->next;
+    }
+    return (index < 0) ? NULL : child;
+}
+
+static cJSON *GetObjectItem(const cJSON *object, const char *name, cJSON_bool caseSensitive)
+{
+    cJSON *child = ((object != NULL) && (name != NULL)) ? object->child : NULL;
+
+    for (; child != NULL; child = child->next)
+    {
+        if ((child->string != NULL) &&
+            ((caseSensitive ? strcmp(child->string, name) : strcasecmp(child->string, name)) == 0))
+        {
+            break;
+        }
+    }
+    return child;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *const object, const char *const string)
+{
+    return GetObjectItem(object, string, 0);
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *const object, const char *const string)
+{
+    return GetObjectItem(object, string, 1);
+}
+
+cJSON_bool cJSON_HasObjectItem(const cJSON *object, const char *string)
+{
+    return cJSON_GetObjectItem(object, string) != NULL;
+}
+
+#define IS_TYPE(item, kind) (((item) != NULL) && (((item)->type & 0xFF) == (kind)))
+
+cJSON_bool cJSON_IsInvalid(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_Invalid);
+}
+
+cJSON_bool cJSON_IsFalse(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_False);
+}
+
+cJSON_bool cJSON_IsTrue(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_True);
+}
+
+cJSON_bool cJSON_IsBool(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_True) || IS_TYPE(item, cJSON_False);
+}
+
+cJSON_bool cJSON_IsNull(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_NULL);
+}
+
+cJSON_bool cJSON_IsNumber(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_Number);
+}
+
+cJSON_bool cJSON_IsString(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_String);
+}
+
+cJSON_bool cJSON_IsArray(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_Array);
+}
+
+cJSON_bool cJSON_IsObject(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_Object);
+}
+
+cJSON_bool cJSON_IsRaw(const cJSON *const item)
+{
+    return IS_TYPE(item, cJSON_Raw);
+}
+
+char *cJSON_GetStringValue(cJSON *item)
+{
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+cJSON *cJSON_CreateNull(void)
+{
+    return NewItem(cJSON_NULL);
+}
+
+cJSON *cJSON_CreateTrue(void)
+{
+    return NewItem(cJSON_True);
+}
+
+cJSON *cJSON_CreateFalse(void)
+{
+    return NewItem(cJSON_False);
+}
+
+cJSON *cJSON_CreateBool(cJSON_bool boolean)
+{
+    return NewItem(boolean ? cJSON_True : cJSON_False);
+}
+
+double cJSON_SetNumberHelper(cJSON *object, double number)
+{
+    if (number >= INT_MAX)
+    {
+        object->valueint = INT_MAX;
+    }
+    else if (number <= (double)INT_MIN)
+    {
+        object->valueint = INT_MIN;
+    }
+    else
+    {
+        object->valueint = (int)number;
+    }
+    return object->valuedouble = number;
+}
+
+cJSON *cJSON_CreateNumber(double num)
+{
+    cJSON *item = NewItem(cJSON_Number);
+
+    if (item != NULL)
+    {
+        cJSON_SetNumberHelper(item, num);
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateString(const char *string)
+{
+    cJSON *item = (string != NULL) ? NewItem(cJSON_String) : NULL;
+
+    if (item != NULL)
+    {
+        item->valuestring = Duplicate(string);
+    }
+    return item;
+}
+
+cJSON *cJSON_CreateArray(void)
+{
+    return NewItem(cJSON_Array);
+}
+
+cJSON *cJSON_CreateObject(void)
+{
+    return NewItem(cJSON_Object);
+}
+
+void cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    cJSON *last;
+
+    if ((array == NULL) || (item == NULL) || (array == item))
+    {
+        return;
+    }
+    if (array->child == NULL)
+    {
+        array->child = item;
+        return;
+    }
+    for (last = array->child; last->next != NULL; last = last->next)
+    {
+    }
+    last->next = item;
+    item->prev = last;
+}
+
+void cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    if ((object == NULL) || (string == NULL) || (item == NULL))
+    {
+        return;
+    }
+    if (!(item->type & cJSON_StringIsConst))
+    {
+        free(item->string);
+    }
+    item->string = Duplicate(string);
+    item->type &= ~cJSON_StringIsConst;
+    cJSON_AddItemToArray(object, item);
+}
+
+cJSON *cJSON_DetachItemViaPointer(cJSON *parent, cJSON *const item)
+{
+    if ((parent == NULL) || (item == NULL))
+    {
+        return NULL;
+    }
+    if (item->prev != NULL)
+    {
+        item->prev->next = item->next;
+    }
+    if (item->next != NULL)
+    {
+        item->next->prev = item->prev;
+    }
+    if (item == parent->child)
+    {
+        parent->child = item->next;
+    }
+    item->prev = NULL;
+    item->next = NULL;
+
+    return item;
+}
+
+cJSON *cJSON_DetachItemFromObjectCaseSensitive(cJSON *object, const char *string)
+{
+    return cJSON_DetachItemViaPointer(object, cJSON_GetObjectItemCaseSensitive(object, string));
+}
+
+cJSON_bool cJSON_ReplaceItemViaPointer(cJSON *const parent, cJSON *const item, cJSON *replacement)
+{
+    if ((parent == NULL) || (item == NULL) || (replacement == NULL))
+    {
+        return 0;
+    }
+    if (replacement == item)
+    {
+        return 1;
+    }
+    replacement->next = item->next;
+    replacement->prev = item->prev;
+    if (replacement->next != NULL)
+    {
+        replacement->next->prev = replacement;
+    }
+    if (replacement->prev != NULL)
+    {
+        replacement->prev->next = replacement;
+    }
+    if (parent->child == item)
+    {
+        parent->child = replacement;
+    }
+    item->next = NULL;
+    item->prev = NULL;
+    cJSON_Delete(item);
+
+    return 1;
+}
+
+void cJSON_ReplaceItemInObjectCaseSensitive(cJSON *object, const char *string, cJSON *newitem)
+{
+    if ((newitem == NULL) || (string == NULL))
+    {
+        return;
+    }
+    if (!(newitem->type & cJSON_StringIsConst))
+    {
+        free(newitem->string);
+    }
+    newitem->string = Duplicate(string);
+    newitem->type &= ~cJSON_StringIsConst;
+    cJSON_ReplaceItemViaPointer(object, cJSON_GetObjectItemCaseSensitive(object, string), newitem);
+}
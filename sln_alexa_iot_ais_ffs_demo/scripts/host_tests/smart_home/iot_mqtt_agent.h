@@ -0,0 +1,9 @@
+/*
+ * Host stand-in for iot_mqtt_agent.h, nothing of it is used by the smart home
+ * modules.
+ */
+
+#ifndef IOT_MQTT_AGENT_H
+#define IOT_MQTT_AGENT_H
+
+#endif /* IOT_MQTT_AGENT_H */
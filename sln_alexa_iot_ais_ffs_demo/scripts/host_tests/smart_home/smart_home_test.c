@@ -0,0 +1,726 @@
+/*
+ * Host check of aws_ais/src/ais_smart_home_interface.c and the controllers,
+ * with the discovery report of avs/smart_home/, on the simulated scheduler of
+ * fake_sai/. The directives are handled the way aisv2_msg.c hands them over:
+ * the EndpointForwarding payload is parsed, dispatched, then deleted. The
+ * events the device sends are printed as they would be published.
+ *  - recorded directives are replayed: ReportState is answered with a
+ *    StateReport, the power and brightness directives with a Response echoing
+ *    the correlation token and carrying the new state, the application
+ *    callbacks run in the smart home task, EventProcessed is not answered;
+ *    the time from the parse to the printed answer is reported per directive;
+ *  - malformed directives: every truncation of the recorded ones, fields
+ *    missing or of the wrong type, unknown endpoints and capabilities, deep
+ *    nesting and random byte flips. No answer, no state change, no JSON item
+ *    or response left behind, and the recorded directives are answered again
+ *    afterwards;
+ *  - a button task changes the power and brightness in a burst, as fast as
+ *    a user presses: the changes of each window go out as one ChangeReport
+ *    naming the capabilities changed since the previous one, the reports are
+ *    a window apart, far fewer than the changes, and the last one carries
+ *    the final state.
+ *
+ * Build and run with "make -C scripts/host_tests smart_home".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aisv2.h"
+#include "aisv2_app.h"
+#include "device_utils.h"
+#include "sim_rtos.h"
+#include "task.h"
+
+#define TEST_SERIAL       "0123456789ABCDEF"
+#define TEST_REPLAY_ROUND 2000
+#define TEST_FUZZ_ROUNDS  20000
+#define TEST_TEXT_SIZE    1024
+#define TEST_BUDGET_US    1000 /* Far above the host, the median answer has to stay under it */
+#define TEST_BURST_PRESSES 300
+#define TEST_BURST_GAP_MS  20 /* Up to, between two presses */
+#define TEST_BUTTON_PRIO   5
+#define TEST_TIMEOUT_MS    20000
+
+#define TEST_BURST_CAPABILITIES \
+    ((1U << AIS_SMART_HOME_POWER_CONTROLLER) | (1U << AIS_SMART_HOME_BRIGHTNESS_CONTROLLER))
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("smart home: ");         \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+typedef struct
+{
+    const char *label;
+    const char *name_space;
+    const char *name;
+    const char *payload;
+    const char *answer; /* Name of the event answering it, NULL for none */
+} test_directive_t;
+
+/* The endpoint of the discovery report has the power and brightness capabilities */
+static const test_directive_t s_recorded[] = {
+    {"ReportState", "Alexa", "ReportState", "{}", "StateReport"},
+    {"TurnOn", "Alexa.PowerController", "TurnOn", "{}", "Response"},
+    {"SetBrightness", "Alexa.BrightnessController", "SetBrightness", "{\"brightness\":42}", "Response"},
+    {"AdjustBrightness", "Alexa.BrightnessController", "AdjustBrightness", "{\"brightnessDelta\":-25}", "Response"},
+    {"TurnOff", "Alexa.PowerController", "TurnOff", "{}", "Response"},
+};
+
+#define TEST_RECORDED_NUM (sizeof(s_recorded) / sizeof(s_recorded[0]))
+
+static const char *const s_eventProcessed =
+    "{\"directive\":{\"header\":{\"namespace\":\"Alexa\",\"name\":\"EventProcessed\",\"messageId\":\"m-0\","
+    "\"eventCorrelationToken\":\"e-0\",\"payloadVersion\":\"3\"},\"payload\":{}}}";
+
+static ais_handle_t s_handle;
+static ais_app_data_t s_appData;
+static char s_endpointId[128];
+static uint32_t s_uuid;
+static uint32_t s_callbacks[AIS_SMART_HOME_BRIGHTNESS_CONTROLLER + 1];
+
+/* Events printed since the last clear_events, and when the first one was */
+static char **s_events;
+static uint32_t s_eventNum;
+static uint32_t s_eventSize;
+static uint64_t s_firstEventNs;
+
+/* Simulated time of each event, and the capabilities the burst changed since the previous one */
+static uint64_t *s_eventUs;
+static uint32_t *s_eventPending;
+
+/* Capabilities changed by the button task and not reported yet */
+static uint32_t s_pendingMask;
+static uint32_t s_burstChanges;
+static bool s_burstDone;
+
+long cJSON_HostLiveItems(void);
+
+static uint64_t now_ns(void)
+{
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return ((uint64_t)time.tv_sec * 1000000000ULL) + (uint64_t)time.tv_nsec;
+}
+
+ais_app_data_t *AIS_APP_GetAppData(void)
+{
+    return &s_appData;
+}
+
+void APP_GetHexUniqueID(char **uniqueID)
+{
+    *uniqueID = pvPortMalloc(sizeof(TEST_SERIAL));
+    memcpy(*uniqueID, TEST_SERIAL, sizeof(TEST_SERIAL));
+}
+
+void APP_GetUniqueID(char **uniqueID, bool removeSpecialCharacters)
+{
+    APP_GetHexUniqueID(uniqueID);
+}
+
+void AIA_build_uuid(ais_handle_t *handle, uint8_t *out)
+{
+    snprintf((char *)out, 17, "%016x", s_uuid++);
+}
+
+/* What AIS_EventSmartHomeEndpointForwarding publishes is the printed event */
+status_t AIS_EventSmartHomeEndpointForwarding(ais_handle_t *handle, ais_json_t *jsonEvent)
+{
+    char *text = cJSON_PrintUnformatted(jsonEvent->json);
+
+    if (s_eventNum == 0)
+    {
+        s_firstEventNs = now_ns();
+    }
+    if (s_eventNum == s_eventSize)
+    {
+        s_eventSize    = (s_eventSize != 0) ? (2 * s_eventSize) : 8;
+        s_events       = realloc(s_events, s_eventSize * sizeof(s_events[0]));
+        s_eventUs      = realloc(s_eventUs, s_eventSize * sizeof(s_eventUs[0]));
+        s_eventPending = realloc(s_eventPending, s_eventSize * sizeof(s_eventPending[0]));
+    }
+    s_eventUs[s_eventNum]      = sim_now_us();
+    s_eventPending[s_eventNum] = s_pendingMask;
+    s_events[s_eventNum++]     = text;
+    s_pendingMask              = 0;
+    cJSON_Delete(jsonEvent->json);
+
+    return kStatus_Success;
+}
+
+void AIS_AppCallback_PowerController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
+{
+    s_callbacks[smart_home_msg->controller_type]++;
+}
+
+void AIS_AppCallback_ToggleController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
+{
+    s_callbacks[smart_home_msg->controller_type]++;
+}
+
+void AIS_AppCallback_RangeController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
+{
+    s_callbacks[smart_home_msg->controller_type]++;
+}
+
+void AIS_AppCallback_ModeController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
+{
+    s_callbacks[smart_home_msg->controller_type]++;
+}
+
+void AIS_AppCallback_BrightnessController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
+{
+    s_callbacks[smart_home_msg->controller_type]++;
+}
+
+static void clear_events(void)
+{
+    for (uint32_t i = 0; i < s_eventNum; i++)
+    {
+        free(s_events[i]);
+    }
+    s_eventNum = 0;
+}
+
+static void format_directive(char *text, const test_directive_t *directive, uint32_t n)
+{
+    snprintf(text, TEST_TEXT_SIZE,
+             "{\"directive\":{\"header\":{\"namespace\":\"%s\",\"name\":\"%s\",\"messageId\":\"m-%u\","
+             "\"correlationToken\":\"c-%u\",\"payloadVersion\":\"3\"},\"endpoint\":{\"endpointId\":\"%s\","
+             "\"cookie\":{}},\"payload\":%s}}",
+             directive->name_space, directive->name, n, n, s_endpointId, directive->payload);
+}
+
+/* Parses and dispatches the text, returns the time from the parse to the first event */
+static uint64_t test_dispatch(const char *text, status_t *status)
+{
+    uint64_t start;
+    cJSON *message;
+
+    clear_events();
+    start   = now_ns();
+    message = cJSON_Parse(text);
+    *status = AIA_AlexaSmartHomeDispatch(&s_handle, message);
+    cJSON_Delete(message);
+
+    /* The smart home task takes the queued directive */
+    sim_run(1);
+
+    return (s_eventNum != 0) ? (s_firstEventNs - start) : 0;
+}
+
+static const char *get_string(cJSON *object, const char *key)
+{
+    cJSON *item = cJSON_GetObjectItemCaseSensitive(object, key);
+
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+static cJSON *find_property(cJSON *properties, const char *name_space)
+{
+    cJSON *property;
+
+    cJSON_ArrayForEach(property, properties)
+    {
+        const char *ns = get_string(property, "namespace");
+
+        if ((ns != NULL) && (strcmp(ns, name_space) == 0))
+        {
+            return property;
+        }
+    }
+    return NULL;
+}
+
+/* Checks the answer against the state of the endpoint */
+static void check_answer(const test_directive_t *directive, uint32_t n)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = &s_handle.smart_home.smart_home_endpoint[0];
+    cJSON *event, *header, *properties, *power, *brightness, *value;
+    bool stateReport = (strcmp(directive->answer, "StateReport") == 0);
+    const char *endpointId;
+    char token[16];
+
+    if (s_eventNum != 1)
+    {
+        FAIL("%s answered with %u events", directive->label, s_eventNum);
+    }
+    event = cJSON_Parse(s_events[0]);
+    if (event == NULL)
+    {
+        FAIL("%s answered with unparsable %s", directive->label, s_events[0]);
+    }
+
+    header = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(event, "event"), "header");
+    snprintf(token, sizeof(token), "c-%u", n);
+    if ((get_string(header, "name") == NULL) || (strcmp(get_string(header, "name"), directive->answer) != 0) ||
+        (get_string(header, "correlationToken") == NULL) || (strcmp(get_string(header, "correlationToken"), token) != 0))
+    {
+        FAIL("%s answered with %s", directive->label, s_events[0]);
+    }
+    endpointId = get_string(
+        cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(event, "event"), "endpoint"), "endpointId");
+    if ((endpointId == NULL) || (strcmp(endpointId, s_endpointId) != 0))
+    {
+        FAIL("%s answered for another endpoint: %s", directive->label, s_events[0]);
+    }
+
+    properties = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(event, "context"), "properties");
+    power      = find_property(properties, "Alexa.PowerController");
+    brightness = find_property(properties, "Alexa.BrightnessController");
+    /* A Response carries the capability of the directive, a StateReport all of them */
+    if (stateReport || (strcmp(directive->name_space, "Alexa.PowerController") == 0))
+    {
+        value = cJSON_GetObjectItemCaseSensitive(power, "value");
+        if (!cJSON_IsString(value) || (strcmp(value->valuestring, endpoint->powerController->on ? "ON" : "OFF") != 0))
+        {
+            FAIL("%s answered with the power off the state: %s", directive->label, s_events[0]);
+        }
+    }
+    if (stateReport || (strcmp(directive->name_space, "Alexa.BrightnessController") == 0))
+    {
+        value = cJSON_GetObjectItemCaseSensitive(brightness, "value");
+        if (!cJSON_IsNumber(value) || ((uint32_t)value->valueint != endpoint->brightnessController->brightness))
+        {
+            FAIL("%s answered with the brightness off the state: %s", directive->label, s_events[0]);
+        }
+    }
+    cJSON_Delete(event);
+}
+
+static void setup(void)
+{
+    s_appData.currTime = AIA_TIME_EPOCH_ADJUST + 1600000000ULL;
+    snprintf(s_endpointId, sizeof(s_endpointId), "%s::%s::%s", AIA_CLIENT_ID, clientcredentialIOT_PRODUCT_NAME,
+             TEST_SERIAL);
+
+    if (AIA_AlexaSmartHomeInit(&s_handle) != kStatus_Success)
+    {
+        FAIL("init failed");
+    }
+    if ((s_handle.smart_home.number_of_endpoints != 1) ||
+        (strcmp(s_handle.smart_home.smart_home_endpoint[0].endpointId, s_endpointId) != 0) ||
+        (s_handle.smart_home.smart_home_endpoint[0].powerController == NULL) ||
+        (s_handle.smart_home.smart_home_endpoint[0].brightnessController == NULL))
+    {
+        FAIL("discovery report read as %u endpoints, the first %s", s_handle.smart_home.number_of_endpoints,
+             s_handle.smart_home.smart_home_endpoint[0].endpointId);
+    }
+    sim_run(1);
+}
+
+/* Replays the recorded directives, returns the median time to the answer of each one */
+static void replay(uint64_t *medianNs, uint64_t *worstNs)
+{
+    static uint64_t samples[TEST_RECORDED_NUM][TEST_REPLAY_ROUND];
+    char text[TEST_TEXT_SIZE];
+    uint32_t callbacks[AIS_SMART_HOME_BRIGHTNESS_CONTROLLER + 1];
+    status_t status;
+    uint32_t n = 0;
+
+    for (uint32_t round = 0; round < TEST_REPLAY_ROUND; round++)
+    {
+        for (uint32_t i = 0; i < TEST_RECORDED_NUM; i++, n++)
+        {
+            memcpy(callbacks, s_callbacks, sizeof(callbacks));
+            format_directive(text, &s_recorded[i], n);
+            samples[i][round] = test_dispatch(text, &status);
+            if (status != kStatus_Success)
+            {
+                FAIL("%s failed: %d", s_recorded[i].label, (int)status);
+            }
+            check_answer(&s_recorded[i], n);
+
+            if ((strcmp(s_recorded[i].answer, "Response") == 0) &&
+                (s_callbacks[AIS_SMART_HOME_POWER_CONTROLLER] + s_callbacks[AIS_SMART_HOME_BRIGHTNESS_CONTROLLER] !=
+                 callbacks[AIS_SMART_HOME_POWER_CONTROLLER] + callbacks[AIS_SMART_HOME_BRIGHTNESS_CONTROLLER] + 1))
+            {
+                FAIL("%s did not reach the application", s_recorded[i].label);
+            }
+        }
+
+        test_dispatch(s_eventProcessed, &status);
+        if ((status != kStatus_Success) || (s_eventNum != 0))
+        {
+            FAIL("EventProcessed: status %d, %u events", (int)status, s_eventNum);
+        }
+    }
+    clear_events();
+
+    for (uint32_t i = 0; i < TEST_RECORDED_NUM; i++)
+    {
+        uint64_t *sample = samples[i];
+
+        /* A sort of the few thousand samples is enough */
+        for (uint32_t a = 1; a < TEST_REPLAY_ROUND; a++)
+        {
+            for (uint32_t b = a; (b > 0) && (sample[b - 1] > sample[b]); b--)
+            {
+                uint64_t swap = sample[b];
+
+                sample[b]     = sample[b - 1];
+                sample[b - 1] = swap;
+            }
+        }
+        medianNs[i] = sample[TEST_REPLAY_ROUND / 2];
+        worstNs[i]  = sample[TEST_REPLAY_ROUND - 1];
+    }
+}
+
+/* Dispatches the text, which must not be answered nor change the endpoint */
+static void check_refused(const char *label, const char *text)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = &s_handle.smart_home.smart_home_endpoint[0];
+    ais_avs_power_controller_t power        = *endpoint->powerController;
+    ais_avs_brightness_controller_t light   = *endpoint->brightnessController;
+    uint32_t callbacks[AIS_SMART_HOME_BRIGHTNESS_CONTROLLER + 1];
+    long items = cJSON_HostLiveItems();
+    status_t status;
+
+    memcpy(callbacks, s_callbacks, sizeof(callbacks));
+    test_dispatch(text, &status);
+    if ((status == kStatus_Success) || (s_eventNum != 0))
+    {
+        FAIL("%s: status %d, %u events, the first %s", label, (int)status, s_eventNum,
+             (s_eventNum != 0) ? s_events[0] : "-");
+    }
+    if ((memcmp(&power, endpoint->powerController, sizeof(power)) != 0) ||
+        (memcmp(&light, endpoint->brightnessController, sizeof(light)) != 0) ||
+        (memcmp(callbacks, s_callbacks, sizeof(callbacks)) != 0))
+    {
+        FAIL("%s changed the endpoint", label);
+    }
+    if (cJSON_HostLiveItems() != items)
+    {
+        FAIL("%s left %ld JSON items behind", label, cJSON_HostLiveItems() - items);
+    }
+}
+
+static void malformed(uint32_t *cases)
+{
+    static const test_directive_t shapes[] = {
+        {"unknown namespace", "Alexa.ColorController", "SetColor", "{\"color\":{}}", NULL},
+        {"unknown name", "Alexa.PowerController", "Toggle", "{}", NULL},
+        {"namespace and name swapped", "TurnOn", "Alexa.PowerController", "{}", NULL},
+        {"capability of no endpoint", "Alexa.ModeController", "SetMode", "{\"mode\":1}", NULL},
+        {"toggle of no endpoint", "Alexa.ToggleController", "TurnOn", "{}", NULL},
+        {"range of no endpoint", "Alexa.RangeController", "SetRangeValue", "{\"rangeValue\":1}", NULL},
+        {"brightness as a string", "Alexa.BrightnessController", "SetBrightness", "{\"brightness\":\"42\"}", NULL},
+        {"brightness over 100", "Alexa.BrightnessController", "SetBrightness", "{\"brightness\":142}", NULL},
+        {"brightness negative", "Alexa.BrightnessController", "SetBrightness", "{\"brightness\":-2}", NULL},
+        {"brightness delta under -100", "Alexa.BrightnessController", "AdjustBrightness",
+         "{\"brightnessDelta\":-4200}", NULL},
+        {"brightness missing", "Alexa.BrightnessController", "SetBrightness", "{\"level\":42}", NULL},
+        {"brightness delta null", "Alexa.BrightnessController", "AdjustBrightness", "{\"brightnessDelta\":null}",
+         NULL},
+        {"payload an array", "Alexa.BrightnessController", "SetBrightness", "[42]", NULL},
+        {"payload a string", "Alexa.BrightnessController", "SetBrightness", "\"42\"", NULL},
+    };
+    static const char *const texts[][2] = {
+        {"no directive", "{\"header\":{\"namespace\":\"Alexa.PowerController\",\"name\":\"TurnOn\"}}"},
+        {"directive a string", "{\"directive\":\"TurnOn\"}"},
+        {"header an array", "{\"directive\":{\"header\":[\"Alexa.PowerController\",\"TurnOn\"]}}"},
+        {"namespace a number", "{\"directive\":{\"header\":{\"namespace\":7,\"name\":\"TurnOn\"}}}"},
+        {"name null", "{\"directive\":{\"header\":{\"namespace\":\"Alexa.PowerController\",\"name\":null}}}"},
+        {"name missing", "{\"directive\":{\"header\":{\"namespace\":\"Alexa.PowerController\"}}}"},
+        {"no endpoint", "{\"directive\":{\"header\":{\"namespace\":\"Alexa.PowerController\",\"name\":\"TurnOn\","
+                        "\"correlationToken\":\"c\"},\"payload\":{}}}"},
+        {"endpointId a number", "{\"directive\":{\"header\":{\"namespace\":\"Alexa.PowerController\",\"name\":"
+                                "\"TurnOn\",\"correlationToken\":\"c\"},\"endpoint\":{\"endpointId\":1},"
+                                "\"payload\":{}}}"},
+        {"unknown endpoint", "{\"directive\":{\"header\":{\"namespace\":\"Alexa.PowerController\",\"name\":"
+                             "\"TurnOn\",\"correlationToken\":\"c\"},\"endpoint\":{\"endpointId\":\"lamp\"},"
+                             "\"payload\":{}}}"},
+        {"unknown endpoint state", "{\"directive\":{\"header\":{\"namespace\":\"Alexa\",\"name\":\"ReportState\","
+                                   "\"correlationToken\":\"c\"},\"endpoint\":{\"endpointId\":\"lamp\"}}}"},
+        {"message an array", "[{\"directive\":{}}]"},
+        {"message a number", "42"},
+        {"empty", ""},
+    };
+    char text[TEST_TEXT_SIZE];
+    char *deep;
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++, n++)
+    {
+        format_directive(text, &shapes[i], n);
+        check_refused(shapes[i].label, text);
+    }
+    for (uint32_t i = 0; i < sizeof(texts) / sizeof(texts[0]); i++, n++)
+    {
+        check_refused(texts[i][0], texts[i][1]);
+    }
+
+    /* The correlation token missing, a Response could not be matched */
+    format_directive(text, &s_recorded[1], n++);
+    memmove(strstr(text, "\"correlationToken\""), strstr(text, "\"payloadVersion\""),
+            strlen(strstr(text, "\"payloadVersion\"")) + 1);
+    check_refused("no correlation token", text);
+
+    /* Nested deeper than cJSON parses */
+    deep = malloc(2 * (CJSON_NESTING_LIMIT + 2) + 1);
+    for (uint32_t i = 0; i < CJSON_NESTING_LIMIT + 2; i++)
+    {
+        deep[i]                                 = '[';
+        deep[2 * (CJSON_NESTING_LIMIT + 2) - 1 - i] = ']';
+    }
+    deep[2 * (CJSON_NESTING_LIMIT + 2)] = '\0';
+    check_refused("too deep", deep);
+    free(deep);
+    n++;
+
+    /* Every truncation of the recorded directives, as a message cut short would be */
+    for (uint32_t i = 0; i < TEST_RECORDED_NUM; i++, n++)
+    {
+        char label[64];
+        size_t length;
+
+        format_directive(text, &s_recorded[i], n);
+        length = strlen(text);
+        for (size_t cut = 0; cut < length; cut++)
+        {
+            format_directive(text, &s_recorded[i], n);
+            text[cut] = '\0';
+            snprintf(label, sizeof(label), "%s cut at %zu", s_recorded[i].label, cut);
+            check_refused(label, text);
+            (*cases)++;
+        }
+    }
+    *cases += n;
+}
+
+/* Random bytes of the recorded directives flipped: whatever is answered is a valid event */
+static uint32_t fuzz(void)
+{
+    char text[TEST_TEXT_SIZE];
+    uint32_t answered = 0;
+    long items        = cJSON_HostLiveItems();
+    status_t status;
+
+    srand(47);
+    for (uint32_t round = 0; round < TEST_FUZZ_ROUNDS; round++)
+    {
+        size_t length;
+
+        format_directive(text, &s_recorded[round % TEST_RECORDED_NUM], round);
+        length = strlen(text);
+        for (int flips = 1 + rand() % 4; flips > 0; flips--)
+        {
+            text[rand() % length] = (char)(1 + rand() % 255);
+        }
+        test_dispatch(text, &status);
+        for (uint32_t i = 0; i < s_eventNum; i++)
+        {
+            cJSON *event = cJSON_Parse(s_events[i]);
+
+            if (event == NULL)
+            {
+                FAIL("a flipped directive answered with unparsable %s", s_events[i]);
+            }
+            cJSON_Delete(event);
+        }
+        answered += (s_eventNum != 0);
+    }
+    clear_events();
+    if (cJSON_HostLiveItems() != items)
+    {
+        FAIL("the flipped directives left %ld JSON items behind", cJSON_HostLiveItems() - items);
+    }
+    return answered;
+}
+
+/* Presses as a user does, each one changes the power or sets a random brightness */
+static void button_task(void *arg)
+{
+    ais_avs_smart_home_endpoint_t *endpoint = &s_handle.smart_home.smart_home_endpoint[0];
+    status_t status;
+
+    for (uint32_t i = 0; i < TEST_BURST_PRESSES; i++)
+    {
+        if (rand() % 2)
+        {
+            s_pendingMask |= (1U << AIS_SMART_HOME_POWER_CONTROLLER);
+            s_burstChanges++;
+            status = AIA_AlexaSmartHomePowerControllerSetState(&s_handle, endpoint, !endpoint->powerController->on);
+        }
+        else
+        {
+            uint32_t brightness = rand() % (AIA_SMART_HOME_BRIGHTNESS_MAX + 1);
+
+            if (brightness != endpoint->brightnessController->brightness)
+            {
+                s_pendingMask |= (1U << AIS_SMART_HOME_BRIGHTNESS_CONTROLLER);
+                s_burstChanges++;
+            }
+            status = AIA_AlexaSmartHomeBrightnessControllerSetState(&s_handle, endpoint, brightness);
+        }
+        if (status != kStatus_Success)
+        {
+            FAIL("press %u not taken: %d", i, (int)status);
+        }
+        vTaskDelay(pdMS_TO_TICKS(1 + rand() % TEST_BURST_GAP_MS));
+    }
+    s_burstDone = true;
+    vTaskDelete(NULL);
+}
+
+static bool burst_done(void *arg)
+{
+    return s_burstDone;
+}
+
+/* Returns the capabilities named in the properties, the value of those found */
+static uint32_t read_properties(cJSON *properties, int *power, uint32_t *brightness)
+{
+    cJSON *property;
+    uint32_t mask = 0;
+
+    cJSON_ArrayForEach(property, properties)
+    {
+        const char *ns = get_string(property, "namespace");
+        cJSON *value   = cJSON_GetObjectItemCaseSensitive(property, "value");
+
+        if ((ns != NULL) && (strcmp(ns, "Alexa.PowerController") == 0) && cJSON_IsString(value))
+        {
+            mask |= (1U << AIS_SMART_HOME_POWER_CONTROLLER);
+            *power = (strcmp(value->valuestring, "ON") == 0);
+        }
+        else if ((ns != NULL) && (strcmp(ns, "Alexa.BrightnessController") == 0) && cJSON_IsNumber(value))
+        {
+            mask |= (1U << AIS_SMART_HOME_BRIGHTNESS_CONTROLLER);
+            *brightness = (uint32_t)value->valueint;
+        }
+        else
+        {
+            FAIL("unexpected property %s", (ns != NULL) ? ns : "-");
+        }
+    }
+    return mask;
+}
+
+static void burst(void)
+{
+    const uint64_t windowUs                 = AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS * 1000ULL;
+    ais_avs_smart_home_endpoint_t *endpoint = &s_handle.smart_home.smart_home_endpoint[0];
+    int power                               = -1;
+    uint32_t brightness                     = UINT32_MAX;
+    uint64_t start;
+    uint32_t elapsedMs;
+
+    clear_events();
+    srand(48);
+    s_pendingMask  = 0;
+    s_burstChanges = 0;
+    s_burstDone    = false;
+    start          = sim_now_us();
+
+    xTaskCreate(button_task, "button", 1024, NULL, TEST_BUTTON_PRIO, NULL);
+    sim_run_until(burst_done, NULL, TEST_TIMEOUT_MS);
+    if (!s_burstDone)
+    {
+        FAIL("the button task did not finish");
+    }
+    elapsedMs = (uint32_t)((sim_now_us() - start) / 1000);
+    /* The changes of the last window */
+    sim_run(2 * AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS);
+
+    if (s_pendingMask != 0)
+    {
+        FAIL("changes 0x%x never reported", s_pendingMask);
+    }
+    for (uint32_t i = 0; i < s_eventNum; i++)
+    {
+        cJSON *event = cJSON_Parse(s_events[i]);
+        cJSON *body  = cJSON_GetObjectItemCaseSensitive(event, "event");
+        cJSON *change;
+        const char *endpointId;
+        uint32_t changed;
+
+        if ((get_string(cJSON_GetObjectItemCaseSensitive(body, "header"), "name") == NULL) ||
+            (strcmp(get_string(cJSON_GetObjectItemCaseSensitive(body, "header"), "name"), "ChangeReport") != 0))
+        {
+            FAIL("the burst sent %s", s_events[i]);
+        }
+        endpointId = get_string(cJSON_GetObjectItemCaseSensitive(body, "endpoint"), "endpointId");
+        if ((endpointId == NULL) || (strcmp(endpointId, s_endpointId) != 0))
+        {
+            FAIL("ChangeReport for another endpoint: %s", s_events[i]);
+        }
+        if ((i != 0) && (s_eventUs[i] - s_eventUs[i - 1] < windowUs))
+        {
+            FAIL("ChangeReports %u and %u %llu us apart", i - 1, i,
+                 (unsigned long long)(s_eventUs[i] - s_eventUs[i - 1]));
+        }
+
+        /* The payload names what changed since the previous report, the context the rest */
+        change  = cJSON_GetObjectItemCaseSensitive(cJSON_GetObjectItemCaseSensitive(body, "payload"), "change");
+        changed = read_properties(cJSON_GetObjectItemCaseSensitive(change, "properties"), &power, &brightness);
+        if (changed != s_eventPending[i])
+        {
+            FAIL("ChangeReport %u names 0x%x, 0x%x changed: %s", i, changed, s_eventPending[i], s_events[i]);
+        }
+        if ((changed | read_properties(cJSON_GetObjectItemCaseSensitive(
+                                           cJSON_GetObjectItemCaseSensitive(event, "context"), "properties"),
+                                       &power, &brightness)) != TEST_BURST_CAPABILITIES)
+        {
+            FAIL("ChangeReport %u misses a capability: %s", i, s_events[i]);
+        }
+        cJSON_Delete(event);
+    }
+
+    if ((s_eventNum == 0) || (power != (int)endpoint->powerController->on) ||
+        (brightness != endpoint->brightnessController->brightness))
+    {
+        FAIL("the last ChangeReport is not the final state: %s", (s_eventNum != 0) ? s_events[s_eventNum - 1] : "-");
+    }
+    /* One report per window at most, where every change was a message before */
+    if ((s_eventNum > elapsedMs / AIA_SMART_HOME_CHANGE_REPORT_WINDOW_MS + 2) || (10 * s_eventNum > s_burstChanges))
+    {
+        FAIL("%u changes in %u ms sent as %u ChangeReports", s_burstChanges, elapsedMs, s_eventNum);
+    }
+    printf("smart home: %u changes in %u ms sent as %u ChangeReports, the last one the final state\n", s_burstChanges,
+           elapsedMs, s_eventNum);
+    clear_events();
+}
+
+int main(void)
+{
+    uint64_t medianNs[TEST_RECORDED_NUM];
+    uint64_t worstNs[TEST_RECORDED_NUM];
+    uint64_t againNs[TEST_RECORDED_NUM];
+    uint64_t againWorstNs[TEST_RECORDED_NUM];
+    uint32_t cases = 0;
+    uint32_t answered;
+
+    setup();
+
+    replay(medianNs, worstNs);
+    malformed(&cases);
+    answered = fuzz();
+    /* Nothing refused above kept a response of the pool or broke the state */
+    replay(againNs, againWorstNs);
+
+    for (uint32_t i = 0; i < TEST_RECORDED_NUM; i++)
+    {
+        if (medianNs[i] > TEST_BUDGET_US * 1000ULL)
+        {
+            FAIL("%s answered in %.1f us median", s_recorded[i].label, (double)medianNs[i] / 1000);
+        }
+        printf("smart home: %-16s parse to answer %6.1f us median, %6.1f us worst\n", s_recorded[i].label,
+               (double)medianNs[i] / 1000, (double)worstNs[i] / 1000);
+    }
+    printf("smart home: %u malformed directives refused, %u of %u flipped ones answered with valid events\n",
+           cases, answered, TEST_FUZZ_ROUNDS);
+
+    burst();
+    return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for osa_common.h, streamer_pcm.c only needs the C library
+ * headers it pulls in.
+ */
+
+#ifndef _OSA_COMMON_H_
+#define _OSA_COMMON_H_
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#endif /* _OSA_COMMON_H_ */
@@ -0,0 +1,232 @@
+/*
+ * Host check of source/streamer_pcm.c against the fake SAI of fake_sai/.
+ *
+ * The real streamer_pcm.c and amplifier run on the simulated scheduler. A
+ * writer task plays a stream of numbered non-zero samples through
+ * streamer_pcm_write() in writes of random lengths, whole samples but rarely
+ * a multiple of the 32 byte DMA size, writing a refused write again as the
+ * streamer does:
+ *  - every write accepted: once the silence is taken out the SAI played the
+ *    stream sample for sample, the tails carried from write to write included;
+ *  - the amplifier refuses some of the blocks: no sample is played twice,
+ *    samples are only lost where a refusal dropped the queue, and the end of
+ *    the stream is played;
+ *  - the writer waits for a free block on the semaphore the TX interrupt
+ *    gives, it wakes up less often than the 1ms polling it replaced, run on
+ *    the same stream.
+ *
+ * Build and run with "make -C scripts/host_tests streamer_pcm".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+#include "fake_sai.h"
+#include "pdm_pcm_definitions.h"
+#include "sim_rtos.h"
+#include "sln_amplifier.h"
+#include "sln_tickless.h"
+#include "streamer_pcm.h"
+
+#define TEST_STREAM_SAMPLES 30000
+#define TEST_MAX_WRITE      1600
+#define TEST_WRITER_PRIO    5
+#define TEST_TIMEOUT_MS     10000
+
+static const char *s_scenario = "init";
+
+#define FAIL(...)                                   \
+    do {                                            \
+        printf("streamer pcm: %s: ", s_scenario);   \
+        printf(__VA_ARGS__);                        \
+        printf("\n");                               \
+        exit(1);                                    \
+    } while (0)
+
+static int16_t s_stream[TEST_STREAM_SAMPLES];
+static pcm_rtos_t *s_pcm;
+static bool s_polling;
+static bool s_writer_done;
+static uint32_t s_writes;
+static uint32_t s_refused_writes;
+
+/* Every s_refuse_every-th block is refused by the amplifier, 0 for none */
+static uint32_t s_refuse_every;
+static uint32_t s_blocks;
+static uint32_t s_refused_blocks;
+
+/* streamer_pcm.c is built with its SLN_AMP_WriteNoWait calls sent here */
+amplifier_status_t test_amp_write_no_wait(uint8_t *data, uint32_t length)
+{
+    s_blocks++;
+    if (s_refuse_every && (s_blocks % s_refuse_every) == 0) {
+        s_refused_blocks++;
+        return kStatus_Fail;
+    }
+    return SLN_AMP_WriteNoWait(data, length);
+}
+
+void SLN_TICKLESS_PeriodicIrqDone(sln_tickless_periodic_t source, uint32_t periodUs)
+{
+}
+
+static void writer_task(void *arg)
+{
+    uint32_t offset = 0;
+    uint32_t total = sizeof(s_stream);
+
+    while (offset < total) {
+        uint32_t size = 2 * (1 + rand() % (TEST_MAX_WRITE / 2));
+
+        size = (size > total - offset) ? total - offset : size;
+        /* The write it replaced waited for a free block 1ms at a time */
+        while (s_polling && s_pcm->emptyBlock == 0) {
+            vTaskDelay(1);
+        }
+        while (streamer_pcm_write(s_pcm, (uint8_t *)s_stream + offset, size) != 0) {
+            s_refused_writes++;
+        }
+        offset += size;
+        s_writes++;
+    }
+    streamer_pcm_close(s_pcm);
+    s_writer_done = true;
+    vTaskDelete(NULL);
+}
+
+static bool writer_done(void *arg)
+{
+    return s_writer_done;
+}
+
+static bool sai_stopped(void *arg)
+{
+    return !fake_sai_running();
+}
+
+/* Plays the stream, returns the wakeups of the scheduler meanwhile */
+static uint64_t play_stream(void)
+{
+    uint64_t wakeups = sim_wakeups();
+
+    fake_sai_reset();
+    s_pcm = streamer_pcm_open(SAI_XFER_QUEUE_SIZE);
+    s_pcm->waits = 0;
+    s_writer_done = false;
+    s_writes = 0;
+    s_refused_writes = 0;
+    s_blocks = 0;
+    s_refused_blocks = 0;
+
+    xTaskCreate(writer_task, "writer", 1024, NULL, TEST_WRITER_PRIO, NULL);
+    sim_run_until(writer_done, NULL, TEST_TIMEOUT_MS);
+    sim_run_until(sai_stopped, NULL, 1000);
+    return sim_wakeups() - wakeups;
+}
+
+/* Returns the number of gaps in the samples played, fails on a sample played twice or out of order */
+static uint32_t check_output(void)
+{
+    size_t length;
+    const uint8_t *out = fake_sai_output(&length);
+    uint32_t next = 0;
+    uint32_t gaps = 0;
+
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        int16_t sample;
+
+        memcpy(&sample, out + i, 2);
+        if (sample == 0) {
+            continue;
+        }
+        if (sample < 1 || sample > TEST_STREAM_SAMPLES || sample - 1 < (int32_t)next) {
+            FAIL("sample %d played after sample %u", sample - 1, next - 1);
+        }
+        if (sample - 1 != (int32_t)next) {
+            gaps++;
+        }
+        next = sample;
+    }
+    if (next != TEST_STREAM_SAMPLES) {
+        FAIL("the stream ends with sample %d of %d", (int)next - 1, TEST_STREAM_SAMPLES);
+    }
+    return gaps;
+}
+
+static void sample_exact(void)
+{
+    fake_sai_stats_t sai;
+    uint64_t wakeups;
+    uint64_t polling_wakeups;
+    uint32_t waits;
+
+    s_scenario = "exact";
+    wakeups = play_stream();
+    waits = s_pcm->waits;
+    fake_sai_get_stats(&sai);
+    if (check_output() != 0 || s_refused_writes != 0) {
+        FAIL("samples lost, %u writes refused", s_refused_writes);
+    }
+    if (waits == 0) {
+        FAIL("the writer never waited for a block");
+    }
+
+    s_scenario = "polling";
+    s_polling = true;
+    polling_wakeups = play_stream();
+    s_polling = false;
+    if (check_output() != 0) {
+        FAIL("samples lost");
+    }
+    if (wakeups >= polling_wakeups) {
+        FAIL("%llu wakeups waiting on the semaphore, %llu polling", (unsigned long long)wakeups,
+             (unsigned long long)polling_wakeups);
+    }
+    printf("streamer pcm: %u writes played sample for sample in %u transfers, %u waits for a block, "
+           "%llu wakeups (%llu polling)\n",
+           s_writes, sai.transfers, waits, (unsigned long long)wakeups, (unsigned long long)polling_wakeups);
+}
+
+static void refused_blocks(void)
+{
+    fake_sai_stats_t sai;
+    uint32_t gaps;
+
+    s_scenario = "refused";
+    s_refuse_every = 7;
+    play_stream();
+    s_refuse_every = 0;
+    fake_sai_get_stats(&sai);
+
+    gaps = check_output();
+    if (s_refused_blocks == 0 || s_refused_writes != s_refused_blocks) {
+        FAIL("%u blocks refused, %u writes", s_refused_blocks, s_refused_writes);
+    }
+    /* Only a refusal after the carry slot was queued drops the queue */
+    if (gaps > sai.terminates) {
+        FAIL("%u gaps in the samples played, the queue was dropped %u times", gaps, sai.terminates);
+    }
+    printf("streamer pcm: %u of %u blocks refused and written again, no sample twice, %u gaps for %u dropped "
+           "queues\n",
+           s_refused_blocks, s_blocks, gaps, sai.terminates);
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < TEST_STREAM_SAMPLES; i++) {
+        s_stream[i] = (int16_t)(1 + i);
+    }
+    srand(46);
+
+    fake_sai_init();
+    streamer_pcm_init();
+
+    sample_exact();
+    refused_blocks();
+    return 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for sln_flash_mgmt.h. The test keeps the lease file in memory
+ * shared by the runs of the check, as the flash is kept across reboots.
+ */
+
+#ifndef _SLN_FLASH_MGMT_
+#define _SLN_FLASH_MGMT_
+
+#include <stdint.h>
+
+typedef enum _sln_flash_mgmt_status
+{
+    SLN_FLASH_MGMT_OK         = 0x00,
+    SLN_FLASH_MGMT_ENOENTRY2  = -0x51,
+    SLN_FLASH_MGMT_EOVERFLOW  = -0x60,
+    SLN_FLASH_MGMT_EOVERFLOW2 = -0x61,
+} sln_flash_mgmt_status_t;
+
+int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len);
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len);
+int32_t SLN_FLASH_MGMT_Erase(const char *name);
+
+#endif /* _SLN_FLASH_MGMT_ */
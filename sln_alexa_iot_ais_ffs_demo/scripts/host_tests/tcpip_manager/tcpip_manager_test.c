@@ -0,0 +1,531 @@
+/*
+ * Host check of the DHCP client setup of tcpip_manager.c.
+ *
+ * lwIP runs on the simulated scheduler of fake_sai/, its WiFi interface is the
+ * fake one of fake_net/. The test plays the AP the station joins: a DHCP
+ * server, silent when asked to be, and an ARP neighbour which can hold the
+ * address the station probes. Each join runs in a child process, as after a
+ * reboot. The lease file lives in memory shared with the parent, so it is
+ * kept from one join to the next. The check goes through:
+ *  - first join: DISCOVER, the address is bound and the lease saved;
+ *  - joined again: the lease is asked back with a REQUEST (INIT-REBOOT), no
+ *    DISCOVER, and the unchanged lease is not written again;
+ *  - the server gives another address: the REQUEST is NAKed, a DISCOVER
+ *    follows and the new lease is saved;
+ *  - no DHCP answer on the same AP: the lease is probed with ARP and taken
+ *    as a static address, unless another host answers the probe;
+ *  - no DHCP answer on another AP of the same SSID: no static fallback;
+ *  - another SSID, or the lease forgotten: DISCOVER.
+ *
+ * Build and run with "make -C scripts/host_tests tcpip_manager".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lwip/def.h"
+#include "lwip/ip4_addr.h"
+#include "lwip/prot/dhcp.h"
+#include "lwip/prot/etharp.h"
+#include "lwip/prot/iana.h"
+
+#include "dhcp_server.h"
+#include "fake_net.h"
+#include "sim_rtos.h"
+#include "sln_flash_mgmt.h"
+#include "tcpip_lease_file.h"
+#include "tcpip_manager.h"
+#include "wwd_wifi.h"
+
+#define TEST_FILE_MAX 128
+
+/* The network of the AP */
+#define TEST_SERVER_IP PP_HTONL(LWIP_MAKEU32(10, 0, 0, 1))
+#define TEST_NETMASK   PP_HTONL(LWIP_MAKEU32(255, 255, 255, 0))
+#define TEST_POOL_IP   PP_HTONL(LWIP_MAKEU32(10, 0, 0, 100))
+#define TEST_OTHER_IP  PP_HTONL(LWIP_MAKEU32(10, 0, 0, 101))
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("tcpip manager: ");      \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+/* Kept across the joins, in memory shared with the children */
+typedef struct
+{
+    uint8_t data[TEST_FILE_MAX];
+    uint32_t len;
+    int present;
+    uint32_t saves;
+} fake_flash_t;
+
+/* What the AP does during a join */
+typedef struct
+{
+    const char *ssid;
+    uint8_t bssid;
+    int dhcpSilent;   /* The DHCP server does not answer */
+    uint32_t givenIp; /* Address the server gives the station */
+    int ipTaken;      /* Another host answers the ARP probes */
+} test_ap_t;
+
+/* What the AP saw during a join */
+typedef struct
+{
+    uint32_t discovers;
+    uint32_t selectRequests; /* REQUEST for an OFFER, with a server identifier */
+    uint32_t rebootRequests; /* REQUEST for a cached lease (INIT-REBOOT) */
+    uint32_t rebootIp;       /* Address asked back */
+    uint32_t firstType;      /* Type of the first DHCP message */
+    uint32_t naks;
+    uint32_t probes;         /* ARP probes */
+} test_seen_t;
+
+static fake_flash_t *s_flash;
+static test_ap_t s_ap;
+static test_seen_t s_seen;
+
+static const uint8_t s_serverMac[ETH_HWADDR_LEN] = {0x02, 0, 0, 0, 0, 0x10};
+static const uint8_t s_otherMac[ETH_HWADDR_LEN]  = {0x02, 0, 0, 0, 0, 0x20};
+
+int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len)
+{
+    if (0 != strcmp(name, TCPIP_LEASE_FILE_NAME))
+    {
+        FAIL("save of unknown file %s", name);
+    }
+    if (s_flash->present)
+    {
+        return SLN_FLASH_MGMT_EOVERFLOW2;
+    }
+    if (len > sizeof(s_flash->data))
+    {
+        FAIL("lease of %u bytes", len);
+    }
+    memcpy(s_flash->data, data, len);
+    s_flash->len     = len;
+    s_flash->present = 1;
+    s_flash->saves++;
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_MGMT_Read(const char *name, uint8_t *data, uint32_t *len)
+{
+    if (!s_flash->present)
+    {
+        return SLN_FLASH_MGMT_ENOENTRY2;
+    }
+    if (*len < s_flash->len)
+    {
+        FAIL("read of %s in %u bytes, %u needed", name, *len, s_flash->len);
+    }
+    memcpy(data, s_flash->data, s_flash->len);
+    *len = s_flash->len;
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+int32_t SLN_FLASH_MGMT_Erase(const char *name)
+{
+    s_flash->present = 0;
+
+    return SLN_FLASH_MGMT_OK;
+}
+
+wwd_result_t wwd_wifi_get_ap_info(wl_bss_info_t *ap_info, wiced_security_t *security)
+{
+    memset(ap_info, 0, sizeof(*ap_info));
+    ap_info->SSID_len = (uint8_t)strlen(s_ap.ssid);
+    memcpy(ap_info->SSID, s_ap.ssid, ap_info->SSID_len);
+    ap_info->BSSID.octet[0] = 0x02;
+    ap_info->BSSID.octet[5] = s_ap.bssid;
+    *security = WICED_SECURITY_WPA2_AES_PSK;
+
+    return WWD_SUCCESS;
+}
+
+/* The AP side of tcpip_manager.c is not used by this check */
+void start_dhcp_server(uint32_t local_addr)
+{
+}
+
+void quit_dhcp_server(void)
+{
+}
+
+/* Returns the data of a DHCP option, NULL when the message has none */
+static const uint8_t *dhcp_option(const uint8_t *msg, uint16_t len, uint8_t code)
+{
+    uint16_t ofs = DHCP_OPTIONS_OFS;
+
+    while ((ofs + 1 < len) && (msg[ofs] != DHCP_OPTION_END))
+    {
+        if (msg[ofs] == DHCP_OPTION_PAD)
+        {
+            ofs++;
+            continue;
+        }
+        if (msg[ofs] == code)
+        {
+            return &msg[ofs + 2];
+        }
+        ofs += 2 + msg[ofs + 1];
+    }
+
+    return NULL;
+}
+
+static uint32_t dhcp_option_ip(const uint8_t *option)
+{
+    uint32_t ip;
+
+    memcpy(&ip, option, sizeof(ip));
+    return ip;
+}
+
+static void server_reply(struct netif *netif, const uint8_t *request, uint8_t type, uint32_t yiaddr)
+{
+    static const uint8_t broadcast[ETH_HWADDR_LEN] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+    uint8_t msg[DHCP_OPTIONS_OFS + 32] = {0};
+    uint8_t frame[SIZEOF_ETH_HDR + 28 + sizeof(msg)];
+    uint8_t *opt         = &msg[DHCP_OPTIONS_OFS];
+    uint32_t serverIp    = TEST_SERVER_IP;
+    uint32_t netmask     = TEST_NETMASK;
+    uint32_t leaseTime   = PP_HTONL(3600);
+    uint16_t len;
+
+    msg[0] = DHCP_BOOTREPLY;
+    msg[1] = LWIP_IANA_HWTYPE_ETHERNET;
+    msg[2] = ETH_HWADDR_LEN;
+    memcpy(&msg[4], &request[4], 4);    /* xid */
+    memcpy(&msg[16], &yiaddr, 4);       /* yiaddr */
+    memcpy(&msg[28], &request[28], 16); /* chaddr */
+    memcpy(&msg[236], &request[236], 4);
+
+    *opt++ = DHCP_OPTION_MESSAGE_TYPE;
+    *opt++ = 1;
+    *opt++ = type;
+    *opt++ = DHCP_OPTION_SERVER_ID;
+    *opt++ = 4;
+    memcpy(opt, &serverIp, 4);
+    opt += 4;
+    if (type != DHCP_NAK)
+    {
+        *opt++ = DHCP_OPTION_LEASE_TIME;
+        *opt++ = 4;
+        memcpy(opt, &leaseTime, 4);
+        opt += 4;
+        *opt++ = DHCP_OPTION_SUBNET_MASK;
+        *opt++ = 4;
+        memcpy(opt, &netmask, 4);
+        opt += 4;
+        *opt++ = DHCP_OPTION_ROUTER;
+        *opt++ = 4;
+        memcpy(opt, &serverIp, 4);
+        opt += 4;
+    }
+    *opt++ = DHCP_OPTION_END;
+
+    len = fake_net_udp_frame(frame, broadcast, s_serverMac, serverIp, IPADDR_BROADCAST, LWIP_IANA_PORT_DHCP_SERVER,
+                             LWIP_IANA_PORT_DHCP_CLIENT, msg, (uint16_t)(opt - msg));
+    if (!fake_net_input(netif, frame, len))
+    {
+        FAIL("DHCP reply dropped");
+    }
+}
+
+static void server_dhcp(struct netif *netif, const uint8_t *msg, uint16_t len)
+{
+    const uint8_t *type      = dhcp_option(msg, len, DHCP_OPTION_MESSAGE_TYPE);
+    const uint8_t *serverId  = dhcp_option(msg, len, DHCP_OPTION_SERVER_ID);
+    const uint8_t *requested = dhcp_option(msg, len, DHCP_OPTION_REQUESTED_IP);
+
+    if (type == NULL)
+    {
+        FAIL("DHCP message without a type");
+    }
+    if (s_seen.firstType == 0)
+    {
+        s_seen.firstType = *type;
+    }
+
+    switch (*type)
+    {
+        case DHCP_DISCOVER:
+            s_seen.discovers++;
+            if (!s_ap.dhcpSilent)
+            {
+                server_reply(netif, msg, DHCP_OFFER, s_ap.givenIp);
+            }
+            break;
+
+        case DHCP_REQUEST:
+            if (requested == NULL)
+            {
+                break;
+            }
+            if (serverId != NULL)
+            {
+                s_seen.selectRequests++;
+            }
+            else
+            {
+                s_seen.rebootRequests++;
+                s_seen.rebootIp = dhcp_option_ip(requested);
+            }
+            if (!s_ap.dhcpSilent)
+            {
+                if (dhcp_option_ip(requested) == s_ap.givenIp)
+                {
+                    server_reply(netif, msg, DHCP_ACK, s_ap.givenIp);
+                }
+                else
+                {
+                    s_seen.naks++;
+                    server_reply(netif, msg, DHCP_NAK, 0);
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/* An ARP probe for the address another host holds gets an answer */
+static void neighbour_arp(struct netif *netif, const uint8_t *frame, uint16_t len)
+{
+    const struct etharp_hdr *arp = (const struct etharp_hdr *)(frame + SIZEOF_ETH_HDR);
+    struct etharp_hdr *reply;
+    uint8_t out[SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR];
+    uint32_t sender;
+    uint32_t target;
+
+    if ((len < sizeof(out)) || (arp->opcode != PP_HTONS(ARP_REQUEST)))
+    {
+        return;
+    }
+    memcpy(&sender, &arp->sipaddr, 4);
+    memcpy(&target, &arp->dipaddr, 4);
+    if (sender != 0)
+    {
+        return;
+    }
+
+    s_seen.probes++;
+    if (!s_ap.ipTaken || (target != s_ap.givenIp))
+    {
+        return;
+    }
+
+    memcpy(out, frame + ETH_HWADDR_LEN, ETH_HWADDR_LEN);
+    memcpy(out + ETH_HWADDR_LEN, s_otherMac, ETH_HWADDR_LEN);
+    out[12] = ETHTYPE_ARP >> 8;
+    out[13] = ETHTYPE_ARP & 0xff;
+    reply = (struct etharp_hdr *)(out + SIZEOF_ETH_HDR);
+    memcpy(reply, arp, SIZEOF_ETHARP_HDR);
+    reply->opcode = PP_HTONS(ARP_REPLY);
+    memcpy(&reply->shwaddr, s_otherMac, ETH_HWADDR_LEN);
+    memcpy(&reply->sipaddr, &target, 4);
+    memcpy(&reply->dhwaddr, &arp->shwaddr, ETH_HWADDR_LEN);
+    memset(&reply->dipaddr, 0, 4);
+    if (!fake_net_input(netif, out, sizeof(out)))
+    {
+        FAIL("ARP reply dropped");
+    }
+}
+
+static void ap_tx_hook(struct netif *netif, const uint8_t *frame, uint16_t len)
+{
+    const uint8_t *msg;
+    uint16_t msgLen;
+
+    if ((len >= SIZEOF_ETH_HDR) && (((frame[12] << 8) | frame[13]) == ETHTYPE_ARP))
+    {
+        neighbour_arp(netif, frame, len);
+        return;
+    }
+
+    msg = fake_net_udp_payload(frame, len, LWIP_IANA_PORT_DHCP_SERVER, &msgLen);
+    if ((msg != NULL) && (msgLen > DHCP_OPTIONS_OFS))
+    {
+        server_dhcp(netif, msg, msgLen);
+    }
+}
+
+/* One boot: joins ap, checks the outcome, and exits with the address the station got */
+static void join_child(TCPIPReturnCode_t expected, uint32_t expectedIp)
+{
+    volatile bool connected = true;
+    TCPIPReturnCode_t ret;
+    uint32_t ip = 0;
+
+    fake_net_set_tx_hook(ap_tx_hook);
+
+    if (eTCPIPSuccess != TCPIP_MANAGER_init())
+    {
+        FAIL("TCPIP_MANAGER_init");
+    }
+    ret = TCPIP_MANAGER_start_sta_interface(true, &connected);
+    if (ret != expected)
+    {
+        FAIL("%s: join returned %d, %d expected", s_ap.ssid, ret, expected);
+    }
+    TCPIP_MANAGER_get_ip_only_sta_interface(&ip);
+    if ((ret == eTCPIPSuccess) && (ip != expectedIp))
+    {
+        FAIL("%s: bound to %s", s_ap.ssid, ip4addr_ntoa((const ip4_addr_t *)&ip));
+    }
+}
+
+static void join(const test_ap_t *ap, TCPIPReturnCode_t expected, uint32_t expectedIp, test_seen_t *seen,
+                 uint32_t *join_ms)
+{
+    test_seen_t *shared = mmap(NULL, sizeof(*shared) + sizeof(uint32_t), PROT_READ | PROT_WRITE,
+                               MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t pid;
+    int status;
+
+    s_ap = *ap;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0)
+    {
+        join_child(expected, expectedIp);
+        *shared                       = s_seen;
+        *(uint32_t *)(shared + 1) = (uint32_t)(sim_now_us() / 1000);
+        exit(0);
+    }
+    if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+        FAIL("%s: join failed", ap->ssid);
+    }
+
+    *seen = *shared;
+    if (join_ms != NULL)
+    {
+        *join_ms = *(uint32_t *)(shared + 1);
+    }
+    munmap(shared, sizeof(*shared) + sizeof(uint32_t));
+}
+
+static void expect_lease(uint32_t ip, uint32_t saves, const char *what)
+{
+    uint32_t leaseIp;
+
+    if (!s_flash->present)
+    {
+        FAIL("%s: no lease saved", what);
+    }
+    /* The address follows the ssid and bssid of the lease */
+    memcpy(&leaseIp, &s_flash->data[48], sizeof(leaseIp));
+    if (leaseIp != ip)
+    {
+        FAIL("%s: lease of %s saved", what, ip4addr_ntoa((const ip4_addr_t *)&leaseIp));
+    }
+    if (s_flash->saves != saves)
+    {
+        FAIL("%s: lease saved %u times, %u expected", what, s_flash->saves, saves);
+    }
+}
+
+int main(void)
+{
+    const test_ap_t home      = {.ssid = "home", .bssid = 1, .givenIp = TEST_POOL_IP};
+    const test_ap_t homeNew   = {.ssid = "home", .bssid = 1, .givenIp = TEST_OTHER_IP};
+    const test_ap_t homeDown  = {.ssid = "home", .bssid = 1, .givenIp = TEST_OTHER_IP, .dhcpSilent = 1};
+    const test_ap_t homeTaken = {.ssid = "home", .bssid = 1, .givenIp = TEST_OTHER_IP, .dhcpSilent = 1, .ipTaken = 1};
+    const test_ap_t homeOther = {.ssid = "home", .bssid = 2, .givenIp = TEST_OTHER_IP, .dhcpSilent = 1};
+    const test_ap_t office    = {.ssid = "office", .bssid = 3, .givenIp = TEST_POOL_IP};
+    test_seen_t seen;
+    uint32_t firstMs;
+    uint32_t rejoinMs;
+    uint32_t firstMsgs;
+
+    s_flash = mmap(NULL, sizeof(*s_flash), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    /* First join */
+    join(&home, eTCPIPSuccess, TEST_POOL_IP, &seen, &firstMs);
+    if ((seen.firstType != DHCP_DISCOVER) || (seen.selectRequests != 1) || (seen.rebootRequests != 0))
+    {
+        FAIL("first join: %u DISCOVER, %u REQUEST", seen.discovers, seen.selectRequests + seen.rebootRequests);
+    }
+    expect_lease(TEST_POOL_IP, 1, "first join");
+    firstMsgs = seen.discovers + seen.selectRequests;
+
+    /* Same AP after a reboot */
+    join(&home, eTCPIPSuccess, TEST_POOL_IP, &seen, &rejoinMs);
+    if ((seen.discovers != 0) || (seen.selectRequests != 0) || (seen.rebootRequests != 1) ||
+        (seen.rebootIp != TEST_POOL_IP))
+    {
+        FAIL("rejoin: %u DISCOVER, %u INIT-REBOOT REQUEST", seen.discovers, seen.rebootRequests);
+    }
+    expect_lease(TEST_POOL_IP, 1, "rejoin");
+
+    /* The server gives another address */
+    join(&homeNew, eTCPIPSuccess, TEST_OTHER_IP, &seen, NULL);
+    if ((seen.firstType != DHCP_REQUEST) || (seen.naks != 1) || (seen.discovers == 0))
+    {
+        FAIL("stale lease: %u NAK, %u DISCOVER", seen.naks, seen.discovers);
+    }
+    expect_lease(TEST_OTHER_IP, 2, "stale lease");
+
+    /* No DHCP answer, the lease is taken back once probed */
+    join(&homeDown, eTCPIPSuccess, TEST_OTHER_IP, &seen, NULL);
+    if ((seen.rebootRequests == 0) || (seen.probes == 0))
+    {
+        FAIL("no DHCP answer: %u INIT-REBOOT REQUEST, %u probes", seen.rebootRequests, seen.probes);
+    }
+
+    /* No DHCP answer and the address is in use */
+    join(&homeTaken, eTCPIPDhcpCLientFailed, 0, &seen, NULL);
+
+    /* No DHCP answer on another AP of the network: asked back, no static fallback */
+    join(&homeOther, eTCPIPDhcpCLientFailed, 0, &seen, NULL);
+    if ((seen.firstType != DHCP_REQUEST) || (seen.probes != 0))
+    {
+        FAIL("other AP: first DHCP message %u, %u probes", seen.firstType, seen.probes);
+    }
+    expect_lease(TEST_OTHER_IP, 2, "other AP");
+
+    /* Another network */
+    join(&office, eTCPIPSuccess, TEST_POOL_IP, &seen, NULL);
+    if ((seen.firstType != DHCP_DISCOVER) || (seen.rebootRequests != 0))
+    {
+        FAIL("other network: first DHCP message %u", seen.firstType);
+    }
+    expect_lease(TEST_POOL_IP, 3, "other network");
+
+    /* Lease forgotten */
+    if (0 == fork())
+    {
+        TCPIP_MANAGER_forget_lease();
+        exit(0);
+    }
+    wait(NULL);
+    if (s_flash->present)
+    {
+        FAIL("lease kept after TCPIP_MANAGER_forget_lease");
+    }
+    join(&office, eTCPIPSuccess, TEST_POOL_IP, &seen, NULL);
+    if ((seen.firstType != DHCP_DISCOVER) || (seen.rebootRequests != 0))
+    {
+        FAIL("forgotten lease: first DHCP message %u", seen.firstType);
+    }
+
+    /* Both include the ARP probes of the address, which take most of the time */
+    printf("tcpip manager: first join bound in %u ms with %u DHCP messages, rejoin in %u ms with 1\n", firstMs,
+           firstMsgs, rejoinMs);
+
+    return 0;
+}
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for wifi_credentials.h, nothing of it is used.
+ */
+
+#ifndef WIFI_CREDENTIALS_H_
+#define WIFI_CREDENTIALS_H_
+
+#endif /* WIFI_CREDENTIALS_H_ */
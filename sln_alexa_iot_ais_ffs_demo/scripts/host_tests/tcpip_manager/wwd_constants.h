@@ -0,0 +1,31 @@
+/*
+ * Host stand-in for wwd_constants.h.
+ */
+
+#ifndef INCLUDED_WWD_CONSTANTS_H_
+#define INCLUDED_WWD_CONSTANTS_H_
+
+typedef enum
+{
+    WICED_FALSE = 0,
+    WICED_TRUE  = 1,
+} wiced_bool_t;
+
+typedef enum
+{
+    WWD_SUCCESS = 0,
+    WWD_NOT_JOINED = 1,
+} wwd_result_t;
+
+typedef enum
+{
+    WWD_STA_INTERFACE = 0,
+    WWD_AP_INTERFACE  = 1,
+} wwd_interface_t;
+
+typedef enum
+{
+    WICED_SECURITY_WPA2_AES_PSK = 0x00400004,
+} wiced_security_t;
+
+#endif /* INCLUDED_WWD_CONSTANTS_H_ */
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for wwd_wifi.h. The test answers wwd_wifi_get_ap_info() with
+ * the AP it joins.
+ */
+
+#ifndef INCLUDED_WWD_WIFI_H
+#define INCLUDED_WWD_WIFI_H
+
+#include <stdint.h>
+
+#include "wwd_constants.h"
+
+typedef struct
+{
+    uint8_t octet[6];
+} wiced_mac_t;
+
+typedef struct
+{
+    uint8_t SSID_len;
+    uint8_t SSID[32];
+    wiced_mac_t BSSID;
+} wl_bss_info_t;
+
+wwd_result_t wwd_wifi_get_ap_info(wl_bss_info_t *ap_info, wiced_security_t *security);
+
+#endif /* INCLUDED_WWD_WIFI_H */
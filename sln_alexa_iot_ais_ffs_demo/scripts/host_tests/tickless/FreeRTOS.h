@@ -0,0 +1,38 @@
+/*
+ * Host stand-in for FreeRTOS.h, with the tickless idle settings of
+ * FreeRTOSConfig.h. The interrupt masks are kept by tickless_test.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configUSE_TICKLESS_IDLE                 1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP   2
+#define configTICK_RATE_HZ                      ((TickType_t)1000)
+#define configLIBRARY_LOWEST_INTERRUPT_PRIORITY 15U
+
+#define configPRE_SLEEP_PROCESSING(x)
+#define configPOST_SLEEP_PROCESSING(x)
+
+#define portSET_INTERRUPT_MASK_FROM_ISR()    0U
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x) (void)(x)
+#define portYIELD_FROM_ISR(x)                (void)(x)
+
+/* portable.h */
+void vPortSetupTimerInterrupt(void);
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+#endif /* INC_FREERTOS_H */
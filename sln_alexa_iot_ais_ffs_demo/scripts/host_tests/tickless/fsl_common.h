@@ -0,0 +1,73 @@
+/*
+ * Host stand-in for fsl_common.h, with the clock, NVIC and CMSIS calls of
+ * sln_tickless.c. The NVIC and the core are faked by tickless_test.c:
+ * __enable_irq() runs the pending interrupts, __WFI() moves the virtual clock
+ * on to the next one.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef int32_t status_t;
+
+typedef enum
+{
+    GPT1_IRQn = 100,
+} IRQn_Type;
+
+typedef enum
+{
+    kCLOCK_OscClk,
+} clock_name_t;
+
+typedef enum
+{
+    kCLOCK_PerclkMux,
+} clock_mux_t;
+
+typedef enum
+{
+    kCLOCK_PerclkDiv,
+} clock_div_t;
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+#define SDK_ISR_EXIT_BARRIER
+
+static inline void CLOCK_SetMux(clock_mux_t mux, uint32_t value)
+{
+}
+
+static inline void CLOCK_SetDiv(clock_div_t divider, uint32_t value)
+{
+}
+
+static inline uint32_t CLOCK_GetFreq(clock_name_t name)
+{
+    return 24000000U;
+}
+
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+}
+
+void EnableIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+
+void __disable_irq(void);
+void __enable_irq(void);
+void __WFI(void);
+
+static inline void __DSB(void)
+{
+}
+
+static inline void __ISB(void)
+{
+}
+
+#endif /* _FSL_COMMON_H_ */
@@ -0,0 +1,54 @@
+/*
+ * Host stand-in for fsl_gpt.h. GPT1 is faked by tickless_test.c: its counter
+ * is the virtual time in microseconds, wrapping at 32 bits, and output compare
+ * 1 sets its flag as the counter reaches the compare value.
+ */
+
+#ifndef _FSL_GPT_H_
+#define _FSL_GPT_H_
+
+#include "fsl_common.h"
+
+typedef struct
+{
+    int unused;
+} GPT_Type;
+
+extern GPT_Type g_fakeGpt1;
+#define GPT1 (&g_fakeGpt1)
+
+typedef enum
+{
+    kGPT_OutputCompare_Channel1 = 0,
+} gpt_output_compare_channel_t;
+
+enum
+{
+    kGPT_OutputCompare1InterruptEnable = 1U << 0,
+};
+
+enum
+{
+    kGPT_OutputCompare1Flag = 1U << 0,
+};
+
+typedef struct
+{
+    bool enableFreeRun;
+    uint32_t divider;
+} gpt_config_t;
+
+static inline void GPT_GetDefaultConfig(gpt_config_t *config)
+{
+    config->enableFreeRun = false;
+    config->divider       = 1U;
+}
+
+void GPT_Init(GPT_Type *base, const gpt_config_t *config);
+void GPT_StartTimer(GPT_Type *base);
+uint32_t GPT_GetCurrentTimerCount(GPT_Type *base);
+void GPT_SetOutputCompareValue(GPT_Type *base, gpt_output_compare_channel_t channel, uint32_t value);
+void GPT_EnableInterrupts(GPT_Type *base, uint32_t mask);
+void GPT_ClearStatusFlags(GPT_Type *base, uint32_t mask);
+
+#endif /* _FSL_GPT_H_ */
@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for task.h. The tick count and the tasks waiting on it are a
+ * model in tickless_test.c.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef enum
+{
+    eAbortSleep = 0,
+    eStandardSleep,
+    eNoTasksWaitingTimeout,
+} eSleepModeStatus;
+
+BaseType_t xTaskIncrementTick(void);
+void vTaskStepTick(TickType_t xTicksToJump);
+eSleepModeStatus eTaskConfirmSleepModeStatus(void);
+
+/* Only the idle task and the interrupts run */
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif /* INC_TASK_H */
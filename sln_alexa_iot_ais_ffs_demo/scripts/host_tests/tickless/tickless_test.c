@@ -0,0 +1,413 @@
+/*
+ * Host check of the tickless idle of sln_tickless.c, on a virtual clock.
+ *
+ * GPT1 is a fake one: its counter is the virtual time in microseconds,
+ * wrapping at 32 bits, and its output compare pends the interrupt as the
+ * counter reaches it. The kernel is a model of the idle task and of a few
+ * tasks each due on a tick. The microphone and amplifier DMA interrupts come
+ * on their own schedule and report to SLN_TICKLESS_PeriodicIrqDone() as the
+ * drivers do. The core only moves on in __WFI(), to the next interrupt. The
+ * phases run back to back:
+ *  - microphones: a block every 10ms, tasks every 100ms and 1s;
+ *  - playback: on top of the microphones, the amplifier plays 20ms chunks,
+ *    then 2ms silence chunks, then stops. Its chunks end 0.7ms after a
+ *    microphone block;
+ *  - idle: the microphones stop without a word, a task every 40 minutes, the
+ *    GPT counter wraps 72 minutes in.
+ *
+ * After each pass of the idle task the tick count must be the time in ms,
+ * rounded down, and every task must run on the microsecond its tick is due.
+ * No sleep with the tick stopped may be cut shorter than
+ * SLN_TICKLESS_MIN_SLEEP_US by a periodic interrupt.
+ *
+ * Build and run with "make -C scripts/host_tests tickless".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fsl_gpt.h"
+#include "sln_tickless.h"
+#include "task.h"
+
+#define TEST_MIC_FIRST_US  7300U
+#define TEST_MIC_PERIOD_US 10000U /* PDM_PCM_BLOCK_PERIOD_US */
+#define TEST_MIC_END_MS    90000U
+
+#define TEST_AMP_CHUNK_US   20000U /* PCM_AMP_DMA_CHUNK_SIZE */
+#define TEST_AMP_CHUNKS     150U
+#define TEST_AMP_SILENCE_US 2000U
+#define TEST_AMP_SILENCES   10U /* AMP_SILENCE_MAX_CHUNKS */
+
+#define TEST_US_PER_TICK 1000U
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("tickless: ");           \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+typedef struct
+{
+    const char *name;
+    TickType_t first;
+    TickType_t period;
+    TickType_t last;     /* Last tick it may be due on */
+    void (*work)(void); /* Run on each tick due, if any */
+    TickType_t next;
+    uint32_t runs;
+} test_task_t;
+
+static void start_playback(void);
+
+static test_task_t s_tasks[] = {
+    {.name = "100ms", .first = 100, .period = 100, .last = TEST_MIC_END_MS},
+    {.name = "1s", .first = 1000, .period = 1000, .last = TEST_MIC_END_MS},
+    {.name = "playback", .first = 60008, .period = 5000, .last = 85008, .work = start_playback},
+    {.name = "40min", .first = 2490000, .period = 2400000, .last = 4890000},
+};
+
+GPT_Type g_fakeGpt1;
+
+static uint64_t s_now;
+
+static bool s_gptStarted;
+static bool s_gptIrqEnabled;
+static bool s_gptFlag;
+static bool s_gptPending;
+static uint32_t s_gptCompare;
+static uint32_t s_gptIrqs;
+
+static uint64_t s_micNext = TEST_MIC_FIRST_US;
+static bool s_micPending;
+static uint32_t s_micIrqs;
+
+static uint64_t s_ampNext = UINT64_MAX;
+static bool s_ampPending;
+static uint32_t s_ampChunk;
+static uint32_t s_ampIrqs;
+
+static TickType_t s_ticks;
+static uint32_t s_tickIrqs; /* Ticks counted by the interrupt */
+
+void GPT1_IRQHandler(void);
+
+void GPT_Init(GPT_Type *base, const gpt_config_t *config)
+{
+    if (!config->enableFreeRun || (24U != config->divider))
+    {
+        FAIL("GPT not free running at 1MHz, divider %u", config->divider);
+    }
+}
+
+void GPT_StartTimer(GPT_Type *base)
+{
+    s_gptStarted = true;
+}
+
+uint32_t GPT_GetCurrentTimerCount(GPT_Type *base)
+{
+    return (uint32_t)s_now;
+}
+
+void GPT_SetOutputCompareValue(GPT_Type *base, gpt_output_compare_channel_t channel, uint32_t value)
+{
+    s_gptCompare = value;
+}
+
+void GPT_EnableInterrupts(GPT_Type *base, uint32_t mask)
+{
+    s_gptIrqEnabled = (0 != (mask & kGPT_OutputCompare1InterruptEnable));
+}
+
+void GPT_ClearStatusFlags(GPT_Type *base, uint32_t mask)
+{
+    if (mask & kGPT_OutputCompare1Flag)
+    {
+        s_gptFlag = false;
+    }
+}
+
+void EnableIRQ(IRQn_Type irq)
+{
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    s_gptPending = true;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    s_gptPending = false;
+}
+
+/* Time of the next compare match, the counter passed the compare value already when they are equal */
+static uint64_t gpt_next_match(void)
+{
+    uint64_t delta = (uint32_t)(s_gptCompare - (uint32_t)s_now);
+
+    if (!s_gptStarted || !s_gptIrqEnabled)
+    {
+        return UINT64_MAX;
+    }
+
+    return s_now + ((0U == delta) ? (1ULL << 32) : delta);
+}
+
+static bool irq_pending(void)
+{
+    return (s_gptIrqEnabled && s_gptFlag) || s_gptPending || s_micPending || s_ampPending;
+}
+
+static void mic_irq(void)
+{
+    s_micIrqs++;
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Microphones, TEST_MIC_PERIOD_US);
+}
+
+/* The chunk queued behind the one that ended is playing now */
+static void amp_irq(void)
+{
+    uint32_t playUs = 0;
+
+    s_ampIrqs++;
+    s_ampChunk++;
+    if (s_ampChunk < TEST_AMP_CHUNKS)
+    {
+        playUs = TEST_AMP_CHUNK_US;
+    }
+    else if (s_ampChunk < TEST_AMP_CHUNKS + TEST_AMP_SILENCES)
+    {
+        playUs = TEST_AMP_SILENCE_US;
+    }
+
+    s_ampNext = (0U != playUs) ? (s_now + playUs) : UINT64_MAX;
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Amplifier, playUs);
+}
+
+/* The interrupts only run from __enable_irq(), nothing else unmasks them */
+void __disable_irq(void)
+{
+}
+
+void __enable_irq(void)
+{
+    while (irq_pending())
+    {
+        if ((s_gptIrqEnabled && s_gptFlag) || s_gptPending)
+        {
+            s_gptPending = false;
+            s_gptIrqs++;
+            GPT1_IRQHandler();
+        }
+        if (s_micPending)
+        {
+            s_micPending = false;
+            mic_irq();
+        }
+        if (s_ampPending)
+        {
+            s_ampPending = false;
+            amp_irq();
+        }
+    }
+}
+
+/* Wakes on any pending interrupt, masked or not */
+void __WFI(void)
+{
+    uint64_t gpt = gpt_next_match();
+    uint64_t next;
+
+    if (irq_pending())
+    {
+        return;
+    }
+
+    next = MIN(gpt, MIN(s_micNext, s_ampNext));
+    if (UINT64_MAX == next)
+    {
+        FAIL("WFI at %llu us with no interrupt to come", (unsigned long long)s_now);
+    }
+    s_now = next;
+
+    if (gpt == next)
+    {
+        s_gptFlag = true;
+    }
+    if (s_micNext == next)
+    {
+        s_micPending = true;
+        s_micNext += TEST_MIC_PERIOD_US;
+        if (s_micNext >= (uint64_t)TEST_MIC_END_MS * TEST_US_PER_TICK)
+        {
+            /* The microphones stop without a word */
+            s_micNext = UINT64_MAX;
+        }
+    }
+    if (s_ampNext == next)
+    {
+        s_ampPending = true;
+        s_ampNext    = UINT64_MAX;
+    }
+}
+
+/* Tick of the next task due, portMAX_DELAY once they are all done */
+static TickType_t next_deadline(void)
+{
+    TickType_t next = portMAX_DELAY;
+
+    for (uint32_t idx = 0; idx < sizeof(s_tasks) / sizeof(s_tasks[0]); idx++)
+    {
+        if (s_tasks[idx].next <= s_tasks[idx].last)
+        {
+            next = MIN(next, s_tasks[idx].next);
+        }
+    }
+
+    return next;
+}
+
+BaseType_t xTaskIncrementTick(void)
+{
+    s_ticks++;
+    s_tickIrqs++;
+
+    return (next_deadline() <= s_ticks) ? pdTRUE : pdFALSE;
+}
+
+void vTaskStepTick(TickType_t xTicksToJump)
+{
+    if (s_ticks + xTicksToJump >= next_deadline())
+    {
+        FAIL("%u ticks stepped at tick %u, a task is due on %u", xTicksToJump, s_ticks, next_deadline());
+    }
+    s_ticks += xTicksToJump;
+}
+
+eSleepModeStatus eTaskConfirmSleepModeStatus(void)
+{
+    return (next_deadline() <= s_ticks) ? eAbortSleep : eStandardSleep;
+}
+
+static void run_tasks(void)
+{
+    for (uint32_t idx = 0; idx < sizeof(s_tasks) / sizeof(s_tasks[0]); idx++)
+    {
+        test_task_t *task = &s_tasks[idx];
+
+        if ((task->next > task->last) || (task->next > s_ticks))
+        {
+            continue;
+        }
+        if ((uint64_t)task->next * TEST_US_PER_TICK != s_now)
+        {
+            FAIL("task %s due on tick %u ran at %llu us", task->name, task->next, (unsigned long long)s_now);
+        }
+        task->runs++;
+        task->next += task->period;
+
+        if (NULL != task->work)
+        {
+            task->work();
+        }
+    }
+}
+
+/* SLN_AMP_SubmitChunk from idle */
+static void start_playback(void)
+{
+    s_ampChunk = 0;
+    s_ampNext  = s_now + TEST_AMP_CHUNK_US;
+    SLN_TICKLESS_PeriodicIrqDone(kSLN_TICKLESS_Amplifier, TEST_AMP_CHUNK_US);
+}
+
+int main(void)
+{
+    sln_tickless_stats_t before;
+    sln_tickless_stats_t stats;
+    TickType_t expected;
+    uint64_t sleepStart;
+    uint64_t shortest = UINT64_MAX;
+    uint32_t passes   = 0;
+
+    for (uint32_t idx = 0; idx < sizeof(s_tasks) / sizeof(s_tasks[0]); idx++)
+    {
+        s_tasks[idx].next = s_tasks[idx].first;
+    }
+
+    vPortSetupTimerInterrupt();
+
+    while (1)
+    {
+        run_tasks();
+        if (portMAX_DELAY == next_deadline())
+        {
+            break;
+        }
+
+        /* prvIdleTask */
+        expected = next_deadline() - s_ticks;
+        if (expected >= configEXPECTED_IDLE_TIME_BEFORE_SLEEP)
+        {
+            SLN_TICKLESS_GetStats(&before);
+            sleepStart = s_now;
+            vPortSuppressTicksAndSleep(expected);
+            SLN_TICKLESS_GetStats(&stats);
+
+            if (stats.sleeps != before.sleeps)
+            {
+                if (s_now - sleepStart < SLN_TICKLESS_MIN_SLEEP_US)
+                {
+                    FAIL("tick stopped at %llu us for %llu us only, mic %u, amplifier %u interrupts",
+                         (unsigned long long)sleepStart, (unsigned long long)(s_now - sleepStart), s_micIrqs,
+                         s_ampIrqs);
+                }
+                shortest = MIN(shortest, s_now - sleepStart);
+            }
+        }
+        else
+        {
+            __disable_irq();
+            __WFI();
+            __enable_irq();
+        }
+        passes++;
+
+        if (s_ticks != s_now / TEST_US_PER_TICK)
+        {
+            FAIL("tick count %u at %llu us", s_ticks, (unsigned long long)s_now);
+        }
+    }
+
+    for (uint32_t idx = 0; idx < sizeof(s_tasks) / sizeof(s_tasks[0]); idx++)
+    {
+        uint32_t runs = ((s_tasks[idx].last - s_tasks[idx].first) / s_tasks[idx].period) + 1U;
+
+        if (s_tasks[idx].runs != runs)
+        {
+            FAIL("task %s ran %u times for %u", s_tasks[idx].name, s_tasks[idx].runs, runs);
+        }
+    }
+
+    SLN_TICKLESS_GetStats(&stats);
+    if (s_tickIrqs + stats.ticksSuppressed != s_ticks)
+    {
+        FAIL("%u ticks, %u counted by the interrupt and %u stepped", s_ticks, s_tickIrqs, stats.ticksSuppressed);
+    }
+    if ((s_now >> 32) == 0)
+    {
+        FAIL("GPT counter never wrapped");
+    }
+
+    printf("tickless: %u ticks in %u GPT interrupts, %u stepped over in %u sleeps of %llu us or more, "
+           "%u skipped, %u mic and %u amplifier interrupts, %u idle passes\n",
+           s_ticks, s_gptIrqs, stats.ticksSuppressed, stats.sleeps, (unsigned long long)shortest, stats.skipped,
+           s_micIrqs, s_ampIrqs, passes);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * Host stand-in for FreeRTOS.h. Only the LED renderer of ux_attention_system.c
+ * runs, the task and its queue are never started.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+typedef struct
+{
+    int unused;
+} StaticTask_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  (pdTRUE)
+#define pdFAIL  (pdFALSE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configPRINTF(x) printf x
+#define configASSERT(x)                                                \
+    do                                                                 \
+    {                                                                  \
+        if (!(x))                                                      \
+        {                                                              \
+            printf("ux led: assert %s at %s:%d\n", #x, __FILE__, __LINE__); \
+            exit(1);                                                   \
+        }                                                              \
+    } while (0)
+
+/* True while the test runs the PIT interrupt handler */
+extern bool g_fakeInsideInterrupt;
+
+static inline BaseType_t xPortIsInsideInterrupt(void)
+{
+    return g_fakeInsideInterrupt ? pdTRUE : pdFALSE;
+}
+
+#endif /* INC_FREERTOS_H */
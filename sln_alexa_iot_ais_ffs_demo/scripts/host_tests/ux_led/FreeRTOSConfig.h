@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for FreeRTOSConfig.h.
+ */
+
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#define configMAX_SYSCALL_INTERRUPT_PRIORITY 2
+#define configTIMER_TASK_PRIORITY            14
+
+#endif /* FREERTOS_CONFIG_H */
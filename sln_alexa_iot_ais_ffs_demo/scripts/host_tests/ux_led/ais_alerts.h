@@ -0,0 +1,17 @@
+/*
+ * Host stand-in for ais_alerts.h.
+ */
+
+#ifndef AIS_ALERTS_H_
+#define AIS_ALERTS_H_
+
+#include <stdint.h>
+
+#include "timers.h"
+
+static inline uint32_t AIS_Alerts_GetUxNotifyBit(void)
+{
+    return 0;
+}
+
+#endif /* AIS_ALERTS_H_ */
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for aisv2_app.h, the AIS state a pattern resumes to is set by
+ * the test.
+ */
+
+#ifndef AISV2_APP_H_
+#define AISV2_APP_H_
+
+typedef enum
+{
+    AIS_STATE_IDLE,
+    AIS_STATE_THINKING,
+    AIS_STATE_SPEAKING,
+    AIS_STATE_ALERTING,
+    AIS_STATE_DO_NOT_DISTURB,
+    AIS_STATE_NOTIFICATION,
+    AIS_STATE_INVALID
+} ais_state_t;
+
+typedef struct
+{
+    ais_state_t state;
+} ais_app_data_t;
+
+ais_app_data_t *AIS_APP_GetAppData(void);
+
+#endif /* AISV2_APP_H_ */
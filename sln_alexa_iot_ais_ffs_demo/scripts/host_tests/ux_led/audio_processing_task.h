@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for audio_processing_task.h, the mic mute is set by the test.
+ */
+
+#ifndef AUDIO_PROCESSING_TASK_H_
+#define AUDIO_PROCESSING_TASK_H_
+
+typedef enum __mic_mute_mode
+{
+    kMicMuteModeOff = 0,
+    kMicMuteModeOn,
+} mic_mute_mode_t;
+
+mic_mute_mode_t audio_processing_get_mic_mute(void);
+
+#endif /* AUDIO_PROCESSING_TASK_H_ */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for board.h.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#include "fsl_common.h"
+
+#endif /* _BOARD_H_ */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for clock_config.h, nothing of it is used.
+ */
+
+#ifndef CLOCK_CONFIG_H_
+#define CLOCK_CONFIG_H_
+
+#endif /* CLOCK_CONFIG_H_ */
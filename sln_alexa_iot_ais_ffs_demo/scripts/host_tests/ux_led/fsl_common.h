@@ -0,0 +1,77 @@
+/*
+ * Host stand-in for fsl_common.h, with the clock and NVIC calls of the LED
+ * code. The clocks run at their board rates.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+enum
+{
+    kStatus_Success         = 0,
+    kStatus_Fail            = 1,
+    kStatus_InvalidArgument = 4,
+};
+
+typedef enum
+{
+    kCLOCK_OscClk,
+    kCLOCK_IpgClk,
+} clock_name_t;
+
+typedef enum
+{
+    kCLOCK_Gpio1,
+} clock_ip_name_t;
+
+typedef enum
+{
+    kCLOCK_PerclkMux,
+} clock_mux_t;
+
+typedef enum
+{
+    kCLOCK_PerclkDiv,
+    kCLOCK_AhbDiv,
+    kCLOCK_IpgDiv,
+} clock_div_t;
+
+typedef enum
+{
+    PIT_IRQn = 122,
+} IRQn_Type;
+
+#define USEC_TO_COUNT(us, clockFreqInHz) (uint64_t)(((uint64_t)(us) * (clockFreqInHz)) / 1000000U)
+
+static inline uint32_t CLOCK_GetFreq(clock_name_t name)
+{
+    return (name == kCLOCK_OscClk) ? 24000000U : 150000000U;
+}
+
+static inline void CLOCK_EnableClock(clock_ip_name_t name)
+{
+}
+
+static inline void CLOCK_SetMux(clock_mux_t mux, uint32_t value)
+{
+}
+
+static inline void CLOCK_SetDiv(clock_div_t div, uint32_t value)
+{
+}
+
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+}
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq)
+{
+}
+
+#endif /* _FSL_COMMON_H_ */
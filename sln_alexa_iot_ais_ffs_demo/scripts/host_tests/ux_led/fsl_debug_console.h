@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for fsl_debug_console.h, nothing of it is used.
+ */
+
+#ifndef FSL_DEBUG_CONSOLE_H_
+#define FSL_DEBUG_CONSOLE_H_
+
+#endif /* FSL_DEBUG_CONSOLE_H_ */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for fsl_device_registers.h, nothing of it is used.
+ */
+
+#ifndef FSL_DEVICE_REGISTERS_H_
+#define FSL_DEVICE_REGISTERS_H_
+
+#endif /* FSL_DEVICE_REGISTERS_H_ */
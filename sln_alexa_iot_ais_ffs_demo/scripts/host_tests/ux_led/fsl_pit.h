@@ -0,0 +1,59 @@
+/*
+ * Host stand-in for fsl_pit.h. Channel 0 is the fake PIT of the test: it
+ * counts down on the virtual clock of the test and calls the interrupt
+ * handler when it expires. As on the chip, the load value written while the
+ * timer runs is used from the next reload on.
+ */
+
+#ifndef _FSL_PIT_H_
+#define _FSL_PIT_H_
+
+#include "fsl_common.h"
+
+typedef struct
+{
+    int unused;
+} PIT_Type;
+
+typedef enum
+{
+    kPIT_Chnl_0 = 0,
+} pit_chnl_t;
+
+enum
+{
+    kPIT_TimerFlag            = 1,
+    kPIT_TimerInterruptEnable = 1,
+};
+
+typedef struct
+{
+    bool enableRunInDebug;
+} pit_config_t;
+
+extern PIT_Type g_fakePit;
+#define PIT (&g_fakePit)
+
+/* Implemented by the test */
+void PIT_SetTimerPeriod(PIT_Type *base, pit_chnl_t channel, uint32_t count);
+void PIT_StartTimer(PIT_Type *base, pit_chnl_t channel);
+void PIT_StopTimer(PIT_Type *base, pit_chnl_t channel);
+
+static inline void PIT_GetDefaultConfig(pit_config_t *config)
+{
+    config->enableRunInDebug = false;
+}
+
+static inline void PIT_Init(PIT_Type *base, const pit_config_t *config)
+{
+}
+
+static inline void PIT_EnableInterrupts(PIT_Type *base, pit_chnl_t channel, uint32_t mask)
+{
+}
+
+static inline void PIT_ClearStatusFlags(PIT_Type *base, pit_chnl_t channel, uint32_t mask)
+{
+}
+
+#endif /* _FSL_PIT_H_ */
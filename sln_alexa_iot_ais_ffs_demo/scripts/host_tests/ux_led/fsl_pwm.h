@@ -0,0 +1,96 @@
+/*
+ * Host stand-in for fsl_pwm.h. PWM2 is a register block in RAM, the test sets
+ * the modulo of the submodules and reads the duty registers back when the
+ * load okay bit is set.
+ */
+
+#ifndef _FSL_PWM_H_
+#define _FSL_PWM_H_
+
+#include "fsl_common.h"
+
+typedef struct
+{
+    struct
+    {
+        uint16_t VAL1;
+        uint16_t VAL2;
+        uint16_t VAL3;
+    } SM[4];
+} PWM_Type;
+
+typedef enum
+{
+    kPWM_Module_0 = 0,
+    kPWM_Module_1,
+    kPWM_Module_2,
+    kPWM_Module_3,
+} pwm_submodule_t;
+
+typedef enum
+{
+    kPWM_PwmA = 0,
+} pwm_channels_t;
+
+typedef enum
+{
+    kPWM_SignedCenterAligned = 0,
+} pwm_mode_t;
+
+typedef enum
+{
+    kPWM_LowTrue = 1,
+} pwm_level_select_t;
+
+enum
+{
+    kPWM_Control_Module_0 = 1U << 0,
+    kPWM_Control_Module_1 = 1U << 1,
+    kPWM_Control_Module_3 = 1U << 3,
+};
+
+typedef struct
+{
+    bool enableDebugMode;
+} pwm_config_t;
+
+typedef struct
+{
+    pwm_channels_t pwmChannel;
+    uint8_t dutyCyclePercent;
+    pwm_level_select_t level;
+    uint16_t deadtimeValue;
+} pwm_signal_param_t;
+
+extern PWM_Type g_fakePwm;
+#define PWM2 (&g_fakePwm)
+
+/* Implemented by the test */
+void PWM_SetPwmLdok(PWM_Type *base, uint8_t subModulesToUpdate, bool value);
+
+static inline void PWM_GetDefaultConfig(pwm_config_t *config)
+{
+    config->enableDebugMode = false;
+}
+
+static inline status_t PWM_Init(PWM_Type *base, pwm_submodule_t subModule, const pwm_config_t *config)
+{
+    return kStatus_Success;
+}
+
+static inline status_t PWM_SetupPwm(PWM_Type *base, pwm_submodule_t subModule, const pwm_signal_param_t *chnlParams,
+                                    uint8_t numOfChnls, pwm_mode_t mode, uint32_t pwmFreq_Hz, uint32_t srcClock_Hz)
+{
+    return kStatus_Success;
+}
+
+static inline void PWM_UpdatePwmDutycycle(PWM_Type *base, pwm_submodule_t subModule, pwm_channels_t pwmSignal,
+                                          pwm_mode_t currPwmMode, uint8_t dutyCyclePercent)
+{
+}
+
+static inline void PWM_StartTimer(PWM_Type *base, uint8_t subModulesToStart)
+{
+}
+
+#endif /* _FSL_PWM_H_ */
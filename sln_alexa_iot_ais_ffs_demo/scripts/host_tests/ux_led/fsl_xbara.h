@@ -0,0 +1,37 @@
+/*
+ * Host stand-in for fsl_xbara.h, the fault inputs are not modelled.
+ */
+
+#ifndef _FSL_XBARA_H_
+#define _FSL_XBARA_H_
+
+typedef struct
+{
+    int unused;
+} XBARA_Type;
+
+typedef enum
+{
+    kXBARA1_InputLogicHigh,
+} xbar_input_signal_t;
+
+typedef enum
+{
+    kXBARA1_OutputFlexpwm2Fault0,
+    kXBARA1_OutputFlexpwm2Fault1,
+    kXBARA1_OutputFlexpwm1234Fault2,
+    kXBARA1_OutputFlexpwm1234Fault3,
+} xbar_output_signal_t;
+
+#define XBARA1 ((XBARA_Type *)0)
+
+static inline void XBARA_Init(XBARA_Type *base)
+{
+}
+
+static inline void XBARA_SetSignalsConnection(XBARA_Type *base, xbar_input_signal_t input,
+                                              xbar_output_signal_t output)
+{
+}
+
+#endif /* _FSL_XBARA_H_ */
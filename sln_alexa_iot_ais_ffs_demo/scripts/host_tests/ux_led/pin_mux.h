@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for pin_mux.h, nothing of it is used.
+ */
+
+#ifndef PIN_MUX_H_
+#define PIN_MUX_H_
+
+#endif /* PIN_MUX_H_ */
@@ -0,0 +1,36 @@
+/*
+ * Host stand-in for queue.h. The UX states sent from the PIT interrupt, when a
+ * pattern with a repeat count ends, are handed to the test.
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef void *QueueHandle_t;
+
+/* Implemented by the test */
+BaseType_t fake_queue_send(QueueHandle_t queue, const void *item);
+
+static inline QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    return NULL;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    return pdFALSE;
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return fake_queue_send(queue, item);
+}
+
+static inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    return fake_queue_send(queue, item);
+}
+
+#endif /* QUEUE_H */
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for sln_amplifier.h, nothing of it is used.
+ */
+
+#ifndef SLN_AMPLIFIER_H_
+#define SLN_AMPLIFIER_H_
+
+#endif /* SLN_AMPLIFIER_H_ */
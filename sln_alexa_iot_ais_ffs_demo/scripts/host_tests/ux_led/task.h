@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for task.h, the UX task is never started.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+static inline TaskHandle_t xTaskCreateStatic(TaskFunction_t code, const char *name, uint32_t stackDepth,
+                                             void *params, UBaseType_t priority, StackType_t *stack,
+                                             StaticTask_t *task)
+{
+    return NULL;
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+}
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for timers.h, the alert timer is never started.
+ */
+
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include "FreeRTOS.h"
+
+typedef void *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+static inline TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                                         TimerCallbackFunction_t callback)
+{
+    return NULL;
+}
+
+static inline BaseType_t xTimerReset(TimerHandle_t timer, TickType_t ticks)
+{
+    return pdPASS;
+}
+
+#endif /* TIMERS_H */
@@ -0,0 +1,346 @@
+/*
+ * Host check of the LED patterns of ux_attention_system.c, against golden
+ * frames.
+ *
+ * ux_attention_system.c is included, so its pattern table and renderer run as
+ * they are, with the real PWM frames of sln_RT10xx_RGB_LED_driver_pwm.c. The
+ * PIT is a fake one on a virtual clock: it calls the real interrupt handler
+ * as it expires. Each pattern of the table is played for a few seconds, once
+ * more with the mics muted when that changes its colors. Every PWM frame
+ * loaded is written down with its time, along with the UX state sent back
+ * when a pattern ends, and the whole is compared with golden.txt. A fade,
+ * which no state uses at the moment, is rendered as well.
+ *
+ * On top of the golden frames, no pattern may take more than 5 PIT
+ * interrupts a second, and speaking no more than 2: it lasts as long as the
+ * answers do.
+ *
+ * Build and run with "make -C scripts/host_tests ux_led". After a change of
+ * the patterns, run "ux_led/ux_led_test ux_led/golden.txt --update" and
+ * review the diff of golden.txt.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fsl_pwm.h"
+#include "ux_attention_system.c"
+
+#define TEST_PLAY_MS           6000U
+#define TEST_OUT_MAX           (256 * 1024)
+#define TEST_MAX_IRQ_RATE      5U /* A second, thinking toggles every 200 ms */
+#define TEST_SPEAKING_IRQ_RATE 2U
+
+/* Counts of the PIT source clock in a millisecond */
+#define TEST_COUNTS_PER_MS (PIT_SOURCE_CLOCK / 1000U)
+
+#define FAIL(...)                       \
+    do                                  \
+    {                                   \
+        printf("ux led: ");             \
+        printf(__VA_ARGS__);            \
+        printf("\n");                   \
+        exit(1);                        \
+    } while (0)
+
+PIT_Type g_fakePit;
+PWM_Type g_fakePwm;
+bool g_fakeInsideInterrupt;
+
+static bool s_muted;
+static ais_app_data_t s_appData = {.state = AIS_STATE_IDLE};
+
+/* Fake PIT channel 0, in PIT counts */
+static bool s_pitRunning;
+static uint32_t s_pitLoad;
+static uint64_t s_pitNext;
+static uint64_t s_now;
+
+static uint16_t s_lastFrame[3];
+static char s_out[TEST_OUT_MAX];
+static size_t s_outLen;
+
+static const char *s_stateNames[] = {
+    [uxIdle]                 = "idle",
+    [uxListeningStart]       = "listening start",
+    [uxListeningActive]      = "listening active",
+    [uxListeningEnd]         = "listening end",
+    [uxThinking]             = "thinking",
+    [uxSpeaking]             = "speaking",
+    [uxSpeakingEnd]          = "speaking end",
+    [uxMicOntoOff]           = "mic on to off",
+    [uxMicOfftoOn]           = "mic off to on",
+    [uxTimer]                = "timer",
+    [uxTimerShort]           = "timer short",
+    [uxTimerEnd]             = "timer end",
+    [uxAlarm]                = "alarm",
+    [uxAlarmShort]           = "alarm short",
+    [uxAlarmEnd]             = "alarm end",
+    [uxReminder]             = "reminder",
+    [uxReminderShort]        = "reminder short",
+    [uxReminderEnd]          = "reminder end",
+    [uxNotificationIncoming] = "notification incoming",
+    [uxNotificationQueued]   = "notification queued",
+    [uxNotificationCleared]  = "notification cleared",
+    [uxDoNotDisturb]         = "do not disturb",
+    [uxReconnecting]         = "reconnecting",
+    [uxConnected]            = "connected",
+    [uxBootUp]               = "boot up",
+    [uxApMode]               = "ap mode",
+    [uxWiFiSetup]            = "wifi setup",
+    [uxAccessPointFound]     = "access point found",
+    [uxNoAccessPoint]        = "no access point",
+    [uxInvalidWiFiCred]      = "invalid wifi credentials",
+    [uxDeviceChange]         = "device change",
+    [uxDiscovery]            = "discovery",
+    [uxAuthentication]       = "authentication",
+    [uxDisconnected]         = "disconnected",
+    [uxBleProvision]         = "ble provision",
+    [uxFSSProvision]         = "ffs provision",
+    [uxError]                = "error",
+    [uxFactoryReset]         = "factory reset",
+    [uxWiFiCredentialsErase] = "wifi credentials erase",
+    [uxUGSSessionRestart]    = "ugs session restart",
+};
+
+static void out(const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    s_outLen += vsnprintf(&s_out[s_outLen], sizeof(s_out) - s_outLen, fmt, args);
+    va_end(args);
+
+    if (s_outLen >= sizeof(s_out) - 1)
+    {
+        FAIL("output too long");
+    }
+}
+
+/* Time of the event, in ms with the fraction of the PIT counts */
+static void out_time(void)
+{
+    out("%6llu.%03llu ", (unsigned long long)(s_now / TEST_COUNTS_PER_MS),
+        (unsigned long long)((s_now % TEST_COUNTS_PER_MS) * 1000U / TEST_COUNTS_PER_MS));
+}
+
+mic_mute_mode_t audio_processing_get_mic_mute(void)
+{
+    return s_muted ? kMicMuteModeOn : kMicMuteModeOff;
+}
+
+ais_app_data_t *AIS_APP_GetAppData(void)
+{
+    return &s_appData;
+}
+
+BaseType_t fake_queue_send(QueueHandle_t queue, const void *item)
+{
+    ux_attention_states_t state = *(const ux_attention_states_t *)item;
+
+    if (!g_fakeInsideInterrupt)
+    {
+        FAIL("state %d sent outside of the interrupt", state);
+    }
+    out_time();
+    out("resume %s\n", s_stateNames[state]);
+
+    return pdPASS;
+}
+
+void PWM_SetPwmLdok(PWM_Type *base, uint8_t subModulesToUpdate, bool value)
+{
+    const uint8_t subModules[3] = {kPWM_Module_0, kPWM_Module_1, kPWM_Module_3};
+    uint16_t frame[3];
+
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        frame[channel] = base->SM[subModules[channel]].VAL3;
+        if ((uint16_t)(base->SM[subModules[channel]].VAL2 + frame[channel]) != 0)
+        {
+            FAIL("pulse of channel %u not centered", channel);
+        }
+    }
+
+    /* Only the changes */
+    if (0 != memcmp(frame, s_lastFrame, sizeof(frame)))
+    {
+        out_time();
+        out("%5u %5u %5u\n", frame[0], frame[1], frame[2]);
+        memcpy(s_lastFrame, frame, sizeof(frame));
+    }
+}
+
+void PIT_SetTimerPeriod(PIT_Type *base, pit_chnl_t channel, uint32_t count)
+{
+    if (count == 0)
+    {
+        FAIL("PIT period of 0");
+    }
+    s_pitLoad = count;
+}
+
+void PIT_StartTimer(PIT_Type *base, pit_chnl_t channel)
+{
+    s_pitRunning = true;
+    s_pitNext    = s_now + s_pitLoad;
+}
+
+void PIT_StopTimer(PIT_Type *base, pit_chnl_t channel)
+{
+    s_pitRunning = false;
+}
+
+/* Plays pattern for ms, returns the PIT interrupts taken */
+static uint32_t play(const char *name, const ux_led_pattern_t *pattern, bool muted, rgb_led_brightness_t brightness,
+                     uint32_t ms)
+{
+    uint64_t end  = (uint64_t)ms * TEST_COUNTS_PER_MS;
+    uint32_t irqs = 0;
+
+    out("[%s%s%s]\n", name, muted ? ", muted" : "", (brightness != LED_BRIGHT_HIGH) ? ", low" : "");
+
+    s_now = 0;
+    /* Unlike any frame, so the first one is written down */
+    memset(s_lastFrame, 0xff, sizeof(s_lastFrame));
+    s_muted           = muted;
+    currentBrightness = brightness;
+
+    ux_led_play(pattern);
+
+    while (s_pitRunning && (s_pitNext <= end))
+    {
+        s_now = s_pitNext;
+        /* Reloaded as it expires, before the handler queues the next period */
+        s_pitNext = s_now + s_pitLoad;
+        irqs++;
+
+        g_fakeInsideInterrupt = true;
+        PIT_LED_HANDLER();
+        g_fakeInsideInterrupt = false;
+    }
+
+    out("%u interrupts\n", irqs);
+
+    return irqs;
+}
+
+static bool has_muted_colors(const ux_led_pattern_t *pattern)
+{
+    for (uint32_t key = 0; key < pattern->keyCount; key++)
+    {
+        if (pattern->keys[key].mutedColor != pattern->keys[key].color)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void compare(const char *path, bool update)
+{
+    FILE *file;
+    static char golden[TEST_OUT_MAX];
+    size_t len;
+    size_t line = 1;
+
+    if (update)
+    {
+        file = fopen(path, "w");
+        if ((file == NULL) || (fwrite(s_out, 1, s_outLen, file) != s_outLen))
+        {
+            FAIL("%s not written", path);
+        }
+        fclose(file);
+        return;
+    }
+
+    file = fopen(path, "r");
+    if (file == NULL)
+    {
+        FAIL("%s not found", path);
+    }
+    len = fread(golden, 1, sizeof(golden), file);
+    fclose(file);
+
+    for (size_t idx = 0; (idx < len) && (idx < s_outLen); idx++)
+    {
+        if (golden[idx] != s_out[idx])
+        {
+            FAIL("frames differ from %s at line %zu", path, line);
+        }
+        line += (golden[idx] == '\n');
+    }
+    if (len != s_outLen)
+    {
+        FAIL("frames differ from %s at line %zu, %zu bytes for %zu", path, line, s_outLen, len);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    static const ux_led_keyframe_t fadeKeys[] = {UX_KEY_FADE(LED_COLOR_BLUE, RGB_LED_LEVEL_FULL, kUxLedEaseInOut, 400),
+                                                 UX_KEY_FADE(LED_COLOR_BLUE, 0, kUxLedLinear, 200),
+                                                 UX_KEY(LED_COLOR_OFF, 200)};
+    static const ux_led_pattern_t fade = UX_PATTERN(fadeKeys, 2, kUxLedEndOff);
+    uint32_t irqs;
+    uint32_t speakingIrqs = 0;
+    uint32_t patterns     = 0;
+
+    if (argc < 2)
+    {
+        FAIL("usage: %s <golden file> [--update]", argv[0]);
+    }
+
+    /* Modulo of the submodules, center aligned on a 32768 count period */
+    g_fakePwm.SM[kPWM_Module_0].VAL1 = 0x3fff;
+    g_fakePwm.SM[kPWM_Module_1].VAL1 = 0x3fff;
+    g_fakePwm.SM[kPWM_Module_3].VAL1 = 0x3fff;
+
+    /* The end of a pattern may resume the state of AIS */
+    g_uxQueue       = (QueueHandle_t)&s_appData;
+    s_appData.state = AIS_STATE_THINKING;
+
+    for (uint32_t state = 0; state < sizeof(s_uxPatterns) / sizeof(s_uxPatterns[0]); state++)
+    {
+        const ux_led_pattern_t *pattern = &s_uxPatterns[state];
+
+        if (pattern->keys == NULL)
+        {
+            continue;
+        }
+
+        irqs = play(s_stateNames[state], pattern, false, LED_BRIGHT_HIGH, TEST_PLAY_MS);
+        if (irqs > TEST_MAX_IRQ_RATE * TEST_PLAY_MS / 1000U)
+        {
+            FAIL("%s: %u PIT interrupts in %u ms", s_stateNames[state], irqs, TEST_PLAY_MS);
+        }
+        if (state == uxSpeaking)
+        {
+            speakingIrqs = irqs;
+            if (irqs > TEST_SPEAKING_IRQ_RATE * TEST_PLAY_MS / 1000U)
+            {
+                FAIL("speaking: %u PIT interrupts in %u ms", irqs, TEST_PLAY_MS);
+            }
+        }
+        patterns++;
+
+        if (has_muted_colors(pattern))
+        {
+            play(s_stateNames[state], pattern, true, LED_BRIGHT_HIGH, TEST_PLAY_MS);
+        }
+    }
+
+    play(s_stateNames[uxSpeaking], &s_uxPatterns[uxSpeaking], false, LED_BRIGHT_LOW, TEST_PLAY_MS);
+    play("fade", &fade, false, LED_BRIGHT_HIGH, TEST_PLAY_MS);
+
+    compare(argv[1], (argc > 2) && (0 == strcmp(argv[2], "--update")));
+
+    printf("ux led: %u patterns rendered as in %s, speaking takes %u PIT interrupts in %u ms\n", patterns, argv[1],
+           speakingIrqs, TEST_PLAY_MS);
+
+    return 0;
+}
@@ -23,6 +23,33 @@
 #define AIS_ALERT_TASK_STACK    512U
 #define AIS_ALERT_TASK_PRIORITY (configTIMER_TASK_PRIORITY - 2)
 
+/*
+ * The alerts file is a journal (little endian):
+ * |--ais_alert_journal_hdr_t--|--record--|--record--| ... |--erased (0xFF)--|
+ *
+ * Records are programmed in the erased tail with SLN_FLASH_MGMT_Program, which only writes the flash pages
+ * holding them, so a change doesn't rewrite the file. Once the tail is full the journal is compacted: a new copy
+ * holding one add record per alert is saved.
+ */
+#define AIS_ALERT_JOURNAL_MAGIC   0x4A524C41U /* "ALRJ" */
+#define AIS_ALERT_JOURNAL_VERSION 1U
+
+#define AIS_ALERT_RECORD_HDR_SIZE (sizeof(ais_alert_record_hdr_t))
+#define AIS_ALERT_RECORD_ADD_SIZE (AIS_ALERT_RECORD_HDR_SIZE + ((sizeof(ais_alert_t) + 3U) & ~3U))
+
+/* Room for an add record per alert, and as many records again as half of them before a compaction */
+#ifndef AIS_ALERT_JOURNAL_SIZE
+#define AIS_ALERT_JOURNAL_SIZE \
+    (sizeof(ais_alert_journal_hdr_t) + ((3U * AIS_APP_MAX_ALERT_COUNT / 2U) * AIS_ALERT_RECORD_ADD_SIZE))
+#endif
+
+#define AIS_ALERT_NOT_QUEUED 0xFFFFU
+
+/* Open addressing table of the slots in use by token; a power of two, at least twice the alert count */
+#define AIS_ALERT_TOKEN_INDEX_SIZE (2U * AIS_ABS_MAX_ALERT_COUNT)
+#define AIS_ALERT_TOKEN_INDEX_MASK (AIS_ALERT_TOKEN_INDEX_SIZE - 1U)
+#define AIS_ALERT_NO_SLOT          0xFFFFU
+
 typedef enum _alert_slot_state
 {
     ALERT_SLOT_STATE_EMPTY,
@@ -32,6 +59,44 @@ typedef enum _alert_slot_state
     ALERT_SLOT_STATE_INUSE,
 } alert_slot_state_t;
 
+typedef enum _alert_slot_flags
+{
+    ALERT_SLOT_FLAG_INUSE   = (1U << 0U), /* Slot holds an alert */
+    ALERT_SLOT_FLAG_UNSAVED = (1U << 1U), /* Add record not written to the journal yet */
+    ALERT_SLOT_FLAG_DELETED = (1U << 2U), /* Alert marked for delete, waiting in s_deletedSlots */
+} alert_slot_flags_t;
+
+typedef enum _alert_record_op
+{
+    ALERT_RECORD_ADD     = 0x01, /* Alert saved; followed by the ais_alert_t */
+    ALERT_RECORD_TRIGGER = 0x02, /* Alert triggered offline */
+    ALERT_RECORD_DELETE  = 0x03, /* Alert marked for delete */
+    ALERT_RECORD_REMOVE  = 0x04, /* Alert slot freed */
+    ALERT_RECORD_END     = 0xFF, /* Erased flash */
+} alert_record_op_t;
+
+typedef struct __attribute__((packed)) _ais_alert_journal_hdr
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t slotCount;
+} ais_alert_journal_hdr_t;
+
+typedef struct __attribute__((packed)) _ais_alert_record_hdr
+{
+    uint8_t op;
+    uint8_t reserved;
+    uint16_t slot;
+} ais_alert_record_hdr_t;
+
+/* Min-heap of alert slots ordered by scheduled time */
+typedef struct _ais_alert_heap
+{
+    uint16_t slots[AIS_APP_MAX_ALERT_COUNT];
+    uint16_t pos[AIS_APP_MAX_ALERT_COUNT]; /* Heap position of each slot or AIS_ALERT_NOT_QUEUED */
+    uint32_t count;
+} ais_alert_heap_t;
+
 // TODO: Make this "spark joy"
 extern EventGroupHandle_t s_offlineAudioEventGroup;
 
@@ -45,6 +110,27 @@ static SemaphoreHandle_t s_aisAlertLock;
 volatile static uint32_t s_aisAlertCount = 0U;
 __attribute__((section(".ocram_non_cacheable_bss"))) static ais_alert_t s_aisAlerts[AIS_APP_MAX_ALERT_COUNT];
 
+/* Valid alerts, expired by AIS_Alerts_UpdateState */
+static ais_alert_heap_t s_expiryHeap;
+/* Valid alerts not triggered yet, returned by AIS_Alerts_GetNextDue */
+static ais_alert_heap_t s_dueHeap;
+
+static uint8_t s_slotFlags[AIS_APP_MAX_ALERT_COUNT];
+static uint16_t s_freeSlots[AIS_APP_MAX_ALERT_COUNT];
+static uint32_t s_freeCount = 0U;
+static uint16_t s_unsavedSlots[AIS_APP_MAX_ALERT_COUNT];
+static uint32_t s_unsavedCount = 0U;
+static uint16_t s_deletedSlots[AIS_APP_MAX_ALERT_COUNT];
+static uint32_t s_deletedCount = 0U;
+
+/* Slots in use by token hash, AIS_ALERT_NO_SLOT for an empty entry */
+static uint16_t s_tokenIndex[AIS_ALERT_TOKEN_INDEX_SIZE];
+static uint32_t s_tokenHash[AIS_APP_MAX_ALERT_COUNT];
+
+/* Journal bytes in use; 0 when there is no journal in flash */
+static uint32_t s_journalUsed        = 0U;
+static ais_alert_stats_t s_alertStats = {0};
+
 __attribute__((section(".ocram_non_cacheable_bss"))) StackType_t ais_alert_task_stack_buffer[AIS_ALERT_TASK_STACK];
 __attribute__((section(".ocram_non_cacheable_bss"))) StaticTask_t ais_alert_task_buffer;
 
@@ -108,196 +194,572 @@ static int32_t ais_alert_get_flash_slot_state(ais_alert_t *alertSlot)
     return ret;
 }
 
-int32_t ais_alert_store_alerts_to_nvm(void)
+static bool ais_alert_heap_less(ais_alert_heap_t *heap, uint32_t a, uint32_t b)
 {
-    int32_t ret = -1;
+    return s_aisAlerts[heap->slots[a]].scheduledTime < s_aisAlerts[heap->slots[b]].scheduledTime;
+}
 
-    if (NULL != s_aisAlertLock)
+static void ais_alert_heap_swap(ais_alert_heap_t *heap, uint32_t a, uint32_t b)
+{
+    uint16_t slot = heap->slots[a];
+
+    heap->slots[a]            = heap->slots[b];
+    heap->slots[b]            = slot;
+    heap->pos[heap->slots[a]] = a;
+    heap->pos[heap->slots[b]] = b;
+}
+
+static void ais_alert_heap_sift(ais_alert_heap_t *heap, uint32_t pos)
+{
+    uint32_t child = 0;
+
+    // Up
+    while ((0 < pos) && ais_alert_heap_less(heap, pos, (pos - 1) / 2))
     {
-        if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
+        ais_alert_heap_swap(heap, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+
+    // Down
+    while ((child = (2 * pos) + 1) < heap->count)
+    {
+        if (((child + 1) < heap->count) && ais_alert_heap_less(heap, child + 1, child))
         {
-            ret               = -2;
-            uint32_t fileSize = sizeof(s_aisAlerts);
+            child++;
+        }
 
-            // Allocate ram space for current file
-            ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
+        if (!ais_alert_heap_less(heap, child, pos))
+        {
+            break;
+        }
 
-            if (NULL == flashFile)
-            {
-                ret = -3;
-                goto exit;
-            }
+        ais_alert_heap_swap(heap, pos, child);
+        pos = child;
+    }
+}
 
-            // Read current file into temporary file buffer
-            ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+static void ais_alert_heap_init(ais_alert_heap_t *heap)
+{
+    heap->count = 0U;
+    memset(heap->pos, 0xFF, sizeof(heap->pos));
+}
 
-            if (SLN_FLASH_MGMT_ENOENTRY2 == ret)
-            {
-                // No entry so we should clear flashFile contents
-                memset((uint8_t *)flashFile, 0xFF, fileSize);
+static void ais_alert_heap_insert(ais_alert_heap_t *heap, uint16_t slot)
+{
+    if ((AIS_ALERT_NOT_QUEUED == heap->pos[slot]) && (AIS_APP_MAX_ALERT_COUNT > heap->count))
+    {
+        heap->slots[heap->count] = slot;
+        heap->pos[slot]          = heap->count;
+        heap->count++;
 
-                // Copy in RAM copy of alerts
-                memcpy(flashFile, s_aisAlerts, sizeof(ais_alert_t));
+        ais_alert_heap_sift(heap, heap->count - 1);
+    }
+}
 
-                // Write a new file entry
-                ret = SLN_FLASH_MGMT_Save(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, fileSize);
-            }
-            /* Due to the CRC implementation, CRC will always fail */
-            else if ((SLN_FLASH_MGMT_OK == ret) || (SLN_FLASH_MGMT_EENCRYPT2 == ret))
-            {
-                // Iterate through file and add new valid entries
-                volatile uint32_t nvmInvalidCount = 0;
-                volatile uint32_t ramInvalidCount = 0;
-                for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-                {
-                    volatile bool copyNewSlot       = false;
-                    alert_slot_state_t nvmSlotState = ais_alert_get_flash_slot_state(&flashFile[idx]);
-                    alert_slot_state_t ramSlotState = ais_alert_get_flash_slot_state(&s_aisAlerts[idx]);
+static void ais_alert_heap_remove(ais_alert_heap_t *heap, uint16_t slot)
+{
+    uint32_t pos = heap->pos[slot];
 
-                    // If RAM and Flash contents do not match we must take action
-                    if (memcmp(&(flashFile[idx]), &s_aisAlerts[idx], sizeof(ais_alert_t)))
-                    {
-                        // Tentatively set copy flag to true
-                        copyNewSlot = true;
+    if (AIS_ALERT_NOT_QUEUED != pos)
+    {
+        heap->count--;
 
-                        if ((ALERT_SLOT_STATE_DELETED == nvmSlotState) || (ALERT_SLOT_STATE_INVALID == nvmSlotState))
-                        {
-                            // There is garbage in here or it zeros (can't update)
-                            nvmInvalidCount |= (1U << idx);
-                        }
+        if (pos != heap->count)
+        {
+            ais_alert_heap_swap(heap, pos, heap->count);
+            heap->pos[slot] = AIS_ALERT_NOT_QUEUED;
+            ais_alert_heap_sift(heap, pos);
+        }
+        else
+        {
+            heap->pos[slot] = AIS_ALERT_NOT_QUEUED;
+        }
+    }
+}
 
-                        if ((ALERT_SLOT_STATE_DELETED == ramSlotState) || (ALERT_SLOT_STATE_INVALID == ramSlotState))
-                        {
-                            // There is garbage in here or it zeros (can't update)
-                            ramInvalidCount |= (1U << idx);
+static int32_t ais_alert_heap_top(ais_alert_heap_t *heap)
+{
+    return (0 < heap->count) ? (int32_t)heap->slots[0] : -1;
+}
 
-                            // Reset copy flag back to false; should not copy deleted or invalid data
-                            copyNewSlot = false;
-                        }
-                    }
+static uint32_t ais_alert_token_hash(const char *token, size_t len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261U;
 
-                    if (copyNewSlot)
-                    {
-                        memcpy(&(flashFile[idx]), &s_aisAlerts[idx], sizeof(ais_alert_t));
-                    }
-                }
+    for (size_t idx = 0; idx < len; idx++)
+    {
+        hash ^= (uint8_t)token[idx];
+        hash *= 16777619U;
+    }
 
-                // Make sure invalid counts match in ram and nvm
-                if (nvmInvalidCount == ramInvalidCount)
-                {
-                    // Over write flash file with new valid entries
-                    ret = SLN_FLASH_MGMT_Update(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
-                }
-                else
-                {
-                    // Write a new file entry
-                    ret = SLN_FLASH_MGMT_Save(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, fileSize);
-                }
-            }
-            else
-            {
-                ret = -4;
-                goto exit;
-            }
+    return hash;
+}
 
-            if (0 != ret)
-            {
-                ret = -5;
-                goto exit;
-            }
+/*!
+ * @brief Finds the slot in use holding this token
+ *
+ * @returns Slot of the alert or -1 if not found
+ */
+static int32_t ais_alert_token_find(const char *token, size_t len)
+{
+    uint32_t hash = 0;
+    uint32_t pos  = 0;
+    uint16_t slot = 0;
 
-            // Update RAM copy; re-sync the ram copy with Flash copy
-            ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)s_aisAlerts, &fileSize);
+    len  = safe_strlen(token, (AIS_MAX_ALERT_TOKEN_LEN_BYTES < len) ? AIS_MAX_ALERT_TOKEN_LEN_BYTES : len);
+    hash = ais_alert_token_hash(token, len);
+    pos  = hash & AIS_ALERT_TOKEN_INDEX_MASK;
 
-            /* Due to the CRC implementation, CRC will always fail */
-            if ((0 != ret) && (SLN_FLASH_MGMT_EENCRYPT2 == ret))
-            {
-                ret = -6;
-                goto exit;
-            }
+    while (AIS_ALERT_NO_SLOT != (slot = s_tokenIndex[pos]))
+    {
+        if ((hash == s_tokenHash[slot]) &&
+            (len == safe_strlen(s_aisAlerts[slot].token, AIS_MAX_ALERT_TOKEN_LEN_BYTES)) &&
+            (0 == memcmp(token, s_aisAlerts[slot].token, len)))
+        {
+            return slot;
+        }
+
+        pos = (pos + 1) & AIS_ALERT_TOKEN_INDEX_MASK;
+    }
+
+    return -1;
+}
+
+static void ais_alert_token_add(uint16_t slot)
+{
+    uint32_t pos = 0;
+
+    s_tokenHash[slot] = ais_alert_token_hash(s_aisAlerts[slot].token,
+                                             safe_strlen(s_aisAlerts[slot].token, AIS_MAX_ALERT_TOKEN_LEN_BYTES));
+    pos               = s_tokenHash[slot] & AIS_ALERT_TOKEN_INDEX_MASK;
+
+    while (AIS_ALERT_NO_SLOT != s_tokenIndex[pos])
+    {
+        pos = (pos + 1) & AIS_ALERT_TOKEN_INDEX_MASK;
+    }
+
+    s_tokenIndex[pos] = slot;
+}
+
+static void ais_alert_token_remove(uint16_t slot)
+{
+    uint32_t pos  = s_tokenHash[slot] & AIS_ALERT_TOKEN_INDEX_MASK;
+    uint32_t next = 0;
+    uint32_t home = 0;
 
-        exit:
-            if (NULL != flashFile)
+    while (slot != s_tokenIndex[pos])
+    {
+        if (AIS_ALERT_NO_SLOT == s_tokenIndex[pos])
+        {
+            return;
+        }
+
+        pos = (pos + 1) & AIS_ALERT_TOKEN_INDEX_MASK;
+    }
+
+    // Move back the entries that probed past the freed one, so no lookup stops early
+    next = pos;
+
+    while (AIS_ALERT_NO_SLOT != s_tokenIndex[next = (next + 1) & AIS_ALERT_TOKEN_INDEX_MASK])
+    {
+        home = s_tokenHash[s_tokenIndex[next]] & AIS_ALERT_TOKEN_INDEX_MASK;
+
+        // Only if its own position isn't between the freed one and where it is
+        if (((next - home) & AIS_ALERT_TOKEN_INDEX_MASK) >= ((next - pos) & AIS_ALERT_TOKEN_INDEX_MASK))
+        {
+            s_tokenIndex[pos] = s_tokenIndex[next];
+            pos               = next;
+        }
+    }
+
+    s_tokenIndex[pos] = AIS_ALERT_NO_SLOT;
+}
+
+/*!
+ * @brief Adds a slot holding an alert to the scheduling structures
+ */
+static void ais_alert_index_slot(uint16_t slot)
+{
+    ais_alert_t *alert = &s_aisAlerts[slot];
+
+    s_slotFlags[slot] |= ALERT_SLOT_FLAG_INUSE;
+    s_aisAlertCount++;
+    ais_alert_token_add(slot);
+
+    if (alert->valid)
+    {
+        ais_alert_heap_insert(&s_expiryHeap, slot);
+
+        /* Any alert before this date is guaranteed to be invalid, never trigger it */
+        if (alert->idle && (AIS_ALERT_EPOCH_DAY_ZERO < alert->scheduledTime))
+        {
+            ais_alert_heap_insert(&s_dueHeap, slot);
+        }
+    }
+    else
+    {
+        s_slotFlags[slot] |= ALERT_SLOT_FLAG_DELETED;
+        s_deletedSlots[s_deletedCount++] = slot;
+    }
+}
+
+/*!
+ * @brief Marks an alert for delete, it is removed later by the alert task
+ */
+static void ais_alert_invalidate_slot(uint16_t slot)
+{
+    s_aisAlerts[slot].valid = false;
+
+    ais_alert_heap_remove(&s_expiryHeap, slot);
+    ais_alert_heap_remove(&s_dueHeap, slot);
+
+    if (!(s_slotFlags[slot] & ALERT_SLOT_FLAG_DELETED))
+    {
+        s_slotFlags[slot] |= ALERT_SLOT_FLAG_DELETED;
+        s_deletedSlots[s_deletedCount++] = slot;
+    }
+}
+
+/*!
+ * @brief Frees a slot; the caller takes it out of s_deletedSlots
+ */
+static void ais_alert_free_slot(uint16_t slot)
+{
+    ais_alert_heap_remove(&s_expiryHeap, slot);
+    ais_alert_heap_remove(&s_dueHeap, slot);
+    ais_alert_token_remove(slot);
+
+    // Set slot back to all ones to match erased flash state
+    memset(&s_aisAlerts[slot], 0xFF, sizeof(ais_alert_t));
+
+    s_slotFlags[slot]          = 0U;
+    s_freeSlots[s_freeCount++] = slot;
+
+    if (s_aisAlertCount != 0)
+    {
+        s_aisAlertCount--;
+    }
+}
+
+static bool ais_alert_slot_in_use(uint32_t index)
+{
+    return (AIS_APP_MAX_ALERT_COUNT > index) && (s_slotFlags[index] & ALERT_SLOT_FLAG_INUSE);
+}
+
+static uint32_t ais_alert_record_put(uint8_t *buf, alert_record_op_t op, uint16_t slot)
+{
+    ais_alert_record_hdr_t *record = (ais_alert_record_hdr_t *)buf;
+    uint32_t len                   = AIS_ALERT_RECORD_HDR_SIZE;
+
+    record->op       = op;
+    record->reserved = 0xFF;
+    record->slot     = slot;
+
+    if (ALERT_RECORD_ADD == op)
+    {
+        memset(buf + AIS_ALERT_RECORD_HDR_SIZE, 0xFF, AIS_ALERT_RECORD_ADD_SIZE - AIS_ALERT_RECORD_HDR_SIZE);
+        memcpy(buf + AIS_ALERT_RECORD_HDR_SIZE, &s_aisAlerts[slot], sizeof(ais_alert_t));
+        len = AIS_ALERT_RECORD_ADD_SIZE;
+    }
+
+    return len;
+}
+
+/*!
+ * @brief Replays the journal records into the RAM copy of the alerts
+ */
+static void ais_alert_journal_replay(const uint8_t *file, uint32_t fileSize)
+{
+    uint32_t offset                      = sizeof(ais_alert_journal_hdr_t);
+    const ais_alert_record_hdr_t *record = NULL;
+
+    while ((offset + AIS_ALERT_RECORD_HDR_SIZE) <= fileSize)
+    {
+        record = (const ais_alert_record_hdr_t *)(file + offset);
+
+        if ((ALERT_RECORD_ADD == record->op) && ((offset + AIS_ALERT_RECORD_ADD_SIZE) > fileSize))
+        {
+            break;
+        }
+
+        // Slots beyond the current alert count are dropped
+        if (AIS_APP_MAX_ALERT_COUNT > record->slot)
+        {
+            switch (record->op)
             {
-                memset(flashFile, 0x00, fileSize);
+                case ALERT_RECORD_ADD:
+                    memcpy(&s_aisAlerts[record->slot], file + offset + AIS_ALERT_RECORD_HDR_SIZE, sizeof(ais_alert_t));
+                    break;
+                case ALERT_RECORD_TRIGGER:
+                    s_aisAlerts[record->slot].idle = false;
+                    break;
+                case ALERT_RECORD_DELETE:
+                    s_aisAlerts[record->slot].valid = false;
+                    break;
+                case ALERT_RECORD_REMOVE:
+                    memset(&s_aisAlerts[record->slot], 0xFF, sizeof(ais_alert_t));
+                    break;
+                default:
+                    break;
             }
-            vPortFree(flashFile);
-            flashFile = NULL;
-            xSemaphoreGive(s_aisAlertLock);
         }
+
+        if (ALERT_RECORD_ADD == record->op)
+        {
+            offset += AIS_ALERT_RECORD_ADD_SIZE;
+        }
+        else if ((ALERT_RECORD_TRIGGER == record->op) || (ALERT_RECORD_DELETE == record->op) ||
+                 (ALERT_RECORD_REMOVE == record->op))
+        {
+            offset += AIS_ALERT_RECORD_HDR_SIZE;
+        }
+        else
+        {
+            // End of the journal, or a record that never completed
+            break;
+        }
+    }
+
+    s_journalUsed = offset;
+}
+
+/*!
+ * @brief Saves a new copy of the journal holding one add record per alert
+ */
+static int32_t ais_alert_journal_compact(void)
+{
+    int32_t ret                  = 0;
+    uint32_t offset              = sizeof(ais_alert_journal_hdr_t);
+    ais_alert_journal_hdr_t *hdr = NULL;
+
+    uint8_t *flashFile = (uint8_t *)pvPortMalloc(AIS_ALERT_JOURNAL_SIZE);
+
+    if (NULL == flashFile)
+    {
+        return -10;
+    }
+
+    // Erased flash state, records are appended here later
+    memset(flashFile, 0xFF, AIS_ALERT_JOURNAL_SIZE);
+
+    hdr            = (ais_alert_journal_hdr_t *)flashFile;
+    hdr->magic     = AIS_ALERT_JOURNAL_MAGIC;
+    hdr->version   = AIS_ALERT_JOURNAL_VERSION;
+    hdr->slotCount = AIS_APP_MAX_ALERT_COUNT;
+
+    for (uint16_t slot = 0; slot < AIS_APP_MAX_ALERT_COUNT; slot++)
+    {
+        if (s_slotFlags[slot] & ALERT_SLOT_FLAG_INUSE)
+        {
+            offset += ais_alert_record_put(flashFile + offset, ALERT_RECORD_ADD, slot);
+        }
+    }
+
+    ret = SLN_FLASH_MGMT_Save(AIS_ALERT_FILE_NAME, flashFile, AIS_ALERT_JOURNAL_SIZE);
+
+    if ((SLN_FLASH_MGMT_EOVERFLOW == ret) || (SLN_FLASH_MGMT_EOVERFLOW2 == ret))
+    {
+        SLN_FLASH_MGMT_Erase(AIS_ALERT_FILE_NAME);
+        ret = SLN_FLASH_MGMT_Save(AIS_ALERT_FILE_NAME, flashFile, AIS_ALERT_JOURNAL_SIZE);
+    }
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_journalUsed = offset;
+        s_alertStats.journalWrites++;
+        s_alertStats.compactions++;
+
+        // Every alert is in the new copy
+        for (uint32_t idx = 0; idx < s_unsavedCount; idx++)
+        {
+            s_slotFlags[s_unsavedSlots[idx]] &= ~ALERT_SLOT_FLAG_UNSAVED;
+        }
+        s_unsavedCount = 0U;
+    }
+    else
+    {
+        ret = -11;
     }
 
+    memset(flashFile, 0x00, AIS_ALERT_JOURNAL_SIZE);
+    vPortFree(flashFile);
+
     return ret;
 }
 
-int32_t ais_alert_delete(uint32_t index)
+/*!
+ * @brief Appends records to the journal; compacts it when they don't fit
+ *
+ * Only the records are programmed, in the erased tail of the file. The RAM copy must already hold the changes, a
+ * compaction saves the RAM copy instead of the records.
+ */
+static int32_t ais_alert_journal_append(const uint8_t *records, uint32_t len)
+{
+    int32_t ret = 0;
+
+    if ((0U == s_journalUsed) || ((s_journalUsed + len) > AIS_ALERT_JOURNAL_SIZE))
+    {
+        return ais_alert_journal_compact();
+    }
+
+    ret = SLN_FLASH_MGMT_Program(AIS_ALERT_FILE_NAME, s_journalUsed, records, len);
+
+    if (SLN_FLASH_MGMT_OK == ret)
+    {
+        s_journalUsed += len;
+        s_alertStats.journalWrites++;
+    }
+    else
+    {
+        // Journal is gone, was not written by this build or the program failed; start a new one
+        ret = ais_alert_journal_compact();
+    }
+
+    return ret;
+}
+
+static int32_t ais_alert_journal_append_one(alert_record_op_t op, uint16_t slot)
+{
+    uint8_t record[AIS_ALERT_RECORD_HDR_SIZE];
+
+    // Nothing to log for an alert that was never written; its add record holds its state
+    if (s_slotFlags[slot] & ALERT_SLOT_FLAG_UNSAVED)
+    {
+        return 0;
+    }
+
+    return ais_alert_journal_append(record, ais_alert_record_put(record, op, slot));
+}
+
+/*!
+ * @brief Loads an alerts file written before the journal; an array of ais_alert_t
+ */
+static void ais_alert_load_legacy_file(const uint8_t *file, uint32_t fileSize)
+{
+    uint32_t count = fileSize / sizeof(ais_alert_t);
+
+    count = (count > AIS_APP_MAX_ALERT_COUNT) ? AIS_APP_MAX_ALERT_COUNT : count;
+
+    for (uint32_t idx = 0; idx < count; idx++)
+    {
+        memcpy(&s_aisAlerts[idx], file + (idx * sizeof(ais_alert_t)), sizeof(ais_alert_t));
+    }
+}
+
+int32_t ais_alert_store_alerts_to_nvm(void)
 {
     int32_t ret = -1;
 
-    if (AIS_APP_MAX_ALERT_COUNT > index)
+    if (NULL != s_aisAlertLock)
     {
-        if (NULL != s_aisAlertLock)
+        if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
         {
-            if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
+            uint32_t len    = 0;
+            uint8_t *record = NULL;
+
+            ret = 0;
+
+            if (0U < s_unsavedCount)
             {
-                uint32_t fileSize = sizeof(s_aisAlerts);
+                // Allocate ram space for all the new add records
+                record = (uint8_t *)pvPortMalloc(s_unsavedCount * AIS_ALERT_RECORD_ADD_SIZE);
 
-                // Allocate ram space for current file
-                ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
+                if (NULL == record)
+                {
+                    ret = -3;
+                }
+            }
 
-                if (NULL == flashFile)
+            if ((0 == ret) && (NULL != record))
+            {
+                for (uint32_t idx = 0; idx < s_unsavedCount; idx++)
                 {
-                    ret = -2;
-                    goto exit;
+                    len += ais_alert_record_put(record + len, ALERT_RECORD_ADD, s_unsavedSlots[idx]);
                 }
 
-                // Read current file into temporary file buffer
-                ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+                ret = ais_alert_journal_append(record, len);
 
-                /* Due to the CRC implementation, CRC will always fail */
-                if ((0 != ret) && (SLN_FLASH_MGMT_EENCRYPT2 == ret))
+                if (0 == ret)
                 {
-                    ret = -3;
-                    goto exit;
+                    for (uint32_t idx = 0; idx < s_unsavedCount; idx++)
+                    {
+                        s_slotFlags[s_unsavedSlots[idx]] &= ~ALERT_SLOT_FLAG_UNSAVED;
+                    }
+                    s_unsavedCount = 0U;
                 }
+            }
+
+            vPortFree(record);
+            xSemaphoreGive(s_aisAlertLock);
+        }
+    }
 
-                // Clear all bits in Flash to invalidate the entry in this file space
-                memset(&flashFile[index], 0x00, sizeof(ais_alert_t));
+    return ret;
+}
 
-                // Over write flash file
-                ret = SLN_FLASH_MGMT_Update(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+int32_t ais_alert_delete(void)
+{
+    int32_t ret = -1;
 
-                if (0 != ret)
+    if (NULL != s_aisAlertLock)
+    {
+        if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
+        {
+            uint32_t len    = 0;
+            uint8_t *record = NULL;
+            uint16_t slot   = 0;
+
+            ret = 0;
+
+            if (0U < s_deletedCount)
+            {
+                record = (uint8_t *)pvPortMalloc(s_deletedCount * AIS_ALERT_RECORD_HDR_SIZE);
+
+                if (NULL == record)
                 {
-                    ret = -4;
-                    goto exit;
+                    ret = -2;
                 }
+            }
 
-                // Update RAM copy
-                ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)s_aisAlerts, &fileSize);
-
-                /* Due to the CRC implementation, CRC will always fail */
-                if ((0 != ret) && (SLN_FLASH_MGMT_EENCRYPT2 == ret))
+            if ((0 == ret) && (NULL != record))
+            {
+                for (uint32_t idx = 0; idx < s_deletedCount; idx++)
                 {
-                    ret = -5;
-                    goto exit;
+                    slot = s_deletedSlots[idx];
+
+                    if (!(s_slotFlags[slot] & ALERT_SLOT_FLAG_UNSAVED))
+                    {
+                        len += ais_alert_record_put(record + len, ALERT_RECORD_REMOVE, slot);
+                    }
+
+                    ais_alert_free_slot(slot);
+                    configPRINTF(("Successfully deleted the alert %d !\r\n", slot));
                 }
 
-                // Update count
-                if (s_aisAlertCount != 0)
+                s_deletedCount = 0U;
+
+                // Drop the freed slots that never made it to the journal
+                for (uint32_t idx = 0; idx < s_unsavedCount;)
                 {
-                    s_aisAlertCount--;
+                    if (s_slotFlags[s_unsavedSlots[idx]] & ALERT_SLOT_FLAG_UNSAVED)
+                    {
+                        idx++;
+                    }
+                    else
+                    {
+                        s_unsavedSlots[idx] = s_unsavedSlots[--s_unsavedCount];
+                    }
                 }
 
-            exit:
-                if (NULL != flashFile)
+                if (0U < len)
                 {
-                    memset(flashFile, 0x00, fileSize);
+                    ret = ais_alert_journal_append(record, len);
                 }
-                vPortFree(flashFile);
-                flashFile = NULL;
-                xSemaphoreGive(s_aisAlertLock);
             }
+
+            vPortFree(record);
+            xSemaphoreGive(s_aisAlertLock);
         }
     }
 
@@ -329,26 +791,11 @@ void ais_alert_task(void *pvParameters)
 
         if (kAlertDelete == (taskNotification & 0xFFFF))
         {
-            for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-            {
-                alert_slot_state_t ramSlotState = ais_alert_get_flash_slot_state(&s_aisAlerts[idx]);
+            status = ais_alert_delete();
 
-                if (ALERT_SLOT_STATE_INUSE == ramSlotState)
-                {
-                    if (false == s_aisAlerts[idx].valid)
-                    {
-                        status = ais_alert_delete(idx);
-
-                        if (0 != status)
-                        {
-                            configPRINTF(("Error deleting alerts: %d!\r\n", status));
-                        }
-                        else
-                        {
-                            configPRINTF(("Successfully deleted the alert %d !\r\n", idx));
-                        }
-                    }
-                }
+            if (0 != status)
+            {
+                configPRINTF(("Error deleting alerts: %d!\r\n", status));
             }
         }
         taskNotification = 0;
@@ -357,29 +804,42 @@ void ais_alert_task(void *pvParameters)
 
 int32_t AIS_Alerts_Init(void)
 {
-    int32_t ret = -1;
+    int32_t ret                  = -1;
+    uint32_t fileSize            = 0;
+    uint8_t *flashFile           = NULL;
+    ais_alert_journal_hdr_t *hdr = NULL;
+    bool isLegacy                = false;
 
     // Set default state to all ones to match erased flash state
     memset(&s_aisAlerts[0], 0xFF, AIS_APP_MAX_ALERT_COUNT * sizeof(ais_alert_t));
+    memset(s_slotFlags, 0x00, sizeof(s_slotFlags));
+    memset(s_tokenIndex, 0xFF, sizeof(s_tokenIndex));
+    ais_alert_heap_init(&s_expiryHeap);
+    ais_alert_heap_init(&s_dueHeap);
+    s_aisAlertCount = 0U;
+    s_freeCount     = 0U;
+    s_unsavedCount  = 0U;
+    s_deletedCount  = 0U;
+    s_journalUsed   = 0U;
 
     // Check for existing file
-    uint32_t fileSize = sizeof(s_aisAlerts);
+    ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, NULL, &fileSize);
 
-    // Allocate ram space for current file
-    ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
+    if ((SLN_FLASH_MGMT_OK == ret) && (0U < fileSize))
+    {
+        // Allocate ram space for current file
+        flashFile = (uint8_t *)pvPortMalloc(fileSize);
 
-    /* Memset to 0 just in case the memory block was previously used. Best practice */
-    memset(flashFile, 0, fileSize);
+        if (NULL == flashFile)
+        {
+            ret = -2;
+            goto exit;
+        }
 
-    if (NULL == flashFile)
-    {
-        ret = -2;
-        goto exit;
+        // Read current file into temporary file buffer
+        ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, flashFile, &fileSize);
     }
 
-    // Read current file into temporary file buffer
-    ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
-
     /* Due to the CRC implementation, CRC will always fail */
     if ((0 != ret) && (SLN_FLASH_MGMT_ENOENTRY2 != ret) && (SLN_FLASH_MGMT_EENCRYPT2 != ret))
     {
@@ -388,32 +848,48 @@ int32_t AIS_Alerts_Init(void)
     }
 
     /* If this is the first time, then don't check for alerts */
-    if (SLN_FLASH_MGMT_ENOENTRY2 != ret)
+    if ((NULL != flashFile) && (sizeof(ais_alert_journal_hdr_t) <= fileSize))
     {
-        volatile bool isFileDeleted = (safe_strlen((char *)flashFile, fileSize)) ?
-                                          false :
-                                          true; // Protecting from optimization for debug purposes
+        hdr = (ais_alert_journal_hdr_t *)flashFile;
 
-        if (!isFileDeleted)
+        if ((AIS_ALERT_JOURNAL_MAGIC == hdr->magic) && (AIS_ALERT_JOURNAL_VERSION == hdr->version))
         {
-            // Update Count
-            for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-            {
-                volatile size_t tokenLen = safe_strlen(flashFile[idx].token, AIS_MAX_ALERT_TOKEN_LEN_BYTES);
-                volatile bool isEmpty    = (AIS_MAX_ALERT_TOKEN_LEN_BYTES == tokenLen) || (0 == tokenLen);
+            ais_alert_journal_replay(flashFile, fileSize);
 
-                if (!isEmpty && s_aisAlerts[idx].valid)
-                {
-                    s_aisAlertCount++;
-                    configPRINTF(("Found alert index %d in flash !\r\n", idx));
-                }
+            // A journal sized for a different alert count is rewritten at the next change
+            if (AIS_ALERT_JOURNAL_SIZE != fileSize)
+            {
+                s_journalUsed = 0U;
             }
+        }
+        else if (0 == (fileSize % sizeof(ais_alert_t)))
+        {
+            ais_alert_load_legacy_file(flashFile, fileSize);
+            isLegacy = true;
+        }
+    }
 
-            // Copy contents into static copy
-            memcpy(s_aisAlerts, flashFile, fileSize);
+    // Build the free list and the schedule from the loaded alerts
+    for (int32_t idx = AIS_APP_MAX_ALERT_COUNT - 1; idx >= 0; idx--)
+    {
+        if (ALERT_SLOT_STATE_INUSE == ais_alert_get_flash_slot_state(&s_aisAlerts[idx]))
+        {
+            ais_alert_index_slot(idx);
+            configPRINTF(("Found alert index %d in flash !\r\n", idx));
+        }
+        else
+        {
+            memset(&s_aisAlerts[idx], 0xFF, sizeof(ais_alert_t));
+            s_freeSlots[s_freeCount++] = idx;
         }
     }
 
+    if (isLegacy)
+    {
+        // Move the alerts to the journal format
+        ais_alert_journal_compact();
+    }
+
     // Reset ret back to zero
     ret = 0;
 
@@ -494,26 +970,22 @@ int32_t AIS_Alerts_UpdateState(uint64_t epoch)
     {
         if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
         {
-            bool isDeletePending = false;
-            ret                  = 0;
+            int32_t slot = -1;
+            ret          = 0;
 
-            // Find the open slot and copy alert data
-            for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
+            // Only the alerts that expired are visited, earliest first
+            while (0 <= (slot = ais_alert_heap_top(&s_expiryHeap)))
             {
-                volatile size_t tokenLen = safe_strlen(s_aisAlerts[idx].token, AIS_MAX_ALERT_TOKEN_LEN_BYTES);
-                volatile bool isEmpty    = (AIS_MAX_ALERT_TOKEN_LEN_BYTES == tokenLen) || (0 == tokenLen);
-                if (!isEmpty)
+                if (epoch <= s_aisAlerts[slot].scheduledTime)
                 {
-                    if (epoch > AIS_Alerts_GetScheduledTime(idx))
-                    {
-                        // Update static copy
-                        s_aisAlerts[idx].valid = 0;
-                        isDeletePending        = true;
-                    }
+                    break;
                 }
+
+                // Update static copy
+                ais_alert_invalidate_slot(slot);
             }
 
-            if (isDeletePending)
+            if (0U < s_deletedCount)
             {
                 ret = 1;
             }
@@ -546,26 +1018,19 @@ int32_t AIS_Alerts_SaveAlert(ais_alert_t *alert)
                 {
                     ret = -3;
 
-                    if (AIS_APP_MAX_ALERT_COUNT >= s_aisAlertCount)
+                    if (0U < s_freeCount)
                     {
-                        // Find the open slot and copy alert data
-                        for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-                        {
-                            alert_slot_state_t ramSlotState = ais_alert_get_flash_slot_state(&s_aisAlerts[idx]);
-
-                            if (ALERT_SLOT_STATE_INUSE != ramSlotState)
-                            {
-                                // Save Alert to RAM
-                                memcpy(&(s_aisAlerts[idx]), alert, sizeof(ais_alert_t));
+                        uint16_t slot = s_freeSlots[--s_freeCount];
 
-                                // Increment Total Alert Count
-                                s_aisAlertCount++;
+                        // Save Alert to RAM
+                        memcpy(&(s_aisAlerts[slot]), alert, sizeof(ais_alert_t));
 
-                                ret = 0;
+                        // Schedule it, the alert task writes it to flash
+                        ais_alert_index_slot(slot);
+                        s_slotFlags[slot] |= ALERT_SLOT_FLAG_UNSAVED;
+                        s_unsavedSlots[s_unsavedCount++] = slot;
 
-                                break;
-                            }
-                        }
+                        ret = 0;
                     }
                 }
                 else
@@ -590,64 +1055,23 @@ int32_t AIS_Alerts_MarkForDelete(const char *token, size_t len)
     {
         if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
         {
-            uint32_t idx = 0;
-            ret          = -2;
-
-            // Find a matching token
-            for (idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-            {
-                if (0 == memcmp(token, s_aisAlerts[idx].token, len))
-                {
-                    s_aisAlerts[idx].valid = false;
-                    configPRINTF(("Marking for delete, alert token: %s\r\n", s_aisAlerts[idx].token));
-                    ret = 0;
-                    break;
-                }
-            }
+            int32_t idx = ais_alert_token_find(token, len);
 
             // Update flash file
-            if (0 == ret)
+            if (0 <= idx)
             {
-                uint32_t fileSize = sizeof(s_aisAlerts);
-
-                // Allocate ram space for current file
-                ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
-
-                if (NULL == flashFile)
-                {
-                    ret = -3;
-                    goto exit;
-                }
-
-                // Read current file into temporary file buffer
-                ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
-
-                /* Due to the CRC implementation, CRC will always fail */
-                if ((0 != ret) && (ret != SLN_FLASH_MGMT_EENCRYPT2))
-                {
-                    ret = -4;
-                    goto exit;
-                }
-
-                // Clear all bits in Flash to invalidate the entry in this file space
-                flashFile[idx].valid = 0;
-
-                // Over write flash file
-                ret = SLN_FLASH_MGMT_Update(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+                configPRINTF(("Marking for delete, alert token: %s\r\n", s_aisAlerts[idx].token));
+                ret = 0;
 
-                if (0 != ret)
+                if (s_aisAlerts[idx].valid)
                 {
-                    ret = -5;
-                    goto exit;
-                }
+                    ais_alert_invalidate_slot(idx);
 
-            exit:
-                if (NULL != flashFile)
-                {
-                    memset(flashFile, 0x00, fileSize);
+                    if (0 != ais_alert_journal_append_one(ALERT_RECORD_DELETE, idx))
+                    {
+                        ret = -5;
+                    }
                 }
-                vPortFree(flashFile);
-                flashFile = NULL;
             }
             else
             {
@@ -674,50 +1098,19 @@ int32_t AIS_Alerts_MarkForDeleteOffline(uint32_t index)
         {
             if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
             {
-                // Set ram copy to triggered
-                s_aisAlerts[index].valid = false;
-
-                // Update flash file
-                uint32_t fileSize = sizeof(s_aisAlerts);
-
-                // Allocate ram space for current file
-                ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
-
-                if (NULL == flashFile)
-                {
-                    ret = -3;
-                    goto exit;
-                }
-
-                // Read current file into temporary file buffer
-                ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
-
-                /* Due to the CRC implementation, CRC will always fail */
-                if ((0 != ret) && (ret != SLN_FLASH_MGMT_EENCRYPT2))
-                {
-                    ret = -4;
-                    goto exit;
-                }
-
-                // Clear all bits in Flash to invalidate the entry in this file space
-                flashFile[index].valid = 0;
-
-                // Over write flash file
-                ret = SLN_FLASH_MGMT_Update(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+                ret = 0;
 
-                if (0 != ret)
+                if (ais_alert_slot_in_use(index) && s_aisAlerts[index].valid)
                 {
-                    ret = -5;
-                    goto exit;
-                }
+                    // Set ram copy to deleted
+                    ais_alert_invalidate_slot(index);
 
-            exit:
-                if (NULL != flashFile)
-                {
-                    memset(flashFile, 0x00, fileSize);
+                    // Update flash file
+                    if (0 != ais_alert_journal_append_one(ALERT_RECORD_DELETE, index))
+                    {
+                        ret = -5;
+                    }
                 }
-                vPortFree(flashFile);
-                flashFile = NULL;
 
                 xSemaphoreGive(s_aisAlertLock);
             }
@@ -807,6 +1200,7 @@ int32_t AIS_Alerts_MarkAsTriggered(uint32_t index)
             {
                 ret                     = 0;
                 s_aisAlerts[index].idle = false;
+                ais_alert_heap_remove(&s_dueHeap, index);
                 xSemaphoreGive(s_aisAlertLock);
             }
         }
@@ -827,53 +1221,45 @@ int32_t AIS_Alerts_MarkAsTriggeredOffline(uint32_t index)
         {
             if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
             {
+                ret = 0;
+
                 // Set ram copy to triggered
                 s_aisAlerts[index].idle = false;
+                ais_alert_heap_remove(&s_dueHeap, index);
 
                 // Update flash file
-                uint32_t fileSize = sizeof(s_aisAlerts);
-
-                // Allocate ram space for current file
-                ais_alert_t *flashFile = (ais_alert_t *)pvPortMalloc(fileSize);
-
-                if (NULL == flashFile)
+                if (ais_alert_slot_in_use(index))
                 {
-                    ret = -3;
-                    goto exit;
-                }
-
-                // Read current file into temporary file buffer
-                ret = SLN_FLASH_MGMT_Read(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
-
-                /* Due to the CRC implementation, CRC will always fail */
-                if ((0 != ret) && (SLN_FLASH_MGMT_EENCRYPT2 == ret))
-                {
-                    ret = -4;
-                    goto exit;
+                    if (0 != ais_alert_journal_append_one(ALERT_RECORD_TRIGGER, index))
+                    {
+                        ret = -5;
+                    }
                 }
 
-                // Clear all bits in Flash to invalidate the entry in this file space
-                flashFile[index].idle = 0;
+                xSemaphoreGive(s_aisAlertLock);
+            }
+        }
+    }
 
-                // Over write flash file
-                ret = SLN_FLASH_MGMT_Update(AIS_ALERT_FILE_NAME, (uint8_t *)flashFile, &fileSize);
+    return ret;
+}
 
-                if (0 != ret)
-                {
-                    ret = -5;
-                    goto exit;
-                }
+int32_t AIS_Alerts_GetNextDue(uint64_t epoch)
+{
+    int32_t ret = -1;
 
-            exit:
-                if (NULL != flashFile)
-                {
-                    memset(flashFile, 0x00, fileSize);
-                }
-                vPortFree(flashFile);
-                flashFile = NULL;
+    if (NULL != s_aisAlertLock)
+    {
+        if (pdTRUE == xSemaphoreTake(s_aisAlertLock, portMAX_DELAY))
+        {
+            int32_t slot = ais_alert_heap_top(&s_dueHeap);
 
-                xSemaphoreGive(s_aisAlertLock);
+            if ((0 <= slot) && (s_aisAlerts[slot].scheduledTime < epoch))
+            {
+                ret = slot;
             }
+
+            xSemaphoreGive(s_aisAlertLock);
         }
     }
 
@@ -1002,15 +1388,14 @@ int32_t AIS_Alerts_GetAlertsList(alertTokenList_t *alertList, uint32_t *alertCou
 
 int32_t AIS_Alerts_GetDuplicate(const char *token, size_t len)
 {
-    int ret = -1;
+    return ais_alert_token_find(token, len);
+}
 
-    for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
+void AIS_Alerts_GetStats(ais_alert_stats_t *stats)
+{
+    if (NULL != stats)
     {
-        if (memcmp(token, s_aisAlerts[idx].token, len) == 0)
-        {
-            ret = idx;
-            break;
-        }
+        memcpy(stats, &s_alertStats, sizeof(ais_alert_stats_t));
+        stats->journalUsed = s_journalUsed;
     }
-    return ret;
 }
@@ -23,9 +23,15 @@
 
 #define AIS_ALERT_FILE_NAME "alerts.dat"
 
-#define AIS_APP_MAX_ALERT_COUNT (6U)
+#ifndef AIS_APP_MAX_ALERT_COUNT
+#define AIS_APP_MAX_ALERT_COUNT (200U)
+#endif
+
+/* Slots are tracked with 16 bit indices */
+#define AIS_ABS_MAX_ALERT_COUNT (256U)
 
-#define AIS_ABS_MAX_ALERT_COUNT (32U)
+/* Any alert scheduled before this date is guaranteed to be invalid; 11/26/2018 0:00:00 */
+#define AIS_ALERT_EPOCH_DAY_ZERO (3752179200ULL)
 
 #define OFFLINE_AUDIO_TIMER      (1U << 0U)
 #define OFFLINE_AUDIO_ALARM      (1U << 1U)
@@ -54,6 +60,15 @@ typedef struct _ais_alert
     bool valid : 1;
 } ais_alert_t;
 
+/*! @brief Alert persistence counters */
+typedef struct _ais_alert_stats
+{
+    uint32_t journalWrites; /* Flash writes of the alerts file, compactions included */
+    uint32_t compactions;   /* New copies of the alerts file */
+    uint32_t journalUsed;   /* Bytes of the alerts file in use */
+} ais_alert_stats_t;
+
+/* Too big for a task stack with the default alert count, allocate it */
 typedef char alertTokenList_t[AIS_APP_MAX_ALERT_COUNT][AIS_MAX_ALERT_TOKEN_LEN_BYTES];
 
 #if defined(__cplusplus)
@@ -181,6 +196,16 @@ int32_t AIS_Alerts_MarkAsTriggered(uint32_t index);
  */
 int32_t AIS_Alerts_MarkAsTriggeredOffline(uint32_t index);
 
+/*!
+ * @brief Get the earliest idle alert scheduled before epoch; pass it to AIS_Alerts_Trigger and
+ * AIS_Alerts_MarkAsTriggeredOffline to move on to the next one
+ *
+ * @param epoch Seconds since Jan 1, 1900
+ *
+ * @returns Numeric index in array of the due alert or -1 if none is due
+ */
+int32_t AIS_Alerts_GetNextDue(uint64_t epoch);
+
 /*!
  * @brief Get alert's scheduled time to trigger
  *
@@ -236,6 +261,13 @@ int32_t AIS_Alerts_GetAlertsList(alertTokenList_t *alertList, uint32_t *alertCou
  */
 int32_t AIS_Alerts_GetDuplicate(const char *token, size_t len);
 
+/*!
+ * @brief Get the alert persistence counters
+ *
+ * @param stats Reference to counters to fill
+ */
+void AIS_Alerts_GetStats(ais_alert_stats_t *stats);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -104,6 +104,9 @@ void AIS_AppCallback_ToggleController(ais_handle_t *handle, aia_smart_home_queue
 
 void AIS_AppCallback_RangeController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
 {
+    bool adjusted  = false;
+    uint32_t range = 0;
+
     /* Write code here to handle Range Controller */
 
     if (handle->smart_home.s_smartHomeLock != NULL)
@@ -123,8 +126,11 @@ void AIS_AppCallback_RangeController(ais_handle_t *handle, aia_smart_home_queue_
                 break;
 
             case AIS_SMART_HOME_RANGE_CONTROLLER_ADJUST_RANGE:
-                /* Handle the turn off command here */
+                /* Handle the adjust command here, the Response had the value before the adjustment */
                 configPRINTF(("[App Smart Home] - Adjust Range!\r\n"));
+                range = smart_home_msg->endpoint->rangeController->range +
+                        smart_home_msg->endpoint->rangeController->rangeDelta;
+                adjusted = true;
                 break;
 
             default:
@@ -133,6 +139,12 @@ void AIS_AppCallback_RangeController(ais_handle_t *handle, aia_smart_home_queue_
         }
 
         xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        /* State changed outside of the directive, sent in a ChangeReport */
+        if (adjusted)
+        {
+            AIA_AlexaSmartHomeRangeControllerSetState(handle, smart_home_msg->endpoint, range);
+        }
     }
     else
     {
@@ -141,6 +153,9 @@ void AIS_AppCallback_RangeController(ais_handle_t *handle, aia_smart_home_queue_
 }
 void AIS_AppCallback_ModeController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
 {
+    bool adjusted = false;
+    uint32_t mode = 0;
+
     /* Write code here to handle Mode Controller */
 
     if (handle->smart_home.s_smartHomeLock != NULL)
@@ -159,7 +174,10 @@ void AIS_AppCallback_ModeController(ais_handle_t *handle, aia_smart_home_queue_p
             case AIS_SMART_HOME_MODE_CONTROLLER_ADJUST:
                 configPRINTF(("[App Smart Home] - Mode Adjust!\r\n"));
 
-                /* Handle the turn off command here */
+                /* Handle the adjust command here, the Response had the mode before the adjustment */
+                mode = smart_home_msg->endpoint->modeController->mode +
+                       smart_home_msg->endpoint->modeController->modeDelta;
+                adjusted = true;
                 break;
 
             default:
@@ -168,6 +186,12 @@ void AIS_AppCallback_ModeController(ais_handle_t *handle, aia_smart_home_queue_p
         }
 
         xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        /* State changed outside of the directive, sent in a ChangeReport */
+        if (adjusted)
+        {
+            AIA_AlexaSmartHomeModeControllerSetState(handle, smart_home_msg->endpoint, mode);
+        }
     }
     else
     {
@@ -177,6 +201,9 @@ void AIS_AppCallback_ModeController(ais_handle_t *handle, aia_smart_home_queue_p
 
 void AIS_AppCallback_BrightnessController(ais_handle_t *handle, aia_smart_home_queue_payload_t *smart_home_msg)
 {
+    bool adjusted      = false;
+    int32_t brightness = 0;
+
     /* Write code here to handle Brightness Controller */
 
     if (handle->smart_home.s_smartHomeLock != NULL)
@@ -195,8 +222,12 @@ void AIS_AppCallback_BrightnessController(ais_handle_t *handle, aia_smart_home_q
                 break;
 
             case AIS_SMART_HOME_BRIGHTNESS_CONTROLLER_ADJUST:
-                /* Handle the turn off command here */
+                /* Handle the adjust command here, the Response had the brightness before the adjustment */
                 configPRINTF(("[App Smart Home] - Adjust Brightness!\r\n"));
+                brightness = (int32_t)smart_home_msg->endpoint->brightnessController->brightness +
+                             (int32_t)smart_home_msg->endpoint->brightnessController->brightnessDelta;
+                brightness = MAX(0, MIN(100, brightness));
+                adjusted   = true;
                 break;
 
             default:
@@ -205,6 +236,12 @@ void AIS_AppCallback_BrightnessController(ais_handle_t *handle, aia_smart_home_q
         }
 
         xSemaphoreGive(handle->smart_home.s_smartHomeLock);
+
+        /* State changed outside of the directive, sent in a ChangeReport */
+        if (adjusted)
+        {
+            AIA_AlexaSmartHomeBrightnessControllerSetState(handle, smart_home_msg->endpoint, (uint32_t)brightness);
+        }
     }
     else
     {
@@ -50,6 +50,27 @@
 #include "wiced_rtos.h"
 #include "bt_hall_gatt_helpers.h"
 
+/* ATT header of notifications, indications and write requests: opcode and handle */
+#define ATT_HEADER_SIZE 3
+
+/* Largest attribute value allowed by the ATT protocol, size of the prepared write queue */
+#define PREP_WRITE_BUFFER_SIZE 512
+
+/* Notifications are retried while the stack reports the link as congested */
+#define CONGESTED_RETRY_NUM 20
+#define CONGESTED_RETRY_DELAY_MS 5
+
+typedef struct
+{
+    uint16_t handle;
+    uint16_t offset;
+    uint16_t len;
+    wiced_bool_t error;
+    uint8_t data[PREP_WRITE_BUFFER_SIZE];
+} prep_write_queue_t;
+
+extern wiced_bt_cfg_settings_t wiced_bt_cfg_settings;
+
 static BTGattServerCallbacks_t xGattServerCb;
 static uint8_t ServerIf = 0;
 static uint16_t conn_id = 0;
@@ -57,6 +78,10 @@ static wiced_bool_t is_connected = WICED_FALSE;
 static uint32_t TransId = 0;
 static BTBdaddr_t BTAddr;
 static uint32_t ulGattServerIFhandle = 0;
+static uint16_t negotiated_mtu = GATT_DEF_BLE_MTU_SIZE;
+static wiced_bool_t indication_pending = WICED_FALSE;
+static wiced_bool_t indications_as_notifications = BT_HAL_GATT_NOTIFY_INDICATIONS;
+static prep_write_queue_t prep_write_queue;
 
 extern uint8_t ble_gatt_database[];
 
@@ -152,11 +177,143 @@ wiced_bool_t get_connection_state(void)
     return is_connected;
 }
 
+uint16_t get_negotiated_mtu(void)
+{
+    return negotiated_mtu;
+}
+
+/* An indication takes a connection event for the value and one for the confirmation, a stream of
+ * them runs at half the rate of notifications. The ACS layer may trade the confirmation for the
+ * rate, its indications are then sent as notifications and reported sent right away.
+ */
+void set_indications_as_notifications(wiced_bool_t enable)
+{
+    indications_as_notifications = enable;
+}
+
+static void prep_write_queue_reset(void)
+{
+    prep_write_queue.handle = 0;
+    prep_write_queue.offset = 0;
+    prep_write_queue.len = 0;
+    prep_write_queue.error = WICED_FALSE;
+}
+
+/* Queue the chunks of a long write until the execute write request, the ACS layer gets the
+ * whole value in one write instead of one callback per chunk
+ */
+static wiced_bt_gatt_status_t prep_write_queue_add(wiced_bt_gatt_write_t *p_write)
+{
+    wiced_bt_gatt_status_t result = WICED_BT_GATT_SUCCESS;
+
+    if (prep_write_queue.len == 0)
+    {
+        prep_write_queue.handle = p_write->handle;
+        prep_write_queue.offset = p_write->offset;
+    }
+
+    /* Once a chunk is rejected the value is lost, none of the next chunks is queued until the
+     * execute write, even when the rejected chunk was the first one and the queue is still empty
+     */
+    if (prep_write_queue.error == WICED_TRUE)
+    {
+        result = WICED_BT_GATT_PREPARE_Q_FULL;
+    }
+    /* Only contiguous chunks of a single attribute are queued */
+    else if (prep_write_queue.handle != p_write->handle)
+    {
+        result = WICED_BT_GATT_PREPARE_Q_FULL;
+    }
+    else if (p_write->offset != (prep_write_queue.offset + prep_write_queue.len))
+    {
+        result = WICED_BT_GATT_INVALID_OFFSET;
+    }
+    else if ((prep_write_queue.len + p_write->val_len) > PREP_WRITE_BUFFER_SIZE)
+    {
+        result = WICED_BT_GATT_PREPARE_Q_FULL;
+    }
+
+    if (WICED_BT_GATT_SUCCESS == result)
+    {
+        memcpy(prep_write_queue.data + prep_write_queue.len, p_write->p_val, p_write->val_len);
+        prep_write_queue.len += p_write->val_len;
+    }
+    else
+    {
+        /* The client may still send the execute write, drop the whole queue then */
+        BT_LOGE("Prepared write 0x%x at %d rejected 0x%x\r\n", p_write->handle, p_write->offset, result);
+        prep_write_queue.error = WICED_TRUE;
+    }
+
+    return result;
+}
+
+static wiced_bt_gatt_status_t prep_write_queue_execute(uint16_t conn, wiced_bt_gatt_exec_flag_t exec_write)
+{
+    wiced_bt_gatt_status_t result = WICED_BT_GATT_SUCCESS;
+
+    if ((exec_write == GATT_PREP_WRITE_EXEC) && (prep_write_queue.error == WICED_TRUE))
+    {
+        result = WICED_BT_GATT_PREPARE_Q_FULL;
+    }
+    else if ((exec_write == GATT_PREP_WRITE_EXEC) && (prep_write_queue.len > 0))
+    {
+        if (xGattServerCb.pxRequestWriteCb != NULL)
+        {
+            BT_LOG_REQUEST("Execute write 0x%x, %d bytes\r\n", prep_write_queue.handle, prep_write_queue.len);
+
+            /* The execute write response is sent by the stack on return */
+            xGattServerCb.pxRequestWriteCb( conn,
+                                            TransId,
+                                            &BTAddr,
+                                            get_characteristic_handle(prep_write_queue.handle),
+                                            prep_write_queue.offset,
+                                            prep_write_queue.len,
+                                            false,
+                                            false,
+                                            prep_write_queue.data);
+        }
+    }
+    else if (xGattServerCb.pxRequestExecWriteCb != NULL)
+    {
+        xGattServerCb.pxRequestExecWriteCb(conn, TransId, &BTAddr, exec_write);
+    }
+
+    prep_write_queue_reset();
+
+    return result;
+}
+
+static void update_mtu(uint16_t conn, uint16_t mtu)
+{
+    negotiated_mtu = mtu;
+    BT_LOGI("MTU %d, %d bytes per notification\r\n", mtu, mtu - ATT_HEADER_SIZE);
+
+    if (xGattServerCb.pxMtuChangedCb != NULL)
+    {
+        xGattServerCb.pxMtuChangedCb(conn, mtu);
+    }
+}
+
+/* The confirmation of an indication completes it, the ACS layer only sends the next one then */
+static void indication_done(uint16_t conn, BTStatus_t xStatus)
+{
+    if (indication_pending == WICED_TRUE)
+    {
+        indication_pending = WICED_FALSE;
+
+        if (xGattServerCb.pxIndicationSentCb != NULL)
+        {
+            xGattServerCb.pxIndicationSentCb(conn, xStatus);
+        }
+    }
+}
+
 static wiced_bt_gatt_status_t gatt_server_request_handler(wiced_bt_gatt_attribute_request_t *p_data)
 {
     wiced_bt_gatt_status_t result = WICED_BT_GATT_INVALID_PDU;
 
-    BT_LOGI("gatt_server_request_handler. conn %d, type %d\r\n", p_data->conn_id, p_data->request_type);
+    BT_LOG_REQUEST("gatt_server_request_handler. conn %d, type %d\r\n", p_data->conn_id, p_data->request_type);
 
     switch (p_data->request_type)
     {
@@ -188,38 +345,20 @@ static wiced_bt_gatt_status_t gatt_server_request_handler(wiced_bt_gatt_attribut
             break;
 
         case GATTS_REQ_TYPE_PREP_WRITE:
-            if (xGattServerCb.pxRequestWriteCb != NULL)
-            {
-                xGattServerCb.pxRequestWriteCb( p_data->conn_id,
-                                                TransId,
-                                                &BTAddr,
-                                                get_characteristic_handle(p_data->data.write_req.handle),
-                                                p_data->data.write_req.offset,
-                                                p_data->data.write_req.val_len,
-                                                true,
-                                                p_data->data.write_req.is_prep,
-                                                p_data->data.write_req.p_val);
-                result = WICED_BT_GATT_SUCCESS;
-            }
+            result = prep_write_queue_add(&p_data->data.write_req);
             break;
 
         case GATTS_REQ_TYPE_WRITE_EXEC:
-            if (xGattServerCb.pxRequestExecWriteCb != NULL)
-            {
-                xGattServerCb.pxRequestExecWriteCb( p_data->conn_id, TransId, &BTAddr, p_data->data.exec_write);
-                result = WICED_BT_GATT_SUCCESS;
-            }
+            result = prep_write_queue_execute(p_data->conn_id, p_data->data.exec_write);
             break;
 
         case GATTS_REQ_TYPE_MTU:
-            if (xGattServerCb.pxMtuChangedCb != NULL)
-            {
-                xGattServerCb.pxMtuChangedCb(p_data->conn_id, p_data->data.mtu);
-                result = WICED_BT_GATT_SUCCESS;
-            }
+            update_mtu(p_data->conn_id, p_data->data.mtu);
+            result = WICED_BT_GATT_SUCCESS;
             break;
 
         case GATTS_REQ_TYPE_CONF:
+            indication_done(p_data->conn_id, eBTStatusSuccess);
             result =  WICED_BT_GATT_SUCCESS;
             break;
 
@@ -243,6 +382,8 @@ static wiced_bt_gatt_status_t gatts_callback(wiced_bt_gatt_evt_t event, wiced_bt
         case GATT_CONNECTION_STATUS_EVT:
             BT_LOGI("gatts_callback: GATT_CONNECTION_STATUS_EVT %d\r\n", p_status->connected);
             memcpy(BTAddr.ucAddress, p_status->bd_addr, btADDRESS_LEN);
+            negotiated_mtu = GATT_DEF_BLE_MTU_SIZE;
+            prep_write_queue_reset();
             if (p_status->connected)
             {
                 conn_id = p_status->conn_id;
@@ -250,6 +391,7 @@ static wiced_bt_gatt_status_t gatts_callback(wiced_bt_gatt_evt_t event, wiced_bt
             }
             else
             {
+                indication_done(p_status->conn_id, eBTStatusFail);
                 conn_id = 0;
                 is_connected = WICED_FALSE;
                 BT_LOGI("Disconnected ! Reason %d", p_status->reason);
@@ -260,6 +402,24 @@ static wiced_bt_gatt_status_t gatts_callback(wiced_bt_gatt_evt_t event, wiced_bt
                 xGattServerCb.pxConnectionCb(p_status->conn_id, ServerIf, p_status->connected, &BTAddr);
             }
 
+            /* Many phones never start the MTU exchange, ask for the largest MTU right away so the
+             * provisioning data does not go through 20 bytes payloads
+             */
+            if (p_status->connected)
+            {
+                prvConfigureMtu(ServerIf, wiced_bt_cfg_settings.gatt_cfg.max_mtu_size);
+            }
+
+            result = WICED_BT_GATT_SUCCESS;
+            break;
+
+        case GATT_OPERATION_CPLT_EVT:
+            /* Completion of the MTU exchange started on connection */
+            if ((p_data->operation_complete.op == GATTC_OPTYPE_CONFIG) &&
+                (p_data->operation_complete.status == WICED_BT_GATT_SUCCESS))
+            {
+                update_mtu(p_data->operation_complete.conn_id, p_data->operation_complete.response_data.mtu);
+            }
             result = WICED_BT_GATT_SUCCESS;
             break;
 
@@ -631,14 +791,38 @@ static BTStatus_t prvBTSendIndication( uint8_t ucServerIf,
 {
     BTStatus_t xStatus = eBTStatusSuccess;
     wiced_bt_gatt_status_t xWWDstatus = WICED_BT_GATT_SUCCESS;
+    uint16_t usValueHandle = get_value_handle(usAttributeHandle);
+    uint32_t ulRetry = 0;
 
-    if (bConfirm)
+    if (indications_as_notifications == WICED_TRUE)
     {
-        xWWDstatus = wiced_bt_gatt_send_indication(usConnId, get_value_handle(usAttributeHandle), xLen, pucValue);
+        bConfirm = false;
+    }
+
+    if (xLen > (size_t)(negotiated_mtu - ATT_HEADER_SIZE))
+    {
+        /* The stack would truncate the value silently */
+        BT_LOGE("Value of %d bytes does not fit the MTU %d\r\n", (int)xLen, negotiated_mtu);
+        xWWDstatus = WICED_BT_GATT_INVALID_ATTR_LEN;
+    }
+    else if (bConfirm)
+    {
+        indication_pending = WICED_TRUE;
+        xWWDstatus = wiced_bt_gatt_send_indication(usConnId, usValueHandle, xLen, pucValue);
     }
     else
     {
-        xWWDstatus = wiced_bt_gatt_send_notification(usConnId, get_value_handle(usAttributeHandle), xLen, pucValue);
+        /* Back-to-back notifications fill the controller buffers, wait for them to drain instead
+         * of failing the transfer
+         */
+        xWWDstatus = wiced_bt_gatt_send_notification(usConnId, usValueHandle, xLen, pucValue);
+        while (((xWWDstatus == WICED_BT_GATT_CONGESTED) || (xWWDstatus == WICED_BT_GATT_BUSY)) &&
+               (ulRetry < CONGESTED_RETRY_NUM) && (is_connected == WICED_TRUE))
+        {
+            wiced_rtos_delay_milliseconds(CONGESTED_RETRY_DELAY_MS);
+            xWWDstatus = wiced_bt_gatt_send_notification(usConnId, usValueHandle, xLen, pucValue);
+            ulRetry++;
+        }
     }
 
     if (xWWDstatus != WICED_BT_GATT_SUCCESS)
@@ -646,9 +830,15 @@ static BTStatus_t prvBTSendIndication( uint8_t ucServerIf,
         xStatus = eBTStatusFail;
     }
 
-    if (xGattServerCb.pxIndicationSentCb != NULL)
+    /* A sent indication is reported on the confirmation of the client, see indication_done */
+    if ((bConfirm == false) || (xStatus != eBTStatusSuccess))
     {
-        xGattServerCb.pxIndicationSentCb(usConnId, xStatus);
+        indication_pending = WICED_FALSE;
+
+        if (xGattServerCb.pxIndicationSentCb != NULL)
+        {
+            xGattServerCb.pxIndicationSentCb(usConnId, xStatus);
+        }
     }
 
     return xStatus;
@@ -19,6 +19,18 @@ __attribute__((section(".ocram_non_cacheable_bss"))) handle_value_database_t han
 static uint32_t database_size = 0;
 static uint8_t handle_cnt = 0;
 
+static inline wiced_bool_t is_value_handle(uint16_t handle)
+{
+    uint16_t index = handle - GENERATED_HANDLE_BASE;
+
+    if (index >= GENERATED_HANDLE_NUM)
+    {
+        return WICED_FALSE;
+    }
+
+    return ((handle_values.bitmap[index / 32] & (1U << (index % 32))) != 0) ? WICED_TRUE : WICED_FALSE;
+}
+
 static void generate_handle(uint16_t* handle, wiced_bool_t is_handle_value)
 {
     /* If the handle is not 0 we don't need to generate a new one, it has a static value */
@@ -27,22 +39,15 @@ static void generate_handle(uint16_t* handle, wiced_bool_t is_handle_value)
         /* Generate an unique handle starting from 0x0100
          * All the static values are smaller then 0x0100
          */
-        *handle = (uint16_t)(handle_cnt | 0x0100);
-        handle_cnt++;
+        *handle = (uint16_t)(handle_cnt | GENERATED_HANDLE_BASE);
 
         if (is_handle_value == WICED_TRUE)
         {
-            if (handle_values.size < HANDLE_VALUE_DATABASE_SIZE)
-            {
-                handle_values.data[handle_values.size] = *handle;
-                handle_values.size++;
-            }
-            else
-            {
-                /* It should never get here if the math is right */
-                BT_LOGE("Handle value database full\n\r");
-            }
+            handle_values.bitmap[handle_cnt / 32] |= 1U << (handle_cnt % 32);
+            handle_values.size++;
         }
+
+        handle_cnt++;
     }
 }
 
@@ -54,42 +59,27 @@ uint16_t get_characteristic_handle(uint16_t handle)
 {
     uint16_t characteristic_handle = handle;
 
-    /* Check is the handle is a value handle */
-    for (int i = 0; i < handle_values.size; i++)
+    /* The value handle is always characteristic_handle + 1 */
+    if (is_value_handle(handle) == WICED_TRUE)
     {
-        if (handle_values.data[i] == handle)
-        {
-            /* The value handle is always characteristic_handle + 1 */
-            characteristic_handle = handle - 1;
-        }
+        characteristic_handle = handle - 1;
     }
 
-    BT_LOGI("get_characteristic_handle: Receive 0x%x, sent 0x%x", handle, characteristic_handle);
+    BT_LOG_REQUEST("get_characteristic_handle: Receive 0x%x, sent 0x%x", handle, characteristic_handle);
     return characteristic_handle;
 }
 
 uint16_t get_value_handle(uint16_t handle)
 {
-    int16_t value_handle = handle + 1;
-    wiced_bool_t is_value_handle = WICED_FALSE;
-
-    /* Check is the handle + 1 is a value handle */
-    for (int i = 0; i < handle_values.size; i++)
-    {
-        if (handle_values.data[i] == value_handle)
-        {
-            is_value_handle = WICED_TRUE;
-            break;
-        }
-    }
+    uint16_t value_handle = handle;
 
-    /* If handle + 1 is a NOT value handle return the handle as it is */
-    if (is_value_handle == WICED_FALSE)
+    /* A characteristic handle is followed by its value handle, any other handle is returned as it is */
+    if (is_value_handle(handle + 1) == WICED_TRUE)
     {
-        value_handle = value_handle - 1;
+        value_handle = handle + 1;
     }
 
-    BT_LOGI("get_value_handle: Receive 0x%x, sent 0x%x", handle, value_handle);
+    BT_LOG_REQUEST("get_value_handle: Receive 0x%x, sent 0x%x", handle, value_handle);
     return value_handle;
 }
 
@@ -580,6 +570,7 @@ void init_gatt_database()
     database_size = 0;
     handle_cnt = 0;
     handle_values.size = 0;
+    memset(handle_values.bitmap, 0, sizeof(handle_values.bitmap));
 }
 
 uint8_t parse_permissions(BTCharPermissions_t permissions)
@@ -12,13 +12,39 @@
 
 #include "bt_hal_gatt_types.h"
 
+#ifndef BLE_GAT_DATABASE_MAX_SIZE
 #define BLE_GAT_DATABASE_MAX_SIZE 512
+#endif
 #define MAX_ATRIBUTE_SIZE 46
 #define UUID128SIZE 16
-#define HANDLE_VALUE_DATABASE_SIZE BLE_GAT_DATABASE_MAX_SIZE / MAX_ATRIBUTE_SIZE
+
+/* Generated handles are 0x0100 | handle_cnt, one bit per handle marks the value handles */
+#define GENERATED_HANDLE_BASE 0x0100
+#define GENERATED_HANDLE_NUM 256
+#define HANDLE_VALUE_BITMAP_WORDS (GENERATED_HANDLE_NUM / 32)
+
+/* Set to 1 to log every GATT request and handle translation, off by default as it sits on the
+ * provisioning data path
+ */
+#ifndef BT_HAL_GATT_REQUEST_LOG
+#define BT_HAL_GATT_REQUEST_LOG 0
+#endif
+
+#if BT_HAL_GATT_REQUEST_LOG
+#define BT_LOG_REQUEST(...) BT_LOGI(__VA_ARGS__)
+#else
+#define BT_LOG_REQUEST(...)
+#endif
+
+/* Set to 1 to send the indications of the ACS layer as notifications from boot, see
+ * set_indications_as_notifications
+ */
+#ifndef BT_HAL_GATT_NOTIFY_INDICATIONS
+#define BT_HAL_GATT_NOTIFY_INDICATIONS 0
+#endif
 
 typedef struct {
-    uint16_t data[HANDLE_VALUE_DATABASE_SIZE];
+    uint32_t bitmap[HANDLE_VALUE_BITMAP_WORDS];
     uint8_t size;
 }handle_value_database_t;
 
@@ -173,6 +199,8 @@ void init_gatt_database();
 uint8_t parse_permissions(BTCharPermissions_t permissions);
 uint32_t get_datebase_size();
 uint16_t get_connection_id();
+uint16_t get_negotiated_mtu(void);
+void set_indications_as_notifications(wiced_bool_t enable);
 wiced_bool_t get_connection_state(void);
 
 
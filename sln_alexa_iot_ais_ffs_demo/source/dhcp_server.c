@@ -45,6 +45,8 @@
 #include "lwip/sockets.h"  /* equivalent of <sys/socket.h> */
 #include <string.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "network/wwd_network_constants.h"
 #include "RTOS/wwd_rtos_interface.h"
 
@@ -57,6 +59,8 @@
 
 #include "wwd_logging.h"
 
+#include "dhcp_server.h"
+
 /******************************************************
  *                      Macros
  ******************************************************/
@@ -84,9 +88,37 @@
 #define IPPORT_DHCPS                   (67)
 #define IPPORT_DHCPC                   (68)
 
+/* DHCP options */
+#define DHCP_OPTION_PAD                 (0)
+#define DHCP_OPTION_REQUESTED_IP        (50)
+#define DHCP_OPTION_OVERLOAD            (52)
+#define DHCP_OPTION_MESSAGE_TYPE        (53)
+#define DHCP_OPTION_SERVER_ID           (54)
+#define DHCP_OPTION_END                 (255)
+
+/* Option overload values, RFC 2132 9.3 */
+#define DHCP_OVERLOAD_FILE              (1)
+#define DHCP_OVERLOAD_SNAME             (2)
+
+/* Offset and size of the 'sname' and 'file' fields in the legacy area */
+#define DHCP_SNAME_OFFSET               (0)
+#define DHCP_SNAME_LEN                  (64)
+#define DHCP_FILE_OFFSET                (64)
+#define DHCP_FILE_LEN                   (128)
+
 /* DHCP socket timeout value in milliseconds. Modify this to make thread exiting more responsive */
 #define DHCP_SOCKET_TIMEOUT     500
 
+/* Address pool: DHCP_SERVER_MAX_LEASES hosts of the server /24, starting at DHCP_POOL_FIRST_HOST */
+#define DHCP_POOL_FIRST_HOST            (100)
+
+/* Lease time given to the clients, must match lease_time_option_buff */
+#define DHCP_LEASE_TIME_SEC             (3600)
+
+/* How long an OFFERED address is kept for the client, and a DECLINED address kept out of the pool */
+#define DHCP_OFFER_HOLD_SEC             (30)
+#define DHCP_DECLINE_HOLD_SEC           (600)
+
 
 
 /******************************************************
@@ -125,25 +157,27 @@ typedef struct
 /******************************************************
  *               Static Function Declarations
  ******************************************************/
-static unsigned char * find_option( dhcp_header_t* request, unsigned char option_num );
+static unsigned char * find_option( dhcp_header_t* request, uint32_t request_len, unsigned char option_num );
 static void dhcp_thread( void * thread_input );
 
 /******************************************************
  *               Variable Definitions
  ******************************************************/
-static char             new_ip_addr[4]                = { 192, 168, 0, 0 };
-static uint16_t         next_available_ip_addr        = ( 1 << 8 ) + 100;
 static char             subnet_option_buff[]          = { 1, 4, 255, 255, 0, 0 };
 static char             server_ip_addr_option_buff[]  = { 54, 4, 192, 168, 1, 1 };
 static char             mtu_option_buff[]             = { 26, 2, WICED_PAYLOAD_MTU>>8, WICED_PAYLOAD_MTU&0xff };
 static char             dhcp_offer_option_buff[]      = { 53, 1, DHCPOFFER };
 static char             dhcp_ack_option_buff[]        = { 53, 1, DHCPACK };
 static char             dhcp_nak_option_buff[]        = { 53, 1, DHCPNAK };
-static char             lease_time_option_buff[]      = { 51, 4, 0x00, 0x01, 0x51, 0x80 }; /* 1 day lease */
+static char             lease_time_option_buff[]      = { 51, 4, 0x00, 0x00, 0x0E, 0x10 }; /* 1 hour lease */
 static char             dhcp_magic_cookie[]           = { 0x63, 0x82, 0x53, 0x63 };
 static volatile char    dhcp_quit_flag = 0;
 static TaskHandle_t     dhcp_thread_handle;
 static dhcp_header_t    dhcp_header_buff;
+static uint32_t         dhcp_header_len;
+
+/* One entry per pool address, the client is identified by its MAC */
+static dhcp_server_lease_t dhcp_leases[ DHCP_SERVER_MAX_LEASES ];
 
 /******************************************************
  *               Function Definitions
@@ -151,6 +185,16 @@ static dhcp_header_t    dhcp_header_buff;
 
 void start_dhcp_server( uint32_t local_addr )
 {
+    uint32_t i;
+
+    /* Leases are kept across AP restarts, the pool follows the server /24 */
+    memcpy( &server_ip_addr_option_buff[2], &local_addr, 4 );
+    for ( i = 0; i < DHCP_SERVER_MAX_LEASES; i++ )
+    {
+        memcpy( dhcp_leases[i].ip_addr, &local_addr, 3 );
+        dhcp_leases[i].ip_addr[3] = DHCP_POOL_FIRST_HOST + i;
+    }
+
     //xTaskCreate( dhcp_thread, "DHCP thread", DHCP_STACK_SIZE/sizeof( portSTACK_TYPE ), (void*)local_addr, DEFAULT_THREAD_PRIO, &dhcp_thread_handle);
     xTaskCreate( dhcp_thread, "DHCP thread", DHCP_STACK_SIZE/sizeof( portSTACK_TYPE ), (void*)local_addr, DEFAULT_THREAD_PRIO, &dhcp_thread_handle);
 }
@@ -160,27 +204,215 @@ void quit_dhcp_server( void )
     dhcp_quit_flag = 1;
 }
 
+static bool dhcp_lease_expired( const dhcp_server_lease_t* lease, TickType_t now )
+{
+    return ( lease->state != DHCP_LEASE_FREE ) && ( (int32_t) ( lease->expiry_tick - now ) <= 0 );
+}
+
+static void dhcp_lease_set( dhcp_server_lease_t* lease, const uint8_t* mac, uint8_t state, uint32_t hold_sec )
+{
+    /* The shell reads the table from another task */
+    taskENTER_CRITICAL( );
+    if ( mac != NULL )
+    {
+        memcpy( lease->mac, mac, sizeof( lease->mac ) );
+    }
+    else
+    {
+        memset( lease->mac, 0, sizeof( lease->mac ) );
+    }
+    lease->state       = state;
+    lease->expiry_tick = xTaskGetTickCount( ) + pdMS_TO_TICKS( hold_sec * 1000 );
+    taskEXIT_CRITICAL( );
+}
+
+static dhcp_server_lease_t* dhcp_lease_find_mac( const uint8_t* mac )
+{
+    uint32_t i;
+
+    for ( i = 0; i < DHCP_SERVER_MAX_LEASES; i++ )
+    {
+        if ( ( dhcp_leases[i].state != DHCP_LEASE_DECLINED ) && ( memcmp( dhcp_leases[i].mac, mac, 6 ) == 0 ) )
+        {
+            return &dhcp_leases[i];
+        }
+    }
+
+    return NULL;
+}
+
+static dhcp_server_lease_t* dhcp_lease_find_ip( const unsigned char* ip_addr )
+{
+    uint32_t i;
+
+    if ( ip_addr == NULL )
+    {
+        return NULL;
+    }
+
+    for ( i = 0; i < DHCP_SERVER_MAX_LEASES; i++ )
+    {
+        if ( memcmp( dhcp_leases[i].ip_addr, ip_addr, 4 ) == 0 )
+        {
+            return &dhcp_leases[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool dhcp_lease_available( const dhcp_server_lease_t* lease, const uint8_t* mac, TickType_t now )
+{
+    return ( lease->state == DHCP_LEASE_FREE ) || dhcp_lease_expired( lease, now ) ||
+           ( ( lease->state != DHCP_LEASE_DECLINED ) && ( memcmp( lease->mac, mac, 6 ) == 0 ) );
+}
+
+/**
+ *  Picks the address offered to a client, RFC 2131 4.3.1:
+ *  the client's current or previous address, else the address it asks for, else the free address
+ *  unused for the longest time
+ */
+static dhcp_server_lease_t* dhcp_lease_allocate( const uint8_t* mac, const unsigned char* requested_addr )
+{
+    TickType_t now = xTaskGetTickCount( );
+    dhcp_server_lease_t* lease;
+    dhcp_server_lease_t* oldest = NULL;
+    uint32_t i;
+
+    lease = dhcp_lease_find_mac( mac );
+    if ( lease != NULL )
+    {
+        return lease;
+    }
+
+    lease = dhcp_lease_find_ip( requested_addr );
+    if ( ( lease != NULL ) && dhcp_lease_available( lease, mac, now ) )
+    {
+        return lease;
+    }
+
+    for ( i = 0; i < DHCP_SERVER_MAX_LEASES; i++ )
+    {
+        lease = &dhcp_leases[i];
+        if ( ( lease->state == DHCP_LEASE_FREE ) || dhcp_lease_expired( lease, now ) )
+        {
+            if ( ( oldest == NULL ) || ( (int32_t) ( lease->expiry_tick - oldest->expiry_tick ) < 0 ) )
+            {
+                oldest = lease;
+            }
+        }
+    }
+
+    return oldest;
+}
+
 /**
- *  Implements a very simple DHCP server.
+ *  Turns the request held in dhcp_header_buff into a reply and broadcasts it
  *
- *  Server will always offer next available address to a DISCOVER command
- *  Server will NAK any REQUEST command which is not requesting the next available address
- *  Server will ACK any REQUEST command which is for the next available address, and then increment the next available address
+ * @param conn :         DHCP server connection
+ * @param type_option :  DHCP message type option to send
+ * @param lease :        Address given to the client, NULL for a NAK
+ */
+static void dhcp_send_reply( struct netconn* conn, const char* type_option, const dhcp_server_lease_t* lease )
+{
+    dhcp_header_t* dhcp_header_ptr = &dhcp_header_buff;
+    ip_addr_t      dst_ip          = IPADDR4_INIT(0xffffffff);
+    char*          option_ptr;
+    struct netbuf* buf;
+    char*          mem;
+    int            slen;
+    err_t          err;
+
+    dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
+
+    /* Clear the DHCP options list, and 'sname' / 'file' which may carry the overloaded client options */
+    memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
+    memset( &dhcp_header_ptr->legacy, 0, sizeof( dhcp_header_ptr->legacy ) );
+
+    if ( lease != NULL )
+    {
+        memcpy( &dhcp_header_ptr->your_ip_addr, lease->ip_addr, 4 );
+    }
+    else
+    {
+        memset( &dhcp_header_ptr->your_ip_addr, 0, sizeof( dhcp_header_ptr->your_ip_addr ) ); /* Clear 'your address' field */
+    }
+
+    /* Copy the magic DHCP number */
+    memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
+
+    /* Add options */
+    option_ptr = (char *) &dhcp_header_ptr->options;
+    memcpy( option_ptr, type_option, 3 );                  /* DHCP message type */
+    option_ptr += 3;
+    memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Server identifier */
+    option_ptr += 6;
+    if ( lease != NULL )
+    {
+        memcpy( option_ptr, lease_time_option_buff, 6 );       /* Lease Time */
+        option_ptr += 6;
+        memcpy( option_ptr, subnet_option_buff, 6 );           /* Subnet Mask */
+        option_ptr += 6;
+        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Router (gateway) */
+        option_ptr[0] = 3; /* Router id */
+        option_ptr += 6;
+        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* DNS server */
+        option_ptr[0] = 6; /* DNS server id */
+        option_ptr += 6;
+        memcpy( option_ptr, mtu_option_buff, 4 );              /* Interface MTU */
+        option_ptr += 4;
+    }
+    option_ptr[0] = 0xff; /* end options */
+    option_ptr++;
+
+    /* Send packet */
+    slen = (option_ptr - (char*)&dhcp_header_buff);
+    buf = netbuf_new();
+    if ( buf == NULL )
+    {
+        WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
+        return;
+    }
+    mem = (char *)netbuf_alloc(buf, slen);
+    if(mem == NULL)
+    {
+        WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
+    }
+    else
+    {
+        memcpy(mem, dhcp_header_ptr, slen);
+        err = netconn_sendto(conn, buf,&dst_ip, IPPORT_DHCPC );
+        if( err != ERR_OK )
+        {
+            WWD_LOG(("dhcp srv: sending is failed\r\n"));
+        }
+    }
+    netbuf_delete(buf);
+}
+
+/**
+ *  Implements a small DHCP server with a lease table.
+ *
+ *  Server offers the client its current lease, the address it asks for when free, or the free address
+ *  unused for the longest time.
+ *  Server ACKs a REQUEST for the address leased or offered to the client (or free, for a client rebooting)
+ *  and NAKs any other one.
+ *  RELEASE frees the lease, DECLINE keeps the address out of the pool for DHCP_DECLINE_HOLD_SEC.
  *
  * @param my_addr : local IP address for binding of server port.
  */
 
 static void dhcp_thread( void * thread_input )
 {
-    char*                 option_ptr;
     static dhcp_header_t* dhcp_header_ptr = &dhcp_header_buff;
     struct netconn *conn;
     struct netbuf *buf;
     err_t err;
-    int   slen;
-    char  *mem;
-    //uint16_t rxlen;
-    ip_addr_t dst_ip = IPADDR4_INIT(0xffffffff);
+    unsigned char* message_type;
+    unsigned char* requested_address;
+    unsigned char* server_id;
+    dhcp_server_lease_t* lease;
+    uint8_t mac[6];
 
     WWD_LOG(("DHCP server start\n"));
     conn = netconn_new(NETCONN_UDP);
@@ -217,166 +449,120 @@ static void dhcp_thread( void * thread_input )
         {
             /*  no need netconn_connect here, since the netbuf contains the address */
             WWD_LOG(("Rx Packet\r\n"));
-            netbuf_copy(buf,(char *) dhcp_header_ptr, sizeof(dhcp_header_buff));
+            memset( dhcp_header_ptr, 0, sizeof( dhcp_header_buff ) );
+            dhcp_header_len = netbuf_copy(buf,(char *) dhcp_header_ptr, sizeof(dhcp_header_buff));
             netbuf_delete(buf);
-            //netbuf_data(buf, &dhcp_header_ptr, &rxlen);
-            //WWD_LOG(("rxlen: %d\n", rxlen));
 
-            switch ( dhcp_header_ptr->options[2] )
+            /* Only Ethernet client requests carrying the DHCP cookie */
+            if ( ( dhcp_header_len <= offsetof( dhcp_header_t, options ) ) ||
+                 ( dhcp_header_ptr->opcode != BOOTP_OP_REQUEST ) ||
+                 ( dhcp_header_ptr->hardware_addr_len != sizeof( mac ) ) ||
+                 ( memcmp( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 ) != 0 ) )
+            {
+                continue;
+            }
+
+            message_type = find_option( dhcp_header_ptr, dhcp_header_len, DHCP_OPTION_MESSAGE_TYPE );
+            if ( message_type == NULL )
+            {
+                continue;
+            }
+
+            memcpy( mac, dhcp_header_ptr->client_hardware_addr, sizeof( mac ) );
+            requested_address = find_option( dhcp_header_ptr, dhcp_header_len, DHCP_OPTION_REQUESTED_IP );
+            server_id         = find_option( dhcp_header_ptr, dhcp_header_len, DHCP_OPTION_SERVER_ID );
+
+            switch ( message_type[0] )
             {
                 case DHCPDISCOVER:
                     {
                         WWD_LOG(("Rcvd DHCP DISCOVER\n"));
 
-                        /* Discover command - send back OFFER response */
-                        dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
-
-                        /* Clear the DHCP options list */
-                        memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
-
-                        /* Create the IP address for the Offer */
-                        new_ip_addr[2] = next_available_ip_addr >> 8;
-                        new_ip_addr[3] = next_available_ip_addr & 0xff;
-                        memcpy( &dhcp_header_ptr->your_ip_addr, new_ip_addr, 4 );
-
-                        /* Copy the magic DHCP number */
-                        memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
-
-                        /* Add options */
-                        option_ptr = (char *) &dhcp_header_ptr->options;
-                        memcpy( option_ptr, dhcp_offer_option_buff, 3 );       /* DHCP message type */
-                        option_ptr += 3;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Server identifier */
-                        option_ptr += 6;
-                        memcpy( option_ptr, lease_time_option_buff, 6 );       /* Lease Time */
-                        option_ptr += 6;
-                        memcpy( option_ptr, subnet_option_buff, 6 );           /* Subnet Mask */
-                        option_ptr += 6;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* Router (gateway) */
-                        option_ptr[0] = 3; /* Router id */
-                        option_ptr += 6;
-                        memcpy( option_ptr, server_ip_addr_option_buff, 6 );   /* DNS server */
-                        option_ptr[0] = 6; /* DNS server id */
-                        option_ptr += 6;
-                        memcpy( option_ptr, mtu_option_buff, 4 );              /* Interface MTU */
-                        option_ptr += 4;
-                        option_ptr[0] = 0xff; /* end options */
-                        option_ptr++;
-
-                        /* Send packet */
-                        slen = (option_ptr - (char*)&dhcp_header_buff);
-                        buf = netbuf_new();
-                        mem = (char *)netbuf_alloc(buf, slen);
-                        if(mem == NULL)
+                        lease = dhcp_lease_allocate( mac, requested_address );
+                        if ( lease == NULL )
                         {
-                            WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
+                            WWD_LOG(("dhcp srv: address pool exhausted\r\n"));
+                            break;
                         }
-                        memcpy(mem, dhcp_header_ptr, slen);
-                        err = netconn_sendto(conn, buf,&dst_ip, IPPORT_DHCPC );
-                        if( err != ERR_OK )
+
+                        /* A bound client keeps its lease until it REQUESTs again */
+                        if ( lease->state != DHCP_LEASE_BOUND )
                         {
-                            WWD_LOG(("dhcp srv: sending is failed"));
+                            dhcp_lease_set( lease, mac, DHCP_LEASE_OFFERED, DHCP_OFFER_HOLD_SEC );
                         }
-                        netbuf_delete(buf);
+
+                        /* Discover command - send back OFFER response */
+                        dhcp_send_reply( conn, dhcp_offer_option_buff, lease );
                         WWD_LOG(("Sending discover response\r\n"));
                     }
                     break;
 
                 case DHCPREQUEST:
                     {
-                        /* REQUEST command - send back ACK or NAK */
-                        unsigned char* requested_address;
-                        uint32_t*      req_addr_ptr;
-                        uint32_t*      newip_ptr;
-                        //uint32_t*      server_id_req;
-
                         WWD_LOG(("Rcvd DHCP REQUEST\n"));
-                        /* Check that the REQUEST is for this server */
-
-                        dhcp_header_ptr->opcode = BOOTP_OP_REPLY;
-
-                        /* Locate the requested address in the options */
-                        requested_address = find_option( dhcp_header_ptr, 50 );
-
-                        /* Copy requested address */
-                        memcpy( &dhcp_header_ptr->your_ip_addr, requested_address, 4 );
 
-                        /* Blank options list */
-                        memset( &dhcp_header_ptr->options, 0, sizeof( dhcp_header_ptr->options ) );
-
-                        /* Copy DHCP magic number into packet */
-                        memcpy( dhcp_header_ptr->magic, dhcp_magic_cookie, 4 );
-
-                        option_ptr = (char *) &dhcp_header_ptr->options;
+                        /* Check that the REQUEST is for this server */
+                        if ( ( server_id != NULL ) && ( memcmp( server_id, &server_ip_addr_option_buff[2], 4 ) != 0 ) )
+                        {
+                            /* The client took the offer of another server */
+                            lease = dhcp_lease_find_mac( mac );
+                            if ( ( lease != NULL ) && ( lease->state == DHCP_LEASE_OFFERED ) )
+                            {
+                                dhcp_lease_set( lease, NULL, DHCP_LEASE_FREE, 0 );
+                            }
+                            break;
+                        }
 
-                        /* Check if Request if for next available IP address */
-                        req_addr_ptr = (uint32_t*) dhcp_header_ptr->your_ip_addr;
-                        newip_ptr = (uint32_t*) new_ip_addr;
-                        if ( *req_addr_ptr != ( ( *newip_ptr & 0x0000ffff ) | ( ( next_available_ip_addr & 0xff ) << 24 ) |
-                                                ( ( next_available_ip_addr & 0xff00 ) << 8 ) ) )
+                        /* SELECTING / INIT-REBOOT carry the address in an option, RENEWING / REBINDING in ciaddr */
+                        if ( requested_address == NULL )
                         {
-                            /* Request is not for next available IP - force client to take next available IP by sending NAK */
-                            /* Add appropriate options */
-                            memcpy( option_ptr, dhcp_nak_option_buff, 3 );  /* DHCP message type */
-                            option_ptr += 3;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Server identifier */
-                            option_ptr += 6;
-                            memset( &dhcp_header_ptr->your_ip_addr, 0, sizeof( dhcp_header_ptr->your_ip_addr ) ); /* Clear 'your address' field */
+                            requested_address = dhcp_header_ptr->client_ip_addr;
                         }
-                        else
+
+                        lease = dhcp_lease_find_ip( requested_address );
+                        if ( ( lease != NULL ) && dhcp_lease_available( lease, mac, xTaskGetTickCount( ) ) )
                         {
-                            /* Request is not for next available IP - force client to take next available IP by sending NAK
-                             * Add appropriate options
-                             */
-                            memcpy( option_ptr, dhcp_ack_option_buff, 3 );       /* DHCP message type */
-                            option_ptr += 3;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Server identifier */
-                            option_ptr += 6;
-                            memcpy( option_ptr, lease_time_option_buff, 6 );     /* Lease Time */
-                            option_ptr += 6;
-                            memcpy( option_ptr, subnet_option_buff, 6 );         /* Subnet Mask */
-                            option_ptr += 6;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* Router (gateway) */
-                            option_ptr[0] = 3; /* Router id */
-                            option_ptr += 6;
-                            memcpy( option_ptr, server_ip_addr_option_buff, 6 ); /* DNS server */
-                            option_ptr[0] = 6; /* DNS server id */
-                            option_ptr += 6;
-                            memcpy( option_ptr, mtu_option_buff, 4 );            /* Interface MTU */
-                            option_ptr += 4;
-                            /* WPRINT_APP_INFO(("Assigned new IP address %d.%d.%d.%d\n",
-                                                (uint8_t)new_ip_addr[0], (uint8_t)new_ip_addr[1], 
-                                                next_available_ip_addr>>8, next_available_ip_addr&0xff )); */
-                            /* Increment IP address */
-                            next_available_ip_addr++;
-                            if ( ( next_available_ip_addr & 0xff ) == 0xff ) /* Handle low byte rollover */
-                            {
-                                next_available_ip_addr += 101;
-                            }
-                            if ( ( next_available_ip_addr >> 8 ) == 0xff ) /* Handle high byte rollover */
+                            /* Drop any other address held for this client */
+                            dhcp_server_lease_t* previous = dhcp_lease_find_mac( mac );
+                            if ( ( previous != NULL ) && ( previous != lease ) )
                             {
-                                next_available_ip_addr += ( 2 << 8 );
+                                dhcp_lease_set( previous, NULL, DHCP_LEASE_FREE, 0 );
                             }
+
+                            dhcp_lease_set( lease, mac, DHCP_LEASE_BOUND, DHCP_LEASE_TIME_SEC );
+                            dhcp_send_reply( conn, dhcp_ack_option_buff, lease );
                         }
-                        option_ptr[0] = 0xff; /* end options */
-                        option_ptr++;
-
-                        /* Send packet */
-                        slen = (option_ptr - (char*)&dhcp_header_buff);
-                        buf = netbuf_new();
-                        mem = (char *)netbuf_alloc(buf, slen);
-                        if(mem == NULL)
+                        else
                         {
-                            WWD_LOG(("dhcp srv : Could not allocate memory for sending\n"));
+                            /* Address is not in the pool or leased to another client - force client to restart with a DISCOVER */
+                            dhcp_send_reply( conn, dhcp_nak_option_buff, NULL );
                         }
-                        memcpy(mem, dhcp_header_ptr, slen);
-                        err = netconn_sendto(conn, buf,&dst_ip, IPPORT_DHCPC );
-                        if( err != ERR_OK )
+                        WWD_LOG(("Sent request response\r\n"));
+                    }
+                    break;
+
+                case DHCPDECLINE:
+                    {
+                        /* The address is in use on the network, keep it out of the pool for a while */
+                        lease = dhcp_lease_find_ip( requested_address );
+                        if ( ( lease != NULL ) && ( memcmp( lease->mac, mac, sizeof( mac ) ) == 0 ) )
                         {
-                            WWD_LOG(("dhcp srv: sending is failed\r\n"));
+                            WWD_LOG(("Rcvd DHCP DECLINE\n"));
+                            dhcp_lease_set( lease, NULL, DHCP_LEASE_DECLINED, DHCP_DECLINE_HOLD_SEC );
+                        }
+                    }
+                    break;
+
+                case DHCPRELEASE:
+                    {
+                        /* Keep the MAC, the client gets the same address back on its next DISCOVER */
+                        lease = dhcp_lease_find_ip( dhcp_header_ptr->client_ip_addr );
+                        if ( ( lease != NULL ) && ( lease->state == DHCP_LEASE_BOUND ) &&
+                             ( memcmp( lease->mac, mac, sizeof( mac ) ) == 0 ) )
+                        {
+                            WWD_LOG(("Rcvd DHCP RELEASE\n"));
+                            dhcp_lease_set( lease, mac, DHCP_LEASE_FREE, 0 );
                         }
-                        WWD_LOG(("Sent request response\r\n"));
-                        netbuf_delete(buf);
                     }
                     break;
 
@@ -394,33 +580,105 @@ static void dhcp_thread( void * thread_input )
     vTaskDelete( dhcp_thread_handle );
 }
 
+uint32_t dhcp_server_get_leases( dhcp_server_lease_t* leases, uint32_t max_leases )
+{
+    uint32_t count = ( max_leases < DHCP_SERVER_MAX_LEASES ) ? max_leases : DHCP_SERVER_MAX_LEASES;
+
+    taskENTER_CRITICAL( );
+    memcpy( leases, dhcp_leases, count * sizeof( dhcp_server_lease_t ) );
+    taskEXIT_CRITICAL( );
+
+    return count;
+}
+
+
+/**
+ *  Searches one options area for an option
+ *
+ * @return Pointer to the option length byte, or NULL if not found
+ */
+
+static unsigned char * find_option_in( unsigned char* option_ptr, unsigned char* end_ptr, unsigned char option_num )
+{
+    while ( option_ptr < end_ptr )
+    {
+        if ( option_ptr[0] == DHCP_OPTION_END )
+        {
+            break;
+        }
+        if ( option_ptr[0] == DHCP_OPTION_PAD )
+        {
+            option_ptr++;
+            continue;
+        }
+        /* Length byte and data must be inside the area */
+        if ( ( option_ptr + 2 > end_ptr ) || ( option_ptr + 2 + option_ptr[1] > end_ptr ) )
+        {
+            break;
+        }
+        if ( option_ptr[0] == option_num )
+        {
+            return &option_ptr[1];
+        }
+        option_ptr += option_ptr[1] + 2;
+    }
+
+    return NULL;
+}
 
 /**
  *  Finds a specified DHCP option
  *
  *  Searches the given DHCP request and returns a pointer to the
- *  specified DHCP option data, or NULL if not found
+ *  specified DHCP option data, or NULL if not found.
+ *  With option overload (52), the 'file' then 'sname' fields are searched after the options area.
  *
- * @param request :    The DHCP request structure
- * @param option_num : Which DHCP option number to find
+ * @param request :     The DHCP request structure
+ * @param request_len : Bytes received in request
+ * @param option_num :  Which DHCP option number to find
  *
  * @return Pointer to the DHCP option data, or NULL if not found
  */
 
-static unsigned char * find_option( dhcp_header_t* request, unsigned char option_num )
+static unsigned char * find_option( dhcp_header_t* request, uint32_t request_len, unsigned char option_num )
 {
-    unsigned char* option_ptr = (unsigned char*) request->options;
-    while ( ( option_ptr[0] != 0xff ) &&
-            ( option_ptr[0] != option_num ) &&
-            ( option_ptr < ( (unsigned char*) request ) + sizeof( dhcp_header_t ) ) )
+    unsigned char* options_end = ( (unsigned char*) request ) + request_len;
+    unsigned char* option_len;
+    unsigned char* overload;
+    unsigned char  overload_value = 0;
+
+    if ( options_end > ( (unsigned char*) request ) + sizeof( dhcp_header_t ) )
     {
-        option_ptr += option_ptr[1] + 2;
+        options_end = ( (unsigned char*) request ) + sizeof( dhcp_header_t );
+    }
+
+    option_len = find_option_in( request->options, options_end, option_num );
+
+    if ( ( option_len == NULL ) && ( option_num != DHCP_OPTION_OVERLOAD ) )
+    {
+        overload = find_option_in( request->options, options_end, DHCP_OPTION_OVERLOAD );
+        if ( ( overload != NULL ) && ( overload[0] == 1 ) )
+        {
+            overload_value = overload[1];
+        }
+
+        if ( overload_value & DHCP_OVERLOAD_FILE )
+        {
+            option_len = find_option_in( &request->legacy[DHCP_FILE_OFFSET],
+                                         &request->legacy[DHCP_FILE_OFFSET + DHCP_FILE_LEN], option_num );
+        }
+        if ( ( option_len == NULL ) && ( overload_value & DHCP_OVERLOAD_SNAME ) )
+        {
+            option_len = find_option_in( &request->legacy[DHCP_SNAME_OFFSET],
+                                         &request->legacy[DHCP_SNAME_OFFSET + DHCP_SNAME_LEN], option_num );
+        }
     }
-    if ( option_ptr[0] == option_num )
+
+    /* Callers read the requested address and server identifier as 4 bytes, the message type as 1 */
+    if ( ( option_len == NULL ) || ( option_len[0] < ( ( option_num == DHCP_OPTION_MESSAGE_TYPE ) ? 1 : 4 ) ) )
     {
-        return &option_ptr[2];
+        return NULL;
     }
-    return NULL;
 
+    return &option_len[1];
 }
-
@@ -34,6 +34,27 @@
 #ifndef DHCP_SERVER_H
 #define DHCP_SERVER_H
 
+#include <stdint.h>
+
+/* Addresses handed out by the server, from .100 of the server /24 */
+#ifndef DHCP_SERVER_MAX_LEASES
+#define DHCP_SERVER_MAX_LEASES (8)
+#endif
+
+/* Lease states */
+#define DHCP_LEASE_FREE     (0)
+#define DHCP_LEASE_OFFERED  (1)
+#define DHCP_LEASE_BOUND    (2)
+#define DHCP_LEASE_DECLINED (3)
+
+typedef struct
+{
+    uint8_t  mac[6];      /* client hardware address, kept after release to give the same address back */
+    uint8_t  ip_addr[4];  /* leased address */
+    uint8_t  state;       /* DHCP_LEASE_xxx */
+    uint32_t expiry_tick; /* end of the offer, lease or decline hold, in RTOS ticks */
+} dhcp_server_lease_t;
+
 /**
  * @brief Starts the DHCP server
  *
@@ -46,4 +67,14 @@ void start_dhcp_server(uint32_t local_addr);
  */
 void quit_dhcp_server(void);
 
+/**
+ * @brief Gets a copy of the lease table
+ *
+ * @params leases: Array receiving the leases
+ * @params max_leases: Number of entries of leases
+ *
+ * @return Number of entries written
+ */
+uint32_t dhcp_server_get_leases(dhcp_server_lease_t *leases, uint32_t max_leases);
+
 #endif /* DHCP_SERVER_H */
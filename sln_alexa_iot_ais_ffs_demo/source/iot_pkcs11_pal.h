@@ -64,4 +64,22 @@ BaseType_t PKCS11_PAL_GetObjectValue( CK_OBJECT_HANDLE xHandle,
 void PKCS11_PAL_GetObjectValueCleanup( uint8_t * pucBuffer,
                                        uint32_t ulBufferSize );
 
+/**
+ *  @brief Drop the RAM copies of the objects, to be called after writing them to flash
+ *         other than through PKCS11_PAL_SaveObject().
+ */
+void PKCS11_PAL_InvalidateCache( void );
+
+/**
+ *  @brief Drop the RAM copy of a file written or erased in flash, set as the
+ *         file_changed_cb of the flash management.
+ */
+void PKCS11_PAL_FileChanged( const char * pcFileName );
+
+/**
+ *  @brief Zeroize every object kept in RAM right away, including copies still handed out,
+ *         to be called from C_Finalize().
+ */
+void PKCS11_PAL_WipeCache( void );
+
 #endif /* AWS_PKCS11_PAL include guard. */
@@ -51,6 +51,10 @@
 /* MbedTLS includes */
 #include "ksdk_mbedtls.h"
 
+/* PKCS#11 includes, the object cache follows the file writes */
+#include "iot_pkcs11.h"
+#include "iot_pkcs11_pal.h"
+
 /* Required last to have defined all members of g_fileTable */
 #include "sln_cfg_file.h"
 #include "sln_file_table.h"
@@ -179,7 +183,7 @@ static void vendor_startup_init(void)
 static void demo_init(void)
 {
     /* Set flash management callbacks */
-    sln_flash_mgmt_cbs_t flash_mgmt_cbs = {pdm_to_pcm_mics_off, pdm_to_pcm_mics_on};
+    sln_flash_mgmt_cbs_t flash_mgmt_cbs = {pdm_to_pcm_mics_off, pdm_to_pcm_mics_on, PKCS11_PAL_FileChanged};
     SLN_FLASH_MGMT_SetCbs(&flash_mgmt_cbs);
 
     /* Initialize flash management */
@@ -109,6 +109,7 @@
 #define FFS_REG_CHECK_INTERVAL_MSEC (30000U) /* Check FFS registration state every 30 seconds */
 #define FFS_REG_UGS_TIMEOUT_SEC     (900U)   /* UGS registration timeout interval 900 seconds */
 #define APP_EVENT_QUEUE_SIZE        (5)
+#define APP_ALERT_QUEUE_SIZE        (APP_EVENT_QUEUE_SIZE + 1) /* A token per alert event queued and the one sent */
 
 /*******************************************************************************
  * Prototypes
@@ -130,8 +131,6 @@ static status_t _init_streamer();
  * Variables
  ******************************************************************************/
 
-const uint64_t kEpochDayZero = 3752179200ULL; // 11/26/2018 0:00:00
-
 __attribute__((section(".ocram_non_cacheable_bss"))) ais_handle_t aisHandle;
 __attribute__((section(".ocram_non_cacheable_bss"))) ais_config_t aisConfig;
 
@@ -917,27 +916,16 @@ void ais_app_clock_cb(TimerHandle_t xTimer)
 
     if (kStartState != reconnection_task_get_state())
     {
-        /* Begin check for timers that should have triggered (Offline use case) */
-        for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
-        {
-            uint64_t alertTime = AIS_Alerts_GetScheduledTime(idx);
+        int32_t idx = -1;
 
-            /* Any timer before this date is guaranteed to be invalid */
-            if ((kEpochDayZero < alertTime) && ((alertTime != UINT64_MAX)))
-            {
-                if (alertTime < appData->currTime)
-                {
-                    /* Trigger alerts that aren't already triggered */
-                    if (true == AIS_Alerts_GetIdleState(idx))
-                    {
-                        /* Trigger alert in UX system */
-                        AIS_Alerts_Trigger(idx, true);
+        /* Trigger alerts that should have triggered and aren't already triggered (Offline use case) */
+        while (0 <= (idx = AIS_Alerts_GetNextDue(appData->currTime)))
+        {
+            /* Trigger alert in UX system */
+            AIS_Alerts_Trigger(idx, true);
 
-                        /* Mark this as triggered */
-                        AIS_Alerts_MarkAsTriggeredOffline(idx);
-                    }
-                }
-            }
+            /* Mark this as triggered */
+            AIS_Alerts_MarkAsTriggeredOffline(idx);
         }
     }
 }
@@ -1141,25 +1129,32 @@ void appInit(void *arg)
     }
 
     /* Gather any alerts requires for deletion */
-    alertTokenList_t alertsList;
-    uint32_t alertsCount = 0;
+    alertTokenList_t *alertsList = (alertTokenList_t *)pvPortMalloc(sizeof(alertTokenList_t));
+    char **alertTokens           = (char **)pvPortMalloc(AIS_APP_MAX_ALERT_COUNT * sizeof(char *));
+    uint32_t alertsCount         = 0;
+
+    if ((NULL != alertsList) && (NULL != alertTokens))
+    {
 #if (defined(AIS_SPEC_REV_325) && (AIS_SPEC_REV_325 == 1))
-    AIS_Alerts_GetAlertsList(&alertsList, &alertsCount);
+        AIS_Alerts_GetAlertsList(alertsList, &alertsCount);
 #else
-    AIS_Alerts_GetDeletedList(&alertsList, &alertsCount);
+        AIS_Alerts_GetDeletedList(alertsList, &alertsCount);
 #endif
+    }
     configPRINTF(("Found %d alerts ready to delete.\r\n", alertsCount));
 
     /* Send SynchronizeState to update on our status. */
-    char *alertTokens[AIS_APP_MAX_ALERT_COUNT] = {0};
     for (uint32_t idx = 0; idx < alertsCount; idx++)
     {
-        alertTokens[idx] = (char *)(&alertsList[idx]);
+        alertTokens[idx] = (*alertsList)[idx];
         configPRINTF(("Alert ready for delete: %s\r\n", alertTokens[idx]));
     }
 
     AIS_EventSynchronizeState(&aisHandle, appData->volume, (const char **)alertTokens, alertsCount);
 
+    vPortFree(alertTokens);
+    vPortFree(alertsList);
+
     aisClockSyncHandle =
         xTimerCreate("AIS_Clock_Sync", AIS_APP_TIMER_INTERVAL_MSEC, pdTRUE, (void *)0, ais_app_clock_cb);
 
@@ -1312,7 +1307,7 @@ void appTask(void *arg)
     vTaskDelay(1000);
 
     /* Queue needs to be initialized before AIS connect as this will cause a fault if a set or delete alert occurs */
-    g_alertQueue = xQueueCreate(AIS_APP_MAX_ALERT_COUNT, AIS_MAX_ALERT_TOKEN_LEN_BYTES);
+    g_alertQueue = xQueueCreate(APP_ALERT_QUEUE_SIZE, AIS_MAX_ALERT_TOKEN_LEN_BYTES);
 
     vTaskSuspend(NULL);
 
@@ -1344,23 +1339,29 @@ void appTask(void *arg)
     if (1 == updateStatus)
     {
         /* Gather any alerts requires for deletion */
-        alertTokenList_t alertsList;
-        uint32_t alertsCount = 0;
+        alertTokenList_t *alertsList = (alertTokenList_t *)pvPortMalloc(sizeof(alertTokenList_t));
+        char **alertTokens           = (char **)pvPortMalloc(AIS_APP_MAX_ALERT_COUNT * sizeof(char *));
+        uint32_t alertsCount         = 0;
+
+        if ((NULL != alertsList) && (NULL != alertTokens))
+        {
 #if (defined(AIS_SPEC_REV_325) && (AIS_SPEC_REV_325 == 1))
-        AIS_Alerts_GetAlertsList(&alertsList, &alertsCount);
+            AIS_Alerts_GetAlertsList(alertsList, &alertsCount);
 #else
-        AIS_Alerts_GetDeletedList(&alertsList, &alertsCount);
+            AIS_Alerts_GetDeletedList(alertsList, &alertsCount);
 #endif
+        }
 
         /* Send SynchronizeState to update on our status. */
-        char *alertTokens[AIS_APP_MAX_ALERT_COUNT] = {0};
-
-        for (uint32_t idx = 0; idx < AIS_APP_MAX_ALERT_COUNT; idx++)
+        for (uint32_t idx = 0; idx < alertsCount; idx++)
         {
-            alertTokens[idx] = (char *)(&alertsList[idx]);
+            alertTokens[idx] = (*alertsList)[idx];
         }
 
         AIS_EventSynchronizeState(&aisHandle, appData->volume, (const char **)alertTokens, alertsCount);
+
+        vPortFree(alertTokens);
+        vPortFree(alertsList);
     }
 
     micOpen.asr_profile = AIS_ASR_FAR_FIELD;
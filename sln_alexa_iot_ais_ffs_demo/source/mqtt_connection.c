@@ -17,9 +17,115 @@
 #include "mqtt_connection.h"
 #include "iot_mqtt_types.h"
 
+#if MQTT_TLS_SESSION_PERSIST
+#include "iot_tls.h"
+#include "sln_flash_mgmt.h"
+#endif
+
 static MQTTAgentHandle_t mqttHandle = NULL;
 static char *alexaCLIENT_ID         = NULL;
 
+#if MQTT_TLS_SESSION_PERSIST
+/* Last session blob written to flash, used to skip rewriting an unchanged session */
+static uint8_t s_tlsSessionBlob[TLS_SESSION_BLOB_MAX_LENGTH];
+static uint32_t s_tlsSessionBlobLen    = 0;
+static bool s_tlsSessionLoaded         = false;
+static TickType_t s_tlsSessionSaveTick = 0;
+static uint8_t s_tlsSessionId[TLS_SESSION_ID_MAX_LENGTH];
+static size_t s_tlsSessionIdLen = 0;
+
+/*!
+ * @brief Loads the TLS session saved by a previous boot into the TLS session cache
+ */
+static void tls_session_load(void)
+{
+    int32_t ret  = SLN_FLASH_MGMT_OK;
+    uint32_t len = sizeof(s_tlsSessionBlob);
+
+    s_tlsSessionLoaded = true;
+
+    ret = SLN_FLASH_MGMT_Read(TLS_SESSION_FILE_NAME, s_tlsSessionBlob, &len);
+
+    if ((SLN_FLASH_MGMT_OK == ret) && (0 != len) && (len <= sizeof(s_tlsSessionBlob)))
+    {
+        if (0 == TLS_SessionImport(s_tlsSessionBlob, len))
+        {
+            s_tlsSessionBlobLen  = len;
+            s_tlsSessionSaveTick = xTaskGetTickCount();
+            TLS_SessionGetInfo(s_tlsSessionId, &s_tlsSessionIdLen, NULL, NULL);
+            configPRINTF(("Loaded saved TLS session.\r\n"));
+        }
+    }
+}
+
+/*!
+ * @brief Saves the TLS session of the current connection, when it differs from the one in flash
+ *
+ * A session resumed by ID keeps the ID of the one in flash and is skipped without exporting it.
+ * A session resumed by ticket gets a new random ID, but keeps the master secret of the one in
+ * flash, only its ticket may have been renewed. The ticket in flash stays usable, so it is only
+ * replaced once half of its lifetime is gone.
+ */
+static void tls_session_save(void)
+{
+    static uint8_t blob[TLS_SESSION_BLOB_MAX_LENGTH] = {0};
+    uint8_t id[TLS_SESSION_ID_MAX_LENGTH]            = {0};
+    size_t idLen                                     = 0;
+    int32_t ret                                      = SLN_FLASH_MGMT_OK;
+    size_t len                                       = 0;
+    BaseType_t resumed                               = pdFALSE;
+    uint32_t lifetime                                = 0;
+
+    if (0 != TLS_SessionGetInfo(id, &idLen, &resumed, &lifetime))
+    {
+        return;
+    }
+
+    if ((0 != s_tlsSessionBlobLen) && (0 != idLen) && (idLen == s_tlsSessionIdLen) &&
+        (0 == memcmp(id, s_tlsSessionId, idLen)))
+    {
+        return;
+    }
+
+    if (resumed && (0 != s_tlsSessionBlobLen))
+    {
+        uint32_t age = (xTaskGetTickCount() - s_tlsSessionSaveTick) / configTICK_RATE_HZ;
+
+        if ((0 == lifetime) || (age < (lifetime / 2)))
+        {
+            return;
+        }
+    }
+
+    if (0 == TLS_SessionExport(blob, sizeof(blob), &len))
+    {
+        if ((len != s_tlsSessionBlobLen) || (0 != memcmp(blob, s_tlsSessionBlob, len)))
+        {
+            ret = SLN_FLASH_MGMT_Save(TLS_SESSION_FILE_NAME, blob, len);
+
+            if ((SLN_FLASH_MGMT_EOVERFLOW == ret) || (SLN_FLASH_MGMT_EOVERFLOW2 == ret))
+            {
+                SLN_FLASH_MGMT_Erase(TLS_SESSION_FILE_NAME);
+                ret = SLN_FLASH_MGMT_Save(TLS_SESSION_FILE_NAME, blob, len);
+            }
+
+            if (SLN_FLASH_MGMT_OK == ret)
+            {
+                memcpy(s_tlsSessionBlob, blob, len);
+                memcpy(s_tlsSessionId, id, idLen);
+                s_tlsSessionBlobLen  = len;
+                s_tlsSessionIdLen    = idLen;
+                s_tlsSessionSaveTick = xTaskGetTickCount();
+            }
+            else
+            {
+                configPRINTF(("ERROR %d: Failed to save TLS session.\r\n", ret));
+            }
+        }
+    }
+}
+#endif /* MQTT_TLS_SESSION_PERSIST */
+
 /*!
  * @brief Generates an incremental backoff delay between MQTT connections
  *
@@ -114,6 +220,13 @@ MQTTAgentReturnCode_t APP_MQTT_Connect(MQTTAgentCallback_t callback)
         xReturned = eMQTTAgentFailure;
     }
 
+#if MQTT_TLS_SESSION_PERSIST
+    if ((xReturned == eMQTTAgentSuccess) && !s_tlsSessionLoaded)
+    {
+        tls_session_load();
+    }
+#endif /* MQTT_TLS_SESSION_PERSIST */
+
     if (xReturned == eMQTTAgentSuccess)
     {
         for (attempts = 0; attempts < MQTT_CONNECTION_ATTEMPTS; attempts++)
@@ -125,6 +238,9 @@ MQTTAgentReturnCode_t APP_MQTT_Connect(MQTTAgentCallback_t callback)
             if (xReturned == eMQTTAgentSuccess)
             {
                 configPRINTF(("MQTT Alexa connected.\r\n"));
+#if MQTT_TLS_SESSION_PERSIST
+                tls_session_save();
+#endif /* MQTT_TLS_SESSION_PERSIST */
                 break;
             }
             else
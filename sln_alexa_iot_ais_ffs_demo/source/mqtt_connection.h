@@ -11,6 +11,7 @@
 #define MQTT_CONNECTION_H_
 
 #include "task.h"
+#include "tls_session_file.h"
 
 #ifndef MQTT_CONNECTION_ATTEMPTS
 #define MQTT_CONNECTION_ATTEMPTS (6)
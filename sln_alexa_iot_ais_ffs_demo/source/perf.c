@@ -11,6 +11,9 @@
 
 #include "fsl_gpt.h"
 #include "perf.h"
+#include "heap_slab.h"
+#include "heap_4_wrap.h"
+#include "sln_tickless.h"
 
 #ifdef SLN_TRACE_CPU_USAGE
 /* In this configuration, PERF_TIMER_GPT will overflow after ~10 hours and
@@ -112,3 +115,128 @@ void PERF_PrintStacks(void)
         configPRINTF(("%s: No memory for storing task status\r\n", __func__));
     }
 }
+
+#if (configUSE_HEAP_SLAB == 1)
+void PERF_PrintSlabs(void)
+{
+    SlabStats_t stats[8];
+    size_t count = xSlabGetStats(stats, sizeof(stats) / sizeof(stats[0]));
+
+    if (0 == count)
+    {
+        configPRINTF(("Heap slab classes not set up\r\n"));
+        return;
+    }
+
+    configPRINTF(("\r\n"));
+    configPRINTF(("Size\tBlocks\tIn use\tMax\tAllocs\tTo heap_4\r\n"));
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        configPRINTF(("%u\t%u\t%u\t%u\t%u\t%u\r\n", stats[idx].xBlockSize, stats[idx].xBlockCount, stats[idx].xInUse,
+                      stats[idx].xHighWater, stats[idx].xAllocations, stats[idx].xFallThroughs));
+    }
+    configPRINTF(("  heap_4 free: %d, min free: %d\r\n", xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize()));
+}
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+#if (configUSE_HEAP_TRACKER == 1)
+/* Bytes per "HEAPTRK" line of the export */
+#define PERF_HEAP_EXPORT_LINE 32
+
+void PERF_PrintHeapProfile(bool exportBlob)
+{
+    HeapSiteStats_t sites[8];
+    static HeapTrendSample_t trend[configHEAP_TRACKER_TREND_SAMPLES];
+    size_t bins[heapHISTOGRAM_BINS];
+    size_t largest;
+    size_t count;
+
+    if (exportBlob)
+    {
+        uint8_t *blob = (uint8_t *)pvPortMalloc(heapEXPORT_MAX_SIZE);
+        char line[8 + (2 * PERF_HEAP_EXPORT_LINE) + 1];
+
+        if (NULL == blob)
+        {
+            configPRINTF(("%s: No memory for the export\r\n", __func__));
+            return;
+        }
+
+        size_t len = xHeapTrackerExport(blob, heapEXPORT_MAX_SIZE);
+        for (size_t pos = 0; pos < len; pos += PERF_HEAP_EXPORT_LINE)
+        {
+            size_t out = 0;
+            for (size_t idx = pos; (idx < len) && (idx < pos + PERF_HEAP_EXPORT_LINE); idx++)
+            {
+                out += snprintf(&line[out], sizeof(line) - out, "%02x", blob[idx]);
+            }
+            configPRINTF(("HEAPTRK %s\r\n", line));
+        }
+        configPRINTF(("HEAPTRK END\r\n"));
+
+        vPortFree(blob);
+        return;
+    }
+
+    largest = xHeapGetFreeHistogram(bins, heapHISTOGRAM_BINS);
+
+    configPRINTF(("\r\n"));
+    configPRINTF(("Heap free: %d, min free: %d, largest free block: %u, untracked allocs: %u\r\n",
+                  xPortGetFreeHeapSize(), xPortGetMinimumEverFreeHeapSize(), largest, xHeapTrackerGetUntracked()));
+
+    configPRINTF(("Free blocks\r\n"));
+    for (size_t idx = 0; idx < heapHISTOGRAM_BINS; idx++)
+    {
+        if (bins[idx] != 0)
+        {
+            if (idx < heapHISTOGRAM_BINS - 1)
+            {
+                configPRINTF(("  < %u\t%u\r\n", 1U << (heapHISTOGRAM_FIRST_SHIFT + 1 + idx), bins[idx]));
+            }
+            else
+            {
+                configPRINTF(("  >= %u\t%u\r\n", 1U << (heapHISTOGRAM_FIRST_SHIFT + idx), bins[idx]));
+            }
+        }
+    }
+
+    count = xHeapTrackerGetTopSites(sites, sizeof(sites) / sizeof(sites[0]), pdFALSE);
+    configPRINTF(("Top sites by live bytes\r\nCaller\t\tLive\tBlocks\tAllocs\tBytes\r\n"));
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        configPRINTF(("%p\t%u\t%u\t%u\t%u\r\n", sites[idx].pvCaller, sites[idx].xLiveBytes, sites[idx].xLiveBlocks,
+                      sites[idx].xAllocations, sites[idx].xAllocatedBytes));
+    }
+
+    count = xHeapTrackerGetTopSites(sites, sizeof(sites) / sizeof(sites[0]), pdTRUE);
+    configPRINTF(("Top sites by churn\r\nCaller\t\tLive\tBlocks\tAllocs\tBytes\r\n"));
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        configPRINTF(("%p\t%u\t%u\t%u\t%u\r\n", sites[idx].pvCaller, sites[idx].xLiveBytes, sites[idx].xLiveBlocks,
+                      sites[idx].xAllocations, sites[idx].xAllocatedBytes));
+    }
+
+    count = xHeapTrackerGetTrend(trend, configHEAP_TRACKER_TREND_SAMPLES);
+    if (count > 0)
+    {
+        configPRINTF(("Largest free block trend: %u (tick %u) -> %u (tick %u)\r\n", trend[0].xLargestFreeBlock,
+                      trend[0].xTick, trend[count - 1].xLargestFreeBlock, trend[count - 1].xTick));
+    }
+}
+#endif /* configUSE_HEAP_TRACKER == 1 */
+
+#if (configUSE_TICKLESS_IDLE == 1)
+void PERF_PrintTickless(void)
+{
+    sln_tickless_stats_t stats;
+    uint32_t uptimeMs = xTaskGetTickCount() * portTICK_PERIOD_MS;
+
+    SLN_TICKLESS_GetStats(&stats);
+
+    configPRINTF(("\r\n"));
+    configPRINTF(("Tickless idle: %u sleeps, %u too short, %u woken early\r\n", stats.sleeps, stats.skipped,
+                  stats.earlyWakes));
+    configPRINTF(("  ticks suppressed: %u, asleep %u ms of %u ms\r\n", stats.ticksSuppressed,
+                  (uint32_t)(stats.sleepUs / 1000U), uptimeMs));
+}
+#endif /* configUSE_TICKLESS_IDLE == 1 */
@@ -13,6 +13,8 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include <stdbool.h>
+
 #if defined(__cplusplus)
 extern "C" {
 #endif /*_cplusplus*/
@@ -34,6 +36,29 @@ void PERF_PrintHeap(void);
  */
 void PERF_PrintStacks(void);
 
+#if (configUSE_HEAP_SLAB == 1)
+/**
+ * @brief print the usage of the heap slab classes
+ */
+void PERF_PrintSlabs(void);
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+#if (configUSE_HEAP_TRACKER == 1)
+/**
+ * @brief print the heap call site profile and free block histogram
+ *
+ * @param exportBlob true to dump the raw profile as "HEAPTRK" hex lines for scripts/heap_profile_report.py
+ */
+void PERF_PrintHeapProfile(bool exportBlob);
+#endif /* configUSE_HEAP_TRACKER == 1 */
+
+#if (configUSE_TICKLESS_IDLE == 1)
+/**
+ * @brief print the tickless idle counters
+ */
+void PERF_PrintTickless(void);
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
 #if defined(__cplusplus)
 }
 #endif /*_cplusplus*/
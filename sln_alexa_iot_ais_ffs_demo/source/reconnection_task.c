@@ -440,21 +440,24 @@ static void reconnect_state_machine(uint32_t *reconnectState)
                 }
 
                 /* Gather any alerts requires for deletion */
-                alertTokenList_t alertsList;
-                uint32_t alertsCount = 0;
+                alertTokenList_t *alertsList = (alertTokenList_t *)pvPortMalloc(sizeof(alertTokenList_t));
+                char **alertTokens           = (char **)pvPortMalloc(AIS_APP_MAX_ALERT_COUNT * sizeof(char *));
+                uint32_t alertsCount         = 0;
 
+                if ((NULL != alertsList) && (NULL != alertTokens))
+                {
 #if (defined(AIS_SPEC_REV_325) && (AIS_SPEC_REV_325 == 1))
-                AIS_Alerts_GetAlertsList(&alertsList, &alertsCount);
+                    AIS_Alerts_GetAlertsList(alertsList, &alertsCount);
 #else
-                AIS_Alerts_GetDeletedList(&alertsList, &alertsCount);
+                    AIS_Alerts_GetDeletedList(alertsList, &alertsCount);
 #endif
+                }
                 configPRINTF(("Found %d alerts ready to send.\r\n", alertsCount));
 
                 /* Send SynchronizeState to update on our status. */
-                char *alertTokens[AIS_APP_MAX_ALERT_COUNT] = {0};
                 for (uint32_t idx = 0; idx < alertsCount; idx++)
                 {
-                    alertTokens[idx] = (char *)(&alertsList[idx]);
+                    alertTokens[idx] = (*alertsList)[idx];
                     configPRINTF(("Alert ready to send: %s\r\n", alertTokens[idx]));
                 }
 
@@ -462,6 +465,9 @@ static void reconnect_state_machine(uint32_t *reconnectState)
                 connectStatus =
                     AIS_EventSynchronizeState(&aisHandle, appData->volume, (const char **)alertTokens, alertsCount);
 
+                vPortFree(alertTokens);
+                vPortFree(alertsList);
+
                 if (kStatus_Success != connectStatus)
                 {
                     configPRINTF(("[Reconnect] Error sending SynchronizeState: %d\r\n", connectStatus));
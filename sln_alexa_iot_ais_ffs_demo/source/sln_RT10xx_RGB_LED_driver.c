@@ -27,6 +27,21 @@ __attribute__((weak)) void RGB_LED_SetBrightnessColor(rgb_led_brightness_t brigh
     /* Set RGB color and brightness from enum */
 }
 
+__attribute__((weak)) status_t RGB_LED_ComputeFrame(rgb_led_brightness_t brightness,
+                                                    rgbLedColor_t color,
+                                                    uint8_t level,
+                                                    rgb_led_frame_t *frame)
+{
+    /* Compute the PWM frame of a color */
+    memset(frame, 0, sizeof(rgb_led_frame_t));
+    return kStatus_Success;
+}
+
+__attribute__((weak)) void RGB_LED_SetFrame(const rgb_led_frame_t *frame)
+{
+    /* Load a PWM frame */
+}
+
 void RGB_LED_Blink(uint8_t brightness, uint8_t color, uint32_t blinkrate, uint32_t *blinkcount, bool *blinktoggle)
 {
     if (*blinkcount > blinkrate)
@@ -38,6 +38,15 @@ typedef enum _rgb_led_color
     LED_COLOR_OFF,    /*!< LED Off */
 } rgbLedColor_t;
 
+/*! @brief Full level passed to RGB_LED_ComputeFrame, the color as RGB_LED_SetBrightnessColor shows it */
+#define RGB_LED_LEVEL_FULL 255U
+
+/*! @brief PWM duty of the red, green and blue channels, ready to be loaded */
+typedef struct _rgb_led_frame
+{
+    uint16_t halfPulse[3]; /*!< Half of the high pulse width, in PWM counts */
+} rgb_led_frame_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
@@ -60,6 +69,25 @@ void RGB_LED_SetColor(rgbLedColor_t color);
  */
 void RGB_LED_SetBrightnessColor(rgb_led_brightness_t brightness, rgbLedColor_t color);
 
+/*!
+ * @brief Compute the PWM frame of a color, without touching the outputs
+ *
+ * @param brightness Target brightness of the RGB LED
+ * @param color Target color of the RGB LED
+ * @param level Intensity scale, 0 (off) to RGB_LED_LEVEL_FULL
+ * @param frame Pointer to the computed frame
+ *
+ * @returns kStatus_Success or kStatus_InvalidArgument for an unknown brightness
+ */
+status_t RGB_LED_ComputeFrame(rgb_led_brightness_t brightness, rgbLedColor_t color, uint8_t level, rgb_led_frame_t *frame);
+
+/*!
+ * @brief Load a frame computed by RGB_LED_ComputeFrame, safe to call from an interrupt
+ *
+ * @param frame Pointer to the frame to show
+ */
+void RGB_LED_SetFrame(const rgb_led_frame_t *frame);
+
 /*!
  * @brief Blink RGB LED for given duration and frequency
  *
@@ -178,7 +178,7 @@ void RGB_LED_SetColor(rgbLedColor_t color)
     PWM_SetPwmLdok(BOARD_PWM_BASEADDR, kPWM_Control_Module_0 | kPWM_Control_Module_1 | kPWM_Control_Module_3, true);
 }
 
-void RGB_LED_SetBrightnessColor(rgb_led_brightness_t brightness, rgbLedColor_t color)
+static bool RGB_LED_GetDutyPercent(rgb_led_brightness_t brightness, rgbLedColor_t color, uint8_t duty[3])
 {
     uint8_t redPWMval;
     uint8_t greenPWMval;
@@ -269,14 +269,63 @@ void RGB_LED_SetBrightnessColor(rgb_led_brightness_t brightness, rgbLedColor_t c
     else
     {
         /* error */
-        return;
+        return false;
     }
 
-    /* Update duty cycles for all 3 PWM signals */
-    PWM_UpdatePwmDutycycle(BOARD_PWM_BASEADDR, kPWM_Module_0, kPWM_PwmA, kPWM_SignedCenterAligned, redPWMval);
-    PWM_UpdatePwmDutycycle(BOARD_PWM_BASEADDR, kPWM_Module_1, kPWM_PwmA, kPWM_SignedCenterAligned, (greenPWMval >> 1));
-    PWM_UpdatePwmDutycycle(BOARD_PWM_BASEADDR, kPWM_Module_3, kPWM_PwmA, kPWM_SignedCenterAligned, (bluePWMval >> 3));
+    /* Channel balance of the RGB LED */
+    duty[0] = redPWMval;
+    duty[1] = (greenPWMval >> 1);
+    duty[2] = (bluePWMval >> 3);
+
+    return true;
+}
+
+status_t RGB_LED_ComputeFrame(rgb_led_brightness_t brightness, rgbLedColor_t color, uint8_t level, rgb_led_frame_t *frame)
+{
+    static const pwm_submodule_t s_subModules[3] = {kPWM_Module_0, kPWM_Module_1, kPWM_Module_3};
+    uint8_t duty[3];
+    uint32_t dutyCycle;
+    uint32_t pulseCnt;
+
+    if (!RGB_LED_GetDutyPercent(brightness, color, duty))
+    {
+        return kStatus_InvalidArgument;
+    }
+
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        /* Same rounding as PWM_UpdatePwmDutycycle, then scaled by level */
+        dutyCycle = ((65535U * duty[channel]) + 50U) / 100U;
+        dutyCycle = (dutyCycle * level) / RGB_LED_LEVEL_FULL;
+
+        /* Signed center aligned: the pulse spans twice the modulo */
+        pulseCnt = (uint16_t)((BOARD_PWM_BASEADDR->SM[s_subModules[channel]].VAL1 + 1U) * 2U);
+
+        frame->halfPulse[channel] = (uint16_t)(((pulseCnt * dutyCycle) / 65535U) / 2U);
+    }
+
+    return kStatus_Success;
+}
+
+void RGB_LED_SetFrame(const rgb_led_frame_t *frame)
+{
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_0].VAL2 = (uint16_t)(~frame->halfPulse[0] + 1U);
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_0].VAL3 = frame->halfPulse[0];
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_1].VAL2 = (uint16_t)(~frame->halfPulse[1] + 1U);
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_1].VAL3 = frame->halfPulse[1];
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_3].VAL2 = (uint16_t)(~frame->halfPulse[2] + 1U);
+    BOARD_PWM_BASEADDR->SM[kPWM_Module_3].VAL3 = frame->halfPulse[2];
 
     /* Set the load okay bit for all submodules to load registers from their buffer */
     PWM_SetPwmLdok(BOARD_PWM_BASEADDR, kPWM_Control_Module_0 | kPWM_Control_Module_1 | kPWM_Control_Module_3, true);
 }
+
+void RGB_LED_SetBrightnessColor(rgb_led_brightness_t brightness, rgbLedColor_t color)
+{
+    rgb_led_frame_t frame;
+
+    if (kStatus_Success == RGB_LED_ComputeFrame(brightness, color, RGB_LED_LEVEL_FULL, &frame))
+    {
+        RGB_LED_SetFrame(&frame);
+    }
+}
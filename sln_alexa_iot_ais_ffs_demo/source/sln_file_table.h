@@ -11,6 +11,8 @@
 #define _SLN_FILE_TABLE_
 
 #include "sln_flash_mgmt.h"
+#include "tcpip_lease_file.h"
+#include "tls_session_file.h"
 
 /*! Addresses for files */
 #define SLN_FLASH_TBL_RES           RESERVED
@@ -106,14 +108,22 @@ const sln_flash_entry_t g_fileTable[] = {
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 13
 
+#ifdef TCPIP_LEASE_FILE_NAME
+    SLN_FLASH_ENTRY(TCPIP_LEASE_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#endif
 
 #undef SLN_FLASH_INDEX
 #define SLN_FLASH_INDEX 14
 
+#ifdef TLS_SESSION_FILE_NAME
+    SLN_FLASH_ENTRY(TLS_SESSION_FILE_NAME, SLN_FLASH_INDEX, SLN_FLASH_ENCRYPTED),
+#else
     SLN_FLASH_ENTRY(
         SLN_FLASH_TBL_PRINT(SLN_FLASH_TBL_CAT(SLN_FLASH_TBL_RES, SLN_FLASH_INDEX)), SLN_FLASH_INDEX, SLN_FLASH_PLAIN),
+#endif
 
 // Start of NXP defined files; DO NOT edit below if using NXP kit & eco-system
 #undef SLN_FLASH_INDEX
@@ -335,6 +335,15 @@ static int32_t write_file(file_meta_t *meta, uint8_t *flashFile)
     return ret;
 }
 
+/*! @brief Tell the file changed callback a file was written or erased, file lock not held */
+static void file_changed(const char *name)
+{
+    if (NULL != s_flashMgmtCbs.file_changed_cb)
+    {
+        s_flashMgmtCbs.file_changed_cb(name);
+    }
+}
+
 /*! @brief Initialize RAM CRC mirror for all files in global table. */
 static int32_t init_ram_crc_mirror(uint32_t flashEntryIdx)
 {
@@ -804,6 +813,9 @@ int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len)
             vPortFree(flashFile);
             flashFile = NULL;
             xSemaphoreGive(s_fileLock);
+
+            // Outside the lock, the callback may read the file again
+            file_changed(name);
         }
     }
 
@@ -950,6 +962,173 @@ int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len)
             vPortFree(meta);
             meta = NULL;
             xSemaphoreGive(s_fileLock);
+
+            // Outside the lock, the callback may read the file again
+            file_changed(name);
+        }
+    }
+
+    return ret;
+}
+
+int32_t SLN_FLASH_MGMT_Program(const char *name, uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    int32_t ret = SLN_FLASH_MGMT_ENOLOCK;
+
+    if (NULL != s_fileLock)
+    {
+        if (pdTRUE == xSemaphoreTake(s_fileLock, portMAX_DELAY))
+        {
+            file_meta_t *meta          = NULL;
+            uint8_t *flashPage         = NULL;
+            sln_flash_map_t *flashMap  = NULL;
+            sln_file_header_t *currHdr = NULL;
+            uint32_t fileSize          = 0;
+            uint32_t address           = 0;
+            uint32_t pageAddr          = 0;
+            uint32_t toCopy            = 0;
+
+            ret = SLN_FLASH_MGMT_OK;
+
+            if ((NULL == data) || (0U == len))
+            {
+                // Bail out, nothing to program
+                ret = SLN_FLASH_MGMT_EINVAL;
+                goto exit;
+            }
+
+            meta = (file_meta_t *)pvPortMalloc(sizeof(file_meta_t));
+
+            if (NULL == meta)
+            {
+                ret = SLN_FLASH_MGMT_ENOMEM;
+                goto exit;
+            }
+            else
+            {
+                // Clear out data
+                memset(meta, 0x00, sizeof(file_meta_t));
+            }
+
+            // Get file meta info
+            ret = get_file_info_from_name(meta, name);
+
+            if (SLN_FLASH_MGMT_ENOENTRY == ret)
+            {
+                goto exit;
+            }
+
+            if (meta->useEncryption)
+            {
+                // Encrypted data can't be programmed a few bytes at a time
+                ret = SLN_FLASH_MGMT_EINVAL2;
+                goto exit;
+            }
+
+            // Get current flash address from map
+            flashMap = (sln_flash_map_t *)pvPortMalloc(sizeof(sln_flash_map_t));
+
+            if (NULL == flashMap)
+            {
+                ret = SLN_FLASH_MGMT_ENOMEM;
+                goto exit;
+            }
+
+            // Copy sector file map to ram
+            ret = get_sector_file_map(meta, flashMap);
+
+            if (SLN_FLASH_MGMT_OK != ret)
+            {
+                goto exit;
+            }
+
+            currHdr   = (sln_file_header_t *)pvPortMalloc(sizeof(sln_file_header_t));
+            flashPage = (uint8_t *)pvPortMalloc(FLASH_PAGE_SIZE);
+
+            if ((NULL == currHdr) || (NULL == flashPage))
+            {
+                ret = SLN_FLASH_MGMT_ENOMEM2;
+                goto exit;
+            }
+
+            // Get current file header from flash
+            SLN_Read_Flash_At_Address(meta->fileHeadAddr, (uint8_t *)currHdr, sizeof(sln_file_header_t));
+
+            fileSize = get_entry_file_size(currHdr);
+
+            if ((offset > fileSize) || (len > (fileSize - offset)))
+            {
+                // Can't increase length
+                ret = SLN_FLASH_MGMT_EINVAL3;
+                goto exit;
+            }
+
+            if (currHdr->clean)
+            {
+                // Indicate that this is updated so we won't use CRC in NVM; only clears a bit of the header
+                currHdr->clean = 0;
+
+                ret = SLN_Write_Flash_Page(meta->fileHeadAddr, (uint8_t *)currHdr, sizeof(sln_file_header_t));
+
+                if (kStatus_Success != ret)
+                {
+                    goto exit;
+                }
+            }
+
+            // Program only the pages holding the bytes, the rest of each page is left as it is
+            address = meta->fileHeadAddr + sizeof(sln_file_header_t) + offset;
+
+            while (0U < len)
+            {
+                pageAddr = address & ~(FLASH_PAGE_SIZE - 1U);
+                toCopy   = FLASH_PAGE_SIZE - (address - pageAddr);
+                toCopy   = (len < toCopy) ? len : toCopy;
+
+                memset(flashPage, 0xFF, FLASH_PAGE_SIZE);
+                memcpy(flashPage + (address - pageAddr), data, toCopy);
+
+                ret = SLN_Write_Flash_Page(pageAddr, flashPage, FLASH_PAGE_SIZE);
+
+                if (kStatus_Success != ret)
+                {
+                    goto exit;
+                }
+
+                address += toCopy;
+                data += toCopy;
+                len -= toCopy;
+            }
+
+            // Run crc on the file data now in flash
+            meta->fileDataAddr = SLN_Flash_Get_Read_Address(meta->fileHeadAddr + sizeof(sln_file_header_t));
+
+            ret = calc_crc_32(meta, (uint8_t *)meta->fileDataAddr, fileSize);
+
+            if (kStatus_Success != ret)
+            {
+                goto exit;
+            }
+
+            // Update ram list
+            if (NULL != s_flashCrcList)
+            {
+                s_flashCrcList[meta->flashTableIdx] = meta->crcValue;
+            }
+
+        exit:
+            vPortFree(flashMap);
+            flashMap = NULL;
+            vPortFree(currHdr);
+            currHdr = NULL;
+            vPortFree(flashPage);
+            flashPage = NULL;
+            vPortFree(meta);
+            meta = NULL;
+            xSemaphoreGive(s_fileLock);
+
+            // Outside the lock, the callback may read the file again
+            file_changed(name);
         }
     }
 
@@ -1304,6 +1483,8 @@ int32_t SLN_FLASH_MGMT_Erase(const char *name)
         s_flashMgmtCbs.post_sector_erase_cb();
     }
 
+    file_changed(name);
+
 exit:
     return ret;
 }
@@ -1374,6 +1555,7 @@ int32_t SLN_FLASH_MGMT_SetCbs(sln_flash_mgmt_cbs_t *cbs)
     {
         s_flashMgmtCbs.pre_sector_erase_cb  = cbs->pre_sector_erase_cb;
         s_flashMgmtCbs.post_sector_erase_cb = cbs->post_sector_erase_cb;
+        s_flashMgmtCbs.file_changed_cb      = cbs->file_changed_cb;
     }
 
     return ret;
@@ -114,6 +114,7 @@ typedef struct
 {
     void (*pre_sector_erase_cb)(void);  /*! Callback to be called before erasing a sector */
     void (*post_sector_erase_cb)(void); /*! Callback to be called after erasing a sector */
+    void (*file_changed_cb)(const char *name); /*! Callback to be called after a file is written or erased */
 } sln_flash_mgmt_cbs_t;
 
 #if defined(__cplusplus)
@@ -153,6 +154,21 @@ int32_t SLN_FLASH_MGMT_Save(const char *name, uint8_t *data, uint32_t len);
  */
 int32_t SLN_FLASH_MGMT_Update(const char *name, uint8_t *data, uint32_t *len);
 
+/*!
+ * @brief Program bytes of a named entry in place [can only clear bits as per nature of Flash Memory]
+ *
+ * Only the pages holding the bytes are programmed, so it is meant for bytes still erased in flash, like the
+ * unused end of a file saved with room to grow. Doesn't support encrypted files.
+ *
+ * @param name String name of entry/file to program
+ * @param offset Offset in bytes of the data in the file
+ * @param data Pointer to data to program
+ * @param len Length in bytes to program [can't go past the file size on NVM, will fail]
+ *
+ * @returns Status of program [will fail with SLN_FLASH_MGMT_ENOENTRY2 if no previous save]
+ */
+int32_t SLN_FLASH_MGMT_Program(const char *name, uint32_t offset, const uint8_t *data, uint32_t len);
+
 /*!
  * @brief Read from a named entry
  *
@@ -697,6 +697,9 @@ CK_DEFINE_FUNCTION(CK_RV, C_Finalize)(CK_VOID_PTR pvReserved)
 
         vSemaphoreDelete(xP11Context.xObjectList.xMutex);
 
+        /* Wipe the objects kept in RAM, private key included */
+        PKCS11_PAL_WipeCache();
+
         xP11Context.xIsInitialized = CK_FALSE;
     }
 
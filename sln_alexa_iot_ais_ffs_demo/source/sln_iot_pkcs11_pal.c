@@ -41,6 +41,7 @@
 #include "FreeRTOSIPConfig.h"
 #include "iot_crypto.h"
 #include "task.h"
+#include "semphr.h"
 #include "iot_pkcs11.h"
 #include "iot_pkcs11_config.h"
 
@@ -51,6 +52,7 @@
 #include "mbedtls/pk.h"
 #include "mbedtls/pk_internal.h"
 #include "mbedtls/pkcs5.h"
+#include "mbedtls/platform_util.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/x509_crt.h"
 
@@ -59,6 +61,7 @@
 #include "device_utils.h"
 
 /* C runtime includes. */
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -66,6 +69,14 @@
 #define pkcs11palFILE_NAME_KEY                   "pkey.dat"
 #define pkcs11palFILE_CODE_SIGN_PUBLIC_KEY       "FreeRTOS_P11_CodeSignKey.dat"
 
+#ifndef pkcs11configPAL_OBJECT_CACHE
+#define pkcs11configPAL_OBJECT_CACHE 0
+#endif
+
+#ifndef pkcs11configPAL_PRIVATE_CACHE_SIZE
+#define pkcs11configPAL_PRIVATE_CACHE_SIZE 2048
+#endif
+
 enum eObjectHandles
 {
     eInvalidHandle = 0, /* According to PKCS #11 spec, 0 is never a valid object handle. */
@@ -75,6 +86,51 @@ enum eObjectHandles
     eAwsCodeSigningKey
 };
 
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+
+/* Objects are cached per file, the device public and private key share pkey.dat */
+enum eCacheEntries
+{
+    eCacheCertificate = 0,
+    eCacheKey,
+    eCacheCodeSigningKey,
+    eCacheEntryCount
+};
+
+typedef enum _pal_cache_state
+{
+    kPalCacheEmpty = 0, /* Not read from flash yet, or not found */
+    kPalCachePresent    /* pucData holds the file */
+} pal_cache_state_t;
+
+typedef struct _pal_cache_entry
+{
+    const char * pcFileName;
+    CK_BBOOL xPrivate;                      /* File holds private key material */
+    pal_cache_state_t eState;
+    uint32_t ulRefs;                        /* Buffers given out and not cleaned up yet */
+    CK_BBOOL xStale;                        /* Invalidated while referenced, dropped by the last cleanup */
+    uint8_t * pucData;
+    uint32_t ulDataSize;
+    uint8_t ucDigest[ 32 ];                 /* SHA256 of pucData, checked before every reuse */
+} pal_cache_entry_t;
+
+static pal_cache_entry_t s_xCache[ eCacheEntryCount ] =
+{
+    [ eCacheCertificate ]    = { .pcFileName = pkcs11palFILE_NAME_CLIENT_CERTIFICATE, .xPrivate = CK_FALSE },
+    [ eCacheKey ]            = { .pcFileName = pkcs11palFILE_NAME_KEY, .xPrivate = CK_TRUE },
+    [ eCacheCodeSigningKey ] = { .pcFileName = pkcs11palFILE_CODE_SIGN_PUBLIC_KEY, .xPrivate = CK_FALSE },
+};
+
+/* Private key material never goes to the heap, it only lives here and is wiped on invalidation */
+static uint8_t s_ucPrivateArea[ pkcs11configPAL_PRIVATE_CACHE_SIZE + 1 ];
+static CK_BBOOL s_xPrivateAreaUsed = CK_FALSE;
+
+static SemaphoreHandle_t s_xCacheMutex = NULL;
+static StaticSemaphore_t s_xCacheMutexBuffer;
+
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
+
 /*-----------------------------------------------------------*/
 
 /* Converts a label to its respective filename and handle. */
@@ -121,6 +177,285 @@ void prvLabelToFilenameHandle( uint8_t * pcLabel,
     }
 }
 
+/* Reads a whole file in a new heap buffer, one extra zeroed byte keeps PEM data terminated. */
+static CK_RV prvReadObject( const char * pcFileName,
+                            uint8_t ** ppucData,
+                            uint32_t * pulDataSize )
+{
+    CK_RV ulReturn = CKR_OK;
+    sln_flash_mgmt_status_t ulFlashStatus = SLN_FLASH_MGMT_OK;
+
+    *ppucData = NULL;
+
+    /* Get size of file in NVM */
+    ulFlashStatus = SLN_FLASH_MGMT_Read( pcFileName, NULL, pulDataSize );
+
+    if( SLN_FLASH_MGMT_OK != ulFlashStatus )
+    {
+        ulReturn = CKR_FUNCTION_FAILED;
+    }
+
+    /* Allocate appropriate memory */
+    if( CKR_OK == ulReturn )
+    {
+        *ppucData = ( uint8_t * ) pvPortMalloc( *pulDataSize + 1 );
+
+        if( NULL == *ppucData )
+        {
+            ulReturn = CKR_FUNCTION_FAILED;
+        }
+        else
+        {
+            memset( *ppucData, 0x00, *pulDataSize + 1 );
+        }
+    }
+
+    /* Copy memory from NVM to RAM */
+    if( CKR_OK == ulReturn )
+    {
+        ulFlashStatus = SLN_FLASH_MGMT_Read( pcFileName, *ppucData, pulDataSize );
+
+        if( SLN_FLASH_MGMT_OK != ulFlashStatus )
+        {
+            ulReturn = CKR_FUNCTION_FAILED;
+        }
+    }
+
+    /* Clean-up if we failed somewhere above */
+    if( ( CKR_OK != ulReturn ) && ( NULL != *ppucData ) )
+    {
+        mbedtls_platform_zeroize( *ppucData, *pulDataSize + 1 );
+        vPortFree( *ppucData );
+        *ppucData = NULL;
+    }
+
+    return ulReturn;
+}
+
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+
+static pal_cache_entry_t * prvHandleToCacheEntry( CK_OBJECT_HANDLE xHandle )
+{
+    pal_cache_entry_t * pxEntry = NULL;
+
+    if( xHandle == eAwsDeviceCertificate )
+    {
+        pxEntry = &s_xCache[ eCacheCertificate ];
+    }
+    else if( ( xHandle == eAwsDevicePrivateKey ) || ( xHandle == eAwsDevicePublicKey ) )
+    {
+        pxEntry = &s_xCache[ eCacheKey ];
+    }
+    else if( xHandle == eAwsCodeSigningKey )
+    {
+        pxEntry = &s_xCache[ eCacheCodeSigningKey ];
+    }
+
+    return pxEntry;
+}
+
+/* Drops the cached copy, cache mutex held and no buffer given out. */
+static void prvCacheRelease( pal_cache_entry_t * pxEntry )
+{
+    if( NULL != pxEntry->pucData )
+    {
+        mbedtls_platform_zeroize( pxEntry->pucData, pxEntry->ulDataSize + 1 );
+
+        if( pxEntry->pucData == s_ucPrivateArea )
+        {
+            s_xPrivateAreaUsed = CK_FALSE;
+        }
+        else
+        {
+            vPortFree( pxEntry->pucData );
+        }
+    }
+
+    mbedtls_platform_zeroize( pxEntry->ucDigest, sizeof( pxEntry->ucDigest ) );
+    pxEntry->pucData = NULL;
+    pxEntry->ulDataSize = 0;
+    pxEntry->xStale = CK_FALSE;
+    pxEntry->eState = kPalCacheEmpty;
+}
+
+/* Drops the cached copy now, or on the last cleanup if it is in use. Cache mutex held. */
+static void prvCacheInvalidate( pal_cache_entry_t * pxEntry )
+{
+    if( pxEntry->ulRefs > 0 )
+    {
+        pxEntry->xStale = CK_TRUE;
+    }
+    else
+    {
+        prvCacheRelease( pxEntry );
+    }
+}
+
+/* Makes sure the entry reflects flash, cache mutex held. CK_FALSE if the file is not in flash. */
+static CK_BBOOL prvCacheLoad( pal_cache_entry_t * pxEntry )
+{
+    uint8_t ucDigest[ 32 ];
+    uint32_t ulDataSize = 0;
+    sln_flash_mgmt_status_t ulFlashStatus = SLN_FLASH_MGMT_OK;
+
+    /* A corrupted copy is read again, unless someone still uses it */
+    if( ( kPalCachePresent == pxEntry->eState ) && ( 0 == pxEntry->ulRefs ) )
+    {
+        if( ( 0 != mbedtls_sha256_ret( pxEntry->pucData, pxEntry->ulDataSize, ucDigest, 0 ) ) ||
+            ( 0 != memcmp( ucDigest, pxEntry->ucDigest, sizeof( ucDigest ) ) ) )
+        {
+            configPRINTF( ( "[PKCS11] Cached %s corrupted, reloading\r\n", pxEntry->pcFileName ) );
+            prvCacheRelease( pxEntry );
+        }
+    }
+
+    if( kPalCacheEmpty != pxEntry->eState )
+    {
+        return CK_TRUE;
+    }
+
+    ulFlashStatus = SLN_FLASH_MGMT_Read( pxEntry->pcFileName, NULL, &ulDataSize );
+
+    if( SLN_FLASH_MGMT_OK != ulFlashStatus )
+    {
+        /* Not remembered, the file can be provisioned at any time */
+        return CK_FALSE;
+    }
+
+    if( CK_TRUE == pxEntry->xPrivate )
+    {
+        if( ( CK_FALSE == s_xPrivateAreaUsed ) && ( ulDataSize <= pkcs11configPAL_PRIVATE_CACHE_SIZE ) )
+        {
+            s_xPrivateAreaUsed = CK_TRUE;
+            pxEntry->pucData = s_ucPrivateArea;
+            memset( pxEntry->pucData, 0x00, ulDataSize + 1 );
+        }
+    }
+    else
+    {
+        pxEntry->pucData = ( uint8_t * ) pvPortMalloc( ulDataSize + 1 );
+
+        if( NULL != pxEntry->pucData )
+        {
+            memset( pxEntry->pucData, 0x00, ulDataSize + 1 );
+        }
+    }
+
+    if( NULL == pxEntry->pucData )
+    {
+        /* Left empty, the caller falls back to an uncached read */
+        return CK_TRUE;
+    }
+
+    pxEntry->ulDataSize = ulDataSize;
+    ulFlashStatus = SLN_FLASH_MGMT_Read( pxEntry->pcFileName, pxEntry->pucData, &pxEntry->ulDataSize );
+
+    if( ( SLN_FLASH_MGMT_OK == ulFlashStatus ) &&
+        ( 0 == mbedtls_sha256_ret( pxEntry->pucData, pxEntry->ulDataSize, pxEntry->ucDigest, 0 ) ) )
+    {
+        pxEntry->eState = kPalCachePresent;
+    }
+    else
+    {
+        pxEntry->ulDataSize = ulDataSize;
+        prvCacheRelease( pxEntry );
+    }
+
+    return CK_TRUE;
+}
+
+void PKCS11_PAL_InvalidateCache( void )
+{
+    uint32_t ulIdx;
+
+    if( NULL != s_xCacheMutex )
+    {
+        xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+
+        for( ulIdx = 0; ulIdx < eCacheEntryCount; ulIdx++ )
+        {
+            prvCacheInvalidate( &s_xCache[ ulIdx ] );
+        }
+
+        xSemaphoreGive( s_xCacheMutex );
+    }
+}
+
+void PKCS11_PAL_FileChanged( const char * pcFileName )
+{
+    uint32_t ulIdx;
+
+    if( NULL != s_xCacheMutex )
+    {
+        xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+
+        for( ulIdx = 0; ulIdx < eCacheEntryCount; ulIdx++ )
+        {
+            if( 0 == strcmp( pcFileName, s_xCache[ ulIdx ].pcFileName ) )
+            {
+                prvCacheInvalidate( &s_xCache[ ulIdx ] );
+            }
+        }
+
+        xSemaphoreGive( s_xCacheMutex );
+    }
+}
+
+void PKCS11_PAL_WipeCache( void )
+{
+    uint32_t ulIdx;
+    pal_cache_entry_t * pxEntry;
+
+    if( NULL != s_xCacheMutex )
+    {
+        xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+
+        for( ulIdx = 0; ulIdx < eCacheEntryCount; ulIdx++ )
+        {
+            pxEntry = &s_xCache[ ulIdx ];
+
+            if( pxEntry->ulRefs > 0 )
+            {
+                /* Wiped under the holder, whose cleanup frees it */
+                if( NULL != pxEntry->pucData )
+                {
+                    mbedtls_platform_zeroize( pxEntry->pucData, pxEntry->ulDataSize + 1 );
+                }
+
+                mbedtls_platform_zeroize( pxEntry->ucDigest, sizeof( pxEntry->ucDigest ) );
+                pxEntry->xStale = CK_TRUE;
+            }
+            else
+            {
+                prvCacheRelease( pxEntry );
+            }
+        }
+
+        mbedtls_platform_zeroize( s_ucPrivateArea, sizeof( s_ucPrivateArea ) );
+
+        xSemaphoreGive( s_xCacheMutex );
+    }
+}
+
+#else
+
+void PKCS11_PAL_InvalidateCache( void )
+{
+}
+
+void PKCS11_PAL_FileChanged( const char * pcFileName )
+{
+    ( void ) pcFileName;
+}
+
+void PKCS11_PAL_WipeCache( void )
+{
+}
+
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
+
+/*-----------------------------------------------------------*/
+
 void PKCS11_KeyGen(char **keyPhrase)
 {
     mbedtls_md_context_t mdCtx;
@@ -234,6 +569,16 @@ CK_OBJECT_HANDLE PKCS11_PAL_SaveObject( CK_ATTRIBUTE_PTR pxLabel,
             xHandle = eInvalidHandle;
         }
 #endif
+
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+        /* The cached copy no longer matches the storage */
+        if( NULL != s_xCacheMutex )
+        {
+            xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+            prvCacheInvalidate( prvHandleToCacheEntry( xHandle ) );
+            xSemaphoreGive( s_xCacheMutex );
+        }
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
     }
 
     return xHandle;
@@ -259,12 +604,36 @@ CK_OBJECT_HANDLE PKCS11_PAL_FindObject( uint8_t * pLabel,
 {
     CK_OBJECT_HANDLE xHandle = eInvalidHandle;
     char * pcFileName = NULL;
+    bool bExists = false;
 
     /* Translate from the PKCS#11 label to local storage file name. */
     prvLabelToFilenameHandle( pLabel, &pcFileName, &xHandle );
 
-    /*TODO: check if file actually there.
-     * Note: g_cert_files only seems to check if the entry in the array is present */
+    /* Check that the file is actually there */
+    if( xHandle != eInvalidHandle )
+    {
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+        if( NULL != s_xCacheMutex )
+        {
+            pal_cache_entry_t * pxEntry = prvHandleToCacheEntry( xHandle );
+
+            /* The object is usually read right after, so it is loaded now */
+            xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+            bExists = ( CK_TRUE == prvCacheLoad( pxEntry ) );
+            xSemaphoreGive( s_xCacheMutex );
+        }
+        else
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
+        {
+            uint32_t ulDataSize = 0;
+            bExists = ( SLN_FLASH_MGMT_OK == SLN_FLASH_MGMT_Read( pcFileName, NULL, &ulDataSize ) );
+        }
+
+        if( !bExists )
+        {
+            xHandle = eInvalidHandle;
+        }
+    }
 
     return xHandle;
 }
@@ -302,7 +671,7 @@ CK_RV PKCS11_PAL_GetObjectValue( CK_OBJECT_HANDLE xHandle,
 {
     char * pcFileName = NULL;
     CK_RV ulReturn = CKR_OK;
-    sln_flash_mgmt_status_t ulFlashStatus = SLN_FLASH_MGMT_OK;
+    bool bCached = false;
 
     if( xHandle == eAwsDeviceCertificate )
     {
@@ -330,54 +699,34 @@ CK_RV PKCS11_PAL_GetObjectValue( CK_OBJECT_HANDLE xHandle,
         ulReturn = CKR_KEY_HANDLE_INVALID;
     }
 
-    /* Get size of file in NVM */
-    if (CKR_OK == ulReturn)
-	{
-    	ulFlashStatus = SLN_FLASH_MGMT_Read(pcFileName, NULL, pulDataSize);
-
-    	if (SLN_FLASH_MGMT_OK != ulFlashStatus)
-    	{
-    		ulReturn = CKR_FUNCTION_FAILED;
-    	}
-	}
-
-    /* Allocate appropriate memory */
-    if (CKR_OK == ulReturn)
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+    if( ( CKR_OK == ulReturn ) && ( NULL != s_xCacheMutex ) )
     {
-    	/* We will de-allocate and clean-up in PKCS11_PAL_GetObjectValueCleanup */
-    	*ppucData = (uint8_t *)pvPortMalloc(*pulDataSize + 1);
+        pal_cache_entry_t * pxEntry = prvHandleToCacheEntry( xHandle );
 
-        if (NULL == *ppucData)
+        xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+
+        if( CK_FALSE == prvCacheLoad( pxEntry ) )
         {
-        	ulReturn = CKR_FUNCTION_FAILED;
+            ulReturn = CKR_FUNCTION_FAILED;
         }
-        else
+        else if( ( kPalCachePresent == pxEntry->eState ) && ( CK_FALSE == pxEntry->xStale ) )
         {
-        	/* Wipe out memory here */
-        	memset(*ppucData, 0x00, *pulDataSize);
+            /* Shared with other readers, handed back by PKCS11_PAL_GetObjectValueCleanup */
+            pxEntry->ulRefs++;
+            *ppucData = pxEntry->pucData;
+            *pulDataSize = pxEntry->ulDataSize;
+            bCached = true;
         }
-    }
 
-    /* Copy memory from NVM to RAM */
-    if (CKR_OK == ulReturn)
-	{
-    	ulFlashStatus = SLN_FLASH_MGMT_Read(pcFileName, *ppucData, pulDataSize);
-
-    	if (SLN_FLASH_MGMT_OK != ulFlashStatus)
-    	{
-    		ulReturn = CKR_FUNCTION_FAILED;
-    	}
-	}
+        xSemaphoreGive( s_xCacheMutex );
+    }
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
 
-    /* Clean-up if we failed somewhere above */
-    if (CKR_FUNCTION_FAILED == ulReturn)
+    /* Not cacheable right now, read a private copy */
+    if( ( CKR_OK == ulReturn ) && !bCached )
     {
-    	if (NULL != *ppucData)
-    	{
-    		memset(*ppucData, 0x00, *pulDataSize);
-    	}
-    	vPortFree(*ppucData);
-    	*ppucData = NULL;
+        ulReturn = prvReadObject( pcFileName, ppucData, pulDataSize );
     }
 
     return ulReturn;
@@ -394,10 +743,39 @@ CK_RV PKCS11_PAL_GetObjectValue( CK_OBJECT_HANDLE xHandle,
 void PKCS11_PAL_GetObjectValueCleanup( uint8_t * pucData,
                                        uint32_t ulDataSize )
 {
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+    uint32_t ulIdx;
+
+    if( ( NULL != pucData ) && ( NULL != s_xCacheMutex ) )
+    {
+        xSemaphoreTake( s_xCacheMutex, portMAX_DELAY );
+
+        for( ulIdx = 0; ulIdx < eCacheEntryCount; ulIdx++ )
+        {
+            pal_cache_entry_t * pxEntry = &s_xCache[ ulIdx ];
+
+            if( ( pucData == pxEntry->pucData ) && ( pxEntry->ulRefs > 0 ) )
+            {
+                /* Cached buffer stays for the next reader */
+                pxEntry->ulRefs--;
+
+                if( ( 0 == pxEntry->ulRefs ) && ( CK_TRUE == pxEntry->xStale ) )
+                {
+                    prvCacheRelease( pxEntry );
+                }
+
+                pucData = NULL;
+                break;
+            }
+        }
+
+        xSemaphoreGive( s_xCacheMutex );
+    }
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
 
 	if (NULL != pucData)
 	{
-		memset(pucData, 0x00, ulDataSize);
+		mbedtls_platform_zeroize(pucData, ulDataSize);
 	}
 	vPortFree(pucData);
 	pucData = NULL;
@@ -429,6 +807,13 @@ CK_DEFINE_FUNCTION( CK_RV, C_Initialize )( CK_VOID_PTR pvInitArgs )
 
     CK_RV xResult = CKR_OK;
 
+#if ( pkcs11configPAL_OBJECT_CACHE == 1 )
+    if( NULL == s_xCacheMutex )
+    {
+        s_xCacheMutex = xSemaphoreCreateMutexStatic( &s_xCacheMutexBuffer );
+    }
+#endif /* pkcs11configPAL_OBJECT_CACHE == 1 */
+
 #if 0
     if( !mflash_is_initialized() )
     {
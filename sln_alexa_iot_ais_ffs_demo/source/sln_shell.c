@@ -16,6 +16,7 @@
 #include "sln_flash_mgmt.h"
 #include "sln_cfg_file.h"
 #include "perf.h"
+#include "dhcp_server.h"
 
 #ifdef FFS_ENABLED
 #include "ffs_provision_cli.h"
@@ -67,6 +68,16 @@ static shell_status_t sln_version_handler(shell_handle_t shellHandle, int32_t ar
 static shell_status_t sln_ww_model_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
 static shell_status_t sln_heap_view_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
 static shell_status_t sln_tasks_stack_view_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+static shell_status_t sln_dhcp_leases_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#if (configUSE_TICKLESS_IDLE == 1)
+static shell_status_t sln_tickless_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+#if (configUSE_HEAP_SLAB == 1)
+static shell_status_t sln_slab_view_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#endif /* configUSE_HEAP_SLAB == 1 */
+#if (configUSE_HEAP_TRACKER == 1)
+static shell_status_t sln_heap_profile_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
+#endif /* configUSE_HEAP_TRACKER == 1 */
 #ifdef SLN_TRACE_CPU_USAGE
 static shell_status_t sln_trace_cpu_usage_handler(shell_handle_t shellHandle, int32_t argc, char **argv);
 #endif /* SLN_TRACE_CPU_USAGE */
@@ -171,6 +182,32 @@ SHELL_COMMAND_DEFINE(stacks_view,
                      "\r\n\"stacks_view\": Print FreeRTOS stacks consumptions\r\n",
                      sln_tasks_stack_view_handler,
                      0);
+SHELL_COMMAND_DEFINE(dhcp_leases,
+                     "\r\n\"dhcp_leases\": Print the leases of the AP mode DHCP server\r\n",
+                     sln_dhcp_leases_handler,
+                     0);
+#if (configUSE_TICKLESS_IDLE == 1)
+SHELL_COMMAND_DEFINE(tickless,
+                     "\r\n\"tickless\": Print the tickless idle counters\r\n",
+                     sln_tickless_handler,
+                     0);
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
+#if (configUSE_HEAP_SLAB == 1)
+SHELL_COMMAND_DEFINE(slab_view,
+                     "\r\n\"slab_view\": Print the usage of the heap slab classes\r\n",
+                     sln_slab_view_handler,
+                     0);
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+#if (configUSE_HEAP_TRACKER == 1)
+SHELL_COMMAND_DEFINE(heap_profile,
+                     "\r\n\"heap_profile\": Print the heap call sites and fragmentation\r\n"
+                     "         Usage:\r\n"
+                     "             heap_profile [summary/export]\r\n",
+                     sln_heap_profile_handler,
+                     SHELL_IGNORE_PARAMETER_COUNT);
+#endif /* configUSE_HEAP_TRACKER == 1 */
 
 #ifdef SLN_TRACE_CPU_USAGE
 SHELL_COMMAND_DEFINE(cpu_view, "\r\n\"cpu_view\": Print the CPU usage info\r\n", sln_trace_cpu_usage_handler, 0);
@@ -213,6 +250,9 @@ static wifi_cred_t s_wifi_cred;
 #endif
 
 static ww_model_cmd_t ww_model_cmd;
+#if (configUSE_HEAP_TRACKER == 1)
+static bool s_heap_profile_export;
+#endif /* configUSE_HEAP_TRACKER == 1 */
 
 static TaskHandle_t s_appInitTask;
 static shell_heap_trace_t s_heap_trace;
@@ -520,6 +560,58 @@ static shell_status_t sln_tasks_stack_view_handler(shell_handle_t shellHandle, i
     return kStatus_SHELL_Success;
 }
 
+static shell_status_t sln_dhcp_leases_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBitsFromISR(s_ShellEventGroup, DHCP_LEASES_EVT, &xHigherPriorityTaskWoken);
+    return kStatus_SHELL_Success;
+}
+
+#if (configUSE_TICKLESS_IDLE == 1)
+static shell_status_t sln_tickless_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBitsFromISR(s_ShellEventGroup, TICKLESS_EVT, &xHigherPriorityTaskWoken);
+    return kStatus_SHELL_Success;
+}
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
+#if (configUSE_HEAP_SLAB == 1)
+static shell_status_t sln_slab_view_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBitsFromISR(s_ShellEventGroup, SLAB_VIEW_EVT, &xHigherPriorityTaskWoken);
+
+    return kStatus_SHELL_Success;
+}
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+#if (configUSE_HEAP_TRACKER == 1)
+static shell_status_t sln_heap_profile_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
+{
+    if (argc == 1 || (argc == 2 && 0 == strcmp(argv[1], "summary")))
+    {
+        s_heap_profile_export = false;
+    }
+    else if (argc == 2 && 0 == strcmp(argv[1], "export"))
+    {
+        s_heap_profile_export = true;
+    }
+    else
+    {
+        SHELL_Printf(
+            s_shellHandle,
+            "\r\nIncorrect command parameter(s).  Enter \"help\" to view a list of available commands.\r\n\r\n");
+        return kStatus_SHELL_Error;
+    }
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    xEventGroupSetBitsFromISR(s_ShellEventGroup, HEAP_PROFILE_EVT, &xHigherPriorityTaskWoken);
+
+    return kStatus_SHELL_Success;
+}
+#endif /* configUSE_HEAP_TRACKER == 1 */
+
 #ifdef SLN_TRACE_CPU_USAGE
 static shell_status_t sln_trace_cpu_usage_handler(shell_handle_t shellHandle, int32_t argc, char **argv)
 {
@@ -623,6 +715,16 @@ int sln_shell_init(void)
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(ww_model));
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(heap_view));
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(stacks_view));
+    SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(dhcp_leases));
+#if (configUSE_TICKLESS_IDLE == 1)
+    SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(tickless));
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+#if (configUSE_HEAP_SLAB == 1)
+    SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(slab_view));
+#endif /* configUSE_HEAP_SLAB == 1 */
+#if (configUSE_HEAP_TRACKER == 1)
+    SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(heap_profile));
+#endif /* configUSE_HEAP_TRACKER == 1 */
 #ifdef SLN_TRACE_CPU_USAGE
     SHELL_RegisterCommand(s_shellHandle, SHELL_COMMAND(cpu_view));
 #endif /* SLN_TRACE_CPU_USAGE */
@@ -944,6 +1046,47 @@ void sln_shell_task(void *arg)
             PERF_PrintStacks();
         }
 
+        if (shellEvents & DHCP_LEASES_EVT)
+        {
+            static const char *leaseStates[] = {"free", "offered", "bound", "declined"};
+            static dhcp_server_lease_t leases[DHCP_SERVER_MAX_LEASES];
+            uint32_t count = dhcp_server_get_leases(leases, DHCP_SERVER_MAX_LEASES);
+            TickType_t now = xTaskGetTickCount();
+
+            SHELL_Printf(s_shellHandle, "\r\nAddress          MAC                State     Expires in (s)\r\n");
+            for (uint32_t i = 0; i < count; i++)
+            {
+                int32_t left = (int32_t)(leases[i].expiry_tick - now);
+
+                SHELL_Printf(s_shellHandle, "%3u.%3u.%3u.%3u  %02X:%02X:%02X:%02X:%02X:%02X  %-8s  %d\r\n",
+                             leases[i].ip_addr[0], leases[i].ip_addr[1], leases[i].ip_addr[2], leases[i].ip_addr[3],
+                             leases[i].mac[0], leases[i].mac[1], leases[i].mac[2], leases[i].mac[3], leases[i].mac[4],
+                             leases[i].mac[5], leaseStates[leases[i].state & 0x3],
+                             ((leases[i].state == DHCP_LEASE_FREE) || (left < 0)) ? 0 : (int)(left / configTICK_RATE_HZ));
+            }
+        }
+
+#if (configUSE_TICKLESS_IDLE == 1)
+        if (shellEvents & TICKLESS_EVT)
+        {
+            PERF_PrintTickless();
+        }
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
+#if (configUSE_HEAP_SLAB == 1)
+        if (shellEvents & SLAB_VIEW_EVT)
+        {
+            PERF_PrintSlabs();
+        }
+#endif /* configUSE_HEAP_SLAB == 1 */
+
+#if (configUSE_HEAP_TRACKER == 1)
+        if (shellEvents & HEAP_PROFILE_EVT)
+        {
+            PERF_PrintHeapProfile(s_heap_profile_export);
+        }
+#endif /* configUSE_HEAP_TRACKER == 1 */
+
 #ifdef SLN_TRACE_CPU_USAGE
         if (shellEvents & TRACE_CPU_USAGE_EVT)
         {
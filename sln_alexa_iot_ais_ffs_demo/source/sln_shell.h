@@ -74,7 +74,9 @@ typedef enum __shell_event
     DIS_USB_LOG_EVT    = (1 << 9U),
     LOGS_EVT           = (1 << 10U),
     SERIAL_NUMBER_EVT  = (1 << 11U),
-    /* 1 << 12 free here */
+#if (configUSE_HEAP_SLAB == 1)
+    SLAB_VIEW_EVT = (1 << 12U),
+#endif /* configUSE_HEAP_SLAB == 1 */
     FAULTLOG_STATUSGET_EVT   = (1 << 13U),
     FAULTLOG_STATUSERASE_EVT = (1 << 14U),
     VERSION_EVT              = (1 << 15U),
@@ -87,6 +89,13 @@ typedef enum __shell_event
 #ifdef FFS_ENABLED
     FFS_PROVISION_EVT = (1 << 20U),
 #endif /* FFS_ENABLED */
+#if (configUSE_HEAP_TRACKER == 1)
+    HEAP_PROFILE_EVT = (1 << 21U),
+#endif /* configUSE_HEAP_TRACKER == 1 */
+    DHCP_LEASES_EVT = (1 << 22U),
+#if (configUSE_TICKLESS_IDLE == 1)
+    TICKLESS_EVT = (1 << 23U),
+#endif /* configUSE_TICKLESS_IDLE == 1 */
 } shell_event_t;
 
 typedef struct __shell_heap_trace
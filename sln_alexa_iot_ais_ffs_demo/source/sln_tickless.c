@@ -0,0 +1,236 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include "sln_tickless.h"
+
+#include "task.h"
+
+#include "fsl_common.h"
+#include "fsl_gpt.h"
+
+#if (configUSE_TICKLESS_IDLE == 1)
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define TICKLESS_GPT_FREQ_HZ 1000000U
+#define TICKLESS_US_PER_TICK (TICKLESS_GPT_FREQ_HZ / configTICK_RATE_HZ)
+
+/* Keep the wakeup compare value within half of the 32 bits counter range */
+#define TICKLESS_MAX_SUPPRESSED_TICKS ((0x7FFFFFFFU / TICKLESS_US_PER_TICK) - 1U)
+
+/* A periodic interrupt not seen for this many periods is considered stopped */
+#define TICKLESS_PERIODIC_TIMEOUT 2U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* GPT count of the next tick, the output compare always points to it outside of the idle window */
+static volatile uint32_t s_nextTick;
+
+/* Last completion and period of each periodic interrupt reported by SLN_TICKLESS_PeriodicIrqDone */
+static volatile uint32_t s_periodicLast[kSLN_TICKLESS_PeriodicCount];
+static volatile uint32_t s_periodicUs[kSLN_TICKLESS_PeriodicCount];
+
+static sln_tickless_stats_t s_stats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static inline uint32_t TICKLESS_Now(void)
+{
+    return GPT_GetCurrentTimerCount(SLN_TICKLESS_GPT);
+}
+
+/* The output compare only fires on equality, pend the interrupt if the counter is already past it */
+static void TICKLESS_ArmCompare(uint32_t count)
+{
+    GPT_SetOutputCompareValue(SLN_TICKLESS_GPT, kGPT_OutputCompare_Channel1, count);
+
+    if ((int32_t)(TICKLESS_Now() - count) >= 0)
+    {
+        NVIC_SetPendingIRQ(SLN_TICKLESS_GPT_IRQn);
+    }
+}
+
+/* Microseconds until the next periodic interrupt, UINT32_MAX if none is running */
+static uint32_t TICKLESS_PeriodicBudget(uint32_t now)
+{
+    uint32_t budgetUs = UINT32_MAX;
+    uint32_t periodUs;
+    uint32_t elapsed;
+    uint32_t source;
+
+    for (source = 0; source < kSLN_TICKLESS_PeriodicCount; source++)
+    {
+        periodUs = s_periodicUs[source];
+        elapsed  = now - s_periodicLast[source];
+
+        if ((0 != periodUs) && (elapsed < (TICKLESS_PERIODIC_TIMEOUT * periodUs)))
+        {
+            budgetUs = MIN(budgetUs, periodUs - (elapsed % periodUs));
+        }
+    }
+
+    return budgetUs;
+}
+
+/* Replaces the SysTick setup of port.c */
+void vPortSetupTimerInterrupt(void)
+{
+    gpt_config_t gpt;
+
+    /* Same PERCLK setup as the other GPT and PIT users: 24 MHz from the oscillator */
+    CLOCK_SetMux(kCLOCK_PerclkMux, 1U);
+    CLOCK_SetDiv(kCLOCK_PerclkDiv, 0U);
+
+    GPT_GetDefaultConfig(&gpt);
+    gpt.enableFreeRun = true;
+    gpt.divider       = CLOCK_GetFreq(kCLOCK_OscClk) / TICKLESS_GPT_FREQ_HZ;
+    GPT_Init(SLN_TICKLESS_GPT, &gpt);
+
+    s_nextTick = TICKLESS_US_PER_TICK;
+    GPT_SetOutputCompareValue(SLN_TICKLESS_GPT, kGPT_OutputCompare_Channel1, s_nextTick);
+    GPT_EnableInterrupts(SLN_TICKLESS_GPT, kGPT_OutputCompare1InterruptEnable);
+
+    NVIC_SetPriority(SLN_TICKLESS_GPT_IRQn, configLIBRARY_LOWEST_INTERRUPT_PRIORITY);
+    EnableIRQ(SLN_TICKLESS_GPT_IRQn);
+
+    GPT_StartTimer(SLN_TICKLESS_GPT);
+}
+
+void SLN_TICKLESS_GPT_HANDLER(void)
+{
+    BaseType_t switchRequired = pdFALSE;
+    uint32_t savedMask;
+
+    GPT_ClearStatusFlags(SLN_TICKLESS_GPT, kGPT_OutputCompare1Flag);
+
+    savedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+
+    /* Catch up on every tick boundary crossed, the interrupt may have been masked for a while */
+    while ((int32_t)(TICKLESS_Now() - s_nextTick) >= 0)
+    {
+        s_nextTick += TICKLESS_US_PER_TICK;
+
+        if (xTaskIncrementTick() != pdFALSE)
+        {
+            switchRequired = pdTRUE;
+        }
+    }
+
+    TICKLESS_ArmCompare(s_nextTick);
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(savedMask);
+
+    portYIELD_FROM_ISR(switchRequired);
+    SDK_ISR_EXIT_BARRIER;
+}
+
+/* Replaces the SysTick based implementation of port.c */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+    TickType_t modifiableIdleTime;
+    TickType_t crossedTicks;
+    uint32_t sleepStart;
+    uint32_t wakeAt;
+    uint32_t windowUs;
+    uint32_t budgetUs;
+    uint32_t now;
+
+    if (xExpectedIdleTime > TICKLESS_MAX_SUPPRESSED_TICKS)
+    {
+        xExpectedIdleTime = TICKLESS_MAX_SUPPRESSED_TICKS;
+    }
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        __enable_irq();
+        return;
+    }
+
+    /* The kernel runs again on the tick xExpectedIdleTime from now, which accounts for the software
+     * timers through the timer task, the audio DMA wakes the core on its own in between */
+    sleepStart = TICKLESS_Now();
+    wakeAt     = s_nextTick + ((xExpectedIdleTime - 1U) * TICKLESS_US_PER_TICK);
+    windowUs   = ((int32_t)(wakeAt - sleepStart) > 0) ? (wakeAt - sleepStart) : 0U;
+    budgetUs   = MIN(windowUs, TICKLESS_PeriodicBudget(sleepStart));
+
+    if (budgetUs < SLN_TICKLESS_MIN_SLEEP_US)
+    {
+        /* Not worth reprogramming the timer, wait for the next tick or interrupt */
+        s_stats.skipped++;
+        __DSB();
+        __WFI();
+        __ISB();
+        __enable_irq();
+        return;
+    }
+
+    GPT_SetOutputCompareValue(SLN_TICKLESS_GPT, kGPT_OutputCompare_Channel1, wakeAt);
+
+    modifiableIdleTime = xExpectedIdleTime;
+    configPRE_SLEEP_PROCESSING(modifiableIdleTime);
+    if (modifiableIdleTime > 0)
+    {
+        __DSB();
+        __WFI();
+        __ISB();
+    }
+    configPOST_SLEEP_PROCESSING(xExpectedIdleTime);
+
+    /* The ticks are accounted for below, drop the compare event of the wakeup */
+    now = TICKLESS_Now();
+    GPT_ClearStatusFlags(SLN_TICKLESS_GPT, kGPT_OutputCompare1Flag);
+    NVIC_ClearPendingIRQ(SLN_TICKLESS_GPT_IRQn);
+
+    s_stats.sleeps++;
+    s_stats.sleepUs += now - sleepStart;
+    if ((int32_t)(now - wakeAt) < 0)
+    {
+        s_stats.earlyWakes++;
+    }
+
+    if ((int32_t)(now - s_nextTick) >= 0)
+    {
+        crossedTicks = ((now - s_nextTick) / TICKLESS_US_PER_TICK) + 1U;
+
+        /* Leave the last tick to the interrupt so that xTaskIncrementTick unblocks the waiting task */
+        crossedTicks = MIN(crossedTicks, xExpectedIdleTime) - 1U;
+        s_nextTick += crossedTicks * TICKLESS_US_PER_TICK;
+        vTaskStepTick(crossedTicks);
+        s_stats.ticksSuppressed += crossedTicks;
+    }
+
+    TICKLESS_ArmCompare(s_nextTick);
+
+    __enable_irq();
+}
+
+void SLN_TICKLESS_PeriodicIrqDone(sln_tickless_periodic_t source, uint32_t periodUs)
+{
+    s_periodicLast[source] = TICKLESS_Now();
+    s_periodicUs[source]   = periodUs;
+}
+
+void SLN_TICKLESS_GetStats(sln_tickless_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = s_stats;
+    taskEXIT_CRITICAL();
+}
+
+#endif /* configUSE_TICKLESS_IDLE == 1 */
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef SLN_TICKLESS_H_
+#define SLN_TICKLESS_H_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+/*
+ * With configUSE_TICKLESS_IDLE set to 1, the RTOS tick comes from a GPT output compare running at
+ * 1 MHz from the 24 MHz oscillator instead of the SysTick. The tick rate stays exact when
+ * BOARD_BoostClock / BOARD_RevertClock switch the ARM PLL, and the idle task stops the tick until
+ * the next task or software timer deadline. The core only executes WFI: the PLLs and the boost state
+ * are left as they are, so a wake word detected on the next audio block is processed at full speed.
+ */
+
+/*! @brief GPT instance and interrupt used for the RTOS tick */
+#define SLN_TICKLESS_GPT         GPT1
+#define SLN_TICKLESS_GPT_IRQn    GPT1_IRQn
+#define SLN_TICKLESS_GPT_HANDLER GPT1_IRQHandler
+
+/*! @brief Shortest idle window worth stopping the tick for, in microseconds */
+#ifndef SLN_TICKLESS_MIN_SLEEP_US
+#define SLN_TICKLESS_MIN_SLEEP_US 2000U
+#endif
+
+/*! @brief Periodic interrupts reported by SLN_TICKLESS_PeriodicIrqDone */
+typedef enum _sln_tickless_periodic
+{
+    kSLN_TICKLESS_Microphones, /* PDM microphone DMA, one per audio block */
+    kSLN_TICKLESS_Amplifier,   /* Amplifier SAI TX DMA, one per chunk while playing */
+    kSLN_TICKLESS_PeriodicCount,
+} sln_tickless_periodic_t;
+
+typedef struct _sln_tickless_stats
+{
+    uint32_t sleeps;          /* idle windows with the tick stopped */
+    uint32_t skipped;         /* idle windows shorter than SLN_TICKLESS_MIN_SLEEP_US */
+    uint32_t earlyWakes;      /* windows ended by another interrupt before the deadline */
+    uint32_t ticksSuppressed; /* tick interrupts saved */
+    uint64_t sleepUs;         /* time spent in WFI with the tick stopped */
+} sln_tickless_stats_t;
+
+#if (configUSE_TICKLESS_IDLE == 1)
+
+/**
+ * @brief Record the completion of a periodic interrupt, such as the microphone DMA.
+ *        Must be called from the interrupt, or from a critical section when the transfer starts.
+ *        The tick is not stopped when one of the sources is due sooner than
+ *        SLN_TICKLESS_MIN_SLEEP_US from now.
+ *
+ * @param source[in]              Interrupt completed.
+ * @param periodUs[in]            Time to its next completion in microseconds, 0 once it stopped.
+ * @return                        Void.
+ */
+void SLN_TICKLESS_PeriodicIrqDone(sln_tickless_periodic_t source, uint32_t periodUs);
+
+/**
+ * @brief Copy the tickless idle counters.
+ *
+ * @param stats[out]              Counters since boot.
+ * @return                        Void.
+ */
+void SLN_TICKLESS_GetStats(sln_tickless_stats_t *stats);
+
+#else
+
+#define SLN_TICKLESS_PeriodicIrqDone(source, periodUs)
+
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
+#endif /* SLN_TICKLESS_H_ */
@@ -9,28 +9,182 @@
 
 #include "osa_common.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include "board.h"
 #include "pdm_pcm_definitions.h"
 #include "sln_amplifier.h"
 #include "streamer_pcm.h"
 
+/* Carried over tails. A tail is copied into the next slot before a block is taken for it, so the ring
+ * has one slot more than there are blocks: the slot refilled was queued SAI_XFER_QUEUE_SIZE blocks ago
+ * and has been played already */
+#define STREAMER_PCM_CARRY_SLOTS (SAI_XFER_QUEUE_SIZE + 1U)
+
 pcm_rtos_t pcmHandle = {0};
 
+__attribute__((section(".ocram_non_cacheable_bss"), aligned(4)))
+static uint8_t s_carryBuffers[STREAMER_PCM_CARRY_SLOTS][STREAMER_PCM_DMA_ALIGN];
+
+/*! @brief Play time of size bytes in the output format, rounded up */
+static uint32_t streamer_pcm_duration_ms(pcm_rtos_t *pcm, uint32_t size)
+{
+    uint32_t sample_rate = 0;
+    uint32_t bit_width   = 0;
+    uint8_t num_channels = 0;
+    uint32_t bytesPerMs  = 0;
+
+    streamer_pcm_getparams(pcm, &sample_rate, &bit_width, &num_channels);
+    bytesPerMs = (sample_rate / 1000U) * (bit_width / 8U) * num_channels;
+
+    return (size + bytesPerMs - 1U) / bytesPerMs;
+}
+
+/*! @brief Marks every block as free, once the amplifier queue was dropped or emptied */
+static void streamer_pcm_reset_blocks(pcm_rtos_t *pcm)
+{
+    while (uxSemaphoreGetCount(pcm->freeBlocks) < pcm->numBlocks)
+    {
+        xSemaphoreGive(pcm->freeBlocks);
+    }
+
+    pcm->emptyBlock = pcm->numBlocks;
+}
+
+/*!
+ * @brief Waits for a free block
+ *
+ * The oldest queued block is the one playing, so a block frees up within the duration of the longest
+ * block written. If it does not, the SAI DMA stalled and is cleaned - VOIS-890.
+ */
+static int streamer_pcm_take_block(pcm_rtos_t *pcm)
+{
+    TickType_t start = 0;
+    uint32_t waitMs  = 0;
+
+    if (xSemaphoreTake(pcm->freeBlocks, 0) == pdTRUE)
+    {
+        return 0;
+    }
+
+    pcm->waits++;
+    start = xTaskGetTickCount();
+
+    if (xSemaphoreTake(pcm->freeBlocks, pdMS_TO_TICKS(pcm->blockMaxMs + STREAMER_PCM_STALL_MARGIN_MSEC)) == pdTRUE)
+    {
+        waitMs = (xTaskGetTickCount() - start) * portTICK_PERIOD_MS;
+        if (waitMs > pcm->maxWaitMs)
+        {
+            pcm->maxWaitMs = waitMs;
+        }
+        return 0;
+    }
+
+    pcm->stalls++;
+    configPRINTF(("SAI DMA stalled, no block played in %d ms, stalls=%d\r\n",
+                  pcm->blockMaxMs + STREAMER_PCM_STALL_MARGIN_MSEC, pcm->stalls));
+    streamer_pcm_clean(pcm);
+
+    return (xSemaphoreTake(pcm->freeBlocks, 0) == pdTRUE) ? 0 : 1;
+}
+
+/*! @brief Takes the blocks of a write, all of them or none */
+static int streamer_pcm_take_blocks(pcm_rtos_t *pcm, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (streamer_pcm_take_block(pcm) != 0)
+        {
+            /* After a stall the clean marked every block as free already, the extra gives fail */
+            while (i--)
+            {
+                xSemaphoreGive(pcm->freeBlocks);
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*! @brief Queues one block for the amplifier, size is a multiple of STREAMER_PCM_DMA_ALIGN. The block was taken
+ * already, on failure it is given back. */
+static int streamer_pcm_submit(pcm_rtos_t *pcm, uint8_t *data, uint32_t size)
+{
+    status_t ret;
+    uint32_t durationMs = 0;
+
+    /* The TX interrupt increments the pool once the block was played */
+    taskENTER_CRITICAL();
+    pcm->emptyBlock--;
+    taskEXIT_CRITICAL();
+
+    pcm->saiTx.dataSize = size;
+    pcm->saiTx.data     = data;
+
+    ret = SLN_AMP_WriteNoWait(pcm->saiTx.data, pcm->saiTx.dataSize);
+    if (ret != kStatus_Success)
+    {
+        taskENTER_CRITICAL();
+        pcm->emptyBlock++;
+        taskEXIT_CRITICAL();
+        xSemaphoreGive(pcm->freeBlocks);
+
+        configPRINTF(("pcm_write failed, sai_error=%d, emptyBlocks=%d\r\n", ret, pcm->emptyBlock));
+        return 1;
+    }
+
+    durationMs = streamer_pcm_duration_ms(pcm, size);
+    if (durationMs > pcm->blockMaxMs)
+    {
+        pcm->blockMaxMs = durationMs;
+    }
+
+    return 0;
+}
+
+/*! @brief Queues the carry slot, once full or padded with silence. On failure the samples stay in the slot. */
+static int streamer_pcm_submit_carry(pcm_rtos_t *pcm)
+{
+    if (streamer_pcm_submit(pcm, s_carryBuffers[pcm->carrySlot], STREAMER_PCM_DMA_ALIGN) != 0)
+    {
+        return 1;
+    }
+
+    pcm->carryLen  = 0;
+    pcm->carrySlot = (pcm->carrySlot + 1) % STREAMER_PCM_CARRY_SLOTS;
+
+    return 0;
+}
+
 void streamer_pcm_init(void)
 {
     amplifier_status_t ret;
+
+    pcmHandle.freeBlocks = xSemaphoreCreateCounting(SAI_XFER_QUEUE_SIZE, SAI_XFER_QUEUE_SIZE);
+    if (pcmHandle.freeBlocks == NULL)
+    {
+        configPRINTF(("Failed to create the PCM block semaphore!\r\n"));
+    }
+
     ret = SLN_AMP_Init(&pcmHandle.emptyBlock);
     if (ret != kStatus_Success)
     {
         configPRINTF(("SLN_AMP_Init failed!\r\n"));
     }
+
+    SLN_AMP_SetBufferPoolSemaphore(pcmHandle.freeBlocks);
 }
 
 pcm_rtos_t *streamer_pcm_open(uint32_t num_buffers)
 {
     assert(num_buffers == SAI_XFER_QUEUE_SIZE);
 
-    pcmHandle.emptyBlock = pcmHandle.numBlocks = num_buffers;
+    pcmHandle.numBlocks  = num_buffers;
+    pcmHandle.carryLen   = 0;
+    pcmHandle.blockMaxMs = 0;
+    streamer_pcm_reset_blocks(&pcmHandle);
 
     return &pcmHandle;
 }
@@ -43,74 +197,128 @@ void streamer_pcm_start(pcm_rtos_t *pcm)
 
 void streamer_pcm_clean(pcm_rtos_t *pcm)
 {
-    /* Stop playback. This will flush the SAI transmit buffers. */
-    SAI_TransferTerminateSendEDMA(BOARD_AMP_SAI, SLN_AMP_GetAmpTxHandler());
+    /* Stop playback. This will flush the SAI transmit buffers and the amplifier write queue. */
+    SLN_AMP_Abort();
 
-    configPRINTF(("SAI DMA transfer aborted, emptyBlock=%d\r\n", pcm->emptyBlock));
+    configPRINTF(("SAI DMA transfer aborted, emptyBlock=%d, waits=%d, maxWaitMs=%d\r\n", pcm->emptyBlock,
+                  pcm->waits, pcm->maxWaitMs));
 
-    /* Reset block index */
-    pcm->emptyBlock = pcm->numBlocks;
+    /* The dropped blocks never reach the TX interrupt */
+    streamer_pcm_reset_blocks(pcm);
 }
 
 void streamer_pcm_close(pcm_rtos_t *pcm)
 {
-    uint8_t waitLoop = STREAMER_PCM_CLOSE_TIMEOUT_MSEC;
-    /* Wait (up to 100ms) until the queue is emptied. */
-    while ((pcm->emptyBlock < pcm->numBlocks) && (waitLoop > 0))
+    uint32_t taken = 0;
+
+    /* Play the last samples, padded with silence to the DMA size */
+    if (pcm->carryLen)
     {
-        osa_time_delay(1);
-        waitLoop--;
+        memset(s_carryBuffers[pcm->carrySlot] + pcm->carryLen, 0, STREAMER_PCM_DMA_ALIGN - pcm->carryLen);
+        if (streamer_pcm_take_blocks(pcm, 1) == 0)
+        {
+            streamer_pcm_submit_carry(pcm);
+        }
     }
-    /* If still full DMA might be stalled - clean and restart - VOIS-890 */
-    if (waitLoop == 0)
+
+    /* Wait until every block was played, each one within its duration */
+    while (taken < pcm->numBlocks)
+    {
+        if (xSemaphoreTake(pcm->freeBlocks, pdMS_TO_TICKS(pcm->blockMaxMs + STREAMER_PCM_STALL_MARGIN_MSEC)) != pdTRUE)
+        {
+            break;
+        }
+        taken++;
+    }
+
+    while (taken--)
+    {
+        xSemaphoreGive(pcm->freeBlocks);
+    }
+
+    /* If still not empty the DMA might be stalled - clean and restart - VOIS-890 */
+    if (pcm->emptyBlock < pcm->numBlocks)
     {
+        pcm->stalls++;
         streamer_pcm_clean(pcm);
     }
 }
 
 int streamer_pcm_write(pcm_rtos_t *pcm, uint8_t *data, uint32_t size)
 {
-    status_t ret;
+    uint8_t *carry     = NULL;
+    uint32_t carryLen  = pcm->carryLen;
+    uint32_t carrySlot = pcm->carrySlot;
+    uint32_t fill      = 0;
+    uint32_t tail      = 0;
+    uint32_t blocks    = 0;
 
 #if 0
     static uint32_t entryCount = 0U;
     configPRINTF(("pcm_write entry count: %d\r\n", ++entryCount));
 #endif
 
-    uint8_t waitLoop = STREAMER_PCM_WRITE_TIMEOUT_MSEC;
-    /* Block (up to 30ms) until there is free space to write. */
-    while ((pcm->emptyBlock == 0) && (waitLoop > 0))
-    {
-        osa_time_delay(1);
-        waitLoop--;
-    }
-    /* If still full DMA might be stalled - clean and restart - VOIS-890 */
-    if (waitLoop == 0)
+    /* Complete the tail of the previous write with the head of this one. Writes hold whole samples,
+     * so the rest of the data stays sample aligned for the eDMA. */
+    if (carryLen)
     {
-        streamer_pcm_clean(pcm);
+        carry = s_carryBuffers[pcm->carrySlot];
+        fill  = MIN(STREAMER_PCM_DMA_ALIGN - pcm->carryLen, size);
+
+        memcpy(carry + pcm->carryLen, data, fill);
+        pcm->carryLen += fill;
+        data += fill;
+        size -= fill;
+
+        if (pcm->carryLen < STREAMER_PCM_DMA_ALIGN)
+        {
+            return 0;
+        }
+        blocks++;
     }
 
-    pcm->saiTx.dataSize = size;
-    pcm->saiTx.data     = data;
+    /* The eDMA needs a multiple of 32 bytes, the tail waits for the next write */
+    tail = size % STREAMER_PCM_DMA_ALIGN;
+    size -= tail;
+    blocks += (size != 0) ? 1U : 0U;
 
-    /* Ensure write size is a multiple of 32, otherwise EDMA will assert
-     * failure.  Round down for the last chunk of a file/stream. */
-    if (size % 32)
+    /* A failed write must have consumed nothing, the caller writes it again. The blocks are all taken
+     * before the carry slot is queued, so only a refused queueing can fail the write past that point. */
+    if (streamer_pcm_take_blocks(pcm, blocks) != 0)
     {
-        pcm->saiTx.dataSize = size - (size % 32);
+        pcm->carryLen = carryLen;
+        return 1;
     }
 
-    ret = SLN_AMP_WriteNoWait(pcm->saiTx.data, pcm->saiTx.dataSize);
-    if (ret == kStatus_Success)
+    if (carryLen && (streamer_pcm_submit_carry(pcm) != 0))
     {
-        pcm->emptyBlock--;
+        if (size)
+        {
+            xSemaphoreGive(pcm->freeBlocks);
+        }
+        pcm->carryLen = carryLen;
+        return 1;
     }
-    else
+
+    if (size && (streamer_pcm_submit(pcm, data, size) != 0))
     {
-        configPRINTF(("pcm_write failed, sai_error=%d, emptyBlocks=%d\r\n", ret, pcm->emptyBlock));
+        if (carryLen)
+        {
+            /* The carry slot is queued with the head of this write and cannot be taken back alone: drop the
+             * queue and go back to the tail of the previous write, still in its slot */
+            streamer_pcm_clean(pcm);
+            pcm->carrySlot = carrySlot;
+            pcm->carryLen  = carryLen;
+        }
         return 1;
     }
 
+    if (tail)
+    {
+        memcpy(s_carryBuffers[pcm->carrySlot], data + size, tail);
+        pcm->carryLen = tail;
+    }
+
     return 0;
 }
 
@@ -10,6 +10,9 @@
 #ifndef _FSL_STREAMER_PCM_H_
 #define _FSL_STREAMER_PCM_H_
 
+#include "FreeRTOS.h"
+#include "semphr.h"
+
 #include "fsl_dmamux.h"
 #include "fsl_sai_edma.h"
 
@@ -20,8 +23,11 @@
 #define STREAMER_PCM_OPUS_DATA_SIZE   160
 #define STREAMER_PCM_OPUS_FRAME_SIZE  (STREAMER_PCM_OPUS_HEADER_SIZE + STREAMER_PCM_OPUS_DATA_SIZE)
 
-#define STREAMER_PCM_CLOSE_TIMEOUT_MSEC (100U) /* Timeout for flushing the SAI DMA on close */
-#define STREAMER_PCM_WRITE_TIMEOUT_MSEC (30U)  /* Timeout for flushing the SAI DMA on write */
+/* The SAI eDMA transfers are a multiple of this size, the remainder of a write is carried over to the next one */
+#define STREAMER_PCM_DMA_ALIGN (32U)
+
+/* A block is considered stalled once it played this long past its own duration - VOIS-890 */
+#define STREAMER_PCM_STALL_MARGIN_MSEC (20U)
 
 /*! @brief PCM interface structure */
 typedef struct _pcm_rtos_t
@@ -36,6 +42,15 @@ typedef struct _pcm_rtos_t
 
     volatile uint8_t emptyBlock;
     uint8_t numBlocks;
+
+    SemaphoreHandle_t freeBlocks; /* Given by the amplifier TX interrupt for every block played */
+    uint32_t carryLen;            /* Tail of the last write waiting in the carry slot */
+    uint32_t carrySlot;
+    uint32_t blockMaxMs; /* Duration of the longest block written since open */
+
+    uint32_t stalls;    /* Blocks that did not complete in time */
+    uint32_t waits;     /* Writes that had to wait for a free block */
+    uint32_t maxWaitMs; /* Longest wait for a free block */
 } pcm_rtos_t;
 
 /*******************************************************************************
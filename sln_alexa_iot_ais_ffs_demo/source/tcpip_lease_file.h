@@ -0,0 +1,16 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef TCPIP_LEASE_FILE_H_
+#define TCPIP_LEASE_FILE_H_
+
+/* Last DHCP lease on the joined network, kept by tcpip_manager.c */
+#define TCPIP_LEASE_FILE_NAME "dhcp_lease.dat"
+
+#endif /* TCPIP_LEASE_FILE_H_ */
@@ -9,23 +9,181 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 
-#include "FreeRTOSConfig.h"
+#include "FreeRTOS.h"
+#include "event_groups.h"
+#include "task.h"
 #include "dhcp_server.h"
+#include "lwip/acd.h"
 #include "lwip/dhcp.h"
+#include "lwip/dns.h"
+#include "lwip/init.h"
 #include "lwip/ip4_addr.h"
 #include "lwip/netif.h"
 #include "lwip/prot/dhcp.h"
 #include "lwip/tcpip.h"
+#include "sln_flash_mgmt.h"
+#include "tcpip_lease_file.h"
 #include "tcpip_manager.h"
+#include "wifi_credentials.h"
 #include "wwd_constants.h"
 #include "wwd_network.h"
-
-#define DHCP_RETRIES_CNT 150
+#include "wwd_wifi.h"
+
+/* Same budget as the former 150 polls of 100 ms */
+#define DHCP_BIND_TIMEOUT_MS  15000
+/* ACD probing plus announcing takes up to ~9 s (RFC 5227 timings) */
+#define LEASE_PROBE_TIMEOUT_MS 12000
+/* dhcp_start only fails when lwIP is short of memory, give it a few more chances */
+#define DHCP_START_RETRIES     3
+#define DHCP_START_RETRY_MS    500
+
+/* tcpip_manager_dhcp_seed() writes DHCP client internals, check them again when moving to another lwIP */
+#if (LWIP_VERSION_MAJOR != 2) || (LWIP_VERSION_MINOR != 2)
+#error "tcpip_manager_dhcp_seed() relies on the DHCP client internals of lwIP 2.2"
+#endif
+
+#define TCPIP_LEASE_MAGIC   0x4C504354 /* "TCPL" */
+#define TCPIP_LEASE_VERSION 1
+
+#define TCPIP_STA_EVT_ADDR_SET       (1 << 0U)
+#define TCPIP_STA_EVT_LINK_DOWN      (1 << 1U)
+#define TCPIP_STA_EVT_PROBE_OK       (1 << 2U)
+#define TCPIP_STA_EVT_PROBE_CONFLICT (1 << 3U)
+#define TCPIP_STA_EVT_ALL                                                                   \
+    (TCPIP_STA_EVT_ADDR_SET | TCPIP_STA_EVT_LINK_DOWN | TCPIP_STA_EVT_PROBE_OK | \
+     TCPIP_STA_EVT_PROBE_CONFLICT)
+
+/*! @brief Last DHCP lease, kept in flash to rejoin the same network faster */
+typedef struct _tcpip_manager_lease
+{
+    uint32_t magic;
+    uint16_t version;
+    uint8_t ssidLen;
+    uint8_t reserved;
+    uint8_t ssid[32];
+    uint8_t bssid[6];
+    uint8_t reserved2[2];
+    ip4_addr_t ip;
+    ip4_addr_t netmask;
+    ip4_addr_t gw;
+    ip4_addr_t dns;
+} tcpip_manager_lease_t;
 
 static struct netif g_sta_interface;
 static struct netif g_ap_interface;
 
+static EventGroupHandle_t s_staEvents = NULL;
+static struct acd s_staAcd;
+static bool s_staAcdUsed = false;
+
+static tcpip_manager_lease_t s_lease;
+static bool s_leaseLoaded = false;
+
+/* Called from the tcpip thread when the address of the station interface changes */
+static void tcpip_manager_sta_status_cb(struct netif *netif)
+{
+    if (!ip4_addr_isany_val(*netif_ip4_addr(netif)))
+    {
+        xEventGroupSetBits(s_staEvents, TCPIP_STA_EVT_ADDR_SET);
+    }
+}
+
+/* Called from the tcpip thread, TCPIP_MANAGER_link_sta_down() is used by the WiFi HAL on link loss */
+static void tcpip_manager_sta_link_cb(struct netif *netif)
+{
+    if (!netif_is_link_up(netif))
+    {
+        xEventGroupSetBits(s_staEvents, TCPIP_STA_EVT_LINK_DOWN);
+    }
+}
+
+static void tcpip_manager_sta_acd_cb(struct netif *netif, acd_callback_enum_t state)
+{
+    xEventGroupSetBits(s_staEvents, (state == ACD_IP_OK) ? TCPIP_STA_EVT_PROBE_OK : TCPIP_STA_EVT_PROBE_CONFLICT);
+}
+
+static void tcpip_manager_lease_load(void)
+{
+    uint32_t len = sizeof(s_lease);
+
+    if (!s_leaseLoaded)
+    {
+        if ((SLN_FLASH_MGMT_OK != SLN_FLASH_MGMT_Read(TCPIP_LEASE_FILE_NAME, (uint8_t *)&s_lease, &len)) ||
+            (len != sizeof(s_lease)) || (s_lease.magic != TCPIP_LEASE_MAGIC) ||
+            (s_lease.version != TCPIP_LEASE_VERSION) || (s_lease.ssidLen > sizeof(s_lease.ssid)))
+        {
+            memset(&s_lease, 0, sizeof(s_lease));
+        }
+
+        s_leaseLoaded = true;
+    }
+}
+
+static void tcpip_manager_lease_save(const tcpip_manager_lease_t *lease)
+{
+    int32_t ret;
+
+    /* Same network, same lease: nothing to write */
+    if (0 == memcmp(lease, &s_lease, sizeof(s_lease)))
+    {
+        return;
+    }
+
+    memcpy(&s_lease, lease, sizeof(s_lease));
+
+    ret = SLN_FLASH_MGMT_Save(TCPIP_LEASE_FILE_NAME, (uint8_t *)&s_lease, sizeof(s_lease));
+    if ((SLN_FLASH_MGMT_EOVERFLOW == ret) || (SLN_FLASH_MGMT_EOVERFLOW2 == ret))
+    {
+        SLN_FLASH_MGMT_Erase(TCPIP_LEASE_FILE_NAME);
+        ret = SLN_FLASH_MGMT_Save(TCPIP_LEASE_FILE_NAME, (uint8_t *)&s_lease, sizeof(s_lease));
+    }
+
+    if (SLN_FLASH_MGMT_OK != ret)
+    {
+        configPRINTF(("[TCPIP] Failed to save the DHCP lease: %d\r\n", ret));
+    }
+}
+
+/* Makes the next link up of netif ask ip back with a REQUEST (INIT-REBOOT, RFC 2131 3.2) instead of a
+ * DISCOVER. lwIP has no API for it, this sets two fields of its struct dhcp:
+ *  - offered_ip_addr, put in the requested IP option by dhcp_reboot();
+ *  - state to DHCP_STATE_BOUND, on which dhcp_network_changed_link_up() calls dhcp_reboot().
+ * A NAK or no answer falls back to a DISCOVER. TCPIP core locked, after dhcp_start() with the link down. */
+static void tcpip_manager_dhcp_seed(struct netif *netif, const ip4_addr_t *ip)
+{
+    struct dhcp *dhcp = netif_dhcp_data(netif);
+
+    LWIP_ASSERT("dhcp_start() first", dhcp != NULL);
+    LWIP_ASSERT("link up", !netif_is_link_up(netif));
+
+    ip4_addr_copy(dhcp->offered_ip_addr, *ip);
+    dhcp->state = DHCP_STATE_BOUND;
+}
+
+/* Fills the network part of lease with the AP the station is joined to */
+static bool tcpip_manager_get_network(tcpip_manager_lease_t *lease)
+{
+    wl_bss_info_t ap_info;
+    wiced_security_t ap_security;
+
+    memset(lease, 0, sizeof(*lease));
+
+    if (WWD_SUCCESS != wwd_wifi_get_ap_info(&ap_info, &ap_security))
+    {
+        return false;
+    }
+
+    lease->magic   = TCPIP_LEASE_MAGIC;
+    lease->version = TCPIP_LEASE_VERSION;
+    lease->ssidLen = (ap_info.SSID_len <= sizeof(lease->ssid)) ? ap_info.SSID_len : sizeof(lease->ssid);
+    memcpy(lease->ssid, ap_info.SSID, lease->ssidLen);
+    memcpy(lease->bssid, ap_info.BSSID.octet, sizeof(lease->bssid));
+
+    return true;
+}
+
 
 TCPIPReturnCode_t TCPIP_MANAGER_init(void)
 {
@@ -33,6 +191,12 @@ TCPIPReturnCode_t TCPIP_MANAGER_init(void)
 
     if (inited == false)
     {
+        s_staEvents = xEventGroupCreate();
+        if (s_staEvents == NULL)
+        {
+            return eTCPIPFailure;
+        }
+
         tcpip_init(NULL, NULL);
         inited = true;
     }
@@ -44,16 +208,27 @@ TCPIPReturnCode_t TCPIP_MANAGER_start_sta_interface(bool dhcp_use, volatile bool
 {
     TCPIPReturnCode_t status;
     struct netif *netif_status;
-    err_t dhcp_status;
+    err_t dhcp_status = ERR_OK;
     ip4_addr_t ipaddr, netmask, gw;
-    struct dhcp *dhcp;
-    uint8_t retries;
+    tcpip_manager_lease_t network;
+    bool known_network = false;
+    bool known_ap      = false;
+    EventBits_t bits   = 0;
+    uint32_t retry;
 
     if (dhcp_use)
     {
         IP4_ADDR(&ipaddr,  0, 0, 0, 0);
         IP4_ADDR(&netmask, 0, 0, 0, 0);
         IP4_ADDR(&gw,      0, 0, 0, 0);
+
+        /* A lease from the same SSID is asked back with INIT-REBOOT, the same AP also allows the static fallback */
+        tcpip_manager_lease_load();
+        if (tcpip_manager_get_network(&network) && (s_lease.magic == TCPIP_LEASE_MAGIC))
+        {
+            known_network = (network.ssidLen == s_lease.ssidLen) && (0 == memcmp(network.ssid, s_lease.ssid, s_lease.ssidLen));
+            known_ap      = known_network && (0 == memcmp(network.bssid, s_lease.bssid, sizeof(s_lease.bssid)));
+        }
     }
     else
     {
@@ -62,11 +237,23 @@ TCPIPReturnCode_t TCPIP_MANAGER_start_sta_interface(bool dhcp_use, volatile bool
         IP4_ADDR(&gw,      configGATEWAY_ADDR0,  configGATEWAY_ADDR1,  configGATEWAY_ADDR2,  configGATEWAY_ADDR3);
     }
 
+    xEventGroupClearBits(s_staEvents, TCPIP_STA_EVT_ALL);
+
+    LOCK_TCPIP_CORE();
+
     netif_status = netif_add(&g_sta_interface, &ipaddr, &netmask, &gw,
             (void *)WWD_STA_INTERFACE, wlanif_init, tcpip_input);
     if (netif_status != NULL)
     {
         netif_set_default(&g_sta_interface);
+        netif_set_status_callback(&g_sta_interface, tcpip_manager_sta_status_cb);
+
+        /* Held down until the DHCP client is seeded, so no DISCOVER goes out first */
+        if (known_network)
+        {
+            netif_set_link_down(&g_sta_interface);
+        }
+
         netif_set_up(&g_sta_interface);
         status = eTCPIPSuccess;
     }
@@ -78,44 +265,153 @@ TCPIPReturnCode_t TCPIP_MANAGER_start_sta_interface(bool dhcp_use, volatile bool
     if ((status == eTCPIPSuccess) && (dhcp_use == true))
     {
         dhcp_status = dhcp_start(&g_sta_interface);
-        if (dhcp_status == ERR_OK)
+        if ((dhcp_status == ERR_OK) && known_network)
+        {
+            tcpip_manager_dhcp_seed(&g_sta_interface, &s_lease.ip);
+            configPRINTF(("[TCPIP] Asking back %s\r\n", ip4addr_ntoa(&s_lease.ip)));
+        }
+
+        /* Released whether the client could be seeded or not */
+        if (known_network)
         {
-            dhcp = (struct dhcp *)netif_get_client_data(&g_sta_interface, LWIP_NETIF_CLIENT_DATA_INDEX_DHCP);
-            for (retries = 0; retries < DHCP_RETRIES_CNT; retries++)
+            netif_set_link_up(&g_sta_interface);
+        }
+    }
+
+    if (status == eTCPIPSuccess)
+    {
+        netif_set_link_callback(&g_sta_interface, tcpip_manager_sta_link_cb);
+    }
+
+    UNLOCK_TCPIP_CORE();
+
+    /* Plain DISCOVER from here on, the link is already up */
+    for (retry = 0; (status == eTCPIPSuccess) && dhcp_use && (dhcp_status != ERR_OK) && (retry < DHCP_START_RETRIES);
+         retry++)
+    {
+        configPRINTF(("[TCPIP] dhcp_start failed: %d, retrying\r\n", dhcp_status));
+        vTaskDelay(pdMS_TO_TICKS(DHCP_START_RETRY_MS));
+
+        LOCK_TCPIP_CORE();
+        dhcp_status = dhcp_start(&g_sta_interface);
+        UNLOCK_TCPIP_CORE();
+    }
+
+    if ((status == eTCPIPSuccess) && (dhcp_use == true))
+    {
+        if ((dhcp_status != ERR_OK) && !known_ap)
+        {
+            status = eTCPIPFailure;
+        }
+        else if ((bool)WICED_FALSE == *connection_state)
+        {
+            /* Link lost before the callbacks were in place */
+            status = eTCPIPDhcpCLientFailed;
+        }
+        else
+        {
+            /* Without a DHCP client only the cached lease below is left */
+            if (dhcp_status == ERR_OK)
+            {
+                bits = xEventGroupWaitBits(s_staEvents, TCPIP_STA_EVT_ADDR_SET | TCPIP_STA_EVT_LINK_DOWN, pdFALSE,
+                                           pdFALSE, pdMS_TO_TICKS(DHCP_BIND_TIMEOUT_MS));
+            }
+
+            if ((bits & TCPIP_STA_EVT_LINK_DOWN) || ((bool)WICED_FALSE == *connection_state))
             {
-                if (dhcp->state == DHCP_STATE_BOUND)
+                status = eTCPIPDhcpCLientFailed;
+            }
+            else if (bits & TCPIP_STA_EVT_ADDR_SET)
+            {
+                LOCK_TCPIP_CORE();
+                ip4_addr_copy(network.ip, *netif_ip4_addr(&g_sta_interface));
+                ip4_addr_copy(network.netmask, *netif_ip4_netmask(&g_sta_interface));
+                ip4_addr_copy(network.gw, *netif_ip4_gw(&g_sta_interface));
+#if LWIP_DNS
+                ip4_addr_copy(network.dns, *ip_2_ip4(dns_getserver(0)));
+#endif /* LWIP_DNS */
+                UNLOCK_TCPIP_CORE();
+
+                if (network.magic == TCPIP_LEASE_MAGIC)
                 {
-                    break;
+                    tcpip_manager_lease_save(&network);
                 }
-                else
+            }
+            else if (known_ap)
+            {
+                /* No DHCP client or no DHCP answer on the AP the lease came from: take the lease back as a
+                 * static address, once an ARP probe showed nobody else uses it */
+                configPRINTF(("[TCPIP] No DHCP answer, probing %s\r\n", ip4addr_ntoa(&s_lease.ip)));
+
+                LOCK_TCPIP_CORE();
+                dhcp_release_and_stop(&g_sta_interface);
+                acd_add(&g_sta_interface, &s_staAcd, tcpip_manager_sta_acd_cb);
+                s_staAcdUsed = (ERR_OK == acd_start(&g_sta_interface, &s_staAcd, s_lease.ip));
+                UNLOCK_TCPIP_CORE();
+
+                if (s_staAcdUsed)
                 {
-                    if ((bool)WICED_FALSE == *connection_state)
+                    bits = xEventGroupWaitBits(s_staEvents,
+                                               TCPIP_STA_EVT_PROBE_OK | TCPIP_STA_EVT_PROBE_CONFLICT |
+                                                   TCPIP_STA_EVT_LINK_DOWN,
+                                               pdFALSE, pdFALSE, pdMS_TO_TICKS(LEASE_PROBE_TIMEOUT_MS));
+                }
+
+                if (bits & TCPIP_STA_EVT_PROBE_OK)
+                {
+                    LOCK_TCPIP_CORE();
+                    netif_set_addr(&g_sta_interface, &s_lease.ip, &s_lease.netmask, &s_lease.gw);
+#if LWIP_DNS
                     {
-                        status = eTCPIPDhcpCLientFailed;
-                        break;
+                        ip_addr_t dns;
+                        ip_addr_copy_from_ip4(dns, s_lease.dns);
+                        dns_setserver(0, &dns);
                     }
+#endif /* LWIP_DNS */
+                    UNLOCK_TCPIP_CORE();
+
+                    configPRINTF(("[TCPIP] Using cached lease %s\r\n", ip4addr_ntoa(&s_lease.ip)));
+                }
+                else
+                {
+                    status = eTCPIPDhcpCLientFailed;
                 }
-                vTaskDelay(100);
             }
-            if (dhcp->state != DHCP_STATE_BOUND)
+            else
             {
                 status = eTCPIPDhcpCLientFailed;
             }
         }
-        else
-        {
-            status = eTCPIPFailure;
-        }
     }
 
     return status;
 }
 
+TCPIPReturnCode_t TCPIP_MANAGER_forget_lease(void)
+{
+    memset(&s_lease, 0, sizeof(s_lease));
+    s_leaseLoaded = true;
+
+    SLN_FLASH_MGMT_Erase(TCPIP_LEASE_FILE_NAME);
+
+    return eTCPIPSuccess;
+}
+
 TCPIPReturnCode_t TCPIP_MANAGER_quit_sta_interface(void)
 {
+    LOCK_TCPIP_CORE();
+
+    if (s_staAcdUsed)
+    {
+        acd_stop(&s_staAcd);
+        s_staAcdUsed = false;
+    }
+
     dhcp_release_and_stop(&g_sta_interface);
     netif_remove(&g_sta_interface);
 
+    UNLOCK_TCPIP_CORE();
+
     return eTCPIPSuccess;
 }
 
@@ -56,7 +56,24 @@ typedef struct {
 
 TCPIPReturnCode_t TCPIP_MANAGER_init(void);
 
+/**
+ * @brief Bring up the station interface once the WiFi is joined
+ *
+ * With DHCP, a lease obtained earlier on the same SSID is asked back first (INIT-REBOOT). If no DHCP server
+ * answers on the same AP, the cached lease is used as a static address after an ARP probe.
+ *
+ * @param dhcp_use true to use the DHCP client, false for the static configIP_ADDR configuration
+ * @param connection_state WiFi link state, the call gives up when it goes false
+ *
+ * @return eTCPIPSuccess once the interface has an address
+ */
 TCPIPReturnCode_t TCPIP_MANAGER_start_sta_interface(bool dhcp_use, volatile bool *connection_state);
+
+/**
+ * @brief Drop the cached DHCP lease, the next join does a full DISCOVER.
+ *        wifi_credentials_flash_reset() calls it along with the credentials.
+ */
+TCPIPReturnCode_t TCPIP_MANAGER_forget_lease(void);
 TCPIPReturnCode_t TCPIP_MANAGER_quit_sta_interface(void);
 TCPIPReturnCode_t TCPIP_MANAGER_get_ip_sta_interface(tcpip_manager_ip_info_t *ip_info);
 TCPIPReturnCode_t TCPIP_MANAGER_get_ip_only_sta_interface(uint32_t *ip);
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef TLS_SESSION_FILE_H_
+#define TLS_SESSION_FILE_H_
+
+/* Keep the TLS session of the broker connection in flash, so the first connection
+ * after a reboot can resume it instead of doing a full handshake */
+#ifndef MQTT_TLS_SESSION_PERSIST
+#define MQTT_TLS_SESSION_PERSIST (1)
+#endif
+
+#if MQTT_TLS_SESSION_PERSIST
+#define TLS_SESSION_FILE_NAME "tls_sess.dat"
+#endif
+
+#endif /* TLS_SESSION_FILE_H_ */
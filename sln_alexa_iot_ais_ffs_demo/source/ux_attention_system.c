@@ -54,53 +54,288 @@ static TimerHandle_t s_speakingAlertTimerHandle;
 
 static rgb_led_brightness_t currentBrightness = LED_BRIGHT_HIGH;
 
-static uint16_t toggleCount    = 0;
-static bool toggleCountEnabled = 0;
-static bool resumePrevState    = 0;
-
 QueueHandle_t g_uxQueue = NULL;
 
-#define RBG_PATTERN_MAX_COUNT 8U
+/*! @brief LED pattern engine settings */
+#define UX_LED_MAX_FRAMES   64U /* Frames of the longest rendered pattern */
+#define UX_LED_FADE_STEP_MS 40U /* Frame period of fades */
 
-static uint32_t pit_led_index                                      = 0;
-static uint32_t pit_led_count                                      = 0;
-static volatile rgbLedColor_t pit_led_color[RBG_PATTERN_MAX_COUNT] = {0};
+/*! @brief How a keyframe is reached from the previous one */
+typedef enum _ux_led_easing
+{
+    kUxLedStep,      /* Jump to the color when the keyframe starts */
+    kUxLedLinear,    /* Linear fade over the keyframe duration */
+    kUxLedEaseInOut, /* Smoothstep fade over the keyframe duration */
+} ux_led_easing_t;
+
+/*! @brief What the LED does once a pattern with a repeat count is over */
+typedef enum _ux_led_end
+{
+    kUxLedEndOff,    /* Turn the LED off */
+    kUxLedEndResume, /* Show the pattern of the current AIS state */
+} ux_led_end_t;
+
+/*! @brief One step of a pattern */
+typedef struct _ux_led_keyframe
+{
+    uint8_t color;      /* rgbLedColor_t */
+    uint8_t mutedColor; /* rgbLedColor_t used instead of color while the mics are muted */
+    uint8_t level;      /* 0 to RGB_LED_LEVEL_FULL */
+    uint8_t easing;     /* ux_led_easing_t */
+    uint16_t durationMs;
+} ux_led_keyframe_t;
+
+/*! @brief LED pattern of a UX state */
+typedef struct _ux_led_pattern
+{
+    const ux_led_keyframe_t *keys;
+    uint8_t keyCount;
+    uint8_t repeat; /* Runs of the keyframes, 0 loops until the next state */
+    uint8_t end;    /* ux_led_end_t */
+} ux_led_pattern_t;
+
+/*! @brief Rendered frame, streamed to the PWM by the PIT interrupt */
+typedef struct _ux_led_frame
+{
+    rgb_led_frame_t pwm;
+    uint32_t period; /* PIT counts */
+} ux_led_frame_t;
+
+#define UX_KEY(c, ms)           {(c), (c), RGB_LED_LEVEL_FULL, kUxLedStep, (ms)}
+#define UX_KEY_MUTE(c, m, ms)   {(c), (m), RGB_LED_LEVEL_FULL, kUxLedStep, (ms)}
+#define UX_KEY_FADE(c, l, e, ms) {(c), (c), (l), (e), (ms)}
+
+#define UX_PATTERN(k, r, e) {(k), sizeof(k) / sizeof((k)[0]), (r), (e)}
+
+static const ux_led_keyframe_t s_keysIdle[]      = {UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 0)};
+static const ux_led_keyframe_t s_keysBlue[]      = {UX_KEY(LED_COLOR_BLUE, 0)};
+static const ux_led_keyframe_t s_keysCyan[]      = {UX_KEY(LED_COLOR_CYAN, 0)};
+static const ux_led_keyframe_t s_keysOff[]       = {UX_KEY(LED_COLOR_OFF, 0)};
+static const ux_led_keyframe_t s_keysYellow[]    = {UX_KEY(LED_COLOR_YELLOW, 0)};
+static const ux_led_keyframe_t s_keysOrange[]    = {UX_KEY(LED_COLOR_ORANGE, 0)};
+static const ux_led_keyframe_t s_keysThinking[]  = {UX_KEY(LED_COLOR_CYAN, 200), UX_KEY(LED_COLOR_BLUE, 200)};
+/* Steps, a fade would take a PIT interrupt every UX_LED_FADE_STEP_MS for as long as uvoice speaks */
+static const ux_led_keyframe_t s_keysSpeaking[]  = {UX_KEY(LED_COLOR_CYAN, 500), UX_KEY(LED_COLOR_BLUE, 500)};
+static const ux_led_keyframe_t s_keysMicOff[]    = {UX_KEY(LED_COLOR_RED, 500)};
+static const ux_led_keyframe_t s_keysMicOn[]     = {UX_KEY(LED_COLOR_OFF, 500)};
+static const ux_led_keyframe_t s_keysAlert[]     = {
+    UX_KEY(LED_COLOR_BLUE, 250), UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 250),
+    UX_KEY(LED_COLOR_BLUE, 250), UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 250),
+    UX_KEY(LED_COLOR_CYAN, 250), UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 250),
+    UX_KEY(LED_COLOR_CYAN, 250), UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 250)};
+static const ux_led_keyframe_t s_keysNotifIncoming[] = {UX_KEY(LED_COLOR_YELLOW, 500), UX_KEY(LED_COLOR_OFF, 500)};
+static const ux_led_keyframe_t s_keysNotifQueued[]   = {UX_KEY(LED_COLOR_YELLOW, 1000), UX_KEY(LED_COLOR_OFF, 2000),
+                                                      UX_KEY_MUTE(LED_COLOR_YELLOW, LED_COLOR_RED, 1000),
+                                                      UX_KEY(LED_COLOR_OFF, 2000)};
+static const ux_led_keyframe_t s_keysDoNotDisturb[]  = {UX_KEY(LED_COLOR_PURPLE, 1000)};
+static const ux_led_keyframe_t s_keysGreenSlow[]     = {UX_KEY(LED_COLOR_GREEN, 500), UX_KEY(LED_COLOR_OFF, 500)};
+static const ux_led_keyframe_t s_keysGreenFast[]     = {UX_KEY(LED_COLOR_GREEN, 250), UX_KEY(LED_COLOR_OFF, 250)};
+static const ux_led_keyframe_t s_keysBootUp[]        = {UX_KEY(LED_COLOR_BLUE, 1000), UX_KEY(LED_COLOR_CYAN, 1000)};
+static const ux_led_keyframe_t s_keysYellowSlow[]    = {UX_KEY(LED_COLOR_YELLOW, 500), UX_KEY(LED_COLOR_OFF, 500)};
+static const ux_led_keyframe_t s_keysYellowFast[]    = {UX_KEY(LED_COLOR_YELLOW, 250), UX_KEY(LED_COLOR_OFF, 250)};
+static const ux_led_keyframe_t s_keysRedYellowSlow[] = {UX_KEY(LED_COLOR_RED, 500), UX_KEY(LED_COLOR_YELLOW, 500)};
+static const ux_led_keyframe_t s_keysRedYellowFast[] = {UX_KEY(LED_COLOR_RED, 250), UX_KEY(LED_COLOR_YELLOW, 250)};
+static const ux_led_keyframe_t s_keysDiscovery[]     = {UX_KEY_MUTE(LED_COLOR_BLUE, LED_COLOR_RED, 1000),
+                                                      UX_KEY(LED_COLOR_BLUE, 1000)};
+static const ux_led_keyframe_t s_keysDeviceChange[]  = {UX_KEY(LED_COLOR_WHITE, 2000)};
+static const ux_led_keyframe_t s_keysDisconnected[]  = {UX_KEY(LED_COLOR_RED, 500), UX_KEY(LED_COLOR_OFF, 500)};
+static const ux_led_keyframe_t s_keysError[]         = {UX_KEY(LED_COLOR_RED, 500), UX_KEY(LED_COLOR_WHITE, 500)};
+static const ux_led_keyframe_t s_keysFSSProvision[]  = {UX_KEY_MUTE(LED_COLOR_OFF, LED_COLOR_RED, 500),
+                                                      UX_KEY(LED_COLOR_ORANGE, 500)};
+static const ux_led_keyframe_t s_keysFactoryReset[]  = {UX_KEY(LED_COLOR_PURPLE, 250), UX_KEY(LED_COLOR_YELLOW, 250)};
+static const ux_led_keyframe_t s_keysCredErase[]     = {UX_KEY(LED_COLOR_PURPLE, 500), UX_KEY(LED_COLOR_GREEN, 500)};
+
+/*! @brief LED pattern of each UX state, states without keys only update the state machine */
+static const ux_led_pattern_t s_uxPatterns[] = {
+    [uxIdle]                 = UX_PATTERN(s_keysIdle, 0, kUxLedEndOff),
+    [uxListeningStart]       = UX_PATTERN(s_keysBlue, 0, kUxLedEndOff),
+    [uxListeningActive]      = UX_PATTERN(s_keysCyan, 0, kUxLedEndOff),
+    [uxListeningEnd]         = UX_PATTERN(s_keysOff, 0, kUxLedEndOff),
+    [uxThinking]             = UX_PATTERN(s_keysThinking, 0, kUxLedEndOff),
+    [uxSpeaking]             = UX_PATTERN(s_keysSpeaking, 0, kUxLedEndOff),
+    [uxSpeakingEnd]          = UX_PATTERN(s_keysIdle, 0, kUxLedEndOff),
+    [uxMicOntoOff]           = UX_PATTERN(s_keysMicOff, 1, kUxLedEndResume),
+    [uxMicOfftoOn]           = UX_PATTERN(s_keysMicOn, 1, kUxLedEndResume),
+    [uxTimer]                = UX_PATTERN(s_keysAlert, 0, kUxLedEndOff),
+    [uxTimerShort]           = UX_PATTERN(s_keysAlert, 4, kUxLedEndOff),
+    [uxTimerEnd]             = UX_PATTERN(s_keysOff, 0, kUxLedEndOff),
+    [uxAlarm]                = UX_PATTERN(s_keysAlert, 0, kUxLedEndOff),
+    [uxAlarmShort]           = UX_PATTERN(s_keysAlert, 4, kUxLedEndOff),
+    [uxAlarmEnd]             = UX_PATTERN(s_keysOff, 0, kUxLedEndOff),
+    [uxReminder]             = UX_PATTERN(s_keysAlert, 0, kUxLedEndOff),
+    [uxReminderShort]        = UX_PATTERN(s_keysAlert, 4, kUxLedEndOff),
+    [uxReminderEnd]          = UX_PATTERN(s_keysOff, 0, kUxLedEndOff),
+    [uxNotificationIncoming] = UX_PATTERN(s_keysNotifIncoming, 0, kUxLedEndOff),
+    [uxNotificationQueued]   = UX_PATTERN(s_keysNotifQueued, 0, kUxLedEndOff),
+    [uxNotificationCleared]  = UX_PATTERN(s_keysOff, 0, kUxLedEndOff),
+    [uxDoNotDisturb]         = UX_PATTERN(s_keysDoNotDisturb, 1, kUxLedEndResume),
+    [uxReconnecting]         = UX_PATTERN(s_keysGreenSlow, 0, kUxLedEndOff),
+    [uxConnected]            = UX_PATTERN(s_keysGreenFast, 0, kUxLedEndOff),
+    [uxBootUp]               = UX_PATTERN(s_keysBootUp, 0, kUxLedEndOff),
+    [uxApMode]               = UX_PATTERN(s_keysOrange, 0, kUxLedEndOff),
+    [uxWiFiSetup]            = UX_PATTERN(s_keysYellowSlow, 0, kUxLedEndOff),
+    [uxAccessPointFound]     = UX_PATTERN(s_keysYellowFast, 0, kUxLedEndOff),
+    [uxNoAccessPoint]        = UX_PATTERN(s_keysRedYellowSlow, 0, kUxLedEndOff),
+    [uxInvalidWiFiCred]      = UX_PATTERN(s_keysRedYellowFast, 0, kUxLedEndOff),
+    [uxDeviceChange]         = UX_PATTERN(s_keysDeviceChange, 1, kUxLedEndResume),
+    [uxDiscovery]            = UX_PATTERN(s_keysDiscovery, 0, kUxLedEndOff),
+    [uxAuthentication]       = UX_PATTERN(s_keysYellow, 0, kUxLedEndOff),
+    [uxDisconnected]         = UX_PATTERN(s_keysDisconnected, 3, kUxLedEndResume),
+    [uxBleProvision]         = UX_PATTERN(s_keysOrange, 0, kUxLedEndOff),
+    [uxFSSProvision]         = UX_PATTERN(s_keysFSSProvision, 0, kUxLedEndOff),
+    [uxError]                = UX_PATTERN(s_keysError, 6, kUxLedEndOff),
+    [uxFactoryReset]         = UX_PATTERN(s_keysFactoryReset, 6, kUxLedEndOff),
+    [uxWiFiCredentialsErase] = UX_PATTERN(s_keysCredErase, 3, kUxLedEndOff),
+    [uxUGSSessionRestart]    = UX_PATTERN(s_keysCredErase, 3, kUxLedEndOff),
+};
+
+/* Written by the task with the PIT stopped, read by the PIT interrupt */
+static ux_led_frame_t s_ledFrames[UX_LED_MAX_FRAMES];
+static volatile uint32_t s_ledFrameCount = 0;
+static volatile uint32_t s_ledFrameIndex = 0;
+static volatile uint32_t s_ledRepeatLeft = 0;
+static volatile uint8_t s_ledEnd         = kUxLedEndOff;
 
 __attribute__((section(".ocram_non_cacheable_bss"))) StackType_t ux_attention_task_stack_buffer[UX_ATT_TASK_STACK];
 __attribute__((section(".ocram_non_cacheable_bss"))) StaticTask_t ux_attention_task_buffer;
 
 void PIT_LED_HANDLER(void)
 {
+    uint32_t next;
+
     /* Clear interrupt flag.*/
     PIT_ClearStatusFlags(PIT, kPIT_Chnl_0, kPIT_TimerFlag);
 
-    if (pit_led_index >= pit_led_count)
+    next = s_ledFrameIndex + 1;
+
+    if (next >= s_ledFrameCount)
     {
-        pit_led_index = 0;
+        next = 0;
+
+        /* Last run of a pattern with a repeat count */
+        if ((s_ledRepeatLeft != 0) && (--s_ledRepeatLeft == 0))
+        {
+            PIT_StopTimer(PIT, kPIT_Chnl_0);
+            if (kUxLedEndResume == s_ledEnd)
+            {
+                ux_attention_resume_state(AIS_APP_GetAppData()->state);
+            }
+            else
+            {
+                RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
+            }
+            return;
+        }
+    }
+
+    RGB_LED_SetFrame(&s_ledFrames[next].pwm);
+    s_ledFrameIndex = next;
+
+    /* The timer has already reloaded the period of this frame, queue the one of the next frame */
+    next = (next + 1 < s_ledFrameCount) ? (next + 1) : 0;
+    PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, s_ledFrames[next].period);
+}
+
+static uint8_t ux_led_ease(uint8_t easing, uint32_t step, uint32_t steps)
+{
+    /* Progress in 1/256 */
+    uint32_t t = (step * 256U) / steps;
+
+    if (kUxLedEaseInOut == easing)
+    {
+        /* 3t^2 - 2t^3 */
+        t = (t * t * (768U - 2U * t)) >> 16;
+    }
+
+    return (t > 255U) ? 255U : (uint8_t)t;
+}
+
+static void ux_led_mix(const rgb_led_frame_t *from, const rgb_led_frame_t *to, uint8_t amount, rgb_led_frame_t *out)
+{
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        int32_t delta = (int32_t)to->halfPulse[channel] - (int32_t)from->halfPulse[channel];
+
+        out->halfPulse[channel] = (uint16_t)((int32_t)from->halfPulse[channel] + ((delta * (int32_t)amount) / 255));
     }
+}
 
-    RGB_LED_SetBrightnessColor(currentBrightness, pit_led_color[pit_led_index]);
+/**
+ * @brief Render a pattern in s_ledFrames and start streaming it to the LED
+ *
+ * Colors, fades and the mic mute variant are all resolved here, the PIT interrupt only loads the next frame.
+ */
+static void ux_led_play(const ux_led_pattern_t *pattern)
+{
+    bool muted = audio_processing_get_mic_mute();
+    rgb_led_frame_t keyFrame[2];
+    rgb_led_frame_t *from = &keyFrame[0];
+    rgb_led_frame_t *to   = &keyFrame[1];
+    rgb_led_frame_t *swap;
+    uint32_t frameCount = 0;
+    uint32_t steps;
+    uint32_t key;
 
-    if ((pit_led_index & 0x1))
+    PIT_StopTimer(PIT, kPIT_Chnl_0);
+    PIT_ClearStatusFlags(PIT, kPIT_Chnl_0, kPIT_TimerFlag);
+
+    if ((pattern == NULL) || (pattern->keys == NULL))
     {
-        toggleCount--;
+        RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
+        return;
     }
 
-    if ((toggleCountEnabled == 1) && (toggleCount == 0))
+    /* Fades into the first keyframe start from the last one, so a looping pattern is seamless */
+    key = pattern->keyCount - 1;
+    RGB_LED_ComputeFrame(currentBrightness, muted ? pattern->keys[key].mutedColor : pattern->keys[key].color,
+                         pattern->keys[key].level, from);
+
+    for (key = 0; key < pattern->keyCount; key++)
     {
-        PIT_StopTimer(PIT, kPIT_Chnl_0);
-        if (resumePrevState)
+        const ux_led_keyframe_t *keyframe = &pattern->keys[key];
+
+        RGB_LED_ComputeFrame(currentBrightness, muted ? keyframe->mutedColor : keyframe->color, keyframe->level, to);
+
+        steps = 1;
+        if ((kUxLedStep != keyframe->easing) && (keyframe->durationMs >= 2 * UX_LED_FADE_STEP_MS))
         {
-            ux_attention_resume_state(AIS_APP_GetAppData()->state);
-            resumePrevState = false;
+            steps = keyframe->durationMs / UX_LED_FADE_STEP_MS;
         }
-        else
+
+        configASSERT(frameCount + steps <= UX_LED_MAX_FRAMES);
+
+        for (uint32_t step = 1; step <= steps; step++)
         {
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
+            ux_led_mix(from, to, ux_led_ease(keyframe->easing, step, steps), &s_ledFrames[frameCount].pwm);
+
+            /* The last step takes what is left of the keyframe duration */
+            s_ledFrames[frameCount].period =
+                USEC_TO_COUNT(((step < steps) ? UX_LED_FADE_STEP_MS
+                                              : (keyframe->durationMs - (steps - 1) * UX_LED_FADE_STEP_MS)) *
+                                  1000U,
+                              PIT_SOURCE_CLOCK);
+            frameCount++;
         }
+
+        swap = from;
+        from = to;
+        to   = swap;
     }
 
-    pit_led_index++;
+    s_ledFrameCount = frameCount;
+    s_ledFrameIndex = 0;
+    s_ledRepeatLeft = pattern->repeat;
+    s_ledEnd        = pattern->end;
+
+    RGB_LED_SetFrame(&s_ledFrames[0].pwm);
+
+    /* A single looping frame is a solid color, nothing to stream */
+    if ((frameCount > 1) || (pattern->repeat != 0))
+    {
+        PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, s_ledFrames[0].period);
+        PIT_StartTimer(PIT, kPIT_Chnl_0);
+        PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, s_ledFrames[(frameCount > 1) ? 1 : 0].period);
+    }
 }
 
 /*  Current State Machine isn't very good..it will handle the Main State fine but the auxiliary state handling needs
@@ -133,6 +368,7 @@ void ux_attention_task(void *pvParameters)
     bool speakingState            = false;
     prevState                     = uxIdle;
     ux_attention_states_t uxState = uxNull;
+    ux_attention_states_t nextState;
 
     while (1)
     {
@@ -150,754 +386,110 @@ void ux_attention_task(void *pvParameters)
             continue;
         }
 
-        if (uxHighBrightness == uxState)
-        {
-            currentBrightness = LED_BRIGHT_HIGH;
-            uxState           = prevState;
-        }
-
-        if (uxMediumBrightness == uxState)
+        if ((uxHighBrightness == uxState) || (uxMediumBrightness == uxState) || (uxLowBrightness == uxState))
         {
-            currentBrightness = LED_BRIGHT_MEDIUM;
-            uxState           = prevState;
+            currentBrightness = (uxHighBrightness == uxState) ?
+                                    LED_BRIGHT_HIGH :
+                                    ((uxMediumBrightness == uxState) ? LED_BRIGHT_MEDIUM : LED_BRIGHT_LOW);
+            uxState = prevState;
         }
 
-        if (uxLowBrightness == uxState)
+        // uxIdle and mic mute changes are set during FFS at mics unmute/mute, the provisioning pattern stays
+        if (((uxIdle == uxState) || (uxMicOntoOff == uxState)) &&
+            ((uxFSSProvision == prevState) || (uxDiscovery == prevState)))
         {
-            currentBrightness = LED_BRIGHT_LOW;
-            uxState           = prevState;
+            uxState = prevState;
         }
 
-        // idle
-        if (uxIdle == uxState)
+        // Alerts play their short version while uvoice is speaking
+        if (speakingState)
         {
-            if (uxFSSProvision == prevState)
+            if (uxTimer == uxState)
             {
-                // move to uxFSSProvision, uxIdle is set during FFS at mics unmute
-                uxState = uxFSSProvision;
+                uxState = uxTimerShort;
             }
-            else if (uxDiscovery == prevState)
+            else if (uxAlarm == uxState)
             {
-                // move to uxDiscovery, uxIdle is set during FFS at mics unmute
-                uxState = uxDiscovery;
+                uxState = uxAlarmShort;
             }
-            else
+            else if (uxReminder == uxState)
             {
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                RGB_LED_SetBrightnessColor(currentBrightness, muteColour);
-                toggleCountEnabled = 0;
-                speakingState      = false;
-                prevState          = uxIdle;
+                uxState = uxReminderShort;
             }
         }
-
-        /*LISTENING START = WakeWordTriggered */
-        if (uxListeningStart == uxState)
+        else if ((uxTimerShort == uxState) || (uxAlarmShort == uxState) || (uxReminderShort == uxState))
         {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_BLUE);
-
-            prevState = uxListeningStart;
+            /* TODO: speakingState not currently enabled because not sure how to interrupt speaking audio */
+            uxState = uxNull;
         }
 
-        // LISTENING ACTIVE
-        if (uxListeningActive == uxState)
+        if ((uxNull == uxState) || (uxState >= (sizeof(s_uxPatterns) / sizeof(s_uxPatterns[0]))))
         {
-            vTaskDelay(0xF);
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_CYAN);
-            toggleCountEnabled = 0;
-
-            prevState = uxListeningActive;
+            continue;
         }
 
-        // LISTENING END
-        if (uxListeningEnd == uxState)
+        // We should stop the leds only if the prevState was uxListeningActive otherwise we interfere with other
+        // uxStates
+        if ((uxListeningEnd != uxState) || (uxListeningActive == prevState))
         {
-            // We should stop the leds only if the prevState was uxListeningActive otherwise we interfere with other
-            // uxStates
-            if (uxListeningActive == prevState)
+            if (uxListeningActive == uxState)
             {
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                toggleCountEnabled = 0;
-                RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
+                vTaskDelay(0xF);
             }
 
-            prevState = uxListeningEnd;
-        }
-
-        // THINKING : alternate blue and cyan every 200ms
-        if (uxThinking == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_CYAN;
-            pit_led_color[1]   = LED_COLOR_BLUE;
-
-            // 200ms timer
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(200000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxThinking;
-        }
-
-        // Need to think more clearly what happens when thinking Ends.For now assume moving to speaking state
-        // or listening state or idle state is the end of thinking state.
-
-        // SPEAKING: alternate blue and cyan every 500ms
-        if (uxSpeaking == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_CYAN;
-            pit_led_color[1]   = LED_COLOR_BLUE;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-            speakingState = true;
-
-            prevState = uxSpeaking;
+            ux_led_play(&s_uxPatterns[uxState]);
         }
 
-        // END SPEAKING:
-        if (uxSpeakingEnd == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-
-            rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-            RGB_LED_SetBrightnessColor(currentBrightness, muteColour);
-            toggleCountEnabled = 0;
-
-            speakingState = false;
-            // If timer/alarm/reminder flag then play long versions of timer,alarm, reminder
-
-            prevState = uxIdle;
-        }
-
-        // MIC ON to MIC OFF
-        if (uxMicOntoOff == uxState)
-        {
-            if (uxFSSProvision == prevState)
-            {
-                // move to uxFSSProvision, where mic mute is being considered
-                uxState = uxFSSProvision;
-            }
-            else if (uxDiscovery == prevState)
-            {
-                // move to uxDiscovery, where mic mute is being considered
-                uxState = uxDiscovery;
-            }
-            else
-            {
-                // solid RED
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 2;
-                toggleCount        = 1;
-                toggleCountEnabled = 1;
-                resumePrevState    = true;
-                pit_led_color[0]   = LED_COLOR_RED;
-                pit_led_color[1]   = LED_COLOR_RED;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                prevState = uxMicOntoOff;
-            }
-        }
-
-        // MIC OFF TO MIC ON
-        if (uxMicOfftoOn == uxState)
-        {
-            // led OFF
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCount        = 1;
-            toggleCountEnabled = 1;
-            resumePrevState    = true;
-            pit_led_color[0]   = LED_COLOR_OFF;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxMicOfftoOn;
-        }
+        nextState = uxState;
 
-        if (speakingState)
+        switch (uxState)
         {
-            /* If uvoice is speaking, play the shortened versions of the alerts */
-            /* TODO: speakingState not currently enabled because not sure how to interrupt speaking audio */
-
-            if ((uxTimerShort == uxState) || (uxTimer == uxState))
-            {
-                // TODO: Play toggling cyan/blue led and audio prompt every 10 seconds
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCount        = 16;
-                toggleCountEnabled = 1;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                if (xTimerReset(s_speakingAlertTimerHandle, 0) != pdPASS)
-                {
-                    configPRINTF(("xTimerReset failed\r\n"));
-                }
+            case uxIdle:
+            case uxSpeakingEnd:
+                speakingState = false;
+                nextState     = uxIdle;
+                break;
 
-                prevState = uxTimerShort;
-            }
-
-            if ((uxAlarmShort == uxState) || (uxAlarm == uxState))
-            {
-                // TODO: Play toggling cyan/blue led and audio prompt every 10 seconds
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCount        = 16;
-                toggleCountEnabled = 1;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
+            case uxSpeaking:
+                speakingState = true;
+                break;
 
+            case uxTimerShort:
+            case uxAlarmShort:
+            case uxReminderShort:
+                // TODO: Play audio prompt every 10 seconds
                 if (xTimerReset(s_speakingAlertTimerHandle, 0) != pdPASS)
                 {
                     configPRINTF(("xTimerReset failed\r\n"));
                 }
-
-                prevState = uxAlarmShort;
-            }
-
-            if ((uxReminderShort == uxState) || (uxReminder == uxState))
-            {
-                // TODO: Play toggling cyan/blue led and audio prompt every 10 seconds
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCount        = 16;
-                toggleCountEnabled = 1;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                if (xTimerReset(s_speakingAlertTimerHandle, 0) != pdPASS)
-                {
-                    configPRINTF(("xTimerReset failed\r\n"));
-                }
-
-                prevState = uxReminderShort;
-            }
-        }
-        else
-        {
-            if (uxTimer == uxState)
-            {
-                // loop between cyan and blue every 300ms
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCountEnabled = 0;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                // SLN_AMP_Write((uint8_t *)med_system_alerts_melodic_01_mono_wav,
-                // MED_SYSTEM_ALERTS_MELODIC_01_MONO_WAV_LEN);
-
-                prevState = uxTimer;
-            }
-
-            if (uxAlarm == uxState)
-            {
-                // loop between cyan and blue every 300ms
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCountEnabled = 0;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                prevState = uxAlarm;
-            }
-
-            if (uxReminder == uxState)
-            {
-                // loop 2 blue 2 cyan every 250ms
-                PIT_StopTimer(PIT, kPIT_Chnl_0);
-                pit_led_index      = 0;
-                pit_led_count      = 8;
-                toggleCountEnabled = 0;
-
-                rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-
-                pit_led_color[0] = LED_COLOR_BLUE;
-                pit_led_color[1] = muteColour;
-                pit_led_color[2] = LED_COLOR_BLUE;
-                pit_led_color[3] = muteColour;
-                pit_led_color[4] = LED_COLOR_CYAN;
-                pit_led_color[5] = muteColour;
-                pit_led_color[6] = LED_COLOR_CYAN;
-                pit_led_color[7] = muteColour;
-
-                PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-                PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-                prevState = uxReminder;
-            }
-        }
-
-        if (uxTimerEnd == uxState)
-        {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
-
-            // SLN_AMP_AbortWrite();
-
-            prevState = uxIdle;
-        }
-
-        if (uxAlarmEnd == uxState)
-        {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
-
-            prevState = uxIdle;
-        }
-
-        if (uxReminderEnd == uxState)
-        {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
-
-            prevState = uxIdle;
-        }
-
-        if (uxNotificationIncoming == uxState)
-        {
-            // blink yellow led once with 250ms period
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_YELLOW;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxNotificationIncoming;
-        }
-
-        if (uxNotificationQueued == uxState)
-        {
-            // loop yellow led on and off every 2 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 6;
-            toggleCountEnabled = 0;
-
-            rgbLedColor_t muteColour = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_YELLOW);
-
-            pit_led_color[0] = LED_COLOR_YELLOW;
-            pit_led_color[1] = LED_COLOR_OFF;
-            pit_led_color[2] = LED_COLOR_OFF;
-            pit_led_color[3] = muteColour;
-            pit_led_color[4] = LED_COLOR_OFF;
-            pit_led_color[5] = LED_COLOR_OFF;
-
-            /* When we have a notification queued we no longer hit idle state so we have to mark the end of speaking
-             * state*/
-            speakingState = false;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(1000000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxNotificationQueued;
-        }
-
-        if (uxNotificationCleared == uxState)
-        {
-            // stop loop of yellow on and off
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_OFF);
-
-            prevState = uxIdle;
-        }
-
-        if (uxDoNotDisturb == uxState)
-        {
-            // Blink purple led
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_PURPLE);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCount        = 1;
-            toggleCountEnabled = 1;
-            resumePrevState    = true;
-            pit_led_color[0]   = LED_COLOR_PURPLE;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            /* When we are in do not disturb state we no longer hit idle state so we have to mark the end of speaking
-             * state*/
-            speakingState = false;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            AIS_APP_GetAppData()->state = AIS_STATE_IDLE;
-
-            prevState = uxIdle;
-        }
-
-        if (uxReconnecting == uxState)
-        {
-            // loop green led on and off every 0.5 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_GREEN;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxReconnecting;
-        }
-
-        if (uxConnected == uxState)
-        {
-            // loop green led on and off every 0.25 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_GREEN;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxConnected;
-        }
-
-        if (uxBootUp == uxState)
-        {
-            // alternate blue and cyan every 1 second
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_BLUE;
-            pit_led_color[1]   = LED_COLOR_CYAN;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(1000000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxBootUp;
-        }
-
-        if (uxWiFiSetup == uxState)
-        {
-            // loop yellow led on and off every 0.5 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_YELLOW;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxWiFiSetup;
-        }
-
-        if (uxAccessPointFound == uxState)
-        {
-            // loop yellow led on and off every 0.25 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_YELLOW;
-            pit_led_color[1]   = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxAccessPointFound;
-        }
-
-        if (uxNoAccessPoint == uxState)
-        {
-            // loop yellow led and red led every 0.5 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_RED;
-            pit_led_color[1]   = LED_COLOR_YELLOW;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxNoAccessPoint;
-        }
-
-        if (uxInvalidWiFiCred == uxState)
-        {
-            // loop yellow led and red led every 0.25 seconds
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = LED_COLOR_RED;
-            pit_led_color[1]   = LED_COLOR_YELLOW;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxInvalidWiFiCred;
-        }
-
-        if (uxDiscovery == uxState)
-        {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-
-            // loop blue led and red led every 1 second if mute on, otherwise just blue
-            pit_led_index      = 0;
-            pit_led_count      = 4;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_BLUE);
-            pit_led_color[1]   = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_BLUE);
-            pit_led_color[2]   = LED_COLOR_BLUE;
-            pit_led_color[3]   = LED_COLOR_BLUE;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxDiscovery;
-        }
-
-        if (uxAuthentication == uxState)
-        {
-            toggleCountEnabled = 0;
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_YELLOW);
-
-            prevState = uxAuthentication;
-        }
-
-        if (uxDeviceChange == uxState)
-        {
-            /*leave the white led on for 2 ticks a total of 1s*/
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCount        = 2;
-            toggleCountEnabled = 1;
-            resumePrevState    = true;
-            pit_led_color[0]   = LED_COLOR_WHITE;
-            pit_led_color[1]   = LED_COLOR_WHITE;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxDeviceChange;
-        }
-
-        if (uxDisconnected == uxState)
-        {
-            // blink red 3 times every 0.5s
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCount        = 3;
-            toggleCountEnabled = 1;
-            /* We are disconnected. We need to ensure that the device goes back into the previous offline state */
-            resumePrevState  = true;
-            pit_led_color[0] = LED_COLOR_RED;
-            pit_led_color[1] = LED_COLOR_OFF;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxDisconnected;
-        }
-
-        if (uxError == uxState)
-        {
-            // toggle between red and white every 0.5 second for 6 times
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCount        = 6;
-            toggleCountEnabled = 1;
-            pit_led_color[0]   = LED_COLOR_RED;
-            pit_led_color[1]   = LED_COLOR_WHITE;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxError;
-        }
-
-        if (uxApMode == uxState)
-        {
-            /* set orange led */
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_ORANGE);
-            prevState = uxApMode;
-        }
-
-        if (uxBleProvision == uxState)
-        {
-            /* set orange led */
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_ORANGE);
-            prevState = uxBleProvision;
-        }
-
-        if (uxFSSProvision == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 0;
-            pit_led_count      = 2;
-            toggleCountEnabled = 0;
-            pit_led_color[0]   = ((audio_processing_get_mic_mute()) ? LED_COLOR_RED : LED_COLOR_OFF);
-            pit_led_color[1]   = LED_COLOR_ORANGE;
-
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxFSSProvision;
-        }
-
-        if (uxFactoryReset == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 1;
-            pit_led_count      = 2;
-            toggleCountEnabled = 1;
-            toggleCount        = 6;
-            pit_led_color[0]   = LED_COLOR_PURPLE;
-            pit_led_color[1]   = LED_COLOR_YELLOW;
-
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_PURPLE);
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(250000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxFactoryReset;
-        }
-
-        if (uxWiFiCredentialsErase == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 1;
-            pit_led_count      = 2;
-            toggleCountEnabled = 1;
-            toggleCount        = 3;
-            pit_led_color[0]   = LED_COLOR_PURPLE;
-            pit_led_color[1]   = LED_COLOR_GREEN;
-
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_PURPLE);
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxWiFiCredentialsErase;
-        }
-
-        if (uxUGSSessionRestart == uxState)
-        {
-            PIT_StopTimer(PIT, kPIT_Chnl_0);
-            pit_led_index      = 1;
-            pit_led_count      = 2;
-            toggleCountEnabled = 1;
-            toggleCount        = 3;
-            pit_led_color[0]   = LED_COLOR_PURPLE;
-            pit_led_color[1]   = LED_COLOR_GREEN;
-
-            RGB_LED_SetBrightnessColor(currentBrightness, LED_COLOR_PURPLE);
-            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(500000U, PIT_SOURCE_CLOCK));
-            PIT_StartTimer(PIT, kPIT_Chnl_0);
-
-            prevState = uxUGSSessionRestart;
-        }
-
-        uxState = uxNull;
+                break;
+
+            case uxTimerEnd:
+            case uxAlarmEnd:
+            case uxReminderEnd:
+            case uxNotificationCleared:
+                nextState = uxIdle;
+                break;
+
+            case uxNotificationQueued:
+                /* When we have a notification queued we no longer hit idle state so we have to mark the end of
+                 * speaking state*/
+                speakingState = false;
+                break;
+
+            case uxDoNotDisturb:
+                /* When we are in do not disturb state we no longer hit idle state so we have to mark the end of
+                 * speaking state*/
+                speakingState               = false;
+                AIS_APP_GetAppData()->state = AIS_STATE_IDLE;
+                nextState                   = uxIdle;
+                break;
+
+            default:
+                break;
+        }
+
+        prevState = nextState;
     }
 }
 
@@ -10,6 +10,7 @@
 #include "wifi_credentials.h"
 
 #include "sln_flash_mgmt.h"
+#include "tcpip_manager.h"
 
 #ifdef FFS_ENABLED
 
@@ -168,6 +169,9 @@ status_t wifi_credentials_flash_reset(void)
         {
             status = kStatus_Fail;
         }
+
+        /* The lease belongs to the network just forgotten */
+        TCPIP_MANAGER_forget_lease();
     }
 
     return status;
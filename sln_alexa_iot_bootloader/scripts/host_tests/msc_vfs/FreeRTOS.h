@@ -0,0 +1,32 @@
+/*
+ * Host stand-in for FreeRTOS.h. The tasks are POSIX threads and the queues and
+ * semaphores are built on a mutex and condition variable, see pthread_rtos.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define portSTACK_TYPE     StackType_t
+#define portMAX_DELAY      ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE  ((BaseType_t)1)
+#define pdPASS  (pdTRUE)
+#define pdFAIL  (pdFALSE)
+
+/* Kept by the test, which checks the progress lines */
+void msc_vfs_log(const char *fmt, ...);
+#define configPRINTF(x) msc_vfs_log x
+
+#endif /* INC_FREERTOS_H */
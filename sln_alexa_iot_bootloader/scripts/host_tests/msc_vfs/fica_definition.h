@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for fica_definition.h. The banks keep their addresses on the
+ * 10 MB bank layout, but are cut down to 1 MB each.
+ */
+
+#ifndef _FICA_DEFINITION_H_
+#define _FICA_DEFINITION_H_
+
+#define FICA_IMG_APP_A_SIZE 0x00100000
+#define FICA_IMG_APP_B_SIZE 0x00100000
+
+#define FICA_IMG_APP_A_ADDR 0x00300000
+#define FICA_IMG_APP_B_ADDR 0x00D00000
+
+typedef enum _fica_img_type
+{
+    FICA_IMG_TYPE_NONE = -1,
+    FICA_IMG_TYPE_BOOTLOADER,
+    FICA_IMG_TYPE_APP_A,
+    FICA_IMG_TYPE_APP_B,
+    FICA_NUM_IMG_TYPES,
+} fica_img_type_t;
+
+#endif /* _FICA_DEFINITION_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Host stand-in for flash_ica_driver.h: the bank programming calls of the MSC
+ * writer, backed by the simulated flash of the test.
+ */
+
+#ifndef _FLASH_ICA_DRIVER_H_
+#define _FLASH_ICA_DRIVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fica_definition.h"
+
+#define SLN_FLASH_NO_ERROR 0
+#define SLN_FLASH_ERROR    -1
+
+#define EXT_FLASH_PROGRAM_PAGE 0x200
+#define EXT_FLASH_ERASE_PAGE   0x1000
+
+int32_t FICA_initialize(void);
+int32_t FICA_GetImgTypeFromAddr(uint32_t appaddr, int32_t *imgtype);
+int32_t FICA_app_program_ext_init_no_erase(int32_t newimgtype);
+int32_t FICA_app_program_ext_erase_sector(uint32_t offset);
+int32_t FICA_app_program_ext_abs(uint32_t offset, uint8_t *pbuf, uint32_t len);
+int32_t FICA_get_app_img_start_addr(int32_t imgtype, uint32_t *startaddr);
+int32_t FICA_get_app_img_max_size(int32_t imgtype, uint32_t *maximgsize);
+
+#endif /* _FLASH_ICA_DRIVER_H_ */
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for fsl_common.h.
+ */
+
+#ifndef _FSL_COMMON_H_
+#define _FSL_COMMON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef int32_t status_t;
+
+enum
+{
+    kStatus_Success = 0,
+    kStatus_Fail    = 1,
+};
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+#define FlexSPI_AMBA_BASE (0x60000000U)
+
+#endif /* _FSL_COMMON_H_ */
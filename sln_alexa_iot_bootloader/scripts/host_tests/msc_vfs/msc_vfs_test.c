@@ -0,0 +1,498 @@
+/*
+ * Host check of the USB mass storage update of sln_msc_vfs.c: host writes
+ * are replayed against the staging ring and the flash writer task.
+ *
+ * sln_msc_vfs.c is built against the stub headers in this directory, its
+ * writer task is a POSIX thread (pthread_rtos.c). The two application banks
+ * are kept in RAM and behave as NOR: a program may only touch erased bytes.
+ * Each bank starts out holding an older, longer image, with a blank hole in
+ * it. The main thread plays the USB device task: it writes the FAT volume
+ * the way a host copies a .BIN file to it, in transfers of 1 to 32 blocks.
+ *
+ *  - size last: the directory entry is created empty and only gets its size
+ *    after the data, as Windows does. Every sector is erased on demand;
+ *  - size early: the size is written after the first 64 KB. The writer erases
+ *    the rest of the file ahead while the host pauses, the data after the
+ *    pause needs no erase;
+ *  - slow flash: page programs take 300 us, the ring fills up and the USB
+ *    writes wait for the writer;
+ *  - flash error: a page program fails, the USB writes return an error
+ *    instead of waiting and the application task is woken up.
+ *
+ * After each transfer the bank holds the data written, each sector of the
+ * file was erased once, the sectors past it are blank and the blank ones
+ * were only read. The CRC-32 logged is the one of the data saved.
+ *
+ * Build and run with "make -C scripts/host_tests msc_vfs".
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "FreeRTOS.h"
+#include "flash_ica_driver.h"
+#include "fsl_common.h"
+#include "sln_flash.h"
+#include "sln_msc_vfs.h"
+
+#define TEST_BANK_SIZE    FICA_IMG_APP_A_SIZE
+#define TEST_SECTORS      (TEST_BANK_SIZE / EXT_FLASH_ERASE_PAGE)
+#define TEST_LBA          512U
+#define TEST_WINDOW_LBAS  0x20U /* USB write buffer of disk.c */
+#define TEST_ROOT_DIR_LBA 24U   /* Reserved sectors and two FATs of 8 sectors */
+#define TEST_FAT_LBA      8U
+#define TEST_DATA_LBA     56U   /* Past the 512 root directory entries */
+#define TEST_CLUSTER      (8U * TEST_LBA)
+#define TEST_OLD_IMAGE    (900U * 1024U)
+#define TEST_HOLE_START   (700U * 1024U)
+#define TEST_HOLE_END     (800U * 1024U)
+#define TEST_EARLY_SIZE   (64U * 1024U)
+#define TEST_TIMEOUT_S    60
+
+static const char *s_scenario = "init";
+
+#define FAIL(...)                                      \
+    do {                                               \
+        printf("msc vfs: %s: ", s_scenario);           \
+        printf(__VA_ARGS__);                           \
+        printf("\n");                                  \
+        exit(1);                                       \
+    } while (0)
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint8_t s_flash[2][TEST_BANK_SIZE];
+static uint32_t s_erases[2][TEST_SECTORS];
+static uint32_t s_erasesAhead;
+static int s_bank = -1;
+static uint32_t s_programDelayUs;
+static uint32_t s_failOffset = UINT32_MAX;
+static volatile uint32_t s_hostStaged; /* Image bytes handed to MSC_VFS_WriteResponse */
+static uint32_t s_length;
+
+static char s_savedLine[256];
+static char s_tailLine[256];
+
+static uint8_t s_disk[TEST_WINDOW_LBAS * TEST_LBA];
+static TaskHandle_t s_appTask;
+static uint8_t s_file[TEST_BANK_SIZE];
+
+void msc_vfs_log(const char *fmt, ...)
+{
+    char line[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    pthread_mutex_lock(&s_lock);
+    if (strstr(line, "bytes saved in") != NULL) {
+        strcpy(s_savedLine, line);
+    } else if (strstr(line, "past the end") != NULL) {
+        strcpy(s_tailLine, line);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void timed_out(int sig)
+{
+    static const char msg[] = "msc vfs: timed out\n";
+
+    write(1, msg, sizeof(msg) - 1);
+    _exit(1);
+}
+
+static int bank_index(int32_t imgtype)
+{
+    return (FICA_IMG_TYPE_APP_A == imgtype) ? 0 : 1;
+}
+
+int32_t FICA_initialize(void)
+{
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_GetImgTypeFromAddr(uint32_t appaddr, int32_t *imgtype)
+{
+    *imgtype = (FICA_IMG_APP_A_ADDR == appaddr) ? FICA_IMG_TYPE_APP_A :
+               (FICA_IMG_APP_B_ADDR == appaddr) ? FICA_IMG_TYPE_APP_B : FICA_IMG_TYPE_NONE;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_init_no_erase(int32_t newimgtype)
+{
+    s_bank = bank_index(newimgtype);
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_get_app_img_start_addr(int32_t imgtype, uint32_t *startaddr)
+{
+    *startaddr = (FICA_IMG_TYPE_APP_A == imgtype) ? FICA_IMG_APP_A_ADDR : FICA_IMG_APP_B_ADDR;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_get_app_img_max_size(int32_t imgtype, uint32_t *maximgsize)
+{
+    *maximgsize = TEST_BANK_SIZE;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_erase_sector(uint32_t offset)
+{
+    if (offset >= TEST_BANK_SIZE || s_bank < 0) {
+        FAIL("erase at 0x%x outside of the bank", offset);
+    }
+    offset -= offset % EXT_FLASH_ERASE_PAGE;
+    memset(s_flash[s_bank] + offset, 0xFF, EXT_FLASH_ERASE_PAGE);
+    s_erases[s_bank][offset / EXT_FLASH_ERASE_PAGE]++;
+    if (offset >= s_hostStaged && offset < s_length) {
+        s_erasesAhead++;
+    }
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_abs(uint32_t offset, uint8_t *pbuf, uint32_t len)
+{
+    if (offset + len > TEST_BANK_SIZE || s_bank < 0) {
+        FAIL("program of %u bytes at 0x%x outside of the bank", len, offset);
+    }
+    if (offset / EXT_FLASH_PROGRAM_PAGE != (offset + len - 1) / EXT_FLASH_PROGRAM_PAGE) {
+        FAIL("program of %u bytes at 0x%x across a page", len, offset);
+    }
+    if (s_programDelayUs != 0) {
+        usleep(s_programDelayUs);
+    }
+    if (offset <= s_failOffset && s_failOffset < offset + len) {
+        return SLN_FLASH_ERROR;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (s_flash[s_bank][offset + i] != 0xFF) {
+            FAIL("program at 0x%x over a byte not erased", offset + i);
+        }
+    }
+    memcpy(s_flash[s_bank] + offset, pbuf, len);
+    return SLN_FLASH_NO_ERROR;
+}
+
+status_t SLN_Read_Flash_At_Address(uint32_t address, uint8_t *data, uint32_t size)
+{
+    int bank = (address >= FICA_IMG_APP_B_ADDR) ? 1 : 0;
+    uint32_t offset = address - ((bank == 0) ? FICA_IMG_APP_A_ADDR : FICA_IMG_APP_B_ADDR);
+
+    if (offset + size > TEST_BANK_SIZE) {
+        FAIL("read of %u bytes at 0x%x outside of the banks", size, address);
+    }
+    memcpy(data, s_flash[bank] + offset, size);
+    return kStatus_Success;
+}
+
+static uint32_t crc32(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+        }
+    }
+    return ~crc;
+}
+
+/* An older, longer image with a blank hole, erases counted from here */
+static void old_image(int bank)
+{
+    for (uint32_t i = 0; i < TEST_BANK_SIZE; i++) {
+        s_flash[bank][i] = (i < TEST_OLD_IMAGE && (i < TEST_HOLE_START || i >= TEST_HOLE_END)) ? (uint8_t)(i * 13 + 5) :
+                                                                                                 0xFF;
+    }
+    memset(s_erases, 0, sizeof(s_erases));
+    s_erasesAhead = 0;
+}
+
+static void make_file(int bank, uint32_t length)
+{
+    uint32_t reset = FlexSPI_AMBA_BASE | ((bank == 0) ? FICA_IMG_APP_A_ADDR : FICA_IMG_APP_B_ADDR) | 0x2401;
+
+    for (uint32_t i = 0; i < length; i++) {
+        s_file[i] = (uint8_t)rand();
+    }
+    memcpy(&s_file[4], &reset, sizeof(reset));
+}
+
+/* Writes the blocks in USB transfers of 1 to 32 blocks, each one through the window buffer */
+static status_t host_write(uint32_t lba, const uint8_t *data, uint32_t blocks)
+{
+    status_t status = kStatus_Success;
+
+    while (blocks > 0 && status == kStatus_Success) {
+        uint32_t count = 1 + rand() % TEST_WINDOW_LBAS;
+        uint8_t *buffer;
+
+        count = (count > blocks) ? blocks : count;
+        count = (count > TEST_WINDOW_LBAS - lba % TEST_WINDOW_LBAS) ? TEST_WINDOW_LBAS - lba % TEST_WINDOW_LBAS :
+                                                                      count;
+        buffer = &s_disk[(lba % TEST_WINDOW_LBAS) * TEST_LBA];
+        memcpy(buffer, data, count * TEST_LBA);
+        status = MSC_VFS_WriteResponse(lba, count * TEST_LBA, buffer);
+
+        lba += count;
+        data += count * TEST_LBA;
+        blocks -= count;
+    }
+    return status;
+}
+
+/* The root directory sector, with a volume label, a long name and a deleted entry before the file */
+static void host_write_dir(uint32_t size)
+{
+    uint8_t sector[TEST_LBA] = {0};
+    fat_file_t *entries = (fat_file_t *)sector;
+
+    memcpy(entries[0].name, "SLN-BOOT   ", 11);
+    entries[0].attributes = FAT_ATTR_VOLUME_ID;
+    memcpy(entries[1].name, "AOLDAPPBIN ", 11);
+    entries[1].attributes = 0x0F;
+    memcpy(entries[2].name, "\xE5OLD    BIN", 11);
+    entries[2].size = 12345;
+    memcpy(entries[3].name, "APP     BIN", 11);
+    entries[3].attributes = 0x20;
+    entries[3].first_cluster_lower = 2;
+    entries[3].size = size;
+
+    host_write(TEST_ROOT_DIR_LBA, sector, 1);
+}
+
+static void host_write_fat(uint32_t length)
+{
+    uint8_t sector[TEST_LBA];
+    uint16_t *fat = (uint16_t *)sector;
+    uint32_t clusters = (length + TEST_CLUSTER - 1) / TEST_CLUSTER;
+
+    memset(sector, 0, sizeof(sector));
+    fat[0] = 0xFFF0;
+    fat[1] = 0xFFFF;
+    for (uint32_t i = 0; i < clusters && i + 2 < TEST_LBA / 2; i++) {
+        fat[i + 2] = (i + 1 == clusters) ? 0xFFFF : (uint16_t)(i + 3);
+    }
+    host_write(TEST_FAT_LBA, sector, 1);
+}
+
+/* Data from the image offset, up to the block holding the end */
+static status_t host_write_data(uint32_t from, uint32_t to)
+{
+    s_hostStaged = to;
+    return host_write(TEST_DATA_LBA + from / TEST_LBA, &s_file[from], (to - from + TEST_LBA - 1) / TEST_LBA);
+}
+
+static void start(int bank, uint32_t length)
+{
+    s_savedLine[0] = 0;
+    s_tailLine[0] = 0;
+    s_hostStaged = 0;
+    s_length = length;
+    s_bank = -1;
+    old_image(bank);
+    make_file(bank, length);
+    if (MSC_VFS_Init(s_disk, &s_appTask, TEST_LBA) != kStatus_Success) {
+        FAIL("init failed");
+    }
+}
+
+/* The application task is woken up at the end, the bank holds the file and nothing of the old image.
+ * Returns the number of sectors erased past the file. */
+static uint32_t check_saved(int bank, uint32_t length, uint32_t written)
+{
+    uint32_t fileSectors = (length + EXT_FLASH_ERASE_PAGE - 1) / EXT_FLASH_ERASE_PAGE;
+    uint32_t saved = 0;
+    uint32_t crc = 0;
+    uint32_t tail = 0;
+
+    pthread_task_suspend(s_appTask);
+    if (MSC_VFS_GetTransferState() != TRANSFER_FINAL) {
+        FAIL("transfer state %d at the end", MSC_VFS_GetTransferState());
+    }
+    if (s_bank != bank) {
+        FAIL("bank %d programmed, the image is for bank %d", s_bank, bank);
+    }
+    if (sscanf(s_savedLine, "[Write Response] %u bytes saved in %*d ms, CRC32 0x%x", &saved, &crc) != 2) {
+        FAIL("no end of transfer line logged");
+    }
+    if (saved < length || saved > written || crc != crc32(s_file, saved)) {
+        FAIL("logged %u bytes saved with CRC32 0x%08x, the file is %u bytes long", saved, crc, length);
+    }
+    if (memcmp(s_flash[bank], s_file, saved) != 0) {
+        FAIL("bank differs from the data written");
+    }
+    for (uint32_t sector = 0; sector < TEST_SECTORS; sector++) {
+        uint32_t offset = sector * EXT_FLASH_ERASE_PAGE;
+        bool oldData = offset < TEST_OLD_IMAGE && (offset < TEST_HOLE_START || offset >= TEST_HOLE_END);
+
+        if (sector < fileSectors) {
+            if (s_erases[bank][sector] != 1) {
+                FAIL("sector %u of the file erased %u times", sector, s_erases[bank][sector]);
+            }
+            continue;
+        }
+        for (uint32_t i = (offset < saved) ? saved - offset : 0; i < EXT_FLASH_ERASE_PAGE; i++) {
+            if (s_flash[bank][offset + i] != 0xFF) {
+                FAIL("old image left at 0x%x, past the end of the file", offset + i);
+            }
+        }
+        if (s_erases[bank][sector] != (oldData ? 1 : 0)) {
+            FAIL("sector %u past the file erased %u times, it %s", sector, s_erases[bank][sector],
+                 oldData ? "held the old image" : "was blank");
+        }
+        tail += s_erases[bank][sector];
+    }
+    if (tail != 0 && strtoul(s_tailLine + strlen("[Write Response] "), NULL, 10) != tail) {
+        FAIL("%u sectors erased past the file, logged: %s", tail, s_tailLine);
+    }
+    return tail;
+}
+
+static uint32_t total_erases(int bank)
+{
+    uint32_t erases = 0;
+
+    for (uint32_t sector = 0; sector < TEST_SECTORS; sector++) {
+        erases += s_erases[bank][sector];
+    }
+    return erases;
+}
+
+/* Created empty, the size is written once the data is, so every erase is on demand */
+static void size_last(void)
+{
+    uint32_t length = 600 * 1024 + 1234;
+    uint32_t written = (length + TEST_LBA - 1) / TEST_LBA * TEST_LBA;
+    uint32_t tail;
+
+    s_scenario = "size last";
+    start(0, length);
+    host_write_dir(0);
+    host_write_data(0, length);
+    host_write_fat(length);
+    host_write_dir(length);
+    tail = check_saved(0, length, written);
+    if (s_erasesAhead != 0) {
+        FAIL("%u sectors erased ahead before the size was known", s_erasesAhead);
+    }
+    printf("msc vfs: size last: %u bytes saved, %u sectors erased on demand, %u past the file\n", length,
+           total_erases(0) - tail, tail);
+}
+
+/* The size comes after 64 KB, the rest of the file is erased while the host pauses */
+static void size_early(void)
+{
+    uint32_t length = 500 * 1024 + 77;
+    uint32_t written = (length + TEST_CLUSTER - 1) / TEST_CLUSTER * TEST_CLUSTER;
+    uint32_t fileSectors = (length + EXT_FLASH_ERASE_PAGE - 1) / EXT_FLASH_ERASE_PAGE;
+    uint32_t erased = 0;
+    uint32_t before;
+    uint32_t tail;
+
+    s_scenario = "size early";
+    start(1, length);
+    memset(&s_file[length], 0, written - length);
+    host_write_data(0, TEST_EARLY_SIZE);
+    host_write_fat(length);
+    host_write_dir(length);
+
+    for (int wait = 0; wait < 5000 && erased < fileSectors; wait++) {
+        usleep(1000);
+        erased = 0;
+        for (uint32_t sector = 0; sector < fileSectors; sector++) {
+            erased += (s_erases[1][sector] != 0);
+        }
+    }
+    if (erased != fileSectors) {
+        FAIL("%u of %u sectors of the file erased during the pause", erased, fileSectors);
+    }
+    if (s_erasesAhead != fileSectors - TEST_EARLY_SIZE / EXT_FLASH_ERASE_PAGE) {
+        FAIL("%u sectors erased ahead, %u expected", s_erasesAhead,
+             fileSectors - TEST_EARLY_SIZE / EXT_FLASH_ERASE_PAGE);
+    }
+
+    before = total_erases(1);
+    host_write_data(TEST_EARLY_SIZE, written);
+    tail = check_saved(1, length, written);
+    if (total_erases(1) - before != tail) {
+        FAIL("%u sectors of the file erased after the pause", total_erases(1) - before);
+    }
+    printf("msc vfs: size early: %u bytes saved, %u of %u sectors erased ahead, %u past the file\n", length,
+           s_erasesAhead, fileSectors, tail);
+}
+
+/* The ring fills up, the USB writes wait for the writer */
+static void slow_flash(void)
+{
+    uint32_t length = 256 * 1024;
+    uint32_t waits = 0;
+    uint32_t from;
+
+    s_scenario = "slow flash";
+    start(0, length);
+    s_programDelayUs = 300;
+    for (from = 0; from < length; from += MSC_VFS_STAGING_SIZE / 4) {
+        TickType_t tick = xTaskGetTickCount();
+
+        host_write_data(from, from + MSC_VFS_STAGING_SIZE / 4);
+        waits += (xTaskGetTickCount() - tick) > 2;
+    }
+    host_write_dir(length);
+    check_saved(0, length, length);
+    s_programDelayUs = 0;
+    if (waits == 0) {
+        FAIL("the USB writes never waited for the writer");
+    }
+    printf("msc vfs: slow flash: %u of %u host writes waited for room in the %u byte ring\n", waits,
+           length / (MSC_VFS_STAGING_SIZE / 4), MSC_VFS_STAGING_SIZE);
+}
+
+/* A failed page program ends the transfer, the USB writes are refused instead of waiting */
+static void flash_error(void)
+{
+    uint32_t length = 300 * 1024;
+    status_t status = kStatus_Success;
+    uint32_t from;
+
+    s_scenario = "flash error";
+    start(1, length);
+    s_failOffset = 200 * 1024 + 100;
+    for (from = 0; from < length && status == kStatus_Success; from += 16 * 1024) {
+        status = host_write_data(from, from + 16 * 1024);
+    }
+    pthread_task_suspend(s_appTask);
+    if (MSC_VFS_GetTransferState() != TRANSFER_ERROR) {
+        FAIL("transfer state %d after the failed program", MSC_VFS_GetTransferState());
+    }
+    if (status == kStatus_Success) {
+        status = host_write_data(from, from + 16 * 1024);
+    }
+    if (status == kStatus_Success) {
+        FAIL("writes still accepted after the failed program");
+    }
+    s_failOffset = UINT32_MAX;
+    printf("msc vfs: flash error: writes refused %u bytes after the failed page\n", from - 200 * 1024);
+}
+
+int main(void)
+{
+    signal(SIGALRM, timed_out);
+    alarm(TEST_TIMEOUT_S);
+    srand(40);
+
+    s_appTask = pthread_task_create();
+
+    size_last();
+    size_early();
+    slow_flash();
+    flash_error();
+    return 0;
+}
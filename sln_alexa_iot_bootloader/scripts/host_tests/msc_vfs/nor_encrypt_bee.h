@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for nor_encrypt_bee.h, sln_msc_vfs.c calls none of it.
+ */
+
+#ifndef _NOR_ENCRYPT_BEE_H_
+#define _NOR_ENCRYPT_BEE_H_
+
+#endif /* _NOR_ENCRYPT_BEE_H_ */
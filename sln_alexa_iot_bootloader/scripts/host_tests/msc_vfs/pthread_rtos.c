@@ -0,0 +1,166 @@
+/*
+ * The FreeRTOS calls of sln_msc_vfs.c on POSIX threads. Each task is a
+ * detached thread, a queue is a ring of items under one mutex, with a
+ * condition variable for each direction. A binary semaphore is a queue of
+ * one empty item.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+
+struct pthread_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct pthread_task {
+    pthread_mutex_t lock;
+    pthread_cond_t resumed;
+    bool pending;
+};
+
+struct task_start {
+    TaskFunction_t code;
+    void *params;
+};
+
+static void *task_main(void *arg)
+{
+    struct task_start start = *(struct task_start *)arg;
+
+    free(arg);
+    start.code(start.params);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created)
+{
+    struct task_start *start = malloc(sizeof(*start));
+    pthread_t thread;
+
+    start->code = code;
+    start->params = params;
+    if (pthread_create(&thread, NULL, task_main, start) != 0) {
+        free(start);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+TaskHandle_t pthread_task_create(void)
+{
+    TaskHandle_t task = calloc(1, sizeof(*task));
+
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->resumed, NULL);
+    return task;
+}
+
+void pthread_task_suspend(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    while (!task->pending) {
+        pthread_cond_wait(&task->resumed, &task->lock);
+    }
+    task->pending = false;
+    pthread_mutex_unlock(&task->lock);
+}
+
+void vTaskResume(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->pending = true;
+    pthread_cond_signal(&task->resumed);
+    pthread_mutex_unlock(&task->lock);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+    queue->items = calloc(length, itemSize ? itemSize : 1);
+    queue->length = length;
+    queue->item_size = itemSize;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (wait == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    if (queue->item_size != 0) {
+        memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], item,
+               queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (wait == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFAIL;
+        }
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+    if (queue->item_size != 0) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    return xQueueReceive(sem, NULL, wait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return xQueueSend(sem, NULL, 0);
+}
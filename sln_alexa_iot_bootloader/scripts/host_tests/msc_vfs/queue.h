@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for queue.h, only the two timeouts used, 0 and portMAX_DELAY.
+ */
+
+#ifndef INC_QUEUE_H
+#define INC_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct pthread_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t wait);
+
+#endif /* INC_QUEUE_H */
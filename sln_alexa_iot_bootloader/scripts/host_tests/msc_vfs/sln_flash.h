@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for sln_flash.h, reads of the simulated flash of the test.
+ */
+
+#ifndef _SLN_FLASH_H_
+#define _SLN_FLASH_H_
+
+#include "fsl_common.h"
+
+status_t SLN_Read_Flash_At_Address(uint32_t address, uint8_t *data, uint32_t size);
+
+#endif /* _SLN_FLASH_H_ */
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for task.h, each task is a detached POSIX thread.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct pthread_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t code, const char *name, uint32_t stackDepth, void *params,
+                       UBaseType_t priority, TaskHandle_t *created);
+TickType_t xTaskGetTickCount(void);
+
+/* Wakes up a task waiting in pthread_task_suspend() */
+void vTaskResume(TaskHandle_t task);
+
+/* Host only: a task made by pthread_task_create() for the main thread waits here for vTaskResume() */
+TaskHandle_t pthread_task_create(void);
+void pthread_task_suspend(TaskHandle_t task);
+
+#endif /* INC_TASK_H */
@@ -0,0 +1,22 @@
+/*
+ * Host stand-in for FreeRTOS.h, just enough to build aws_ota_pal.c.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef long BaseType_t;
+typedef uint32_t TickType_t;
+typedef void *TaskHandle_t;
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(ptr)     free(ptr)
+
+#define vTaskDelay(ticks)           ((void)(ticks))
+#define xTaskNotifyGive(task)       ((void)(task))
+
+#endif /* INC_FREERTOS_H */
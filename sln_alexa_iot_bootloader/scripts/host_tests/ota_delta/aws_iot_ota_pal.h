@@ -0,0 +1,79 @@
+/*
+ * Host stand-in for aws_iot_ota_pal.h: the OTA types aws_ota_pal.c uses and the
+ * PAL entry points the test drives.
+ */
+
+#ifndef _AWS_IOT_OTA_PAL_H_
+#define _AWS_IOT_OTA_PAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+
+typedef uint32_t OTA_Err_t;
+
+#define kOTA_Err_None               0x00000000UL
+#define kOTA_Err_Uninitialized      0xff000000UL
+#define kOTA_Err_RxFileCreateFailed 0x0e000000UL
+#define kOTA_Err_FileClose          0x1b000000UL
+#define kOTA_Err_BadImageState      0x08000000UL
+
+typedef enum
+{
+    eOTA_ImageState_Unknown = 0,
+    eOTA_ImageState_Testing,
+    eOTA_ImageState_Accepted,
+    eOTA_ImageState_Rejected,
+    eOTA_ImageState_Aborted,
+} OTA_ImageState_t;
+
+typedef enum
+{
+    eOTA_PAL_ImageState_Unknown = 0,
+    eOTA_PAL_ImageState_PendingCommit,
+    eOTA_PAL_ImageState_Valid,
+    eOTA_PAL_ImageState_Invalid,
+} OTA_PAL_ImageState_t;
+
+typedef enum
+{
+    eOTA_AgentState_Ready = 1,
+    eOTA_AgentState_WaitingForFileBlock,
+    eOTA_AgentState_ShuttingDown,
+} OTA_State_t;
+
+#define OTA_FILE_SIG_KEY_STR_MAX_LENGTH 32
+
+/* The signature is only checked for NULL here, it is verified by the bootloader */
+typedef struct
+{
+    uint16_t usSize;
+    uint8_t *ucData;
+} Sig256_t;
+
+typedef struct
+{
+    uint8_t *pucFilePath;
+    uint8_t *pucFile;
+    uint32_t ulFileSize;
+    uint32_t ulBlocksRemaining;
+    bool xIsInSelfTest;
+    Sig256_t *pxSignature;
+} OTA_FileContext_t;
+
+#define DEFINE_OTA_METHOD_NAME(name) static const char OTA_METHOD_NAME[] __attribute__((unused)) = name
+#define OTA_LOG_L1(...)              ota_delta_log(__VA_ARGS__)
+
+void ota_delta_log(const char *fmt, ...);
+OTA_State_t OTA_GetAgentState(void);
+
+OTA_Err_t prvPAL_CreateFileForRx(OTA_FileContext_t *const C);
+OTA_Err_t prvPAL_Abort(OTA_FileContext_t *const C);
+int16_t prvPAL_WriteBlock(OTA_FileContext_t *const C, uint32_t ulOffset, uint8_t *const pacData, uint32_t ulBlockSize);
+OTA_Err_t prvPAL_CloseFile(OTA_FileContext_t *const C);
+OTA_Err_t prvPAL_ResetDevice(void);
+
+#endif /* _AWS_IOT_OTA_PAL_H_ */
@@ -0,0 +1,11 @@
+/*
+ * Host stand-in for aws_ota_agent_config.h, with the block size of the target.
+ */
+
+#ifndef _AWS_OTA_AGENT_CONFIG_H_
+#define _AWS_OTA_AGENT_CONFIG_H_
+
+#define otaconfigLOG2_FILE_BLOCK_SIZE   12UL
+#define otaconfigMAX_NUM_BLOCKS_REQUEST 32U
+
+#endif /* _AWS_OTA_AGENT_CONFIG_H_ */
@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for board.h, aws_ota_pal.c needs nothing from it on the host.
+ */
+
+#ifndef _BOARD_H_
+#define _BOARD_H_
+
+#define ENABLE_UNSIGNED_USB_MSD 0
+
+#endif /* _BOARD_H_ */
@@ -0,0 +1,12 @@
+/*
+ * Host stand-in for fica_definition.h, the image types only.
+ */
+
+#ifndef _FICA_DEFINITION_H_
+#define _FICA_DEFINITION_H_
+
+#define FICA_IMG_TYPE_NONE  -1
+#define FICA_IMG_TYPE_APP_A 1
+#define FICA_IMG_TYPE_APP_B 2
+
+#endif /* _FICA_DEFINITION_H_ */
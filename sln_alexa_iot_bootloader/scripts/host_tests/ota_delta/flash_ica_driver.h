@@ -0,0 +1,30 @@
+/*
+ * Host stand-in for flash_ica_driver.h: the bank programming calls of the PAL,
+ * backed by the simulated flash of the test.
+ */
+
+#ifndef _FLASH_ICA_DRIVER_H_
+#define _FLASH_ICA_DRIVER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SLN_FLASH_NO_ERROR 0
+#define SLN_FLASH_ERROR    -1
+
+#define EXT_FLASH_PROGRAM_PAGE 0x200
+#define EXT_FLASH_ERASE_PAGE   0x1000
+
+int32_t FICA_app_program_ext_init(int32_t newimgtype);
+int32_t FICA_app_program_ext_erase_sector(uint32_t offset);
+int32_t FICA_app_program_ext_abs(uint32_t offset, uint8_t *pbuf, uint32_t len);
+int32_t FICA_app_program_ext_stage(uint32_t offset, uint8_t *pbuf, uint32_t len);
+int32_t FICA_app_program_ext_finalize(void);
+int32_t FICA_app_program_ext_set_reset_vector(void);
+int32_t FICA_Save_Signature(uint8_t *sig);
+int32_t FICA_Clear_OTA_FlashBit(void);
+int32_t FICA_GetCurAppStartType(int32_t *imgtype);
+int32_t FICA_get_app_img_start_addr(int32_t imgtype, uint32_t *startaddr);
+int32_t FICA_get_app_img_max_size(int32_t imgtype, uint32_t *maxsize);
+
+#endif /* _FLASH_ICA_DRIVER_H_ */
@@ -0,0 +1,12 @@
+/*
+ * mbedTLS configuration of the host delta check: SHA256 for the image digests.
+ */
+
+#ifndef HOST_MBEDTLS_CONFIG_H
+#define HOST_MBEDTLS_CONFIG_H
+
+#define MBEDTLS_SHA256_C
+
+#include "mbedtls/check_config.h"
+
+#endif /* HOST_MBEDTLS_CONFIG_H */
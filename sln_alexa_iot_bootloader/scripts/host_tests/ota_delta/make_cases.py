@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""
+Write the image pairs of the delta check and their deltas, made with
+gen_delta() from scripts/sln_delta_gen.py:
+
+    <out>/caseN.old  image running in the source bank
+    <out>/caseN.new  image the delta rebuilds
+    <out>/caseN.delta
+"""
+
+import os
+import random
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..'))
+
+from sln_delta_gen import gen_delta
+
+
+def code_like(rnd, length):
+    # Repeating instruction-like words, so the matcher finds shifted runs
+    words = [rnd.getrandbits(32).to_bytes(4, 'little') for _ in range(64)]
+    return b''.join(rnd.choice(words) if rnd.random() < 0.7 else rnd.getrandbits(32).to_bytes(4, 'little')
+                    for _ in range(length // 4))
+
+
+def patch(rnd, img, count):
+    img = bytearray(img)
+    for _ in range(count):
+        pos = rnd.randrange(len(img))
+        img[pos] ^= 1 + rnd.randrange(255)
+    return bytes(img)
+
+
+def main():
+    out_dir = sys.argv[1]
+    rnd = random.Random(28)
+    base = code_like(rnd, 300 * 1024)
+    cases = [
+        # A few patched bytes
+        (base, patch(rnd, base, 40)),
+        # Code inserted in the middle, a function removed later: everything after is shifted
+        (base, base[:70000] + code_like(rnd, 3000) + base[70000:200000] + base[203000:]),
+        # Nothing in common, the delta is all inserts
+        (base, code_like(rnd, 180 * 1024 + 123)),
+        # Same image
+        (base, base),
+        # Smaller image, not a whole number of blocks
+        (base, base[:123457]),
+        # Bigger image, data appended
+        (base[:150000], base[:150000] + code_like(rnd, 90000) + b'\xff' * 5000 + b'\x00' * 7),
+    ]
+
+    for idx, (old, new) in enumerate(cases):
+        delta = gen_delta(old, new)
+        for ext, data in (('old', old), ('new', new), ('delta', delta)):
+            with open(os.path.join(out_dir, 'case%d.%s' % (idx, ext)), 'wb') as f:
+                f.write(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,431 @@
+/*
+ * Host check of delta OTA: images encoded by scripts/sln_delta_gen.py are
+ * rebuilt by the C decoder sln_delta.c, directly and through aws_ota_pal.c.
+ *
+ * aws_ota_pal.c is built against the stub headers in this directory. The two
+ * application banks are kept in RAM and behave as NOR: a program may only
+ * touch erased bytes, so a parked block landing on the rebuilt image, or the
+ * image on a parked block, is caught.
+ *
+ * For each case written by make_cases.py:
+ *  - the delta is fed to SLN_DELTA_Feed in chunks of random size and the
+ *    rebuilt image compared with the new image;
+ *  - the delta is received through the PAL the way the OTA agent does it:
+ *    each stream request asks for the first otaconfigMAX_NUM_BLOCKS_REQUEST
+ *    missing blocks, which arrive shuffled and some get lost. After the close
+ *    the bank holds the new image, the image length handed to FICA is the new
+ *    image length and the rest of the bank is erased;
+ *  - a byte of the delta is flipped: the PAL has to fail the block or the
+ *    close, unless the flip still rebuilds the same image (a copy from
+ *    another offset holding the same bytes). It may never finalize a wrong
+ *    image.
+ *
+ * Build and run with "make -C scripts/host_tests ota_delta".
+ */
+
+#include <stdarg.h>
+
+#include "aws_iot_ota_pal.h"
+#include "aws_ota_agent_config.h"
+#include "flash_ica_driver.h"
+#include "fica_definition.h"
+#include "sln_ota.h"
+#include "sln_delta.h"
+
+#define TEST_BANK_SIZE   0x100000
+#define TEST_BLOCK_SIZE  (1UL << otaconfigLOG2_FILE_BLOCK_SIZE)
+#define TEST_MAX_BLOCKS  ((TEST_BANK_SIZE + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE)
+#define TEST_PAL_RUNS    20
+#define TEST_SPLIT_RUNS  10
+#define TEST_FLIP_RUNS   40
+
+static uint8_t s_flash[2 * TEST_BANK_SIZE];
+static int32_t s_bank = FICA_IMG_TYPE_NONE;
+static uint32_t s_curLen;
+static uint32_t s_finalLen;
+static bool s_finalized;
+static long s_staged;
+static char s_lastLog[256];
+
+static const char *s_case;
+static int s_run;
+
+#define FAIL(...)                                          \
+    do {                                                   \
+        printf("ota delta: %s: run %d: ", s_case, s_run);  \
+        printf(__VA_ARGS__);                               \
+        printf("\n");                                      \
+        if (s_lastLog[0]) {                                \
+            printf("ota delta: last PAL log: %s", s_lastLog); \
+        }                                                  \
+        exit(1);                                           \
+    } while (0)
+
+void ota_delta_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(s_lastLog, sizeof(s_lastLog), fmt, ap);
+    va_end(ap);
+}
+
+OTA_State_t OTA_GetAgentState(void)
+{
+    /* Keeps prvPAL_Abort from resetting the device */
+    return eOTA_AgentState_ShuttingDown;
+}
+
+void ErrorBlinkLED(void)
+{
+}
+
+void selfTestCleanup(void)
+{
+}
+
+uintptr_t SLN_Flash_Get_Read_Address(uint32_t address)
+{
+    return (uintptr_t)s_flash + address;
+}
+
+int32_t SLN_AUTH_Hash_Message(uint8_t *msg, size_t msglen, uint8_t *hash)
+{
+    return mbedtls_sha256_ret(msg, msglen, hash, 0) ? SLN_AUTH_ERR : SLN_AUTH_OK;
+}
+
+static uint8_t *bank_base(int32_t imgtype)
+{
+    return s_flash + ((FICA_IMG_TYPE_APP_A == imgtype) ? 0 : TEST_BANK_SIZE);
+}
+
+int32_t FICA_GetCurAppStartType(int32_t *imgtype)
+{
+    *imgtype = FICA_IMG_TYPE_APP_A;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_get_app_img_start_addr(int32_t imgtype, uint32_t *startaddr)
+{
+    *startaddr = (uint32_t)(bank_base(imgtype) - s_flash);
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_get_app_img_max_size(int32_t imgtype, uint32_t *maxsize)
+{
+    *maxsize = TEST_BANK_SIZE;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_init(int32_t newimgtype)
+{
+    if (FICA_IMG_TYPE_APP_A == newimgtype) {
+        FAIL("the running bank was picked for the new image");
+    }
+    s_bank = newimgtype;
+    s_curLen = 0;
+    s_finalized = false;
+    memset(bank_base(s_bank), 0xFF, TEST_BANK_SIZE);
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_erase_sector(uint32_t offset)
+{
+    if (offset >= TEST_BANK_SIZE) {
+        FAIL("erase of sector 0x%x outside of the bank", offset);
+    }
+    offset -= offset % EXT_FLASH_ERASE_PAGE;
+    memset(bank_base(s_bank) + offset, 0xFF, EXT_FLASH_ERASE_PAGE);
+    return SLN_FLASH_NO_ERROR;
+}
+
+static int32_t program(uint32_t offset, uint8_t *pbuf, uint32_t len)
+{
+    uint8_t *dst = bank_base(s_bank) + offset;
+
+    if ((0 == len) || (offset + len > TEST_BANK_SIZE)) {
+        FAIL("program of %u bytes at 0x%x outside of the bank", len, offset);
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (0xFF != dst[i]) {
+            FAIL("program of %u bytes at 0x%x over programmed byte 0x%x", len, offset, offset + i);
+        }
+    }
+    memcpy(dst, pbuf, len);
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_abs(uint32_t offset, uint8_t *pbuf, uint32_t len)
+{
+    if (offset + len > s_curLen) {
+        s_curLen = offset + len;
+    }
+    return program(offset, pbuf, len);
+}
+
+int32_t FICA_app_program_ext_stage(uint32_t offset, uint8_t *pbuf, uint32_t len)
+{
+    s_staged++;
+    return program(offset, pbuf, len);
+}
+
+int32_t FICA_Save_Signature(uint8_t *sig)
+{
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_finalize(void)
+{
+    s_finalized = true;
+    s_finalLen = s_curLen;
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_app_program_ext_set_reset_vector(void)
+{
+    return SLN_FLASH_NO_ERROR;
+}
+
+int32_t FICA_Clear_OTA_FlashBit(void)
+{
+    return SLN_FLASH_NO_ERROR;
+}
+
+static uint8_t *read_file(const char *dir, const char *name, const char *ext, uint32_t *len)
+{
+    char path[512];
+    uint8_t *buf;
+    long size;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/%s.%s", dir, name, ext);
+    f = fopen(path, "rb");
+    if (NULL == f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(size ? size : 1);
+    if (fread(buf, 1, size, f) != (size_t)size) {
+        printf("ota delta: short read of %s\n", path);
+        exit(1);
+    }
+    fclose(f);
+    *len = (uint32_t)size;
+    return buf;
+}
+
+static void load_source(const uint8_t *old, uint32_t oldLen)
+{
+    memset(s_flash, 0xFF, TEST_BANK_SIZE);
+    memcpy(s_flash, old, oldLen);
+}
+
+static int32_t direct_src_read(void *arg, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    memcpy(buf, s_flash + offset, len);
+    return 0;
+}
+
+static int32_t direct_dst_write(void *arg, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    if (offset + len > TEST_BANK_SIZE) {
+        FAIL("decoder write of %u bytes at 0x%x outside of the bank", len, offset);
+    }
+    memcpy(s_flash + TEST_BANK_SIZE + offset, buf, len);
+    return 0;
+}
+
+/* Feed the delta straight to the decoder, in chunks of random size */
+static void split_run(const uint8_t *delta, uint32_t deltaLen, const uint8_t *img, uint32_t imgLen)
+{
+    static sln_delta_ctx_t ctx;
+    const sln_delta_ops_t ops = { .srcRead = direct_src_read, .dstWrite = direct_dst_write };
+    uint32_t dstLen = 0;
+    uint32_t pos = 0;
+    int32_t ret;
+
+    if (SLN_DELTA_OK != SLN_DELTA_Init(&ctx, &ops, TEST_BANK_SIZE, TEST_BANK_SIZE)) {
+        FAIL("decoder init failed");
+    }
+    while (pos < deltaLen) {
+        uint32_t n = 1 + rand() % ((rand() % 4) ? 64 : 6000);
+
+        n = (n > deltaLen - pos) ? deltaLen - pos : n;
+        ret = SLN_DELTA_Feed(&ctx, delta + pos, n);
+        if (SLN_DELTA_OK != ret) {
+            FAIL("feed of %u bytes at %u failed, %d", n, pos, ret);
+        }
+        pos += n;
+    }
+    ret = SLN_DELTA_Finish(&ctx, &dstLen);
+    if ((SLN_DELTA_OK != ret) || (dstLen != imgLen)) {
+        FAIL("finish failed, %d, length %u of %u", ret, dstLen, imgLen);
+    }
+    if (memcmp(s_flash + TEST_BANK_SIZE, img, imgLen)) {
+        FAIL("rebuilt image differs");
+    }
+    SLN_DELTA_Deinit(&ctx);
+}
+
+/*
+ * Receive the delta through the PAL like the OTA agent: request the first
+ * missing blocks, take them in any order, lose some. Returns false when the
+ * PAL failed a block or the close.
+ */
+static bool pal_run(const uint8_t *delta, uint32_t deltaLen, uint32_t lossPercent)
+{
+    static uint8_t needed[TEST_MAX_BLOCKS];
+    uint32_t request[otaconfigMAX_NUM_BLOCKS_REQUEST];
+    uint32_t blocks = (deltaLen + TEST_BLOCK_SIZE - 1) / TEST_BLOCK_SIZE;
+    static uint8_t sigData[256];
+    Sig256_t sig = { .usSize = sizeof(sigData), .ucData = sigData };
+    OTA_FileContext_t file = {
+        .pucFilePath = (uint8_t *)"AppB.delta",
+        .ulFileSize = deltaLen,
+        .ulBlocksRemaining = blocks,
+        .pxSignature = &sig,
+    };
+
+    s_lastLog[0] = 0;
+    if (kOTA_Err_None != prvPAL_CreateFileForRx(&file)) {
+        FAIL("create failed");
+    }
+    memset(needed, 1, blocks);
+
+    while (file.ulBlocksRemaining) {
+        uint32_t count = 0;
+
+        for (uint32_t b = 0; b < blocks && count < otaconfigMAX_NUM_BLOCKS_REQUEST; b++) {
+            if (needed[b]) {
+                request[count++] = b;
+            }
+        }
+        for (uint32_t i = count - 1; i > 0; i--) {
+            uint32_t j = rand() % (i + 1);
+            uint32_t t = request[i];
+
+            request[i] = request[j];
+            request[j] = t;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t b = request[i];
+            uint32_t offset = b * TEST_BLOCK_SIZE;
+            uint32_t len = (deltaLen - offset < TEST_BLOCK_SIZE) ? deltaLen - offset : TEST_BLOCK_SIZE;
+            uint8_t block[TEST_BLOCK_SIZE];
+            int16_t ret;
+
+            if ((uint32_t)(rand() % 100) < lossPercent) {
+                continue;
+            }
+            /* The agent hands over its receive buffer, it is gone after the call */
+            memcpy(block, delta + offset, len);
+            ret = prvPAL_WriteBlock(&file, offset, block, len);
+            memset(block, 0xA5, sizeof(block));
+            if (ret < 0) {
+                prvPAL_Abort(&file);
+                return false;
+            }
+            if (ret != (int16_t)len) {
+                FAIL("write of block %u returned %d", b, ret);
+            }
+            needed[b] = 0;
+            file.ulBlocksRemaining--;
+        }
+    }
+
+    return kOTA_Err_None == prvPAL_CloseFile(&file);
+}
+
+static void check_bank(const uint8_t *img, uint32_t imgLen)
+{
+    const uint8_t *bank = bank_base(FICA_IMG_TYPE_APP_B);
+
+    if (!s_finalized || (s_finalLen != imgLen)) {
+        FAIL("image length %u finalized, expected %u", s_finalLen, imgLen);
+    }
+    if (memcmp(bank, img, imgLen)) {
+        FAIL("rebuilt image differs");
+    }
+    for (uint32_t i = imgLen; i < TEST_BANK_SIZE; i++) {
+        if (0xFF != bank[i]) {
+            FAIL("bank not erased at 0x%x after the image", i);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = argv[1];
+    char name[32];
+    long staged = 0;
+    int cases = 0;
+    int flips = 0;
+    int harmless = 0;
+
+    for (int c = 0;; c++) {
+        uint32_t oldLen, newLen, deltaLen;
+        uint8_t *old, *img, *delta, *flipped;
+
+        snprintf(name, sizeof(name), "case%d", c);
+        s_case = name;
+        old = read_file(dir, name, "old", &oldLen);
+        if (NULL == old) {
+            break;
+        }
+        img = read_file(dir, name, "new", &newLen);
+        delta = read_file(dir, name, "delta", &deltaLen);
+        flipped = read_file(dir, name, "delta", &deltaLen);
+        if ((NULL == img) || (NULL == delta) || (NULL == flipped)) {
+            printf("ota delta: %s is incomplete\n", name);
+            return 1;
+        }
+        srand(c + 1);
+        load_source(old, oldLen);
+
+        for (s_run = 0; s_run < TEST_SPLIT_RUNS; s_run++) {
+            memset(s_flash + TEST_BANK_SIZE, 0xFF, TEST_BANK_SIZE);
+            split_run(delta, deltaLen, img, newLen);
+        }
+
+        for (s_run = 0; s_run < TEST_PAL_RUNS; s_run++) {
+            s_staged = 0;
+            if (!pal_run(delta, deltaLen, (s_run % 2) ? 10 : 0)) {
+                FAIL("delta rejected");
+            }
+            check_bank(img, newLen);
+            staged += s_staged;
+        }
+
+        for (s_run = 0; s_run < TEST_FLIP_RUNS; s_run++) {
+            uint32_t pos = rand() % deltaLen;
+
+            flipped[pos] ^= 1 + rand() % 255;
+            s_finalized = false;
+            if (pal_run(flipped, deltaLen, 5)) {
+                check_bank(img, newLen);
+                harmless++;
+            } else if (s_finalized) {
+                FAIL("delta with byte %u of %u flipped was finalized", pos, deltaLen);
+            }
+            flipped[pos] = delta[pos];
+            flips++;
+        }
+
+        printf("ota delta: %s: %u byte image from a %u byte delta\n", name, newLen, deltaLen);
+        free(old);
+        free(img);
+        free(delta);
+        free(flipped);
+        cases++;
+    }
+
+    if (0 == cases) {
+        printf("ota delta: no cases in %s\n", dir);
+        return 1;
+    }
+    printf("ota delta: %d cases, %d PAL runs with %ld blocks parked, %d of %d flipped deltas rejected\n",
+           cases, cases * TEST_PAL_RUNS, staged, flips - harmless, flips);
+    return 0;
+}
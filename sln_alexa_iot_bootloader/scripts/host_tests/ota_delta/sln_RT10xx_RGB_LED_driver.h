@@ -0,0 +1,10 @@
+/*
+ * Host stand-in for sln_RT10xx_RGB_LED_driver.h, the LED calls do nothing.
+ */
+
+#ifndef _SLN_RT10XX_RGB_LED_DRIVER_H_
+#define _SLN_RT10XX_RGB_LED_DRIVER_H_
+
+#define RGB_LED_SetBrightnessColor(brightness, color) ((void)0)
+
+#endif /* _SLN_RT10XX_RGB_LED_DRIVER_H_ */
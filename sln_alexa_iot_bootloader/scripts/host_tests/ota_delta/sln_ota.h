@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for sln_ota.h: the flash read window and the SHA256 of
+ * sln_auth.c, on top of mbedTLS.
+ */
+
+#ifndef _SLN_OTA_H_
+#define _SLN_OTA_H_
+
+#include <stdint.h>
+
+#define SLN_AUTH_OK  0
+#define SLN_AUTH_ERR -1
+#define SHA256_LEN   32
+
+/* Read addresses point into the simulated flash, they don't fit 32 bits on the host */
+uintptr_t SLN_Flash_Get_Read_Address(uint32_t address);
+int32_t SLN_AUTH_Hash_Message(uint8_t *msg, size_t msglen, uint8_t *hash);
+
+void ErrorBlinkLED(void);
+void selfTestCleanup(void);
+
+#define NVIC_SystemReset() abort()
+
+#endif /* _SLN_OTA_H_ */
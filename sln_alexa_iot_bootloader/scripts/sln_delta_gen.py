@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+
+"""
+
+Copyright 2021 NXP.
+
+This software is owned or controlled by NXP and may only be used
+strictly in accordance with the license terms that accompany it. By
+expressly accepting such terms or by downloading, installing,
+activating and/or otherwise using the software, you are agreeing that
+you have read, and that you agree to comply with and are bound by,
+such license terms. If you do not agree to be bound by the applicable
+license terms, then you may not retain, install, activate or otherwise
+use the software.
+
+File
+++++
+/scripts/sln_delta_gen.py
+
+Brief
++++++
+** Generates and checks delta images for the bootloader OTA **
+
+.. versionadded:: 0.0
+
+
+A delta image rebuilds a new application image from the image that is
+currently running, so only the differences have to be sent over the air.
+The format is described in source/sln_delta.h; the bootloader applies it
+while the file is received (see source/aws_ota_pal.c) and writes the
+rebuilt image in the inactive bank.
+
+Sub-commands:
+
+    gen    <old.bin> <new.bin> <out.delta>
+           Generate a delta rebuilding new.bin from old.bin
+
+    apply  <old.bin> <in.delta> <out.bin>
+           Rebuild an image the way the bootloader does: old.bin acts as
+           the running bank and out.bin as the inactive bank
+
+    verify <old.bin> <new.bin> <in.delta>
+           Apply the delta to file backed banks, feeding it in OTA sized
+           blocks, then compare the result byte for byte with new.bin
+
+##########
+NOTA BENE:
+  1. The OTA job must be created for file path "AppA.delta" / "AppB.delta"
+     (the bank being written) instead of "AppA" / "AppB"
+
+  2. The OTA signature must be computed over new.bin, not over the delta;
+     the bootloader checks it against the rebuilt image exactly as it does
+     for a full image
+
+  3. old.bin must be the exact image running on the device, otherwise the
+     bootloader rejects the delta before writing anything
+
+  4. Blocks received ahead of the decoder are parked at the end of the bank
+     being written, so new.bin plus the delta rounded up to 4KB must fit
+     in the bank
+##########
+
+
+execute "sln_delta_gen.py --help" for usage information.
+
+"""
+
+import sys
+import struct
+import hashlib
+import argparse
+import random
+import tempfile
+import os
+
+
+DELTA_MAGIC = 0x444E4C53
+DELTA_VERSION = 1
+DELTA_HEADER = struct.Struct('<IHHII32s32s')
+
+OP_END = 0x00
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+# Must match SLN_DELTA_WINDOW_SIZE and FICA_IMG_APP_A_SIZE / FICA_IMG_APP_B_SIZE
+WINDOW_SIZE = 0x1000
+BANK_SIZE = 0x600000
+
+# Source is indexed every INDEX_STEP bytes by its next MATCH_LEN bytes
+MATCH_LEN = 16
+INDEX_STEP = 4
+MIN_COPY_LEN = MATCH_LEN
+
+
+def build_index(src):
+    """
+    Index the source image for match lookups
+
+    :param src: source image
+    :type  src: bytes
+
+    :returns: (dict) MATCH_LEN bytes block -> first source offset
+    """
+
+    index = {}
+    for pos in range(0, len(src) - MATCH_LEN + 1, INDEX_STEP):
+        index.setdefault(src[pos:pos + MATCH_LEN], pos)
+
+    return index
+
+
+def match_len(src, src_pos, dst, dst_pos):
+    """
+    Length of the common run starting at src_pos / dst_pos
+    """
+
+    length = 0
+    limit = min(len(src) - src_pos, len(dst) - dst_pos)
+
+    # Compare in chunks first, then byte by byte for the tail
+    while length + 64 <= limit and src[src_pos + length:src_pos + length + 64] == \
+            dst[dst_pos + length:dst_pos + length + 64]:
+        length += 64
+
+    while length < limit and src[src_pos + length] == dst[dst_pos + length]:
+        length += 1
+
+    return length
+
+
+def gen_ops(src, dst):
+    """
+    Greedy block matching of dst against src
+
+    :returns: (list) of (OP_COPY, src_offset, length) and (OP_INSERT, data)
+    """
+
+    index = build_index(src)
+    ops = []
+    literal_start = 0
+    dst_pos = 0
+    # Offset between the last copied source and target, code following a change is
+    # usually just shifted so this is tried before the index
+    last_shift = 0
+
+    while dst_pos <= len(dst) - MATCH_LEN:
+        best_src = -1
+        best_len = 0
+
+        candidate = dst_pos + last_shift
+        if 0 <= candidate <= len(src) - MATCH_LEN:
+            length = match_len(src, candidate, dst, dst_pos)
+            if length >= MIN_COPY_LEN:
+                best_src, best_len = candidate, length
+
+        if best_len == 0:
+            # The indexed source offset may be up to INDEX_STEP - 1 bytes into the run
+            for back in range(INDEX_STEP):
+                if dst_pos - back < literal_start:
+                    break
+                pos = index.get(dst[dst_pos - back:dst_pos - back + MATCH_LEN])
+                if pos is not None:
+                    length = match_len(src, pos, dst, dst_pos - back)
+                    if length > best_len:
+                        best_src, best_len = pos, length
+                        start = dst_pos - back
+            if best_len >= MIN_COPY_LEN:
+                dst_pos = start
+
+        if best_len < MIN_COPY_LEN:
+            dst_pos += 1
+            continue
+
+        if dst_pos > literal_start:
+            ops.append((OP_INSERT, dst[literal_start:dst_pos]))
+
+        ops.append((OP_COPY, best_src, best_len))
+        last_shift = best_src - dst_pos
+        dst_pos += best_len
+        literal_start = dst_pos
+
+    if literal_start < len(dst):
+        ops.append((OP_INSERT, dst[literal_start:]))
+
+    return ops
+
+
+def gen_delta(src, dst):
+    """
+    Generate a delta image rebuilding dst from src
+
+    :returns: (bytes) delta image
+    """
+
+    out = bytearray(DELTA_HEADER.pack(DELTA_MAGIC, DELTA_VERSION, 0, len(src), len(dst),
+                                      hashlib.sha256(src).digest(), hashlib.sha256(dst).digest()))
+
+    for op in gen_ops(src, dst):
+        if op[0] == OP_COPY:
+            out += struct.pack('<BII', OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack('<BI', OP_INSERT, len(op[1]))
+            out += op[1]
+
+    out += struct.pack('<B', OP_END)
+
+    return bytes(out)
+
+
+class FileBank(object):
+    """
+    Flash bank backed by a file, erased to 0xFF
+    """
+
+    def __init__(self, path, size):
+        self.fp = open(path, 'w+b')
+        self.fp.write(b'\xff' * size)
+        self.size = size
+
+    def write(self, offset, data):
+        if offset + len(data) > self.size:
+            raise ValueError("write beyond bank end at 0x%x" % offset)
+        self.fp.seek(offset)
+        self.fp.write(data)
+
+    def read(self, offset, length):
+        self.fp.seek(offset)
+        return self.fp.read(length)
+
+    def close(self):
+        self.fp.close()
+
+
+class DeltaApplier(object):
+    """
+    Streaming delta decoder, mirrors SLN_DELTA_Feed / SLN_DELTA_Finish
+    """
+
+    def __init__(self, src_read, src_len, dst_bank):
+        self.src_read = src_read
+        self.src_len = src_len
+        self.dst = dst_bank
+        self.pending = bytearray()
+        self.header = None
+        self.insert_left = 0
+        self.window = bytearray()
+        self.dst_pos = 0
+        self.sha = hashlib.sha256()
+        self.done = False
+
+    def _emit(self, data):
+        self.dst_pos += len(data)
+        if self.dst_pos > self.header[4]:
+            raise ValueError("target overflows the announced length")
+        self.window += data
+        while len(self.window) >= WINDOW_SIZE:
+            self._flush(WINDOW_SIZE)
+
+    def _flush(self, length):
+        chunk = bytes(self.window[:length])
+        del self.window[:length]
+        self.sha.update(chunk)
+        self.dst.write(self.dst_pos - len(self.window) - len(chunk), chunk)
+
+    def feed(self, data):
+        self.pending += data
+
+        while self.pending:
+            if self.done:
+                raise ValueError("data after end marker")
+
+            if self.header is None:
+                if len(self.pending) < DELTA_HEADER.size:
+                    return
+                self.header = DELTA_HEADER.unpack(bytes(self.pending[:DELTA_HEADER.size]))
+                del self.pending[:DELTA_HEADER.size]
+                magic, version, flags, src_len, dst_len, src_digest, _ = self.header
+                if magic != DELTA_MAGIC or version != DELTA_VERSION or flags != 0:
+                    raise ValueError("bad delta header")
+                if src_len > self.src_len or dst_len > self.dst.size:
+                    raise ValueError("delta does not fit the banks")
+                if hashlib.sha256(self.src_read(0, src_len)).digest() != src_digest:
+                    raise ValueError("source image does not match the delta")
+
+            elif self.insert_left:
+                chunk = bytes(self.pending[:self.insert_left])
+                del self.pending[:len(chunk)]
+                self.insert_left -= len(chunk)
+                self._emit(chunk)
+
+            else:
+                op = self.pending[0]
+                op_len = {OP_END: 1, OP_COPY: 9, OP_INSERT: 5}.get(op)
+                if op_len is None:
+                    raise ValueError("bad op 0x%02x" % op)
+                if len(self.pending) < op_len:
+                    return
+                fields = bytes(self.pending[1:op_len])
+                del self.pending[:op_len]
+
+                if op == OP_END:
+                    if self.dst_pos != self.header[4]:
+                        raise ValueError("delta ended early")
+                    self.done = True
+                elif op == OP_COPY:
+                    src_off, length = struct.unpack('<II', fields)
+                    if src_off + length > self.header[3]:
+                        raise ValueError("copy beyond source end")
+                    self._emit(self.src_read(src_off, length))
+                else:
+                    self.insert_left = struct.unpack('<I', fields)[0]
+
+    def finish(self):
+        if not self.done:
+            raise ValueError("delta incomplete")
+        self._flush(len(self.window))
+        if self.sha.digest() != self.header[6]:
+            raise ValueError("rebuilt image digest mismatch")
+        return self.header[4]
+
+
+def apply_delta(src, delta, out_path, block_size=None):
+    """
+    Apply delta to file backed banks, feeding it in blocks like the OTA agent
+
+    :returns: (bytes) rebuilt image
+    """
+
+    src_bank = FileBank(out_path + '.src', BANK_SIZE)
+    dst_bank = FileBank(out_path, BANK_SIZE)
+
+    try:
+        src_bank.write(0, src)
+        applier = DeltaApplier(src_bank.read, len(src), dst_bank)
+
+        offset = 0
+        while offset < len(delta):
+            step = block_size or random.randint(1, 4096)
+            applier.feed(delta[offset:offset + step])
+            offset += step
+
+        length = applier.finish()
+        return dst_bank.read(0, length)
+
+    finally:
+        src_bank.close()
+        dst_bank.close()
+        os.remove(out_path + '.src')
+
+
+def read_file(path):
+    with open(path, 'rb') as fp:
+        return fp.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate and check bootloader OTA delta images")
+    sub = parser.add_subparsers(dest='cmd')
+
+    p = sub.add_parser('gen', help="generate a delta image")
+    p.add_argument('old')
+    p.add_argument('new')
+    p.add_argument('out')
+
+    p = sub.add_parser('apply', help="rebuild an image from a delta")
+    p.add_argument('old')
+    p.add_argument('delta')
+    p.add_argument('out')
+
+    p = sub.add_parser('verify', help="apply a delta to file backed banks and compare")
+    p.add_argument('old')
+    p.add_argument('new')
+    p.add_argument('delta')
+    p.add_argument('-b', '--block-size', type=int, default=1024, help="OTA block size, 0 for random")
+
+    args = parser.parse_args()
+
+    try:
+        if args.cmd == 'gen':
+            src = read_file(args.old)
+            dst = read_file(args.new)
+            delta = gen_delta(src, dst)
+            with open(args.out, 'wb') as fp:
+                fp.write(delta)
+            print("Delta: %d bytes (%.1f%% of %d)" % (len(delta), 100.0 * len(delta) / len(dst), len(dst)))
+
+        elif args.cmd == 'apply':
+            image = apply_delta(read_file(args.old), read_file(args.delta), args.out + '.bank')
+            with open(args.out, 'wb') as fp:
+                fp.write(image)
+            os.remove(args.out + '.bank')
+
+        elif args.cmd == 'verify':
+            dst = read_file(args.new)
+            with tempfile.TemporaryDirectory() as tmp:
+                image = apply_delta(read_file(args.old), read_file(args.delta), os.path.join(tmp, 'bank.bin'),
+                                    args.block_size)
+            if image != dst:
+                print("\nERROR: rebuilt image differs from %s" % args.new)
+                return 1
+            print("OK: rebuilt image matches %s (%d bytes)" % (args.new, len(dst)))
+
+        else:
+            parser.print_help()
+            return 1
+
+    except (OSError, ValueError) as e:
+        print("\nERROR: %s" % e)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
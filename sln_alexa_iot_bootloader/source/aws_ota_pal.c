@@ -34,6 +34,7 @@
 /* Amazon FreeRTOS include. */
 #include "FreeRTOS.h"
 #include "aws_iot_ota_pal.h"
+#include "aws_ota_agent_config.h"
 
 /* Board specific includes */
 #include "board.h"
@@ -41,15 +42,55 @@
 #include "flash_ica_driver.h"
 #include "sln_ota.h"
 #include "sln_RT10xx_RGB_LED_driver.h"
+#include "sln_delta.h"
 
 /* Definitions */
 #define IMG_TYPE_BOOT_PATH  "Boot"
 #define IMG_TYPE_APP_A_PATH "AppA"
 #define IMG_TYPE_APP_B_PATH "AppB"
 
+/* Delta images are generated against the image in the running bank
+ * with scripts/sln_delta_gen.py and rebuild the full image in the other bank */
+#ifndef ENABLE_OTA_DELTA
+#define ENABLE_OTA_DELTA 1
+#endif
+
+#define IMG_TYPE_APP_A_DELTA_PATH "AppA.delta"
+#define IMG_TYPE_APP_B_DELTA_PATH "AppB.delta"
+
+/* Blocks of a stream request arrive in any order, the ones ahead of the decoder are parked
+ * at their offset in the tail of the bank being written until the blocks before them arrive */
+#define DELTA_BLOCK_SIZE (1UL << otaconfigLOG2_FILE_BLOCK_SIZE)
+
 static OTA_PAL_ImageState_t platformState = eOTA_PAL_ImageState_Unknown;
 static TaskHandle_t s_otaDoneTaskHandle   = NULL;
 
+#if ENABLE_OTA_DELTA
+static int32_t prvPAL_DeltaSrcRead(void *arg, uint32_t offset, uint8_t *buf, uint32_t len);
+static int32_t prvPAL_DeltaSrcCheck(void *arg, uint32_t len, const uint8_t *digest);
+static int32_t prvPAL_DeltaDstWrite(void *arg, uint32_t offset, uint8_t *buf, uint32_t len);
+
+static int16_t prvPAL_DeltaWriteBlock(uint32_t ulOffset, uint8_t *const pacData, uint32_t ulBlockSize);
+static void prvPAL_DeltaRelease(void);
+
+static const sln_delta_ops_t s_deltaOps = {
+    .srcRead  = prvPAL_DeltaSrcRead,
+    .srcCheck = prvPAL_DeltaSrcCheck,
+    .dstWrite = prvPAL_DeltaDstWrite,
+    .arg      = NULL,
+};
+
+static sln_delta_ctx_t s_deltaCtx;
+static bool s_isDelta             = false;
+static uint32_t s_deltaSrcAddr    = 0;
+static uint32_t s_deltaDstAddr    = 0;
+static uint32_t s_deltaNextOffset = 0;
+static uint32_t s_deltaFileSize   = 0;
+static uint32_t s_deltaParkBase   = 0;    /* Bank offset of the parked delta blocks */
+static uint32_t s_deltaParkEnd    = 0;    /* End of the parked blocks, relative to s_deltaParkBase */
+static uint8_t *s_deltaParked     = NULL; /* One bit per parked block */
+#endif /* ENABLE_OTA_DELTA */
+
 /* Specify the OTA signature algorithm we support on this platform. */
 const char cOTA_JSON_FileSignatureKey[OTA_FILE_SIG_KEY_STR_MAX_LENGTH] = "sig-sha256-rsa";
 
@@ -60,6 +101,7 @@ OTA_Err_t prvPAL_CreateFileForRx(OTA_FileContext_t *const C)
     OTA_Err_t ret    = kOTA_Err_None;
     int32_t img_type = FICA_IMG_TYPE_NONE;
     int32_t fica_ret = SLN_FLASH_NO_ERROR;
+    bool is_delta    = false;
 
     /* Decide what image type we have based on the file path */
     if (!strcmp((const char *)C->pucFilePath, IMG_TYPE_APP_A_PATH))
@@ -70,6 +112,18 @@ OTA_Err_t prvPAL_CreateFileForRx(OTA_FileContext_t *const C)
     {
         img_type = FICA_IMG_TYPE_APP_B;
     }
+#if ENABLE_OTA_DELTA
+    else if (!strcmp((const char *)C->pucFilePath, IMG_TYPE_APP_A_DELTA_PATH))
+    {
+        img_type = FICA_IMG_TYPE_APP_A;
+        is_delta = true;
+    }
+    else if (!strcmp((const char *)C->pucFilePath, IMG_TYPE_APP_B_DELTA_PATH))
+    {
+        img_type = FICA_IMG_TYPE_APP_B;
+        is_delta = true;
+    }
+#endif /* ENABLE_OTA_DELTA */
     else
     {
         OTA_LOG_L1("[%s] Invalid file path received: '%s'.\r\n", OTA_METHOD_NAME, C->pucFilePath);
@@ -93,6 +147,88 @@ OTA_Err_t prvPAL_CreateFileForRx(OTA_FileContext_t *const C)
         }
     }
 
+#if ENABLE_OTA_DELTA
+    s_isDelta = is_delta;
+
+    if ((kOTA_Err_None == ret) && is_delta)
+    {
+        int32_t src_type   = FICA_IMG_TYPE_NONE;
+        uint32_t src_size  = 0;
+        uint32_t dst_size  = 0;
+        uint32_t park_size = 0;
+        uint32_t park_bits = 0;
+
+        /* The running bank is the delta source, FICA_app_program_ext_init
+         * already made sure it is not the bank being written */
+        fica_ret = FICA_GetCurAppStartType(&src_type);
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            fica_ret = FICA_get_app_img_start_addr(src_type, &s_deltaSrcAddr);
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            fica_ret = FICA_get_app_img_start_addr(img_type, &s_deltaDstAddr);
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            fica_ret = FICA_get_app_img_max_size(src_type, &src_size);
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            fica_ret = FICA_get_app_img_max_size(img_type, &dst_size);
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            /* The rebuilt image has to end below the parked blocks */
+            s_deltaFileSize = C->ulFileSize;
+            park_size       = ((s_deltaFileSize + EXT_FLASH_ERASE_PAGE - 1) / EXT_FLASH_ERASE_PAGE) * EXT_FLASH_ERASE_PAGE;
+            park_bits       = (s_deltaFileSize + DELTA_BLOCK_SIZE - 1) / DELTA_BLOCK_SIZE;
+
+            if ((0 == s_deltaFileSize) || (park_size >= dst_size))
+            {
+                fica_ret = SLN_FLASH_ERROR;
+            }
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            s_deltaParkBase = dst_size - park_size;
+            s_deltaParkEnd  = 0;
+            s_deltaParked   = (uint8_t *)pvPortMalloc((park_bits + 7) / 8);
+
+            if (NULL == s_deltaParked)
+            {
+                fica_ret = SLN_FLASH_ERROR;
+            }
+            else
+            {
+                memset(s_deltaParked, 0, (park_bits + 7) / 8);
+            }
+        }
+
+        if (SLN_FLASH_NO_ERROR == fica_ret)
+        {
+            fica_ret = SLN_DELTA_Init(&s_deltaCtx, &s_deltaOps, src_size, s_deltaParkBase);
+        }
+
+        if (SLN_FLASH_NO_ERROR != fica_ret)
+        {
+            OTA_LOG_L1("[%s] Delta init failed, error %d.\r\n", OTA_METHOD_NAME, fica_ret);
+            ret = kOTA_Err_RxFileCreateFailed;
+            prvPAL_DeltaRelease();
+        }
+
+        s_deltaNextOffset = 0;
+    }
+#else
+    (void)is_delta;
+#endif /* ENABLE_OTA_DELTA */
+
     if (kOTA_Err_None == ret)
     {
         /* We don't need yet anything here, but this field
@@ -115,6 +251,13 @@ OTA_Err_t prvPAL_Abort(OTA_FileContext_t *const C)
 
     OTA_Err_t eResult = kOTA_Err_None;
 
+#if ENABLE_OTA_DELTA
+    if (s_isDelta)
+    {
+        prvPAL_DeltaRelease();
+    }
+#endif /* ENABLE_OTA_DELTA */
+
     if ((OTA_GetAgentState() ==
              eOTA_AgentState_Ready && /* When abort called in this state, we may have an invalid job */
          !C->xIsInSelfTest &&         /* Do not reset when in self test */
@@ -156,6 +299,13 @@ int16_t prvPAL_WriteBlock(OTA_FileContext_t *const C, uint32_t ulOffset, uint8_t
 {
     DEFINE_OTA_METHOD_NAME("prvPAL_WriteBlock");
 
+#if ENABLE_OTA_DELTA
+    if (s_isDelta)
+    {
+        return prvPAL_DeltaWriteBlock(ulOffset, pacData, ulBlockSize);
+    }
+#endif /* ENABLE_OTA_DELTA */
+
     int32_t fica_ret = FICA_app_program_ext_abs(ulOffset, (void *)pacData, ulBlockSize);
     if (SLN_FLASH_NO_ERROR != fica_ret)
     {
@@ -177,6 +327,30 @@ OTA_Err_t prvPAL_CloseFile(OTA_FileContext_t *const C)
         return kOTA_Err_FileClose;
     }
 
+#if ENABLE_OTA_DELTA
+    if (s_isDelta)
+    {
+        /* Flushes the last window and checks the rebuilt image digest; the signature below
+         * covers the rebuilt image and is verified by the bootloader like for a full image */
+        int32_t delta_ret = SLN_DELTA_Finish(&s_deltaCtx, NULL);
+
+        /* Parked blocks are not part of the image, leave the rest of the bank erased */
+        for (uint32_t offset = 0; (SLN_DELTA_OK == delta_ret) && (offset < s_deltaParkEnd);
+             offset += EXT_FLASH_ERASE_PAGE)
+        {
+            delta_ret = FICA_app_program_ext_erase_sector(s_deltaParkBase + offset);
+        }
+
+        prvPAL_DeltaRelease();
+
+        if (SLN_DELTA_OK != delta_ret)
+        {
+            OTA_LOG_L1("[%s] Delta close failed, error %d.\r\n", OTA_METHOD_NAME, delta_ret);
+            return kOTA_Err_FileClose;
+        }
+    }
+#endif /* ENABLE_OTA_DELTA */
+
     int32_t fica_ret = FICA_Save_Signature(C->pxSignature->ucData);
     if (SLN_FLASH_NO_ERROR != fica_ret)
     {
@@ -198,6 +372,117 @@ OTA_Err_t prvPAL_CloseFile(OTA_FileContext_t *const C)
 }
 /*-----------------------------------------------------------*/
 
+#if ENABLE_OTA_DELTA
+static int16_t prvPAL_DeltaWriteBlock(uint32_t ulOffset, uint8_t *const pacData, uint32_t ulBlockSize)
+{
+    DEFINE_OTA_METHOD_NAME("prvPAL_DeltaWriteBlock");
+
+    int32_t ret    = SLN_DELTA_OK;
+    uint32_t block = ulOffset / DELTA_BLOCK_SIZE;
+
+    /* The target is rebuilt in order, a block ahead of the decoder waits in the bank tail */
+    if (ulOffset != s_deltaNextOffset)
+    {
+        if ((ulOffset < s_deltaNextOffset) || (ulOffset % DELTA_BLOCK_SIZE) ||
+            (ulOffset + ulBlockSize > s_deltaFileSize))
+        {
+            OTA_LOG_L1("[%s] Unexpected delta block at offset %u, expected offset %u.\r\n", OTA_METHOD_NAME,
+                       ulOffset, s_deltaNextOffset);
+            return -1;
+        }
+
+        ret = FICA_app_program_ext_stage(s_deltaParkBase + ulOffset, pacData, ulBlockSize);
+        if (SLN_FLASH_NO_ERROR != ret)
+        {
+            OTA_LOG_L1("[%s] FICA_app_program_ext_stage failed, error %d.\r\n", OTA_METHOD_NAME, ret);
+            return -1;
+        }
+
+        s_deltaParked[block / 8] |= (1U << (block % 8));
+
+        if (ulOffset + ulBlockSize > s_deltaParkEnd)
+        {
+            s_deltaParkEnd = ulOffset + ulBlockSize;
+        }
+
+        return ulBlockSize;
+    }
+
+    ret = SLN_DELTA_Feed(&s_deltaCtx, pacData, ulBlockSize);
+    s_deltaNextOffset += ulBlockSize;
+
+    /* Blocks parked right after this one can be decoded now, straight from the XIP window */
+    while ((SLN_DELTA_OK == ret) && (s_deltaNextOffset < s_deltaFileSize))
+    {
+        uint32_t len = s_deltaFileSize - s_deltaNextOffset;
+
+        block = s_deltaNextOffset / DELTA_BLOCK_SIZE;
+
+        if (0 == (s_deltaParked[block / 8] & (1U << (block % 8))))
+        {
+            break;
+        }
+
+        len = (len < DELTA_BLOCK_SIZE) ? len : DELTA_BLOCK_SIZE;
+        ret = SLN_DELTA_Feed(
+            &s_deltaCtx, (uint8_t *)SLN_Flash_Get_Read_Address(s_deltaDstAddr + s_deltaParkBase + s_deltaNextOffset),
+            len);
+
+        s_deltaParked[block / 8] &= ~(1U << (block % 8));
+        s_deltaNextOffset += len;
+    }
+
+    if (SLN_DELTA_OK != ret)
+    {
+        OTA_LOG_L1("[%s] SLN_DELTA_Feed failed, error %d.\r\n", OTA_METHOD_NAME, ret);
+        return -1;
+    }
+
+    return ulBlockSize;
+}
+
+static void prvPAL_DeltaRelease(void)
+{
+    SLN_DELTA_Deinit(&s_deltaCtx);
+
+    vPortFree(s_deltaParked);
+    s_deltaParked = NULL;
+    s_isDelta     = false;
+}
+
+static int32_t prvPAL_DeltaSrcRead(void *arg, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    /* Read through the XIP window, this gives plain data for encrypted XIP as well */
+    memcpy(buf, (void *)(SLN_Flash_Get_Read_Address(s_deltaSrcAddr) + offset), len);
+
+    return SLN_FLASH_NO_ERROR;
+}
+
+static int32_t prvPAL_DeltaSrcCheck(void *arg, uint32_t len, const uint8_t *digest)
+{
+    DEFINE_OTA_METHOD_NAME("prvPAL_DeltaSrcCheck");
+
+    int32_t ret              = SLN_AUTH_OK;
+    uint8_t hash[SHA256_LEN] = {0};
+
+    ret = SLN_AUTH_Hash_Message((uint8_t *)SLN_Flash_Get_Read_Address(s_deltaSrcAddr), len, hash);
+
+    if ((SLN_AUTH_OK == ret) && memcmp(hash, digest, SHA256_LEN))
+    {
+        OTA_LOG_L1("[%s] Running image does not match the delta source.\r\n", OTA_METHOD_NAME);
+        ret = SLN_AUTH_ERR;
+    }
+
+    return ret;
+}
+
+static int32_t prvPAL_DeltaDstWrite(void *arg, uint32_t offset, uint8_t *buf, uint32_t len)
+{
+    return FICA_app_program_ext_abs(offset, buf, len);
+}
+/*-----------------------------------------------------------*/
+#endif /* ENABLE_OTA_DELTA */
+
 OTA_Err_t prvPAL_ResetDevice(void)
 {
     DEFINE_OTA_METHOD_NAME("prvPAL_ResetDevice");
@@ -71,7 +71,7 @@ static fica_t s_fica = {0};
  *
  */
 
-int32_t FICA_app_program_ext_init(int32_t newimgtype)
+static int32_t FICA_app_program_ext_setup(int32_t newimgtype, bool eraseBank)
 {
     status_t status;
     int32_t curimgtype = FICA_IMG_TYPE_NONE;
@@ -106,7 +106,7 @@ int32_t FICA_app_program_ext_init(int32_t newimgtype)
     s_newAppCurrLen = 0;
     FICA_clear_buf(s_appImgBuffer, 0xFF, SECTOR_SIZE);
 
-    if (SLN_FLASH_NO_ERROR == status)
+    if ((SLN_FLASH_NO_ERROR == status) && eraseBank)
     {
         // Erase all pages in this App bank
         status = FICA_Erase_Bank(s_newAppImgStartAddr, s_newAppImgMaxSize);
@@ -134,9 +134,37 @@ int32_t FICA_app_program_ext_init(int32_t newimgtype)
     return status;
 }
 
-__attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_program_ext_abs(uint32_t offset,
-                                                                                             uint8_t *bufptr,
-                                                                                             uint32_t writelen)
+int32_t FICA_app_program_ext_init(int32_t newimgtype)
+{
+    return FICA_app_program_ext_setup(newimgtype, true);
+}
+
+int32_t FICA_app_program_ext_init_no_erase(int32_t newimgtype)
+{
+    return FICA_app_program_ext_setup(newimgtype, false);
+}
+
+__attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_program_ext_erase_sector(uint32_t offset)
+{
+    bool commflag = false;
+
+    if (offset >= s_newAppImgMaxSize)
+        return (SLN_FLASH_ERROR);
+
+    // Verify the init passed before erasing anything
+    if ((FICA_get_comm_flag(FICA_COMM_AIS_NAI_BIT, &commflag) != SLN_FLASH_NO_ERROR) || !commflag)
+        return (SLN_FLASH_ERROR);
+
+    offset = (offset / EXT_FLASH_ERASE_PAGE) * EXT_FLASH_ERASE_PAGE;
+
+    if (SLN_Erase_Sector(s_newAppImgStartAddr + offset) != kStatus_Success)
+        return (SLN_FLASH_ERROR);
+
+    return (SLN_FLASH_NO_ERROR);
+}
+
+__attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) static int32_t FICA_app_program_ext_write(
+    uint32_t offset, uint8_t *bufptr, uint32_t writelen, bool imgdata)
 {
     // Write the image buffer to the external flash
     // len should be the flash page size until the last call, then the remainder
@@ -171,7 +199,8 @@ __attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_pro
 
     FICA_clear_buf(s_appImgBuffer, 0xFF, SECTOR_SIZE);
 
-    if ((offset + writelen) > s_newAppCurrLen)
+    // Staged data is not part of the image, it must not stretch the image length
+    if (imgdata && ((offset + writelen) > s_newAppCurrLen))
     {
         s_newAppCurrLen = (offset + writelen);
     }
@@ -235,6 +264,20 @@ __attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_pro
     return (IMG_EXT_NO_ERROR);
 }
 
+__attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_program_ext_abs(uint32_t offset,
+                                                                                             uint8_t *bufptr,
+                                                                                             uint32_t writelen)
+{
+    return FICA_app_program_ext_write(offset, bufptr, writelen, true);
+}
+
+__attribute__((section(".ramfunc.$SRAM_OC_NON_CACHEABLE"))) int32_t FICA_app_program_ext_stage(uint32_t offset,
+                                                                                               uint8_t *bufptr,
+                                                                                               uint32_t writelen)
+{
+    return FICA_app_program_ext_write(offset, bufptr, writelen, false);
+}
+
 int32_t FICA_app_program_ext_finalize()
 {
     int32_t status      = SLN_FLASH_NO_ERROR;
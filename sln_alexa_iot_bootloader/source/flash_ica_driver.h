@@ -56,6 +56,19 @@ extern "C" {
  */
 int32_t FICA_app_program_ext_init(int32_t newimgtype);
 
+/*!
+ * @brief Same as FICA_app_program_ext_init, but leaves the bank as it is
+ * The caller erases the sectors with FICA_app_program_ext_erase_sector before programming them
+ *
+ */
+int32_t FICA_app_program_ext_init_no_erase(int32_t newimgtype);
+
+/*!
+ * @brief Erase the sector holding the passed offset of the image being programmed
+ *
+ */
+int32_t FICA_app_program_ext_erase_sector(uint32_t offset);
+
 /*!
  * @brief Blocking image program to external flash
  * This is part of a blocking image program, but the actual small buffer flash write is blocking
@@ -64,6 +77,14 @@ int32_t FICA_app_program_ext_init(int32_t newimgtype);
  */
 int32_t FICA_app_program_ext_abs(uint32_t offset, uint8_t *pbuf, uint32_t len);
 
+/*!
+ * @brief Same as FICA_app_program_ext_abs, for scratch data kept in the bank while it is programmed
+ * The data does not count in the image length written by FICA_app_program_ext_finalize,
+ * the caller erases it with FICA_app_program_ext_erase_sector once done with it
+ *
+ */
+int32_t FICA_app_program_ext_stage(uint32_t offset, uint8_t *pbuf, uint32_t len);
+
 /*!
  * @brief Finalize the program by verifying the Signature and writing image info
  *
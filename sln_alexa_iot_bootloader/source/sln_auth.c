@@ -466,13 +466,89 @@ int32_t SLN_AUTH_Verify_Cert(uint8_t *caPem, uint8_t *vfPem)
 }
 
 int32_t SLN_AUTH_Verify_Signature(uint8_t *vfPem, uint8_t *msg, size_t msglen, uint8_t *msgsig)
+{
+    int32_t ret              = SLN_AUTH_OK;
+    uint8_t hash[SHA256_LEN] = {0};
+
+    if ((NULL == vfPem) || (NULL == msg) || (NULL == msgsig))
+    {
+        ret = SLN_AUTH_NULL_PTR;
+    }
+
+    if (SLN_AUTH_OK == ret)
+    {
+        ret = SLN_AUTH_Hash_Message(msg, msglen, hash);
+    }
+
+    if (SLN_AUTH_OK == ret)
+    {
+        ret = SLN_AUTH_Verify_Signature_Hash(vfPem, hash, msgsig);
+    }
+
+    // Wipe hash data
+    memset(hash, 0x00, sizeof(hash));
+
+    return ret;
+}
+
+int32_t SLN_AUTH_Hash_Message(uint8_t *msg, size_t msglen, uint8_t *hash)
+{
+    int32_t ret                     = SLN_AUTH_OK;
+    int32_t status                  = 0;
+    size_t processed                = 0;
+    size_t current_chunk            = 0;
+    const mbedtls_md_info_t *mdInfo = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    mbedtls_md_context_t mdCtx;
+
+    if ((NULL == msg) || (NULL == hash))
+    {
+        return SLN_AUTH_NULL_PTR;
+    }
+
+    mbedtls_md_init(&mdCtx);
+
+    // SHA256 is backed by the DCP, which reads each chunk directly from the XIP address
+    status = mbedtls_md_setup(&mdCtx, mdInfo, 0);
+
+    if (0 == status)
+    {
+        status = mbedtls_md_starts(&mdCtx);
+    }
+
+    while ((0 == status) && (processed < msglen))
+    {
+        current_chunk = ((msglen - processed) > SLN_AUTH_HASH_CHUNK_SIZE) ? SLN_AUTH_HASH_CHUNK_SIZE :
+                                                                            (msglen - processed);
+
+        status = mbedtls_md_update(&mdCtx, msg + processed, current_chunk);
+
+        processed += current_chunk;
+    }
+
+    if (0 == status)
+    {
+        status = mbedtls_md_finish(&mdCtx, hash);
+    }
+
+    if (status)
+    {
+        configPRINTF(("ERROR: Could not hash message, -0x%X.\r\n", -status));
+        ret = SLN_AUTH_ERR;
+    }
+
+    mbedtls_md_free(&mdCtx);
+
+    return ret;
+}
+
+int32_t SLN_AUTH_Verify_Signature_Hash(uint8_t *vfPem, uint8_t *hash, uint8_t *msgsig)
 {
     int32_t ret    = SLN_AUTH_OK; // SLN_AUTH return code
     int32_t status = 0;           // mbedTLS status code
 
     mbedtls_x509_crt_init(&s_verifCert);
 
-    if ((NULL == vfPem) || (NULL == msg) || (NULL == msgsig))
+    if ((NULL == vfPem) || (NULL == hash) || (NULL == msgsig))
     {
         ret = SLN_AUTH_NULL_PTR;
     }
@@ -491,51 +567,14 @@ int32_t SLN_AUTH_Verify_Signature(uint8_t *vfPem, uint8_t *msg, size_t msglen, u
 
     if (SLN_AUTH_OK == ret)
     {
-        // SHA256 hash of data
-        mbedtls_md_context_t mdCtx;
-        mbedtls_md_type_t mdType  = MBEDTLS_MD_SHA256;
-        mbedtls_md_info_t *mdInfo = (mbedtls_md_info_t *)mbedtls_md_info_from_type(mdType);
-        char *hash                = NULL;
-
-        mbedtls_md_init(&mdCtx);
-        mbedtls_md_setup(&mdCtx, mdInfo, 1);
-
-        // Allocate hash memory
-        hash = (char *)pvPortMalloc(mdCtx.md_info->size);
-
-        if (NULL == hash)
-        {
-            configPRINTF(("ERROR: Could not allocate memory for hash.\r\n"));
-            ret = SLN_AUTH_NO_MEM;
-        }
+        // Now verify the signature for the given hash of the data
+        status = mbedtls_pk_verify(&(s_verifCert.pk), MBEDTLS_MD_SHA256, hash, SHA256_LEN, msgsig, RSA_SIG_LEN);
 
-        if (SLN_AUTH_OK == ret)
-        {
-            // Hash message
-            mbedtls_md(mdCtx.md_info, msg, msglen, (uint8_t *)hash);
-
-            // Now verify the signature for the given hash of the data
-            status = mbedtls_pk_verify(&(s_verifCert.pk), mdCtx.md_info->type, (uint8_t *)hash, mdCtx.md_info->size,
-                                       msgsig, RSA_SIG_LEN);
-
-            if (status)
-            {
-                configPRINTF(("ERROR: Could not authenticate message, -0x%X.\r\n", -status));
-                ret = SLN_AUTH_INVALID_SIG;
-            }
-        }
-
-        if (NULL != hash)
+        if (status)
         {
-            for (uint32_t idx = 0; idx < mdCtx.md_info->size; idx++)
-            {
-                hash[idx] = 0x00; // Wipe hash data
-            }
+            configPRINTF(("ERROR: Could not authenticate message, -0x%X.\r\n", -status));
+            ret = SLN_AUTH_INVALID_SIG;
         }
-        vPortFree(hash);
-        hash = NULL;
-
-        mbedtls_md_free(&mdCtx);
     }
 
     mbedtls_x509_crt_free(&s_verifCert);
@@ -20,6 +20,10 @@
 
 #define MAX_CERT_LEN 2048
 #define RSA_SIG_LEN  256
+#define SHA256_LEN   32
+
+/* Image is fed to the DCP straight from XIP in chunks of this size */
+#define SLN_AUTH_HASH_CHUNK_SIZE 0x10000
 
 #define BACKUP_REGION FICA_CRYPTO_BACKUP_ADDR
 
@@ -97,6 +101,18 @@ int32_t SLN_AUTH_Verify_Cert(uint8_t *caPem, uint8_t *vfPem);
  */
 int32_t SLN_AUTH_Verify_Signature(uint8_t *vfPem, uint8_t *msg, size_t msglen, uint8_t *msgsig);
 
+/*!
+ * @brief SHA256 hash of a message, streamed through the DCP in SLN_AUTH_HASH_CHUNK_SIZE chunks
+ *
+ */
+int32_t SLN_AUTH_Hash_Message(uint8_t *msg, size_t msglen, uint8_t *hash);
+
+/*!
+ * @brief Verify RSA signature of an already computed SHA256 hash against given certificate
+ *
+ */
+int32_t SLN_AUTH_Verify_Signature_Hash(uint8_t *vfPem, uint8_t *hash, uint8_t *msgsig);
+
 #if UPDATER_SUPPORT_ENABLED
 /*!
  * @brief Parse the certificate received as argument, to check if it has the proper format
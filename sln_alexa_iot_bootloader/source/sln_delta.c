@@ -0,0 +1,361 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#include <string.h>
+
+#include "sln_delta.h"
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static uint32_t SLN_DELTA_Get_U32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0]) | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static uint32_t SLN_DELTA_Op_Len(uint8_t op)
+{
+    uint32_t len = 0;
+
+    switch (op)
+    {
+        case SLN_DELTA_OP_END:
+            len = 1;
+            break;
+        case SLN_DELTA_OP_COPY:
+            len = 9;
+            break;
+        case SLN_DELTA_OP_INSERT:
+            len = 5;
+            break;
+        default:
+            break;
+    }
+
+    return len;
+}
+
+static int32_t SLN_DELTA_Flush(sln_delta_ctx_t *ctx)
+{
+    int32_t ret = SLN_DELTA_OK;
+
+    if (ctx->winLen)
+    {
+        if (0 != mbedtls_sha256_update_ret(&ctx->sha, ctx->window, ctx->winLen))
+        {
+            ret = SLN_DELTA_IO_ERR;
+        }
+
+        if (SLN_DELTA_OK == ret)
+        {
+            if (0 != ctx->ops->dstWrite(ctx->ops->arg, ctx->dstPos - ctx->winLen, ctx->window, ctx->winLen))
+            {
+                ret = SLN_DELTA_IO_ERR;
+            }
+        }
+
+        ctx->winLen = 0;
+    }
+
+    return ret;
+}
+
+static int32_t SLN_DELTA_Reserve(sln_delta_ctx_t *ctx, uint32_t len)
+{
+    int32_t ret = SLN_DELTA_OK;
+
+    /* Target must stay within the bank and within what the header announced */
+    if ((len > ctx->header.dstLen) || (ctx->dstPos > ctx->header.dstLen - len))
+    {
+        ret = SLN_DELTA_OUT_OF_RANGE;
+    }
+
+    return ret;
+}
+
+static int32_t SLN_DELTA_Parse_Header(sln_delta_ctx_t *ctx)
+{
+    int32_t ret = SLN_DELTA_OK;
+
+    if ((SLN_DELTA_MAGIC != ctx->header.magic) || (SLN_DELTA_VERSION != ctx->header.version) ||
+        (0 != ctx->header.flags))
+    {
+        ret = SLN_DELTA_BAD_HEADER;
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        if ((ctx->header.srcLen > ctx->srcMax) || (0 == ctx->header.dstLen) || (ctx->header.dstLen > ctx->dstMax))
+        {
+            ret = SLN_DELTA_OUT_OF_RANGE;
+        }
+    }
+
+    /* Running bank must be exactly the image this delta was generated against */
+    if ((SLN_DELTA_OK == ret) && (NULL != ctx->ops->srcCheck))
+    {
+        if (0 != ctx->ops->srcCheck(ctx->ops->arg, ctx->header.srcLen, ctx->header.srcDigest))
+        {
+            ret = SLN_DELTA_BAD_SOURCE;
+        }
+    }
+
+    return ret;
+}
+
+static int32_t SLN_DELTA_Copy(sln_delta_ctx_t *ctx, uint32_t srcOffset, uint32_t len)
+{
+    int32_t ret    = SLN_DELTA_OK;
+    uint32_t chunk = 0;
+
+    if ((len > ctx->header.srcLen) || (srcOffset > ctx->header.srcLen - len))
+    {
+        ret = SLN_DELTA_OUT_OF_RANGE;
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        ret = SLN_DELTA_Reserve(ctx, len);
+    }
+
+    while ((SLN_DELTA_OK == ret) && len)
+    {
+        chunk = SLN_DELTA_WINDOW_SIZE - ctx->winLen;
+        chunk = (len < chunk) ? len : chunk;
+
+        if (0 != ctx->ops->srcRead(ctx->ops->arg, srcOffset, &ctx->window[ctx->winLen], chunk))
+        {
+            ret = SLN_DELTA_IO_ERR;
+            break;
+        }
+
+        ctx->winLen += chunk;
+        ctx->dstPos += chunk;
+        srcOffset += chunk;
+        len -= chunk;
+
+        if (SLN_DELTA_WINDOW_SIZE == ctx->winLen)
+        {
+            ret = SLN_DELTA_Flush(ctx);
+        }
+    }
+
+    return ret;
+}
+
+static int32_t SLN_DELTA_Run_Op(sln_delta_ctx_t *ctx)
+{
+    int32_t ret = SLN_DELTA_OK;
+
+    switch (ctx->stage[0])
+    {
+        case SLN_DELTA_OP_END:
+            if (ctx->dstPos != ctx->header.dstLen)
+            {
+                ret = SLN_DELTA_INCOMPLETE;
+            }
+            else
+            {
+                ctx->state = kDeltaStateDone;
+            }
+            break;
+        case SLN_DELTA_OP_COPY:
+            ret = SLN_DELTA_Copy(ctx, SLN_DELTA_Get_U32(&ctx->stage[1]), SLN_DELTA_Get_U32(&ctx->stage[5]));
+            break;
+        case SLN_DELTA_OP_INSERT:
+            ctx->insertLeft = SLN_DELTA_Get_U32(&ctx->stage[1]);
+            ret             = SLN_DELTA_Reserve(ctx, ctx->insertLeft);
+
+            if ((SLN_DELTA_OK == ret) && ctx->insertLeft)
+            {
+                ctx->state = kDeltaStateInsert;
+            }
+            break;
+        default:
+            ret = SLN_DELTA_BAD_OP;
+            break;
+    }
+
+    return ret;
+}
+
+int32_t SLN_DELTA_Init(sln_delta_ctx_t *ctx, const sln_delta_ops_t *ops, uint32_t srcMax, uint32_t dstMax)
+{
+    int32_t ret = SLN_DELTA_OK;
+
+    if ((NULL == ctx) || (NULL == ops) || (NULL == ops->srcRead) || (NULL == ops->dstWrite))
+    {
+        ret = SLN_DELTA_NULL_PTR;
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        memset(ctx, 0, sizeof(sln_delta_ctx_t));
+
+        ctx->ops    = ops;
+        ctx->srcMax = srcMax;
+        ctx->dstMax = dstMax;
+        ctx->state  = kDeltaStateHeader;
+
+        mbedtls_sha256_init(&ctx->sha);
+
+        if (0 != mbedtls_sha256_starts_ret(&ctx->sha, 0))
+        {
+            ret = SLN_DELTA_IO_ERR;
+        }
+    }
+
+    return ret;
+}
+
+int32_t SLN_DELTA_Feed(sln_delta_ctx_t *ctx, const uint8_t *data, uint32_t len)
+{
+    int32_t ret    = SLN_DELTA_OK;
+    uint32_t chunk = 0;
+
+    if ((NULL == ctx) || (NULL == data))
+    {
+        return SLN_DELTA_NULL_PTR;
+    }
+
+    while ((SLN_DELTA_OK == ret) && len)
+    {
+        switch (ctx->state)
+        {
+            case kDeltaStateHeader:
+                chunk = sizeof(sln_delta_header_t) - ctx->stageLen;
+                chunk = (len < chunk) ? len : chunk;
+                memcpy((uint8_t *)&ctx->header + ctx->stageLen, data, chunk);
+                ctx->stageLen += chunk;
+
+                if (sizeof(sln_delta_header_t) == ctx->stageLen)
+                {
+                    ctx->stageLen = 0;
+                    ctx->state    = kDeltaStateOp;
+                    ret           = SLN_DELTA_Parse_Header(ctx);
+                }
+                break;
+
+            case kDeltaStateOp:
+                if (0 == ctx->stageLen)
+                {
+                    if (0 == SLN_DELTA_Op_Len(data[0]))
+                    {
+                        ret = SLN_DELTA_BAD_OP;
+                        break;
+                    }
+                }
+
+                chunk = SLN_DELTA_Op_Len(ctx->stageLen ? ctx->stage[0] : data[0]) - ctx->stageLen;
+                chunk = (len < chunk) ? len : chunk;
+                memcpy(&ctx->stage[ctx->stageLen], data, chunk);
+                ctx->stageLen += chunk;
+
+                if (SLN_DELTA_Op_Len(ctx->stage[0]) == ctx->stageLen)
+                {
+                    ctx->stageLen = 0;
+                    ret           = SLN_DELTA_Run_Op(ctx);
+                }
+                break;
+
+            case kDeltaStateInsert:
+                chunk = SLN_DELTA_WINDOW_SIZE - ctx->winLen;
+                chunk = (ctx->insertLeft < chunk) ? ctx->insertLeft : chunk;
+                chunk = (len < chunk) ? len : chunk;
+                memcpy(&ctx->window[ctx->winLen], data, chunk);
+                ctx->winLen += chunk;
+                ctx->dstPos += chunk;
+                ctx->insertLeft -= chunk;
+
+                if (0 == ctx->insertLeft)
+                {
+                    ctx->state = kDeltaStateOp;
+                }
+
+                if (SLN_DELTA_WINDOW_SIZE == ctx->winLen)
+                {
+                    ret = SLN_DELTA_Flush(ctx);
+                }
+                break;
+
+            case kDeltaStateDone:
+                /* Nothing may follow the end marker */
+                ret = SLN_DELTA_BAD_OP;
+                break;
+
+            default:
+                ret = SLN_DELTA_BAD_OP;
+                break;
+        }
+
+        data += chunk;
+        len -= chunk;
+    }
+
+    if (SLN_DELTA_OK != ret)
+    {
+        ctx->state = kDeltaStateError;
+    }
+
+    return ret;
+}
+
+int32_t SLN_DELTA_Finish(sln_delta_ctx_t *ctx, uint32_t *dstLen)
+{
+    int32_t ret                          = SLN_DELTA_OK;
+    uint8_t digest[SLN_DELTA_DIGEST_LEN] = {0};
+
+    if (NULL == ctx)
+    {
+        return SLN_DELTA_NULL_PTR;
+    }
+
+    if (kDeltaStateDone != ctx->state)
+    {
+        ret = SLN_DELTA_INCOMPLETE;
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        ret = SLN_DELTA_Flush(ctx);
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        if (0 != mbedtls_sha256_finish_ret(&ctx->sha, digest))
+        {
+            ret = SLN_DELTA_IO_ERR;
+        }
+    }
+
+    if (SLN_DELTA_OK == ret)
+    {
+        if (0 != memcmp(digest, ctx->header.dstDigest, SLN_DELTA_DIGEST_LEN))
+        {
+            ret = SLN_DELTA_BAD_DIGEST;
+        }
+    }
+
+    if ((SLN_DELTA_OK == ret) && (NULL != dstLen))
+    {
+        *dstLen = ctx->header.dstLen;
+    }
+
+    return ret;
+}
+
+void SLN_DELTA_Deinit(sln_delta_ctx_t *ctx)
+{
+    if (NULL != ctx)
+    {
+        mbedtls_sha256_free(&ctx->sha);
+        memset(ctx, 0, sizeof(sln_delta_ctx_t));
+    }
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2021 NXP.
+ * This software is owned or controlled by NXP and may only be used strictly in accordance with the
+ * license terms that accompany it. By expressly accepting such terms or by downloading, installing,
+ * activating and/or otherwise using the software, you are agreeing that you have read, and that you
+ * agree to comply with and are bound by, such license terms. If you do not agree to be bound by the
+ * applicable license terms, then you may not retain, install, activate or otherwise use the software.
+ */
+
+#ifndef _SLN_DELTA_H_
+#define _SLN_DELTA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mbedtls/sha256.h"
+
+/*
+ * Delta image layout (little endian, generated by scripts/sln_delta_gen.py):
+ * |--sln_delta_header_t--|--op--|--op--| ... |--SLN_DELTA_OP_END--|
+ *
+ * Operations:
+ * SLN_DELTA_OP_COPY   |--op(1)--|--srcOffset(4)--|--len(4)--|           target += source[srcOffset, len]
+ * SLN_DELTA_OP_INSERT |--op(1)--|--len(4)--|--data(len)--|              target += data
+ * SLN_DELTA_OP_END    |--op(1)--|                                       target must be dstLen bytes long
+ *
+ * The target image is produced strictly in order, so it can be reconstructed while the delta is
+ * being received, using only a window of SLN_DELTA_WINDOW_SIZE bytes of RAM.
+ */
+
+#define SLN_DELTA_MAGIC   0x444E4C53 /* "SLND" */
+#define SLN_DELTA_VERSION 1
+
+#ifndef SLN_DELTA_WINDOW_SIZE
+#define SLN_DELTA_WINDOW_SIZE 0x1000
+#endif
+
+#define SLN_DELTA_DIGEST_LEN 32
+#define SLN_DELTA_OP_MAX_LEN 9
+
+typedef enum _sln_delta_status
+{
+    SLN_DELTA_OK           = 0,
+    SLN_DELTA_NULL_PTR     = -1,
+    SLN_DELTA_BAD_HEADER   = -2,
+    SLN_DELTA_BAD_SOURCE   = -3,
+    SLN_DELTA_BAD_OP       = -4,
+    SLN_DELTA_OUT_OF_RANGE = -5,
+    SLN_DELTA_IO_ERR       = -6,
+    SLN_DELTA_BAD_DIGEST   = -7,
+    SLN_DELTA_INCOMPLETE   = -8,
+} sln_delta_status_t;
+
+typedef enum _sln_delta_op
+{
+    SLN_DELTA_OP_END    = 0x00,
+    SLN_DELTA_OP_COPY   = 0x01,
+    SLN_DELTA_OP_INSERT = 0x02,
+} sln_delta_op_t;
+
+/*! @brief Delta image header */
+typedef struct __attribute__((packed)) _sln_delta_header
+{
+    uint32_t magic;                          /*!< SLN_DELTA_MAGIC */
+    uint16_t version;                        /*!< SLN_DELTA_VERSION */
+    uint16_t flags;                          /*!< Reserved, must be 0 */
+    uint32_t srcLen;                         /*!< Length of the source image the delta was made against */
+    uint32_t dstLen;                         /*!< Length of the reconstructed image */
+    uint8_t srcDigest[SLN_DELTA_DIGEST_LEN]; /*!< SHA256 of the source image */
+    uint8_t dstDigest[SLN_DELTA_DIGEST_LEN]; /*!< SHA256 of the reconstructed image */
+} sln_delta_header_t;
+
+/*! @brief Platform hooks used by the delta engine */
+typedef struct _sln_delta_ops
+{
+    /*! Reads len bytes of the source image starting at offset */
+    int32_t (*srcRead)(void *arg, uint32_t offset, uint8_t *buf, uint32_t len);
+    /*! Checks the first len bytes of the source image against digest, can be NULL */
+    int32_t (*srcCheck)(void *arg, uint32_t len, const uint8_t *digest);
+    /*! Writes len bytes of the reconstructed image starting at offset */
+    int32_t (*dstWrite)(void *arg, uint32_t offset, uint8_t *buf, uint32_t len);
+    void *arg;
+} sln_delta_ops_t;
+
+typedef enum _sln_delta_state
+{
+    kDeltaStateHeader = 0,
+    kDeltaStateOp,
+    kDeltaStateInsert,
+    kDeltaStateDone,
+    kDeltaStateError,
+} sln_delta_state_t;
+
+/*! @brief Delta engine context */
+typedef struct _sln_delta_ctx
+{
+    const sln_delta_ops_t *ops;
+    sln_delta_state_t state;
+    sln_delta_header_t header;
+    uint32_t srcMax;   /*!< Size of the source bank */
+    uint32_t dstMax;   /*!< Size of the destination bank */
+    uint32_t dstPos;   /*!< Bytes of the target produced so far */
+    uint32_t winLen;   /*!< Bytes waiting in window */
+    uint32_t stageLen; /*!< Bytes gathered for the current header / op */
+    uint32_t insertLeft;
+    uint8_t stage[SLN_DELTA_OP_MAX_LEN];
+    uint8_t window[SLN_DELTA_WINDOW_SIZE];
+    mbedtls_sha256_context sha;
+} sln_delta_ctx_t;
+
+/*!
+ * @brief Prepares a context for applying a new delta image
+ *
+ * @param ctx Context to initialize
+ * @param ops Platform hooks for source reads and target writes
+ * @param srcMax Size of the source bank, the delta may not reference beyond it
+ * @param dstMax Size of the destination bank, the delta may not produce more than this
+ *
+ * @returns SLN_DELTA_OK or an error from sln_delta_status_t
+ */
+int32_t SLN_DELTA_Init(sln_delta_ctx_t *ctx, const sln_delta_ops_t *ops, uint32_t srcMax, uint32_t dstMax);
+
+/*!
+ * @brief Feeds the next chunk of the delta image, writing out every full window of target data
+ *
+ * @param ctx Context from SLN_DELTA_Init
+ * @param data Delta data
+ * @param len Length of data, chunks may be split at any byte
+ *
+ * @returns SLN_DELTA_OK or an error from sln_delta_status_t; after an error the context is unusable
+ */
+int32_t SLN_DELTA_Feed(sln_delta_ctx_t *ctx, const uint8_t *data, uint32_t len);
+
+/*!
+ * @brief Writes out the last window and checks the reconstructed image against the header digest
+ *
+ * @param ctx Context from SLN_DELTA_Init
+ * @param dstLen Receives the length of the reconstructed image, can be NULL
+ *
+ * @returns SLN_DELTA_OK or an error from sln_delta_status_t
+ */
+int32_t SLN_DELTA_Finish(sln_delta_ctx_t *ctx, uint32_t *dstLen);
+
+/*!
+ * @brief Releases the context, safe to call at any point after SLN_DELTA_Init
+ *
+ * @param ctx Context from SLN_DELTA_Init
+ */
+void SLN_DELTA_Deinit(sln_delta_ctx_t *ctx);
+
+#endif /* _SLN_DELTA_H_ */
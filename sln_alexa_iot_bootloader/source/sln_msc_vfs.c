@@ -11,29 +11,64 @@
 #include "sln_msc_vfs.h"
 #include "flash_ica_driver.h"
 #include "nor_encrypt_bee.h"
+#include "sln_flash.h"
+#include "queue.h"
+#include "semphr.h"
 
 /*******************************************************************************
  * Definitions
  ******************************************************************************/
 
+#define MSC_VFS_MAX_SECTORS ((FICA_IMG_APP_A_SIZE + EXT_FLASH_ERASE_PAGE - 1U) / EXT_FLASH_ERASE_PAGE)
+
+/* Words read at once by the blank check, from the writer task stack */
+#define MSC_VFS_BLANK_CHECK_WORDS (16U)
+
+typedef struct _msc_vfs_chunk
+{
+    uint32_t imgOffset; /*!< Image offset of the data */
+    uint32_t size;      /*!< Bytes waiting at the tail of the staging ring, 0 only wakes the writer up */
+} msc_vfs_chunk_t;
+
 /*******************************************************************************
  * Prototypes
  ******************************************************************************/
 
+static void MSC_VFS_WriterTask(void *arg);
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
-static uint32_t s_startOffset = 0;
-static uint32_t s_fileLength  = 0;
-static uint32_t s_dataWritten = 0;
-static uint32_t s_lbaLength   = 0;
+static uint32_t s_startOffset         = 0;
+static uint32_t s_bankAddr            = 0;
+static uint32_t s_bankSectors         = 0;
+static volatile uint32_t s_fileLength = 0;
+static uint32_t s_dataWritten         = 0;
+static uint32_t s_lbaLength           = 0;
 
-static msc_vfs_state_t s_transferState = TRANSFER_IDLE;
+static volatile msc_vfs_state_t s_transferState = TRANSFER_IDLE;
 
 static TaskHandle_t *s_usbAppTaskHandle = NULL;
 
-const char *ext = "BIN";
+static const uint8_t s_binExt[3] = {'B', 'I', 'N'};
+
+/* The head only moves in the USB callback and the tail in the writer task */
+static uint8_t s_staging[MSC_VFS_STAGING_SIZE];
+static volatile uint32_t s_stagingHead = 0;
+static volatile uint32_t s_stagingTail = 0;
+
+static QueueHandle_t s_chunkQueue   = NULL;
+static SemaphoreHandle_t s_spaceSem = NULL;
+
+/* Flash writer state, the page buffer holds the data from s_pageOffset */
+static __attribute__((aligned(4))) uint8_t s_pageBuf[EXT_FLASH_PROGRAM_PAGE];
+static uint32_t s_pageOffset = 0;
+static uint32_t s_pageFill   = 0;
+static uint32_t s_erased[(MSC_VFS_MAX_SECTORS + 31U) / 32U];
+static uint32_t s_eraseNext   = 0; /* Sectors below it are all erased */
+static uint32_t s_crc         = 0;
+static TickType_t s_startTick = 0;
 
 static const fat_mbr_t s_fatMbrInit = {.jump_instr              = {0xEB, 0x3C, 0x90},
                                        .oem_name                = {'M', 'S', 'D', '0', 'S', '5', '.', '0'},
@@ -62,6 +97,367 @@ static const fat_mbr_t s_fatMbrInit = {.jump_instr              = {0xEB, 0x3C, 0
  * Code
  ******************************************************************************/
 
+/* CRC-32 (zlib), so the progress can be compared with the CRC of the file on the host */
+static uint32_t MSC_VFS_Crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    static const uint32_t s_crcNibble[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+                                             0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+                                             0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+    crc = ~crc;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ s_crcNibble[crc & 0x0F];
+        crc = (crc >> 4) ^ s_crcNibble[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+/* Take the file length from the .BIN entry when the host writes the root directory */
+static void MSC_VFS_ParseRootDir(uint32_t offset, uint32_t size, const uint8_t *buffer)
+{
+    uint32_t dirStart = s_fatMbrInit.reserved_sectors + (s_fatMbrInit.num_fats * s_fatMbrInit.logical_sectors_per_fat);
+    uint32_t dirEnd   = dirStart + ((s_fatMbrInit.root_entries * sizeof(fat_file_t)) / s_fatMbrInit.bytes_per_sector);
+    uint32_t first;
+    uint32_t last;
+
+    if ((offset >= dirEnd) || ((offset + (size / s_lbaLength)) <= dirStart))
+    {
+        return;
+    }
+
+    first = (offset < dirStart) ? ((dirStart - offset) * s_lbaLength) : 0;
+    last  = MIN(size, (dirEnd - offset) * s_lbaLength);
+
+    for (uint32_t pos = first; (pos + sizeof(fat_file_t)) <= last; pos += sizeof(fat_file_t))
+    {
+        fat_file_t file;
+
+        memcpy(&file, &buffer[pos], sizeof(fat_file_t));
+
+        if (FAT_NAME_END == file.name[0])
+        {
+            break;
+        }
+
+        /* Long name entries carry the volume ID attribute as well */
+        if ((FAT_NAME_DELETED == file.name[0]) || (file.attributes & (FAT_ATTR_VOLUME_ID | FAT_ATTR_DIRECTORY)) ||
+            (0 != memcmp(&file.name[8], s_binExt, sizeof(s_binExt))))
+        {
+            continue;
+        }
+
+        if ((0 < file.size) && (FICA_IMG_APP_A_SIZE >= file.size))
+        {
+            if (file.size != s_fileLength)
+            {
+                char fileName[12] = {0};
+                msc_vfs_chunk_t kick = {0};
+
+                memcpy(fileName, file.name, sizeof(file.name));
+                configPRINTF(("[Write Response] File Attributes: Name - %s, Size - %d, Cluster - %d\r\n",
+                              (const char *)fileName, file.size, file.first_cluster_lower));
+
+                s_fileLength = file.size;
+
+                // The data may all be staged already, let the writer check for the end of the file
+                xQueueSend(s_chunkQueue, &kick, 0);
+            }
+            break;
+        }
+    }
+}
+
+/* Copy the USB data to the staging ring, waits for the writer when the ring is full */
+static status_t MSC_VFS_Stage(uint32_t imgOffset, const uint8_t *data, uint32_t size)
+{
+    msc_vfs_chunk_t chunk;
+
+    while (size > 0)
+    {
+        uint32_t used    = s_stagingHead - s_stagingTail;
+        uint32_t headIdx = s_stagingHead % MSC_VFS_STAGING_SIZE;
+
+        if (TRANSFER_ERROR == s_transferState)
+        {
+            return kStatus_Fail;
+        }
+
+        if (MSC_VFS_STAGING_SIZE <= used)
+        {
+            xSemaphoreTake(s_spaceSem, portMAX_DELAY);
+            continue;
+        }
+
+        chunk.imgOffset = imgOffset;
+        chunk.size      = MIN(MIN(size, MSC_VFS_STAGING_SIZE - used), MSC_VFS_STAGING_SIZE - headIdx);
+
+        memcpy(&s_staging[headIdx], data, chunk.size);
+        s_stagingHead += chunk.size;
+
+        xQueueSend(s_chunkQueue, &chunk, portMAX_DELAY);
+
+        imgOffset += chunk.size;
+        data += chunk.size;
+        size -= chunk.size;
+    }
+
+    return kStatus_Success;
+}
+
+static void MSC_VFS_Release(uint32_t size)
+{
+    s_stagingTail += size;
+    xSemaphoreGive(s_spaceSem);
+}
+
+static int32_t MSC_VFS_EraseSector(uint32_t sector)
+{
+    int32_t flashError = FICA_app_program_ext_erase_sector(sector * EXT_FLASH_ERASE_PAGE);
+
+    if (SLN_FLASH_NO_ERROR == flashError)
+    {
+        s_erased[sector / 32U] |= (1U << (sector % 32U));
+    }
+
+    return flashError;
+}
+
+static bool MSC_VFS_SectorErased(uint32_t sector)
+{
+    return (0 != (s_erased[sector / 32U] & (1U << (sector % 32U))));
+}
+
+/* Next sector of the file still to erase, only known once the directory entry was written */
+static bool MSC_VFS_EraseAhead(uint32_t *sector)
+{
+    uint32_t fileLength = s_fileLength;
+    uint32_t lastSector;
+
+    if (0 == fileLength)
+    {
+        return false;
+    }
+
+    lastSector = MIN((fileLength - 1U) / EXT_FLASH_ERASE_PAGE, MSC_VFS_MAX_SECTORS - 1U);
+
+    // Sectors stay erased for the whole transfer, so the scan resumes where it stopped
+    for (; s_eraseNext <= lastSector; s_eraseNext++)
+    {
+        if (!MSC_VFS_SectorErased(s_eraseNext))
+        {
+            *sector = s_eraseNext;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool MSC_VFS_SectorBlank(uint32_t sector)
+{
+    uint32_t words[MSC_VFS_BLANK_CHECK_WORDS];
+    uint32_t address = s_bankAddr + (sector * EXT_FLASH_ERASE_PAGE);
+
+    for (uint32_t pos = 0; pos < EXT_FLASH_ERASE_PAGE; pos += sizeof(words))
+    {
+        SLN_Read_Flash_At_Address(address + pos, (uint8_t *)words, sizeof(words));
+
+        for (uint32_t idx = 0; idx < MSC_VFS_BLANK_CHECK_WORDS; idx++)
+        {
+            if (0xFFFFFFFFU != words[idx])
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Erase what a longer image left in the bank past the end of the file. Blank sectors are only read,
+ * with encrypted XIP an erased sector does not read back blank and every one of them is erased. */
+static int32_t MSC_VFS_EraseTail(void)
+{
+    int32_t flashError = SLN_FLASH_NO_ERROR;
+    uint32_t erased    = 0;
+
+    for (uint32_t sector = (s_fileLength + EXT_FLASH_ERASE_PAGE - 1U) / EXT_FLASH_ERASE_PAGE;
+         (SLN_FLASH_NO_ERROR == flashError) && (sector < s_bankSectors); sector++)
+    {
+        if (!MSC_VFS_SectorErased(sector) && !MSC_VFS_SectorBlank(sector))
+        {
+            flashError = MSC_VFS_EraseSector(sector);
+            erased++;
+        }
+    }
+
+    if ((SLN_FLASH_NO_ERROR == flashError) && (0 != erased))
+    {
+        configPRINTF(("[Write Response] %d sectors past the end of the file erased\r\n", erased));
+    }
+
+    return flashError;
+}
+
+/* Program the page buffer, erasing the sectors it covers first */
+static int32_t MSC_VFS_FlushPage(void)
+{
+    int32_t flashError = SLN_FLASH_NO_ERROR;
+    uint32_t lastSector;
+
+    if (0 == s_pageFill)
+    {
+        return flashError;
+    }
+
+    lastSector = (s_pageOffset + s_pageFill - 1U) / EXT_FLASH_ERASE_PAGE;
+
+    for (uint32_t sector = s_pageOffset / EXT_FLASH_ERASE_PAGE;
+         (SLN_FLASH_NO_ERROR == flashError) && (sector <= lastSector); sector++)
+    {
+        if (MSC_VFS_MAX_SECTORS <= sector)
+        {
+            flashError = SLN_FLASH_ERROR;
+        }
+        else if (!MSC_VFS_SectorErased(sector))
+        {
+            flashError = MSC_VFS_EraseSector(sector);
+        }
+    }
+
+    if (SLN_FLASH_NO_ERROR == flashError)
+    {
+        flashError = FICA_app_program_ext_abs(s_pageOffset, s_pageBuf, s_pageFill);
+    }
+
+    if (SLN_FLASH_NO_ERROR == flashError)
+    {
+        s_crc = MSC_VFS_Crc32(s_crc, s_pageBuf, s_pageFill);
+
+        if ((s_dataWritten / EXT_FLASH_ERASE_PAGE) != ((s_dataWritten + s_pageFill) / EXT_FLASH_ERASE_PAGE))
+        {
+            configPRINTF(("[Write Response] %d of %d bytes saved, CRC32 0x%08X\r\n", s_dataWritten + s_pageFill,
+                          s_fileLength, s_crc));
+        }
+
+        s_dataWritten += s_pageFill;
+    }
+
+    s_pageFill = 0;
+
+    return flashError;
+}
+
+/* Move a staged chunk to the page buffer, programming every page it completes */
+static int32_t MSC_VFS_ProgramChunk(const msc_vfs_chunk_t *chunk)
+{
+    int32_t flashError = SLN_FLASH_NO_ERROR;
+    uint32_t imgOffset = chunk->imgOffset;
+    uint32_t size      = chunk->size;
+
+    if ((0 != s_pageFill) && (imgOffset != (s_pageOffset + s_pageFill)))
+    {
+        flashError = MSC_VFS_FlushPage();
+    }
+
+    while ((SLN_FLASH_NO_ERROR == flashError) && (size > 0))
+    {
+        uint32_t tailIdx = s_stagingTail % MSC_VFS_STAGING_SIZE;
+        uint32_t room;
+        uint32_t len;
+
+        if (0 == s_pageFill)
+        {
+            s_pageOffset = imgOffset;
+        }
+
+        room = EXT_FLASH_PROGRAM_PAGE - ((s_pageOffset + s_pageFill) % EXT_FLASH_PROGRAM_PAGE);
+        len  = MIN(MIN(room, size), MSC_VFS_STAGING_SIZE - tailIdx);
+
+        memcpy(&s_pageBuf[s_pageFill], &s_staging[tailIdx], len);
+        s_pageFill += len;
+        imgOffset += len;
+        size -= len;
+        MSC_VFS_Release(len);
+
+        if (len == room)
+        {
+            flashError = MSC_VFS_FlushPage();
+        }
+    }
+
+    if (size > 0)
+    {
+        MSC_VFS_Release(size);
+    }
+
+    return flashError;
+}
+
+static void MSC_VFS_WriterTask(void *arg)
+{
+    msc_vfs_chunk_t chunk;
+    uint32_t sector = 0;
+
+    while (1)
+    {
+        int32_t flashError = SLN_FLASH_NO_ERROR;
+        bool eraseAhead    = (TRANSFER_ACTIVE == s_transferState) && MSC_VFS_EraseAhead(&sector);
+
+        if (pdTRUE != xQueueReceive(s_chunkQueue, &chunk, eraseAhead ? 0 : portMAX_DELAY))
+        {
+            // Nothing staged, get the next sector of the file ready
+            flashError = MSC_VFS_EraseSector(sector);
+        }
+        else if (TRANSFER_ACTIVE != s_transferState)
+        {
+            // Failed or complete, drop the data
+            MSC_VFS_Release(chunk.size);
+            continue;
+        }
+        else if (0 != chunk.size)
+        {
+            flashError = MSC_VFS_ProgramChunk(&chunk);
+        }
+
+        if ((SLN_FLASH_NO_ERROR == flashError) && (0 != s_fileLength) &&
+            ((s_dataWritten + s_pageFill) >= s_fileLength))
+        {
+            flashError = MSC_VFS_FlushPage();
+
+            if (SLN_FLASH_NO_ERROR == flashError)
+            {
+                flashError = MSC_VFS_EraseTail();
+            }
+
+            if (SLN_FLASH_NO_ERROR == flashError)
+            {
+                configPRINTF(("[Write Response] %d bytes saved in %d ms, CRC32 0x%08X\r\n", s_dataWritten,
+                              (xTaskGetTickCount() - s_startTick) * portTICK_PERIOD_MS, s_crc));
+
+                s_transferState = TRANSFER_FINAL;
+
+                // Wake up the application task to finalize transfer
+                vTaskResume(*s_usbAppTaskHandle);
+            }
+        }
+
+        if (SLN_FLASH_NO_ERROR != flashError)
+        {
+            s_transferState = TRANSFER_ERROR;
+            configPRINTF(("[Write Response] ...save failed!!!\r\n"));
+
+            // Unblock the USB callback, then wake up application task to handle this error
+            xSemaphoreGive(s_spaceSem);
+            vTaskResume(*s_usbAppTaskHandle);
+        }
+    }
+}
+
 status_t MSC_VFS_Init(uint8_t *storageDisk, TaskHandle_t *usbAppTask, uint32_t lbaLength)
 {
     status_t status = kStatus_Fail;
@@ -81,6 +477,20 @@ status_t MSC_VFS_Init(uint8_t *storageDisk, TaskHandle_t *usbAppTask, uint32_t l
         s_transferState = TRANSFER_IDLE;
     }
 
+    if ((kStatus_Success == status) && (NULL == s_chunkQueue))
+    {
+        s_chunkQueue = xQueueCreate(MSC_VFS_CHUNK_COUNT, sizeof(msc_vfs_chunk_t));
+        s_spaceSem   = xSemaphoreCreateBinary();
+
+        if ((NULL == s_chunkQueue) || (NULL == s_spaceSem) ||
+            (pdPASS != xTaskCreate(MSC_VFS_WriterTask, "MSC Flash Writer", MSC_VFS_WRITER_STACK, NULL,
+                                   MSC_VFS_WRITER_PRIORITY, NULL)))
+        {
+            configPRINTF(("[MSC VFS] Unable to start the flash writer!\r\n"));
+            status = kStatus_Fail;
+        }
+    }
+
     return status;
 }
 
@@ -101,38 +511,7 @@ status_t MSC_VFS_WriteResponse(uint32_t offset, uint32_t size, uint8_t *buffer)
 
     if (0 != size)
     {
-        char *ret = NULL;
-
-        for (uint32_t idx = 0; idx < size; idx++)
-        {
-            if (0 == memcmp(&buffer[idx], ext, 3))
-            {
-                ret = (char *)(&buffer[idx]);
-                break;
-            }
-        }
-
-        if (NULL != ret)
-        {
-            char *temp         = ret - 8;
-            fat_file_t *file   = (fat_file_t *)temp;
-            char *fileName[12] = {0};
-
-            memcpy(fileName, file->name, sizeof(file->name));
-
-            if ((0 < file->size) && (FICA_IMG_APP_A_SIZE >= file->size))
-            {
-                configPRINTF(
-                    ("[Write Response] File Attributes: Name - %s, Size - %d\r\n", (const char *)fileName, file->size));
-
-                s_fileLength = file->size;
-            }
-        }
-
-#if 0
-        configPRINTF(("[Write Response] offset: %d\r\n", offset));
-        configPRINTF(("[Write Response] size: %d\r\n", size));
-#endif
+        MSC_VFS_ParseRootDir(offset, size, buffer);
 
         if (TRANSFER_IDLE == s_transferState)
         {
@@ -150,6 +529,9 @@ status_t MSC_VFS_WriteResponse(uint32_t offset, uint32_t size, uint8_t *buffer)
 
                 s_transferState = TRANSFER_START;
 
+                // The length of a previous file doesn't apply, the directory entry of this one sets it again
+                s_fileLength = 0;
+
                 configPRINTF(("[Write Response] Reset Handler: 0x%X\r\n", *resetHandler));
 
                 // Initialize FICA, verify img address is valid
@@ -170,63 +552,51 @@ status_t MSC_VFS_WriteResponse(uint32_t offset, uint32_t size, uint8_t *buffer)
                     // Rest of offsets coming in will be relative to the startoffset
                     s_startOffset = offset;
 
-                    // Init FICA to be ready for the new application
-                    flashError = FICA_app_program_ext_init(currImgType);
+                    // Init FICA to be ready for the new application, the writer erases the sectors as it goes
+                    flashError = FICA_app_program_ext_init_no_erase(currImgType);
                 }
 
-                if (SLN_FLASH_NO_ERROR != flashError)
-                {
-                    error           = kStatus_Fail;
-                    s_transferState = TRANSFER_ERROR;
-                    configPRINTF(("[Write Response] Unable to begin transfer of file!\r\n"));
-
-                    // Wake up application task to handle this error
-                    vTaskResume(*s_usbAppTaskHandle);
-                }
-                else
+                if (SLN_FLASH_NO_ERROR == flashError)
                 {
-                    s_transferState = TRANSFER_ACTIVE;
+                    flashError = FICA_get_app_img_start_addr(currImgType, &s_bankAddr);
                 }
-            }
-        }
-
-        if (TRANSFER_ACTIVE == s_transferState)
-        {
-            if (offset >= s_startOffset)
-            {
-                uint32_t imgOffset;
 
-                // Calculate the image address for where to store this data
-                imgOffset = ((offset - s_startOffset) * s_lbaLength);
-
-                configPRINTF(("[Write Response] Saving %d of data to 0x%X...\r\n", size, imgOffset));
+                if (SLN_FLASH_NO_ERROR == flashError)
+                {
+                    uint32_t bankSize = 0;
 
-                // write to external flash
-                flashError = FICA_app_program_ext_abs(imgOffset, buffer, size);
+                    flashError    = FICA_get_app_img_max_size(currImgType, &bankSize);
+                    s_bankSectors = MIN(bankSize / EXT_FLASH_ERASE_PAGE, MSC_VFS_MAX_SECTORS);
+                }
 
                 if (SLN_FLASH_NO_ERROR != flashError)
                 {
                     error           = kStatus_Fail;
                     s_transferState = TRANSFER_ERROR;
-                    configPRINTF(("[Write Response] ...save failed!!!\r\n", size, imgOffset));
+                    configPRINTF(("[Write Response] Unable to begin transfer of file!\r\n"));
 
                     // Wake up application task to handle this error
                     vTaskResume(*s_usbAppTaskHandle);
                 }
                 else
                 {
-                    s_dataWritten += size;
-                    configPRINTF(("[Write Response] ...data saved!\r\n", size, imgOffset));
+                    // The writer is idle, nothing is staged
+                    s_dataWritten = 0;
+                    s_pageFill    = 0;
+                    s_crc         = 0;
+                    s_startTick   = xTaskGetTickCount();
+                    memset(s_erased, 0, sizeof(s_erased));
+                    s_eraseNext = 0;
+
+                    s_transferState = TRANSFER_ACTIVE;
                 }
             }
+        }
 
-            if ((s_fileLength > 0) && (s_dataWritten >= s_fileLength))
-            {
-                s_transferState = TRANSFER_FINAL;
-
-                // Wake up the application task to finalize transfer
-                vTaskResume(*s_usbAppTaskHandle);
-            }
+        if ((TRANSFER_ACTIVE == s_transferState) && (offset >= s_startOffset))
+        {
+            // Calculate the image address for where to store this data, the writer task programs it
+            error = MSC_VFS_Stage((offset - s_startOffset) * s_lbaLength, buffer, size);
         }
     }
     else
@@ -20,6 +20,28 @@
 #define FLASH_BYTE4_UPPER_NIBBLE 0xF0000000
 #define FLASH_BYTE3_UPPER_NIBBLE 0x00F00000
 
+/* RAM the USB writes land in while the flash writer task erases and programs */
+#ifndef MSC_VFS_STAGING_SIZE
+#define MSC_VFS_STAGING_SIZE (32U * 1024U)
+#endif
+
+/* Written blocks queued to the flash writer, each one at most MSC_VFS_STAGING_SIZE */
+#ifndef MSC_VFS_CHUNK_COUNT
+#define MSC_VFS_CHUNK_COUNT (16U)
+#endif
+
+/* Below the USB device task, so the host transfers go on between page programs */
+#define MSC_VFS_WRITER_PRIORITY (4U)
+#define MSC_VFS_WRITER_STACK    (2048L / sizeof(portSTACK_TYPE))
+
+/* FAT directory entry attributes */
+#define FAT_ATTR_VOLUME_ID (0x08U)
+#define FAT_ATTR_DIRECTORY (0x10U)
+
+/* First byte of the name of a FAT directory entry */
+#define FAT_NAME_END     (0x00U)
+#define FAT_NAME_DELETED (0xE5U)
+
 typedef enum __transfer_state
 {
     TRANSFER_IDLE,